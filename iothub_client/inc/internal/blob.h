@@ -57,10 +57,14 @@ MU_DEFINE_ENUM_WITHOUT_INVALID(BLOB_RESULT, BLOB_RESULT_VALUES)
 * @param  certificates      A null terminated string containing CA certificates to be used
 * @param    proxyOptions    A structure that contains optional web proxy information
 * @param  networkInterface    An optional null terminated string containing the network interface
+* @param  parallelBlocks    The number of blocks uploaded at the same time, each on its own connection. With 1 the blocks are uploaded one after the other.
+*                           With more, getDataCallbackEx is called from the upload threads (never concurrently) and failed blocks are attempted again.
+* @param  uploadedBlockCount The number of blocks, from the start of the blob, that an earlier attempt already uploaded to the same blob. They are added to
+*                           the block list without being uploaded again, and the first block returned by getDataCallbackEx is block number uploadedBlockCount.
 *
 * @return    A @c BLOB_RESULT. BLOB_OK means the blob has been uploaded successfully. Any other value indicates an error
 */
-MOCKABLE_FUNCTION(, BLOB_RESULT, Blob_UploadMultipleBlocksFromSasUri, const char*, SASURI, IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX, getDataCallbackEx, void*, context, unsigned int*, httpStatus, BUFFER_HANDLE, httpResponse, const char*, certificates, HTTP_PROXY_OPTIONS*, proxyOptions, const char*, networkInterface)
+MOCKABLE_FUNCTION(, BLOB_RESULT, Blob_UploadMultipleBlocksFromSasUri, const char*, SASURI, IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX, getDataCallbackEx, void*, context, unsigned int*, httpStatus, BUFFER_HANDLE, httpResponse, const char*, certificates, HTTP_PROXY_OPTIONS*, proxyOptions, const char*, networkInterface, size_t, parallelBlocks, unsigned int, uploadedBlockCount)
 
 /**
 * @brief  Synchronously uploads a byte array as a new block to blob storage
@@ -0,0 +1,85 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file    blob_file_source.h
+*    @brief    Feeds the content of a file, block by block, to Blob_UploadMultipleBlocksFromSasUri, and keeps track of the blocks uploaded
+*              so that an upload that was interrupted can be resumed.
+*
+*    @remarks  The file is read with stdio, one block at a time, into a single buffer that is reused for every block.
+*
+*              When a checkpoint path is given, the number of blocks uploaded is written to the checkpoint file as the upload progresses, together
+*              with the size of the file, a hash of its first block and a hash of the destination name. Progress is deduced from the requests for
+*              the next block, so the blocks must be uploaded one at a time (parallelBlocks set to 1). The checkpoint is written aside and renamed
+*              over the previous one, and it is deleted once the upload completes. The file must not be modified between an upload and its resumption.
+*/
+
+#ifndef BLOB_FILE_SOURCE_H
+#define BLOB_FILE_SOURCE_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "umock_c/umock_c_prod.h"
+#include "iothub_client_core_common.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct BLOB_FILE_SOURCE_TAG* BLOB_FILE_SOURCE_HANDLE;
+
+/**
+* @brief    Opens @c file_path for reading. If @c checkpoint_path holds the checkpoint of an earlier upload of the same file to
+*           @c destination_file_name, reading starts after the blocks that upload completed.
+*
+* @param    file_path               Path of the file to upload.
+*
+* @param    checkpoint_path         Path of the checkpoint file, or NULL to upload the file from its start without keeping track of the progress.
+*
+* @param    destination_file_name   Name of the blob the file is uploaded to.
+*
+* @returns    A non-NULL @c BLOB_FILE_SOURCE_HANDLE value that is used when invoking other API functions.
+*/
+MOCKABLE_FUNCTION(, BLOB_FILE_SOURCE_HANDLE, blob_file_source_create, const char*, file_path, const char*, checkpoint_path, const char*, destination_file_name);
+
+/**
+* @brief    Closes the file and frees the resources of @c file_source. The checkpoint file is left in place unless the upload completed.
+*
+* @param    file_source    A @c BLOB_FILE_SOURCE_HANDLE obtained using blob_file_source_create.
+*/
+MOCKABLE_FUNCTION(, void, blob_file_source_destroy, BLOB_FILE_SOURCE_HANDLE, file_source);
+
+/**
+* @brief    Gets the number of blocks, from the start of the file, that an earlier upload completed according to the checkpoint.
+*
+* @param    file_source    A @c BLOB_FILE_SOURCE_HANDLE obtained using blob_file_source_create.
+*
+* @returns    The value to pass as uploadedBlockCount to Blob_UploadMultipleBlocksFromSasUri, 0 when the upload starts over.
+*/
+MOCKABLE_FUNCTION(, unsigned int, blob_file_source_get_uploaded_block_count, BLOB_FILE_SOURCE_HANDLE, file_source);
+
+/**
+* @brief    Informs if reading the file failed. The upload is then aborted by blob_file_source_get_data.
+*
+* @param    file_source    A @c BLOB_FILE_SOURCE_HANDLE obtained using blob_file_source_create.
+*
+* @returns    @c true if a block could not be read from the file, @c false otherwise.
+*/
+MOCKABLE_FUNCTION(, bool, blob_file_source_has_failed, BLOB_FILE_SOURCE_HANDLE, file_source);
+
+/**
+* @brief    The @c IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX that returns the blocks of the file. @c context is the @c BLOB_FILE_SOURCE_HANDLE.
+*           The data returned stays valid until the next call.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_RESULT, blob_file_source_get_data, IOTHUB_CLIENT_FILE_UPLOAD_RESULT, result, unsigned char const **, data, size_t*, size, void*, context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*BLOB_FILE_SOURCE_H*/
@@ -0,0 +1,65 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file    http_batch_encoder.h
+*    @brief    Encodes telemetry messages as items of an "application/vnd.microsoft.iothub.json" batch.
+*
+*    @remarks  An item is {"body":"<base64 of the payload>"[,"properties":{...}]}, or {"body":<JSON string>,"base64Encoded":false[,...]}
+*              for string messages, followed by a comma. A batch is "[" followed by its items, with the last comma replaced by "]".
+*              The size of an item is computed first with http_batch_encoder_measure, so that the whole batch can be written
+*              into a buffer allocated once.
+*/
+
+#ifndef HTTP_BATCH_ENCODER_H
+#define HTTP_BATCH_ENCODER_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif
+
+#include "umock_c/umock_c_prod.h"
+#include "iothub_message.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*every message counts towards the size limit of a request with the length of its payload plus MAXIMUM_PAYLOAD_OVERHEAD, and every
+property with the length of its name and value plus MAXIMUM_PROPERTY_OVERHEAD*/
+#define MAXIMUM_PAYLOAD_OVERHEAD 384
+#define MAXIMUM_PROPERTY_OVERHEAD 16
+
+/**
+* @brief    Computes the size of the batch item of @c message and how much it counts towards the size limit of a batch.
+*
+* @param    message         The message to encode.
+*
+* @param    encoded_size    Set to the number of bytes http_batch_encoder_write writes for @c message, trailing comma included.
+*
+* @param    message_size    Set to the length of the payload plus the length of every property, each with their service overhead.
+*
+* @returns    Zero if the message can be encoded, non-zero otherwise (unknown content type, or a string that is not ASCII).
+*/
+MOCKABLE_FUNCTION(, int, http_batch_encoder_measure, IOTHUB_MESSAGE_HANDLE, message, size_t*, encoded_size, size_t*, message_size);
+
+/**
+* @brief    Writes the batch item of @c message, followed by a comma, to @c destination.
+*
+* @param    message         The message to encode.
+*
+* @param    destination     Where the item is written. It is not NUL-terminated.
+*
+* @param    size            Number of bytes available at @c destination.
+*
+* @returns    The number of bytes written, or zero if the message cannot be encoded or the item does not fit in @c size bytes.
+*/
+MOCKABLE_FUNCTION(, size_t, http_batch_encoder_write, IOTHUB_MESSAGE_HANDLE, message, unsigned char*, destination, size_t, size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*HTTP_BATCH_ENCODER_H*/
@@ -5,6 +5,7 @@
 #define IOTHUB_CLIENT_PRIVATE_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "azure_c_shared_utility/constbuffer.h"
 #include "azure_c_shared_utility/doublylinkedlist.h"
@@ -49,6 +50,12 @@ typedef struct IOTHUB_MESSAGE_LIST_TAG
     DLIST_ENTRY entry;
     tickcounter_ms_t ms_timesOutAfter; /* a value of "0" means "no timeout", if the IOTHUBCLIENT_LL's handle tickcounter > msTimesOutAfer then the message shall timeout*/
     tickcounter_ms_t message_timeout_value;
+    tickcounter_ms_t ms_enqueued; /*only set when the client collects telemetry statistics*/
+    size_t payload_size; /*only set when the client collects telemetry statistics or limits OPTION_SEND_QUEUE_MAX_BYTES*/
+    uint64_t send_sequence; /*order in which IoTHubClientCore_LL_SendEventAsync accepted the message*/
+    DLIST_ENTRY timeout_entry; /*links the message in the client's deadline ordered timeout index, Flink is NULL when it is not indexed*/
+    IOTHUB_CLIENT_CORE_LL_HANDLE client_handle; /*client that accepted the message, its statistics account for it even when the transport is shared*/
+    size_t send_attempts; /*number of times a transport reported sending the message through TRANSPORT_CALLBACKS_INFO::event_sent_cb*/
 }IOTHUB_MESSAGE_LIST;
 
 typedef struct IOTHUB_DEVICE_TWIN_TAG
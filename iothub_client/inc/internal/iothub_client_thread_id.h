@@ -0,0 +1,27 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Identity of the calling thread, so that a thread running a client's callbacks can be recognized without thread-local
+// storage. It exists for Windows and POSIX threads only. Elsewhere (mbed, TI-RTOS, ...) IOTHUB_THREAD_ID_AVAILABLE is
+// not defined and the callers fall back to tracking the dispatch on the client.
+
+#ifndef IOTHUB_CLIENT_THREAD_ID_H
+#define IOTHUB_CLIENT_THREAD_ID_H
+
+#if defined(_WIN32)
+#include <windows.h>
+
+#define IOTHUB_THREAD_ID_AVAILABLE
+typedef DWORD IOTHUB_THREAD_ID;
+#define IOTHUB_THREAD_ID_CURRENT() GetCurrentThreadId()
+#define IOTHUB_THREAD_ID_EQUAL(a, b) ((a) == (b))
+#elif defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+
+#define IOTHUB_THREAD_ID_AVAILABLE
+typedef pthread_t IOTHUB_THREAD_ID;
+#define IOTHUB_THREAD_ID_CURRENT() pthread_self()
+#define IOTHUB_THREAD_ID_EQUAL(a, b) (pthread_equal((a), (b)) != 0)
+#endif
+
+#endif // IOTHUB_CLIENT_THREAD_ID_H
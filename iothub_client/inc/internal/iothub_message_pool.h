@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file    iothub_message_pool.h
+*    @brief    Preallocated memory for the messages a client clones in IoTHubClient_LL_SendEventAsync.
+*
+*    @remarks  A pool holds a block of message headers and an arena of small string slots used for the system properties
+*              (message id, correlation id, content type...). Messages cloned from the pool take their header and property
+*              strings from it, falling back to the heap once it is exhausted or for strings that do not fit a slot, and
+*              IoTHubMessage_Destroy gives them back in O(1). The payload and the property map are still allocated on the heap.
+*
+*              A pool and its messages are not thread safe; they are used under the lock of the client that owns them.
+*/
+
+#ifndef IOTHUB_MESSAGE_POOL_H
+#define IOTHUB_MESSAGE_POOL_H
+
+#include "umock_c/umock_c_prod.h"
+#include "iothub_message.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C"
+{
+#else
+#include <stddef.h>
+#endif
+
+typedef struct IOTHUB_MESSAGE_POOL_TAG* IOTHUB_MESSAGE_POOL_HANDLE;
+
+/**
+* @brief    Creates a pool for @c message_count messages.
+*
+* @param    message_count    Number of message headers to preallocate, each with room for a few property strings. Must not be 0.
+*
+* @returns    A handle to the pool, NULL on failure.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_POOL_HANDLE, IoTHubMessage_CreatePool, size_t, message_count);
+
+/**
+* @brief    Destroys a pool. If messages cloned from it still exist, the memory is released when the last of them is destroyed.
+*
+* @param    pool    A handle obtained using IoTHubMessage_CreatePool.
+*/
+MOCKABLE_FUNCTION(, void, IoTHubMessage_DestroyPool, IOTHUB_MESSAGE_POOL_HANDLE, pool);
+
+/**
+* @brief    Same as IoTHubMessage_Clone, with the header and the system property strings of the clone taken from @c pool.
+*
+* @param    iotHubMessageHandle    Handle to the message to clone.
+* @param    pool                   A handle obtained using IoTHubMessage_CreatePool.
+*
+* @returns    A handle to the clone, to be destroyed with IoTHubMessage_Destroy, NULL on failure.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_HANDLE, IoTHubMessage_CloneFromPool, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, IOTHUB_MESSAGE_POOL_HANDLE, pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_MESSAGE_POOL_H */
@@ -9,6 +9,8 @@
 union IOTHUB_IDENTITY_INFO_TAG;
 typedef union IOTHUB_IDENTITY_INFO_TAG IOTHUB_IDENTITY_INFO;
 
+struct IOTHUB_MESSAGE_LIST_TAG;
+
 #include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/platform.h"
@@ -39,6 +41,10 @@ extern "C"
     typedef void (*pfTransport_Twin_RetrievePropertyComplete_Callback)(DEVICE_TWIN_UPDATE_STATE update_state, const unsigned char* payLoad, size_t size, void* ctx);
     typedef int (*pfTransport_DeviceMethod_Complete_Callback)(const char* method_name, const unsigned char* payLoad, size_t size, METHOD_HANDLE response_id, void* ctx);
     typedef const char* (*pfTransport_GetOption_Model_Id_Callback)(void* ctx);
+    /*optional, called each time a transport writes an event taken from waitingToSend, bytes_sent being what it wrote for it*/
+    typedef void (*pfTransport_EventSent_Callback)(struct IOTHUB_MESSAGE_LIST_TAG* message, size_t bytes_sent);
+    /*optional, called after a DoWork pass of a transport that batches its writes wrote message_count events with payload_bytes of payload*/
+    typedef void (*pfTransport_EventBatchSent_Callback)(size_t message_count, size_t payload_bytes, void* ctx);
 
     /** @brief    This struct captures device configuration. */
     typedef struct IOTHUB_DEVICE_CONFIG_TAG
@@ -69,12 +75,18 @@ extern "C"
         pfTransport_Twin_RetrievePropertyComplete_Callback twin_retrieve_prop_complete_cb;
         pfTransport_DeviceMethod_Complete_Callback method_complete_cb;
         pfTransport_GetOption_Model_Id_Callback get_model_id_cb;
+        pfTransport_EventSent_Callback event_sent_cb;
+        pfTransport_EventBatchSent_Callback event_batch_sent_cb;
     } TRANSPORT_CALLBACKS_INFO;
 
     typedef STRING_HANDLE (*pfIoTHubTransport_GetHostname)(TRANSPORT_LL_HANDLE handle);
     typedef IOTHUB_CLIENT_RESULT(*pfIoTHubTransport_SetOption)(TRANSPORT_LL_HANDLE handle, const char *optionName, const void* value);
     typedef TRANSPORT_LL_HANDLE(*pfIoTHubTransport_Create)(const IOTHUBTRANSPORT_CONFIG* config, TRANSPORT_CALLBACKS_INFO* cb_info, void* ctx);
     typedef void (*pfIoTHubTransport_Destroy)(TRANSPORT_LL_HANDLE handle);
+    /*waitingToSend is the client's list of IOTHUB_MESSAGE_LIST events, oldest first. A transport takes events only from its head, in order,
+    and when it gives events back (e.g. to retry them after a disconnect) it puts them back at its head, in their original order, ahead of
+    the events it has not taken yet. The client relies on this to tell the events still in waitingToSend from those the transport holds,
+    see is_waiting_to_send in iothub_client_core_ll.c*/
     typedef IOTHUB_DEVICE_HANDLE(*pfIotHubTransport_Register)(TRANSPORT_LL_HANDLE handle, const IOTHUB_DEVICE_CONFIG* device, PDLIST_ENTRY waitingToSend);
     typedef void(*pfIotHubTransport_Unregister)(IOTHUB_DEVICE_HANDLE deviceHandle);
     typedef int (*pfIoTHubTransport_Subscribe)(IOTHUB_DEVICE_HANDLE handle);
@@ -94,6 +106,8 @@ extern "C"
     typedef void(*pfIoTHubTransport_Unsubscribe_InputQueue)(IOTHUB_DEVICE_HANDLE handle);
     typedef int(*pfIoTHubTransport_SetCallbackContext)(TRANSPORT_LL_HANDLE handle, void* ctx);
     typedef int(*pfIoTHubTransport_GetSupportedPlatformInfo)(TRANSPORT_LL_HANDLE handle, PLATFORM_INFO_OPTION* info);
+    /*optional, may be NULL. Called each time an event is added to the waitingToSend list of handle*/
+    typedef void(*pfIoTHubTransport_OnEventQueued)(IOTHUB_DEVICE_HANDLE handle);
 
 #define TRANSPORT_PROVIDER_FIELDS                                                   \
 pfIotHubTransport_SendMessageDisposition IoTHubTransport_SendMessageDisposition;    \
@@ -118,7 +132,8 @@ pfIoTHubTransport_Subscribe_InputQueue IoTHubTransport_Subscribe_InputQueue;
 pfIoTHubTransport_Unsubscribe_InputQueue IoTHubTransport_Unsubscribe_InputQueue;    \
 pfIoTHubTransport_SetCallbackContext IoTHubTransport_SetCallbackContext;            \
 pfIoTHubTransport_GetTwinAsync IoTHubTransport_GetTwinAsync;                        \
-pfIoTHubTransport_GetSupportedPlatformInfo IoTHubTransport_GetSupportedPlatformInfo     /*there's an intentional missing ; on this line*/
+pfIoTHubTransport_GetSupportedPlatformInfo IoTHubTransport_GetSupportedPlatformInfo;\
+pfIoTHubTransport_OnEventQueued IoTHubTransport_OnEventQueued                       /*there's an intentional missing ; on this line*/
 
     struct TRANSPORT_PROVIDER_TAG
     {
@@ -41,6 +41,10 @@ extern "C"
     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubTransport_StartWorkerThread, TRANSPORT_HANDLE, transportHandle, IOTHUB_CLIENT_CORE_HANDLE, clientHandle, IOTHUB_CLIENT_MULTIPLEXED_DO_WORK, muxDoWork);
     MOCKABLE_FUNCTION(, bool, IoTHubTransport_SignalEndWorkerThread, TRANSPORT_HANDLE, transportHandle, IOTHUB_CLIENT_CORE_HANDLE, clientHandle);
     MOCKABLE_FUNCTION(, void, IoTHubTransport_JoinWorkerThread, TRANSPORT_HANDLE, transportHandle, IOTHUB_CLIENT_CORE_HANDLE, clientHandle);
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubTransport_SetEventDrivenDoWork, TRANSPORT_HANDLE, transportHandle, bool, eventDriven);
+    MOCKABLE_FUNCTION(, void, IoTHubTransport_SignalWork, TRANSPORT_HANDLE, transportHandle);
+    MOCKABLE_FUNCTION(, bool, IoTHubTransport_IsEventDriven, TRANSPORT_HANDLE, transportHandle);
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubTransport_SetDispatchThreadCount, TRANSPORT_HANDLE, transportHandle, size_t, threadCount);
 
 #ifdef __cplusplus
 }
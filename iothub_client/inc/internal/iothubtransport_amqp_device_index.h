@@ -0,0 +1,39 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Hash index of the devices registered on a multiplexed AMQP transport, keyed by device id and module id.
+// The transport keeps its list of registered devices for iterating over them; this index only makes looking up a
+// device by its identity independent of the number of devices registered.
+
+#ifndef IOTHUBTRANSPORT_AMQP_DEVICE_INDEX_H
+#define IOTHUBTRANSPORT_AMQP_DEVICE_INDEX_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif
+
+#include "umock_c/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct AMQP_DEVICE_INDEX_INSTANCE_TAG* AMQP_DEVICE_INDEX_HANDLE;
+
+MOCKABLE_FUNCTION(, AMQP_DEVICE_INDEX_HANDLE, amqp_device_index_create);
+MOCKABLE_FUNCTION(, void, amqp_device_index_destroy, AMQP_DEVICE_INDEX_HANDLE, index);
+// Fails if a device with the same `device_id` and `module_id` (which can be NULL) is already in the index.
+MOCKABLE_FUNCTION(, int, amqp_device_index_add, AMQP_DEVICE_INDEX_HANDLE, index, const char*, device_id, const char*, module_id, void*, device);
+// Returns the `device` added with `device_id` and `module_id`, or NULL if there is none.
+MOCKABLE_FUNCTION(, void*, amqp_device_index_find, AMQP_DEVICE_INDEX_HANDLE, index, const char*, device_id, const char*, module_id);
+MOCKABLE_FUNCTION(, int, amqp_device_index_remove, AMQP_DEVICE_INDEX_HANDLE, index, const char*, device_id, const char*, module_id);
+MOCKABLE_FUNCTION(, size_t, amqp_device_index_get_count, AMQP_DEVICE_INDEX_HANDLE, index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*IOTHUBTRANSPORT_AMQP_DEVICE_INDEX_H*/
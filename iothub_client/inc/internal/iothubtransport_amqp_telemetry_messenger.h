@@ -73,6 +73,7 @@ typedef struct TELEMETRY_MESSENGER_CONFIG_TAG
     char* iothub_host_fqdn;
     ON_TELEMETRY_MESSENGER_STATE_CHANGED_CALLBACK on_state_changed_callback;
     void* on_state_changed_context;
+    pfTransport_EventSent_Callback event_sent_cb;
 } TELEMETRY_MESSENGER_CONFIG;
 
 #define AMQP_BATCHING_RESERVE_SIZE              (1024)
@@ -0,0 +1,120 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file    persistent_queue.h
+*    @brief    A store-and-forward queue of telemetry messages kept in an append-only log of segment files.
+*
+*    @remarks  Records are appended to the newest segment file and read back in the order they were appended. A read record stays
+*              in the log until it is acknowledged; the position of the oldest record not yet acknowledged is written to a checkpoint
+*              file by persistent_queue_sync, which also syncs the appends to the disk. After a restart, reading resumes from the last
+*              checkpoint, so records acknowledged after it are read again, and records appended after the last sync may be lost on a power
+*              failure. Segments entirely before the checkpoint are deleted.
+*
+*              Files are named after @c path: "<path>.checkpoint" and "<path>.<offset>.log", where offset is the position of the
+*              segment's first byte in the log, as 16 hexadecimal digits.
+*/
+
+#ifndef PERSISTENT_QUEUE_H
+#define PERSISTENT_QUEUE_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "umock_c/umock_c_prod.h"
+#include "iothub_message.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct PERSISTENT_QUEUE_TAG* PERSISTENT_QUEUE_HANDLE;
+
+/**
+* @brief    Opens the log named after @c path, creating it if it does not exist, and positions reading at its last checkpoint.
+*
+* @param    path            Prefix of the names of the log files, including their directory.
+*
+* @param    segment_size    Size, in bytes, past which appending starts a new segment file. A record is never split between segments.
+*
+* @returns    A non-NULL @c PERSISTENT_QUEUE_HANDLE value that is used when invoking other API functions.
+*/
+MOCKABLE_FUNCTION(, PERSISTENT_QUEUE_HANDLE, persistent_queue_create, const char*, path, size_t, segment_size);
+
+/**
+* @brief    Flushes buffered appends and closes the log, without writing a checkpoint. The files are left in place.
+*
+* @param    persistent_queue    A @c PERSISTENT_QUEUE_HANDLE obtained using persistent_queue_create.
+*/
+MOCKABLE_FUNCTION(, void, persistent_queue_destroy, PERSISTENT_QUEUE_HANDLE, persistent_queue);
+
+/**
+* @brief    Appends a copy of @c message to the log. The write is buffered until the next call to persistent_queue_sync.
+*
+* @param    persistent_queue    A @c PERSISTENT_QUEUE_HANDLE obtained using persistent_queue_create.
+*
+* @param    message             The message to store. Its payload, system properties and application properties are stored.
+*
+* @param    record_id           Set to the identifier of the new record. Identifiers grow in the order records are appended.
+*
+* @returns    Zero if the no errors occur, non-zero otherwise.
+*/
+MOCKABLE_FUNCTION(, int, persistent_queue_append, PERSISTENT_QUEUE_HANDLE, persistent_queue, IOTHUB_MESSAGE_HANDLE, message, uint64_t*, record_id);
+
+/**
+* @brief    Informs if there are records in the log that have not been read yet.
+*
+* @param    persistent_queue    A @c PERSISTENT_QUEUE_HANDLE obtained using persistent_queue_create.
+*
+* @returns    @c true if persistent_queue_read may return a record, @c false otherwise.
+*/
+MOCKABLE_FUNCTION(, bool, persistent_queue_has_unread, PERSISTENT_QUEUE_HANDLE, persistent_queue);
+
+/**
+* @brief    Reads the next record of the log as a new message.
+*
+* @remarks  A record that does not pass its integrity check, such as one torn by a crash while it was written, ends its segment:
+*           reading carries on with the next segment. If no record is left, @c message is set to NULL and zero is returned.
+*
+* @param    persistent_queue    A @c PERSISTENT_QUEUE_HANDLE obtained using persistent_queue_create.
+*
+* @param    message             Set to a new message the caller owns.
+*
+* @param    record_id           Set to the identifier of the record, to be passed to persistent_queue_ack.
+*
+* @returns    Zero if the no errors occur, non-zero otherwise.
+*/
+MOCKABLE_FUNCTION(, int, persistent_queue_read, PERSISTENT_QUEUE_HANDLE, persistent_queue, IOTHUB_MESSAGE_HANDLE*, message, uint64_t*, record_id);
+
+/**
+* @brief    Marks a record returned by persistent_queue_read as done with. Records may be acknowledged in any order; the checkpoint
+*           only moves past records that have all been acknowledged.
+*
+* @param    persistent_queue    A @c PERSISTENT_QUEUE_HANDLE obtained using persistent_queue_create.
+*
+* @param    record_id           Identifier returned by persistent_queue_read.
+*
+* @returns    Zero if the no errors occur, non-zero otherwise.
+*/
+MOCKABLE_FUNCTION(, int, persistent_queue_ack, PERSISTENT_QUEUE_HANDLE, persistent_queue, uint64_t, record_id);
+
+/**
+* @brief    Syncs buffered appends to the disk, writes the checkpoint if it moved and deletes the segments before it.
+*
+* @param    persistent_queue    A @c PERSISTENT_QUEUE_HANDLE obtained using persistent_queue_create.
+*
+* @returns    Zero if the no errors occur, non-zero otherwise.
+*/
+MOCKABLE_FUNCTION(, int, persistent_queue_sync, PERSISTENT_QUEUE_HANDLE, persistent_queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*PERSISTENT_QUEUE_H*/
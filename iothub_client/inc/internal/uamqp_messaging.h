@@ -16,6 +16,18 @@ extern "C"
     MOCKABLE_FUNCTION(, int, message_create_IoTHubMessage_from_uamqp_message, MESSAGE_HANDLE, uamqp_message, IOTHUB_MESSAGE_HANDLE*, iothubclient_message);
     MOCKABLE_FUNCTION(, int, message_create_uamqp_encoding_from_iothub_message, MESSAGE_HANDLE, message_batch_container, IOTHUB_MESSAGE_HANDLE, message_handle, BINARY_DATA*, body_binary_data);
 
+    // Memory reused across calls to message_create_uamqp_encoding_in_buffer. It grows to the largest message encoded so far;
+    // the owner frees `bytes` once done with it.
+    typedef struct UAMQP_ENCODING_BUFFER_TAG
+    {
+        unsigned char* bytes;
+        size_t size;
+    } UAMQP_ENCODING_BUFFER;
+
+    // Encodes like message_create_uamqp_encoding_from_iothub_message, but into `encoding_buffer` instead of a new allocation.
+    // `body_binary_data` points into `encoding_buffer` and is valid until the next call with the same buffer.
+    MOCKABLE_FUNCTION(, int, message_create_uamqp_encoding_in_buffer, MESSAGE_HANDLE, message_batch_container, IOTHUB_MESSAGE_HANDLE, message_handle, UAMQP_ENCODING_BUFFER*, encoding_buffer, BINARY_DATA*, body_binary_data);
+
 #ifdef __cplusplus
 }
 #endif
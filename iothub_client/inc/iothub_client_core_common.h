@@ -13,8 +13,11 @@
 #include "iothub_message.h"
 
 #ifdef __cplusplus
+#include <cstdint>
 extern "C"
 {
+#else
+#include <stdint.h>
 #endif
 
 #define IOTHUB_CLIENT_FILE_UPLOAD_RESULT_VALUES \
@@ -29,7 +32,8 @@ extern "C"
     IOTHUB_CLIENT_INVALID_ARG,            \
     IOTHUB_CLIENT_ERROR,                  \
     IOTHUB_CLIENT_INVALID_SIZE,           \
-    IOTHUB_CLIENT_INDEFINITE_TIME
+    IOTHUB_CLIENT_INDEFINITE_TIME,        \
+    IOTHUB_CLIENT_QUEUE_FULL
 
     /** @brief Enumeration specifying the status of calls to various APIs in this module.
     */
@@ -102,7 +106,8 @@ extern "C"
     IOTHUB_CLIENT_CONFIRMATION_OK,                   \
     IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY,      \
     IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT,      \
-    IOTHUB_CLIENT_CONFIRMATION_ERROR                 \
+    IOTHUB_CLIENT_CONFIRMATION_ERROR,                \
+    IOTHUB_CLIENT_CONFIRMATION_DROPPED               \
 
     /** @brief Enumeration passed in by the IoT Hub when the event confirmation
     *           callback is invoked to indicate status of the event processing in
@@ -149,12 +154,36 @@ extern "C"
 
     MU_DEFINE_ENUM_WITHOUT_INVALID(DEVICE_TWIN_UPDATE_STATE, DEVICE_TWIN_UPDATE_STATE_VALUES);
 
+#define IOTHUB_CLIENT_SEND_QUEUE_FULL_POLICY_VALUES \
+    IOTHUB_CLIENT_SEND_QUEUE_FULL_FAIL,             \
+    IOTHUB_CLIENT_SEND_QUEUE_FULL_DROP_OLDEST,      \
+    IOTHUB_CLIENT_SEND_QUEUE_FULL_BLOCK
+
+    /** @brief What SendEventAsync does when the send queue is at OPTION_SEND_QUEUE_MAX_MESSAGES or OPTION_SEND_QUEUE_MAX_BYTES.
+    *           @c IOTHUB_CLIENT_SEND_QUEUE_FULL_FAIL returns @c IOTHUB_CLIENT_QUEUE_FULL,
+    *           @c IOTHUB_CLIENT_SEND_QUEUE_FULL_DROP_OLDEST completes the oldest messages not yet picked up by the transport with
+    *           @c IOTHUB_CLIENT_CONFIRMATION_DROPPED to make room, and @c IOTHUB_CLIENT_SEND_QUEUE_FULL_BLOCK (convenience layer only)
+    *           waits until there is room. Called from a callback, which runs on the worker thread that drains the queue,
+    *           @c IOTHUB_CLIENT_SEND_QUEUE_FULL_BLOCK returns @c IOTHUB_CLIENT_QUEUE_FULL instead of waiting.
+    */
+    MU_DEFINE_ENUM_WITHOUT_INVALID(IOTHUB_CLIENT_SEND_QUEUE_FULL_POLICY, IOTHUB_CLIENT_SEND_QUEUE_FULL_POLICY_VALUES);
+
+#define IOTHUB_CLIENT_SEND_QUEUE_STATE_VALUES       \
+    IOTHUB_CLIENT_SEND_QUEUE_HIGH_WATERMARK,        \
+    IOTHUB_CLIENT_SEND_QUEUE_LOW_WATERMARK
+
+    /** @brief Enumeration passed to the send queue callback. The high watermark is reached when the send queue hits one of its
+    *           limits, the low watermark when it then drains back to half of every limit.
+    */
+    MU_DEFINE_ENUM_WITHOUT_INVALID(IOTHUB_CLIENT_SEND_QUEUE_STATE, IOTHUB_CLIENT_SEND_QUEUE_STATE_VALUES);
+
     typedef void(*IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK)(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback);
     typedef void(*IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK)(IOTHUB_CLIENT_CONNECTION_STATUS result, IOTHUB_CLIENT_CONNECTION_STATUS_REASON reason, void* userContextCallback);
     typedef IOTHUBMESSAGE_DISPOSITION_RESULT (*IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC)(IOTHUB_MESSAGE_HANDLE message, void* userContextCallback);
 
     typedef void(*IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK)(DEVICE_TWIN_UPDATE_STATE update_state, const unsigned char* payLoad, size_t size, void* userContextCallback);
     typedef void(*IOTHUB_CLIENT_REPORTED_STATE_CALLBACK)(int status_code, void* userContextCallback);
+    typedef void(*IOTHUB_CLIENT_SEND_QUEUE_CALLBACK)(IOTHUB_CLIENT_SEND_QUEUE_STATE state, void* userContextCallback);
     typedef int(*IOTHUB_CLIENT_DEVICE_METHOD_CALLBACK_ASYNC)(const char* method_name, const unsigned char* payload, size_t size, unsigned char** response, size_t* response_size, void* userContextCallback);
     typedef int(*IOTHUB_CLIENT_INBOUND_DEVICE_METHOD_CALLBACK)(const char* method_name, const unsigned char* payload, size_t size, METHOD_HANDLE method_id, void* userContextCallback);
 
@@ -234,6 +263,66 @@ extern "C"
         const char* deviceSasToken;
     } IOTHUB_CLIENT_DEVICE_CONFIG;
 
+    /** @brief    Number of buckets in @c IOTHUB_CLIENT_STATISTICS::sendLatencyHistogram. */
+#define IOTHUB_CLIENT_SEND_LATENCY_BUCKETS 20
+
+    /** @brief    Telemetry statistics of a client, as returned by the GetStatistics APIs. */
+    typedef struct IOTHUB_CLIENT_STATISTICS_TAG
+    {
+        /** @brief    Messages accepted by SendEventAsync. */
+        uint64_t messagesEnqueued;
+
+        /** @brief    Messages the transport has written to the network at least once. */
+        uint64_t messagesSent;
+
+        /** @brief    Messages the transport has written to the network more than once. */
+        uint64_t messagesRetried;
+
+        /** @brief    Messages confirmed with @c IOTHUB_CLIENT_CONFIRMATION_OK. */
+        uint64_t messagesConfirmed;
+
+        /** @brief    Messages confirmed with @c IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT. */
+        uint64_t messagesTimedOut;
+
+        /** @brief    Messages confirmed with @c IOTHUB_CLIENT_CONFIRMATION_ERROR, @c IOTHUB_CLIENT_CONFIRMATION_DROPPED or @c IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY. */
+        uint64_t messagesFailed;
+
+        /** @brief    Payload bytes of the messages accepted by SendEventAsync. Only collected with @c OPTION_TELEMETRY_STATISTICS. */
+        uint64_t bytesEnqueued;
+
+        /** @brief    Payload bytes of the messages confirmed with @c IOTHUB_CLIENT_CONFIRMATION_OK. Only collected with @c OPTION_TELEMETRY_STATISTICS. */
+        uint64_t bytesConfirmed;
+
+        /** @brief    Bytes the transports wrote to the network for the messages, counting every attempt: the encoded message and, for MQTT, the PUBLISH packet header. */
+        uint64_t bytesSent;
+
+        /** @brief    Messages accepted by SendEventAsync that no transport has sent yet. */
+        uint64_t waitingToSendCount;
+
+        /** @brief    Messages sent at least once whose confirmation callback has not run yet, including those the transport is going to retry. */
+        uint64_t inFlightCount;
+
+        /** @brief    Milliseconds from SendEventAsync to the confirmation callback, for every confirmed message.
+        *             Bucket 0 counts latencies under 1 ms, bucket i latencies in [2^(i-1), 2^i) ms and the last bucket everything above.
+        *             Only collected with @c OPTION_TELEMETRY_STATISTICS. */
+        uint64_t sendLatencyHistogram[IOTHUB_CLIENT_SEND_LATENCY_BUCKETS];
+
+        /** @brief    Highest latency recorded in @c sendLatencyHistogram, in milliseconds. */
+        uint64_t sendLatencyMaxMs;
+
+        /** @brief    DoWork passes that published at least one message, each being a batch. Only counted by MQTT, see @c OPTION_TELEMETRY_PUBLISH_BATCH_SIZE. */
+        uint64_t publishBatches;
+
+        /** @brief    Messages published by the last batch. */
+        uint64_t lastPublishBatchMessages;
+
+        /** @brief    Payload bytes of the messages published by the last batch. */
+        uint64_t lastPublishBatchBytes;
+
+        /** @brief    Most messages published by a single batch. */
+        uint64_t maxPublishBatchMessages;
+    } IOTHUB_CLIENT_STATISTICS;
+
 #ifdef __cplusplus
 }
 #endif
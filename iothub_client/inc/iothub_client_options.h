@@ -39,10 +39,12 @@ extern "C"
 
     static STATIC_VAR_UNUSED const char* OPTION_MIN_POLLING_TIME = "MinimumPollingTime";
     static STATIC_VAR_UNUSED const char* OPTION_BATCHING = "Batching";
+    static STATIC_VAR_UNUSED const char* OPTION_HTTP_MAX_PARALLEL_REQUESTS = "http_max_parallel_requests";
 
     /* DEPRECATED:: OPTION_MESSAGE_TIMEOUT is DEPRECATED! Use OPTION_SERVICE_SIDE_KEEP_ALIVE_FREQ_SECS for AMQP; MQTT has no option available. OPTION_MESSAGE_TIMEOUT legacy variable will be kept for back-compat.  */
     static STATIC_VAR_UNUSED const char* OPTION_MESSAGE_TIMEOUT = "messageTimeout";
     static STATIC_VAR_UNUSED const char* OPTION_BLOB_UPLOAD_TIMEOUT_SECS = "blob_upload_timeout_secs";
+    static STATIC_VAR_UNUSED const char* OPTION_BLOB_UPLOAD_PARALLEL_BLOCKS = "blob_upload_parallel_blocks";
 
     /*
     * @brief    Set the interface name to use as outgoing network interface for upload to blob.
@@ -61,6 +63,29 @@ extern "C"
     */
     static STATIC_VAR_UNUSED const char* OPTION_AUTO_URL_ENCODE_DECODE = "auto_url_encode_decode";
 
+    /*
+    * @brief    Maximum number of telemetry messages that may be PUBLISH'd and awaiting a PUBACK at the same time (size_t*).
+    *           Further messages stay queued until acknowledgements arrive. The default of 0 means no limit.
+    *           A limit also preallocates the transport's tracking entries for that many messages.
+    *           Only valid for use with MQTT Transport
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_MAX_INFLIGHT_TELEMETRY = "max_inflight_telemetry";
+
+    /*
+    * @brief    Maximum total payload bytes of telemetry messages that may be PUBLISH'd and awaiting a PUBACK at the same time (size_t*).
+    *           A message is always sent when nothing else is in flight. The default of 0 means no limit.
+    *           Only valid for use with MQTT Transport
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_MAX_INFLIGHT_TELEMETRY_BYTES = "max_inflight_telemetry_bytes";
+
+    /*
+    * @brief    Maximum number of telemetry messages PUBLISH'd in a single DoWork call (size_t*).
+    *           The remaining messages are sent on later DoWork calls. The default of 0 means no limit.
+    *           The size of the batches is reported by the publishBatch fields of IOTHUB_CLIENT_STATISTICS.
+    *           Only valid for use with MQTT Transport
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_TELEMETRY_PUBLISH_BATCH_SIZE = "telemetry_publish_batch_size";
+
     /*
     * @brief Informs the service of what is the maximum period the client will wait for a keep-alive message from the service.
     *        The service must send keep-alives before this timeout is reached, otherwise the client will trigger its re-connection logic.
@@ -94,6 +119,91 @@ extern "C"
 
     static STATIC_VAR_UNUSED const char* OPTION_DO_WORK_FREQUENCY_IN_MS = "do_work_freq_ms";
 
+    /*
+    * @brief When set to true the worker thread spun by the convenience layer blocks until there is work to do (e.g. a message is
+    *        queued by IoTHubClient_SendEventAsync) instead of waking up every OPTION_DO_WORK_FREQUENCY_IN_MS.  While messages are
+    *        outstanding it keeps running at OPTION_DO_WORK_FREQUENCY_IN_MS, and when idle it still wakes up at least every 100 ms
+    *        to service the connection.  For clients sharing a transport this applies to the shared worker thread.
+    *        The default is false (the thread wakes up every OPTION_DO_WORK_FREQUENCY_IN_MS).
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_EVENT_DRIVEN_DO_WORK = "event_driven_do_work";
+
+    /*
+    * @brief Number of threads used to run the user callbacks of clients sharing a transport (size_t*).  Each client's callbacks
+    *        still run one at a time and in order, but different clients are dispatched in parallel so a slow callback only stalls
+    *        its own client.  Must be set before the first client on the transport starts its worker thread.
+    *        The default is 0 (callbacks of all clients run on the shared worker thread).
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_MULTIPLEXED_DISPATCH_THREADS = "multiplexed_dispatch_threads";
+
+    /*
+    * @brief Number of queued message entries preallocated as one block per client (size_t*).  Entries for IoTHubClient_LL_SendEventAsync
+    *        are taken from this block and returned to it when the message completes, falling back to the heap once it is exhausted.
+    *        The header and the short system properties (message id, content type...) of the message copies are preallocated the same
+    *        way; their payload and application properties are still allocated from the heap.
+    *        Cannot be changed while messages taken from the block are outstanding.  Not supported with a shared transport.
+    *        The default is 0 (every entry is allocated from the heap).
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_MESSAGE_NODE_POOL_SIZE = "message_node_pool_size";
+
+    /*
+    * @brief When set to true the client also records the payload size and the send-to-confirmation latency of each message (bool*),
+    *        reported by the GetStatistics APIs.  This costs a tick count read and a payload size lookup per message.
+    *        The default is false (only message counts, bytes sent and queue depths are kept).
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_TELEMETRY_STATISTICS = "telemetry_statistics";
+
+    /*
+    * @brief Maximum number of messages accepted by SendEventAsync whose confirmation callback has not run yet (size_t*).
+    *        What happens past it is set by OPTION_SEND_QUEUE_FULL_POLICY.  Not supported with a shared transport.
+    *        The default is 0 (no limit).
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_SEND_QUEUE_MAX_MESSAGES = "send_queue_max_messages";
+
+    /*
+    * @brief Maximum total payload bytes of the messages accepted by SendEventAsync whose confirmation callback has not run yet (size_t*).
+    *        A single message larger than this is rejected with IOTHUB_CLIENT_INVALID_SIZE.  Not supported with a shared transport.
+    *        The default is 0 (no limit).
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_SEND_QUEUE_MAX_BYTES = "send_queue_max_bytes";
+
+    /*
+    * @brief What SendEventAsync does once OPTION_SEND_QUEUE_MAX_MESSAGES or OPTION_SEND_QUEUE_MAX_BYTES is reached
+    *        (IOTHUB_CLIENT_SEND_QUEUE_FULL_POLICY*).  IOTHUB_CLIENT_SEND_QUEUE_FULL_BLOCK is only accepted by the convenience layer,
+    *        and sends made from a client callback return IOTHUB_CLIENT_QUEUE_FULL instead of blocking.
+    *        The default is IOTHUB_CLIENT_SEND_QUEUE_FULL_FAIL.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_SEND_QUEUE_FULL_POLICY = "send_queue_full_policy";
+
+    /*
+    * @brief Path prefix of a store-and-forward log on disk (const char*).  Once set, messages sent while OPTION_PERSISTENT_QUEUE_RAM_MESSAGES
+    *        messages are outstanding are appended to the log instead of being queued in memory, and are queued again, in order, as room
+    *        frees up, including after a restart of the process.  Messages read back after a restart have no confirmation callback.
+    *        Can only be set once per client.  Not supported with a shared transport.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_PERSISTENT_QUEUE_PATH = "persistent_queue_path";
+
+    /*
+    * @brief Number of outstanding messages kept in memory before further messages go to the log set by OPTION_PERSISTENT_QUEUE_PATH (size_t*).
+    *        The default is 100, 0 is rejected.  Messages read back from the log are also held to the send queue limits and are
+    *        never dropped by IOTHUB_CLIENT_SEND_QUEUE_FULL_DROP_OLDEST.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_PERSISTENT_QUEUE_RAM_MESSAGES = "persistent_queue_ram_messages";
+
+    /*
+    * @brief Milliseconds between two syncs to the disk of the log set by OPTION_PERSISTENT_QUEUE_PATH, each also recording which messages
+    *        have been confirmed (tickcounter_ms_t*).  Messages sent after the last sync can be lost on a power failure, and messages
+    *        confirmed after it are sent again after a restart.  The default is 1000.  On platforms without fsync or _commit (mbed,
+    *        TI-RTOS) a sync only flushes the C library buffers.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_PERSISTENT_QUEUE_SYNC_INTERVAL = "persistent_queue_sync_interval";
+
+    /*
+    * @brief Size in bytes past which the log set by OPTION_PERSISTENT_QUEUE_PATH starts a new segment file (size_t*).  Segment files are
+    *        deleted once all their messages have been confirmed.  Must be set before OPTION_PERSISTENT_QUEUE_PATH.  The default is 1048576.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_PERSISTENT_QUEUE_SEGMENT_SIZE = "persistent_queue_segment_size";
+
 // Minimum percentage (in the 0 to 1 range) of multiplexed registered devices that must be failing for a transport-wide reconnection to be triggered.
 // A value of zero results in a single registered device to be able to cause a general transport reconnection 
 // (thus causing all other multiplexed registered devices to be also reconnected, meaning an agressive reconnection strategy).
@@ -128,6 +128,29 @@ extern "C"
     */
     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_SendEventAsync, IOTHUB_DEVICE_CLIENT_HANDLE, iotHubClientHandle, IOTHUB_MESSAGE_HANDLE, eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, eventConfirmationCallback, void*, userContextCallback);
 
+    /**
+    * @brief    Asynchronous call to send the message specified by @p eventMessageHandle, without copying it.
+    *
+    * @param    iotHubClientHandle              The handle created by a call to the create function.
+    * @param    eventMessageHandle              The handle to an IoT Hub message.
+    * @param    eventConfirmationCallback       The callback specified by the device for receiving
+    *                                           confirmation of the delivery of the IoT Hub message.
+    *                                           The user can specify a @c NULL value here to
+    *                                           indicate that no callback is required.
+    * @param    userContextCallback             User specified context that will be provided to the
+    *                                           callback. This can be @c NULL.
+    *
+    *           @b NOTE: The application behavior is undefined if the user calls
+    *           the IoTHubDeviceClient_Destroy function from within any callback.
+    * @remarks
+    *           Unlike IoTHubDeviceClient_SendEventAsync, the message is queued as is instead of being cloned.
+    *           On success the iothub client owns @c eventMessageHandle and destroys it when the message is effectively sent,
+    *           if a failure sending it occurs, or if the client is destroyed; the calling application must not use or destroy it afterwards.
+    *           On failure the calling application still owns @c eventMessageHandle.
+    * @return   IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_SendEventAsyncTakeOwnership, IOTHUB_DEVICE_CLIENT_HANDLE, iotHubClientHandle, IOTHUB_MESSAGE_HANDLE, eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, eventConfirmationCallback, void*, userContextCallback);
+
     /**
     * @brief    This function returns the current sending status for IoTHubClient.
     *
@@ -144,6 +167,17 @@ extern "C"
     */
     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_GetSendStatus, IOTHUB_DEVICE_CLIENT_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_STATUS*, iotHubClientStatus);
 
+    /**
+    * @brief    This API retrieves the telemetry statistics of the client: message counts, bytes sent, queue depths and, when
+    *           @c OPTION_TELEMETRY_STATISTICS is enabled, payload bytes and a send-to-confirmation latency histogram.
+    *
+    * @param    iotHubClientHandle        The handle created by a call to the create function.
+    * @param    statistics                Receives a snapshot of the statistics.
+    *
+    * @return    IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_GetStatistics, IOTHUB_DEVICE_CLIENT_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_STATISTICS*, statistics);
+
     /**
     * @brief    Sets up the message callback to be invoked when IoT Hub issues a
     *           message to the device. This is a blocking call.
@@ -180,6 +214,27 @@ extern "C"
     */
     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_SetConnectionStatusCallback, IOTHUB_DEVICE_CLIENT_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK, connectionStatusCallback, void*, userContextCallback);
 
+    /**
+    * @brief    Sets up the callback invoked when the send queue reaches OPTION_SEND_QUEUE_MAX_MESSAGES or
+    *           OPTION_SEND_QUEUE_MAX_BYTES, and again when it has drained to half of them.
+    *
+    * @param    iotHubClientHandle              The handle created by a call to the create function.
+    * @param    sendQueueCallback               The callback receiving @c IOTHUB_CLIENT_SEND_QUEUE_HIGH_WATERMARK and
+    *                                           @c IOTHUB_CLIENT_SEND_QUEUE_LOW_WATERMARK. Pass @c NULL to stop it.
+    * @param    userContextCallback             User specified context that will be provided to the
+    *                                           callback. This can be @c NULL.
+    *
+    *           @b NOTE: The application behavior is undefined if the user calls
+    *           the IoTHubDeviceClient_Destroy function from within any callback.
+    *
+    * @remark   Lets a producer pause before SendEventAsync starts failing with @c IOTHUB_CLIENT_QUEUE_FULL or dropping messages.
+    *           The callback runs on the client worker thread. A send API of this client called from any callback does not
+    *           block with @c IOTHUB_CLIENT_SEND_QUEUE_FULL_BLOCK, it returns @c IOTHUB_CLIENT_QUEUE_FULL while the queue is full.
+    *
+    * @return   IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_SetSendQueueCallback, IOTHUB_DEVICE_CLIENT_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_SEND_QUEUE_CALLBACK, sendQueueCallback, void*, userContextCallback);
+
     /**
     * @brief    Sets up the connection status callback to be invoked representing the status of
     *           the connection to IOT Hub. This is a blocking call.
@@ -132,6 +132,29 @@ typedef struct IOTHUB_CLIENT_CORE_LL_HANDLE_DATA_TAG* IOTHUB_DEVICE_CLIENT_LL_HA
     */
      MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_LL_SendEventAsync, IOTHUB_DEVICE_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_MESSAGE_HANDLE, eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, eventConfirmationCallback, void*, userContextCallback);
 
+    /**
+    * @brief    Asynchronous call to send the message specified by @p eventMessageHandle, without copying it.
+    *
+    * @param    iotHubClientHandle              The handle created by a call to the create function.
+    * @param    eventMessageHandle              The handle to an IoT Hub message.
+    * @param    eventConfirmationCallback       The callback specified by the device for receiving
+    *                                           confirmation of the delivery of the IoT Hub message.
+    *                                           The user can specify a @c NULL value here to
+    *                                           indicate that no callback is required.
+    * @param    userContextCallback             User specified context that will be provided to the
+    *                                           callback. This can be @c NULL.
+    *
+    *           @b NOTE: The application behavior is undefined if the user calls
+    *           the IoTHubDeviceClient_LL_Destroy function from within any callback.
+    * @remarks
+    *           Unlike IoTHubDeviceClient_LL_SendEventAsync, the message is queued as is instead of being cloned.
+    *           On success the iothub client owns @c eventMessageHandle and destroys it when the message is effectively sent,
+    *           if a failure sending it occurs, or if the client is destroyed; the calling application must not use or destroy it afterwards.
+    *           On failure the calling application still owns @c eventMessageHandle.
+    * @return   IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_LL_SendEventAsyncTakeOwnership, IOTHUB_DEVICE_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_MESSAGE_HANDLE, eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, eventConfirmationCallback, void*, userContextCallback);
+
     /**
     * @brief    This function returns the current sending status for IoTHubClient.
     *
@@ -184,6 +207,25 @@ typedef struct IOTHUB_CLIENT_CORE_LL_HANDLE_DATA_TAG* IOTHUB_DEVICE_CLIENT_LL_HA
     */
      MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_LL_SetConnectionStatusCallback, IOTHUB_DEVICE_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK, connectionStatusCallback, void*, userContextCallback);
 
+    /**
+    * @brief    Sets up the callback invoked when the send queue reaches OPTION_SEND_QUEUE_MAX_MESSAGES or
+    *           OPTION_SEND_QUEUE_MAX_BYTES, and again when it has drained to half of them.
+    *
+    * @param    iotHubClientHandle              The handle created by a call to the create function.
+    * @param    sendQueueCallback               The callback receiving @c IOTHUB_CLIENT_SEND_QUEUE_HIGH_WATERMARK and
+    *                                           @c IOTHUB_CLIENT_SEND_QUEUE_LOW_WATERMARK. Pass @c NULL to stop it.
+    * @param    userContextCallback             User specified context that will be provided to the
+    *                                           callback. This can be @c NULL.
+    *
+    *           @b NOTE: The application behavior is undefined if the user calls
+    *           the IoTHubDeviceClient_LL_Destroy function from within any callback.
+    *
+    * @remark   Lets a producer pause before SendEventAsync starts failing with @c IOTHUB_CLIENT_QUEUE_FULL or dropping messages.
+    *
+    * @return   IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_LL_SetSendQueueCallback, IOTHUB_DEVICE_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_SEND_QUEUE_CALLBACK, sendQueueCallback, void*, userContextCallback);
+
     /**
     * @brief    Sets up the connection status callback to be invoked representing the status of
     * the connection to IOT Hub. This is a blocking call.
@@ -339,6 +381,17 @@ typedef struct IOTHUB_CLIENT_CORE_LL_HANDLE_DATA_TAG* IOTHUB_DEVICE_CLIENT_LL_HA
      */
      MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_LL_DeviceMethodResponse, IOTHUB_DEVICE_CLIENT_LL_HANDLE, iotHubClientHandle, METHOD_HANDLE, methodId, const unsigned char*, response, size_t, respSize, int, statusCode);
 
+     /**
+     * @brief    This API retrieves the telemetry statistics of the client: message counts, bytes sent, queue depths and, when
+     *           @c OPTION_TELEMETRY_STATISTICS is enabled, payload bytes and a send-to-confirmation latency histogram.
+     *
+     * @param    iotHubClientHandle      The handle created by a call to the create function.
+     * @param    statistics              Receives a snapshot of the statistics.
+     *
+     * @return   IOTHUB_CLIENT_OK upon success or an error code upon failure.
+     */
+     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_LL_GetStatistics, IOTHUB_DEVICE_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_STATISTICS*, statistics);
+
 #ifndef DONT_USE_UPLOADTOBLOB
     /**
     * @brief    This API uploads to Azure Storage the content pointed to by @p source having the size @p size
@@ -372,6 +425,25 @@ typedef struct IOTHUB_CLIENT_CORE_LL_HANDLE_DATA_TAG* IOTHUB_DEVICE_CLIENT_LL_HA
      */
      MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_LL_UploadMultipleBlocksToBlob, IOTHUB_DEVICE_CLIENT_LL_HANDLE, iotHubClientHandle, const char*, destinationFileName, IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX, getDataCallbackEx, void*, context);
 
+     /**
+     * @brief    This API uploads to Azure Storage the content of the file @p filePath under the blob name devicename/@pdestinationFileName.
+     *           The file is read one block at a time, it is not loaded in memory.
+     *
+     * @param    iotHubClientHandle      The handle created by a call to the create function.
+     * @param    destinationFileName     name of the file.
+     * @param    filePath                path of the file to upload.
+     * @param    checkpointPath          path of a file where the progress of the upload is kept, or NULL. If an upload of the same file to the same
+     *                                  destination failed, calling this API again with the same @p checkpointPath uploads only the blocks that
+     *                                  were not uploaded. The checkpoint file is deleted once the upload succeeds. The blocks are then uploaded
+     *                                  one at a time, regardless of OPTION_BLOB_UPLOAD_PARALLEL_BLOCKS.
+     *
+     * @warning  The file must not be modified between an upload and its resumption. IoTHubDeviceClient_LL_UploadFileToBlob
+     *           will block until the upload is completed or fails, which may take a while.
+     *
+     * @return   IOTHUB_CLIENT_OK upon success or an error code upon failure.
+     */
+     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_LL_UploadFileToBlob, IOTHUB_DEVICE_CLIENT_LL_HANDLE, iotHubClientHandle, const char*, destinationFileName, const char*, filePath, const char*, checkpointPath);
+
 #endif /*DONT_USE_UPLOADTOBLOB*/
 
 #ifdef __cplusplus
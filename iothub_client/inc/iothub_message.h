@@ -44,6 +44,10 @@ MU_DEFINE_ENUM_WITHOUT_INVALID(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_CONTENT
 
 typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG* IOTHUB_MESSAGE_HANDLE;
 
+/** @brief Callback invoked when a message created with IoTHubMessage_CreateFromByteArrayNoCopy no longer references its payload.
+*/
+typedef void(*IOTHUB_MESSAGE_PAYLOAD_RELEASE_CALLBACK)(const unsigned char* byteArray, size_t size, void* context);
+
 /** @brief diagnostic related data*/
 typedef struct IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA_TAG
 {
@@ -77,6 +81,29 @@ MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_HANDLE, IoTHubMessage_CreateFromByteArray, co
 */
 MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_HANDLE, IoTHubMessage_CreateFromString, const char*, source);
 
+/**
+* @brief   Creates a new IoT hub message that refers to a caller owned byte array
+*          instead of copying it. The type of the message will be set to
+*          @c IOTHUBMESSAGE_BYTEARRAY.
+*
+* @param   byteArray       The byte array holding the message payload.
+* @param   size            The size of the byte array.
+* @param   releaseCallback Optional callback invoked once the payload is no
+*                          longer referenced, that is when this message and
+*                          every clone of it (including the ones queued by
+*                          the client for sending) have been destroyed.
+* @param   releaseContext  User context passed to @p releaseCallback.
+*
+* @remarks The byte array must stay valid and unchanged until @p releaseCallback
+*          is invoked, or until all the messages sharing it are destroyed if no
+*          callback is given. The callback may run on the client's worker thread.
+*          If the message cannot be created the callback is not invoked.
+*
+* @return  A valid @c IOTHUB_MESSAGE_HANDLE if the message was successfully
+*          created or @c NULL in case an error occurs.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_HANDLE, IoTHubMessage_CreateFromByteArrayNoCopy, const unsigned char*, byteArray, size_t, size, IOTHUB_MESSAGE_PAYLOAD_RELEASE_CALLBACK, releaseCallback, void*, releaseContext);
+
 /**
 * @brief   Creates a new IoT hub message with the content identical to that
 *          of the @p iotHubMessageHandle parameter.
@@ -99,6 +99,29 @@ extern "C"
     */
      MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubModuleClient_LL_SendEventAsync, IOTHUB_MODULE_CLIENT_LL_HANDLE, iotHubModuleClientHandle, IOTHUB_MESSAGE_HANDLE, eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, eventConfirmationCallback, void*, userContextCallback);
 
+    /**
+    * @brief    Asynchronous call to send the message specified by @p eventMessageHandle, without copying it.
+    *
+    * @param    iotHubModuleClientHandle         The handle created by a call to the create function.
+    * @param    eventMessageHandle               The handle to an IoT Hub message.
+    * @param    eventConfirmationCallback        The callback specified by the module for receiving
+    *                                            confirmation of the delivery of the IoT Hub message.
+    *                                            The user can specify a @c NULL value here to
+    *                                            indicate that no callback is required.
+    * @param    userContextCallback              User specified context that will be provided to the
+    *                                            callback. This can be @c NULL.
+    *
+    *            @b NOTE: The application behavior is undefined if the user calls
+    *            the IoTHubModuleClient_LL_Destroy function from within any callback.
+    * @remarks
+    *            Unlike IoTHubModuleClient_LL_SendEventAsync, the message is queued as is instead of being cloned.
+    *            On success the iothub client owns @c eventMessageHandle and destroys it when the message is effectively sent,
+    *            if a failure sending it occurs, or if the client is destroyed; the calling application must not use or destroy it afterwards.
+    *            On failure the calling application still owns @c eventMessageHandle.
+    * @return    IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubModuleClient_LL_SendEventAsyncTakeOwnership, IOTHUB_MODULE_CLIENT_LL_HANDLE, iotHubModuleClientHandle, IOTHUB_MESSAGE_HANDLE, eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, eventConfirmationCallback, void*, userContextCallback);
+
     /**
     * @brief    This function returns the current sending status for IoTHubModuleClient.
     *
@@ -113,6 +136,17 @@ extern "C"
     */
      MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubModuleClient_LL_GetSendStatus, IOTHUB_MODULE_CLIENT_LL_HANDLE, iotHubModuleClientHandle, IOTHUB_CLIENT_STATUS*, iotHubClientStatus);
 
+    /**
+    * @brief    This API retrieves the telemetry statistics of the module client: message counts, bytes sent, queue depths and, when
+    *           @c OPTION_TELEMETRY_STATISTICS is enabled, payload bytes and a send-to-confirmation latency histogram.
+    *
+    * @param    iotHubModuleClientHandle  The handle created by a call to the create function.
+    * @param    statistics                Receives a snapshot of the statistics.
+    *
+    * @return    IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubModuleClient_LL_GetStatistics, IOTHUB_MODULE_CLIENT_LL_HANDLE, iotHubModuleClientHandle, IOTHUB_CLIENT_STATISTICS*, statistics);
+
     /**
     * @brief    Sets up the message callback to be invoked when Edge issues a
     *             message to the module. This is a blocking call.
@@ -147,6 +181,25 @@ extern "C"
     */
      MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubModuleClient_LL_SetConnectionStatusCallback, IOTHUB_MODULE_CLIENT_LL_HANDLE, iotHubModuleClientHandle, IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK, connectionStatusCallback, void*, userContextCallback);
 
+    /**
+    * @brief    Sets up the callback invoked when the send queue reaches OPTION_SEND_QUEUE_MAX_MESSAGES or
+    *           OPTION_SEND_QUEUE_MAX_BYTES, and again when it has drained to half of them.
+    *
+    * @param    iotHubModuleClientHandle        The handle created by a call to the create function.
+    * @param    sendQueueCallback               The callback receiving @c IOTHUB_CLIENT_SEND_QUEUE_HIGH_WATERMARK and
+    *                                           @c IOTHUB_CLIENT_SEND_QUEUE_LOW_WATERMARK. Pass @c NULL to stop it.
+    * @param    userContextCallback             User specified context that will be provided to the
+    *                                           callback. This can be @c NULL.
+    *
+    *           @b NOTE: The application behavior is undefined if the user calls
+    *           the IoTHubModuleClient_LL_Destroy function from within any callback.
+    *
+    * @remark   Lets a producer pause before SendEventAsync starts failing with @c IOTHUB_CLIENT_QUEUE_FULL or dropping messages.
+    *
+    * @return   IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubModuleClient_LL_SetSendQueueCallback, IOTHUB_MODULE_CLIENT_LL_HANDLE, iotHubModuleClientHandle, IOTHUB_CLIENT_SEND_QUEUE_CALLBACK, sendQueueCallback, void*, userContextCallback);
+
     /**
     * @brief    Sets up the connection status callback to be invoked representing the status of
     * the connection to IOT Hub. This is a blocking call.
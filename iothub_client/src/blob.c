@@ -12,11 +12,163 @@
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/azure_base64.h"
 #include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/lock.h"
 
 static const char blockListXmlBegin[]  = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n<BlockList>";
 static const char blockListXmlEnd[] = "</BlockList>";
 static const char blockListUriMarker[] = "&comp=blocklist";
 
+/*when blocks are uploaded in parallel, a Put Block that fails with a transient error is attempted up to BLOB_BLOCK_MAX_ATTEMPTS times*/
+#define BLOB_BLOCK_MAX_ATTEMPTS 3
+/*delay before the second attempt of a Put Block, doubled for every further attempt*/
+#define BLOB_BLOCK_RETRY_DELAY_MS 1000
+
+typedef struct BLOB_PARALLEL_UPLOAD_TAG
+{
+    LOCK_HANDLE lock; /*serializes the calls to getDataCallbackEx and guards the fields below*/
+    const char* relativePath;
+    IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX getDataCallbackEx;
+    void* context;
+    unsigned int blockCount; /*number of blocks handed to the workers so far, also the ID of the next block*/
+    int isDone; /*set when getDataCallbackEx has no more blocks, aborts, or when the upload failed*/
+    BLOB_RESULT result;
+    int hasHttpStatus;
+    unsigned int httpStatus; /*status of the last Put Block, or of the Put Block that failed*/
+    BUFFER_HANDLE httpResponse; /*receives the response of the Put Block that failed*/
+} BLOB_PARALLEL_UPLOAD;
+
+typedef struct BLOB_UPLOAD_WORKER_TAG
+{
+    BLOB_PARALLEL_UPLOAD* upload;
+    HTTPAPIEX_HANDLE httpApiExHandle;
+    BUFFER_HANDLE blockContent; /*reused for every block the worker uploads*/
+    BUFFER_HANDLE httpResponse;
+    THREAD_HANDLE threadHandle;
+    int isThreadRunning;
+    BLOB_RESULT result; /*BLOB_ERROR if the worker could not report the outcome of its last block*/
+} BLOB_UPLOAD_WORKER;
+
+/*produces the BASE64 encoding of the block ID (000000... 049999)*/
+static STRING_HANDLE CreateBlockIdString(unsigned int blockID)
+{
+    STRING_HANDLE result;
+    char temp[7]; /*this will contain 000000... 049999*/
+    if (sprintf(temp, "%6u", (unsigned int)blockID) != 6) /*produces 000000... 049999*/
+    {
+        /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
+        LogError("failed to sprintf");
+        result = NULL;
+    }
+    else if ((result = Azure_Base64_Encode_Bytes((const unsigned char*)temp, 6)) == NULL)
+    {
+        /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
+        LogError("unable to Azure_Base64_Encode_Bytes");
+    }
+    return result;
+}
+
+static int AppendBlockIdToList(STRING_HANDLE blockIDList, STRING_HANDLE blockIdString)
+{
+    int result;
+    /*add the blockId base64 encoded to the XML*/
+    if (!(
+        (STRING_concat(blockIDList, "<Latest>") == 0) &&
+        (STRING_concat_with_STRING(blockIDList, blockIdString) == 0) &&
+        (STRING_concat(blockIDList, "</Latest>") == 0)
+        ))
+    {
+        /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
+        LogError("unable to STRING_concat");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+/*adds the IDs of blocks firstBlockID to blockCount-1 to the XML, in block order*/
+static int AppendBlockIdsToList(STRING_HANDLE blockIDList, unsigned int firstBlockID, unsigned int blockCount)
+{
+    int result = 0;
+    unsigned int blockID;
+    for (blockID = firstBlockID; (result == 0) && (blockID < blockCount); blockID++)
+    {
+        STRING_HANDLE blockIdString = CreateBlockIdString(blockID);
+        if (blockIdString == NULL)
+        {
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = AppendBlockIdToList(blockIDList, blockIdString);
+            STRING_delete(blockIdString);
+        }
+    }
+    return result;
+}
+
+/*executes the Put Block request of one block, whose ID has already been encoded*/
+static BLOB_RESULT PutBlock(HTTPAPIEX_HANDLE httpApiExHandle, const char* relativePath, BUFFER_HANDLE requestContent, STRING_HANDLE blockIdString, unsigned int* httpStatus, BUFFER_HANDLE httpResponse)
+{
+    BLOB_RESULT result;
+
+    /*Codes_SRS_BLOB_02_022: [ Blob_UploadMultipleBlocksFromSasUri shall construct a new relativePath from following string: base relativePath + "&comp=block&blockid=BASE64 encoded string of blockId" ]*/
+    STRING_HANDLE newRelativePath = STRING_construct(relativePath);
+    if (newRelativePath == NULL)
+    {
+        /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
+        LogError("unable to STRING_construct");
+        result = BLOB_ERROR;
+    }
+    else
+    {
+        if (!(
+            (STRING_concat(newRelativePath, "&comp=block&blockid=") == 0) &&
+            (STRING_concat_with_STRING(newRelativePath, blockIdString) == 0)
+            ))
+        {
+            /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
+            LogError("unable to STRING concatenate");
+            result = BLOB_ERROR;
+        }
+        else
+        {
+            /*Codes_SRS_BLOB_02_024: [ Blob_UploadMultipleBlocksFromSasUri shall call HTTPAPIEX_ExecuteRequest with a PUT operation, passing httpStatus and httpResponse. ]*/
+            if (HTTPAPIEX_ExecuteRequest(
+                httpApiExHandle,
+                HTTPAPI_REQUEST_PUT,
+                STRING_c_str(newRelativePath),
+                NULL,
+                requestContent,
+                httpStatus,
+                NULL,
+                httpResponse) != HTTPAPIEX_OK
+                )
+            {
+                /*Codes_SRS_BLOB_02_025: [ If HTTPAPIEX_ExecuteRequest fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_HTTP_ERROR. ]*/
+                LogError("unable to HTTPAPIEX_ExecuteRequest");
+                result = BLOB_HTTP_ERROR;
+            }
+            else if (*httpStatus >= 300)
+            {
+                /*Codes_SRS_BLOB_02_026: [ Otherwise, if HTTP response code is >=300 then Blob_UploadMultipleBlocksFromSasUri shall succeed and return BLOB_OK. ]*/
+                LogError("HTTP status from storage does not indicate success (%d)", (int)*httpStatus);
+                result = BLOB_OK;
+            }
+            else
+            {
+                /*Codes_SRS_BLOB_02_027: [ Otherwise Blob_UploadMultipleBlocksFromSasUri shall continue execution. ]*/
+                result = BLOB_OK;
+            }
+        }
+        STRING_delete(newRelativePath);
+    }
+    return result;
+}
+
 BLOB_RESULT Blob_UploadBlock(
         HTTPAPIEX_HANDLE httpApiExHandle,
         const char* relativePath,
@@ -45,91 +197,22 @@ BLOB_RESULT Blob_UploadBlock(
     }
     else
     {
-        char temp[7]; /*this will contain 000000... 049999*/
-        if (sprintf(temp, "%6u", (unsigned int)blockID) != 6) /*produces 000000... 049999*/
+        STRING_HANDLE blockIdString = CreateBlockIdString(blockID);
+        if (blockIdString == NULL)
         {
-            /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
-            LogError("failed to sprintf");
             result = BLOB_ERROR;
         }
         else
         {
-            STRING_HANDLE blockIdString = Azure_Base64_Encode_Bytes((const unsigned char*)temp, 6);
-            if (blockIdString == NULL)
+            if (AppendBlockIdToList(blockIDList, blockIdString) != 0)
             {
-                /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
-                LogError("unable to Azure_Base64_Encode_Bytes");
                 result = BLOB_ERROR;
             }
             else
             {
-                /*add the blockId base64 encoded to the XML*/
-                if (!(
-                    (STRING_concat(blockIDList, "<Latest>") == 0) &&
-                    (STRING_concat_with_STRING(blockIDList, blockIdString) == 0) &&
-                    (STRING_concat(blockIDList, "</Latest>") == 0)
-                    ))
-                {
-                    /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
-                    LogError("unable to STRING_concat");
-                    result = BLOB_ERROR;
-                }
-                else
-                {
-                    /*Codes_SRS_BLOB_02_022: [ Blob_UploadMultipleBlocksFromSasUri shall construct a new relativePath from following string: base relativePath + "&comp=block&blockid=BASE64 encoded string of blockId" ]*/
-                    STRING_HANDLE newRelativePath = STRING_construct(relativePath);
-                    if (newRelativePath == NULL)
-                    {
-                        /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
-                        LogError("unable to STRING_construct");
-                        result = BLOB_ERROR;
-                    }
-                    else
-                    {
-                        if (!(
-                            (STRING_concat(newRelativePath, "&comp=block&blockid=") == 0) &&
-                            (STRING_concat_with_STRING(newRelativePath, blockIdString) == 0)
-                            ))
-                        {
-                            /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
-                            LogError("unable to STRING concatenate");
-                            result = BLOB_ERROR;
-                        }
-                        else
-                        {
-                            /*Codes_SRS_BLOB_02_024: [ Blob_UploadMultipleBlocksFromSasUri shall call HTTPAPIEX_ExecuteRequest with a PUT operation, passing httpStatus and httpResponse. ]*/
-                            if (HTTPAPIEX_ExecuteRequest(
-                                httpApiExHandle,
-                                HTTPAPI_REQUEST_PUT,
-                                STRING_c_str(newRelativePath),
-                                NULL,
-                                requestContent,
-                                httpStatus,
-                                NULL,
-                                httpResponse) != HTTPAPIEX_OK
-                                )
-                            {
-                                /*Codes_SRS_BLOB_02_025: [ If HTTPAPIEX_ExecuteRequest fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_HTTP_ERROR. ]*/
-                                LogError("unable to HTTPAPIEX_ExecuteRequest");
-                                result = BLOB_HTTP_ERROR;
-                            }
-                            else if (*httpStatus >= 300)
-                            {
-                                /*Codes_SRS_BLOB_02_026: [ Otherwise, if HTTP response code is >=300 then Blob_UploadMultipleBlocksFromSasUri shall succeed and return BLOB_OK. ]*/
-                                LogError("HTTP status from storage does not indicate success (%d)", (int)*httpStatus);
-                                result = BLOB_OK;
-                            }
-                            else
-                            {
-                                /*Codes_SRS_BLOB_02_027: [ Otherwise Blob_UploadMultipleBlocksFromSasUri shall continue execution. ]*/
-                                result = BLOB_OK;
-                            }
-                        }
-                        STRING_delete(newRelativePath);
-                    }
-                }
-                STRING_delete(blockIdString);
+                result = PutBlock(httpApiExHandle, relativePath, requestContent, blockIdString, httpStatus, httpResponse);
             }
+            STRING_delete(blockIdString);
         }
     }
     return result;
@@ -138,18 +221,20 @@ BLOB_RESULT Blob_UploadBlock(
 
 // InvokeUserCallbackAndSendBlobs invokes the application's getDataCallbackEx as many time as callback requests and, for each call,
 // sends the blob contents to the server.
-static BLOB_RESULT InvokeUserCallbackAndSendBlobs(HTTPAPIEX_HANDLE httpApiExHandle, const char* relativePath, STRING_HANDLE blockIDList, IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX getDataCallbackEx, void* context, unsigned int* httpStatus, BUFFER_HANDLE httpResponse)
+static BLOB_RESULT InvokeUserCallbackAndSendBlobs(HTTPAPIEX_HANDLE httpApiExHandle, const char* relativePath, STRING_HANDLE blockIDList, IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX getDataCallbackEx, void* context, unsigned int* httpStatus, BUFFER_HANDLE httpResponse, unsigned int uploadedBlockCount)
 {
     BLOB_RESULT result;
 
     /*Codes_SRS_BLOB_02_021: [ For every block returned by `getDataCallbackEx` the following operations shall happen: ]*/
-    unsigned int blockID = 0; /* incremented for each new block */
+    unsigned int blockID = uploadedBlockCount; /* incremented for each new block */
     unsigned int isError = 0; /* set to 1 if a block upload fails or if getDataCallbackEx returns incorrect blocks to upload */
     unsigned int uploadOneMoreBlock = 1; /* set to 1 while getDataCallbackEx returns correct blocks to upload */
     unsigned char const * source = NULL; /* data set by getDataCallbackEx */
     size_t size = 0; /* source size set by getDataCallbackEx */
     IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_RESULT getDataReturnValue;
 
+    *httpStatus = 0; /*left as is when there are no blocks left to upload, for instance when resuming after the last block*/
+
     do
     {
         getDataReturnValue = getDataCallbackEx(FILE_UPLOAD_OK, &source, &size, context);
@@ -227,6 +312,376 @@ static BLOB_RESULT InvokeUserCallbackAndSendBlobs(HTTPAPIEX_HANDLE httpApiExHand
     return result;
 }
 
+static int IsTransientBlockFailure(BLOB_RESULT result, unsigned int httpStatus)
+{
+    /*408 Request Timeout, 429 Too Many Requests and 5xx are worth another attempt, other 4xx are not*/
+    return (result == BLOB_HTTP_ERROR) ||
+        ((result == BLOB_OK) && ((httpStatus == 408) || (httpStatus == 429) || (httpStatus >= 500)));
+}
+
+static BLOB_RESULT PutBlockWithRetries(BLOB_UPLOAD_WORKER* worker, unsigned int blockID, unsigned int* httpStatus)
+{
+    BLOB_RESULT result;
+    STRING_HANDLE blockIdString = CreateBlockIdString(blockID);
+    if (blockIdString == NULL)
+    {
+        result = BLOB_ERROR;
+    }
+    else
+    {
+        unsigned int attempt = 1;
+        unsigned int retryDelay = BLOB_BLOCK_RETRY_DELAY_MS;
+
+        /*Codes_SRS_BLOB_31_005: [ A Put Block that fails with BLOB_HTTP_ERROR or with HTTP status 408, 429 or 5xx shall be attempted again, up to 3 attempts in total. ]*/
+        while (((result = PutBlock(worker->httpApiExHandle, worker->upload->relativePath, worker->blockContent, blockIdString, httpStatus, worker->httpResponse)) != BLOB_OK || *httpStatus >= 300) &&
+            (attempt < BLOB_BLOCK_MAX_ATTEMPTS) &&
+            IsTransientBlockFailure(result, *httpStatus))
+        {
+            LogInfo("Put Block of block %u failed, attempting it again in %u ms", blockID, retryDelay);
+            ThreadAPI_Sleep(retryDelay);
+            retryDelay *= 2;
+            attempt++;
+        }
+        STRING_delete(blockIdString);
+    }
+    return result;
+}
+
+/*asks getDataCallbackEx for the next block and copies it into the worker's buffer. Called with upload->lock held.
+Returns 1 when the worker has a block to upload, 0 when the upload is over*/
+static int TakeNextBlock(BLOB_PARALLEL_UPLOAD* upload, BLOB_UPLOAD_WORKER* worker, unsigned int* blockID)
+{
+    int result = 0;
+    unsigned char const * source = NULL;
+    size_t size = 0;
+
+    if (upload->getDataCallbackEx(FILE_UPLOAD_OK, &source, &size, upload->context) == IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_ABORT)
+    {
+        /*Codes_SRS_BLOB_99_004: [ If `getDataCallbackEx` returns `IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_RESULT_ABORT`, then `Blob_UploadMultipleBlocksFromSasUri` shall exit the loop and return `BLOB_ABORTED`. ]*/
+        LogInfo("Upload to blob has been aborted by the user");
+        upload->result = BLOB_ABORTED;
+        upload->isDone = 1;
+    }
+    else if (source == NULL || size == 0)
+    {
+        /*Codes_SRS_BLOB_99_002: [ If the size of the block returned by `getDataCallbackEx` is 0 or if the data is NULL, then `Blob_UploadMultipleBlocksFromSasUri` shall exit the loop. ]*/
+        upload->isDone = 1;
+    }
+    else if (size > BLOCK_SIZE)
+    {
+        /*Codes_SRS_BLOB_99_001: [ If the size of the block returned by `getDataCallbackEx` is bigger than 4MB, then `Blob_UploadMultipleBlocksFromSasUri` shall fail and return `BLOB_INVALID_ARG`. ]*/
+        LogError("tried to upload block of size %lu, max allowed size is %d", (unsigned long)size, BLOCK_SIZE);
+        upload->result = BLOB_INVALID_ARG;
+        upload->isDone = 1;
+    }
+    else if (upload->blockCount >= MAX_BLOCK_COUNT)
+    {
+        /*Codes_SRS_BLOB_99_003: [ If `getDataCallbackEx` returns more than 50000 blocks, then `Blob_UploadMultipleBlocksFromSasUri` shall fail and return `BLOB_INVALID_ARG`. ]*/
+        LogError("unable to upload more than %lu blocks in one blob", (unsigned long)MAX_BLOCK_COUNT);
+        upload->result = BLOB_INVALID_ARG;
+        upload->isDone = 1;
+    }
+    /*Codes_SRS_BLOB_31_003: [ Each worker shall copy the blocks it uploads into a BUFFER_HANDLE of its own that is reused from block to block. ]*/
+    else if (BUFFER_build(worker->blockContent, source, size) != 0)
+    {
+        /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
+        LogError("unable to BUFFER_build");
+        upload->result = BLOB_ERROR;
+        upload->isDone = 1;
+    }
+    else
+    {
+        *blockID = upload->blockCount++;
+        result = 1;
+    }
+    return result;
+}
+
+/*records the outcome of a Put Block. Called with upload->lock held*/
+static void RecordBlockResult(BLOB_PARALLEL_UPLOAD* upload, BLOB_UPLOAD_WORKER* worker, BLOB_RESULT blockResult, unsigned int httpStatus)
+{
+    /*only the first failure is reported*/
+    if (upload->result == BLOB_OK && !(upload->hasHttpStatus && upload->httpStatus >= 300))
+    {
+        if (blockResult != BLOB_OK)
+        {
+            LogError("unable to upload a block. Returned value=%d", blockResult);
+            upload->result = blockResult;
+            upload->isDone = 1;
+        }
+        else
+        {
+            upload->hasHttpStatus = 1;
+            upload->httpStatus = httpStatus;
+            if (httpStatus >= 300)
+            {
+                const unsigned char* response = BUFFER_u_char(worker->httpResponse);
+                size_t responseLength = BUFFER_length(worker->httpResponse);
+
+                LogError("unable to upload a block. Returned httpStatus=%u", httpStatus);
+                upload->isDone = 1;
+                if (BUFFER_build(upload->httpResponse, response, responseLength) != 0)
+                {
+                    LogError("unable to copy the HTTP response of the failed block");
+                }
+            }
+        }
+    }
+}
+
+/*a worker takes blocks from getDataCallbackEx and uploads them on its own connection until there are no more blocks or the upload failed*/
+static int UploadBlocksWorker(void* arg)
+{
+    BLOB_UPLOAD_WORKER* worker = (BLOB_UPLOAD_WORKER*)arg;
+    BLOB_PARALLEL_UPLOAD* upload = worker->upload;
+    int hasBlock = 1;
+    int hasUploadedBlock = 0;
+    BLOB_RESULT blockResult = BLOB_OK;
+    unsigned int httpStatus = 0;
+    unsigned int blockID = 0;
+
+    while (hasBlock)
+    {
+        if (Lock(upload->lock) != LOCK_OK)
+        {
+            LogError("unable to Lock");
+            worker->result = BLOB_ERROR;
+            hasBlock = 0;
+        }
+        else
+        {
+            if (hasUploadedBlock)
+            {
+                RecordBlockResult(upload, worker, blockResult, httpStatus);
+            }
+
+            hasBlock = upload->isDone ? 0 : TakeNextBlock(upload, worker, &blockID);
+            (void)Unlock(upload->lock);
+
+            if (hasBlock)
+            {
+                blockResult = PutBlockWithRetries(worker, blockID, &httpStatus);
+                hasUploadedBlock = 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int SetConnectionOptions(HTTPAPIEX_HANDLE httpApiExHandle, const char* certificates, HTTP_PROXY_OPTIONS *proxyOptions, const char* networkInterface)
+{
+    int result;
+    if ((certificates != NULL) && (HTTPAPIEX_SetOption(httpApiExHandle, "TrustedCerts", certificates) == HTTPAPIEX_ERROR))
+    {
+        LogError("failure in setting trusted certificates");
+        result = MU_FAILURE;
+    }
+    else if ((proxyOptions != NULL && proxyOptions->host_address != NULL) && HTTPAPIEX_SetOption(httpApiExHandle, OPTION_HTTP_PROXY, proxyOptions) == HTTPAPIEX_ERROR)
+    {
+        LogError("failure in setting proxy options");
+        result = MU_FAILURE;
+    }
+    else if ((networkInterface != NULL) && HTTPAPIEX_SetOption(httpApiExHandle, OPTION_CURL_INTERFACE, networkInterface) == HTTPAPIEX_ERROR)
+    {
+        LogError("failure in setting network interface");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+static void DestroyWorkers(BLOB_UPLOAD_WORKER* workers, size_t workerCount)
+{
+    size_t i;
+    for (i = 0; i < workerCount; i++)
+    {
+        /*workers[0] uses the connection of the caller*/
+        if (i > 0)
+        {
+            HTTPAPIEX_Destroy(workers[i].httpApiExHandle);
+        }
+        BUFFER_delete(workers[i].blockContent);
+        BUFFER_delete(workers[i].httpResponse);
+    }
+    free(workers);
+}
+
+static HTTPAPIEX_HANDLE CreateWorkerConnection(const char* hostname, const char* certificates, HTTP_PROXY_OPTIONS *proxyOptions, const char* networkInterface)
+{
+    HTTPAPIEX_HANDLE result;
+    /*Codes_SRS_BLOB_31_002: [ Every worker other than the first shall open a connection of its own with HTTPAPIEX_Create, with the same options as the first connection. ]*/
+    if ((result = HTTPAPIEX_Create(hostname)) == NULL)
+    {
+        LogError("unable to create a HTTPAPIEX_HANDLE");
+    }
+    else if (SetConnectionOptions(result, certificates, proxyOptions, networkInterface) != 0)
+    {
+        HTTPAPIEX_Destroy(result);
+        result = NULL;
+    }
+    return result;
+}
+
+/*prepares the workers. workers[0] uploads on httpApiExHandle, the others open a connection each. A worker other than workers[0] that cannot
+be prepared is left out and the blocks are shared among fewer workers. Returns the number of workers prepared, 0 on failure*/
+static size_t CreateWorkers(BLOB_PARALLEL_UPLOAD* upload, HTTPAPIEX_HANDLE httpApiExHandle, const char* hostname, const char* certificates, HTTP_PROXY_OPTIONS *proxyOptions, const char* networkInterface, size_t parallelBlocks, BLOB_UPLOAD_WORKER** workers)
+{
+    size_t result = 0;
+
+    if ((*workers = (BLOB_UPLOAD_WORKER*)malloc(parallelBlocks * sizeof(BLOB_UPLOAD_WORKER))) == NULL)
+    {
+        LogError("oom - out of memory");
+    }
+    else
+    {
+        size_t i;
+        (void)memset(*workers, 0, parallelBlocks * sizeof(BLOB_UPLOAD_WORKER));
+
+        for (i = 0; i < parallelBlocks; i++)
+        {
+            BLOB_UPLOAD_WORKER* worker = &(*workers)[result];
+            worker->upload = upload;
+            worker->result = BLOB_OK;
+            worker->httpApiExHandle = (i == 0) ? httpApiExHandle : CreateWorkerConnection(hostname, certificates, proxyOptions, networkInterface);
+
+            if (worker->httpApiExHandle == NULL)
+            {
+                LogError("unable to create the connection of upload worker %lu, the other workers upload its blocks", (unsigned long)i);
+            }
+            else if ((worker->blockContent = BUFFER_new()) == NULL ||
+                (worker->httpResponse = BUFFER_new()) == NULL)
+            {
+                LogError("unable to create the buffers of upload worker %lu", (unsigned long)i);
+                if (i > 0)
+                {
+                    HTTPAPIEX_Destroy(worker->httpApiExHandle);
+                }
+                BUFFER_delete(worker->blockContent);
+                (void)memset(worker, 0, sizeof(BLOB_UPLOAD_WORKER));
+
+                if (i == 0)
+                {
+                    break;
+                }
+            }
+            else
+            {
+                result++;
+            }
+        }
+
+        if (result == 0)
+        {
+            free(*workers);
+            *workers = NULL;
+        }
+    }
+    return result;
+}
+
+/*uploads the blocks returned by getDataCallbackEx over up to parallelBlocks connections at once. workers[0] runs on the calling thread,
+the others on threads that are joined before returning. Once all blocks are uploaded, their IDs are added to blockIDList in block order*/
+static BLOB_RESULT UploadBlocksInParallel(HTTPAPIEX_HANDLE httpApiExHandle, const char* hostname, const char* relativePath, STRING_HANDLE blockIDList, IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX getDataCallbackEx, void* context, unsigned int* httpStatus, BUFFER_HANDLE httpResponse, const char* certificates, HTTP_PROXY_OPTIONS *proxyOptions, const char* networkInterface, size_t parallelBlocks, unsigned int uploadedBlockCount)
+{
+    BLOB_RESULT result;
+    BLOB_PARALLEL_UPLOAD upload;
+    BLOB_UPLOAD_WORKER* workers;
+    size_t workerCount;
+
+    (void)memset(&upload, 0, sizeof(BLOB_PARALLEL_UPLOAD));
+    upload.relativePath = relativePath;
+    upload.getDataCallbackEx = getDataCallbackEx;
+    upload.context = context;
+    upload.blockCount = uploadedBlockCount;
+    upload.result = BLOB_OK;
+    upload.httpResponse = httpResponse;
+
+    if ((upload.lock = Lock_Init()) == NULL)
+    {
+        /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
+        LogError("unable to Lock_Init");
+        result = BLOB_ERROR;
+    }
+    else
+    {
+        /*Codes_SRS_BLOB_31_001: [ If `parallelBlocks` is greater than 1, `Blob_UploadMultipleBlocksFromSasUri` shall upload up to `parallelBlocks` blocks at the same time, each on its own connection. ]*/
+        if ((workerCount = CreateWorkers(&upload, httpApiExHandle, hostname, certificates, proxyOptions, networkInterface, parallelBlocks, &workers)) == 0)
+        {
+            /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
+            LogError("unable to create the upload workers");
+            result = BLOB_ERROR;
+        }
+        else
+        {
+            size_t i;
+
+            for (i = 1; i < workerCount; i++)
+            {
+                if (ThreadAPI_Create(&workers[i].threadHandle, UploadBlocksWorker, &workers[i]) != THREADAPI_OK)
+                {
+                    LogError("unable to create upload worker thread %lu, the other workers upload its blocks", (unsigned long)i);
+                }
+                else
+                {
+                    workers[i].isThreadRunning = 1;
+                }
+            }
+
+            (void)UploadBlocksWorker(&workers[0]);
+
+            result = BLOB_OK;
+            for (i = 0; i < workerCount; i++)
+            {
+                if (workers[i].isThreadRunning)
+                {
+                    int threadResult;
+                    if (ThreadAPI_Join(workers[i].threadHandle, &threadResult) != THREADAPI_OK)
+                    {
+                        LogError("unable to join upload worker thread %lu", (unsigned long)i);
+                        result = BLOB_ERROR;
+                    }
+                }
+
+                if (workers[i].result != BLOB_OK)
+                {
+                    result = workers[i].result;
+                }
+            }
+
+            if (result != BLOB_OK)
+            {
+                /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
+                LogError("an upload worker failed");
+            }
+            /*Codes_SRS_BLOB_31_006: [ If a block fails, no more blocks shall be requested from `getDataCallbackEx` and `Blob_UploadMultipleBlocksFromSasUri` shall report the first failure the same way as when the blocks are uploaded one at a time. ]*/
+            else if ((result = upload.result) != BLOB_OK)
+            {
+                LogError("Failed in invoking callback/sending blob step");
+            }
+            else
+            {
+                *httpStatus = upload.hasHttpStatus ? upload.httpStatus : 0;
+
+                if (!upload.hasHttpStatus || upload.httpStatus < 300)
+                {
+                    /*Codes_SRS_BLOB_31_004: [ The block IDs shall be added to the block list in the order of the blocks, whatever the order in which their uploads complete. ]*/
+                    if (AppendBlockIdsToList(blockIDList, uploadedBlockCount, upload.blockCount) != 0)
+                    {
+                        result = BLOB_ERROR;
+                    }
+                }
+            }
+
+            DestroyWorkers(workers, workerCount);
+        }
+        Lock_Deinit(upload.lock);
+    }
+    return result;
+}
+
 // SendBlockIdList to send an XML of uploaded blockIds to the server after the application's payload block(s) have been transfered.
 static BLOB_RESULT SendBlockIdList(HTTPAPIEX_HANDLE httpApiExHandle, const char* relativePath, STRING_HANDLE blockIDList, unsigned int* httpStatus, BUFFER_HANDLE httpResponse)
 {
@@ -301,7 +756,7 @@ static BLOB_RESULT SendBlockIdList(HTTPAPIEX_HANDLE httpApiExHandle, const char*
 }
 
 
-BLOB_RESULT Blob_UploadMultipleBlocksFromSasUri(const char* SASURI, IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX getDataCallbackEx, void* context, unsigned int* httpStatus, BUFFER_HANDLE httpResponse, const char* certificates, HTTP_PROXY_OPTIONS *proxyOptions, const char* networkInterface)
+BLOB_RESULT Blob_UploadMultipleBlocksFromSasUri(const char* SASURI, IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX getDataCallbackEx, void* context, unsigned int* httpStatus, BUFFER_HANDLE httpResponse, const char* certificates, HTTP_PROXY_OPTIONS *proxyOptions, const char* networkInterface, size_t parallelBlocks, unsigned int uploadedBlockCount)
 {
     BLOB_RESULT result;
     const char* hostnameBegin;
@@ -316,6 +771,12 @@ BLOB_RESULT Blob_UploadMultipleBlocksFromSasUri(const char* SASURI, IOTHUB_CLIEN
         LogError("One or more required values is NULL, SASURI=%p, getDataCallbackEx=%p", SASURI, getDataCallbackEx);
         result = BLOB_INVALID_ARG;
     }
+    /*Codes_SRS_BLOB_31_007: [ If `uploadedBlockCount` is bigger than 50000 then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+    else if (uploadedBlockCount > MAX_BLOCK_COUNT)
+    {
+        LogError("uploadedBlockCount=%u is more than the %lu blocks of a blob", uploadedBlockCount, (unsigned long)MAX_BLOCK_COUNT);
+        result = BLOB_INVALID_ARG;
+    }
     /*Codes_SRS_BLOB_02_017: [ Blob_UploadMultipleBlocksFromSasUri shall copy from SASURI the hostname to a new const char* ]*/
     /*to find the hostname, the following logic is applied:*/
     /*the hostname starts at the first character after "://"*/
@@ -358,19 +819,8 @@ BLOB_RESULT Blob_UploadMultipleBlocksFromSasUri(const char* SASURI, IOTHUB_CLIEN
                     LogError("unable to create a HTTPAPIEX_HANDLE");
                     result = BLOB_ERROR;
                 }
-                else if ((certificates != NULL) && (HTTPAPIEX_SetOption(httpApiExHandle, "TrustedCerts", certificates) == HTTPAPIEX_ERROR))
+                else if (SetConnectionOptions(httpApiExHandle, certificates, proxyOptions, networkInterface) != 0)
                 {
-                    LogError("failure in setting trusted certificates");
-                    result = BLOB_ERROR;
-                }
-                else if ((proxyOptions != NULL && proxyOptions->host_address != NULL) && HTTPAPIEX_SetOption(httpApiExHandle, OPTION_HTTP_PROXY, proxyOptions) == HTTPAPIEX_ERROR)
-                {
-                    LogError("failure in setting proxy options");
-                    result = BLOB_ERROR;
-                }
-                else if ((networkInterface != NULL) && HTTPAPIEX_SetOption(httpApiExHandle, OPTION_CURL_INTERFACE, networkInterface) == HTTPAPIEX_ERROR)
-                {
-                    LogError("failure in setting network interface");
                     result = BLOB_ERROR;
                 }
                 /*Codes_SRS_BLOB_02_028: [ Blob_UploadMultipleBlocksFromSasUri shall construct an XML string with the following content: ]*/
@@ -380,7 +830,16 @@ BLOB_RESULT Blob_UploadMultipleBlocksFromSasUri(const char* SASURI, IOTHUB_CLIEN
                     LogError("failed to STRING_construct");
                     result = BLOB_HTTP_ERROR;
                 }
-                else if ((result = InvokeUserCallbackAndSendBlobs(httpApiExHandle, relativePath, blockIDList, getDataCallbackEx, context, httpStatus, httpResponse)) != BLOB_OK)
+                /*Codes_SRS_BLOB_31_008: [ The IDs of the first `uploadedBlockCount` blocks shall be added to the block list without uploading these blocks again, and the first block returned by `getDataCallbackEx` shall be block number `uploadedBlockCount`. ]*/
+                else if (AppendBlockIdsToList(blockIDList, 0, uploadedBlockCount) != 0)
+                {
+                    /*Codes_SRS_BLOB_02_033: [ If any previous operation that doesn't have an explicit failure description fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR ]*/
+                    LogError("unable to add the IDs of the blocks already uploaded to the block list");
+                    result = BLOB_ERROR;
+                }
+                else if ((result = (parallelBlocks > 1) ?
+                    UploadBlocksInParallel(httpApiExHandle, hostname, relativePath, blockIDList, getDataCallbackEx, context, httpStatus, httpResponse, certificates, proxyOptions, networkInterface, parallelBlocks, uploadedBlockCount) :
+                    InvokeUserCallbackAndSendBlobs(httpApiExHandle, relativePath, blockIDList, getDataCallbackEx, context, httpStatus, httpResponse, uploadedBlockCount)) != BLOB_OK)
                 {
                    LogError("Failed in invoking callback/sending blob step");
                 }
@@ -0,0 +1,475 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef _WIN32
+/*files past 2 GB need a 64-bit off_t and fseeko/ftello on 32-bit targets*/
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+#ifndef _LARGEFILE_SOURCE
+#define _LARGEFILE_SOURCE
+#endif
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+#include "azure_macro_utils/macro_utils.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#include "internal/blob_file_source.h"
+#include "internal/iothub_client_ll_uploadtoblob.h"
+
+#define CHECKPOINT_SIZE 24 /*file size, uploaded block count, destination hash, first block hash and checksum*/
+#define CHECKSUM_SEED 2166136261u
+#define HASH_CHUNK_SIZE 4096
+
+static const char* const CHECKPOINT_TEMP_SUFFIX = ".tmp";
+
+typedef struct BLOB_FILE_SOURCE_TAG
+{
+    FILE* file;
+    uint64_t file_size;
+    unsigned char* block; /*receives each block read from the file*/
+    unsigned int next_block; /*the block the next call to blob_file_source_get_data reads*/
+    unsigned int uploaded_block_count; /*blocks known to be uploaded, last written to the checkpoint*/
+    uint32_t destination_hash;
+    uint32_t first_block_hash; /*tells apart files of the same size, only computed when the progress is kept*/
+    char* checkpoint_name; /*NULL when the progress is not kept*/
+    char* checkpoint_temp_name;
+    bool failed;
+} BLOB_FILE_SOURCE;
+
+static uint32_t update_checksum(uint32_t checksum, const unsigned char* data, size_t size)
+{
+    /*FNV-1a*/
+    uint32_t result = checksum;
+    size_t i;
+    for (i = 0; i < size; i++)
+    {
+        result ^= data[i];
+        result *= 16777619u;
+    }
+    return result;
+}
+
+static uint32_t compute_checksum(const unsigned char* data, size_t size)
+{
+    return update_checksum(CHECKSUM_SEED, data, size);
+}
+
+static void put_uint32(unsigned char* destination, uint32_t value)
+{
+    destination[0] = (unsigned char)(value & 0xFF);
+    destination[1] = (unsigned char)((value >> 8) & 0xFF);
+    destination[2] = (unsigned char)((value >> 16) & 0xFF);
+    destination[3] = (unsigned char)((value >> 24) & 0xFF);
+}
+
+static uint32_t get_uint32(const unsigned char* source)
+{
+    return (uint32_t)source[0] | ((uint32_t)source[1] << 8) | ((uint32_t)source[2] << 16) | ((uint32_t)source[3] << 24);
+}
+
+static char* create_file_name(const char* path, const char* suffix)
+{
+    size_t path_length = strlen(path);
+    size_t suffix_length = strlen(suffix);
+    char* result = (char*)malloc(path_length + suffix_length + 1);
+    if (result == NULL)
+    {
+        LogError("unable to allocate a file name");
+    }
+    else
+    {
+        (void)memcpy(result, path, path_length);
+        (void)memcpy(result + path_length, suffix, suffix_length + 1);
+    }
+    return result;
+}
+
+/*fseek and ftell take a long, which is 32 bits on Windows and on 32-bit targets*/
+static int seek_file(FILE* file, uint64_t offset, int origin)
+{
+    int result;
+    if (offset > INT64_MAX)
+    {
+        result = MU_FAILURE;
+    }
+#ifdef _WIN32
+    else if (_fseeki64(file, (__int64)offset, origin) != 0)
+#else
+    else if (fseeko(file, (off_t)offset, origin) != 0)
+#endif
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+static int tell_file(FILE* file, uint64_t* offset)
+{
+    int result;
+#ifdef _WIN32
+    __int64 position = _ftelli64(file);
+#else
+    off_t position = ftello(file);
+#endif
+    if (position < 0)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        *offset = (uint64_t)position;
+        result = 0;
+    }
+    return result;
+}
+
+static int get_file_size(FILE* file, uint64_t* size)
+{
+    int result;
+    if ((seek_file(file, 0, SEEK_END) != 0) || (tell_file(file, size) != 0) || (seek_file(file, 0, SEEK_SET) != 0))
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+/*hashes the first block of the file and leaves the file at its start*/
+static int hash_first_block(FILE* file, uint64_t file_size, uint32_t* hash)
+{
+    int result;
+    unsigned char chunk[HASH_CHUNK_SIZE];
+    size_t remaining = (file_size > BLOCK_SIZE) ? BLOCK_SIZE : (size_t)file_size;
+    uint32_t checksum = CHECKSUM_SEED;
+
+    result = 0;
+    while ((remaining > 0) && (result == 0))
+    {
+        size_t chunk_size = (remaining > HASH_CHUNK_SIZE) ? HASH_CHUNK_SIZE : remaining;
+        if (fread(chunk, 1, chunk_size, file) != chunk_size)
+        {
+            result = MU_FAILURE;
+        }
+        else
+        {
+            checksum = update_checksum(checksum, chunk, chunk_size);
+            remaining -= chunk_size;
+        }
+    }
+
+    if ((result != 0) || (seek_file(file, 0, SEEK_SET) != 0))
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        *hash = checksum;
+    }
+    return result;
+}
+
+/*returns 0 and sets uploaded_block_count if the checkpoint is intact and was written for this file and destination*/
+static int read_checkpoint_file(BLOB_FILE_SOURCE* file_source, const char* name, unsigned int* uploaded_block_count)
+{
+    int result;
+    FILE* file = fopen(name, "rb");
+    if (file == NULL)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        unsigned char checkpoint[CHECKPOINT_SIZE];
+        if ((fread(checkpoint, 1, CHECKPOINT_SIZE, file) != CHECKPOINT_SIZE) ||
+            (get_uint32(checkpoint + 20) != compute_checksum(checkpoint, 20)))
+        {
+            LogError("ignoring damaged checkpoint %s", name);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            uint64_t file_size = (uint64_t)get_uint32(checkpoint) | ((uint64_t)get_uint32(checkpoint + 4) << 32);
+            uint32_t block_count = get_uint32(checkpoint + 8);
+            if ((file_size != file_source->file_size) ||
+                (get_uint32(checkpoint + 12) != file_source->destination_hash) ||
+                (get_uint32(checkpoint + 16) != file_source->first_block_hash) ||
+                ((uint64_t)block_count * BLOCK_SIZE >= file_size + BLOCK_SIZE))
+            {
+                LogInfo("checkpoint %s is for another upload, starting over", name);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                *uploaded_block_count = block_count;
+                result = 0;
+            }
+        }
+        (void)fclose(file);
+    }
+    return result;
+}
+
+/*the checkpoint is written aside and then renamed over the previous one. If a crash happens in between, the temporary one is used*/
+static int write_checkpoint(BLOB_FILE_SOURCE* file_source)
+{
+    int result;
+    unsigned char checkpoint[CHECKPOINT_SIZE];
+    FILE* file;
+    put_uint32(checkpoint, (uint32_t)(file_source->file_size & 0xFFFFFFFF));
+    put_uint32(checkpoint + 4, (uint32_t)(file_source->file_size >> 32));
+    put_uint32(checkpoint + 8, file_source->uploaded_block_count);
+    put_uint32(checkpoint + 12, file_source->destination_hash);
+    put_uint32(checkpoint + 16, file_source->first_block_hash);
+    put_uint32(checkpoint + 20, compute_checksum(checkpoint, 20));
+
+    if ((file = fopen(file_source->checkpoint_temp_name, "wb")) == NULL)
+    {
+        LogError("unable to create %s", file_source->checkpoint_temp_name);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        bool written = (fwrite(checkpoint, 1, CHECKPOINT_SIZE, file) == CHECKPOINT_SIZE) && (fflush(file) == 0);
+        if ((fclose(file) != 0) || !written)
+        {
+            LogError("unable to write %s", file_source->checkpoint_temp_name);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            (void)remove(file_source->checkpoint_name);
+            if (rename(file_source->checkpoint_temp_name, file_source->checkpoint_name) != 0)
+            {
+                LogError("unable to rename %s", file_source->checkpoint_temp_name);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+    return result;
+}
+
+static int open_checkpoint(BLOB_FILE_SOURCE* file_source, const char* checkpoint_path)
+{
+    int result;
+    if ((file_source->checkpoint_name = create_file_name(checkpoint_path, "")) == NULL ||
+        (file_source->checkpoint_temp_name = create_file_name(checkpoint_path, CHECKPOINT_TEMP_SUFFIX)) == NULL)
+    {
+        result = MU_FAILURE;
+    }
+    else if (hash_first_block(file_source->file, file_source->file_size, &file_source->first_block_hash) != 0)
+    {
+        LogError("unable to read the first block of the file");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        unsigned int uploaded_block_count;
+        if ((read_checkpoint_file(file_source, file_source->checkpoint_name, &uploaded_block_count) != 0) &&
+            (read_checkpoint_file(file_source, file_source->checkpoint_temp_name, &uploaded_block_count) != 0))
+        {
+            result = 0;
+        }
+        else if (seek_file(file_source->file, (uint64_t)uploaded_block_count * BLOCK_SIZE, SEEK_SET) != 0)
+        {
+            LogError("unable to seek to block %u", uploaded_block_count);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            LogInfo("resuming the upload after block %u", uploaded_block_count);
+            file_source->uploaded_block_count = uploaded_block_count;
+            file_source->next_block = uploaded_block_count;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static void remove_checkpoint(BLOB_FILE_SOURCE* file_source)
+{
+    (void)remove(file_source->checkpoint_name);
+    (void)remove(file_source->checkpoint_temp_name);
+}
+
+BLOB_FILE_SOURCE_HANDLE blob_file_source_create(const char* file_path, const char* checkpoint_path, const char* destination_file_name)
+{
+    BLOB_FILE_SOURCE* result;
+
+    if ((file_path == NULL) || (destination_file_name == NULL))
+    {
+        LogError("Invalid argument (file_path=%p, destination_file_name=%p)", file_path, destination_file_name);
+        result = NULL;
+    }
+    else if ((result = (BLOB_FILE_SOURCE*)malloc(sizeof(BLOB_FILE_SOURCE))) == NULL)
+    {
+        LogError("unable to allocate the file source");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(BLOB_FILE_SOURCE));
+        result->destination_hash = compute_checksum((const unsigned char*)destination_file_name, strlen(destination_file_name));
+
+        if ((result->file = fopen(file_path, "rb")) == NULL)
+        {
+            LogError("unable to open %s", file_path);
+            blob_file_source_destroy(result);
+            result = NULL;
+        }
+        else if (get_file_size(result->file, &result->file_size) != 0)
+        {
+            LogError("unable to get the size of %s", file_path);
+            blob_file_source_destroy(result);
+            result = NULL;
+        }
+        else if ((checkpoint_path != NULL) && (open_checkpoint(result, checkpoint_path) != 0))
+        {
+            blob_file_source_destroy(result);
+            result = NULL;
+        }
+        else
+        {
+            /*the buffer is never bigger than what is left to read*/
+            uint64_t offset = (uint64_t)result->next_block * BLOCK_SIZE;
+            uint64_t remaining = (offset < result->file_size) ? result->file_size - offset : 0;
+            size_t block_capacity = (remaining > BLOCK_SIZE) ? BLOCK_SIZE : (size_t)remaining;
+            if ((block_capacity > 0) && ((result->block = (unsigned char*)malloc(block_capacity)) == NULL))
+            {
+                LogError("unable to allocate a block of %lu bytes", (unsigned long)block_capacity);
+                blob_file_source_destroy(result);
+                result = NULL;
+            }
+        }
+    }
+
+    return result;
+}
+
+void blob_file_source_destroy(BLOB_FILE_SOURCE_HANDLE file_source)
+{
+    if (file_source == NULL)
+    {
+        LogError("Invalid argument (file_source is NULL)");
+    }
+    else
+    {
+        if (file_source->file != NULL)
+        {
+            (void)fclose(file_source->file);
+        }
+        free(file_source->block);
+        free(file_source->checkpoint_name);
+        free(file_source->checkpoint_temp_name);
+        free(file_source);
+    }
+}
+
+unsigned int blob_file_source_get_uploaded_block_count(BLOB_FILE_SOURCE_HANDLE file_source)
+{
+    unsigned int result;
+    if (file_source == NULL)
+    {
+        LogError("Invalid argument (file_source is NULL)");
+        result = 0;
+    }
+    else
+    {
+        result = file_source->uploaded_block_count;
+    }
+    return result;
+}
+
+bool blob_file_source_has_failed(BLOB_FILE_SOURCE_HANDLE file_source)
+{
+    bool result;
+    if (file_source == NULL)
+    {
+        LogError("Invalid argument (file_source is NULL)");
+        result = true;
+    }
+    else
+    {
+        result = file_source->failed;
+    }
+    return result;
+}
+
+IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_RESULT blob_file_source_get_data(IOTHUB_CLIENT_FILE_UPLOAD_RESULT result, unsigned char const ** data, size_t* size, void* context)
+{
+    IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_RESULT get_data_result = IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_OK;
+    BLOB_FILE_SOURCE* file_source = (BLOB_FILE_SOURCE*)context;
+
+    if (data == NULL || size == NULL)
+    {
+        /*this is the last call, once the upload has completed the checkpoint is of no use*/
+        if ((result == FILE_UPLOAD_OK) && !file_source->failed && (file_source->checkpoint_name != NULL))
+        {
+            remove_checkpoint(file_source);
+        }
+    }
+    else if (result != FILE_UPLOAD_OK)
+    {
+        *data = NULL;
+        *size = 0;
+    }
+    else
+    {
+        uint64_t offset = (uint64_t)file_source->next_block * BLOCK_SIZE;
+
+        /*a block is only requested once the previous one has been uploaded*/
+        if (file_source->next_block > file_source->uploaded_block_count)
+        {
+            file_source->uploaded_block_count = file_source->next_block;
+            if ((file_source->checkpoint_name != NULL) && (write_checkpoint(file_source) != 0))
+            {
+                LogError("unable to record that %u blocks are uploaded, the upload goes on", file_source->uploaded_block_count);
+            }
+        }
+
+        if (offset >= file_source->file_size)
+        {
+            /*everything has been read*/
+            *data = NULL;
+            *size = 0;
+        }
+        else
+        {
+            size_t block_size = (file_source->file_size - offset > BLOCK_SIZE) ? BLOCK_SIZE : (size_t)(file_source->file_size - offset);
+            if (fread(file_source->block, 1, block_size, file_source->file) != block_size)
+            {
+                LogError("unable to read block %u of the file", file_source->next_block);
+                file_source->failed = true;
+                get_data_result = IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_ABORT;
+            }
+            else
+            {
+                *data = file_source->block;
+                *size = block_size;
+                file_source->next_block++;
+            }
+        }
+    }
+
+    return get_data_result;
+}
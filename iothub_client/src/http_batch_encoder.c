@@ -0,0 +1,351 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <string.h>
+#include <stdbool.h>
+#include "azure_macro_utils/macro_utils.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/map.h"
+
+#include "iothub_message.h"
+#include "internal/http_batch_encoder.h"
+
+#define IOTHUB_APP_PREFIX "iothub-app-"
+
+#define LITERAL_LENGTH(literal) (sizeof(literal) - 1)
+#define STRING_AND_LENGTH(literal) literal, LITERAL_LENGTH(literal)
+
+static const char BASE64_CHARACTERS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char HEX_CHARACTERS[] = "0123456789ABCDEF";
+
+static const char BODY_BEGIN_BASE64[] = "{\"body\":\"";
+static const char BODY_END_BASE64[] = "\"";
+static const char BODY_BEGIN_STRING[] = "{\"body\":";
+static const char BODY_END_STRING[] = ",\"base64Encoded\":false";
+static const char PROPERTIES_BEGIN[] = ",\"properties\":{";
+static const char FIRST_PROPERTY_NAME_BEGIN[] = "\"" IOTHUB_APP_PREFIX;
+static const char PROPERTY_NAME_BEGIN[] = ",\"" IOTHUB_APP_PREFIX;
+static const char PROPERTY_NAME_END[] = "\":\"";
+static const char PROPERTY_VALUE_END[] = "\"";
+static const char PROPERTIES_END[] = "}";
+static const char ITEM_END[] = "},";
+
+/*the parts of a message that make up its batch item*/
+typedef struct ITEM_CONTENT_TAG
+{
+    bool isString;
+    const unsigned char* body;
+    size_t bodyLength;
+    const char* const* keys;
+    const char* const* values;
+    size_t propertyCount;
+} ITEM_CONTENT;
+
+typedef struct ITEM_WRITER_TAG
+{
+    unsigned char* position;
+    unsigned char* end;
+} ITEM_WRITER;
+
+static int get_item_content(IOTHUB_MESSAGE_HANDLE message, ITEM_CONTENT* content)
+{
+    int result;
+    IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(message);
+
+    if (contentType == IOTHUBMESSAGE_BYTEARRAY)
+    {
+        content->isString = false;
+        if (IoTHubMessage_GetByteArray(message, &content->body, &content->bodyLength) != IOTHUB_MESSAGE_OK)
+        {
+            LogError("unable to get the data for the message.");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    else if (contentType == IOTHUBMESSAGE_STRING)
+    {
+        const char* source = IoTHubMessage_GetString(message);
+        content->isString = true;
+        if (source == NULL)
+        {
+            LogError("unable to IoTHubMessage_GetString");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            content->body = (const unsigned char*)source;
+            content->bodyLength = strlen(source);
+            result = 0;
+        }
+    }
+    else
+    {
+        LogError("an unknown message type was encountered (%d)", contentType);
+        result = MU_FAILURE;
+    }
+
+    if (result == 0 &&
+        Map_GetInternals(IoTHubMessage_Properties(message), &content->keys, &content->values, &content->propertyCount) != MAP_OK)
+    {
+        LogError("error while Map_GetInternals");
+        result = MU_FAILURE;
+    }
+
+    return result;
+}
+
+/*length of the JSON string of source, as produced by STRING_new_JSON: quotes around, \uXXXX for control characters and a backslash
+before '"', '\\' and '/'. Non-ASCII characters are not allowed*/
+static int measure_json_string(const unsigned char* source, size_t length, size_t* jsonLength)
+{
+    int result = 0;
+    size_t total = length + 2;
+    size_t i;
+    for (i = 0; i < length; i++)
+    {
+        if (source[i] >= 128)
+        {
+            LogError("invalid character in string message");
+            result = MU_FAILURE;
+            break;
+        }
+        else if (source[i] <= 0x1F)
+        {
+            total += 5;
+        }
+        else if ((source[i] == '"') || (source[i] == '\\') || (source[i] == '/'))
+        {
+            total += 1;
+        }
+    }
+    *jsonLength = total;
+    return result;
+}
+
+static bool write_bytes(ITEM_WRITER* writer, const void* source, size_t length)
+{
+    bool result;
+    if ((size_t)(writer->end - writer->position) < length)
+    {
+        result = false;
+    }
+    else
+    {
+        (void)memcpy(writer->position, source, length);
+        writer->position += length;
+        result = true;
+    }
+    return result;
+}
+
+static bool write_string(ITEM_WRITER* writer, const char* source)
+{
+    return write_bytes(writer, source, strlen(source));
+}
+
+static bool write_base64(ITEM_WRITER* writer, const unsigned char* source, size_t length)
+{
+    bool result;
+    size_t encodedLength = ((length + 2) / 3) * 4;
+    if ((size_t)(writer->end - writer->position) < encodedLength)
+    {
+        result = false;
+    }
+    else
+    {
+        unsigned char* destination = writer->position;
+        size_t i = 0;
+        for (; i + 2 < length; i += 3)
+        {
+            *destination++ = BASE64_CHARACTERS[source[i] >> 2];
+            *destination++ = BASE64_CHARACTERS[((source[i] & 0x03) << 4) | (source[i + 1] >> 4)];
+            *destination++ = BASE64_CHARACTERS[((source[i + 1] & 0x0F) << 2) | (source[i + 2] >> 6)];
+            *destination++ = BASE64_CHARACTERS[source[i + 2] & 0x3F];
+        }
+
+        if (i + 1 == length)
+        {
+            *destination++ = BASE64_CHARACTERS[source[i] >> 2];
+            *destination++ = BASE64_CHARACTERS[(source[i] & 0x03) << 4];
+            *destination++ = '=';
+            *destination++ = '=';
+        }
+        else if (i + 2 == length)
+        {
+            *destination++ = BASE64_CHARACTERS[source[i] >> 2];
+            *destination++ = BASE64_CHARACTERS[((source[i] & 0x03) << 4) | (source[i + 1] >> 4)];
+            *destination++ = BASE64_CHARACTERS[(source[i + 1] & 0x0F) << 2];
+            *destination++ = '=';
+        }
+
+        writer->position = destination;
+        result = true;
+    }
+    return result;
+}
+
+static bool write_json_string(ITEM_WRITER* writer, const unsigned char* source, size_t length)
+{
+    size_t jsonLength;
+    bool result;
+    if (measure_json_string(source, length, &jsonLength) != 0 ||
+        (size_t)(writer->end - writer->position) < jsonLength)
+    {
+        result = false;
+    }
+    else
+    {
+        unsigned char* destination = writer->position;
+        size_t i;
+        *destination++ = '"';
+        for (i = 0; i < length; i++)
+        {
+            if (source[i] <= 0x1F)
+            {
+                *destination++ = '\\';
+                *destination++ = 'u';
+                *destination++ = '0';
+                *destination++ = '0';
+                *destination++ = HEX_CHARACTERS[(source[i] & 0xF0) >> 4];
+                *destination++ = HEX_CHARACTERS[source[i] & 0x0F];
+            }
+            else if ((source[i] == '"') || (source[i] == '\\') || (source[i] == '/'))
+            {
+                *destination++ = '\\';
+                *destination++ = source[i];
+            }
+            else
+            {
+                *destination++ = source[i];
+            }
+        }
+        *destination++ = '"';
+        writer->position = destination;
+        result = true;
+    }
+    return result;
+}
+
+int http_batch_encoder_measure(IOTHUB_MESSAGE_HANDLE message, size_t* encoded_size, size_t* message_size)
+{
+    int result;
+    ITEM_CONTENT content;
+
+    if (message == NULL || encoded_size == NULL || message_size == NULL)
+    {
+        LogError("invalid argument IOTHUB_MESSAGE_HANDLE message=%p, size_t* encoded_size=%p, size_t* message_size=%p", message, encoded_size, message_size);
+        result = MU_FAILURE;
+    }
+    else if (get_item_content(message, &content) != 0)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t encoded;
+        result = 0;
+
+        if (content.isString)
+        {
+            size_t jsonLength;
+            if (measure_json_string(content.body, content.bodyLength, &jsonLength) != 0)
+            {
+                result = MU_FAILURE;
+            }
+            encoded = LITERAL_LENGTH(BODY_BEGIN_STRING) + jsonLength + LITERAL_LENGTH(BODY_END_STRING);
+        }
+        else
+        {
+            encoded = LITERAL_LENGTH(BODY_BEGIN_BASE64) + ((content.bodyLength + 2) / 3) * 4 + LITERAL_LENGTH(BODY_END_BASE64);
+        }
+
+        if (result == 0)
+        {
+            /*Codes_SRS_TRANSPORTMULTITHTTP_17_062: [The message size is computed from the length of the payload + 384.] */
+            size_t size = content.bodyLength + MAXIMUM_PAYLOAD_OVERHEAD;
+
+            if (content.propertyCount > 0)
+            {
+                size_t i;
+                encoded += LITERAL_LENGTH(PROPERTIES_BEGIN) + LITERAL_LENGTH(PROPERTIES_END);
+                for (i = 0; i < content.propertyCount; i++)
+                {
+                    size_t keyLength = strlen(content.keys[i]);
+                    size_t valueLength = strlen(content.values[i]);
+                    encoded += ((i == 0) ? LITERAL_LENGTH(FIRST_PROPERTY_NAME_BEGIN) : LITERAL_LENGTH(PROPERTY_NAME_BEGIN)) +
+                        keyLength + LITERAL_LENGTH(PROPERTY_NAME_END) + valueLength + LITERAL_LENGTH(PROPERTY_VALUE_END);
+                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_063: [Every property name shall add to the message size the length of the property name + the length of the property value + 16 bytes.] */
+                    size += keyLength + valueLength + MAXIMUM_PROPERTY_OVERHEAD;
+                }
+            }
+
+            *encoded_size = encoded + LITERAL_LENGTH(ITEM_END);
+            *message_size = size;
+        }
+    }
+    return result;
+}
+
+size_t http_batch_encoder_write(IOTHUB_MESSAGE_HANDLE message, unsigned char* destination, size_t size)
+{
+    size_t result;
+    ITEM_CONTENT content;
+
+    if (message == NULL || destination == NULL)
+    {
+        LogError("invalid argument IOTHUB_MESSAGE_HANDLE message=%p, unsigned char* destination=%p", message, destination);
+        result = 0;
+    }
+    else if (get_item_content(message, &content) != 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        ITEM_WRITER writer;
+        bool isWritten;
+        writer.position = destination;
+        writer.end = destination + size;
+
+        /*Codes_SRS_TRANSPORTMULTITHTTP_17_057: [If a messages to be send has type IOTHUBMESSAGE_STRING, then its serialization shall be {"body":"JSON encoding of the string", "base64Encoded":false}] */
+        isWritten = content.isString
+            ? (write_bytes(&writer, STRING_AND_LENGTH(BODY_BEGIN_STRING)) &&
+                write_json_string(&writer, content.body, content.bodyLength) &&
+                write_bytes(&writer, STRING_AND_LENGTH(BODY_END_STRING)))
+            : (write_bytes(&writer, STRING_AND_LENGTH(BODY_BEGIN_BASE64)) &&
+                write_base64(&writer, content.body, content.bodyLength) &&
+                write_bytes(&writer, STRING_AND_LENGTH(BODY_END_BASE64)));
+
+        /*Codes_SRS_TRANSPORTMULTITHTTP_17_064: [If IoTHubMessage does not have properties, then "properties":{...} shall be missing from the payload*/
+        /*Codes_SRS_TRANSPORTMULTITHTTP_17_058: [If IoTHubMessage has properties, then they shall be serialized at the same level as "body" using the following pattern: "properties":{"iothub-app-name1":"value1","iothub-app-name2":"value2*/
+        if (isWritten && content.propertyCount > 0)
+        {
+            size_t i;
+            isWritten = write_bytes(&writer, STRING_AND_LENGTH(PROPERTIES_BEGIN));
+            for (i = 0; isWritten && i < content.propertyCount; i++)
+            {
+                isWritten = ((i == 0) ? write_bytes(&writer, STRING_AND_LENGTH(FIRST_PROPERTY_NAME_BEGIN)) : write_bytes(&writer, STRING_AND_LENGTH(PROPERTY_NAME_BEGIN))) &&
+                    write_string(&writer, content.keys[i]) &&
+                    write_bytes(&writer, STRING_AND_LENGTH(PROPERTY_NAME_END)) &&
+                    write_string(&writer, content.values[i]) &&
+                    write_bytes(&writer, STRING_AND_LENGTH(PROPERTY_VALUE_END));
+            }
+            isWritten = isWritten && write_bytes(&writer, STRING_AND_LENGTH(PROPERTIES_END));
+        }
+
+        if (!(isWritten && write_bytes(&writer, STRING_AND_LENGTH(ITEM_END))))
+        {
+            LogError("batch item does not fit in %lu bytes", (unsigned long)size);
+            result = 0;
+        }
+        else
+        {
+            result = (size_t)(writer.position - destination);
+        }
+    }
+    return result;
+}
@@ -13,9 +13,11 @@
 #include "iothub_client_core_ll.h"
 #include "internal/iothubtransport.h"
 #include "internal/iothub_client_private.h"
+#include "internal/iothub_client_thread_id.h"
 #include "internal/iothubtransport.h"
 #include "azure_c_shared_utility/threadapi.h"
 #include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/vector.h"
@@ -26,6 +28,7 @@
 
 #define DO_WORK_FREQ_DEFAULT 1
 #define DO_WORK_MAXIMUM_ALLOWED_FREQUENCY 100
+#define EVENT_DRIVEN_MAX_WAIT_MS DO_WORK_MAXIMUM_ALLOWED_FREQUENCY
 
 struct IOTHUB_QUEUE_CONTEXT_TAG;
 
@@ -50,6 +53,21 @@ typedef struct IOTHUB_CLIENT_CORE_INSTANCE_TAG
     struct IOTHUB_QUEUE_CONTEXT_TAG* method_user_context;
     tickcounter_ms_t do_work_freq_ms;
     tickcounter_ms_t currentMessageTimeout;
+    bool event_driven_do_work;
+    bool work_signaled;
+    COND_HANDLE work_signal;
+    bool block_when_send_queue_full;
+    COND_HANDLE send_queue_room; /*posted when a send completes while SendEventAsync waits for room, see send_event_to_ll*/
+    size_t send_queue_waiters;
+    uint64_t send_queue_completed_when_full; /*completed sends when the last waiter found the send queue full*/
+    IOTHUB_CLIENT_SEND_QUEUE_CALLBACK send_queue_callback;
+    void* send_queue_user_context;
+#ifdef IOTHUB_THREAD_ID_AVAILABLE
+    bool has_callback_thread;
+    IOTHUB_THREAD_ID callback_thread; /*thread that last ran dispatch_user_callbacks, see is_callback_thread*/
+#else
+    bool dispatching_user_callbacks;
+#endif
 } IOTHUB_CLIENT_CORE_INSTANCE;
 
 typedef enum HTTPWORKER_THREAD_TYPE_TAG
@@ -103,7 +121,8 @@ typedef struct HTTPWORKER_THREAD_INFO_TAG
     CALLBACK_TYPE_DEVICE_METHOD,        \
     CALLBACK_TYPE_INBOUD_DEVICE_METHOD, \
     CALLBACK_TYPE_MESSAGE,              \
-    CALLBACK_TYPE_INPUTMESSAGE
+    CALLBACK_TYPE_INPUTMESSAGE,         \
+    CALLBACK_TYPE_SEND_QUEUE_STATE
 
 MU_DEFINE_ENUM_WITHOUT_INVALID(USER_CALLBACK_TYPE, USER_CALLBACK_TYPE_VALUES)
 MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(USER_CALLBACK_TYPE, USER_CALLBACK_TYPE_VALUES)
@@ -161,6 +180,7 @@ typedef struct USER_CALLBACK_INFO_TAG
         METHOD_CALLBACK_INFO method_cb_info;
         MESSAGE_CALLBACK_INFO* message_cb_info;
         INPUTMESSAGE_CALLBACK_INFO inputmessage_cb_info;
+        IOTHUB_CLIENT_SEND_QUEUE_STATE send_queue_state;
     } iothub_callback;
 } USER_CALLBACK_INFO;
 
@@ -438,6 +458,22 @@ static void iothub_ll_connection_status_callback(IOTHUB_CLIENT_CONNECTION_STATUS
     }
 }
 
+static void iothub_ll_send_queue_callback(IOTHUB_CLIENT_SEND_QUEUE_STATE state, void* userContextCallback)
+{
+    IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_CORE_INSTANCE*)userContextCallback;
+    if (iotHubClientInstance != NULL)
+    {
+        USER_CALLBACK_INFO queue_cb_info;
+        queue_cb_info.type = CALLBACK_TYPE_SEND_QUEUE_STATE;
+        queue_cb_info.userContextCallback = iotHubClientInstance->send_queue_user_context;
+        queue_cb_info.iothub_callback.send_queue_state = state;
+        if (VECTOR_push_back(iotHubClientInstance->saved_user_callback_list, &queue_cb_info, 1) != 0)
+        {
+            LogError("send queue callback vector push failed.");
+        }
+    }
+}
+
 static void iothub_ll_event_confirm_callback(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback)
 {
     IOTHUB_QUEUE_CONTEXT* queue_context = (IOTHUB_QUEUE_CONTEXT*)userContextCallback;
@@ -590,6 +626,7 @@ static void dispatch_user_callbacks(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientIns
     IOTHUB_CLIENT_DEVICE_METHOD_CALLBACK_ASYNC device_method_callback = NULL;
     IOTHUB_CLIENT_INBOUND_DEVICE_METHOD_CALLBACK inbound_device_method_callback = NULL;
     IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC message_callback = NULL;
+    IOTHUB_CLIENT_SEND_QUEUE_CALLBACK send_queue_callback = NULL;
     IOTHUB_CLIENT_CORE_HANDLE message_user_context_handle = NULL;
     IOTHUB_CLIENT_CORE_HANDLE method_user_context_handle = NULL;
 
@@ -605,6 +642,7 @@ static void dispatch_user_callbacks(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientIns
         device_method_callback = iotHubClientInstance->device_method_callback;
         inbound_device_method_callback = iotHubClientInstance->inbound_device_method_callback;
         message_callback = iotHubClientInstance->message_callback;
+        send_queue_callback = iotHubClientInstance->send_queue_callback;
         if (iotHubClientInstance->method_user_context)
         {
             method_user_context_handle = iotHubClientInstance->method_user_context->iotHubClientHandle;
@@ -614,10 +652,16 @@ static void dispatch_user_callbacks(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientIns
             message_user_context_handle = iotHubClientInstance->message_user_context->iotHubClientHandle;
         }
 
+#ifdef IOTHUB_THREAD_ID_AVAILABLE
+        iotHubClientInstance->has_callback_thread = true;
+        iotHubClientInstance->callback_thread = IOTHUB_THREAD_ID_CURRENT();
+#else
+        iotHubClientInstance->dispatching_user_callbacks = true;
+#endif
+
         (void)Unlock(iotHubClientInstance->LockHandle);
     }
 
-
     for (index = 0; index < callbacks_length; index++)
     {
         USER_CALLBACK_INFO* queued_cb = (USER_CALLBACK_INFO*)VECTOR_element(call_backs, index);
@@ -755,15 +799,142 @@ static void dispatch_user_callbacks(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientIns
                 }
                 break;
 
+            case CALLBACK_TYPE_SEND_QUEUE_STATE:
+                if (send_queue_callback)
+                {
+                    send_queue_callback(queued_cb->iothub_callback.send_queue_state, queued_cb->userContextCallback);
+                }
+                break;
+
             default:
                 LogError("Invalid callback type '%s'", MU_ENUM_TO_STRING(USER_CALLBACK_TYPE, queued_cb->type));
                 break;
             }
         }
     }
+#ifndef IOTHUB_THREAD_ID_AVAILABLE
+    if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+    {
+        LogError("failed locking for dispatch_user_callbacks");
+    }
+    else
+    {
+        iotHubClientInstance->dispatching_user_callbacks = false;
+        (void)Unlock(iotHubClientInstance->LockHandle);
+    }
+#endif
     VECTOR_destroy(call_backs);
 }
 
+//
+// has_pending_work is used in event driven mode to decide whether the worker thread should keep polling at
+// do_work_freq_ms or may block until signaled. Messages already sent and waiting for their acknowledgement do not
+// count: the wait is bounded, so the acknowledgement is still processed. Must be called with LockHandle held.
+//
+static bool has_pending_work(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance, VECTOR_HANDLE call_backs)
+{
+    IOTHUB_CLIENT_STATISTICS statistics;
+
+    return (iotHubClientInstance->work_signaled) ||
+        ((call_backs != NULL) && (VECTOR_size(call_backs) > 0)) ||
+        (IoTHubClientCore_LL_GetStatistics(iotHubClientInstance->IoTHubClientLLHandle, &statistics) != IOTHUB_CLIENT_OK) ||
+        (statistics.waitingToSendCount > 0);
+}
+
+//
+// signal_worker_thread wakes up the worker thread after new work was handed to the LL layer, so it does not need to
+// wait for the idle timeout. Must be called with LockHandle held.
+//
+static void signal_worker_thread(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance)
+{
+    if (iotHubClientInstance->TransportHandle != NULL)
+    {
+        // Event driven mode of a shared transport may have been set through any of its clients, so the transport
+        // decides whether the signal is needed.
+        IoTHubTransport_SignalWork(iotHubClientInstance->TransportHandle);
+    }
+    else if (iotHubClientInstance->event_driven_do_work)
+    {
+        iotHubClientInstance->work_signaled = true;
+        if (Condition_Post(iotHubClientInstance->work_signal) != COND_OK)
+        {
+            LogError("failed signaling worker thread");
+        }
+    }
+}
+
+//
+// wait_for_work blocks the worker thread of an event driven client until it is signaled, destroyed or
+// EVENT_DRIVEN_MAX_WAIT_MS elapses, so the connection is still serviced while idle.
+//
+static void wait_for_work(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance)
+{
+    if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+    {
+        LogError("failed locking for wait_for_work");
+        (void)ThreadAPI_Sleep(EVENT_DRIVEN_MAX_WAIT_MS);
+    }
+    else
+    {
+        if (!iotHubClientInstance->work_signaled && !iotHubClientInstance->StopThread)
+        {
+            if (Condition_Wait(iotHubClientInstance->work_signal, iotHubClientInstance->LockHandle, EVENT_DRIVEN_MAX_WAIT_MS) == COND_ERROR)
+            {
+                LogError("failed waiting for work");
+            }
+        }
+        iotHubClientInstance->work_signaled = false;
+        (void)Unlock(iotHubClientInstance->LockHandle);
+    }
+}
+
+//
+// get_completed_sends returns the number of messages whose confirmation came back, whatever the result. Each one freed a
+// slot of the send queue. Must be called with LockHandle held.
+//
+static bool get_completed_sends(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance, uint64_t* completed)
+{
+    bool result;
+    IOTHUB_CLIENT_STATISTICS statistics;
+
+    if (IoTHubClientCore_LL_GetStatistics(iotHubClientInstance->IoTHubClientLLHandle, &statistics) != IOTHUB_CLIENT_OK)
+    {
+        LogError("failed getting the client statistics");
+        result = false;
+    }
+    else
+    {
+        *completed = statistics.messagesConfirmed + statistics.messagesTimedOut + statistics.messagesFailed;
+        result = true;
+    }
+
+    return result;
+}
+
+//
+// signal_send_queue_room wakes the threads waiting in send_event_to_ll once a send completed after they found the send
+// queue full. Must be called with LockHandle held.
+//
+static void signal_send_queue_room(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance)
+{
+    uint64_t completed;
+
+    if ((iotHubClientInstance->send_queue_waiters > 0) &&
+        get_completed_sends(iotHubClientInstance, &completed) &&
+        (completed != iotHubClientInstance->send_queue_completed_when_full))
+    {
+        size_t index;
+        for (index = 0; index < iotHubClientInstance->send_queue_waiters; index++)
+        {
+            if (Condition_Post(iotHubClientInstance->send_queue_room) != COND_OK)
+            {
+                LogError("failed signaling room in the send queue");
+                break;
+            }
+        }
+    }
+}
+
 static void ScheduleWork_Thread_ForMultiplexing(void* iotHubClientHandle)
 {
     IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_CORE_INSTANCE*)iotHubClientHandle;
@@ -772,6 +943,11 @@ static void ScheduleWork_Thread_ForMultiplexing(void* iotHubClientHandle)
     if (Lock(iotHubClientInstance->LockHandle) == LOCK_OK)
     {
         VECTOR_HANDLE call_backs = VECTOR_move(iotHubClientInstance->saved_user_callback_list);
+        if (IoTHubTransport_IsEventDriven(iotHubClientInstance->TransportHandle) && has_pending_work(iotHubClientInstance, call_backs))
+        {
+            // The transport lock is the client lock here, so the shared worker thread can be kept awake directly.
+            IoTHubTransport_SignalWork(iotHubClientInstance->TransportHandle);
+        }
         (void)Unlock(iotHubClientInstance->LockHandle);
 
         if (call_backs == NULL)
@@ -793,6 +969,7 @@ static int ScheduleWork_Thread(void* threadArgument)
 {
     IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_CORE_INSTANCE*)threadArgument;
     unsigned int sleeptime_in_ms = DO_WORK_FREQ_DEFAULT;
+    bool wait_for_signal = false;
 
     srand((unsigned int)get_time(NULL));
 
@@ -811,10 +988,20 @@ static int ScheduleWork_Thread(void* threadArgument)
                 /* Codes_SRS_IOTHUBCLIENT_01_037: [The thread created by IoTHubClient_SendEvent or IoTHubClient_SetMessageCallback shall call IoTHubClientCore_LL_DoWork every 1 ms by default.] */
                 /* Codes_SRS_IOTHUBCLIENT_01_039: [All calls to IoTHubClientCore_LL_DoWork shall be protected by the lock created in IotHubClient_Create.] */
                 IoTHubClientCore_LL_DoWork(iotHubClientInstance->IoTHubClientLLHandle);
+                signal_send_queue_room(iotHubClientInstance);
 
                 garbageCollectorImpl(iotHubClientInstance);
                 VECTOR_HANDLE call_backs = VECTOR_move(iotHubClientInstance->saved_user_callback_list);
                 sleeptime_in_ms = (unsigned int)iotHubClientInstance->do_work_freq_ms; // Update the sleepval within the locked thread.
+                if (iotHubClientInstance->event_driven_do_work)
+                {
+                    wait_for_signal = !has_pending_work(iotHubClientInstance, call_backs);
+                    iotHubClientInstance->work_signaled = false;
+                }
+                else
+                {
+                    wait_for_signal = false;
+                }
                 (void)Unlock(iotHubClientInstance->LockHandle);
                 if (call_backs == NULL)
                 {
@@ -833,8 +1020,15 @@ static int ScheduleWork_Thread(void* threadArgument)
             /*Codes_SRS_IOTHUBCLIENT_01_040: [If acquiring the lock fails, IoTHubClientCore_LL_DoWork shall not be called.]*/
             /*no code, shall retry*/
         }
-        /* Codes_SRS_IOTHUBCLIENT_041_02: [The thread shall sleep for a specified time in ms as provided through IoTHubClientCore_SetOption, with a default of 1 ms ] */
-        (void)ThreadAPI_Sleep(sleeptime_in_ms);
+        if (wait_for_signal)
+        {
+            wait_for_work(iotHubClientInstance);
+        }
+        else
+        {
+            /* Codes_SRS_IOTHUBCLIENT_041_02: [The thread shall sleep for a specified time in ms as provided through IoTHubClientCore_SetOption, with a default of 1 ms ] */
+            (void)ThreadAPI_Sleep(sleeptime_in_ms);
+        }
     }
 
     ThreadAPI_Exit(0);
@@ -1189,6 +1383,14 @@ void IoTHubClientCore_Destroy(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle)
         if (iotHubClientInstance->ThreadHandle != NULL)
         {
             iotHubClientInstance->StopThread = 1;
+            if (iotHubClientInstance->work_signal != NULL)
+            {
+                (void)Condition_Post(iotHubClientInstance->work_signal);
+            }
+            if (iotHubClientInstance->send_queue_room != NULL)
+            {
+                (void)Condition_Post(iotHubClientInstance->send_queue_room);
+            }
             joinClientThread = true;
         }
         else
@@ -1281,6 +1483,14 @@ void IoTHubClientCore_Destroy(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle)
         }
         VECTOR_destroy(iotHubClientInstance->saved_user_callback_list);
 
+        if (iotHubClientInstance->work_signal != NULL)
+        {
+            Condition_Deinit(iotHubClientInstance->work_signal);
+        }
+        if (iotHubClientInstance->send_queue_room != NULL)
+        {
+            Condition_Deinit(iotHubClientInstance->send_queue_room);
+        }
         if (iotHubClientInstance->TransportHandle == NULL)
         {
             /* Codes_SRS_IOTHUBCLIENT_01_032: [If the lock was allocated in IoTHubClient_Create, it shall be also freed..] */
@@ -1306,7 +1516,69 @@ void IoTHubClientCore_Destroy(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle)
     }
 }
 
-IOTHUB_CLIENT_RESULT IoTHubClientCore_SendEventAsync(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+//
+// is_callback_thread tells whether the calling thread runs the client's callbacks. That thread also drives the DoWork
+// which makes room in the send queue (the client's worker thread, or the worker thread of a shared transport), or is a
+// dispatch thread that only ever runs user code from callbacks. Without a thread id the client can only tell that its
+// callbacks are being dispatched, so every send made meanwhile is treated as coming from one of them. Must be called
+// with LockHandle held.
+//
+static bool is_callback_thread(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance)
+{
+#ifdef IOTHUB_THREAD_ID_AVAILABLE
+    return iotHubClientInstance->has_callback_thread && IOTHUB_THREAD_ID_EQUAL(iotHubClientInstance->callback_thread, IOTHUB_THREAD_ID_CURRENT());
+#else
+    return iotHubClientInstance->dispatching_user_callbacks;
+#endif
+}
+
+//
+// send_event_to_ll hands a message to the LL layer. With IOTHUB_CLIENT_SEND_QUEUE_FULL_BLOCK it waits on send_queue_room
+// while the send queue is full, which gives up the lock so the worker thread can drain the queue, and retries once a send
+// completed. A send made from a user callback does not wait, since the callback runs on the thread that would have to
+// make room. Must be called with LockHandle held.
+//
+static IOTHUB_CLIENT_RESULT send_event_to_ll(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback, bool takeOwnership)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    while (true)
+    {
+        COND_RESULT wait_result;
+
+        result = takeOwnership ?
+            IoTHubClientCore_LL_SendEventAsyncTakeOwnership(iotHubClientInstance->IoTHubClientLLHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback) :
+            IoTHubClientCore_LL_SendEventAsync(iotHubClientInstance->IoTHubClientLLHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+
+        if ((result != IOTHUB_CLIENT_QUEUE_FULL) || !iotHubClientInstance->block_when_send_queue_full || iotHubClientInstance->StopThread)
+        {
+            break;
+        }
+
+        if (is_callback_thread(iotHubClientInstance))
+        {
+            LogError("send queue is full, not waiting for room from a user callback");
+            break;
+        }
+
+        // Without a count the wait still ends after EVENT_DRIVEN_MAX_WAIT_MS.
+        (void)get_completed_sends(iotHubClientInstance, &iotHubClientInstance->send_queue_completed_when_full);
+        iotHubClientInstance->send_queue_waiters++;
+        signal_worker_thread(iotHubClientInstance);
+        wait_result = Condition_Wait(iotHubClientInstance->send_queue_room, iotHubClientInstance->LockHandle, EVENT_DRIVEN_MAX_WAIT_MS);
+        iotHubClientInstance->send_queue_waiters--;
+        if (wait_result == COND_ERROR)
+        {
+            LogError("failed waiting for room in the send queue");
+            result = IOTHUB_CLIENT_ERROR;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static IOTHUB_CLIENT_RESULT send_event_async(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback, bool takeOwnership)
 {
     IOTHUB_CLIENT_RESULT result;
 
@@ -1340,7 +1612,7 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_SendEventAsync(IOTHUB_CLIENT_CORE_HANDLE i
             {
                 if (iotHubClientInstance->created_with_transport_handle != 0 || eventConfirmationCallback == NULL)
                 {
-                    result = IoTHubClientCore_LL_SendEventAsync(iotHubClientInstance->IoTHubClientLLHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+                    result = send_event_to_ll(iotHubClientInstance, eventMessageHandle, eventConfirmationCallback, userContextCallback, takeOwnership);
                 }
                 else
                 {
@@ -1358,7 +1630,7 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_SendEventAsync(IOTHUB_CLIENT_CORE_HANDLE i
                         queue_context->callbackFunction.eventConfirmationCallback = eventConfirmationCallback;
                         /* Codes_SRS_IOTHUBCLIENT_01_012: [IoTHubClient_SendEventAsync shall call IoTHubClientCore_LL_SendEventAsync, while passing the IoTHubClientCore_LL handle created by IoTHubClient_Create and the parameters eventMessageHandle, eventConfirmationCallback and userContextCallback.] */
                         /* Codes_SRS_IOTHUBCLIENT_01_013: [When IoTHubClientCore_LL_SendEventAsync is called, IoTHubClient_SendEventAsync shall return the result of IoTHubClientCore_LL_SendEventAsync.] */
-                        result = IoTHubClientCore_LL_SendEventAsync(iotHubClientInstance->IoTHubClientLLHandle, eventMessageHandle, iothub_ll_event_confirm_callback, queue_context);
+                        result = send_event_to_ll(iotHubClientInstance, eventMessageHandle, iothub_ll_event_confirm_callback, queue_context, takeOwnership);
                         if (result != IOTHUB_CLIENT_OK)
                         {
                             LogError("IoTHubClientCore_LL_SendEventAsync failed");
@@ -1367,6 +1639,11 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_SendEventAsync(IOTHUB_CLIENT_CORE_HANDLE i
                     }
                 }
 
+                if (result == IOTHUB_CLIENT_OK)
+                {
+                    signal_worker_thread(iotHubClientInstance);
+                }
+
                 /* Codes_SRS_IOTHUBCLIENT_01_025: [IoTHubClient_SendEventAsync shall be made thread-safe by using the lock created in IoTHubClient_Create.] */
                 (void)Unlock(iotHubClientInstance->LockHandle);
             }
@@ -1376,6 +1653,16 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_SendEventAsync(IOTHUB_CLIENT_CORE_HANDLE i
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClientCore_SendEventAsync(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    return send_event_async(iotHubClientHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback, false);
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClientCore_SendEventAsyncTakeOwnership(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    return send_event_async(iotHubClientHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback, true);
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClientCore_GetSendStatus(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle, IOTHUB_CLIENT_STATUS *iotHubClientStatus)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -1411,6 +1698,34 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_GetSendStatus(IOTHUB_CLIENT_CORE_HANDLE io
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClientCore_GetStatistics(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle, IOTHUB_CLIENT_STATISTICS* statistics)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (iotHubClientHandle == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("NULL iothubClientHandle");
+    }
+    else
+    {
+        IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_CORE_INSTANCE*)iotHubClientHandle;
+
+        if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not acquire lock");
+        }
+        else
+        {
+            result = IoTHubClientCore_LL_GetStatistics(iotHubClientInstance->IoTHubClientLLHandle, statistics);
+            (void)Unlock(iotHubClientInstance->LockHandle);
+        }
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClientCore_SetMessageCallback(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC messageCallback, void* userContextCallback)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -1570,6 +1885,56 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_SetConnectionStatusCallback(IOTHUB_CLIENT_
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClientCore_SetSendQueueCallback(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle, IOTHUB_CLIENT_SEND_QUEUE_CALLBACK sendQueueCallback, void* userContextCallback)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (iotHubClientHandle == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("NULL iothubClientHandle");
+    }
+    else
+    {
+        IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_CORE_INSTANCE*)iotHubClientHandle;
+
+        if ((result = StartWorkerThreadIfNeeded(iotHubClientInstance)) != IOTHUB_CLIENT_OK)
+        {
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not start worker thread");
+        }
+        else if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not acquire lock");
+        }
+        else
+        {
+            if (iotHubClientInstance->created_with_transport_handle != 0 || sendQueueCallback == NULL)
+            {
+                result = IoTHubClientCore_LL_SetSendQueueCallback(iotHubClientInstance->IoTHubClientLLHandle, sendQueueCallback, userContextCallback);
+            }
+            else
+            {
+                // The LL callback only queues the state change, the user callback runs from dispatch_user_callbacks.
+                result = IoTHubClientCore_LL_SetSendQueueCallback(iotHubClientInstance->IoTHubClientLLHandle, iothub_ll_send_queue_callback, iotHubClientInstance);
+            }
+
+            if (result != IOTHUB_CLIENT_OK)
+            {
+                LogError("IoTHubClientCore_LL_SetSendQueueCallback failed");
+            }
+            else
+            {
+                iotHubClientInstance->send_queue_callback = sendQueueCallback;
+                iotHubClientInstance->send_queue_user_context = userContextCallback;
+            }
+            (void)Unlock(iotHubClientInstance->LockHandle);
+        }
+    }
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClientCore_SetRetryPolicy(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitInSeconds)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -1743,6 +2108,70 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_SetOption(IOTHUB_CLIENT_CORE_HANDLE iotHub
                     LogError("Invalid value: OPTION_DO_WORK_FREQUENCY_IN_MS cannot exceed %d ms. If you wish to reduce the frequency further, consider using the LL layer.", DO_WORK_MAXIMUM_ALLOWED_FREQUENCY);
                 }
             }
+            else if (strcmp(OPTION_EVENT_DRIVEN_DO_WORK, optionName) == 0)
+            {
+                bool event_driven = *(const bool*)value;
+                if (iotHubClientInstance->TransportHandle != NULL)
+                {
+                    // Shared transports are serviced by the transport worker thread, which owns the wait.
+                    result = IoTHubTransport_SetEventDrivenDoWork(iotHubClientInstance->TransportHandle, event_driven);
+                }
+                else if (event_driven && (iotHubClientInstance->work_signal == NULL) && ((iotHubClientInstance->work_signal = Condition_Init()) == NULL))
+                {
+                    result = IOTHUB_CLIENT_ERROR;
+                    LogError("Failed creating condition for event driven worker thread");
+                }
+                else
+                {
+                    result = IOTHUB_CLIENT_OK;
+                }
+
+                if (result == IOTHUB_CLIENT_OK)
+                {
+                    iotHubClientInstance->event_driven_do_work = event_driven;
+                    if (iotHubClientInstance->work_signal != NULL)
+                    {
+                        // Wake a waiting worker thread so it picks up the new mode.
+                        iotHubClientInstance->work_signaled = true;
+                        (void)Condition_Post(iotHubClientInstance->work_signal);
+                    }
+                }
+                else
+                {
+                    LogError("Failed setting OPTION_EVENT_DRIVEN_DO_WORK");
+                }
+            }
+            else if (strcmp(OPTION_MULTIPLEXED_DISPATCH_THREADS, optionName) == 0)
+            {
+                if (iotHubClientInstance->TransportHandle == NULL)
+                {
+                    result = IOTHUB_CLIENT_INVALID_ARG;
+                    LogError("OPTION_MULTIPLEXED_DISPATCH_THREADS only applies to clients sharing a transport");
+                }
+                else if ((result = IoTHubTransport_SetDispatchThreadCount(iotHubClientInstance->TransportHandle, *(const size_t*)value)) != IOTHUB_CLIENT_OK)
+                {
+                    LogError("Failed setting OPTION_MULTIPLEXED_DISPATCH_THREADS");
+                }
+            }
+            else if (strcmp(OPTION_SEND_QUEUE_FULL_POLICY, optionName) == 0)
+            {
+                // Blocking is done here, the LL layer fails with IOTHUB_CLIENT_QUEUE_FULL and send_event_to_ll retries.
+                IOTHUB_CLIENT_SEND_QUEUE_FULL_POLICY policy = *(const IOTHUB_CLIENT_SEND_QUEUE_FULL_POLICY*)value;
+                IOTHUB_CLIENT_SEND_QUEUE_FULL_POLICY ll_policy = (policy == IOTHUB_CLIENT_SEND_QUEUE_FULL_BLOCK) ? IOTHUB_CLIENT_SEND_QUEUE_FULL_FAIL : policy;
+                if ((policy == IOTHUB_CLIENT_SEND_QUEUE_FULL_BLOCK) && (iotHubClientInstance->send_queue_room == NULL) && ((iotHubClientInstance->send_queue_room = Condition_Init()) == NULL))
+                {
+                    result = IOTHUB_CLIENT_ERROR;
+                    LogError("Failed creating condition for the send queue");
+                }
+                else if ((result = IoTHubClientCore_LL_SetOption(iotHubClientInstance->IoTHubClientLLHandle, optionName, &ll_policy)) != IOTHUB_CLIENT_OK)
+                {
+                    LogError("IoTHubClientCore_LL_SetOption failed");
+                }
+                else
+                {
+                    iotHubClientInstance->block_when_send_queue_full = (policy == IOTHUB_CLIENT_SEND_QUEUE_FULL_BLOCK);
+                }
+            }
             /* Codes_SRS_IOTHUBCLIENT_41_005: [ If parameter `optionName` is `OPTION_MESSAGE_TIMEOUT` then `IoTHubClientCore_SetOption` shall set `currentMessageTimeout` parameter of `IoTHubClientInstance` ]*/
             else if (strcmp(OPTION_MESSAGE_TIMEOUT, optionName) == 0)
             {
@@ -1920,6 +2349,11 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_SendReportedState(IOTHUB_CLIENT_CORE_HANDL
                     }
                 }
 
+                if (result == IOTHUB_CLIENT_OK)
+                {
+                    signal_worker_thread(iotHubClientInstance);
+                }
+
                 (void)Unlock(iotHubClientInstance->LockHandle);
             }
         }
@@ -1982,6 +2416,10 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_GetTwinAsync(IOTHUB_CLIENT_CORE_HANDLE iot
                         LogError("IoTHubClientCore_LL_GetTwinAsync failed");
                         free(queueContext);
                     }
+                    else
+                    {
+                        signal_worker_thread(iotHubClientInstance);
+                    }
 
                     (void)Unlock(iotHubClientInstance->LockHandle);
                 }
@@ -2161,6 +2599,10 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_DeviceMethodResponse(IOTHUB_CLIENT_CORE_HA
             {
                 LogError("IoTHubClientCore_LL_DeviceMethodResponse failed");
             }
+            else
+            {
+                signal_worker_thread(iotHubClientInstance);
+            }
             (void)Unlock(iotHubClientInstance->LockHandle);
         }
     }
@@ -26,6 +26,8 @@
 #include "internal/iothub_client_private.h"
 #include "internal/iothub_client_diagnostic.h"
 #include "internal/iothubtransport.h"
+#include "internal/persistent_queue.h"
+#include "internal/iothub_message_pool.h"
 
 #ifndef DONT_USE_UPLOADTOBLOB
 #include "internal/iothub_client_ll_uploadtoblob.h"
@@ -97,6 +99,23 @@ typedef struct GET_TWIN_CONTEXT_TAG
     void* context;
 } GET_TWIN_CONTEXT;
 
+#define PERSISTENT_QUEUE_DEFAULT_SEGMENT_SIZE 1048576
+#define PERSISTENT_QUEUE_DEFAULT_RAM_MESSAGES 100
+#define PERSISTENT_QUEUE_DEFAULT_SYNC_INTERVAL 1000
+
+struct IOTHUB_CLIENT_CORE_LL_HANDLE_DATA_TAG;
+
+/*a message stored in the persistent queue. Kept from persistent_queue_append until the record is read back only when there is a
+confirmation callback to call, then used as the context of the message queued from the record*/
+typedef struct PERSISTED_MESSAGE_TAG
+{
+    struct IOTHUB_CLIENT_CORE_LL_HANDLE_DATA_TAG* handleData;
+    uint64_t record_id;
+    IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK callback;
+    void* context;
+    struct PERSISTED_MESSAGE_TAG* next;
+} PERSISTED_MESSAGE;
+
 typedef struct IOTHUB_CLIENT_CORE_LL_HANDLE_DATA_TAG
 {
     DLIST_ENTRY waitingToSend;
@@ -113,6 +132,10 @@ typedef struct IOTHUB_CLIENT_CORE_LL_HANDLE_DATA_TAG
     time_t lastMessageReceiveTime;
     TICK_COUNTER_HANDLE tickCounter; /*shared tickcounter used to track message timeouts in waitingToSend list*/
     tickcounter_ms_t currentMessageTimeout;
+    DLIST_ENTRY timeout_index; /*messages with a timeout, ordered by deadline and linked through their timeout_entry*/
+    DLIST_ENTRY overdue_messages; /*messages whose deadline passed while the transport had them, linked through their timeout_entry*/
+    uint64_t overdue_max_sequence; /*upper bound of the send_sequence of overdue_messages*/
+    uint64_t next_send_sequence;
     uint64_t current_device_twin_timeout;
     IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK deviceTwinCallback;
     void* deviceTwinContextCallback;
@@ -131,6 +154,31 @@ typedef struct IOTHUB_CLIENT_CORE_LL_HANDLE_DATA_TAG
     IOTHUB_DIAGNOSTIC_SETTING_DATA diagnostic_setting;
     SINGLYLINKEDLIST_HANDLE event_callbacks;  // List of IOTHUB_EVENT_CALLBACK's
     STRING_HANDLE model_id;
+    IOTHUB_MESSAGE_LIST* message_node_pool; /*optional block the waitingToSend entries are taken from, see OPTION_MESSAGE_NODE_POOL_SIZE*/
+    size_t message_node_pool_size;
+    size_t message_node_pool_in_use;
+    PDLIST_ENTRY message_node_free_list; /*unused entries of message_node_pool, chained through entry.Flink*/
+    IOTHUB_MESSAGE_POOL_HANDLE message_pool; /*headers and system property strings of the messages cloned by SendEventAsync, sized like message_node_pool*/
+    bool collect_statistics; /*see OPTION_TELEMETRY_STATISTICS*/
+    IOTHUB_CLIENT_STATISTICS statistics; /*running counters, IoTHubClientCore_LL_GetStatistics only copies them*/
+    size_t send_queue_max_messages; /*see OPTION_SEND_QUEUE_MAX_MESSAGES, 0 means no limit*/
+    size_t send_queue_max_bytes; /*see OPTION_SEND_QUEUE_MAX_BYTES, 0 means no limit*/
+    IOTHUB_CLIENT_SEND_QUEUE_FULL_POLICY send_queue_full_policy;
+    size_t send_queue_messages; /*messages accepted by SendEventAsync whose confirmation callback has not run yet*/
+    size_t send_queue_bytes; /*sum of payload_size of the above*/
+    bool send_queue_high_watermark_reached;
+    IOTHUB_CLIENT_SEND_QUEUE_CALLBACK sendQueueCallback;
+    void* sendQueueUserContextCallback;
+    PERSISTENT_QUEUE_HANDLE persistent_queue; /*see OPTION_PERSISTENT_QUEUE_PATH, NULL when messages are only kept in memory*/
+    size_t persistent_queue_segment_size;
+    size_t persistent_queue_ram_messages;
+    tickcounter_ms_t persistent_queue_sync_interval;
+    tickcounter_ms_t persistent_queue_last_sync;
+    PERSISTED_MESSAGE* persisted_oldest; /*appended messages not read back yet, in record order*/
+    PERSISTED_MESSAGE* persisted_newest;
+    bool replaying_persisted_messages;
+    IOTHUB_MESSAGE_HANDLE replay_pending_message; /*read back from the persistent queue but not queued yet because the send queue was full*/
+    PERSISTED_MESSAGE* replay_pending;
 }IOTHUB_CLIENT_CORE_LL_HANDLE_DATA;
 
 static const char HOSTNAME_TOKEN[] = "HostName";
@@ -294,6 +342,7 @@ static void setTransportProtocol(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData,
     handleData->IoTHubTransport_Unsubscribe_InputQueue = protocol->IoTHubTransport_Unsubscribe_InputQueue;
     handleData->IoTHubTransport_SetCallbackContext = protocol->IoTHubTransport_SetCallbackContext;
     handleData->IoTHubTransport_GetSupportedPlatformInfo = protocol->IoTHubTransport_GetSupportedPlatformInfo;
+    handleData->IoTHubTransport_OnEventQueued = protocol->IoTHubTransport_OnEventQueued;
 }
 
 static bool is_event_equal(IOTHUB_EVENT_CALLBACK *event_callback, const char *input_name)
@@ -489,6 +538,356 @@ static STRING_HANDLE make_product_info(const char* product, PLATFORM_INFO_OPTION
     return result;
 }
 
+/*returns an entry for waitingToSend, taken from message_node_pool if one is free and from the heap otherwise*/
+static IOTHUB_MESSAGE_LIST* allocate_message_node(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData)
+{
+    IOTHUB_MESSAGE_LIST* result;
+    if (handleData->message_node_free_list != NULL)
+    {
+        result = containingRecord(handleData->message_node_free_list, IOTHUB_MESSAGE_LIST, entry);
+        handleData->message_node_free_list = result->entry.Flink;
+        handleData->message_node_pool_in_use++;
+    }
+    else
+    {
+        result = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST));
+    }
+    return result;
+}
+
+/*gives back an entry obtained from allocate_message_node*/
+static void release_message_node(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_LIST* node)
+{
+    if ((handleData->message_node_pool != NULL) &&
+        (node >= handleData->message_node_pool) &&
+        (node < handleData->message_node_pool + handleData->message_node_pool_size))
+    {
+        node->entry.Flink = handleData->message_node_free_list;
+        handleData->message_node_free_list = &(node->entry);
+        handleData->message_node_pool_in_use--;
+    }
+    else
+    {
+        free(node);
+    }
+}
+
+/*replaces message_node_pool and message_pool with pools of pool_size entries, 0 meaning no pool. Returns 0 on success*/
+static int set_message_node_pool_size(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, size_t pool_size)
+{
+    int result;
+    if (handleData->message_node_pool_in_use != 0)
+    {
+        LogError("cannot resize the message node pool while %lu of its entries are in use", (unsigned long)handleData->message_node_pool_in_use);
+        result = MU_FAILURE;
+    }
+    else if (pool_size > SIZE_MAX / sizeof(IOTHUB_MESSAGE_LIST))
+    {
+        LogError("message node pool size %lu is too large", (unsigned long)pool_size);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        IOTHUB_MESSAGE_LIST* new_pool;
+        IOTHUB_MESSAGE_POOL_HANDLE new_message_pool;
+        if (pool_size == 0)
+        {
+            new_pool = NULL;
+            new_message_pool = NULL;
+            result = 0;
+        }
+        else if ((new_pool = (IOTHUB_MESSAGE_LIST*)malloc(pool_size * sizeof(IOTHUB_MESSAGE_LIST))) == NULL)
+        {
+            LogError("failure allocating message node pool of %lu entries", (unsigned long)pool_size);
+            result = MU_FAILURE;
+        }
+        else if ((new_message_pool = IoTHubMessage_CreatePool(pool_size)) == NULL)
+        {
+            LogError("failure creating message pool of %lu messages", (unsigned long)pool_size);
+            free(new_pool);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = 0;
+        }
+
+        if (result == 0)
+        {
+            size_t index;
+            free(handleData->message_node_pool);
+            if (handleData->message_pool != NULL)
+            {
+                /*messages still in the transport keep the old pool until they are destroyed*/
+                IoTHubMessage_DestroyPool(handleData->message_pool);
+            }
+            handleData->message_pool = new_message_pool;
+            handleData->message_node_pool = new_pool;
+            handleData->message_node_pool_size = pool_size;
+            handleData->message_node_free_list = NULL;
+            for (index = pool_size; index > 0; index--)
+            {
+                new_pool[index - 1].entry.Flink = handleData->message_node_free_list;
+                handleData->message_node_free_list = &(new_pool[index - 1].entry);
+            }
+        }
+    }
+    return result;
+}
+
+/*clones a message sent with SendEventAsync, from message_pool when OPTION_MESSAGE_NODE_POOL_SIZE set one*/
+static IOTHUB_MESSAGE_HANDLE clone_event_message(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_HANDLE eventMessageHandle)
+{
+    IOTHUB_MESSAGE_HANDLE result;
+    if (handleData->message_pool != NULL)
+    {
+        result = IoTHubMessage_CloneFromPool(eventMessageHandle, handleData->message_pool);
+    }
+    else
+    {
+        result = IoTHubMessage_Clone(eventMessageHandle);
+    }
+    return result;
+}
+
+/*returns the payload size of a message, 0 if it cannot be determined*/
+static size_t get_message_payload_size(IOTHUB_MESSAGE_HANDLE messageHandle)
+{
+    size_t result = 0;
+    IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(messageHandle);
+    if (contentType == IOTHUBMESSAGE_BYTEARRAY)
+    {
+        const unsigned char* buffer;
+        if (IoTHubMessage_GetByteArray(messageHandle, &buffer, &result) != IOTHUB_MESSAGE_OK)
+        {
+            result = 0;
+        }
+    }
+    else if (contentType == IOTHUBMESSAGE_STRING)
+    {
+        const char* source = IoTHubMessage_GetString(messageHandle);
+        result = (source == NULL) ? 0 : strlen(source);
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+/*accounts for a message handed to IoTHubClientCore_LL_SendEventAsync, entry->payload_size has already been set*/
+static void record_enqueue_statistics(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_LIST* entry)
+{
+    handleData->statistics.messagesEnqueued++;
+    handleData->statistics.waitingToSendCount++;
+    if (handleData->collect_statistics)
+    {
+        if (tickcounter_get_current_ms(handleData->tickCounter, &entry->ms_enqueued) != 0)
+        {
+            LogError("unable to get the current ms, latency of this message will not be recorded");
+            entry->ms_enqueued = 0;
+        }
+        handleData->statistics.bytesEnqueued += entry->payload_size;
+    }
+    else
+    {
+        entry->ms_enqueued = 0;
+    }
+}
+
+/*accounts for a message whose confirmation callback is about to run; nowTick is only used when collecting statistics*/
+static void record_completion_statistics(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, const IOTHUB_MESSAGE_LIST* entry, IOTHUB_CLIENT_CONFIRMATION_RESULT result, tickcounter_ms_t nowTick)
+{
+    if (entry->send_attempts == 0)
+    {
+        if (handleData->statistics.waitingToSendCount > 0)
+        {
+            handleData->statistics.waitingToSendCount--;
+        }
+    }
+    else if (handleData->statistics.inFlightCount > 0)
+    {
+        handleData->statistics.inFlightCount--;
+    }
+
+    if (result == IOTHUB_CLIENT_CONFIRMATION_OK)
+    {
+        handleData->statistics.messagesConfirmed++;
+    }
+    else if (result == IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT)
+    {
+        handleData->statistics.messagesTimedOut++;
+    }
+    else
+    {
+        handleData->statistics.messagesFailed++;
+    }
+
+    if (handleData->collect_statistics)
+    {
+        if (result == IOTHUB_CLIENT_CONFIRMATION_OK)
+        {
+            handleData->statistics.bytesConfirmed += entry->payload_size;
+        }
+
+        if (entry->ms_enqueued != 0 && nowTick >= entry->ms_enqueued)
+        {
+            tickcounter_ms_t latency = nowTick - entry->ms_enqueued;
+            tickcounter_ms_t remaining = latency;
+            size_t bucket = 0;
+            while (remaining != 0 && bucket < IOTHUB_CLIENT_SEND_LATENCY_BUCKETS - 1)
+            {
+                remaining >>= 1;
+                bucket++;
+            }
+            handleData->statistics.sendLatencyHistogram[bucket]++;
+            if (latency > handleData->statistics.sendLatencyMaxMs)
+            {
+                handleData->statistics.sendLatencyMaxMs = latency;
+            }
+        }
+    }
+}
+
+static tickcounter_ms_t get_message_deadline(const IOTHUB_MESSAGE_LIST* entry)
+{
+    return entry->ms_timesOutAfter + entry->message_timeout_value;
+}
+
+/*links entry into timeout_index or overdue_messages, just before next*/
+static void link_timeout_entry(PDLIST_ENTRY next, IOTHUB_MESSAGE_LIST* entry)
+{
+    entry->timeout_entry.Flink = next;
+    entry->timeout_entry.Blink = next->Blink;
+    next->Blink->Flink = &(entry->timeout_entry);
+    next->Blink = &(entry->timeout_entry);
+}
+
+/*takes entry out of timeout_index or overdue_messages, if it is in either of them*/
+static void unlink_timeout_entry(IOTHUB_MESSAGE_LIST* entry)
+{
+    if (entry->timeout_entry.Flink != NULL)
+    {
+        entry->timeout_entry.Blink->Flink = entry->timeout_entry.Flink;
+        entry->timeout_entry.Flink->Blink = entry->timeout_entry.Blink;
+        entry->timeout_entry.Flink = NULL;
+    }
+}
+
+/*adds a message that has just been queued on waitingToSend to timeout_index. Messages normally all get the same timeout, so their
+deadlines come in send order and the walk back from the tail stops at once; it only goes further after messageTimeout was lowered*/
+static void add_to_timeout_index(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_LIST* entry)
+{
+    tickcounter_ms_t deadline = get_message_deadline(entry);
+    PDLIST_ENTRY next = &(handleData->timeout_index);
+    while ((next->Blink != &(handleData->timeout_index)) &&
+        (get_message_deadline(containingRecord(next->Blink, IOTHUB_MESSAGE_LIST, timeout_entry)) > deadline))
+    {
+        next = next->Blink;
+    }
+    link_timeout_entry(next, entry);
+}
+
+/*transports only take messages from the head of waitingToSend, and only ever hand them back to the head in their original order (see
+pfIotHubTransport_Register). So of the messages not completed yet, waitingToSend holds exactly those sent no earlier than its head, the
+others are in the transport*/
+static bool is_waiting_to_send(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, const IOTHUB_MESSAGE_LIST* entry)
+{
+    return (handleData->waitingToSend.Flink != &(handleData->waitingToSend)) &&
+        (entry->send_sequence >= containingRecord(handleData->waitingToSend.Flink, IOTHUB_MESSAGE_LIST, entry)->send_sequence);
+}
+
+/*takes an entry out of the send queue accounting and the timeout index, once its confirmation callback is about to run. The counters are
+clamped because a shared transport may complete messages queued by another client on this one*/
+static void remove_from_send_queue(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_LIST* entry)
+{
+    unlink_timeout_entry(entry);
+    handleData->send_queue_messages = (handleData->send_queue_messages > 0) ? handleData->send_queue_messages - 1 : 0;
+    handleData->send_queue_bytes = (handleData->send_queue_bytes > entry->payload_size) ? handleData->send_queue_bytes - entry->payload_size : 0;
+}
+
+/*calls the send queue callback when the send queue reaches one of its limits, and again once it has drained to half of every limit*/
+static void check_send_queue_watermarks(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData)
+{
+    if (!handleData->send_queue_high_watermark_reached)
+    {
+        if (((handleData->send_queue_max_messages != 0) && (handleData->send_queue_messages >= handleData->send_queue_max_messages)) ||
+            ((handleData->send_queue_max_bytes != 0) && (handleData->send_queue_bytes >= handleData->send_queue_max_bytes)))
+        {
+            handleData->send_queue_high_watermark_reached = true;
+            if (handleData->sendQueueCallback != NULL)
+            {
+                handleData->sendQueueCallback(IOTHUB_CLIENT_SEND_QUEUE_HIGH_WATERMARK, handleData->sendQueueUserContextCallback);
+            }
+        }
+    }
+    else if (((handleData->send_queue_max_messages == 0) || (handleData->send_queue_messages <= handleData->send_queue_max_messages / 2)) &&
+        ((handleData->send_queue_max_bytes == 0) || (handleData->send_queue_bytes <= handleData->send_queue_max_bytes / 2)))
+    {
+        handleData->send_queue_high_watermark_reached = false;
+        if (handleData->sendQueueCallback != NULL)
+        {
+            handleData->sendQueueCallback(IOTHUB_CLIENT_SEND_QUEUE_LOW_WATERMARK, handleData->sendQueueUserContextCallback);
+        }
+    }
+}
+
+/*returns true if one more message of payload_size bytes does not fit in the send queue*/
+static bool is_send_queue_full(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, size_t messages, size_t bytes, size_t payload_size)
+{
+    return ((handleData->send_queue_max_messages != 0) && (messages >= handleData->send_queue_max_messages)) ||
+        ((handleData->send_queue_max_bytes != 0) && (bytes + payload_size > handleData->send_queue_max_bytes));
+}
+
+/*makes room for a message of payload_size bytes according to send_queue_full_policy. Dropped entries are chained through
+entry.Flink onto *dropped, their callbacks are left to the caller so they do not run before the new message is queued.
+Returns 0 if the message fits*/
+static int make_room_in_send_queue(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, size_t payload_size, PDLIST_ENTRY* dropped)
+{
+    int result;
+    if (!is_send_queue_full(handleData, handleData->send_queue_messages, handleData->send_queue_bytes, payload_size))
+    {
+        result = 0;
+    }
+    else if ((handleData->send_queue_full_policy != IOTHUB_CLIENT_SEND_QUEUE_FULL_DROP_OLDEST) || handleData->replaying_persisted_messages)
+    {
+        /*a replayed message waits for room instead of dropping the ones replayed before it*/
+        result = MU_FAILURE;
+    }
+    else
+    {
+        /*only messages the transport has not picked up yet can be dropped, find out first whether that is enough*/
+        size_t messages = handleData->send_queue_messages;
+        size_t bytes = handleData->send_queue_bytes;
+        PDLIST_ENTRY stop = handleData->waitingToSend.Flink;
+        while ((stop != &(handleData->waitingToSend)) && is_send_queue_full(handleData, messages, bytes, payload_size))
+        {
+            messages--;
+            bytes -= containingRecord(stop, IOTHUB_MESSAGE_LIST, entry)->payload_size;
+            stop = stop->Flink;
+        }
+
+        if (is_send_queue_full(handleData, messages, bytes, payload_size))
+        {
+            result = MU_FAILURE;
+        }
+        else
+        {
+            PDLIST_ENTRY* tail = dropped;
+            while (handleData->waitingToSend.Flink != stop)
+            {
+                PDLIST_ENTRY oldest = DList_RemoveHeadList(&(handleData->waitingToSend));
+                remove_from_send_queue(handleData, containingRecord(oldest, IOTHUB_MESSAGE_LIST, entry));
+                oldest->Flink = NULL;
+                *tail = oldest;
+                tail = &(oldest->Flink);
+            }
+            result = 0;
+        }
+    }
+    return result;
+}
+
 static void IoTHubClientCore_LL_SendComplete(PDLIST_ENTRY completed, IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* ctx)
 {
     /*Codes_SRS_IOTHUBCLIENT_LL_02_022: [If parameter completed is NULL, or parameter handle is NULL then IoTHubClientCore_LL_SendBatch shall return.]*/
@@ -502,19 +901,83 @@ static void IoTHubClientCore_LL_SendComplete(PDLIST_ENTRY completed, IOTHUB_CLIE
     }
     else
     {
+        IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)ctx;
+        tickcounter_ms_t nowTick = 0;
+        if (handleData->collect_statistics && tickcounter_get_current_ms(handleData->tickCounter, &nowTick) != 0)
+        {
+            LogError("unable to get the current ms, latency of the completed messages will not be recorded");
+            nowTick = 0;
+        }
         /*Codes_SRS_IOTHUBCLIENT_LL_02_027: [If parameter result is IOTHUB_CLIENT_CONFIRMATION_ERROR then IoTHubClientCore_LL_SendComplete shall call all the non-NULL callbacks with the result parameter set to IOTHUB_CLIENT_CONFIRMATION_ERROR and the context set to the context passed originally in the SendEventAsync call.] */
         /*Codes_SRS_IOTHUBCLIENT_LL_02_025: [If parameter result is IOTHUB_CLIENT_CONFIRMATION_OK then IoTHubClientCore_LL_SendComplete shall call all the non-NULL callbacks with the result parameter set to IOTHUB_CLIENT_CONFIRMATION_OK and the context set to the context passed originally in the SendEventAsync call.]*/
         PDLIST_ENTRY oldest;
         while ((oldest = DList_RemoveHeadList(completed)) != completed)
         {
             IOTHUB_MESSAGE_LIST* messageList = (IOTHUB_MESSAGE_LIST*)containingRecord(oldest, IOTHUB_MESSAGE_LIST, entry);
+            /*with a shared transport ctx is the last registered client, the message is accounted to the client that queued it*/
+            IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* owner = messageList->client_handle;
+            tickcounter_ms_t ownerTick = nowTick;
+            if (owner != handleData && owner->collect_statistics && tickcounter_get_current_ms(owner->tickCounter, &ownerTick) != 0)
+            {
+                LogError("unable to get the current ms, latency of the completed message will not be recorded");
+                ownerTick = 0;
+            }
+            record_completion_statistics(owner, messageList, result, ownerTick);
+            remove_from_send_queue(owner, messageList);
             /*Codes_SRS_IOTHUBCLIENT_LL_02_026: [If any callback is NULL then there shall not be a callback call.]*/
             if (messageList->callback != NULL)
             {
                 messageList->callback(result, messageList->context);
             }
             IoTHubMessage_Destroy(messageList->messageHandle);
-            free(messageList);
+            release_message_node(owner, messageList);
+        }
+        check_send_queue_watermarks(handleData);
+    }
+}
+
+static void IoTHubClientCore_LL_EventSent(IOTHUB_MESSAGE_LIST* message, size_t bytes_sent)
+{
+    if (message == NULL)
+    {
+        LogError("invalid arg");
+    }
+    else
+    {
+        IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = message->client_handle;
+        if (message->send_attempts == 0)
+        {
+            handleData->statistics.messagesSent++;
+            if (handleData->statistics.waitingToSendCount > 0)
+            {
+                handleData->statistics.waitingToSendCount--;
+            }
+            handleData->statistics.inFlightCount++;
+        }
+        else if (message->send_attempts == 1)
+        {
+            handleData->statistics.messagesRetried++;
+        }
+        message->send_attempts++;
+        handleData->statistics.bytesSent += bytes_sent;
+    }
+}
+
+static void IoTHubClientCore_LL_EventBatchSent(size_t message_count, size_t payload_bytes, void* ctx)
+{
+    if (ctx == NULL)
+    {
+        LogError("invalid arg");
+    }
+    else
+    {
+        IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)ctx;
+        handleData->statistics.publishBatches++;
+        handleData->statistics.lastPublishBatchMessages = message_count;
+        handleData->statistics.lastPublishBatchBytes = payload_bytes;
+        if (message_count > handleData->statistics.maxPublishBatchMessages)
+        {
+            handleData->statistics.maxPublishBatchMessages = message_count;
         }
     }
 }
@@ -847,6 +1310,8 @@ static IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* initialize_iothub_client(const IOTHUB_
             transport_cb.msg_cb = IoTHubClientCore_LL_MessageCallback;
             transport_cb.method_complete_cb = IoTHubClientCore_LL_DeviceMethodComplete;
             transport_cb.get_model_id_cb = IoTHubClientCore_LL_GetModelId;
+            transport_cb.event_sent_cb = IoTHubClientCore_LL_EventSent;
+            transport_cb.event_batch_sent_cb = IoTHubClientCore_LL_EventBatchSent;
 
             if (client_config != NULL)
             {
@@ -1039,6 +1504,8 @@ static IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* initialize_iothub_client(const IOTHUB_
                     DList_InitializeListHead(&(result->waitingToSend));
                     DList_InitializeListHead(&(result->iot_msg_queue));
                     DList_InitializeListHead(&(result->iot_ack_queue));
+                    result->timeout_index.Flink = result->timeout_index.Blink = &(result->timeout_index);
+                    result->overdue_messages.Flink = result->overdue_messages.Blink = &(result->overdue_messages);
                     result->messageCallback.type = CALLBACK_TYPE_NONE;
                     result->methodCallback.type = CALLBACK_TYPE_NONE;
                     result->lastMessageReceiveTime = INDEFINITE_TIME;
@@ -1073,6 +1540,9 @@ static IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* initialize_iothub_client(const IOTHUB_
                         /*Codes_SRS_IOTHUBCLIENT_LL_02_042: [ By default, messages shall not timeout. ]*/
                         result->currentMessageTimeout = 0;
                         result->current_device_twin_timeout = 0;
+                        result->persistent_queue_segment_size = PERSISTENT_QUEUE_DEFAULT_SEGMENT_SIZE;
+                        result->persistent_queue_ram_messages = PERSISTENT_QUEUE_DEFAULT_RAM_MESSAGES;
+                        result->persistent_queue_sync_interval = PERSISTENT_QUEUE_DEFAULT_SYNC_INTERVAL;
 
                         result->diagnostic_setting.currentMessageNumber = 0;
                         result->diagnostic_setting.diagSamplingPercentage = 0;
@@ -1739,7 +2209,40 @@ void IoTHubClientCore_LL_Destroy(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle
                 temp->callback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, temp->context);
             }
             IoTHubMessage_Destroy(temp->messageHandle);
-            free(temp);
+            release_message_node(handleData, temp);
+        }
+        if (handleData->message_node_pool != NULL)
+        {
+            free(handleData->message_node_pool);
+        }
+        if (handleData->message_pool != NULL)
+        {
+            IoTHubMessage_DestroyPool(handleData->message_pool);
+        }
+        if (handleData->persistent_queue != NULL)
+        {
+            /*messages still on disk are sent after the next start, without their confirmation callback*/
+            if (handleData->replay_pending_message != NULL)
+            {
+                if (handleData->replay_pending->callback != NULL)
+                {
+                    handleData->replay_pending->callback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, handleData->replay_pending->context);
+                }
+                IoTHubMessage_Destroy(handleData->replay_pending_message);
+                free(handleData->replay_pending);
+            }
+            while (handleData->persisted_oldest != NULL)
+            {
+                PERSISTED_MESSAGE* persisted = handleData->persisted_oldest;
+                handleData->persisted_oldest = persisted->next;
+                persisted->callback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, persisted->context);
+                free(persisted);
+            }
+            if (persistent_queue_sync(handleData->persistent_queue) != 0)
+            {
+                LogError("unable to sync the persistent queue, confirmed messages may be sent again");
+            }
+            persistent_queue_destroy(handleData->persistent_queue);
         }
 
         /* Codes_SRS_IOTHUBCLIENT_LL_07_007: [ IoTHubClientCore_LL_Destroy shall iterate the device twin queues and destroy any remaining items. ] */
@@ -1819,7 +2322,54 @@ static int attach_ms_timesOutAfter(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData
     return result;
 }
 
-IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SendEventAsync(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+/*appends eventMessageHandle to the persistent queue, to be queued on waitingToSend by replay_persisted_messages*/
+static IOTHUB_CLIENT_RESULT persist_event(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback, bool takeOwnership)
+{
+    IOTHUB_CLIENT_RESULT result;
+    PERSISTED_MESSAGE* persisted = NULL;
+    uint64_t record_id;
+    if ((eventConfirmationCallback != NULL) && ((persisted = (PERSISTED_MESSAGE*)malloc(sizeof(PERSISTED_MESSAGE))) == NULL))
+    {
+        result = IOTHUB_CLIENT_ERROR;
+        LOG_ERROR_RESULT;
+    }
+    else if (persistent_queue_append(handleData->persistent_queue, eventMessageHandle, &record_id) != 0)
+    {
+        free(persisted);
+        result = IOTHUB_CLIENT_ERROR;
+        LOG_ERROR_RESULT;
+    }
+    else
+    {
+        if (persisted != NULL)
+        {
+            memset(persisted, 0, sizeof(PERSISTED_MESSAGE));
+            persisted->handleData = handleData;
+            persisted->record_id = record_id;
+            persisted->callback = eventConfirmationCallback;
+            persisted->context = userContextCallback;
+            if (handleData->persisted_newest == NULL)
+            {
+                handleData->persisted_oldest = persisted;
+            }
+            else
+            {
+                handleData->persisted_newest->next = persisted;
+            }
+            handleData->persisted_newest = persisted;
+        }
+        if (takeOwnership)
+        {
+            IoTHubMessage_Destroy(eventMessageHandle);
+        }
+        result = IOTHUB_CLIENT_OK;
+    }
+    return result;
+}
+
+/*queues eventMessageHandle on waitingToSend, or on the persistent queue once persistent_queue_ram_messages messages are outstanding.
+With takeOwnership the handle itself is queued instead of a clone of it; the caller keeps ownership of the handle if this fails*/
+static IOTHUB_CLIENT_RESULT send_event_async(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback, bool takeOwnership)
 {
     IOTHUB_CLIENT_RESULT result;
     /*Codes_SRS_IOTHUBCLIENT_LL_02_011: [IoTHubClientCore_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter iotHubClientHandle or eventMessageHandle is NULL.]*/
@@ -1835,37 +2385,58 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SendEventAsync(IOTHUB_CLIENT_CORE_LL_HA
     }
     else
     {
-        IOTHUB_MESSAGE_LIST *newEntry = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST));
-        if (newEntry == NULL)
+        IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)iotHubClientHandle;
+        IOTHUB_MESSAGE_LIST *newEntry;
+        PDLIST_ENTRY dropped = NULL;
+        size_t payload_size = ((handleData->send_queue_max_bytes != 0) || handleData->collect_statistics) ? get_message_payload_size(eventMessageHandle) : 0;
+        if ((handleData->persistent_queue != NULL) && !handleData->replaying_persisted_messages &&
+            ((handleData->send_queue_messages >= handleData->persistent_queue_ram_messages) || (handleData->replay_pending_message != NULL) ||
+            persistent_queue_has_unread(handleData->persistent_queue)))
+        {
+            /*once messages are on disk, newer ones go there too so that they are sent in order*/
+            result = persist_event(handleData, eventMessageHandle, eventConfirmationCallback, userContextCallback, takeOwnership);
+        }
+        else if ((handleData->send_queue_max_bytes != 0) && (payload_size > handleData->send_queue_max_bytes))
+        {
+            LogError("message of %lu bytes can never fit in a send queue of %lu bytes", (unsigned long)payload_size, (unsigned long)handleData->send_queue_max_bytes);
+            result = IOTHUB_CLIENT_INVALID_SIZE;
+        }
+        else if (make_room_in_send_queue(handleData, payload_size, &dropped) != 0)
+        {
+            result = IOTHUB_CLIENT_QUEUE_FULL;
+            LOG_ERROR_RESULT;
+        }
+        else if ((newEntry = allocate_message_node(handleData)) == NULL)
         {
             result = IOTHUB_CLIENT_ERROR;
             LOG_ERROR_RESULT;
         }
         else
         {
-            IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)iotHubClientHandle;
-
             if (attach_ms_timesOutAfter(handleData, newEntry) != 0)
             {
                 result = IOTHUB_CLIENT_ERROR;
                 LOG_ERROR_RESULT;
-                free(newEntry);
+                release_message_node(handleData, newEntry);
             }
             else
             {
                 /*Codes_SRS_IOTHUBCLIENT_LL_02_013: [IoTHubClientCore_LL_SendEventAsync shall add the DLIST waitingToSend a new record cloning the information from eventMessageHandle, eventConfirmationCallback, userContextCallback.]*/
-                if ((newEntry->messageHandle = IoTHubMessage_Clone(eventMessageHandle)) == NULL)
+                if ((newEntry->messageHandle = (takeOwnership ? eventMessageHandle : clone_event_message(handleData, eventMessageHandle))) == NULL)
                 {
                     result = IOTHUB_CLIENT_ERROR;
-                    free(newEntry);
+                    release_message_node(handleData, newEntry);
                     LOG_ERROR_RESULT;
                 }
                 else if (IoTHubClient_Diagnostic_AddIfNecessary(&handleData->diagnostic_setting, newEntry->messageHandle) != 0)
                 {
                     /*Codes_SRS_IOTHUBCLIENT_LL_02_014: [If cloning and/or adding the information/diagnostic fails for any reason, IoTHubClientCore_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR.] */
                     result = IOTHUB_CLIENT_ERROR;
-                    IoTHubMessage_Destroy(newEntry->messageHandle);
-                    free(newEntry);
+                    if (!takeOwnership)
+                    {
+                        IoTHubMessage_Destroy(newEntry->messageHandle);
+                    }
+                    release_message_node(handleData, newEntry);
                     LOG_ERROR_RESULT;
                 }
                 else
@@ -1873,16 +2444,57 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SendEventAsync(IOTHUB_CLIENT_CORE_LL_HA
                     /*Codes_SRS_IOTHUBCLIENT_LL_02_013: [IoTHubClientCore_LL_SendEventAsync shall add the DLIST waitingToSend a new record cloning the information from eventMessageHandle, eventConfirmationCallback, userContextCallback.]*/
                     newEntry->callback = eventConfirmationCallback;
                     newEntry->context = userContextCallback;
+                    newEntry->payload_size = payload_size;
+                    newEntry->send_sequence = handleData->next_send_sequence++;
+                    newEntry->timeout_entry.Flink = NULL;
+                    newEntry->client_handle = iotHubClientHandle;
+                    newEntry->send_attempts = 0;
                     DList_InsertTailList(&(iotHubClientHandle->waitingToSend), &(newEntry->entry));
+                    if (newEntry->ms_timesOutAfter != 0)
+                    {
+                        add_to_timeout_index(handleData, newEntry);
+                    }
+                    record_enqueue_statistics(handleData, newEntry);
+                    handleData->send_queue_messages++;
+                    handleData->send_queue_bytes += payload_size;
+                    if (handleData->IoTHubTransport_OnEventQueued != NULL)
+                    {
+                        handleData->IoTHubTransport_OnEventQueued(handleData->deviceHandle);
+                    }
                     /*Codes_SRS_IOTHUBCLIENT_LL_02_015: [Otherwise IoTHubClientCore_LL_SendEventAsync shall succeed and return IOTHUB_CLIENT_OK.] */
                     result = IOTHUB_CLIENT_OK;
                 }
             }
         }
+
+        /*messages dropped to make room are completed even if queuing the new one failed afterwards, they are no longer on waitingToSend*/
+        while (dropped != NULL)
+        {
+            IOTHUB_MESSAGE_LIST* droppedEntry = containingRecord(dropped, IOTHUB_MESSAGE_LIST, entry);
+            dropped = dropped->Flink;
+            record_completion_statistics(handleData, droppedEntry, IOTHUB_CLIENT_CONFIRMATION_DROPPED, 0);
+            if (droppedEntry->callback != NULL)
+            {
+                droppedEntry->callback(IOTHUB_CLIENT_CONFIRMATION_DROPPED, droppedEntry->context);
+            }
+            IoTHubMessage_Destroy(droppedEntry->messageHandle);
+            release_message_node(handleData, droppedEntry);
+        }
+        check_send_queue_watermarks(handleData);
     }
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SendEventAsync(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    return send_event_async(iotHubClientHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback, false);
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SendEventAsyncTakeOwnership(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    return send_event_async(iotHubClientHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback, true);
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SetMessageCallback(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC messageCallback, void* userContextCallback)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -2043,6 +2655,126 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SendMessageDisposition(IOTHUB_CLIENT_CO
     return result;
 }
 
+static void on_persisted_message_sent(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback)
+{
+    PERSISTED_MESSAGE* persisted = (PERSISTED_MESSAGE*)userContextCallback;
+    /*a message not sent because the client is destroyed stays on disk and is sent after the next start*/
+    if ((result != IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY) &&
+        (persistent_queue_ack(persisted->handleData->persistent_queue, persisted->record_id) != 0))
+    {
+        LogError("unable to acknowledge a persisted message, it may be sent again");
+    }
+    if (persisted->callback != NULL)
+    {
+        persisted->callback(result, persisted->context);
+    }
+    free(persisted);
+}
+
+/*returns the PERSISTED_MESSAGE appended as record_id, or a new one without callback for a record appended before a restart*/
+static PERSISTED_MESSAGE* take_persisted_message(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, uint64_t record_id)
+{
+    PERSISTED_MESSAGE* result;
+    /*records before record_id were damaged on disk and have been skipped*/
+    while ((handleData->persisted_oldest != NULL) && (handleData->persisted_oldest->record_id < record_id))
+    {
+        PERSISTED_MESSAGE* lost = handleData->persisted_oldest;
+        handleData->persisted_oldest = lost->next;
+        if (handleData->persisted_oldest == NULL)
+        {
+            handleData->persisted_newest = NULL;
+        }
+        lost->callback(IOTHUB_CLIENT_CONFIRMATION_ERROR, lost->context);
+        free(lost);
+    }
+
+    if ((handleData->persisted_oldest != NULL) && (handleData->persisted_oldest->record_id == record_id))
+    {
+        result = handleData->persisted_oldest;
+        handleData->persisted_oldest = result->next;
+        if (handleData->persisted_oldest == NULL)
+        {
+            handleData->persisted_newest = NULL;
+        }
+        result->next = NULL;
+    }
+    else if ((result = (PERSISTED_MESSAGE*)malloc(sizeof(PERSISTED_MESSAGE))) == NULL)
+    {
+        LogError("unable to allocate PERSISTED_MESSAGE");
+    }
+    else
+    {
+        memset(result, 0, sizeof(PERSISTED_MESSAGE));
+        result->handleData = handleData;
+        result->record_id = record_id;
+    }
+    return result;
+}
+
+/*moves messages from the persistent queue to waitingToSend while fewer than persistent_queue_ram_messages are outstanding.
+A message that does not fit in the send queue is kept in replay_pending_message until a later call, it is never dropped*/
+static void replay_persisted_messages(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData)
+{
+    while ((handleData->send_queue_messages < handleData->persistent_queue_ram_messages) &&
+        !is_send_queue_full(handleData, handleData->send_queue_messages, handleData->send_queue_bytes, 0))
+    {
+        IOTHUB_CLIENT_RESULT send_result;
+        if (handleData->replay_pending_message == NULL)
+        {
+            IOTHUB_MESSAGE_HANDLE message;
+            uint64_t record_id;
+            PERSISTED_MESSAGE* persisted;
+            if (!persistent_queue_has_unread(handleData->persistent_queue))
+            {
+                break;
+            }
+            else if (persistent_queue_read(handleData->persistent_queue, &message, &record_id) != 0)
+            {
+                LogError("unable to read the persistent queue");
+                break;
+            }
+            else if (message == NULL)
+            {
+                break;
+            }
+            else if ((persisted = take_persisted_message(handleData, record_id)) == NULL)
+            {
+                LogError("dropping a persisted message");
+                IoTHubMessage_Destroy(message);
+                (void)persistent_queue_ack(handleData->persistent_queue, record_id);
+                continue;
+            }
+            else
+            {
+                handleData->replay_pending_message = message;
+                handleData->replay_pending = persisted;
+            }
+        }
+
+        handleData->replaying_persisted_messages = true;
+        send_result = send_event_async(handleData, handleData->replay_pending_message, on_persisted_message_sent, handleData->replay_pending, true);
+        handleData->replaying_persisted_messages = false;
+        if (send_result == IOTHUB_CLIENT_QUEUE_FULL)
+        {
+            /*over the byte limit, retried once confirmations make room*/
+            break;
+        }
+        else if (send_result != IOTHUB_CLIENT_OK)
+        {
+            LogError("unable to queue a persisted message, result %s", MU_ENUM_TO_STRING(IOTHUB_CLIENT_RESULT, send_result));
+            IoTHubMessage_Destroy(handleData->replay_pending_message);
+            (void)persistent_queue_ack(handleData->persistent_queue, handleData->replay_pending->record_id);
+            if (handleData->replay_pending->callback != NULL)
+            {
+                handleData->replay_pending->callback(IOTHUB_CLIENT_CONFIRMATION_ERROR, handleData->replay_pending->context);
+            }
+            free(handleData->replay_pending);
+        }
+        handleData->replay_pending_message = NULL;
+        handleData->replay_pending = NULL;
+    }
+}
+
 static void DoTimeouts(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData)
 {
     tickcounter_ms_t nowTick;
@@ -2052,28 +2784,80 @@ static void DoTimeouts(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData)
     }
     else
     {
-        DLIST_ENTRY* currentItemInWaitingToSend = handleData->waitingToSend.Flink;
-        while (currentItemInWaitingToSend != &(handleData->waitingToSend)) /*while we are not at the end of the list*/
+        /*expired entries are unlinked and chained through entry.Flink before any callback runs, because a callback sending a new
+        message may drop entries from waitingToSend*/
+        PDLIST_ENTRY expired = NULL;
+        PDLIST_ENTRY* expiredTail = &expired;
+
+        /*timeout_index is ordered by deadline, so only the messages that expire now are visited*/
+        while (handleData->timeout_index.Flink != &(handleData->timeout_index))
         {
-            IOTHUB_MESSAGE_LIST* fullEntry = containingRecord(currentItemInWaitingToSend, IOTHUB_MESSAGE_LIST, entry);
+            IOTHUB_MESSAGE_LIST* fullEntry = containingRecord(handleData->timeout_index.Flink, IOTHUB_MESSAGE_LIST, timeout_entry);
             /*Codes_SRS_IOTHUBCLIENT_LL_02_041: [ If more than value miliseconds have passed since the call to IoTHubClientCore_LL_SendEventAsync then the message callback shall be called with a status code of IOTHUB_CLIENT_CONFIRMATION_TIMEOUT. ]*/
-            if ((fullEntry->ms_timesOutAfter != 0) && ((nowTick - fullEntry->ms_timesOutAfter) > fullEntry->message_timeout_value))
+            if ((nowTick - fullEntry->ms_timesOutAfter) <= fullEntry->message_timeout_value)
+            {
+                break;
+            }
+
+            unlink_timeout_entry(fullEntry);
+            if (is_waiting_to_send(handleData, fullEntry))
             {
-                PDLIST_ENTRY theNext = currentItemInWaitingToSend->Flink; /*need to save the next item, because the below operations are destructive*/
-                DList_RemoveEntryList(currentItemInWaitingToSend);
-                if (fullEntry->callback != NULL)
+                DList_RemoveEntryList(&(fullEntry->entry));
+                fullEntry->entry.Flink = NULL;
+                *expiredTail = &(fullEntry->entry);
+                expiredTail = &(fullEntry->entry.Flink);
+            }
+            else
+            {
+                /*the transport owns it now, it only times out here if the transport hands it back*/
+                link_timeout_entry(&(handleData->overdue_messages), fullEntry);
+                if (fullEntry->send_sequence > handleData->overdue_max_sequence)
                 {
-                    fullEntry->callback(IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, fullEntry->context);
+                    handleData->overdue_max_sequence = fullEntry->send_sequence;
                 }
-                IoTHubMessage_Destroy(fullEntry->messageHandle); /*because it has been cloned*/
-                free(fullEntry);
-                currentItemInWaitingToSend = theNext;
             }
-            else
+        }
+
+        /*a transport can only have handed an overdue message back if it is now at or behind the head of waitingToSend*/
+        if ((handleData->overdue_messages.Flink != &(handleData->overdue_messages)) &&
+            (handleData->waitingToSend.Flink != &(handleData->waitingToSend)) &&
+            (handleData->overdue_max_sequence >= containingRecord(handleData->waitingToSend.Flink, IOTHUB_MESSAGE_LIST, entry)->send_sequence))
+        {
+            PDLIST_ENTRY currentOverdue = handleData->overdue_messages.Flink;
+            handleData->overdue_max_sequence = 0;
+            while (currentOverdue != &(handleData->overdue_messages))
+            {
+                IOTHUB_MESSAGE_LIST* fullEntry = containingRecord(currentOverdue, IOTHUB_MESSAGE_LIST, timeout_entry);
+                currentOverdue = currentOverdue->Flink;
+                if (is_waiting_to_send(handleData, fullEntry))
+                {
+                    unlink_timeout_entry(fullEntry);
+                    DList_RemoveEntryList(&(fullEntry->entry));
+                    fullEntry->entry.Flink = NULL;
+                    *expiredTail = &(fullEntry->entry);
+                    expiredTail = &(fullEntry->entry.Flink);
+                }
+                else if (fullEntry->send_sequence > handleData->overdue_max_sequence)
+                {
+                    handleData->overdue_max_sequence = fullEntry->send_sequence;
+                }
+            }
+        }
+
+        while (expired != NULL)
+        {
+            IOTHUB_MESSAGE_LIST* fullEntry = containingRecord(expired, IOTHUB_MESSAGE_LIST, entry);
+            expired = expired->Flink;
+            record_completion_statistics(handleData, fullEntry, IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, nowTick);
+            remove_from_send_queue(handleData, fullEntry);
+            if (fullEntry->callback != NULL)
             {
-                currentItemInWaitingToSend = currentItemInWaitingToSend->Flink;
+                fullEntry->callback(IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, fullEntry->context);
             }
+            IoTHubMessage_Destroy(fullEntry->messageHandle); /*because it has been cloned*/
+            release_message_node(handleData, fullEntry);
         }
+        check_send_queue_watermarks(handleData);
     }
 }
 
@@ -2085,6 +2869,21 @@ void IoTHubClientCore_LL_DoWork(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle)
         IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)iotHubClientHandle;
         DoTimeouts(handleData);
 
+        if (handleData->persistent_queue != NULL)
+        {
+            tickcounter_ms_t nowTick;
+            replay_persisted_messages(handleData);
+            if ((tickcounter_get_current_ms(handleData->tickCounter, &nowTick) == 0) &&
+                (nowTick - handleData->persistent_queue_last_sync >= handleData->persistent_queue_sync_interval))
+            {
+                if (persistent_queue_sync(handleData->persistent_queue) != 0)
+                {
+                    LogError("unable to sync the persistent queue");
+                }
+                handleData->persistent_queue_last_sync = nowTick;
+            }
+        }
+
         /*Codes_SRS_IOTHUBCLIENT_LL_07_008: [ IoTHubClientCore_LL_DoWork shall iterate the message queue and execute the underlying transports IoTHubTransport_ProcessItem function for each item. ] */
         DLIST_ENTRY* client_item = handleData->iot_msg_queue.Flink;
         while (client_item != &(handleData->iot_msg_queue)) /*while we are not at the end of the list*/
@@ -2146,6 +2945,23 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_GetSendStatus(IOTHUB_CLIENT_CORE_LL_HAN
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_GetStatistics(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_STATISTICS* statistics)
+{
+    IOTHUB_CLIENT_RESULT result;
+    if (iotHubClientHandle == NULL || statistics == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR_RESULT;
+    }
+    else
+    {
+        IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)iotHubClientHandle;
+        (void)memcpy(statistics, &handleData->statistics, sizeof(IOTHUB_CLIENT_STATISTICS));
+        result = IOTHUB_CLIENT_OK;
+    }
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SetConnectionStatusCallback(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK connectionStatusCallback, void * userContextCallback)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -2167,6 +2983,24 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SetConnectionStatusCallback(IOTHUB_CLIE
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SetSendQueueCallback(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_SEND_QUEUE_CALLBACK sendQueueCallback, void* userContextCallback)
+{
+    IOTHUB_CLIENT_RESULT result;
+    if (iotHubClientHandle == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR_RESULT;
+    }
+    else
+    {
+        IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)iotHubClientHandle;
+        handleData->sendQueueCallback = sendQueueCallback;
+        handleData->sendQueueUserContextCallback = userContextCallback;
+        result = IOTHUB_CLIENT_OK;
+    }
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SetRetryPolicy(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitInSeconds)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -2329,7 +3163,7 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SetOption(IOTHUB_CLIENT_CORE_LL_HANDLE
                 result = IOTHUB_CLIENT_OK;
             }
         }
-        else if ((strcmp(optionName, OPTION_BLOB_UPLOAD_TIMEOUT_SECS) == 0) || (strcmp(optionName, OPTION_CURL_VERBOSE) == 0) || (strcmp(optionName, OPTION_NETWORK_INTERFACE_UPLOAD_TO_BLOB) == 0))
+        else if ((strcmp(optionName, OPTION_BLOB_UPLOAD_TIMEOUT_SECS) == 0) || (strcmp(optionName, OPTION_BLOB_UPLOAD_PARALLEL_BLOCKS) == 0) || (strcmp(optionName, OPTION_CURL_VERBOSE) == 0) || (strcmp(optionName, OPTION_NETWORK_INTERFACE_UPLOAD_TO_BLOB) == 0))
         {
 #ifndef DONT_USE_UPLOADTOBLOB
             // This option just gets passed down into IoTHubClientCore_LL_UploadToBlob
@@ -2376,6 +3210,127 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SetOption(IOTHUB_CLIENT_CORE_LL_HANDLE
                 result = IOTHUB_CLIENT_OK;
             }
         }
+        else if (strcmp(optionName, OPTION_MESSAGE_NODE_POOL_SIZE) == 0)
+        {
+            if (handleData->isSharedTransport)
+            {
+                LogError("%s is not supported with a shared transport", optionName);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else if (set_message_node_pool_size(handleData, *(const size_t*)value) != 0)
+            {
+                LogError("unable to set the message node pool size");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp(optionName, OPTION_TELEMETRY_STATISTICS) == 0)
+        {
+            /*messages queued while collection was off have ms_enqueued == 0 and are left out of the latency histogram*/
+            handleData->collect_statistics = *(const bool*)value;
+            result = IOTHUB_CLIENT_OK;
+        }
+        else if ((strcmp(optionName, OPTION_SEND_QUEUE_MAX_MESSAGES) == 0) || (strcmp(optionName, OPTION_SEND_QUEUE_MAX_BYTES) == 0))
+        {
+            if (handleData->isSharedTransport)
+            {
+                LogError("%s is not supported with a shared transport", optionName);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else
+            {
+                /*lowering a limit below the current depth does not drop anything, it only refuses new messages until the queue drains.
+                messages queued before a byte limit was set count as 0 bytes*/
+                if (strcmp(optionName, OPTION_SEND_QUEUE_MAX_MESSAGES) == 0)
+                {
+                    handleData->send_queue_max_messages = *(const size_t*)value;
+                }
+                else
+                {
+                    handleData->send_queue_max_bytes = *(const size_t*)value;
+                }
+                check_send_queue_watermarks(handleData);
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp(optionName, OPTION_SEND_QUEUE_FULL_POLICY) == 0)
+        {
+            IOTHUB_CLIENT_SEND_QUEUE_FULL_POLICY policy = *(const IOTHUB_CLIENT_SEND_QUEUE_FULL_POLICY*)value;
+            if (handleData->isSharedTransport)
+            {
+                LogError("%s is not supported with a shared transport", optionName);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else if ((policy != IOTHUB_CLIENT_SEND_QUEUE_FULL_FAIL) && (policy != IOTHUB_CLIENT_SEND_QUEUE_FULL_DROP_OLDEST))
+            {
+                /*blocking is done by the convenience layer, the LL layer cannot wait for its own DoWork*/
+                LogError("invalid %s value %d", optionName, (int)policy);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else
+            {
+                handleData->send_queue_full_policy = policy;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp(optionName, OPTION_PERSISTENT_QUEUE_PATH) == 0)
+        {
+            if (handleData->isSharedTransport)
+            {
+                /*the shared transport's DoWork does not go through IoTHubClientCore_LL_DoWork, so nothing would be read back*/
+                LogError("%s is not supported with a shared transport", optionName);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else if (handleData->persistent_queue != NULL)
+            {
+                LogError("%s can only be set once", optionName);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else if ((handleData->persistent_queue = persistent_queue_create((const char*)value, handleData->persistent_queue_segment_size)) == NULL)
+            {
+                LogError("unable to open the persistent queue %s", (const char*)value);
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp(optionName, OPTION_PERSISTENT_QUEUE_SEGMENT_SIZE) == 0)
+        {
+            if ((handleData->persistent_queue != NULL) || (*(const size_t*)value == 0))
+            {
+                LogError("%s must be set to a non-zero value before %s", optionName, OPTION_PERSISTENT_QUEUE_PATH);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else
+            {
+                handleData->persistent_queue_segment_size = *(const size_t*)value;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp(optionName, OPTION_PERSISTENT_QUEUE_RAM_MESSAGES) == 0)
+        {
+            if (*(const size_t*)value == 0)
+            {
+                /*no message would ever be read back from the persistent queue*/
+                LogError("%s must not be 0", optionName);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else
+            {
+                handleData->persistent_queue_ram_messages = *(const size_t*)value;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp(optionName, OPTION_PERSISTENT_QUEUE_SYNC_INTERVAL) == 0)
+        {
+            handleData->persistent_queue_sync_interval = *(const tickcounter_ms_t*)value;
+            result = IOTHUB_CLIENT_OK;
+        }
         else
         {
             // This section is unusual for SetOption calls because it attempts to pass unhandled options
@@ -2795,6 +3750,23 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_UploadMultipleBlocksToBlobEx(IOTHUB_CLI
     }
     return result;
 }
+
+IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_UploadFileToBlob(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, const char* destinationFileName, const char* filePath, const char* checkpointPath)
+{
+    IOTHUB_CLIENT_RESULT result;
+    /*Codes_SRS_IOTHUBCLIENT_LL_31_148: [ If `iotHubClientHandle` is `NULL` then `IoTHubClientCore_LL_UploadFileToBlob` shall fail and return `IOTHUB_CLIENT_INVALID_ARG`. ]*/
+    if (iotHubClientHandle == NULL)
+    {
+        LogError("invalid parameter iotHubClientHandle=%p", iotHubClientHandle);
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBCLIENT_LL_31_149: [ `IoTHubClientCore_LL_UploadFileToBlob` shall call `IoTHubClient_LL_UploadFileToBlob_Impl` and return its result. ]*/
+        result = IoTHubClient_LL_UploadFileToBlob_Impl(iotHubClientHandle->uploadToBlobHandle, destinationFileName, filePath, checkpointPath);
+    }
+    return result;
+}
 #endif // DONT_USE_UPLOADTOBLOB
 
 IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SendEventToOutputAsync(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, const char* outputName, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
@@ -3033,6 +4005,8 @@ int IoTHubClientCore_LL_GetTransportCallbacks(TRANSPORT_CALLBACKS_INFO* transpor
         transport_cb->msg_cb = IoTHubClientCore_LL_MessageCallback;
         transport_cb->method_complete_cb = IoTHubClientCore_LL_DeviceMethodComplete;
         transport_cb->get_model_id_cb = IoTHubClientCore_LL_GetModelId;
+        transport_cb->event_sent_cb = IoTHubClientCore_LL_EventSent;
+        transport_cb->event_batch_sent_cb = IoTHubClientCore_LL_EventBatchSent;
         result = 0;
     }
     return result;
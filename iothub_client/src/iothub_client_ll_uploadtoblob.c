@@ -24,6 +24,7 @@
 #include "internal/iothub_client_ll_uploadtoblob.h"
 #include "internal/iothub_client_authorization.h"
 #include "internal/blob.h"
+#include "internal/blob_file_source.h"
 
 #define API_VERSION "?api-version=2016-11-14"
 
@@ -49,6 +50,10 @@ static const char* const RESPONSE_BODY_ERROR_RETURN_CODE = "-1";
 static const char* const RESPONSE_BODY_ERROR_BOOLEAN_STRING = "false";
 
 #define INDEFINITE_TIME                            ((time_t)-1)
+/*by default the blocks of a blob are uploaded one after the other*/
+#define DEFAULT_BLOB_UPLOAD_PARALLEL_BLOCKS        1
+/*each parallel block holds a thread, a connection and a copy of the block (up to 4 MB)*/
+#define MAX_BLOB_UPLOAD_PARALLEL_BLOCKS            16
 
 static const char* const EMPTY_STRING = "";
 static const char* const HEADER_AUTHORIZATION = "Authorization";
@@ -84,6 +89,7 @@ typedef struct IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA_TAG
     UPOADTOBLOB_CURL_VERBOSITY curl_verbosity_level;
     size_t blob_upload_timeout_secs;
     const char* networkInterface;
+    size_t blob_upload_parallel_blocks;
 }IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA;
 
 typedef struct BLOB_UPLOAD_CONTEXT_TAG
@@ -262,6 +268,7 @@ IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE IoTHubClient_LL_UploadToBlob_Create(const I
             memset(upload_data, 0, sizeof(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA));
 
             upload_data->authorization_module = auth_handle;
+            upload_data->blob_upload_parallel_blocks = DEFAULT_BLOB_UPLOAD_PARALLEL_BLOCKS;
 
             size_t iotHubNameLength = strlen(config->iotHubName);
             size_t iotHubSuffixLength = strlen(config->iotHubSuffix);
@@ -662,7 +669,7 @@ static HTTPAPIEX_RESULT set_transfer_timeout(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDL
     return result;
 }
 
-IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadMultipleBlocksToBlob_Impl(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE handle, const char* destinationFileName, IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX getDataCallbackEx, void* context)
+static IOTHUB_CLIENT_RESULT UploadMultipleBlocksToBlob(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE handle, const char* destinationFileName, IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX getDataCallbackEx, void* context, size_t parallelBlocks, unsigned int uploadedBlockCount)
 {
     IOTHUB_CLIENT_RESULT result;
 
@@ -794,7 +801,7 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadMultipleBlocksToBlob_Impl(IOTHUB_CLIE
                                         else
                                         {
                                             /*Codes_SRS_IOTHUBCLIENT_LL_02_083: [ IoTHubClient_LL_UploadMultipleBlocksToBlob(Ex) shall call Blob_UploadFromSasUri and capture the HTTP return code and HTTP body. ]*/
-                                            BLOB_RESULT uploadMultipleBlocksResult = Blob_UploadMultipleBlocksFromSasUri(STRING_c_str(sasUri), getDataCallbackEx, context, &httpResponse, responseToIoTHub, upload_data->certificates, &(upload_data->http_proxy_options), upload_data->networkInterface);
+                                            BLOB_RESULT uploadMultipleBlocksResult = Blob_UploadMultipleBlocksFromSasUri(STRING_c_str(sasUri), getDataCallbackEx, context, &httpResponse, responseToIoTHub, upload_data->certificates, &(upload_data->http_proxy_options), upload_data->networkInterface, parallelBlocks, uploadedBlockCount);
                                             if (uploadMultipleBlocksResult == BLOB_ABORTED)
                                             {
                                                 /*Codes_SRS_IOTHUBCLIENT_LL_99_008: [ If step 2 is aborted by the client, then the HTTP message body shall look like:  ]*/
@@ -929,6 +936,52 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadMultipleBlocksToBlob_Impl(IOTHUB_CLIE
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadMultipleBlocksToBlob_Impl(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE handle, const char* destinationFileName, IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX getDataCallbackEx, void* context)
+{
+    IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA* upload_data = (IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA*)handle;
+    return UploadMultipleBlocksToBlob(handle, destinationFileName, getDataCallbackEx, context, (upload_data == NULL) ? 1 : upload_data->blob_upload_parallel_blocks, 0);
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadFileToBlob_Impl(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE handle, const char* destinationFileName, const char* filePath, const char* checkpointPath)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    /*Codes_SRS_IOTHUBCLIENT_LL_31_143: [ If handle, destinationFileName or filePath is NULL then IoTHubClient_LL_UploadFileToBlob shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    if (handle == NULL || destinationFileName == NULL || filePath == NULL)
+    {
+        LogError("Invalid parameter handle:%p destinationFileName:%p filePath:%p", handle, destinationFileName, filePath);
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else
+    {
+        IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA* upload_data = (IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA*)handle;
+
+        /*Codes_SRS_IOTHUBCLIENT_LL_31_144: [ IoTHubClient_LL_UploadFileToBlob shall open the file and its checkpoint by calling blob_file_source_create. ]*/
+        BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(filePath, checkpointPath, destinationFileName);
+        if (file_source == NULL)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_31_145: [ If blob_file_source_create fails then IoTHubClient_LL_UploadFileToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+            LogError("unable to open %s for upload", filePath);
+            result = IOTHUB_CLIENT_ERROR;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_31_146: [ IoTHubClient_LL_UploadFileToBlob shall upload the blocks that follow the ones reported by blob_file_source_get_uploaded_block_count, one at a time when checkpointPath is not NULL. ]*/
+            size_t parallelBlocks = (checkpointPath == NULL) ? upload_data->blob_upload_parallel_blocks : 1;
+            result = UploadMultipleBlocksToBlob(handle, destinationFileName, blob_file_source_get_data, file_source, parallelBlocks, blob_file_source_get_uploaded_block_count(file_source));
+
+            /*Codes_SRS_IOTHUBCLIENT_LL_31_147: [ If reading the file failed then IoTHubClient_LL_UploadFileToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+            if (result == IOTHUB_CLIENT_OK && blob_file_source_has_failed(file_source))
+            {
+                LogError("unable to read %s", filePath);
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            blob_file_source_destroy(file_source);
+        }
+    }
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadToBlob_Impl(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE handle, const char* destinationFileName, const unsigned char* source, size_t size)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -1175,6 +1228,26 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadToBlob_SetOption(IOTHUB_CLIENT_LL_UPL
             upload_data->blob_upload_timeout_secs = *(size_t*)value;
             result = IOTHUB_CLIENT_OK;
         }
+        else if (strcmp(optionName, OPTION_BLOB_UPLOAD_PARALLEL_BLOCKS) == 0)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_31_142: [ `blob_upload_parallel_blocks` - shall set the number of blocks uploaded at the same time; 0 shall be rejected with `IOTHUB_CLIENT_INVALID_ARG`. ]*/
+            if (*(size_t*)value == 0)
+            {
+                LogError("0 is not a valid value for the blob_upload_parallel_blocks option");
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            /*Codes_SRS_IOTHUBCLIENT_LL_31_150: [ `blob_upload_parallel_blocks` above 16 shall be rejected with `IOTHUB_CLIENT_INVALID_ARG`. ]*/
+            else if (*(size_t*)value > MAX_BLOB_UPLOAD_PARALLEL_BLOCKS)
+            {
+                LogError("%lu exceeds the maximum of %d for the blob_upload_parallel_blocks option", (unsigned long)*(size_t*)value, MAX_BLOB_UPLOAD_PARALLEL_BLOCKS);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else
+            {
+                upload_data->blob_upload_parallel_blocks = *(size_t*)value;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
         else if (strcmp(optionName, OPTION_NETWORK_INTERFACE_UPLOAD_TO_BLOB) == 0)
         {
             if (value == NULL)
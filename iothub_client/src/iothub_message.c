@@ -2,18 +2,34 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/refcount.h"
 
 #include "iothub_message.h"
+#include "internal/iothub_message_pool.h"
 
 MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_RESULT_VALUES);
 MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_CONTENT_TYPE_VALUES);
 
 static const char* SECURITY_CLIENT_JSON_ENCODING = "application/json";
 
+/*caller owned payload of a message created by IoTHubMessage_CreateFromByteArrayNoCopy, shared by the message and its clones*/
+typedef struct EXTERNAL_PAYLOAD_TAG
+{
+    const unsigned char* byteArray;
+    size_t size;
+    IOTHUB_MESSAGE_PAYLOAD_RELEASE_CALLBACK releaseCallback;
+    void* releaseContext;
+}EXTERNAL_PAYLOAD;
+
+DEFINE_REFCOUNT_TYPE(EXTERNAL_PAYLOAD);
+
 typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG
 {
     IOTHUBMESSAGE_CONTENT_TYPE contentType;
@@ -22,6 +38,7 @@ typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG
         BUFFER_HANDLE byteArray;
         STRING_HANDLE string;
     } value;
+    EXTERNAL_PAYLOAD* externalPayload; /*when not NULL the BYTEARRAY content lives here instead of value.byteArray*/
     MAP_HANDLE properties;
     char* messageId;
     char* correlationId;
@@ -35,8 +52,110 @@ typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG
     bool is_security_message;
     char* creationTimeUtc;
     char* userId;
+    struct IOTHUB_MESSAGE_POOL_TAG* pool; /*set for messages cloned by IoTHubMessage_CloneFromPool*/
 }IOTHUB_MESSAGE_HANDLE_DATA;
 
+#define MESSAGE_POOL_STRING_SIZE 64 /*fits a GUID message id or a creation time*/
+#define MESSAGE_POOL_STRINGS_PER_MESSAGE 4
+
+typedef union MESSAGE_POOL_HEADER_TAG
+{
+    union MESSAGE_POOL_HEADER_TAG* next_free;
+    IOTHUB_MESSAGE_HANDLE_DATA message;
+}MESSAGE_POOL_HEADER;
+
+typedef union MESSAGE_POOL_STRING_TAG
+{
+    union MESSAGE_POOL_STRING_TAG* next_free;
+    char value[MESSAGE_POOL_STRING_SIZE];
+}MESSAGE_POOL_STRING;
+
+typedef struct IOTHUB_MESSAGE_POOL_TAG
+{
+    MESSAGE_POOL_HEADER* headers;
+    size_t header_count;
+    MESSAGE_POOL_HEADER* free_headers;
+    MESSAGE_POOL_STRING* strings;
+    size_t string_count;
+    MESSAGE_POOL_STRING* free_strings;
+    size_t messages; /*messages cloned from the pool and not destroyed yet, whether their header comes from it or not*/
+    bool destroy_pending;
+}IOTHUB_MESSAGE_POOL;
+
+static void free_message_pool(IOTHUB_MESSAGE_POOL* pool)
+{
+    free(pool->strings);
+    free(pool->headers);
+    free(pool);
+}
+
+/*copies a system property string, into a slot of the message's pool when it has one free and the string fits*/
+static int copy_message_string(IOTHUB_MESSAGE_HANDLE_DATA* handleData, char** destination, const char* source)
+{
+    int result;
+    IOTHUB_MESSAGE_POOL* pool = handleData->pool;
+    size_t length;
+
+    if ((pool != NULL) && (pool->free_strings != NULL) && ((length = strlen(source)) < MESSAGE_POOL_STRING_SIZE))
+    {
+        MESSAGE_POOL_STRING* slot = pool->free_strings;
+        pool->free_strings = slot->next_free;
+        (void)memcpy(slot->value, source, length + 1);
+        *destination = slot->value;
+        result = 0;
+    }
+    else
+    {
+        result = mallocAndStrcpy_s(destination, source);
+    }
+    return result;
+}
+
+static void free_message_string(IOTHUB_MESSAGE_HANDLE_DATA* handleData, char* value)
+{
+    IOTHUB_MESSAGE_POOL* pool = handleData->pool;
+    if ((pool != NULL) &&
+        (value >= pool->strings[0].value) &&
+        (value < pool->strings[0].value + pool->string_count * sizeof(MESSAGE_POOL_STRING)))
+    {
+        MESSAGE_POOL_STRING* slot = (MESSAGE_POOL_STRING*)value;
+        slot->next_free = pool->free_strings;
+        pool->free_strings = slot;
+    }
+    else
+    {
+        free(value);
+    }
+}
+
+static void release_message_header(IOTHUB_MESSAGE_HANDLE_DATA* handleData)
+{
+    IOTHUB_MESSAGE_POOL* pool = handleData->pool;
+    if (pool == NULL)
+    {
+        free(handleData);
+    }
+    else
+    {
+        MESSAGE_POOL_HEADER* header = (MESSAGE_POOL_HEADER*)handleData;
+        if ((header >= pool->headers) && (header < pool->headers + pool->header_count))
+        {
+            header->next_free = pool->free_headers;
+            pool->free_headers = header;
+        }
+        else
+        {
+            free(handleData);
+        }
+
+        pool->messages--;
+        if (pool->destroy_pending && (pool->messages == 0))
+        {
+            free_message_pool(pool);
+        }
+    }
+}
+
 static bool ContainsValidUsAscii(const char* asciiValue)
 {
     bool result = true;
@@ -80,9 +199,25 @@ static void DestroyDiagnosticPropertyData(IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DAT
     free(diagnosticHandle);
 }
 
+static void ReleaseExternalPayload(EXTERNAL_PAYLOAD* externalPayload)
+{
+    if (DEC_REF(EXTERNAL_PAYLOAD, externalPayload) == DEC_RETURN_ZERO)
+    {
+        if (externalPayload->releaseCallback != NULL)
+        {
+            externalPayload->releaseCallback(externalPayload->byteArray, externalPayload->size, externalPayload->releaseContext);
+        }
+        REFCOUNT_TYPE_DESTROY(EXTERNAL_PAYLOAD, externalPayload);
+    }
+}
+
 static void DestroyMessageData(IOTHUB_MESSAGE_HANDLE_DATA* handleData)
 {
-    if (handleData->contentType == IOTHUBMESSAGE_BYTEARRAY)
+    if (handleData->externalPayload != NULL)
+    {
+        ReleaseExternalPayload(handleData->externalPayload);
+    }
+    else if (handleData->contentType == IOTHUBMESSAGE_BYTEARRAY)
     {
         BUFFER_delete(handleData->value.byteArray);
     }
@@ -92,20 +227,20 @@ static void DestroyMessageData(IOTHUB_MESSAGE_HANDLE_DATA* handleData)
     }
 
     Map_Destroy(handleData->properties);
-    free(handleData->messageId);
+    free_message_string(handleData, handleData->messageId);
     handleData->messageId = NULL;
-    free(handleData->correlationId);
+    free_message_string(handleData, handleData->correlationId);
     handleData->correlationId = NULL;
-    free(handleData->userDefinedContentType);
-    free(handleData->contentEncoding);
+    free_message_string(handleData, handleData->userDefinedContentType);
+    free_message_string(handleData, handleData->contentEncoding);
     DestroyDiagnosticPropertyData(handleData->diagnosticData);
-    free(handleData->outputName);
-    free(handleData->inputName);
-    free(handleData->connectionModuleId);
-    free(handleData->connectionDeviceId);
-    free(handleData->creationTimeUtc);
-    free(handleData->userId);
-    free(handleData);
+    free_message_string(handleData, handleData->outputName);
+    free_message_string(handleData, handleData->inputName);
+    free_message_string(handleData, handleData->connectionModuleId);
+    free_message_string(handleData, handleData->connectionDeviceId);
+    free_message_string(handleData, handleData->creationTimeUtc);
+    free_message_string(handleData, handleData->userId);
+    release_message_header(handleData);
 }
 
 static int set_content_encoding(IOTHUB_MESSAGE_HANDLE_DATA* handleData, const char* encoding)
@@ -113,7 +248,7 @@ static int set_content_encoding(IOTHUB_MESSAGE_HANDLE_DATA* handleData, const ch
     int result;
     char* tmp_encoding;
 
-    if (mallocAndStrcpy_s(&tmp_encoding, encoding) != 0)
+    if (copy_message_string(handleData, &tmp_encoding, encoding) != 0)
     {
         LogError("Failed saving a copy of contentEncoding");
         // Codes_SRS_IOTHUBMESSAGE_09_008: [If the allocation or the copying of `contentEncoding` fails, then IoTHubMessage_SetContentEncodingSystemProperty shall return IOTHUB_MESSAGE_ERROR.]
@@ -124,7 +259,7 @@ static int set_content_encoding(IOTHUB_MESSAGE_HANDLE_DATA* handleData, const ch
         // Codes_SRS_IOTHUBMESSAGE_09_007: [If the IOTHUB_MESSAGE_HANDLE `contentEncoding` is not NULL it shall be deallocated.]
         if (handleData->contentEncoding != NULL)
         {
-            free(handleData->contentEncoding);
+            free_message_string(handleData, handleData->contentEncoding);
         }
         handleData->contentEncoding = tmp_encoding;
         result = 0;
@@ -139,11 +274,11 @@ static int set_message_creation_time(IOTHUB_MESSAGE_HANDLE_DATA* handleData, con
 
     if (handleData->creationTimeUtc != NULL)
     {
-        free(handleData->creationTimeUtc);
+        free_message_string(handleData, handleData->creationTimeUtc);
         handleData->creationTimeUtc = NULL;
     }
 
-    if (mallocAndStrcpy_s(&tmp_message_creation_time, messageCreationTimeUtc) != 0)
+    if (copy_message_string(handleData, &tmp_message_creation_time, messageCreationTimeUtc) != 0)
     {
         LogError("Failed saving a copy of messageCreationTimeUtc");
         result = MU_FAILURE;
@@ -163,11 +298,11 @@ static int set_message_user_id(IOTHUB_MESSAGE_HANDLE_DATA* handleData, const cha
 
     if (handleData->userId != NULL)
     {
-        free(handleData->userId);
+        free_message_string(handleData, handleData->userId);
         handleData->userId = NULL;
     }
 
-    if (mallocAndStrcpy_s(&tmp_message_user_id, userId) != 0)
+    if (copy_message_string(handleData, &tmp_message_user_id, userId) != 0)
     {
         LogError("Failed saving a copy of userId");
         result = MU_FAILURE;
@@ -332,11 +467,57 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromString(const char* source)
     return result;
 }
 
-/*Codes_SRS_IOTHUBMESSAGE_03_001: [IoTHubMessage_Clone shall create a new IoT hub message with data content identical to that of the iotHubMessageHandle parameter.]*/
-IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromByteArrayNoCopy(const unsigned char* byteArray, size_t size, IOTHUB_MESSAGE_PAYLOAD_RELEASE_CALLBACK releaseCallback, void* releaseContext)
+{
+    IOTHUB_MESSAGE_HANDLE_DATA* result;
+    if ((byteArray == NULL) && (size != 0))
+    {
+        LogError("Invalid argument - byteArray is NULL");
+        result = NULL;
+    }
+    else if ((result = (IOTHUB_MESSAGE_HANDLE_DATA*)malloc(sizeof(IOTHUB_MESSAGE_HANDLE_DATA))) == NULL)
+    {
+        LogError("unable to malloc");
+    }
+    else
+    {
+        memset(result, 0, sizeof(*result));
+        result->contentType = IOTHUBMESSAGE_BYTEARRAY;
+
+        if ((result->externalPayload = REFCOUNT_TYPE_CREATE(EXTERNAL_PAYLOAD)) == NULL)
+        {
+            LogError("unable to allocate the external payload");
+            DestroyMessageData(result);
+            result = NULL;
+        }
+        else
+        {
+            result->externalPayload->byteArray = byteArray;
+            result->externalPayload->size = size;
+            /*the callback is only armed once the message exists, a failed create leaves the buffer with the caller*/
+            result->externalPayload->releaseCallback = NULL;
+            result->externalPayload->releaseContext = NULL;
+
+            if ((result->properties = Map_Create(ValidateAsciiCharactersFilter)) == NULL)
+            {
+                LogError("Map_Create for properties failed");
+                DestroyMessageData(result);
+                result = NULL;
+            }
+            else
+            {
+                result->externalPayload->releaseCallback = releaseCallback;
+                result->externalPayload->releaseContext = releaseContext;
+            }
+        }
+    }
+    return result;
+}
+
+/*pool is NULL for a clone allocated on the heap*/
+static IOTHUB_MESSAGE_HANDLE_DATA* clone_message(const IOTHUB_MESSAGE_HANDLE_DATA* source, IOTHUB_MESSAGE_POOL* pool)
 {
     IOTHUB_MESSAGE_HANDLE_DATA* result;
-    const IOTHUB_MESSAGE_HANDLE_DATA* source = (const IOTHUB_MESSAGE_HANDLE_DATA*)iotHubMessageHandle;
     /* Codes_SRS_IOTHUBMESSAGE_03_005: [IoTHubMessage_Clone shall return NULL if iotHubMessageHandle is NULL.] */
     if (source == NULL)
     {
@@ -345,7 +526,16 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
     }
     else
     {
-        result = (IOTHUB_MESSAGE_HANDLE_DATA*)malloc(sizeof(IOTHUB_MESSAGE_HANDLE_DATA));
+        if ((pool != NULL) && (pool->free_headers != NULL))
+        {
+            result = &(pool->free_headers->message);
+            pool->free_headers = pool->free_headers->next_free;
+        }
+        else
+        {
+            result = (IOTHUB_MESSAGE_HANDLE_DATA*)malloc(sizeof(IOTHUB_MESSAGE_HANDLE_DATA));
+        }
+
         /*Codes_SRS_IOTHUBMESSAGE_03_004: [IoTHubMessage_Clone shall return NULL if it fails for any reason.]*/
         if (result == NULL)
         {
@@ -356,28 +546,34 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
         else
         {
             memset(result, 0, sizeof(*result));
+            if (pool != NULL)
+            {
+                /*from here on DestroyMessageData gives everything back to the pool*/
+                result->pool = pool;
+                pool->messages++;
+            }
             result->contentType = source->contentType;
             result->is_security_message = source->is_security_message;
 
-            if (source->messageId != NULL && mallocAndStrcpy_s(&result->messageId, source->messageId) != 0)
+            if (source->messageId != NULL && copy_message_string(result, &result->messageId, source->messageId) != 0)
             {
                 LogError("unable to Copy messageId");
                 DestroyMessageData(result);
                 result = NULL;
             }
-            else if (source->correlationId != NULL && mallocAndStrcpy_s(&result->correlationId, source->correlationId) != 0)
+            else if (source->correlationId != NULL && copy_message_string(result, &result->correlationId, source->correlationId) != 0)
             {
                 LogError("unable to Copy correlationId");
                 DestroyMessageData(result);
                 result = NULL;
             }
-            else if (source->userDefinedContentType != NULL && mallocAndStrcpy_s(&result->userDefinedContentType, source->userDefinedContentType) != 0)
+            else if (source->userDefinedContentType != NULL && copy_message_string(result, &result->userDefinedContentType, source->userDefinedContentType) != 0)
             {
                 LogError("unable to copy contentType");
                 DestroyMessageData(result);
                 result = NULL;
             }
-            else if (source->contentEncoding != NULL && mallocAndStrcpy_s(&result->contentEncoding, source->contentEncoding) != 0)
+            else if (source->contentEncoding != NULL && copy_message_string(result, &result->contentEncoding, source->contentEncoding) != 0)
             {
                 LogError("unable to copy contentEncoding");
                 DestroyMessageData(result);
@@ -389,42 +585,55 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
                 DestroyMessageData(result);
                 result = NULL;
             }
-            else if (source->outputName != NULL && mallocAndStrcpy_s(&result->outputName, source->outputName) != 0)
+            else if (source->outputName != NULL && copy_message_string(result, &result->outputName, source->outputName) != 0)
             {
                 LogError("unable to copy outputName");
                 DestroyMessageData(result);
                 result = NULL;
             }
-            else if (source->inputName != NULL && mallocAndStrcpy_s(&result->inputName, source->inputName) != 0)
+            else if (source->inputName != NULL && copy_message_string(result, &result->inputName, source->inputName) != 0)
             {
                 LogError("unable to copy inputName");
                 DestroyMessageData(result);
                 result = NULL;
             }
-            else if (source->creationTimeUtc != NULL && mallocAndStrcpy_s(&result->creationTimeUtc, source->creationTimeUtc) != 0)
+            else if (source->creationTimeUtc != NULL && copy_message_string(result, &result->creationTimeUtc, source->creationTimeUtc) != 0)
             {
                 LogError("unable to copy creationTimeUtc");
                 DestroyMessageData(result);
                 result = NULL;
             }
-            else if (source->userId != NULL && mallocAndStrcpy_s(&result->userId, source->userId) != 0)
+            else if (source->userId != NULL && copy_message_string(result, &result->userId, source->userId) != 0)
             {
                 LogError("unable to copy userId");
                 DestroyMessageData(result);
                 result = NULL;
             }
-            else if (source->connectionModuleId != NULL && mallocAndStrcpy_s(&result->connectionModuleId, source->connectionModuleId) != 0)
+            else if (source->connectionModuleId != NULL && copy_message_string(result, &result->connectionModuleId, source->connectionModuleId) != 0)
             {
                 LogError("unable to copy inputName");
                 DestroyMessageData(result);
                 result = NULL;
             }
-            else if (source->connectionDeviceId != NULL && mallocAndStrcpy_s(&result->connectionDeviceId, source->connectionDeviceId) != 0)
+            else if (source->connectionDeviceId != NULL && copy_message_string(result, &result->connectionDeviceId, source->connectionDeviceId) != 0)
             {
                 LogError("unable to copy inputName");
                 DestroyMessageData(result);
                 result = NULL;
             }
+            else if (source->externalPayload != NULL)
+            {
+                /*the payload is shared, not copied; it is released when the last message referring to it is destroyed*/
+                (void)INC_REF(EXTERNAL_PAYLOAD, source->externalPayload);
+                result->externalPayload = source->externalPayload;
+
+                if ((result->properties = Map_Clone(source->properties)) == NULL)
+                {
+                    LogError("unable to Map_Clone");
+                    DestroyMessageData(result);
+                    result = NULL;
+                }
+            }
             else if (source->contentType == IOTHUBMESSAGE_BYTEARRAY)
             {
                 /*Codes_SRS_IOTHUBMESSAGE_02_006: [IoTHubMessage_Clone shall clone to content by a call to BUFFER_clone] */
@@ -469,6 +678,86 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
     return result;
 }
 
+/*Codes_SRS_IOTHUBMESSAGE_03_001: [IoTHubMessage_Clone shall create a new IoT hub message with data content identical to that of the iotHubMessageHandle parameter.]*/
+IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return clone_message((const IOTHUB_MESSAGE_HANDLE_DATA*)iotHubMessageHandle, NULL);
+}
+
+IOTHUB_MESSAGE_HANDLE IoTHubMessage_CloneFromPool(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, IOTHUB_MESSAGE_POOL_HANDLE pool)
+{
+    IOTHUB_MESSAGE_HANDLE_DATA* result;
+    if ((pool == NULL) || pool->destroy_pending)
+    {
+        LogError("invalid pool %p", pool);
+        result = NULL;
+    }
+    else
+    {
+        result = clone_message((const IOTHUB_MESSAGE_HANDLE_DATA*)iotHubMessageHandle, pool);
+    }
+    return result;
+}
+
+IOTHUB_MESSAGE_POOL_HANDLE IoTHubMessage_CreatePool(size_t message_count)
+{
+    IOTHUB_MESSAGE_POOL* result;
+    if ((message_count == 0) || (message_count > SIZE_MAX / (MESSAGE_POOL_STRINGS_PER_MESSAGE * sizeof(MESSAGE_POOL_STRING))))
+    {
+        LogError("invalid message count %lu", (unsigned long)message_count);
+        result = NULL;
+    }
+    else if ((result = (IOTHUB_MESSAGE_POOL*)malloc(sizeof(IOTHUB_MESSAGE_POOL))) == NULL)
+    {
+        LogError("unable to allocate a message pool");
+    }
+    else
+    {
+        memset(result, 0, sizeof(*result));
+        result->header_count = message_count;
+        result->string_count = message_count * MESSAGE_POOL_STRINGS_PER_MESSAGE;
+        if (((result->headers = (MESSAGE_POOL_HEADER*)malloc(result->header_count * sizeof(MESSAGE_POOL_HEADER))) == NULL) ||
+            ((result->strings = (MESSAGE_POOL_STRING*)malloc(result->string_count * sizeof(MESSAGE_POOL_STRING))) == NULL))
+        {
+            LogError("unable to allocate a message pool of %lu messages", (unsigned long)message_count);
+            free_message_pool(result);
+            result = NULL;
+        }
+        else
+        {
+            size_t index;
+            for (index = result->header_count; index > 0; index--)
+            {
+                result->headers[index - 1].next_free = result->free_headers;
+                result->free_headers = &(result->headers[index - 1]);
+            }
+            for (index = result->string_count; index > 0; index--)
+            {
+                result->strings[index - 1].next_free = result->free_strings;
+                result->free_strings = &(result->strings[index - 1]);
+            }
+        }
+    }
+    return result;
+}
+
+void IoTHubMessage_DestroyPool(IOTHUB_MESSAGE_POOL_HANDLE pool)
+{
+    if (pool == NULL)
+    {
+        LogError("invalid argument (pool=NULL)");
+    }
+    else if (pool->messages != 0)
+    {
+        /*the last of them frees the pool, see release_message_header*/
+        pool->destroy_pending = true;
+    }
+    else
+    {
+        free_message_pool(pool);
+    }
+}
+
 IOTHUB_MESSAGE_RESULT IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const unsigned char** buffer, size_t* size)
 {
     IOTHUB_MESSAGE_RESULT result;
@@ -491,6 +780,12 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMes
             result = IOTHUB_MESSAGE_INVALID_ARG;
             LogError("invalid type of message %s", MU_ENUM_TO_STRING(IOTHUBMESSAGE_CONTENT_TYPE, handleData->contentType));
         }
+        else if (handleData->externalPayload != NULL)
+        {
+            *buffer = handleData->externalPayload->byteArray;
+            *size = handleData->externalPayload->size;
+            result = IOTHUB_MESSAGE_OK;
+        }
         else
         {
             /*Codes_SRS_IOTHUBMESSAGE_01_011: [The pointer shall be obtained by using BUFFER_u_char and it shall be copied in the buffer argument.]*/
@@ -649,11 +944,11 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_SetCorrelationId(IOTHUB_MESSAGE_HANDLE iotHu
         /* Codes_SRS_IOTHUBMESSAGE_07_019: [If the IOTHUB_MESSAGE_HANDLE correlationId is not NULL, then the IOTHUB_MESSAGE_HANDLE correlationId will be deallocated.] */
         if (handleData->correlationId != NULL)
         {
-            free(handleData->correlationId);
+            free_message_string(handleData, handleData->correlationId);
             handleData->correlationId = NULL;
         }
 
-        if (mallocAndStrcpy_s(&handleData->correlationId, correlationId) != 0)
+        if (copy_message_string(handleData, &handleData->correlationId, correlationId) != 0)
         {
             /* Codes_SRS_IOTHUBMESSAGE_07_020: [If the allocation or the copying of the correlationId fails, then IoTHubMessage_SetCorrelationId shall return IOTHUB_MESSAGE_ERROR.] */
             result = IOTHUB_MESSAGE_ERROR;
@@ -682,12 +977,12 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_SetMessageId(IOTHUB_MESSAGE_HANDLE iotHubMes
         /* Codes_SRS_IOTHUBMESSAGE_07_013: [If the IOTHUB_MESSAGE_HANDLE messageId is not NULL, then the IOTHUB_MESSAGE_HANDLE messageId will be freed] */
         if (handleData->messageId != NULL)
         {
-            free(handleData->messageId);
+            free_message_string(handleData, handleData->messageId);
             handleData->messageId = NULL;
         }
 
         /* Codes_SRS_IOTHUBMESSAGE_07_014: [If the allocation or the copying of the messageId fails, then IoTHubMessage_SetMessageId shall return IOTHUB_MESSAGE_ERROR.] */
-        if (mallocAndStrcpy_s(&handleData->messageId, messageId) != 0)
+        if (copy_message_string(handleData, &handleData->messageId, messageId) != 0)
         {
             result = IOTHUB_MESSAGE_ERROR;
         }
@@ -734,11 +1029,11 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_SetContentTypeSystemProperty(IOTHUB_MESSAGE_
         // Codes_SRS_IOTHUBMESSAGE_09_002: [If the IOTHUB_MESSAGE_HANDLE `contentType` is not NULL it shall be deallocated.]
         if (handleData->userDefinedContentType != NULL)
         {
-            free(handleData->userDefinedContentType);
+            free_message_string(handleData, handleData->userDefinedContentType);
             handleData->userDefinedContentType = NULL;
         }
 
-        if (mallocAndStrcpy_s(&handleData->userDefinedContentType, contentType) != 0)
+        if (copy_message_string(handleData, &handleData->userDefinedContentType, contentType) != 0)
         {
             LogError("Failed saving a copy of contentType");
             // Codes_SRS_IOTHUBMESSAGE_09_003: [If the allocation or the copying of `contentType` fails, then IoTHubMessage_SetContentTypeSystemProperty shall return IOTHUB_MESSAGE_ERROR.]
@@ -998,11 +1293,11 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_SetOutputName(IOTHUB_MESSAGE_HANDLE iotHubMe
         // Codes_SRS_IOTHUBMESSAGE_31_037: [If the IOTHUB_MESSAGE_HANDLE OutputName is not NULL, then the IOTHUB_MESSAGE_HANDLE OutputName will be deallocated.]
         if (handleData->outputName != NULL)
         {
-            free(handleData->outputName);
+            free_message_string(handleData, handleData->outputName);
             handleData->outputName = NULL;
         }
 
-        if (mallocAndStrcpy_s(&handleData->outputName, outputName) != 0)
+        if (copy_message_string(handleData, &handleData->outputName, outputName) != 0)
         {
             // Codes_SRS_IOTHUBMESSAGE_31_038: [If the allocation or the copying of the OutputName fails, then IoTHubMessage_SetOutputName shall return IOTHUB_MESSAGE_ERROR.]
             LogError("Failed saving a copy of outputName");
@@ -1053,11 +1348,11 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_SetInputName(IOTHUB_MESSAGE_HANDLE iotHubMes
         // Codes_SRS_IOTHUBMESSAGE_31_043: [If the IOTHUB_MESSAGE_HANDLE InputName is not NULL, then the IOTHUB_MESSAGE_HANDLE InputName will be deallocated.]
         if (handleData->inputName != NULL)
         {
-            free(handleData->inputName);
+            free_message_string(handleData, handleData->inputName);
             handleData->inputName = NULL;
         }
 
-        if (mallocAndStrcpy_s(&handleData->inputName, inputName) != 0)
+        if (copy_message_string(handleData, &handleData->inputName, inputName) != 0)
         {
             // Codes_SRS_IOTHUBMESSAGE_31_044: [If the allocation or the copying of the InputName fails, then IoTHubMessage_SetInputName shall return IOTHUB_MESSAGE_ERROR.]
             LogError("Failed saving a copy of inputName");
@@ -1109,11 +1404,11 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_SetConnectionModuleId(IOTHUB_MESSAGE_HANDLE
         // Codes_SRS_IOTHUBMESSAGE_31_049: [If the IOTHUB_MESSAGE_HANDLE ConnectionModuleId is not NULL, then the IOTHUB_MESSAGE_HANDLE ConnectionModuleId will be deallocated.]
         if (handleData->connectionModuleId != NULL)
         {
-            free(handleData->connectionModuleId);
+            free_message_string(handleData, handleData->connectionModuleId);
             handleData->connectionModuleId = NULL;
         }
 
-        if (mallocAndStrcpy_s(&handleData->connectionModuleId, connectionModuleId) != 0)
+        if (copy_message_string(handleData, &handleData->connectionModuleId, connectionModuleId) != 0)
         {
             // Codes_SRS_IOTHUBMESSAGE_31_050: [If the allocation or the copying of the ConnectionModuleId fails, then IoTHubMessage_SetConnectionModuleId shall return IOTHUB_MESSAGE_ERROR.]
             LogError("Failed saving a copy of connectionModuleId");
@@ -1165,11 +1460,11 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_SetConnectionDeviceId(IOTHUB_MESSAGE_HANDLE
         // Codes_SRS_IOTHUBMESSAGE_31_055: [If the IOTHUB_MESSAGE_HANDLE ConnectionDeviceId is not NULL, then the IOTHUB_MESSAGE_HANDLE ConnectionDeviceId will be deallocated.]
         if (handleData->connectionDeviceId != NULL)
         {
-            free(handleData->connectionDeviceId);
+            free_message_string(handleData, handleData->connectionDeviceId);
             handleData->connectionDeviceId = NULL;
         }
 
-        if (mallocAndStrcpy_s(&handleData->connectionDeviceId, connectionDeviceId) != 0)
+        if (copy_message_string(handleData, &handleData->connectionDeviceId, connectionDeviceId) != 0)
         {
             // Codes_SRS_IOTHUBMESSAGE_31_056: [If the allocation or the copying of the ConnectionDeviceId fails, then IoTHubMessage_SetConnectionDeviceId shall return IOTHUB_MESSAGE_ERROR.]
             LogError("Failed saving a copy of connectionDeviceId");
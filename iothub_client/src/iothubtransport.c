@@ -9,8 +9,10 @@
 #include "internal/iothubtransport.h"
 #include "iothub_client_core.h"
 #include "internal/iothub_client_private.h"
+#include "internal/iothub_client_thread_id.h"
 #include "azure_c_shared_utility/threadapi.h"
 #include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/vector.h"
 
@@ -19,6 +21,32 @@
 #include "iothub_transport_ll.h"
 #include "iothub_client_core.h"
 
+// Longest the worker thread blocks waiting for work in event driven mode, so the connection is still serviced when idle.
+#define EVENT_DRIVEN_MAX_WAIT_MS 100
+
+// Optional pool of threads running the clients' callback dispatch. A client is at most once in pending or running,
+// so its callbacks never run on two threads at the same time and keep their order.
+typedef struct DISPATCH_POOL_TAG
+{
+    THREAD_HANDLE* threads;
+    size_t threadCount;
+    LOCK_HANDLE lockHandle;
+    COND_HANDLE workAvailable;
+    COND_HANDLE workDone;
+    VECTOR_HANDLE pending;
+    VECTOR_HANDLE running;
+    bool stop;
+} DISPATCH_POOL;
+
+// Element of DISPATCH_POOL::running: a client and the dispatch thread running its callbacks.
+typedef struct DISPATCH_RUNNING_TAG
+{
+    IOTHUB_CLIENT_CORE_HANDLE clientHandle; /*first member, so find_by_handle matches it*/
+#ifdef IOTHUB_THREAD_ID_AVAILABLE
+    IOTHUB_THREAD_ID thread;
+#endif
+} DISPATCH_RUNNING;
+
 typedef struct TRANSPORT_HANDLE_DATA_TAG
 {
     TRANSPORT_LL_HANDLE transportLLHandle;
@@ -29,6 +57,13 @@ typedef struct TRANSPORT_HANDLE_DATA_TAG
     VECTOR_HANDLE clients;
     LOCK_HANDLE clientsLockHandle;
     IOTHUB_CLIENT_MULTIPLEXED_DO_WORK clientDoWork;
+    // Event driven worker thread; workSignal is only created once event driven mode is turned on.
+    bool eventDriven;
+    bool workPending;
+    COND_HANDLE workSignal;
+    // Number of dispatch threads; 0 runs clientDoWork inline on the worker thread.
+    size_t dispatchThreadCount;
+    DISPATCH_POOL* dispatchPool;
 } TRANSPORT_HANDLE_DATA;
 
 /* Used for Unit test */
@@ -127,6 +162,11 @@ TRANSPORT_HANDLE IoTHubTransport_Create(IOTHUB_CLIENT_TRANSPORT_PROVIDER protoco
                         result->stopThread = 1;
                         result->clientDoWork = NULL;
                         result->workerThreadHandle = NULL; /* create thread when work needs to be done */
+                        result->eventDriven = false;
+                        result->workPending = false;
+                        result->workSignal = NULL;
+                        result->dispatchThreadCount = 0;
+                        result->dispatchPool = NULL;
                         result->IoTHubTransport_GetHostname = transportProtocol->IoTHubTransport_GetHostname;
                         result->IoTHubTransport_SetOption = transportProtocol->IoTHubTransport_SetOption;
                         result->IoTHubTransport_Create = transportProtocol->IoTHubTransport_Create;
@@ -147,6 +187,248 @@ TRANSPORT_HANDLE IoTHubTransport_Create(IOTHUB_CLIENT_TRANSPORT_PROVIDER protoco
     return result;
 }
 
+static bool find_by_handle(const void* element, const void* value)
+{
+    /* data stored at element is device handle */
+    const IOTHUB_CLIENT_CORE_HANDLE * guess = (const IOTHUB_CLIENT_CORE_HANDLE *)element;
+    const IOTHUB_CLIENT_CORE_HANDLE match = (const IOTHUB_CLIENT_CORE_HANDLE)value;
+    return (*guess == match);
+}
+
+static int dispatch_pool_thread(void* threadArgument)
+{
+    TRANSPORT_HANDLE_DATA* transportData = (TRANSPORT_HANDLE_DATA*)threadArgument;
+    DISPATCH_POOL* pool = transportData->dispatchPool;
+
+    if (Lock(pool->lockHandle) != LOCK_OK)
+    {
+        LogError("failed to lock for dispatch_pool_thread");
+    }
+    else
+    {
+        while (!pool->stop)
+        {
+            if (VECTOR_size(pool->pending) == 0)
+            {
+                if (Condition_Wait(pool->workAvailable, pool->lockHandle, EVENT_DRIVEN_MAX_WAIT_MS) == COND_ERROR)
+                {
+                    LogError("failed waiting for dispatch work");
+                }
+            }
+            else
+            {
+                IOTHUB_CLIENT_CORE_HANDLE clientHandle = *(IOTHUB_CLIENT_CORE_HANDLE*)VECTOR_element(pool->pending, 0);
+                DISPATCH_RUNNING running;
+                running.clientHandle = clientHandle;
+#ifdef IOTHUB_THREAD_ID_AVAILABLE
+                running.thread = IOTHUB_THREAD_ID_CURRENT();
+#endif
+                VECTOR_erase(pool->pending, VECTOR_element(pool->pending, 0), 1);
+                if (VECTOR_push_back(pool->running, &running, 1) != 0)
+                {
+                    LogError("Failed tracking running client (VECTOR_push_back failed)");
+                }
+                else
+                {
+                    (void)Unlock(pool->lockHandle);
+                    transportData->clientDoWork(clientHandle);
+                    while (Lock(pool->lockHandle) != LOCK_OK)
+                    {
+                        // The client must be taken out of running, or signal_end_worker_thread would wait forever.
+                        LogError("failed to relock for dispatch_pool_thread");
+                        ThreadAPI_Sleep(1);
+                    }
+
+                    VECTOR_erase(pool->running, VECTOR_find_if(pool->running, find_by_handle, clientHandle), 1);
+                    (void)Condition_Post(pool->workDone);
+                }
+            }
+        }
+        (void)Unlock(pool->lockHandle);
+    }
+
+    ThreadAPI_Exit(0);
+    return 0;
+}
+
+static void destroy_dispatch_pool(DISPATCH_POOL* pool)
+{
+    size_t index;
+
+    if (Lock(pool->lockHandle) != LOCK_OK)
+    {
+        LogError("Unable to lock - will still attempt to end dispatch threads without thread safety");
+        pool->stop = true;
+    }
+    else
+    {
+        pool->stop = true;
+        (void)Condition_Post(pool->workAvailable);
+        (void)Unlock(pool->lockHandle);
+    }
+
+    for (index = 0; index < pool->threadCount; index++)
+    {
+        int res;
+        if (ThreadAPI_Join(pool->threads[index], &res) != THREADAPI_OK)
+        {
+            LogError("ThreadAPI_Join failed for dispatch thread %lu", (unsigned long)index);
+        }
+    }
+
+    VECTOR_destroy(pool->running);
+    VECTOR_destroy(pool->pending);
+    Condition_Deinit(pool->workDone);
+    Condition_Deinit(pool->workAvailable);
+    Lock_Deinit(pool->lockHandle);
+    free(pool->threads);
+    free(pool);
+}
+
+static DISPATCH_POOL* create_dispatch_pool(TRANSPORT_HANDLE_DATA* transportData)
+{
+    DISPATCH_POOL* result = (DISPATCH_POOL*)malloc(sizeof(DISPATCH_POOL));
+    if (result == NULL)
+    {
+        LogError("Failed allocating dispatch pool");
+    }
+    else
+    {
+        memset(result, 0, sizeof(DISPATCH_POOL));
+        if ((result->threads = (THREAD_HANDLE*)malloc(transportData->dispatchThreadCount * sizeof(THREAD_HANDLE))) == NULL)
+        {
+            LogError("Failed allocating dispatch threads");
+            free(result);
+            result = NULL;
+        }
+        else if ((result->lockHandle = Lock_Init()) == NULL)
+        {
+            LogError("dispatch Lock not created.");
+            free(result->threads);
+            free(result);
+            result = NULL;
+        }
+        else if ((result->workAvailable = Condition_Init()) == NULL || (result->workDone = Condition_Init()) == NULL)
+        {
+            LogError("dispatch conditions not created.");
+            if (result->workAvailable != NULL)
+            {
+                Condition_Deinit(result->workAvailable);
+            }
+            Lock_Deinit(result->lockHandle);
+            free(result->threads);
+            free(result);
+            result = NULL;
+        }
+        else if ((result->pending = VECTOR_create(sizeof(IOTHUB_CLIENT_CORE_HANDLE))) == NULL || (result->running = VECTOR_create(sizeof(DISPATCH_RUNNING))) == NULL)
+        {
+            LogError("dispatch lists not created.");
+            if (result->pending != NULL)
+            {
+                VECTOR_destroy(result->pending);
+            }
+            Condition_Deinit(result->workDone);
+            Condition_Deinit(result->workAvailable);
+            Lock_Deinit(result->lockHandle);
+            free(result->threads);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            // The threads read the pool through transportData, so it has to be published before they start.
+            transportData->dispatchPool = result;
+            for (result->threadCount = 0; result->threadCount < transportData->dispatchThreadCount; result->threadCount++)
+            {
+                if (ThreadAPI_Create(&result->threads[result->threadCount], dispatch_pool_thread, transportData) != THREADAPI_OK)
+                {
+                    LogError("Failed creating dispatch thread %lu", (unsigned long)result->threadCount);
+                    break;
+                }
+            }
+
+            if (result->threadCount != transportData->dispatchThreadCount)
+            {
+                destroy_dispatch_pool(result);
+                transportData->dispatchPool = NULL;
+                result = NULL;
+            }
+        }
+    }
+    return result;
+}
+
+//
+// dispatch_pool_schedule queues a client for a dispatch thread. A client that is already pending or running is
+// skipped; the worker thread passes over it again on its next iteration.
+//
+static void dispatch_pool_schedule(DISPATCH_POOL* pool, IOTHUB_CLIENT_CORE_HANDLE clientHandle)
+{
+    if (Lock(pool->lockHandle) != LOCK_OK)
+    {
+        LogError("failed to lock for dispatch_pool_schedule");
+    }
+    else
+    {
+        if (VECTOR_find_if(pool->pending, find_by_handle, clientHandle) == NULL &&
+            VECTOR_find_if(pool->running, find_by_handle, clientHandle) == NULL)
+        {
+            if (VECTOR_push_back(pool->pending, &clientHandle, 1) != 0)
+            {
+                LogError("Failed queuing client for dispatch (VECTOR_push_back failed)");
+            }
+            else
+            {
+                (void)Condition_Post(pool->workAvailable);
+            }
+        }
+        (void)Unlock(pool->lockHandle);
+    }
+}
+
+static bool is_dispatch_thread_of(const DISPATCH_RUNNING* running)
+{
+#ifdef IOTHUB_THREAD_ID_AVAILABLE
+    return IOTHUB_THREAD_ID_EQUAL(running->thread, IOTHUB_THREAD_ID_CURRENT());
+#else
+    (void)running;
+    return false;
+#endif
+}
+
+//
+// dispatch_pool_remove_client drops a client from the pool, waiting for a dispatch already running for it to return so
+// the client can be destroyed safely. When the client is destroyed from one of its own callbacks, that dispatch is the
+// caller: the wait is skipped and the dispatch thread takes the client out of running once the callback returns.
+// Platforms without a thread id cannot tell the caller apart, so there a pooled client must not be destroyed from its
+// own callbacks.
+//
+static void dispatch_pool_remove_client(DISPATCH_POOL* pool, IOTHUB_CLIENT_CORE_HANDLE clientHandle)
+{
+    if (Lock(pool->lockHandle) != LOCK_OK)
+    {
+        LogError("failed to lock for dispatch_pool_remove_client");
+    }
+    else
+    {
+        DISPATCH_RUNNING* running;
+        void* element = VECTOR_find_if(pool->pending, find_by_handle, clientHandle);
+        if (element != NULL)
+        {
+            VECTOR_erase(pool->pending, element, 1);
+        }
+
+        while (((running = (DISPATCH_RUNNING*)VECTOR_find_if(pool->running, find_by_handle, clientHandle)) != NULL) && !is_dispatch_thread_of(running))
+        {
+            if (Condition_Wait(pool->workDone, pool->lockHandle, EVENT_DRIVEN_MAX_WAIT_MS) == COND_ERROR)
+            {
+                LogError("failed waiting for client dispatch to finish");
+            }
+        }
+        (void)Unlock(pool->lockHandle);
+    }
+}
+
 static void multiplexed_client_do_work(TRANSPORT_HANDLE_DATA* transportData)
 {
     if (Lock(transportData->clientsLockHandle) != LOCK_OK)
@@ -165,7 +447,14 @@ static void multiplexed_client_do_work(TRANSPORT_HANDLE_DATA* transportData)
 
             if (clientHandle != NULL)
             {
-                transportData->clientDoWork(*clientHandle);
+                if (transportData->dispatchPool != NULL)
+                {
+                    dispatch_pool_schedule(transportData->dispatchPool, *clientHandle);
+                }
+                else
+                {
+                    transportData->clientDoWork(*clientHandle);
+                }
             }
         }
 
@@ -176,6 +465,39 @@ static void multiplexed_client_do_work(TRANSPORT_HANDLE_DATA* transportData)
     }
 }
 
+//
+// wait_for_work is used in event driven mode in place of the fixed 1 ms sleep.  If work was signaled while the last pass
+// ran the thread keeps polling every 1 ms, otherwise it blocks until signaled or EVENT_DRIVEN_MAX_WAIT_MS elapses.
+//
+static void wait_for_work(TRANSPORT_HANDLE_DATA* transportData)
+{
+    bool workPending;
+
+    if (Lock(transportData->lockHandle) != LOCK_OK)
+    {
+        LogError("failed to lock for wait_for_work");
+        workPending = true;
+    }
+    else
+    {
+        workPending = transportData->workPending;
+        if (!workPending && !transportData->stopThread)
+        {
+            if (Condition_Wait(transportData->workSignal, transportData->lockHandle, EVENT_DRIVEN_MAX_WAIT_MS) == COND_ERROR)
+            {
+                LogError("failed waiting for work");
+            }
+        }
+        transportData->workPending = false;
+        (void)Unlock(transportData->lockHandle);
+    }
+
+    if (workPending)
+    {
+        ThreadAPI_Sleep(1);
+    }
+}
+
 static int transport_worker_thread(void* threadArgument)
 {
     TRANSPORT_HANDLE_DATA* transportData = (TRANSPORT_HANDLE_DATA*)threadArgument;
@@ -202,26 +524,29 @@ static int transport_worker_thread(void* threadArgument)
 
         multiplexed_client_do_work(transportData);
 
-        /*Codes_SRS_IOTHUBTRANSPORT_17_029: [ The thread shall call lower layer transport DoWork every 1 ms. ]*/
-        ThreadAPI_Sleep(1);
+        if (transportData->eventDriven)
+        {
+            wait_for_work(transportData);
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBTRANSPORT_17_029: [ The thread shall call lower layer transport DoWork every 1 ms. ]*/
+            ThreadAPI_Sleep(1);
+        }
     }
 
     ThreadAPI_Exit(0);
     return 0;
 }
 
-static bool find_by_handle(const void* element, const void* value)
-{
-    /* data stored at element is device handle */
-    const IOTHUB_CLIENT_CORE_HANDLE * guess = (const IOTHUB_CLIENT_CORE_HANDLE *)element;
-    const IOTHUB_CLIENT_CORE_HANDLE match = (const IOTHUB_CLIENT_CORE_HANDLE)value;
-    return (*guess == match);
-}
-
 static IOTHUB_CLIENT_RESULT start_worker_if_needed(TRANSPORT_HANDLE_DATA * transportData, IOTHUB_CLIENT_CORE_HANDLE clientHandle)
 {
     IOTHUB_CLIENT_RESULT result;
-    if (transportData->workerThreadHandle == NULL)
+    if ((transportData->dispatchThreadCount > 0) && (transportData->dispatchPool == NULL) && (create_dispatch_pool(transportData) == NULL))
+    {
+        LogError("Failed creating dispatch pool");
+    }
+    else if (transportData->workerThreadHandle == NULL)
     {
         /*Codes_SRS_IOTHUBTRANSPORT_17_018: [ If the worker thread does not exist, IoTHubTransport_StartWorkerThread shall start the thread using ThreadAPI_Create. ]*/
         transportData->stopThread = 0;
@@ -286,6 +611,10 @@ static void stop_worker_thread(TRANSPORT_HANDLE_DATA* transportData)
     else
     {
         transportData->stopThread = 1;
+        if (transportData->workSignal != NULL)
+        {
+            (void)Condition_Post(transportData->workSignal);
+        }
         (void)Unlock(transportData->lockHandle);
     }
 
@@ -347,6 +676,12 @@ static bool signal_end_worker_thread(TRANSPORT_HANDLE_DATA * transportData, IOTH
         {
             LogError("failed to unlock on signal_end_worker_thread");
         }
+
+        // Done outside the clients lock, as the client's callbacks may be calling back into the transport.
+        if (transportData->dispatchPool != NULL)
+        {
+            dispatch_pool_remove_client(transportData->dispatchPool, clientHandle);
+        }
     }
     return okToJoin;
 }
@@ -360,7 +695,15 @@ void IoTHubTransport_Destroy(TRANSPORT_HANDLE transportHandle)
         /*Codes_SRS_IOTHUBTRANSPORT_17_033: [ IoTHubTransport_Destroy shall lock the transport lock. ]*/
         stop_worker_thread(transportData);
         wait_worker_thread(transportData);
+        if (transportData->dispatchPool != NULL)
+        {
+            destroy_dispatch_pool(transportData->dispatchPool);
+        }
         /*Codes_SRS_IOTHUBTRANSPORT_17_010: [ IoTHubTransport_Destroy shall free all resources. ]*/
+        if (transportData->workSignal != NULL)
+        {
+            Condition_Deinit(transportData->workSignal);
+        }
         Lock_Deinit(transportData->lockHandle);
         (transportData->IoTHubTransport_Destroy)(transportData->transportLLHandle);
         VECTOR_destroy(transportData->clients);
@@ -463,3 +806,94 @@ void IoTHubTransport_JoinWorkerThread(TRANSPORT_HANDLE transportHandle, IOTHUB_C
         wait_worker_thread(transportData);
     }
 }
+
+IOTHUB_CLIENT_RESULT IoTHubTransport_SetEventDrivenDoWork(TRANSPORT_HANDLE transportHandle, bool eventDriven)
+{
+    IOTHUB_CLIENT_RESULT result;
+    if (transportHandle == NULL)
+    {
+        LogError("Invalid NULL transportHandle");
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else
+    {
+        // The transport lock is held by the caller.
+        TRANSPORT_HANDLE_DATA * transportData = (TRANSPORT_HANDLE_DATA*)transportHandle;
+        if (eventDriven && (transportData->workSignal == NULL) && ((transportData->workSignal = Condition_Init()) == NULL))
+        {
+            LogError("failed creating condition for event driven worker thread");
+            result = IOTHUB_CLIENT_ERROR;
+        }
+        else
+        {
+            transportData->eventDriven = eventDriven;
+            if (transportData->workSignal != NULL)
+            {
+                // Let a waiting worker thread pick up the new mode.
+                transportData->workPending = true;
+                (void)Condition_Post(transportData->workSignal);
+            }
+            result = IOTHUB_CLIENT_OK;
+        }
+    }
+    return result;
+}
+
+void IoTHubTransport_SignalWork(TRANSPORT_HANDLE transportHandle)
+{
+    if (transportHandle != NULL)
+    {
+        // The transport lock is held by the caller.
+        TRANSPORT_HANDLE_DATA * transportData = (TRANSPORT_HANDLE_DATA*)transportHandle;
+        if (transportData->eventDriven)
+        {
+            transportData->workPending = true;
+            if (Condition_Post(transportData->workSignal) != COND_OK)
+            {
+                LogError("failed signaling worker thread");
+            }
+        }
+    }
+}
+
+bool IoTHubTransport_IsEventDriven(TRANSPORT_HANDLE transportHandle)
+{
+    bool result;
+    if (transportHandle == NULL)
+    {
+        LogError("Invalid NULL transportHandle");
+        result = false;
+    }
+    else
+    {
+        // The transport lock is held by the caller.
+        TRANSPORT_HANDLE_DATA * transportData = (TRANSPORT_HANDLE_DATA*)transportHandle;
+        result = transportData->eventDriven;
+    }
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubTransport_SetDispatchThreadCount(TRANSPORT_HANDLE transportHandle, size_t threadCount)
+{
+    IOTHUB_CLIENT_RESULT result;
+    if (transportHandle == NULL)
+    {
+        LogError("Invalid NULL transportHandle");
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else
+    {
+        TRANSPORT_HANDLE_DATA * transportData = (TRANSPORT_HANDLE_DATA*)transportHandle;
+        if (transportData->dispatchPool != NULL || transportData->workerThreadHandle != NULL)
+        {
+            LogError("The dispatch thread count must be set before the worker thread is started");
+            result = IOTHUB_CLIENT_ERROR;
+        }
+        else
+        {
+            transportData->dispatchThreadCount = threadCount;
+            result = IOTHUB_CLIENT_OK;
+        }
+    }
+    return result;
+}
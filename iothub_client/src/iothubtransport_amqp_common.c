@@ -10,7 +10,6 @@
 #include "azure_c_shared_utility/agenttime.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/platform.h"
@@ -34,6 +33,7 @@
 #include "internal/iothubtransport_amqp_common.h"
 #include "internal/iothubtransport_amqp_connection.h"
 #include "internal/iothubtransport_amqp_device.h"
+#include "internal/iothubtransport_amqp_device_index.h"
 #include "internal/iothubtransport.h"
 #include "iothub_client_version.h"
 #include "internal/iothub_transport_ll_private.h"
@@ -52,6 +52,7 @@
 #define DEFAULT_MAX_RETRY_TIME_IN_SECS            0
 #define MAX_SERVICE_KEEP_ALIVE_RATIO              0.9
 #define DEFAULT_DEVICE_STOP_DELAY                 10
+#define DEFAULT_IDLE_DEVICE_DO_WORK_INTERVAL_SECS 1
 
 // ---------- Data Definitions ---------- //
 
@@ -103,7 +104,11 @@ typedef struct AMQP_TRANSPORT_INSTANCE_TAG
     AMQP_CONNECTION_HANDLE amqp_connection;                             // Base amqp connection with service.
     AMQP_CONNECTION_STATE amqp_connection_state;                        // Current state of the amqp_connection.
     AMQP_TRANSPORT_AUTHENTICATION_MODE preferred_authentication_mode;   // Used to avoid registered devices using different authentication modes.
-    SINGLYLINKEDLIST_HANDLE registered_devices;                         // List of devices currently registered in this transport.
+    DLIST_ENTRY registered_devices;                                     // List of devices currently registered in this transport.
+    DLIST_ENTRY ready_devices;                                          // Registered devices DoWork visits on every call.
+    DLIST_ENTRY idle_devices;                                           // Registered devices with nothing to do, in the order they went idle.
+    size_t number_of_ready_devices;                                     // Number of devices in ready_devices.
+    AMQP_DEVICE_INDEX_HANDLE registered_devices_index;                  // Devices in registered_devices, indexed by device id and module id.
     bool is_trace_on;                                                   // Turns logging on and off.
     OPTIONHANDLER_HANDLE saved_tls_options;                             // Here are the options from the xio layer if any is saved.
     AMQP_TRANSPORT_STATE state;                                         // Current state of the transport.
@@ -129,6 +134,11 @@ typedef struct AMQP_TRANSPORT_INSTANCE_TAG
 typedef struct AMQP_TRANSPORT_DEVICE_INSTANCE_TAG
 {
     STRING_HANDLE device_id;                                            // Identity of the device.
+    STRING_HANDLE module_id;                                            // Identity of the module, or NULL if the device is not a module.
+    DLIST_ENTRY registered_entry;                                       // Entry of this device in the registered_devices list of the transport.
+    DLIST_ENTRY schedule_entry;                                         // Entry of this device in either the ready_devices or the idle_devices list of the transport.
+    bool is_idle;                                                       // Indicates if schedule_entry is in idle_devices.
+    time_t idle_since;                                                  // Time the device was moved to idle_devices.
     AMQP_DEVICE_HANDLE device_handle;                                   // Logic unit that performs authentication, messaging, etc.
     AMQP_TRANSPORT_INSTANCE* transport_instance;                        // Saved reference to the transport the device is registered on.
     PDLIST_ENTRY waiting_to_send;                                       // List of events waiting to be sent to the iot hub (i.e., haven't been processed by the transport yet).
@@ -239,6 +249,11 @@ static void internal_destroy_amqp_device_instance(AMQP_TRANSPORT_DEVICE_INSTANCE
         STRING_delete(trdev_inst->device_id);
     }
 
+    if (trdev_inst->module_id != NULL)
+    {
+        STRING_delete(trdev_inst->module_id);
+    }
+
     free(trdev_inst);
 }
 
@@ -261,15 +276,66 @@ static DEVICE_AUTH_MODE get_authentication_mode(const IOTHUB_DEVICE_CONFIG* devi
     return result;
 }
 
-static void raise_connection_status_callback_retry_expired(const void* item, const void* action_context, bool* continue_processing)
+// @brief       Moves an idle device back to the list of devices DoWork visits on every call.
+static void set_device_ready(AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device)
 {
-    (void)action_context;
+    if (registered_device->is_idle)
+    {
+        AMQP_TRANSPORT_INSTANCE* transport_instance = registered_device->transport_instance;
 
-    AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device = (AMQP_TRANSPORT_DEVICE_INSTANCE*)item;
+        (void)DList_RemoveEntryList(&registered_device->schedule_entry);
+        DList_InsertTailList(&transport_instance->ready_devices, &registered_device->schedule_entry);
+        registered_device->is_idle = false;
+        transport_instance->number_of_ready_devices++;
+    }
+}
 
-    registered_device->transport_callbacks.connection_status_cb(IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED, IOTHUB_CLIENT_CONNECTION_RETRY_EXPIRED, registered_device->transport_ctx);
+// @brief       Parks a device that has nothing to send or wait for; DoWork only visits it again once it is
+//              woken by new work or after DEFAULT_IDLE_DEVICE_DO_WORK_INTERVAL_SECS, for its timeouts and keep-alives.
+static void set_device_idle(AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device, time_t current_time)
+{
+    AMQP_TRANSPORT_INSTANCE* transport_instance = registered_device->transport_instance;
 
-    *continue_processing = true;
+    (void)DList_RemoveEntryList(&registered_device->schedule_entry);
+    DList_InsertTailList(&transport_instance->idle_devices, &registered_device->schedule_entry);
+    registered_device->is_idle = true;
+    registered_device->idle_since = current_time;
+    transport_instance->number_of_ready_devices--;
+}
+
+// @brief       Verifies if a device has nothing left for DoWork to do until new work is queued on it.
+static bool is_device_idle(AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device)
+{
+    DEVICE_SEND_STATUS send_status = DEVICE_SEND_STATUS_BUSY;
+
+    return (registered_device->device_state == DEVICE_STATE_STARTED &&
+        (!registered_device->subscribe_methods_needed || registered_device->subscribed_for_methods) &&
+        registered_device->number_of_send_event_complete_failures == 0 &&
+        amqp_device_get_send_status(registered_device->device_handle, &send_status) == RESULT_OK &&
+        send_status == DEVICE_SEND_STATUS_IDLE);
+}
+
+// @brief       Moves back to the ready list the idle devices whose deadline has passed.
+//              idle_devices is ordered by idle_since, so this stops at the first device still within its interval.
+static void wake_idle_devices(AMQP_TRANSPORT_INSTANCE* transport_instance, time_t current_time)
+{
+    while (!DList_IsListEmpty(&transport_instance->idle_devices))
+    {
+        AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device = containingRecord(transport_instance->idle_devices.Flink, AMQP_TRANSPORT_DEVICE_INSTANCE, schedule_entry);
+
+        if (current_time != INDEFINITE_TIME &&
+            get_difftime(current_time, registered_device->idle_since) < DEFAULT_IDLE_DEVICE_DO_WORK_INTERVAL_SECS)
+        {
+            break;
+        }
+
+        set_device_ready(registered_device);
+    }
+}
+
+static void raise_connection_status_callback_retry_expired(AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device)
+{
+    registered_device->transport_callbacks.connection_status_cb(IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED, IOTHUB_CLIENT_CONNECTION_RETRY_EXPIRED, registered_device->transport_ctx);
 }
 
 // @brief
@@ -284,6 +350,7 @@ static void on_device_state_changed_callback(void* context, DEVICE_STATE previou
         registered_device->device_state = new_state;
         // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_063: [If `registered_device->time_of_last_state_change` shall be set using get_time()]
         registered_device->time_of_last_state_change = get_time(NULL);
+        set_device_ready(registered_device);
 
         if (new_state == DEVICE_STATE_STARTED)
         {
@@ -315,45 +382,13 @@ static void on_device_state_changed_callback(void* context, DEVICE_STATE previou
     }
 }
 
-// @brief    Auxiliary function to be used to find a device in the registered_devices list.
-// @returns  true if the device ids match, false otherwise.
-static bool find_device_by_id_callback(LIST_ITEM_HANDLE list_item, const void* match_context)
+static const char* get_module_id(AMQP_TRANSPORT_DEVICE_INSTANCE* amqp_device_instance)
 {
-    bool result;
-
-    if (match_context == NULL)
-    {
-        result = false;
-    }
-    else
-    {
-        AMQP_TRANSPORT_DEVICE_INSTANCE* device_instance = (AMQP_TRANSPORT_DEVICE_INSTANCE*)singlylinkedlist_item_get_value(list_item);
-
-        if (device_instance == NULL ||
-            device_instance->device_id == NULL ||
-            STRING_c_str(device_instance->device_id) != match_context)
-        {
-            result = false;
-        }
-        else
-        {
-            result = true;
-        }
-    }
-
-    return result;
+    return (amqp_device_instance->module_id == NULL ? NULL : STRING_c_str(amqp_device_instance->module_id));
 }
 
-// @brief       Verifies if a device is already registered within the transport that owns the list of registered devices.
-// @remarks     Returns the correspoding LIST_ITEM_HANDLE in registered_devices, if found.
-// @returns     true if the device is already in the list, false otherwise.
-static bool is_device_registered_ex(SINGLYLINKEDLIST_HANDLE registered_devices, const char* device_id, LIST_ITEM_HANDLE *list_item)
-{
-    return ((*list_item = singlylinkedlist_find(registered_devices, find_device_by_id_callback, device_id)) != NULL ? 1 : 0);
-}
-
-// @brief       Verifies if a device is already registered within the transport that owns the list of registered devices.
-// @returns     true if the device is already in the list, false otherwise.
+// @brief       Verifies if a device is registered within the transport it references.
+// @returns     true if the device is in the index of registered devices of its transport, false otherwise.
 static bool is_device_registered(AMQP_TRANSPORT_DEVICE_INSTANCE* amqp_device_instance)
 {
     if (amqp_device_instance == NULL)
@@ -363,25 +398,14 @@ static bool is_device_registered(AMQP_TRANSPORT_DEVICE_INSTANCE* amqp_device_ins
     }
     else
     {
-        LIST_ITEM_HANDLE list_item;
         const char* device_id = STRING_c_str(amqp_device_instance->device_id);
-        return is_device_registered_ex(amqp_device_instance->transport_instance->registered_devices, device_id, &list_item);
+        return (amqp_device_index_find(amqp_device_instance->transport_instance->registered_devices_index, device_id, get_module_id(amqp_device_instance)) == amqp_device_instance);
     }
 }
 
 static size_t get_number_of_registered_devices(AMQP_TRANSPORT_INSTANCE* transport)
 {
-    size_t result = 0;
-
-    LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(transport->registered_devices);
-
-    while (list_item != NULL)
-    {
-        result++;
-        list_item = singlylinkedlist_get_next_item(list_item);
-    }
-
-    return result;
+    return amqp_device_index_get_count(transport->registered_devices_index);
 }
 
 
@@ -510,6 +534,7 @@ static void on_methods_unsubscribed(void* context)
 
     iothubtransportamqp_methods_unsubscribe(device_state->methods_handle);
     device_state->subscribed_for_methods = false;
+    set_device_ready(device_state);
 }
 
 static int on_method_request_received(void* context, const char* method_name, const unsigned char* request, size_t request_size, IOTHUBTRANSPORT_AMQP_METHOD_HANDLE method_handle)
@@ -906,22 +931,16 @@ void prepare_for_connection_retry(AMQP_TRANSPORT_INSTANCE* transport_instance)
         LogError("Failed saving TLS I/O options while preparing for connection retry; failure will be ignored");
     }
 
-    LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(transport_instance->registered_devices);
+    PDLIST_ENTRY entry = transport_instance->registered_devices.Flink;
 
-    while (list_item != NULL)
+    while (entry != &transport_instance->registered_devices)
     {
-        AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device = (AMQP_TRANSPORT_DEVICE_INSTANCE*)singlylinkedlist_item_get_value(list_item);
+        AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device = containingRecord(entry, AMQP_TRANSPORT_DEVICE_INSTANCE, registered_entry);
 
-        if (registered_device == NULL)
-        {
-            LogError("Failed preparing device for connection retry (singlylinkedlist_item_get_value failed)");
-        }
-        else
-        {
-            prepare_device_for_connection_retry(registered_device);
-        }
+        prepare_device_for_connection_retry(registered_device);
+        set_device_ready(registered_device);
 
-        list_item = singlylinkedlist_get_next_item(list_item);
+        entry = entry->Flink;
     }
 
     // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_033: [`instance->connection` shall be destroyed using amqp_connection_destroy()]
@@ -1289,19 +1308,13 @@ static int IoTHubTransport_AMQP_Common_Device_SetOption(TRANSPORT_LL_HANDLE hand
         AMQP_TRANSPORT_INSTANCE* instance = (AMQP_TRANSPORT_INSTANCE*)handle;
         result = RESULT_OK;
 
-        LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(instance->registered_devices);
+        PDLIST_ENTRY entry = instance->registered_devices.Flink;
 
-        while (list_item != NULL)
+        while (entry != &instance->registered_devices)
         {
-            AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device;
+            AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device = containingRecord(entry, AMQP_TRANSPORT_DEVICE_INSTANCE, registered_entry);
 
-            if ((registered_device = (AMQP_TRANSPORT_DEVICE_INSTANCE*)singlylinkedlist_item_get_value(list_item)) == NULL)
-            {
-                LogError("failed setting option '%s' to registered device (singlylinkedlist_item_get_value failed)", option);
-                result = MU_FAILURE;
-                break;
-            }
-            else if (amqp_device_set_option(registered_device->device_handle, device_option, value) != RESULT_OK)
+            if (amqp_device_set_option(registered_device->device_handle, device_option, value) != RESULT_OK)
             {
                 LogError("failed setting option '%s' to registered device '%s' (amqp_device_set_option failed)",
                     option, STRING_c_str(registered_device->device_id));
@@ -1309,7 +1322,7 @@ static int IoTHubTransport_AMQP_Common_Device_SetOption(TRANSPORT_LL_HANDLE hand
                 break;
             }
 
-            list_item = singlylinkedlist_get_next_item(list_item);
+            entry = entry->Flink;
         }
     }
 
@@ -1322,18 +1335,18 @@ static void internal_destroy_instance(AMQP_TRANSPORT_INSTANCE* instance)
     {
         update_state(instance, AMQP_TRANSPORT_STATE_BEING_DESTROYED);
 
-        if (instance->registered_devices != NULL)
-        {
-            LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(instance->registered_devices);
+        PDLIST_ENTRY entry = instance->registered_devices.Flink;
 
-            while (list_item != NULL)
-            {
-                AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device = (AMQP_TRANSPORT_DEVICE_INSTANCE*)singlylinkedlist_item_get_value(list_item);
-                list_item = singlylinkedlist_get_next_item(list_item);
-                IoTHubTransport_AMQP_Common_Unregister(registered_device);
-            }
+        while (entry != &instance->registered_devices)
+        {
+            AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device = containingRecord(entry, AMQP_TRANSPORT_DEVICE_INSTANCE, registered_entry);
+            entry = entry->Flink;
+            IoTHubTransport_AMQP_Common_Unregister(registered_device);
+        }
 
-            singlylinkedlist_destroy(instance->registered_devices);
+        if (instance->registered_devices_index != NULL)
+        {
+            amqp_device_index_destroy(instance->registered_devices_index);
         }
 
         if (instance->amqp_connection != NULL)
@@ -1426,6 +1439,10 @@ TRANSPORT_LL_HANDLE IoTHubTransport_AMQP_Common_Create(const IOTHUBTRANSPORT_CON
             instance->preferred_authentication_mode = AMQP_TRANSPORT_AUTHENTICATION_MODE_NOT_SET;
             instance->state = AMQP_TRANSPORT_STATE_NOT_CONNECTED;
             instance->authorization_module = config->auth_module_handle;
+            // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_008: [`instance->registered_devices` shall be initialized using DList_InitializeListHead(), as well as the lists of ready and idle devices]
+            DList_InitializeListHead(&instance->registered_devices);
+            DList_InitializeListHead(&instance->ready_devices);
+            DList_InitializeListHead(&instance->idle_devices);
 
             // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_124: [`instance->connection_retry_control` shall be set using retry_control_create(), passing defaults EXPONENTIAL_BACKOFF_WITH_JITTER and 0]
             if ((instance->connection_retry_control = retry_control_create(DEFAULT_RETRY_POLICY, DEFAULT_MAX_RETRY_TIME_IN_SECS)) == NULL)
@@ -1442,11 +1459,11 @@ TRANSPORT_LL_HANDLE IoTHubTransport_AMQP_Common_Create(const IOTHUBTRANSPORT_CON
                 LogError("Failed to obtain the iothub target fqdn.");
                 result = NULL;
             }
-            // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_008: [`instance->registered_devices` shall be set using singlylinkedlist_create()]
-            else if ((instance->registered_devices = singlylinkedlist_create()) == NULL)
+            // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_31_001: [`instance->registered_devices_index` shall be set using amqp_device_index_create()]
+            else if ((instance->registered_devices_index = amqp_device_index_create()) == NULL)
             {
-                // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_009: [If singlylinkedlist_create() fails, IoTHubTransport_AMQP_Common_Create shall fail and return NULL]
-                LogError("Failed to initialize the internal list of registered devices (singlylinkedlist_create failed)");
+                // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_31_002: [If amqp_device_index_create() fails, IoTHubTransport_AMQP_Common_Create shall fail and return NULL]
+                LogError("Failed to initialize the index of registered devices (amqp_device_index_create failed)");
                 result = NULL;
             }
             else
@@ -1470,6 +1487,7 @@ TRANSPORT_LL_HANDLE IoTHubTransport_AMQP_Common_Create(const IOTHUBTRANSPORT_CON
                 instance->transport_callbacks.twin_rpt_state_complete_cb = cb_info->twin_rpt_state_complete_cb;
                 instance->transport_callbacks.twin_retrieve_prop_complete_cb = cb_info->twin_retrieve_prop_complete_cb;
                 instance->transport_callbacks.method_complete_cb = cb_info->method_complete_cb;
+                instance->transport_callbacks.event_sent_cb = cb_info->event_sent_cb;
 
                 // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_012: [If IoTHubTransport_AMQP_Common_Create succeeds it shall return a pointer to `instance`.]
                 result = (TRANSPORT_LL_HANDLE)instance;
@@ -1530,6 +1548,7 @@ IOTHUB_PROCESS_ITEM_RESULT IoTHubTransport_AMQP_Common_ProcessItem(TRANSPORT_LL_
                 }
                 else
                 {
+                    set_device_ready(registered_device);
                     // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_150: [If no errors occur, `IoTHubTransport_AMQP_Common_ProcessItem` shall return IOTHUB_PROCESS_OK.]
                     result = IOTHUB_PROCESS_OK;
                 }
@@ -1556,7 +1575,6 @@ void IoTHubTransport_AMQP_Common_DoWork(TRANSPORT_LL_HANDLE handle)
     else
     {
         AMQP_TRANSPORT_INSTANCE* transport_instance = (AMQP_TRANSPORT_INSTANCE*)handle;
-        LIST_ITEM_HANDLE list_item;
 
         if (transport_instance->state == AMQP_TRANSPORT_STATE_NOT_CONNECTED_NO_MORE_RETRIES)
         {
@@ -1582,13 +1600,20 @@ void IoTHubTransport_AMQP_Common_DoWork(TRANSPORT_LL_HANDLE handle)
             {
                 update_state(transport_instance, AMQP_TRANSPORT_STATE_NOT_CONNECTED_NO_MORE_RETRIES);
 
-                (void)singlylinkedlist_foreach(transport_instance->registered_devices, raise_connection_status_callback_retry_expired, NULL);
+                PDLIST_ENTRY entry = transport_instance->registered_devices.Flink;
+
+                while (entry != &transport_instance->registered_devices)
+                {
+                    AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device = containingRecord(entry, AMQP_TRANSPORT_DEVICE_INSTANCE, registered_entry);
+                    entry = entry->Flink;
+                    raise_connection_status_callback_retry_expired(registered_device);
+                }
             }
         }
         else
         {
             // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_018: [If there are no devices registered on the transport, IoTHubTransport_AMQP_Common_DoWork shall skip do_work for devices]
-            if ((list_item = singlylinkedlist_get_head_item(transport_instance->registered_devices)) != NULL)
+            if (!DList_IsListEmpty(&transport_instance->registered_devices))
             {
                 // We need to check if there are devices, otherwise the amqp_connection won't be able to be created since
                 // there is not a preferred authentication mode set yet on the transport.
@@ -1604,18 +1629,31 @@ void IoTHubTransport_AMQP_Common_DoWork(TRANSPORT_LL_HANDLE handle)
                 // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_020: [If the amqp_connection is OPENED, the transport shall iterate through each registered device and perform a device-specific do_work on each]
                 else if (transport_instance->amqp_connection_state == AMQP_CONNECTION_STATE_OPENED)
                 {
-                    size_t number_of_devices = 0;
+                    time_t current_time = get_time(NULL);
+                    size_t number_of_devices_to_visit;
                     size_t number_of_faulty_devices = 0;
 
-                    while (list_item != NULL)
+                    wake_idle_devices(transport_instance, current_time);
+
+                    // Only the ready devices are visited. Each is rotated to the tail before its do_work, so devices woken
+                    // by callbacks during the loop are appended behind it and visited on the next call.
+                    number_of_devices_to_visit = transport_instance->number_of_ready_devices;
+
+                    while (number_of_devices_to_visit > 0)
                     {
+                        PDLIST_ENTRY entry = DList_RemoveHeadList(&transport_instance->ready_devices);
                         AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device;
 
-                        if ((registered_device = (AMQP_TRANSPORT_DEVICE_INSTANCE*)singlylinkedlist_item_get_value(list_item)) == NULL)
+                        if (entry == &transport_instance->ready_devices)
                         {
-                            LogError("Transport had an unexpected failure during DoWork (failed to fetch a registered_devices list item value)");
+                            break;
                         }
-                        else if (registered_device->number_of_send_event_complete_failures >= DEVICE_FAILURE_COUNT_RECONNECTION_THRESHOLD)
+
+                        DList_InsertTailList(&transport_instance->ready_devices, entry);
+                        registered_device = containingRecord(entry, AMQP_TRANSPORT_DEVICE_INSTANCE, schedule_entry);
+                        number_of_devices_to_visit--;
+
+                        if (registered_device->number_of_send_event_complete_failures >= DEVICE_FAILURE_COUNT_RECONNECTION_THRESHOLD)
                         {
                             number_of_faulty_devices++;
                         }
@@ -1627,17 +1665,23 @@ void IoTHubTransport_AMQP_Common_DoWork(TRANSPORT_LL_HANDLE handle)
                                 number_of_faulty_devices++;
                             }
                         }
-
-                        list_item = singlylinkedlist_get_next_item(list_item);
-                        number_of_devices++;
+                        else if (is_device_idle(registered_device))
+                        {
+                            set_device_idle(registered_device, current_time);
+                        }
                     }
 
-                    if (number_of_faulty_devices > 0 &&
-                        ((float)number_of_faulty_devices/(float)number_of_devices) >= DEVICE_MULTIPLEXING_FAULTY_DEVICE_RATIO_RECONNECTION_THRESHOLD)
+                    // Faulty devices never go idle, so they are all counted above.
+                    if (number_of_faulty_devices > 0)
                     {
-                        LogError("Reconnection required. %zd of %zd registered devices are failing.", number_of_faulty_devices, number_of_devices);
+                        size_t number_of_devices = get_number_of_registered_devices(transport_instance);
+
+                        if (((float)number_of_faulty_devices/(float)number_of_devices) >= DEVICE_MULTIPLEXING_FAULTY_DEVICE_RATIO_RECONNECTION_THRESHOLD)
+                        {
+                            LogError("Reconnection required. %zd of %zd registered devices are failing.", number_of_faulty_devices, number_of_devices);
 
-                        update_state(transport_instance, AMQP_TRANSPORT_STATE_RECONNECTION_REQUIRED);
+                            update_state(transport_instance, AMQP_TRANSPORT_STATE_RECONNECTION_REQUIRED);
+                        }
                     }
                 }
             }
@@ -1680,6 +1724,7 @@ int IoTHubTransport_AMQP_Common_Subscribe(IOTHUB_DEVICE_HANDLE handle)
         }
         else
         {
+            set_device_ready(amqp_device_instance);
             // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_088: [If no failures occur, IoTHubTransport_AMQP_Common_Subscribe shall return 0]
             result = RESULT_OK;
         }
@@ -1709,6 +1754,10 @@ void IoTHubTransport_AMQP_Common_Unsubscribe(IOTHUB_DEVICE_HANDLE handle)
         {
             LogError("Device '%s' failed unsubscribing to cloud-to-device messages (amqp_device_unsubscribe_message failed)", STRING_c_str(amqp_device_instance->device_id));
         }
+        else
+        {
+            set_device_ready(amqp_device_instance);
+        }
     }
 }
 
@@ -1733,23 +1782,17 @@ int IoTHubTransport_AMQP_Common_Subscribe_DeviceTwin(IOTHUB_DEVICE_HANDLE handle
         }
         else
         {
-            LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(transport->registered_devices);
+            PDLIST_ENTRY entry = transport->registered_devices.Flink;
 
             // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_136: [If no errors occur, `IoTHubTransport_AMQP_Common_Subscribe_DeviceTwin` shall return zero.]
             result = RESULT_OK;
 
-            while (list_item != NULL)
+            while (entry != &transport->registered_devices)
             {
-                AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device;
+                AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device = containingRecord(entry, AMQP_TRANSPORT_DEVICE_INSTANCE, registered_entry);
 
-                if ((registered_device = (AMQP_TRANSPORT_DEVICE_INSTANCE*)singlylinkedlist_item_get_value(list_item)) == NULL)
-                {
-                    LogError("Failed retrieving registered device information");
-                    result = MU_FAILURE;
-                    break;
-                }
                 // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_134: [amqp_device_subscribe_for_twin_updates() shall be invoked for the registered device, passing `on_device_twin_update_received_callback`]
-                else if (amqp_device_subscribe_for_twin_updates(registered_device->device_handle, on_device_twin_update_received_callback, (void*)registered_device) != RESULT_OK)
+                if (amqp_device_subscribe_for_twin_updates(registered_device->device_handle, on_device_twin_update_received_callback, (void*)registered_device) != RESULT_OK)
                 {
                     // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_135: [If amqp_device_subscribe_for_twin_updates() fails, `IoTHubTransport_AMQP_Common_Subscribe_DeviceTwin` shall fail and return non-zero.]
                     LogError("Failed subscribing for device Twin updates");
@@ -1757,7 +1800,8 @@ int IoTHubTransport_AMQP_Common_Subscribe_DeviceTwin(IOTHUB_DEVICE_HANDLE handle
                     break;
                 }
 
-                list_item = singlylinkedlist_get_next_item(list_item);
+                set_device_ready(registered_device);
+                entry = entry->Flink;
             }
         }
     }
@@ -1782,26 +1826,22 @@ void IoTHubTransport_AMQP_Common_Unsubscribe_DeviceTwin(IOTHUB_DEVICE_HANDLE han
         }
         else
         {
-            LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(transport->registered_devices);
+            PDLIST_ENTRY entry = transport->registered_devices.Flink;
 
-            while (list_item != NULL)
+            while (entry != &transport->registered_devices)
             {
-                AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device;
+                AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device = containingRecord(entry, AMQP_TRANSPORT_DEVICE_INSTANCE, registered_entry);
 
-                if ((registered_device = (AMQP_TRANSPORT_DEVICE_INSTANCE*)singlylinkedlist_item_get_value(list_item)) == NULL)
-                {
-                    LogError("Failed retrieving registered device information");
-                    break;
-                }
                 // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_142: [amqp_device_unsubscribe_for_twin_updates() shall be invoked for the registered device]
-                else if (amqp_device_unsubscribe_for_twin_updates(registered_device->device_handle) != RESULT_OK)
+                if (amqp_device_unsubscribe_for_twin_updates(registered_device->device_handle) != RESULT_OK)
                 {
                     // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_143: [If `amqp_device_unsubscribe_for_twin_updates` fails, the error shall be ignored]
                     LogError("Failed unsubscribing for device Twin updates");
                     break;
                 }
 
-                list_item = singlylinkedlist_get_next_item(list_item);
+                set_device_ready(registered_device);
+                entry = entry->Flink;
             }
         }
     }
@@ -1852,6 +1892,7 @@ IOTHUB_CLIENT_RESULT IoTHubTransport_AMQP_Common_GetTwinAsync(IOTHUB_DEVICE_HAND
                 }
                 else
                 {
+                    set_device_ready(registered_device);
                     // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_157: [ If no errors occur, `IoTHubTransport_AMQP_Common_GetTwinAsync` shall return IOTHUB_CLIENT_OK ]
                     result = IOTHUB_CLIENT_OK;
                 }
@@ -1879,6 +1920,7 @@ int IoTHubTransport_AMQP_Common_Subscribe_DeviceMethod(IOTHUB_DEVICE_HANDLE hand
         /* Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_01_005: [ If the transport is already subscribed to receive C2D method requests, `IoTHubTransport_AMQP_Common_Subscribe_DeviceMethod` shall perform no additional action and return 0. ]*/
         device_state->subscribe_methods_needed = true;
         device_state->subscribed_for_methods = false;
+        set_device_ready(device_state);
         result = 0;
     }
 
@@ -2241,11 +2283,11 @@ IOTHUB_DEVICE_HANDLE IoTHubTransport_AMQP_Common_Register(TRANSPORT_LL_HANDLE ha
     }
     else
     {
-        LIST_ITEM_HANDLE list_item;
         AMQP_TRANSPORT_INSTANCE* transport_instance = (AMQP_TRANSPORT_INSTANCE*)handle;
 
         // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_064: [If the device is already registered, IoTHubTransport_AMQP_Common_Register shall fail and return NULL.]
-        if (is_device_registered_ex(transport_instance->registered_devices, device->deviceId, &list_item))
+        // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_31_003: [The device shall be looked up with amqp_device_index_find(), passing `device->deviceId` and `device->moduleId`]
+        if (amqp_device_index_find(transport_instance->registered_devices_index, device->deviceId, device->moduleId) != NULL)
         {
             LogError("IoTHubTransport_AMQP_Common_Register failed (device '%s' already registered on this transport instance)", device->deviceId);
             result = NULL;
@@ -2288,6 +2330,12 @@ IOTHUB_DEVICE_HANDLE IoTHubTransport_AMQP_Common_Register(TRANSPORT_LL_HANDLE ha
                     LogError("Transport failed to register device '%s' (failed to copy the deviceId)", device->deviceId);
                     result = NULL;
                 }
+                // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_31_004: [If `config->moduleId` is not NULL, a copy of it shall be saved into `device_state->module_id`]
+                else if (device->moduleId != NULL && (amqp_device_instance->module_id = STRING_construct(device->moduleId)) == NULL)
+                {
+                    LogError("Transport failed to register device '%s' (failed to copy the moduleId)", device->deviceId);
+                    result = NULL;
+                }
                 else
                 {
                     AMQP_DEVICE_CONFIG device_config;
@@ -2301,6 +2349,7 @@ IOTHUB_DEVICE_HANDLE IoTHubTransport_AMQP_Common_Register(TRANSPORT_LL_HANDLE ha
                     device_config.on_state_changed_context = amqp_device_instance;
                     device_config.prod_info_cb = transport_instance->transport_callbacks.prod_info_cb;
                     device_config.prod_info_ctx = transport_instance->transport_ctx;
+                    device_config.event_sent_cb = transport_instance->transport_callbacks.event_sent_cb;
 
                     // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_071: [`amqp_device_instance->device_handle` shall be set using amqp_device_create()]
                     if ((amqp_device_instance->device_handle = amqp_device_create(&device_config)) == NULL)
@@ -2311,7 +2360,7 @@ IOTHUB_DEVICE_HANDLE IoTHubTransport_AMQP_Common_Register(TRANSPORT_LL_HANDLE ha
                     }
                     else
                     {
-                        bool is_first_device_being_registered = (singlylinkedlist_get_head_item(transport_instance->registered_devices) == NULL);
+                        bool is_first_device_being_registered = DList_IsListEmpty(&transport_instance->registered_devices);
 
                         /* Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_01_010: [ `IoTHubTransport_AMQP_Common_Register` shall create a new iothubtransportamqp_methods instance by calling `iothubtransportamqp_methods_create` while passing to it the the fully qualified domain name, the device Id, and optional module Id. ]*/
                         amqp_device_instance->methods_handle = iothubtransportamqp_methods_create(STRING_c_str(transport_instance->iothub_host_fqdn), device->deviceId, device->moduleId);
@@ -2328,15 +2377,21 @@ IOTHUB_DEVICE_HANDLE IoTHubTransport_AMQP_Common_Register(TRANSPORT_LL_HANDLE ha
                                 LogError("Transport failed to register device '%s' (failed to replicate options)", device->deviceId);
                                 result = NULL;
                             }
-                            // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_074: [IoTHubTransport_AMQP_Common_Register shall add the `amqp_device_instance` to `instance->registered_devices`]
-                            else if (singlylinkedlist_add(transport_instance->registered_devices, amqp_device_instance) == NULL)
+                            // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_31_005: [IoTHubTransport_AMQP_Common_Register shall add the `amqp_device_instance` to `instance->registered_devices_index` using amqp_device_index_add()]
+                            else if (amqp_device_index_add(transport_instance->registered_devices_index, device->deviceId, device->moduleId, amqp_device_instance) != RESULT_OK)
                             {
-                                // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_075: [If it fails to add `amqp_device_instance`, IoTHubTransport_AMQP_Common_Register shall fail and return NULL]
-                                LogError("Transport failed to register device '%s' (singlylinkedlist_add failed)", device->deviceId);
+                                // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_31_006: [If amqp_device_index_add() fails, IoTHubTransport_AMQP_Common_Register shall fail and return NULL]
+                                LogError("Transport failed to register device '%s' (amqp_device_index_add failed)", device->deviceId);
                                 result = NULL;
                             }
                             else
                             {
+                                // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_074: [IoTHubTransport_AMQP_Common_Register shall add the `amqp_device_instance` to `instance->registered_devices` and to the list of ready devices]
+                                DList_InsertTailList(&transport_instance->registered_devices, &amqp_device_instance->registered_entry);
+                                DList_InsertTailList(&transport_instance->ready_devices, &amqp_device_instance->schedule_entry);
+                                amqp_device_instance->is_idle = false;
+                                transport_instance->number_of_ready_devices++;
+
                                 // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_076: [If the device is the first being registered on the transport, IoTHubTransport_AMQP_Common_Register shall save its authentication mode as the transport preferred authentication mode]
                                 if (transport_instance->preferred_authentication_mode == AMQP_TRANSPORT_AUTHENTICATION_MODE_NOT_SET &&
                                     is_first_device_being_registered)
@@ -2381,7 +2436,6 @@ void IoTHubTransport_AMQP_Common_Unregister(IOTHUB_DEVICE_HANDLE deviceHandle)
     {
         AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device = (AMQP_TRANSPORT_DEVICE_INSTANCE*)deviceHandle;
         const char* device_id;
-        LIST_ITEM_HANDLE list_item;
 
         if ((device_id = STRING_c_str(registered_device->device_id)) == NULL)
         {
@@ -2393,23 +2447,31 @@ void IoTHubTransport_AMQP_Common_Unregister(IOTHUB_DEVICE_HANDLE deviceHandle)
             LogError("Failed to unregister device '%s' (deviceHandle does not have a transport state associated to).", device_id);
         }
         // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_081: [If the device is not registered with this transport, IoTHubTransport_AMQP_Common_Unregister shall return]
-        else if (!is_device_registered_ex(registered_device->transport_instance->registered_devices, device_id, &list_item))
+        else if (amqp_device_index_find(registered_device->transport_instance->registered_devices_index, device_id, get_module_id(registered_device)) != registered_device)
         {
             LogError("Failed to unregister device '%s' (device is not registered within this transport).", device_id);
         }
         else
         {
-            // Removing it first so the race hazzard is reduced between this function and DoWork. Best would be to use locks.
-            if (singlylinkedlist_remove(registered_device->transport_instance->registered_devices, list_item) != RESULT_OK)
+            AMQP_TRANSPORT_INSTANCE* transport_instance = registered_device->transport_instance;
+
+            // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_082: [The device shall be removed from `instance->registered_devices` and from the list of ready or idle devices it is in]
+            (void)DList_RemoveEntryList(&registered_device->registered_entry);
+            (void)DList_RemoveEntryList(&registered_device->schedule_entry);
+            if (!registered_device->is_idle)
             {
-                LogError("Failed to unregister device '%s' (singlylinkedlist_remove failed).", device_id);
+                transport_instance->number_of_ready_devices--;
             }
-            else
+
+            // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_31_007: [The device shall be removed from `instance->registered_devices_index` using amqp_device_index_remove()]
+            if (amqp_device_index_remove(transport_instance->registered_devices_index, device_id, get_module_id(registered_device)) != RESULT_OK)
             {
-                // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_01_012: [IoTHubTransport_AMQP_Common_Unregister shall destroy the C2D methods handler by calling iothubtransportamqp_methods_destroy]
-                // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_083: [IoTHubTransport_AMQP_Common_Unregister shall free all the memory allocated for the `device_instance`]
-                internal_destroy_amqp_device_instance(registered_device);
+                LogError("Failed to remove device '%s' from the index of registered devices (amqp_device_index_remove failed).", device_id);
             }
+
+            // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_01_012: [IoTHubTransport_AMQP_Common_Unregister shall destroy the C2D methods handler by calling iothubtransportamqp_methods_destroy]
+            // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_083: [IoTHubTransport_AMQP_Common_Unregister shall free all the memory allocated for the `device_instance`]
+            internal_destroy_amqp_device_instance(registered_device);
         }
     }
 }
@@ -2581,4 +2643,16 @@ int IoTHubTransport_AMQP_Common_GetSupportedPlatformInfo(TRANSPORT_LL_HANDLE han
     }
 
     return result;
-}
\ No newline at end of file
+}
+void IoTHubTransport_AMQP_Common_OnEventQueued(IOTHUB_DEVICE_HANDLE handle)
+{
+    if (handle == NULL)
+    {
+        LogError("Invalid argument (handle is NULL)");
+    }
+    else
+    {
+        // The device may have been parked by DoWork; it needs to be visited again to send the new event.
+        set_device_ready((AMQP_TRANSPORT_DEVICE_INSTANCE*)handle);
+    }
+}
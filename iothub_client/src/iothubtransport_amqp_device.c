@@ -522,6 +522,7 @@ static AMQP_DEVICE_CONFIG* clone_device_config(AMQP_DEVICE_CONFIG *config)
             new_config->module_id = IoTHubClient_Auth_Get_ModuleId(config->authorization_module);
             new_config->prod_info_cb = config->prod_info_cb;
             new_config->prod_info_ctx = config->prod_info_ctx;
+            new_config->event_sent_cb = config->event_sent_cb;
             result = RESULT_OK;
         }
 
@@ -605,6 +606,7 @@ static int create_telemetry_messenger_instance(AMQP_DEVICE_INSTANCE* instance, p
     messenger_config.iothub_host_fqdn = instance->config->iothub_host_fqdn;
     messenger_config.on_state_changed_callback = on_messenger_state_changed_callback;
     messenger_config.on_state_changed_context = instance;
+    messenger_config.event_sent_cb = instance->config->event_sent_cb;
 
     if ((instance->messenger_handle = telemetry_messenger_create(&messenger_config, prod_info_cb, prod_info_ctx)) == NULL)
     {
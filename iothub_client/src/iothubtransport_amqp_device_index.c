@@ -0,0 +1,304 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "internal/iothubtransport_amqp_device_index.h"
+
+#define RESULT_OK                   0
+#define INITIAL_BUCKET_COUNT        16
+#define FNV_OFFSET_BASIS            2166136261u
+#define FNV_PRIME                   16777619u
+#define DEVICE_MODULE_SEPARATOR     '/'
+
+typedef struct DEVICE_INDEX_ENTRY_TAG
+{
+    struct DEVICE_INDEX_ENTRY_TAG* next;                                // Next entry in the same bucket.
+    size_t hash;                                                        // Hash of device_id and module_id, kept to rehash and to skip most string comparisons.
+    const char* device_id;                                              // Copy of the device id, stored right after the entry.
+    const char* module_id;                                              // Copy of the module id, stored after device_id; NULL if the device is not a module.
+    void* device;
+} DEVICE_INDEX_ENTRY;
+
+typedef struct AMQP_DEVICE_INDEX_INSTANCE_TAG
+{
+    DEVICE_INDEX_ENTRY** buckets;
+    size_t bucket_count;                                                // Always a power of two.
+    size_t count;
+} AMQP_DEVICE_INDEX_INSTANCE;
+
+static uint32_t hash_string(uint32_t hash, const char* value)
+{
+    while (*value != '\0')
+    {
+        hash = (hash ^ (unsigned char)*value++) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+// FNV-1a of "<device_id>/<module_id>"; '/' is not a valid character of a device id.
+static size_t get_hash(const char* device_id, const char* module_id)
+{
+    uint32_t hash = hash_string(FNV_OFFSET_BASIS, device_id);
+
+    if (module_id != NULL)
+    {
+        hash = (hash ^ (unsigned char)DEVICE_MODULE_SEPARATOR) * FNV_PRIME;
+        hash = hash_string(hash, module_id);
+    }
+
+    return (size_t)hash;
+}
+
+static bool is_same_device(const DEVICE_INDEX_ENTRY* entry, size_t hash, const char* device_id, const char* module_id)
+{
+    return entry->hash == hash &&
+        strcmp(entry->device_id, device_id) == 0 &&
+        ((entry->module_id == NULL && module_id == NULL) ||
+         (entry->module_id != NULL && module_id != NULL && strcmp(entry->module_id, module_id) == 0));
+}
+
+// Returns the link that points to the entry of the device, or the link at the end of its bucket if it is not in the index.
+static DEVICE_INDEX_ENTRY** find_entry_link(AMQP_DEVICE_INDEX_INSTANCE* instance, size_t hash, const char* device_id, const char* module_id)
+{
+    DEVICE_INDEX_ENTRY** link = &instance->buckets[hash & (instance->bucket_count - 1)];
+
+    while (*link != NULL && !is_same_device(*link, hash, device_id, module_id))
+    {
+        link = &(*link)->next;
+    }
+
+    return link;
+}
+
+// Doubles the number of buckets. If that cannot be allocated the index keeps working, with longer buckets.
+static void grow_buckets(AMQP_DEVICE_INDEX_INSTANCE* instance)
+{
+    size_t new_bucket_count = instance->bucket_count * 2;
+    DEVICE_INDEX_ENTRY** new_buckets;
+
+    if ((new_buckets = (DEVICE_INDEX_ENTRY**)malloc(new_bucket_count * sizeof(DEVICE_INDEX_ENTRY*))) == NULL)
+    {
+        LogError("Failed growing the device index to %lu buckets (malloc failed)", (unsigned long)new_bucket_count);
+    }
+    else
+    {
+        size_t i;
+
+        (void)memset(new_buckets, 0, new_bucket_count * sizeof(DEVICE_INDEX_ENTRY*));
+
+        for (i = 0; i < instance->bucket_count; i++)
+        {
+            DEVICE_INDEX_ENTRY* entry = instance->buckets[i];
+
+            while (entry != NULL)
+            {
+                DEVICE_INDEX_ENTRY* next = entry->next;
+                DEVICE_INDEX_ENTRY** bucket = &new_buckets[entry->hash & (new_bucket_count - 1)];
+
+                entry->next = *bucket;
+                *bucket = entry;
+                entry = next;
+            }
+        }
+
+        free(instance->buckets);
+        instance->buckets = new_buckets;
+        instance->bucket_count = new_bucket_count;
+    }
+}
+
+AMQP_DEVICE_INDEX_HANDLE amqp_device_index_create(void)
+{
+    AMQP_DEVICE_INDEX_INSTANCE* instance;
+
+    if ((instance = (AMQP_DEVICE_INDEX_INSTANCE*)malloc(sizeof(AMQP_DEVICE_INDEX_INSTANCE))) == NULL)
+    {
+        LogError("Failed creating the device index (malloc failed)");
+    }
+    else
+    {
+        memset(instance, 0, sizeof(AMQP_DEVICE_INDEX_INSTANCE));
+
+        if ((instance->buckets = (DEVICE_INDEX_ENTRY**)malloc(INITIAL_BUCKET_COUNT * sizeof(DEVICE_INDEX_ENTRY*))) == NULL)
+        {
+            LogError("Failed creating the device index buckets (malloc failed)");
+            free(instance);
+            instance = NULL;
+        }
+        else
+        {
+            memset(instance->buckets, 0, INITIAL_BUCKET_COUNT * sizeof(DEVICE_INDEX_ENTRY*));
+            instance->bucket_count = INITIAL_BUCKET_COUNT;
+        }
+    }
+
+    return (AMQP_DEVICE_INDEX_HANDLE)instance;
+}
+
+void amqp_device_index_destroy(AMQP_DEVICE_INDEX_HANDLE index)
+{
+    if (index == NULL)
+    {
+        LogError("Failed destroying the device index (index is NULL)");
+    }
+    else
+    {
+        size_t i;
+
+        for (i = 0; i < index->bucket_count; i++)
+        {
+            DEVICE_INDEX_ENTRY* entry = index->buckets[i];
+
+            while (entry != NULL)
+            {
+                DEVICE_INDEX_ENTRY* next = entry->next;
+                free(entry);
+                entry = next;
+            }
+        }
+
+        free(index->buckets);
+        free(index);
+    }
+}
+
+int amqp_device_index_add(AMQP_DEVICE_INDEX_HANDLE index, const char* device_id, const char* module_id, void* device)
+{
+    int result;
+
+    if (index == NULL || device_id == NULL || device == NULL)
+    {
+        LogError("Invalid argument (index=%p, device_id=%p, device=%p)", index, device_id, device);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t hash = get_hash(device_id, module_id);
+        DEVICE_INDEX_ENTRY** link = find_entry_link(index, hash, device_id, module_id);
+
+        if (*link != NULL)
+        {
+            LogError("Device '%s' is already in the index", device_id);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            size_t device_id_size = strlen(device_id) + 1;
+            size_t module_id_size = (module_id == NULL) ? 0 : strlen(module_id) + 1;
+            DEVICE_INDEX_ENTRY* entry;
+
+            if ((entry = (DEVICE_INDEX_ENTRY*)malloc(sizeof(DEVICE_INDEX_ENTRY) + device_id_size + module_id_size)) == NULL)
+            {
+                LogError("Failed adding device '%s' to the index (malloc failed)", device_id);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                char* ids = (char*)(entry + 1);
+
+                (void)memcpy(ids, device_id, device_id_size);
+                entry->device_id = ids;
+
+                if (module_id == NULL)
+                {
+                    entry->module_id = NULL;
+                }
+                else
+                {
+                    (void)memcpy(ids + device_id_size, module_id, module_id_size);
+                    entry->module_id = ids + device_id_size;
+                }
+
+                entry->hash = hash;
+                entry->device = device;
+                entry->next = NULL;
+                *link = entry;
+                index->count++;
+
+                if (index->count > index->bucket_count)
+                {
+                    grow_buckets(index);
+                }
+
+                result = RESULT_OK;
+            }
+        }
+    }
+
+    return result;
+}
+
+void* amqp_device_index_find(AMQP_DEVICE_INDEX_HANDLE index, const char* device_id, const char* module_id)
+{
+    void* result;
+
+    if (index == NULL || device_id == NULL)
+    {
+        LogError("Invalid argument (index=%p, device_id=%p)", index, device_id);
+        result = NULL;
+    }
+    else
+    {
+        DEVICE_INDEX_ENTRY* entry = *find_entry_link(index, get_hash(device_id, module_id), device_id, module_id);
+
+        result = (entry == NULL) ? NULL : entry->device;
+    }
+
+    return result;
+}
+
+int amqp_device_index_remove(AMQP_DEVICE_INDEX_HANDLE index, const char* device_id, const char* module_id)
+{
+    int result;
+
+    if (index == NULL || device_id == NULL)
+    {
+        LogError("Invalid argument (index=%p, device_id=%p)", index, device_id);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        DEVICE_INDEX_ENTRY** link = find_entry_link(index, get_hash(device_id, module_id), device_id, module_id);
+
+        if (*link == NULL)
+        {
+            LogError("Device '%s' is not in the index", device_id);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            DEVICE_INDEX_ENTRY* entry = *link;
+
+            *link = entry->next;
+            free(entry);
+            index->count--;
+            result = RESULT_OK;
+        }
+    }
+
+    return result;
+}
+
+size_t amqp_device_index_get_count(AMQP_DEVICE_INDEX_HANDLE index)
+{
+    size_t result;
+
+    if (index == NULL)
+    {
+        LogError("Invalid argument (index is NULL)");
+        result = 0;
+    }
+    else
+    {
+        result = index->count;
+    }
+
+    return result;
+}
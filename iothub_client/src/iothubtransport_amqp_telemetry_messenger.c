@@ -54,6 +54,7 @@ typedef struct TELEMETRY_MESSENGER_INSTANCE_TAG
 
     ON_TELEMETRY_MESSENGER_STATE_CHANGED_CALLBACK on_state_changed_callback;
     void* on_state_changed_context;
+    pfTransport_EventSent_Callback event_sent_cb;
 
     bool receive_messages;
     ON_TELEMETRY_MESSENGER_MESSAGE_RECEIVED on_message_received_callback;
@@ -74,6 +75,9 @@ typedef struct TELEMETRY_MESSENGER_INSTANCE_TAG
     size_t event_send_timeout_secs;
     time_t last_message_sender_state_change_time;
     time_t last_message_receiver_state_change_time;
+
+    uint64_t max_batch_message_size;        // Read from the peer of sender_link on first use, 0 until then.
+    UAMQP_ENCODING_BUFFER encoding_buffer;  // Reused to encode every event sent, instead of allocating one buffer per event.
 } TELEMETRY_MESSENGER_INSTANCE;
 
 // MESSENGER_SEND_EVENT_CALLER_INFORMATION corresponds to a message sent from the API, including
@@ -373,6 +377,9 @@ static void destroy_event_sender(TELEMETRY_MESSENGER_INSTANCE* instance)
         link_destroy(instance->sender_link);
         instance->sender_link = NULL;
     }
+
+    // The next link may be attached to a peer with a different maximum message size.
+    instance->max_batch_message_size = 0;
 }
 
 static void on_event_sender_state_changed_callback(void* context, MESSAGE_SENDER_STATE new_state, MESSAGE_SENDER_STATE previous_state)
@@ -1161,24 +1168,32 @@ static int send_batched_message_and_reset_state(TELEMETRY_MESSENGER_INSTANCE* in
 }
 
 // Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_31_196: [Determine the maximum message size we can send over this link from AMQP, then remove AMQP_BATCHING_RESERVE_SIZE (1024) bytes as reserve buffer.]
+// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_31_202: [The maximum message size shall be read from the link once, and kept until the event sender is destroyed.]
 static int get_max_message_size_for_batching(TELEMETRY_MESSENGER_INSTANCE* instance, uint64_t* max_messagesize)
 {
     int result;
+    uint64_t peer_max_message_size;
 
-    if (link_get_peer_max_message_size(instance->sender_link, max_messagesize) != 0)
+    if (instance->max_batch_message_size != 0)
+    {
+        *max_messagesize = instance->max_batch_message_size;
+        result = 0;
+    }
+    else if (link_get_peer_max_message_size(instance->sender_link, &peer_max_message_size) != 0)
     {
         LogError("link_get_peer_max_message_size failed");
         result = MU_FAILURE;
     }
     // Reserve AMQP_BATCHING_RESERVE_SIZE bytes for AMQP overhead of the "main" message itself.
-    else if (*max_messagesize <= AMQP_BATCHING_RESERVE_SIZE)
+    else if (peer_max_message_size <= AMQP_BATCHING_RESERVE_SIZE)
     {
-        LogError("link_get_peer_max_message_size (%" PRIu64 ") is less than the reserve size (%lu)", *max_messagesize, (unsigned long)AMQP_BATCHING_RESERVE_SIZE);
+        LogError("link_get_peer_max_message_size (%" PRIu64 ") is less than the reserve size (%lu)", peer_max_message_size, (unsigned long)AMQP_BATCHING_RESERVE_SIZE);
         result = MU_FAILURE;
     }
     else
     {
-        *max_messagesize -= AMQP_BATCHING_RESERVE_SIZE;
+        instance->max_batch_message_size = peer_max_message_size - AMQP_BATCHING_RESERVE_SIZE;
+        *max_messagesize = instance->max_batch_message_size;
         result = 0;
     }
 
@@ -1203,13 +1218,6 @@ static int send_pending_events(TELEMETRY_MESSENGER_INSTANCE* instance)
     // Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_31_199: [Errors specific to a message (e.g. failure to encode) are NOT fatal but we'll keep processing.  More general errors (e.g. out of memory) will stop processing.]
     while ((caller_info = get_next_caller_message_to_send(instance)) != NULL)
     {
-        if (body_binary_data.bytes != NULL)
-        {
-            // Free here as this may have been set during previous run through loop.
-            free((unsigned char*)body_binary_data.bytes);
-        }
-        memset(&body_binary_data, 0, sizeof(body_binary_data));
-
         if ((0 == max_messagesize) && (get_max_message_size_for_batching(instance, &max_messagesize)) != 0)
         {
             LogError("get_max_message_size_for_batching failed");
@@ -1227,10 +1235,11 @@ static int send_pending_events(TELEMETRY_MESSENGER_INSTANCE* instance)
             break;
         }
         // Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_31_200: [Retrieve an AMQP encoded representation of this message for later appending to main batched message.  On error, invoke callback but continue send loop; this is NOT a fatal error.]
-        else if (message_create_uamqp_encoding_from_iothub_message(send_pending_events_state.message_batch_container, caller_info->message->messageHandle, &body_binary_data) != RESULT_OK)
+        // The encoding goes into instance->encoding_buffer; message_add_body_amqp_data copies it before the next event reuses the buffer.
+        else if (message_create_uamqp_encoding_in_buffer(send_pending_events_state.message_batch_container, caller_info->message->messageHandle, &instance->encoding_buffer, &body_binary_data) != RESULT_OK)
         {
-            // Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_31_201: [If message_create_uamqp_encoding_from_iothub_message fails, invoke callback with TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE]
-            LogError("message_create_uamqp_encoding_from_iothub_message() failed.  Will continue to try to process messages, result");
+            // Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_31_201: [If message_create_uamqp_encoding_in_buffer fails, invoke callback with TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE]
+            LogError("message_create_uamqp_encoding_in_buffer() failed.  Will continue to try to process messages, result");
             invoke_callback_on_error(caller_info, TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE);
             free(caller_info);
             continue;
@@ -1285,6 +1294,11 @@ static int send_pending_events(TELEMETRY_MESSENGER_INSTANCE* instance)
         }
 
         send_pending_events_state.bytes_pending += body_binary_data.length;
+
+        if (instance->event_sent_cb != NULL)
+        {
+            instance->event_sent_cb(caller_info->message, (size_t)body_binary_data.length);
+        }
     }
 
     if ((result == 0) && (send_pending_events_state.bytes_pending != 0))
@@ -1296,11 +1310,6 @@ static int send_pending_events(TELEMETRY_MESSENGER_INSTANCE* instance)
         }
     }
 
-    if (body_binary_data.bytes != NULL)
-    {
-        free((unsigned char*)body_binary_data.bytes);
-    }
-
     // A non-NULL task indicates error, since otherwise send_batched_message_and_reset_state would've sent off messages and reset send_pending_events_state
     if (send_pending_events_state.task != NULL)
     {
@@ -1969,6 +1978,11 @@ void telemetry_messenger_destroy(TELEMETRY_MESSENGER_HANDLE messenger_handle)
 
         STRING_delete(instance->module_id);
 
+        if (instance->encoding_buffer.bytes != NULL)
+        {
+            free(instance->encoding_buffer.bytes);
+        }
+
         // Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_114: [telemetry_messenger_destroy() shall destroy `instance` with free()]
         (void)free(instance);
     }
@@ -2061,6 +2075,7 @@ TELEMETRY_MESSENGER_HANDLE telemetry_messenger_create(const TELEMETRY_MESSENGER_
                 // Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_014: [`messenger_config->on_state_changed_context` shall be saved into `instance->on_state_changed_context`]
                 instance->on_state_changed_context = messenger_config->on_state_changed_context;
 
+                instance->event_sent_cb = messenger_config->event_sent_cb;
                 instance->prod_info_cb = prod_info_cb;
                 instance->prod_info_ctx = prod_info_ctx;
 
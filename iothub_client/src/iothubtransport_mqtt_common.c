@@ -57,6 +57,17 @@
 
 #define ON_DEMAND_GET_TWIN_REQUEST_TIMEOUT_SECS    60
 #define TWIN_REPORT_UPDATE_TIMEOUT_SECS           (60*5)
+// Deadline value meaning nothing in the corresponding list can time out.
+#define NO_PENDING_DEADLINE                        ((tickcounter_ms_t)-1)
+
+// Number of buckets the in-flight telemetry index starts with.  Must be a power of 2.
+#define DEFAULT_INFLIGHT_INDEX_SIZE         256
+// Packet ids are 16 bit, so the index never needs more buckets than this.
+#define MAX_INFLIGHT_INDEX_SIZE             65536
+// When no cap is set on in-flight publishes, the index is grown once it averages this many entries per bucket.
+#define INFLIGHT_INDEX_MAX_LOAD             2
+// Room reserved after the event topic for properties when the telemetry topic buffer is first allocated.
+#define DEFAULT_TOPIC_PROPERTIES_SIZE       256
 
 static const char TOPIC_DEVICE_TWIN_PREFIX[] = "$iothub/twin";
 static const char TOPIC_DEVICE_METHOD_PREFIX[] = "$iothub/methods";
@@ -156,6 +167,16 @@ typedef enum MQTT_CLIENT_STATUS_TAG
     MQTT_CLIENT_STATUS_EXECUTE_DISCONNECT
 } MQTT_CLIENT_STATUS;
 
+// MQTT_TOPIC_BUILDER holds the buffer telemetry topics are built in.  The event topic is written once at the front
+// of buffer and each message's properties are appended after it, reusing the same allocation from message to message.
+typedef struct MQTT_TOPIC_BUILDER_TAG
+{
+    char* buffer;
+    size_t capacity;
+    size_t length;
+    size_t prefix_length;
+} MQTT_TOPIC_BUILDER;
+
 typedef struct MQTTTRANSPORT_HANDLE_DATA_TAG
 {
     // Topic control
@@ -167,6 +188,8 @@ typedef struct MQTTTRANSPORT_HANDLE_DATA_TAG
 
     STRING_HANDLE topic_DeviceMethods;
 
+    MQTT_TOPIC_BUILDER telemetry_topic;
+
     uint32_t topics_ToSubscribe;
 
     // Connection related constants
@@ -228,6 +251,33 @@ typedef struct MQTTTRANSPORT_HANDLE_DATA_TAG
     DLIST_ENTRY telemetry_waitingForAck;
     bool auto_url_encode_decode;
 
+    // Index of the entries in telemetry_waitingForAck keyed by packet id, so a PUBACK
+    // can be correlated without walking the list.  telemetry_waitingForAck still holds publish order.
+    struct MQTT_MESSAGE_DETAILS_LIST_TAG** telemetry_inflight_index;
+    size_t telemetry_inflight_index_size;
+    size_t telemetry_inflight_count;
+    // Maximum number of telemetry messages PUBLISH'd but not yet PUBACK'd.  0 means no limit.
+    size_t max_inflight_telemetry;
+    // Payload bytes of the messages in telemetry_inflight_index, and the cap on it.  0 means no limit.
+    size_t telemetry_inflight_bytes;
+    size_t max_inflight_telemetry_bytes;
+    // Block of max_inflight_telemetry entries for telemetry_waitingForAck, so a bounded in-flight window publishes
+    // without allocating.  Unused entries are chained through next_inflight; past the block entries come from the heap.
+    struct MQTT_MESSAGE_DETAILS_LIST_TAG* telemetry_detail_pool;
+    size_t telemetry_detail_pool_size;
+    size_t telemetry_detail_pool_in_use;
+    struct MQTT_MESSAGE_DETAILS_LIST_TAG* telemetry_detail_free_list;
+    // Maximum number of telemetry messages PUBLISH'd in a single DoWork pass.  0 means no limit.
+    size_t telemetry_publish_batch_size;
+
+    // Tick count shared by everything done in one DoWork pass, so the tick counter is read at most once per pass.
+    tickcounter_ms_t dowork_time;
+    bool dowork_time_valid;
+    // Earliest time an entry of telemetry_waitingForAck, or of the twin queues, can time out.
+    // The expiry scans are skipped until then.
+    tickcounter_ms_t telemetry_next_resend_check;
+    tickcounter_ms_t twin_next_expiry_check;
+
     // Controls frequency of reconnection logic.
     RETRY_CONTROL_HANDLE retry_control_handle;
 
@@ -267,7 +317,9 @@ typedef struct MQTT_MESSAGE_DETAILS_LIST_TAG
     IOTHUB_MESSAGE_LIST* iotHubMessageEntry;
     void* context;
     uint16_t packet_id;
+    size_t msgLength;
     DLIST_ENTRY entry;
+    struct MQTT_MESSAGE_DETAILS_LIST_TAG* next_inflight;
 } MQTT_MESSAGE_DETAILS_LIST, *PMQTT_MESSAGE_DETAILS_LIST;
 
 typedef struct DEVICE_METHOD_INFO_TAG
@@ -393,6 +445,9 @@ static void freeTransportHandleData(MQTTTRANSPORT_HANDLE_DATA* transport_data)
 
     DestroyXioTransport(transport_data);
 
+    free(transport_data->telemetry_topic.buffer);
+    free(transport_data->telemetry_inflight_index);
+    free(transport_data->telemetry_detail_pool);
     free(transport_data);
 }
 
@@ -412,6 +467,160 @@ static uint16_t getNextPacketId(PMQTTTRANSPORT_HANDLE_DATA transport_data)
     return transport_data->packetId;
 }
 
+//
+// createInflightIndex allocates an empty in-flight telemetry index with index_size buckets.
+//
+static MQTT_MESSAGE_DETAILS_LIST** createInflightIndex(size_t index_size)
+{
+    MQTT_MESSAGE_DETAILS_LIST** result = (MQTT_MESSAGE_DETAILS_LIST**)malloc(index_size * sizeof(MQTT_MESSAGE_DETAILS_LIST*));
+    if (result == NULL)
+    {
+        LogError("Failure allocating in-flight telemetry index");
+    }
+    else
+    {
+        memset(result, 0, index_size * sizeof(MQTT_MESSAGE_DETAILS_LIST*));
+    }
+    return result;
+}
+
+//
+// addToInflightIndex records a telemetry message that has been PUBLISH'd and is waiting for its PUBACK.
+//
+static void addToInflightIndex(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry)
+{
+    size_t bucket = mqttMsgEntry->packet_id & (transport_data->telemetry_inflight_index_size - 1);
+    mqttMsgEntry->next_inflight = transport_data->telemetry_inflight_index[bucket];
+    transport_data->telemetry_inflight_index[bucket] = mqttMsgEntry;
+    transport_data->telemetry_inflight_count++;
+    transport_data->telemetry_inflight_bytes += mqttMsgEntry->msgLength;
+}
+
+//
+// removeFromInflightIndex removes and returns the in-flight telemetry message with the given packet_id, or NULL if there is none.
+// Packet ids are handed out sequentially so the in-flight set maps onto the buckets with very few collisions.
+//
+static MQTT_MESSAGE_DETAILS_LIST* removeFromInflightIndex(PMQTTTRANSPORT_HANDLE_DATA transport_data, uint16_t packet_id)
+{
+    MQTT_MESSAGE_DETAILS_LIST** current = &transport_data->telemetry_inflight_index[packet_id & (transport_data->telemetry_inflight_index_size - 1)];
+    MQTT_MESSAGE_DETAILS_LIST* result = NULL;
+
+    while (*current != NULL)
+    {
+        if ((*current)->packet_id == packet_id)
+        {
+            result = *current;
+            *current = result->next_inflight;
+            result->next_inflight = NULL;
+            transport_data->telemetry_inflight_count--;
+            transport_data->telemetry_inflight_bytes -= result->msgLength;
+            break;
+        }
+        current = &(*current)->next_inflight;
+    }
+    return result;
+}
+
+//
+// resizeInflightIndex moves the in-flight telemetry index to new_size buckets.  new_size must be a power of 2.
+//
+static int resizeInflightIndex(PMQTTTRANSPORT_HANDLE_DATA transport_data, size_t new_size)
+{
+    int result;
+    MQTT_MESSAGE_DETAILS_LIST** new_index = createInflightIndex(new_size);
+    if (new_index == NULL)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        PDLIST_ENTRY current_entry = transport_data->telemetry_waitingForAck.Flink;
+
+        free(transport_data->telemetry_inflight_index);
+        transport_data->telemetry_inflight_index = new_index;
+        transport_data->telemetry_inflight_index_size = new_size;
+        transport_data->telemetry_inflight_count = 0;
+        transport_data->telemetry_inflight_bytes = 0;
+
+        while (current_entry != &transport_data->telemetry_waitingForAck)
+        {
+            addToInflightIndex(transport_data, containingRecord(current_entry, MQTT_MESSAGE_DETAILS_LIST, entry));
+            current_entry = current_entry->Flink;
+        }
+        result = 0;
+    }
+    return result;
+}
+
+//
+// allocateMessageDetails returns an entry for telemetry_waitingForAck, from telemetry_detail_pool if one is free.
+//
+static MQTT_MESSAGE_DETAILS_LIST* allocateMessageDetails(PMQTTTRANSPORT_HANDLE_DATA transport_data)
+{
+    MQTT_MESSAGE_DETAILS_LIST* result = transport_data->telemetry_detail_free_list;
+    if (result != NULL)
+    {
+        transport_data->telemetry_detail_free_list = result->next_inflight;
+        transport_data->telemetry_detail_pool_in_use++;
+    }
+    else
+    {
+        result = (MQTT_MESSAGE_DETAILS_LIST*)malloc(sizeof(MQTT_MESSAGE_DETAILS_LIST));
+    }
+    return result;
+}
+
+//
+// releaseMessageDetails gives back an entry obtained from allocateMessageDetails.
+//
+static void releaseMessageDetails(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry)
+{
+    if (transport_data->telemetry_detail_pool != NULL &&
+        mqttMsgEntry >= transport_data->telemetry_detail_pool &&
+        mqttMsgEntry < transport_data->telemetry_detail_pool + transport_data->telemetry_detail_pool_size)
+    {
+        mqttMsgEntry->next_inflight = transport_data->telemetry_detail_free_list;
+        transport_data->telemetry_detail_free_list = mqttMsgEntry;
+        transport_data->telemetry_detail_pool_in_use--;
+    }
+    else
+    {
+        free(mqttMsgEntry);
+    }
+}
+
+//
+// setMessageDetailsPool replaces telemetry_detail_pool with pool, a block of pool_size entries (NULL for none).
+// Must only be called while no entry of the current block is in use.
+//
+static void setMessageDetailsPool(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_MESSAGE_DETAILS_LIST* pool, size_t pool_size)
+{
+    size_t index;
+
+    free(transport_data->telemetry_detail_pool);
+    transport_data->telemetry_detail_pool = pool;
+    transport_data->telemetry_detail_pool_size = pool_size;
+    transport_data->telemetry_detail_free_list = NULL;
+    for (index = pool_size; index > 0; index--)
+    {
+        pool[index - 1].next_inflight = transport_data->telemetry_detail_free_list;
+        transport_data->telemetry_detail_free_list = &pool[index - 1];
+    }
+}
+
+//
+// getInflightIndexSizeFor returns the smallest power of 2 number of buckets that holds entry_count entries.
+//
+static size_t getInflightIndexSizeFor(size_t entry_count)
+{
+    size_t result = DEFAULT_INFLIGHT_INDEX_SIZE;
+    while (result < entry_count && result < MAX_INFLIGHT_INDEX_SIZE)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
 #ifndef NO_LOGGING
 //
 // retrieveMqttReturnCodes returns friendly representation of connection code for logging purposes.
@@ -611,11 +820,160 @@ static void notifyApplicationOfSendMessageComplete(IOTHUB_MESSAGE_LIST* iothubMs
     transport_data->transport_callbacks.send_complete_cb(&messageCompleted, confirmResult, transport_data->transport_ctx);
 }
 
+//
+// isUrlSafe returns true if value would come back from URL encoding unchanged, in which case the encode pass can be skipped.
+// This must stay in step with the set of characters URL_Encode leaves as is.
+//
+static bool isUrlSafe(const char* value)
+{
+    bool result = true;
+    const char* current;
+    for (current = value; *current != '\0'; current++)
+    {
+        char c = *current;
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+            (c == '!') || (c == '(') || (c == ')') || (c == '*') || (c == '-') || (c == '.') || (c == '_')))
+        {
+            result = false;
+            break;
+        }
+    }
+    return result;
+}
+
+//
+// initTopicBuilder allocates the buffer telemetry topics are built in and caches event_topic at the front of it.
+//
+static int initTopicBuilder(MQTT_TOPIC_BUILDER* topic_builder, const char* event_topic)
+{
+    int result;
+    size_t prefix_length = strlen(event_topic);
+    size_t capacity = prefix_length + DEFAULT_TOPIC_PROPERTIES_SIZE + 1;
+
+    if ((topic_builder->buffer = (char*)malloc(capacity)) == NULL)
+    {
+        LogError("Failure allocating telemetry topic buffer");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        (void)memcpy(topic_builder->buffer, event_topic, prefix_length + 1);
+        topic_builder->capacity = capacity;
+        topic_builder->length = prefix_length;
+        topic_builder->prefix_length = prefix_length;
+        result = 0;
+    }
+    return result;
+}
+
+//
+// resetTopicBuilder truncates the topic being built back to the cached event topic prefix.
+//
+static void resetTopicBuilder(MQTT_TOPIC_BUILDER* topic_builder)
+{
+    topic_builder->length = topic_builder->prefix_length;
+    topic_builder->buffer[topic_builder->length] = '\0';
+}
+
+//
+// reserveTopicBuilder makes sure there is room for additional_length more characters.  The buffer is kept
+// between messages so once it has grown to fit the largest topic no further allocations are made.
+//
+static int reserveTopicBuilder(MQTT_TOPIC_BUILDER* topic_builder, size_t additional_length)
+{
+    int result;
+    size_t required = topic_builder->length + additional_length + 1;
+
+    if (required <= topic_builder->capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t new_capacity = topic_builder->capacity * 2;
+        char* new_buffer;
+
+        if (new_capacity < required)
+        {
+            new_capacity = required;
+        }
+
+        if ((new_buffer = (char*)realloc(topic_builder->buffer, new_capacity)) == NULL)
+        {
+            LogError("Failure growing telemetry topic buffer to %lu bytes", (unsigned long)new_capacity);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            topic_builder->buffer = new_buffer;
+            topic_builder->capacity = new_capacity;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+//
+// appendToTopicBuilder appends length characters of value onto the topic being built.
+//
+static int appendToTopicBuilder(MQTT_TOPIC_BUILDER* topic_builder, const char* value, size_t length)
+{
+    int result;
+    if (reserveTopicBuilder(topic_builder, length) != 0)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        (void)memcpy(topic_builder->buffer + topic_builder->length, value, length);
+        topic_builder->length += length;
+        topic_builder->buffer[topic_builder->length] = '\0';
+        result = 0;
+    }
+    return result;
+}
+
+//
+// appendStringToTopicBuilder appends the NULL terminated value onto the topic being built.
+//
+static int appendStringToTopicBuilder(MQTT_TOPIC_BUILDER* topic_builder, const char* value)
+{
+    return appendToTopicBuilder(topic_builder, value, strlen(value));
+}
+
+//
+// appendValueToTopicBuilder appends value onto the topic being built, URL encoding it first if urlencode is set
+// and value contains characters that need it.
+//
+static int appendValueToTopicBuilder(MQTT_TOPIC_BUILDER* topic_builder, const char* value, bool urlencode)
+{
+    int result;
+    if (!urlencode || isUrlSafe(value))
+    {
+        result = appendStringToTopicBuilder(topic_builder, value);
+    }
+    else
+    {
+        STRING_HANDLE encoded_value = URL_EncodeString(value);
+        if (encoded_value == NULL)
+        {
+            LogError("Failed URL encoding value");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = appendStringToTopicBuilder(topic_builder, STRING_c_str(encoded_value));
+            STRING_delete(encoded_value);
+        }
+    }
+    return result;
+}
+
 //
 // addUserPropertiesTouMqttMessage translates application properties in iothub_message_handle (set by the application with IoTHubMessage_SetProperty e.g.)
-// into a representation in the MQTT TOPIC topic_string.
+// into a representation in the MQTT TOPIC topic_builder.
 //
-static int addUserPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, STRING_HANDLE topic_string, size_t* index_ptr, bool urlencode)
+static int addUserPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, MQTT_TOPIC_BUILDER* topic_builder, size_t* index_ptr, bool urlencode)
 {
     int result = 0;
     const char* const* propertyKeys;
@@ -634,32 +992,28 @@ static int addUserPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_message_
         {
             if (propertyCount != 0)
             {
+                // Size the buffer for the unencoded properties up front; encoding only grows it further when needed.
+                size_t properties_length = 0;
+                for (index = 0; index < propertyCount; index++)
+                {
+                    properties_length += strlen(propertyKeys[index]) + strlen(propertyValues[index]) + 2;
+                }
+
+                if (reserveTopicBuilder(topic_builder, properties_length) != 0)
+                {
+                    LogError("Failed constructing property string.");
+                    result = MU_FAILURE;
+                }
+
                 for (index = 0; index < propertyCount && result == 0; index++)
                 {
-                    if (urlencode)
+                    if ((appendValueToTopicBuilder(topic_builder, propertyKeys[index], urlencode) != 0) ||
+                        (appendToTopicBuilder(topic_builder, "=", 1) != 0) ||
+                        (appendValueToTopicBuilder(topic_builder, propertyValues[index], urlencode) != 0) ||
+                        ((propertyCount - 1 != index) && (appendStringToTopicBuilder(topic_builder, PROPERTY_SEPARATOR) != 0)))
                     {
-                        STRING_HANDLE property_key = URL_EncodeString(propertyKeys[index]);
-                        STRING_HANDLE property_value = URL_EncodeString(propertyValues[index]);
-                        if ((property_key == NULL) || (property_value == NULL))
-                        {
-                            LogError("Failed URL Encoding properties");
-                            result = MU_FAILURE;
-                        }
-                        else if (STRING_sprintf(topic_string, "%s=%s%s", STRING_c_str(property_key), STRING_c_str(property_value), propertyCount - 1 == index ? "" : PROPERTY_SEPARATOR) != 0)
-                        {
-                            LogError("Failed constructing property string.");
-                            result = MU_FAILURE;
-                        }
-                        STRING_delete(property_key);
-                        STRING_delete(property_value);
-                    }
-                    else
-                    {
-                        if (STRING_sprintf(topic_string, "%s=%s%s", propertyKeys[index], propertyValues[index], propertyCount - 1 == index ? "" : PROPERTY_SEPARATOR) != 0)
-                        {
-                            LogError("Failed constructing property string.");
-                            result = MU_FAILURE;
-                        }
+                        LogError("Failed constructing property string.");
+                        result = MU_FAILURE;
                     }
                 }
             }
@@ -671,43 +1025,29 @@ static int addUserPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_message_
 
 //
 // addSystemPropertyToTopicString appends a given "system" property from iothub_message_handle (set by the application with APIs such as IoTHubMessage_SetMessageId,
-// IoTHubMessage_SetContentTypeSystemProperty, etc.) onto the MQTT TOPIC topic_string.
+// IoTHubMessage_SetContentTypeSystemProperty, etc.) onto the MQTT TOPIC topic_builder.
 //
-static int addSystemPropertyToTopicString(STRING_HANDLE topic_string, size_t index, const char* property_key, const char* property_value, bool urlencode)
+static int addSystemPropertyToTopicString(MQTT_TOPIC_BUILDER* topic_builder, size_t index, const char* property_key, const char* property_value, bool urlencode)
 {
     int result = 0;
 
-    if (urlencode)
+    if (((index != 0) && (appendStringToTopicBuilder(topic_builder, PROPERTY_SEPARATOR) != 0)) ||
+        (appendStringToTopicBuilder(topic_builder, "%24.") != 0) ||
+        (appendStringToTopicBuilder(topic_builder, property_key) != 0) ||
+        (appendToTopicBuilder(topic_builder, "=", 1) != 0) ||
+        (appendValueToTopicBuilder(topic_builder, property_value, urlencode) != 0))
     {
-        STRING_HANDLE encoded_property_value = URL_EncodeString(property_value);
-        if (encoded_property_value == NULL)
-        {
-            LogError("Failed URL encoding %s.", property_key);
-            result = MU_FAILURE;
-        }
-        else if (STRING_sprintf(topic_string, "%s%%24.%s=%s", index == 0 ? "" : PROPERTY_SEPARATOR, property_key, STRING_c_str(encoded_property_value)) != 0)
-        {
-            LogError("Failed setting %s.", property_key);
-            result = MU_FAILURE;
-        }
-        STRING_delete(encoded_property_value);
-    }
-    else
-    {
-        if (STRING_sprintf(topic_string, "%s%%24.%s=%s", index == 0 ? "" : PROPERTY_SEPARATOR, property_key, property_value) != 0)
-        {
-            LogError("Failed setting %s.", property_key);
-            result = MU_FAILURE;
-        }
+        LogError("Failed setting %s.", property_key);
+        result = MU_FAILURE;
     }
     return result;
 }
 
 //
 // addSystemPropertyToTopicString appends all "system" property from iothub_message_handle (set by the application with APIs such as IoTHubMessage_SetMessageId,
-// IoTHubMessage_SetContentTypeSystemProperty, etc.) onto the MQTT TOPIC topic_string.
+// IoTHubMessage_SetContentTypeSystemProperty, etc.) onto the MQTT TOPIC topic_builder.
 //
-static int addSystemPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, STRING_HANDLE topic_string, size_t* index_ptr, bool urlencode)
+static int addSystemPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, MQTT_TOPIC_BUILDER* topic_builder, size_t* index_ptr, bool urlencode)
 {
     int result = 0;
     size_t index = *index_ptr;
@@ -717,7 +1057,7 @@ static int addSystemPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_messag
     const char* correlation_id = IoTHubMessage_GetCorrelationId(iothub_message_handle);
     if (correlation_id != NULL)
     {
-        result = addSystemPropertyToTopicString(topic_string, index, CORRELATION_ID_PROPERTY, correlation_id, urlencode);
+        result = addSystemPropertyToTopicString(topic_builder, index, CORRELATION_ID_PROPERTY, correlation_id, urlencode);
         index++;
     }
     /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_07_053: [ IoTHubTransport_MQTT_Common_DoWork shall check for the MessageId property and if found add the value as a system property in the format of $.mid=<id> ] */
@@ -726,7 +1066,7 @@ static int addSystemPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_messag
         const char* msg_id = IoTHubMessage_GetMessageId(iothub_message_handle);
         if (msg_id != NULL)
         {
-            result = addSystemPropertyToTopicString(topic_string, index, MESSAGE_ID_PROPERTY, msg_id, urlencode);
+            result = addSystemPropertyToTopicString(topic_builder, index, MESSAGE_ID_PROPERTY, msg_id, urlencode);
             index++;
         }
     }
@@ -736,7 +1076,7 @@ static int addSystemPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_messag
         const char* content_type = IoTHubMessage_GetContentTypeSystemProperty(iothub_message_handle);
         if (content_type != NULL)
         {
-            result = addSystemPropertyToTopicString(topic_string, index, CONTENT_TYPE_PROPERTY, content_type, urlencode);
+            result = addSystemPropertyToTopicString(topic_builder, index, CONTENT_TYPE_PROPERTY, content_type, urlencode);
             index++;
         }
     }
@@ -747,7 +1087,7 @@ static int addSystemPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_messag
         if (content_encoding != NULL)
         {
             // Security message require content encoding
-            result = addSystemPropertyToTopicString(topic_string, index, CONTENT_ENCODING_PROPERTY, content_encoding, is_security_msg ? true : urlencode);
+            result = addSystemPropertyToTopicString(topic_builder, index, CONTENT_ENCODING_PROPERTY, content_encoding, is_security_msg ? true : urlencode);
             index++;
         }
     }
@@ -757,7 +1097,7 @@ static int addSystemPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_messag
         const char* message_creation_time_utc = IoTHubMessage_GetMessageCreationTimeUtcSystemProperty(iothub_message_handle);
         if (message_creation_time_utc != NULL)
         {
-            result = addSystemPropertyToTopicString(topic_string, index, MESSAGE_CREATION_TIME_UTC, message_creation_time_utc, urlencode);
+            result = addSystemPropertyToTopicString(topic_builder, index, MESSAGE_CREATION_TIME_UTC, message_creation_time_utc, urlencode);
             index++;
         }
     }
@@ -767,7 +1107,7 @@ static int addSystemPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_messag
         if (is_security_msg)
         {
             // The Security interface Id value must be encoded
-            if (addSystemPropertyToTopicString(topic_string, index++, SECURITY_INTERFACE_ID_MQTT, SECURITY_INTERFACE_ID_VALUE, true) != 0)
+            if (addSystemPropertyToTopicString(topic_builder, index++, SECURITY_INTERFACE_ID_MQTT, SECURITY_INTERFACE_ID_VALUE, true) != 0)
             {
                 LogError("Failed setting Security interface id");
                 result = MU_FAILURE;
@@ -784,9 +1124,9 @@ static int addSystemPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_messag
 
 //
 // addDiagnosticPropertiesTouMqttMessage appends diagnostic data (as specified by IoTHubMessage_SetDiagnosticPropertyData) onto
-// the MQTT topic topic_string.
+// the MQTT topic topic_builder.
 //
-static int addDiagnosticPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, STRING_HANDLE topic_string, size_t* index_ptr)
+static int addDiagnosticPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, MQTT_TOPIC_BUILDER* topic_builder, size_t* index_ptr)
 {
     int result = 0;
     size_t index = *index_ptr;
@@ -800,7 +1140,7 @@ static int addDiagnosticPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_me
         //diagid and creationtimeutc must be present/unpresent simultaneously
         if (diag_id != NULL && creation_time_utc != NULL)
         {
-            if (STRING_sprintf(topic_string, "%s%%24.%s=%s", index == 0 ? "" : PROPERTY_SEPARATOR, DIAGNOSTIC_ID_PROPERTY, diag_id) != 0)
+            if (addSystemPropertyToTopicString(topic_builder, index, DIAGNOSTIC_ID_PROPERTY, diag_id, false) != 0)
             {
                 LogError("Failed setting diagnostic id");
                 result = MU_FAILURE;
@@ -824,7 +1164,7 @@ static int addDiagnosticPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_me
                     if (encodedContextValueHandle != NULL &&
                         (encodedContextValueString = STRING_c_str(encodedContextValueHandle)) != NULL)
                     {
-                        if (STRING_sprintf(topic_string, "%s%%24.%s=%s", index == 0 ? "" : PROPERTY_SEPARATOR, DIAGNOSTIC_CONTEXT_PROPERTY, encodedContextValueString) != 0)
+                        if (addSystemPropertyToTopicString(topic_builder, index, DIAGNOSTIC_CONTEXT_PROPERTY, encodedContextValueString, false) != 0)
                         {
                             LogError("Failed setting diagnostic context");
                             result = MU_FAILURE;
@@ -858,31 +1198,28 @@ static int addDiagnosticPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_me
 // construct of the SDK and IoT Hub.  The MQTT protocol itself does not assign any significance to system and user properties (as opposed to AMQP).
 // The IOTHUB_MESSAGE_HANDLE structure however does have well-known properties (e.g. IoTHubMessage_SetMessageId) that the SDK treats as system
 // properties where we can automatically fill in the key value for in the key=value list.
+// The topic is built in place after the cached event topic prefix in topic_builder, which is only valid until the next call.
 //
-static STRING_HANDLE addPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, const char* eventTopic, bool urlencode)
+static const char* addPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, MQTT_TOPIC_BUILDER* topic_builder, bool urlencode)
 {
     size_t index = 0;
-    STRING_HANDLE result = STRING_construct(eventTopic);
-    if (result == NULL)
-    {
-        LogError("Failed to create event topic string handle");
-    }
-    else if (addUserPropertiesTouMqttMessage(iothub_message_handle, result, &index, urlencode) != 0)
+    const char* result = topic_builder->buffer;
+
+    resetTopicBuilder(topic_builder);
+
+    if (addUserPropertiesTouMqttMessage(iothub_message_handle, topic_builder, &index, urlencode) != 0)
     {
         LogError("Failed adding Properties to uMQTT Message");
-        STRING_delete(result);
         result = NULL;
     }
-    else if (addSystemPropertiesTouMqttMessage(iothub_message_handle, result, &index, urlencode) != 0)
+    else if (addSystemPropertiesTouMqttMessage(iothub_message_handle, topic_builder, &index, urlencode) != 0)
     {
         LogError("Failed adding System Properties to uMQTT Message");
-        STRING_delete(result);
         result = NULL;
     }
-    else if (addDiagnosticPropertiesTouMqttMessage(iothub_message_handle, result, &index) != 0)
+    else if (addDiagnosticPropertiesTouMqttMessage(iothub_message_handle, topic_builder, &index) != 0)
     {
         LogError("Failed adding Diagnostic Properties to uMQTT Message");
-        STRING_delete(result);
         result = NULL;
     }
 
@@ -892,16 +1229,72 @@ static STRING_HANDLE addPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_me
         const char* output_name = IoTHubMessage_GetOutputName(iothub_message_handle);
         if (output_name != NULL)
         {
-            if (STRING_sprintf(result, "%s%%24.on=%s/", index == 0 ? "" : PROPERTY_SEPARATOR, output_name) != 0)
+            if ((addSystemPropertyToTopicString(topic_builder, index, "on", output_name, false) != 0) ||
+                (appendToTopicBuilder(topic_builder, "/", 1) != 0))
             {
                 LogError("Failed setting output name.");
-                STRING_delete(result);
                 result = NULL;
             }
             index++;
         }
     }
 
+    if (result != NULL)
+    {
+        // The buffer may have moved while growing.
+        result = topic_builder->buffer;
+    }
+
+    return result;
+}
+
+//
+// getDoWorkTime returns the tick count of the current DoWork pass.  The tick counter is only read the first time
+// it is needed in a pass; outside of DoWork every call reads it.
+//
+static int getDoWorkTime(PMQTTTRANSPORT_HANDLE_DATA transport_data, tickcounter_ms_t* current_ms)
+{
+    int result;
+    if (transport_data->dowork_time_valid)
+    {
+        *current_ms = transport_data->dowork_time;
+        result = 0;
+    }
+    else if (tickcounter_get_current_ms(transport_data->msgTickCounter, &transport_data->dowork_time) != 0)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        transport_data->dowork_time_valid = true;
+        *current_ms = transport_data->dowork_time;
+        result = 0;
+    }
+    return result;
+}
+
+//
+// getTelemetryResendTime returns when a PUBLISH'd telemetry message becomes due for a resend.
+//
+static tickcounter_ms_t getTelemetryResendTime(const MQTT_MESSAGE_DETAILS_LIST* msg_detail_entry)
+{
+    return msg_detail_entry->msgPublishTime + ((tickcounter_ms_t)RESEND_TIMEOUT_VALUE_MIN + 1) * 1000;
+}
+
+//
+// getPublishPacketSize returns the size of a QoS 1 PUBLISH packet: fixed header, topic, packet id and payload.
+//
+static size_t getPublishPacketSize(const char* topic, size_t payload_length)
+{
+    size_t remaining_length = 2 + strlen(topic) + 2 + payload_length;
+    size_t result = 1 + remaining_length;
+
+    do
+    {
+        result++;
+        remaining_length >>= 7;
+    } while (remaining_length > 0);
+
     return result;
 }
 
@@ -911,7 +1304,7 @@ static STRING_HANDLE addPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_me
 static int publishTelemetryMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry, const unsigned char* payload, size_t len)
 {
     int result;
-    STRING_HANDLE msgTopic = addPropertiesTouMqttMessage(mqttMsgEntry->iotHubMessageEntry->messageHandle, STRING_c_str(transport_data->topic_MqttEvent), transport_data->auto_url_encode_decode);
+    const char* msgTopic = addPropertiesTouMqttMessage(mqttMsgEntry->iotHubMessageEntry->messageHandle, &transport_data->telemetry_topic, transport_data->auto_url_encode_decode);
     if (msgTopic == NULL)
     {
         LogError("Failed adding properties to mqtt message");
@@ -919,7 +1312,7 @@ static int publishTelemetryMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_M
     }
     else
     {
-        MQTT_MESSAGE_HANDLE mqttMsg = mqttmessage_create_in_place(mqttMsgEntry->packet_id, STRING_c_str(msgTopic), DELIVER_AT_LEAST_ONCE, payload, len);
+        MQTT_MESSAGE_HANDLE mqttMsg = mqttmessage_create_in_place(mqttMsgEntry->packet_id, msgTopic, DELIVER_AT_LEAST_ONCE, payload, len);
         if (mqttMsg == NULL)
         {
             LogError("Failed creating mqtt message");
@@ -927,7 +1320,7 @@ static int publishTelemetryMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_M
         }
         else
         {
-            if (tickcounter_get_current_ms(transport_data->msgTickCounter, &mqttMsgEntry->msgPublishTime) != 0)
+            if (getDoWorkTime(transport_data, &mqttMsgEntry->msgPublishTime) != 0)
             {
                 LogError("Failed retrieving tickcounter info");
                 result = MU_FAILURE;
@@ -941,13 +1334,21 @@ static int publishTelemetryMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_M
                 }
                 else
                 {
+                    tickcounter_ms_t resend_time = getTelemetryResendTime(mqttMsgEntry);
+                    if (resend_time < transport_data->telemetry_next_resend_check)
+                    {
+                        transport_data->telemetry_next_resend_check = resend_time;
+                    }
                     mqttMsgEntry->retryCount++;
+                    if (transport_data->transport_callbacks.event_sent_cb != NULL)
+                    {
+                        transport_data->transport_callbacks.event_sent_cb(mqttMsgEntry->iotHubMessageEntry, getPublishPacketSize(msgTopic, len));
+                    }
                     result = 0;
                 }
             }
             mqttmessage_destroy(mqttMsg);
         }
-        STRING_delete(msgTopic);
     }
     return result;
 }
@@ -1000,6 +1401,27 @@ static void destroyDeviceTwinGetMsg(MQTT_DEVICE_TWIN_ITEM* msg_entry)
     free(msg_entry);
 }
 
+//
+// getTwinRequestExpiryTime returns when a twin request times out, or NO_PENDING_DEADLINE for requests that never do.
+//
+static tickcounter_ms_t getTwinRequestExpiryTime(const MQTT_DEVICE_TWIN_ITEM* msg_entry)
+{
+    tickcounter_ms_t result;
+    if (msg_entry->device_twin_msg_type == RETRIEVE_PROPERTIES)
+    {
+        result = msg_entry->msgCreationTime + (tickcounter_ms_t)ON_DEMAND_GET_TWIN_REQUEST_TIMEOUT_SECS * 1000;
+    }
+    else if (msg_entry->device_twin_msg_type == REPORTED_STATE)
+    {
+        result = msg_entry->msgCreationTime + (tickcounter_ms_t)TWIN_REPORT_UPDATE_TIMEOUT_SECS * 1000;
+    }
+    else
+    {
+        result = NO_PENDING_DEADLINE;
+    }
+    return result;
+}
+
 //
 // createDeviceTwinMsg allocates and fills in structure for MQTT_DEVICE_TWIN_ITEM.
 //
@@ -1025,6 +1447,13 @@ static MQTT_DEVICE_TWIN_ITEM* createDeviceTwinMsg(MQTTTRANSPORT_HANDLE_DATA* tra
         result->packet_id = getNextPacketId(transport_data);
         result->iothub_msg_id = iothub_msg_id;
         result->device_twin_msg_type = device_twin_msg_type;
+
+        // Callers may stamp msgCreationTime again later, which only moves the real expiry further out.
+        tickcounter_ms_t expiry_time = getTwinRequestExpiryTime(result);
+        if (expiry_time < transport_data->twin_next_expiry_check)
+        {
+            transport_data->twin_next_expiry_check = expiry_time;
+        }
     }
 
     return result;
@@ -1140,17 +1569,46 @@ static void removeExpiredTwinRequestsFromList(PMQTTTRANSPORT_HANDLE_DATA transpo
 
 }
 
+//
+// getNextTwinExpiryFromList returns the earliest expiry time of the requests in twin_list, or next_expiry if that is earlier.
+//
+static tickcounter_ms_t getNextTwinExpiryFromList(DLIST_ENTRY* twin_list, tickcounter_ms_t next_expiry)
+{
+    PDLIST_ENTRY list_item = twin_list->Flink;
+
+    while (list_item != twin_list)
+    {
+        tickcounter_ms_t expiry_time = getTwinRequestExpiryTime(containingRecord(list_item, MQTT_DEVICE_TWIN_ITEM, entry));
+        if (expiry_time < next_expiry)
+        {
+            next_expiry = expiry_time;
+        }
+        list_item = list_item->Flink;
+    }
+
+    return next_expiry;
+}
+
 //
 // removeExpiredTwinRequests removes any requests that have timed out, regardless of how the request invoked.
+// The lists are only walked once the earliest known expiry time has been reached.
 //
 static void removeExpiredTwinRequests(PMQTTTRANSPORT_HANDLE_DATA transport_data)
 {
     tickcounter_ms_t current_ms;
 
-    if (tickcounter_get_current_ms(transport_data->msgTickCounter, &current_ms) == 0)
+    if (transport_data->pending_get_twin_queue.Flink == &transport_data->pending_get_twin_queue &&
+        transport_data->ack_waiting_queue.Flink == &transport_data->ack_waiting_queue)
+    {
+        transport_data->twin_next_expiry_check = NO_PENDING_DEADLINE;
+    }
+    else if (getDoWorkTime(transport_data, &current_ms) == 0 && current_ms >= transport_data->twin_next_expiry_check)
     {
         removeExpiredTwinRequestsFromList(transport_data, current_ms, &transport_data->pending_get_twin_queue);
         removeExpiredTwinRequestsFromList(transport_data, current_ms, &transport_data->ack_waiting_queue);
+
+        transport_data->twin_next_expiry_check = getNextTwinExpiryFromList(&transport_data->ack_waiting_queue,
+            getNextTwinExpiryFromList(&transport_data->pending_get_twin_queue, NO_PENDING_DEADLINE));
     }
 }
 
@@ -1848,20 +2306,12 @@ static void mqttOperationCompleteCallback(MQTT_CLIENT_HANDLE handle, MQTT_CLIENT
                 const PUBLISH_ACK* puback = (const PUBLISH_ACK*)msgInfo;
                 if (puback != NULL)
                 {
-                    PDLIST_ENTRY currentListEntry = transport_data->telemetry_waitingForAck.Flink;
-                    while (currentListEntry != &transport_data->telemetry_waitingForAck)
+                    MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = removeFromInflightIndex(transport_data, puback->packetId);
+                    if (mqttMsgEntry != NULL)
                     {
-                        MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = containingRecord(currentListEntry, MQTT_MESSAGE_DETAILS_LIST, entry);
-                        DLIST_ENTRY saveListEntry;
-                        saveListEntry.Flink = currentListEntry->Flink;
-
-                        if (puback->packetId == mqttMsgEntry->packet_id)
-                        {
-                            (void)DList_RemoveEntryList(currentListEntry); //First remove the item from Waiting for Ack List.
-                            notifyApplicationOfSendMessageComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_OK);
-                            free(mqttMsgEntry);
-                        }
-                        currentListEntry = saveListEntry.Flink;
+                        (void)DList_RemoveEntryList(&mqttMsgEntry->entry); //First remove the item from Waiting for Ack List.
+                        notifyApplicationOfSendMessageComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_OK);
+                        releaseMessageDetails(transport_data, mqttMsgEntry);
                     }
                 }
                 else
@@ -2221,18 +2671,16 @@ static bool RetrieveMessagePayload(IOTHUB_MESSAGE_HANDLE messageHandle, const un
 }
 
 //
-// ProcessPendingTelemetryMessages examines each telemetry message the device/module has sent that hasn't yet been PUBACK'd.
+// ProcessDueTelemetryMessages examines each telemetry message the device/module has sent that hasn't yet been PUBACK'd.
 // For each message, it might:
 // * Ignore it, if its timeout has not yet been reached.
 // * Attempt to retry PUBLISH the message, if has remaining retries left.
 // * Stop attempting to send the message.  This will result in tearing down the underlying MQTT/TCP connection because it indicates
 //   something is wrong.
 //
-static void ProcessPendingTelemetryMessages(PMQTTTRANSPORT_HANDLE_DATA transport_data)
+static void ProcessDueTelemetryMessages(PMQTTTRANSPORT_HANDLE_DATA transport_data, tickcounter_ms_t current_ms)
 {
     PDLIST_ENTRY current_entry = transport_data->telemetry_waitingForAck.Flink;
-    tickcounter_ms_t current_ms;
-    (void)tickcounter_get_current_ms(transport_data->msgTickCounter, &current_ms);
     while (current_entry != &transport_data->telemetry_waitingForAck)
     {
         MQTT_MESSAGE_DETAILS_LIST* msg_detail_entry = containingRecord(current_entry, MQTT_MESSAGE_DETAILS_LIST, entry);
@@ -2243,9 +2691,10 @@ static void ProcessPendingTelemetryMessages(PMQTTTRANSPORT_HANDLE_DATA transport
         {
             if (msg_detail_entry->retryCount >= MAX_SEND_RECOUNT_LIMIT)
             {
+                (void)removeFromInflightIndex(transport_data, msg_detail_entry->packet_id);
                 notifyApplicationOfSendMessageComplete(msg_detail_entry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT);
                 (void)DList_RemoveEntryList(current_entry);
-                free(msg_detail_entry);
+                releaseMessageDetails(transport_data, msg_detail_entry);
 
                 DisconnectFromClient(transport_data);
                 if (!transport_data->isRetryExpiredCallbackCalled) // Only call once
@@ -2264,16 +2713,19 @@ static void ProcessPendingTelemetryMessages(PMQTTTRANSPORT_HANDLE_DATA transport
                     const unsigned char* messagePayload = NULL;
                     if (!RetrieveMessagePayload(msg_detail_entry->iotHubMessageEntry->messageHandle, &messagePayload, &messageLength))
                     {
+                        (void)removeFromInflightIndex(transport_data, msg_detail_entry->packet_id);
                         (void)DList_RemoveEntryList(current_entry);
                         notifyApplicationOfSendMessageComplete(msg_detail_entry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_ERROR);
+                        releaseMessageDetails(transport_data, msg_detail_entry);
                     }
                     else
                     {
                         if (publishTelemetryMsg(transport_data, msg_detail_entry, messagePayload, messageLength) != 0)
                         {
+                            (void)removeFromInflightIndex(transport_data, msg_detail_entry->packet_id);
                             (void)DList_RemoveEntryList(current_entry);
                             notifyApplicationOfSendMessageComplete(msg_detail_entry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_ERROR);
-                            free(msg_detail_entry);
+                            releaseMessageDetails(transport_data, msg_detail_entry);
                         }
                     }
                 }
@@ -2288,6 +2740,36 @@ static void ProcessPendingTelemetryMessages(PMQTTTRANSPORT_HANDLE_DATA transport
     }
 }
 
+//
+// ProcessPendingTelemetryMessages runs ProcessDueTelemetryMessages once the earliest resend time of the messages
+// waiting for a PUBACK has been reached, and then works out the next one.  Until then it does not walk the list.
+//
+static void ProcessPendingTelemetryMessages(PMQTTTRANSPORT_HANDLE_DATA transport_data)
+{
+    tickcounter_ms_t current_ms;
+
+    if (transport_data->telemetry_waitingForAck.Flink == &transport_data->telemetry_waitingForAck)
+    {
+        transport_data->telemetry_next_resend_check = NO_PENDING_DEADLINE;
+    }
+    else if (getDoWorkTime(transport_data, &current_ms) == 0 && current_ms >= transport_data->telemetry_next_resend_check)
+    {
+        PDLIST_ENTRY current_entry;
+
+        ProcessDueTelemetryMessages(transport_data, current_ms);
+
+        transport_data->telemetry_next_resend_check = NO_PENDING_DEADLINE;
+        for (current_entry = transport_data->telemetry_waitingForAck.Flink; current_entry != &transport_data->telemetry_waitingForAck; current_entry = current_entry->Flink)
+        {
+            tickcounter_ms_t resend_time = getTelemetryResendTime(containingRecord(current_entry, MQTT_MESSAGE_DETAILS_LIST, entry));
+            if (resend_time < transport_data->telemetry_next_resend_check)
+            {
+                transport_data->telemetry_next_resend_check = resend_time;
+            }
+        }
+    }
+}
+
 //
 // CreateTransportProviderIfNecessary will create the underlying xioTransport (which handles networking I/O) and
 // set its options, assuming the xioTransport does not already exist.
@@ -2622,7 +3104,7 @@ static int UpdateMqttConnectionStateIfNeeded(PMQTTTRANSPORT_HANDLE_DATA transpor
         else if (transport_data->mqttClientStatus == MQTT_CLIENT_STATUS_CONNECTING)
         {
             tickcounter_ms_t current_time;
-            if (tickcounter_get_current_ms(transport_data->msgTickCounter, &current_time) != 0)
+            if (getDoWorkTime(transport_data, &current_time) != 0)
             {
                 LogError("failed verifying MQTT_CLIENT_STATUS_CONNECTING timeout");
                 result = MU_FAILURE;
@@ -2639,7 +3121,7 @@ static int UpdateMqttConnectionStateIfNeeded(PMQTTTRANSPORT_HANDLE_DATA transpor
         {
             // We are connected and not being closed, so does SAS need to reconnect?
             tickcounter_ms_t current_time;
-            if (tickcounter_get_current_ms(transport_data->msgTickCounter, &current_time) != 0)
+            if (getDoWorkTime(transport_data, &current_time) != 0)
             {
                 transport_data->connectFailCount++;
                 result = MU_FAILURE;
@@ -2821,6 +3303,12 @@ static PMQTTTRANSPORT_HANDLE_DATA InitializeTransportHandleData(const IOTHUB_CLI
                 freeTransportHandleData(state);
                 state = NULL;
             }
+            else if (initTopicBuilder(&state->telemetry_topic, STRING_c_str(state->topic_MqttEvent)) != 0)
+            {
+                LogError("Could not create telemetry topic buffer for MQTT");
+                freeTransportHandleData(state);
+                state = NULL;
+            }
             else
             {
                 state->mqttClient = mqtt_client_init(mqttNotificationCallback, mqttOperationCompleteCallback, state, processErrorCallback, state);
@@ -2853,6 +3341,11 @@ static PMQTTTRANSPORT_HANDLE_DATA InitializeTransportHandleData(const IOTHUB_CLI
                         freeTransportHandleData(state);
                         state = NULL;
                     }
+                    else if ((state->telemetry_inflight_index = createInflightIndex(DEFAULT_INFLIGHT_INDEX_SIZE)) == NULL)
+                    {
+                        freeTransportHandleData(state);
+                        state = NULL;
+                    }
                     else
                     {
                         /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_010: [IoTHubTransport_MQTT_Common_Create shall allocate memory to save its internal state where all topics, hostname, device_id, device_key, sasTokenSr and client handle shall be saved.] */
@@ -2887,6 +3380,15 @@ static PMQTTTRANSPORT_HANDLE_DATA InitializeTransportHandleData(const IOTHUB_CLI
                         state->isConnectUsernameSet = false;
                         state->auto_url_encode_decode = false;
                         state->conn_attempted = false;
+                        state->telemetry_inflight_index_size = DEFAULT_INFLIGHT_INDEX_SIZE;
+                        state->telemetry_inflight_count = 0;
+                        state->max_inflight_telemetry = 0;
+                        state->telemetry_inflight_bytes = 0;
+                        state->max_inflight_telemetry_bytes = 0;
+                        state->telemetry_publish_batch_size = 0;
+                        state->dowork_time_valid = false;
+                        state->telemetry_next_resend_check = NO_PENDING_DEADLINE;
+                        state->twin_next_expiry_check = NO_PENDING_DEADLINE;
                     }
                 }
             }
@@ -2927,14 +3429,32 @@ static void ProcessSubackDoWork(PMQTTTRANSPORT_HANDLE_DATA transport_data)
     transport_data->currPacketState = PUBLISH_TYPE;
 }
 
+//
+// isInflightByteBudgetAvailable returns whether a telemetry message of messageLength bytes fits in the in-flight byte budget.
+// A message is always allowed when nothing is in flight, so a single message larger than the budget cannot stall the queue.
+//
+static bool isInflightByteBudgetAvailable(PMQTTTRANSPORT_HANDLE_DATA transport_data, size_t messageLength)
+{
+    return transport_data->max_inflight_telemetry_bytes == 0 ||
+        transport_data->telemetry_inflight_bytes == 0 ||
+        (transport_data->telemetry_inflight_bytes < transport_data->max_inflight_telemetry_bytes &&
+         messageLength <= transport_data->max_inflight_telemetry_bytes - transport_data->telemetry_inflight_bytes);
+}
+
 //
 // ProcessPublishStateDoWork traverses all messages waiting to be sent and attempts to PUBLISH them.
+// If a cap on in-flight telemetry (message count or payload bytes) has been set, messages past the cap are left on waitingToSend
+// until PUBACKs free up room.  If a batch size has been set, at most that many messages are PUBLISH'd per call.
 //
 static void ProcessPublishStateDoWork(PMQTTTRANSPORT_HANDLE_DATA transport_data)
 {
     PDLIST_ENTRY currentListEntry = transport_data->waitingToSend->Flink;
+    size_t batch_messages = 0;
+    size_t batch_bytes = 0;
     /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_027: [IoTHubTransport_MQTT_Common_DoWork shall inspect the "waitingToSend" DLIST passed in config structure.] */
-    while (currentListEntry != transport_data->waitingToSend)
+    while (currentListEntry != transport_data->waitingToSend &&
+        (transport_data->max_inflight_telemetry == 0 || transport_data->telemetry_inflight_count < transport_data->max_inflight_telemetry) &&
+        (transport_data->telemetry_publish_batch_size == 0 || batch_messages < transport_data->telemetry_publish_batch_size))
     {
         IOTHUB_MESSAGE_LIST* iothubMsgList = containingRecord(currentListEntry, IOTHUB_MESSAGE_LIST, entry);
         DLIST_ENTRY savedFromCurrentListEntry;
@@ -2949,24 +3469,33 @@ static void ProcessPublishStateDoWork(PMQTTTRANSPORT_HANDLE_DATA transport_data)
             notifyApplicationOfSendMessageComplete(iothubMsgList, transport_data, IOTHUB_CLIENT_CONFIRMATION_ERROR);
             LogError("Failure result from IoTHubMessage_GetData");
         }
+        else if (!isInflightByteBudgetAvailable(transport_data, messageLength))
+        {
+            // Keep publish order; this message and the ones behind it wait for PUBACKs to free up the budget.
+            break;
+        }
         else
         {
             /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_029: [IoTHubTransport_MQTT_Common_DoWork shall create a MQTT_MESSAGE_HANDLE and pass this to a call to mqtt_client_publish.] */
-            MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = (MQTT_MESSAGE_DETAILS_LIST*)malloc(sizeof(MQTT_MESSAGE_DETAILS_LIST));
+            MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = allocateMessageDetails(transport_data);
             if (mqttMsgEntry == NULL)
             {
+                // The message stays at the head of waitingToSend. Publishing the ones behind it would break the
+                // order, and the client relies on transports only taking messages from the head.
                 LogError("Allocation Error: Failure allocating MQTT Message Detail List.");
+                break;
             }
             else
             {
                 mqttMsgEntry->retryCount = 0;
                 mqttMsgEntry->iotHubMessageEntry = iothubMsgList;
                 mqttMsgEntry->packet_id = getNextPacketId(transport_data);
+                mqttMsgEntry->msgLength = messageLength;
                 if (publishTelemetryMsg(transport_data, mqttMsgEntry, messagePayload, messageLength) != 0)
                 {
                     (void)(DList_RemoveEntryList(currentListEntry));
                     notifyApplicationOfSendMessageComplete(iothubMsgList, transport_data, IOTHUB_CLIENT_CONFIRMATION_ERROR);
-                    free(mqttMsgEntry);
+                    releaseMessageDetails(transport_data, mqttMsgEntry);
                 }
                 else
                 {
@@ -2974,12 +3503,30 @@ static void ProcessPublishStateDoWork(PMQTTTRANSPORT_HANDLE_DATA transport_data)
                     (void)(DList_RemoveEntryList(currentListEntry));
                     // and add it to the ack queue
                     DList_InsertTailList(&(transport_data->telemetry_waitingForAck), &(mqttMsgEntry->entry));
+                    addToInflightIndex(transport_data, mqttMsgEntry);
+                    batch_messages++;
+                    batch_bytes += messageLength;
+
+                    if (transport_data->max_inflight_telemetry == 0 &&
+                        transport_data->telemetry_inflight_count > transport_data->telemetry_inflight_index_size * INFLIGHT_INDEX_MAX_LOAD &&
+                        transport_data->telemetry_inflight_index_size < MAX_INFLIGHT_INDEX_SIZE &&
+                        resizeInflightIndex(transport_data, transport_data->telemetry_inflight_index_size << 1) != 0)
+                    {
+                        // Not fatal; the current index keeps working, just with longer bucket chains.
+                        LogError("Failure growing in-flight telemetry index");
+                    }
                 }
             }
         }
         currentListEntry = savedFromCurrentListEntry.Flink;
     }
 
+    // Per-batch metrics, a batch being the messages PUBLISH'd by this DoWork pass.
+    if (batch_messages > 0 && transport_data->transport_callbacks.event_batch_sent_cb != NULL)
+    {
+        transport_data->transport_callbacks.event_batch_sent_cb(batch_messages, batch_bytes, transport_data->transport_ctx);
+    }
+
     if (transport_data->twin_resp_sub_recv)
     {
         sendPendingGetTwinRequests(transport_data);
@@ -3086,8 +3633,9 @@ void IoTHubTransport_MQTT_Common_Destroy(TRANSPORT_LL_HANDLE handle)
         {
             PDLIST_ENTRY currentEntry = DList_RemoveHeadList(&transport_data->telemetry_waitingForAck);
             MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = containingRecord(currentEntry, MQTT_MESSAGE_DETAILS_LIST, entry);
+            (void)removeFromInflightIndex(transport_data, mqttMsgEntry->packet_id);
             notifyApplicationOfSendMessageComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY);
-            free(mqttMsgEntry);
+            releaseMessageDetails(transport_data, mqttMsgEntry);
         }
         while (!DList_IsListEmpty(&transport_data->ack_waiting_queue))
         {
@@ -3468,6 +4016,9 @@ void IoTHubTransport_MQTT_Common_DoWork(TRANSPORT_LL_HANDLE handle)
     PMQTTTRANSPORT_HANDLE_DATA transport_data = (PMQTTTRANSPORT_HANDLE_DATA)handle;
     if (transport_data != NULL)
     {
+        // A new pass; the first helper needing the time reads the tick counter and the rest reuse it.
+        transport_data->dowork_time_valid = false;
+
         if (UpdateMqttConnectionStateIfNeeded(transport_data) == 0)
         {
             if (transport_data->mqttClientStatus == MQTT_CLIENT_STATUS_PENDING_CLOSE)
@@ -3494,6 +4045,8 @@ void IoTHubTransport_MQTT_Common_DoWork(TRANSPORT_LL_HANDLE handle)
         // Check the ack messages timeouts
         ProcessPendingTelemetryMessages(transport_data);
         removeExpiredTwinRequests(transport_data);
+
+        transport_data->dowork_time_valid = false;
     }
 }
 
@@ -3600,6 +4153,49 @@ IOTHUB_CLIENT_RESULT IoTHubTransport_MQTT_Common_SetOption(TRANSPORT_LL_HANDLE h
             transport_data->auto_url_encode_decode = *((bool*)value);
             result = IOTHUB_CLIENT_OK;
         }
+        else if (strcmp(OPTION_MAX_INFLIGHT_TELEMETRY, option) == 0)
+        {
+            size_t max_inflight = *((size_t*)value);
+            size_t index_size = getInflightIndexSizeFor(max_inflight);
+            // Entries of the current block still waiting for a PUBACK keep it in place; it keeps working, with
+            // the entries past it coming from the heap.
+            bool replace_detail_pool = transport_data->telemetry_detail_pool_in_use == 0;
+            size_t detail_pool_size = max_inflight < MAX_INFLIGHT_INDEX_SIZE ? max_inflight : MAX_INFLIGHT_INDEX_SIZE;
+            MQTT_MESSAGE_DETAILS_LIST* detail_pool = NULL;
+
+            if (replace_detail_pool && detail_pool_size != 0 &&
+                (detail_pool = (MQTT_MESSAGE_DETAILS_LIST*)malloc(detail_pool_size * sizeof(MQTT_MESSAGE_DETAILS_LIST))) == NULL)
+            {
+                LogError("Failure allocating in-flight telemetry entries for %lu messages", (unsigned long)detail_pool_size);
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else if (index_size != transport_data->telemetry_inflight_index_size &&
+                resizeInflightIndex(transport_data, index_size) != 0)
+            {
+                LogError("Failure sizing in-flight telemetry index for %lu messages", (unsigned long)max_inflight);
+                free(detail_pool);
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                if (replace_detail_pool)
+                {
+                    setMessageDetailsPool(transport_data, detail_pool, detail_pool_size);
+                }
+                transport_data->max_inflight_telemetry = max_inflight;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp(OPTION_MAX_INFLIGHT_TELEMETRY_BYTES, option) == 0)
+        {
+            transport_data->max_inflight_telemetry_bytes = *((size_t*)value);
+            result = IOTHUB_CLIENT_OK;
+        }
+        else if (strcmp(OPTION_TELEMETRY_PUBLISH_BATCH_SIZE, option) == 0)
+        {
+            transport_data->telemetry_publish_batch_size = *((size_t*)value);
+            result = IOTHUB_CLIENT_OK;
+        }
         else if (strcmp(OPTION_CONNECTION_TIMEOUT, option) == 0)
         {
             int* connection_time = (int*)value;
@@ -187,6 +187,11 @@ static int IoTHubTransportAMQP_GetSupportedPlatformInfo(TRANSPORT_LL_HANDLE hand
     return IoTHubTransport_AMQP_Common_GetSupportedPlatformInfo(handle, info);
 }
 
+static void IoTHubTransportAMQP_OnEventQueued(IOTHUB_DEVICE_HANDLE handle)
+{
+    IoTHubTransport_AMQP_Common_OnEventQueued(handle);
+}
+
 static TRANSPORT_PROVIDER thisTransportProvider =
 {
     IoTHubTransportAMQP_SendMessageDisposition,     /*pfIotHubTransport_Send_Message_Disposition IoTHubTransport_Send_Message_Disposition;*/
@@ -211,7 +216,8 @@ static TRANSPORT_PROVIDER thisTransportProvider =
     IotHubTransportAMQP_Unsubscribe_InputQueue,     /*pfIoTHubTransport_Unsubscribe_InputQueue IoTHubTransport_Unsubscribe_InputQueue; */
     IoTHubTransportAMQP_SetCallbackContext,         /*pfIoTHubTransport_SetTransportCallbacks IoTHubTransport_SetTransportCallbacks; */
     IoTHubTransportAMQP_GetTwinAsync,               /*pfIoTHubTransport_GetTwinAsync IoTHubTransport_GetTwinAsync;*/
-    IoTHubTransportAMQP_GetSupportedPlatformInfo      /*pfIoTHubTransport_GetSupportedPlatformInfo IoTHubTransport_GetSupportedPlatformInfo;*/
+    IoTHubTransportAMQP_GetSupportedPlatformInfo,   /*pfIoTHubTransport_GetSupportedPlatformInfo IoTHubTransport_GetSupportedPlatformInfo;*/
+    IoTHubTransportAMQP_OnEventQueued               /*pfIoTHubTransport_OnEventQueued IoTHubTransport_OnEventQueued;*/
 };
 
 /* Codes_SRS_IOTHUBTRANSPORTAMQP_09_019: [This function shall return a pointer to a structure of type TRANSPORT_PROVIDER having the following values for it's fields:
@@ -229,7 +235,8 @@ IoTHubTransport_Unsubscribe = IoTHubTransportAMQP_Unsubscribe
 IoTHubTransport_DoWork = IoTHubTransportAMQP_DoWork
 IoTHubTransport_SetRetryPolicy = IoTHubTransportAMQP_SetRetryPolicy
 IoTHubTransport_SetOption = IoTHubTransportAMQP_SetOption
-IoTHubTransport_GetSupportedPlatformInfo = IoTHubTransportAMQP_GetSupportedPlatformInfo]*/
+IoTHubTransport_GetSupportedPlatformInfo = IoTHubTransportAMQP_GetSupportedPlatformInfo
+IoTHubTransport_OnEventQueued = IoTHubTransportAMQP_OnEventQueued]*/
 extern const TRANSPORT_PROVIDER* AMQP_Protocol(void)
 {
     return &thisTransportProvider;
@@ -239,6 +239,11 @@ static int IoTHubTransportAMQP_WS_GetSupportedPlatformInfo(TRANSPORT_LL_HANDLE h
     return IoTHubTransport_AMQP_Common_GetSupportedPlatformInfo(handle, info);
 }
 
+static void IoTHubTransportAMQP_WS_OnEventQueued(IOTHUB_DEVICE_HANDLE handle)
+{
+    IoTHubTransport_AMQP_Common_OnEventQueued(handle);
+}
+
 static TRANSPORT_PROVIDER thisTransportProvider_WebSocketsOverTls =
 {
     IoTHubTransportAMQP_WS_SendMessageDisposition,                     /*pfIotHubTransport_Send_Message_Disposition IoTHubTransport_Send_Message_Disposition;*/
@@ -263,7 +268,8 @@ static TRANSPORT_PROVIDER thisTransportProvider_WebSocketsOverTls =
     IotHubTransportAMQP_WS_Unsubscribe_InputQueue,                     /*pfIoTHubTransport_Unsubscribe_InputQueue IoTHubTransport_Unsubscribe_InputQueue; */
     IoTHubTransportAMQP_WS_SetCallbackContext,                         /*pfIoTHubTransport_SetCallbackContext IoTHubTransport_SetCallbackContext; */
     IoTHubTransportAMQP_WS_GetTwinAsync,                               /*pfIoTHubTransport_GetTwinAsync IoTHubTransport_GetTwinAsync;*/
-    IoTHubTransportAMQP_WS_GetSupportedPlatformInfo                         /*pfIoTHubTransport_GetSupportedPlatformInfo IoTHubTransport_GetSupportedPlatformInfo;*/
+    IoTHubTransportAMQP_WS_GetSupportedPlatformInfo,                   /*pfIoTHubTransport_GetSupportedPlatformInfo IoTHubTransport_GetSupportedPlatformInfo;*/
+    IoTHubTransportAMQP_WS_OnEventQueued                               /*pfIoTHubTransport_OnEventQueued IoTHubTransport_OnEventQueued;*/
 };
 
 /* Codes_SRS_IoTHubTransportAMQP_WS_09_019: [This function shall return a pointer to a structure of type TRANSPORT_PROVIDER having the following values for it's fields:
@@ -284,7 +290,8 @@ IoTHubTransport_DoWork = IoTHubTransportAMQP_WS_DoWork
 IoTHubTransport_SetRetryLogic = IoTHubTransportAMQP_WS_SetRetryLogic
 IoTHubTransport_SetOption = IoTHubTransportAMQP_WS_SetOption
 IoTHubTransport_GetSendStatus = IoTHubTransportAMQP_WS_GetSendStatus
-IoTHubTransport_GetSupportedPlatformInfo = IoTHubTransportAMQP_WS_GetSupportedPlatformInfo] */
+IoTHubTransport_GetSupportedPlatformInfo = IoTHubTransportAMQP_WS_GetSupportedPlatformInfo
+IoTHubTransport_OnEventQueued = IoTHubTransportAMQP_WS_OnEventQueued] */
 extern const TRANSPORT_PROVIDER* AMQP_Protocol_over_WebSocketsTls(void)
 {
     return &thisTransportProvider_WebSocketsOverTls;
@@ -2,6 +2,8 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <stddef.h>
+#include <signal.h>
 #include "azure_c_shared_utility/gballoc.h"
 
 #include <time.h>
@@ -13,6 +15,7 @@
 #include "internal/iothubtransport.h"
 #include "internal/iothub_transport_ll_private.h"
 #include "internal/iothub_internal_consts.h"
+#include "internal/http_batch_encoder.h"
 
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/httpapiexsas.h"
@@ -21,11 +24,13 @@
 #include "azure_c_shared_utility/httpapiex.h"
 #include "azure_c_shared_utility/httpapiexsas.h"
 #include "azure_c_shared_utility/strings.h"
-#include "azure_c_shared_utility/azure_base64.h"
 #include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/vector.h"
 #include "azure_c_shared_utility/httpheaders.h"
 #include "azure_c_shared_utility/agenttime.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
 
 #define IOTHUB_APP_PREFIX "iothub-app-"
 static const char* IOTHUB_MESSAGE_ID = "iothub-messageid";
@@ -49,12 +54,34 @@ static const char* IOTHUB_AUTH_HEADER_VALUE = "Authorization";
 /*the default is 25 minutes*/
 #define DEFAULT_GETMINIMUMPOLLINGTIME ((unsigned int)25*60)
 
+/*DEFAULT_MAX_PARALLEL_REQUESTS is the number of HTTP connections that requests of the registered devices are spread over*/
+/*the default is 1, so the devices are served one after the other on a single connection*/
+#define DEFAULT_MAX_PARALLEL_REQUESTS 1
+
+/*MIN_PENDING_DEVICES_FOR_PARALLEL_REQUESTS is the number of devices that must have events to send or a poll due before DoWork spreads*/
+/*them over worker threads, below it creating and joining the threads costs more than the requests they would overlap*/
+#define MIN_PENDING_DEVICES_FOR_PARALLEL_REQUESTS 2
+
 #define MAXIMUM_MESSAGE_SIZE (255*1024-1)
-#define MAXIMUM_PAYLOAD_OVERHEAD 384
-#define MAXIMUM_PROPERTY_OVERHEAD 16
 
-/*forward declaration*/
-static int appendMapToJSON(STRING_HANDLE existing, const char* const* keys, const char* const* values, size_t count);
+struct HTTPTRANSPORT_HANDLE_DATA_TAG;
+
+typedef struct HTTP_WORKER_TAG
+{
+    struct HTTPTRANSPORT_HANDLE_DATA_TAG* transportData;
+    HTTPAPIEX_HANDLE httpApiExHandle;
+    size_t firstDevice; /*the worker serves devices firstDevice, firstDevice + deviceStride, ... up to deviceCount*/
+    size_t deviceStride;
+    size_t deviceCount;
+    THREAD_HANDLE threadHandle;
+    bool isThreadRunning; /*never for workers[0], nor when the thread could not be created: their devices are served on the calling thread*/
+    COND_HANDLE jobAvailable;
+    bool hasJob; /*set by DoWorkInParallel, cleared by the thread once its devices are served*/
+    sig_atomic_t stopThread;
+} HTTP_WORKER;
+
+/* Used for Unit test */
+const size_t IoTHubTransportHttp_WorkerTerminationOffset = offsetof(HTTP_WORKER, stopThread);
 
 typedef struct HTTPTRANSPORT_HANDLE_DATA_TAG
 {
@@ -64,6 +91,13 @@ typedef struct HTTPTRANSPORT_HANDLE_DATA_TAG
     unsigned int getMinimumPollingTime;
     VECTOR_HANDLE perDeviceList;
 
+    size_t maxParallelRequests;
+    HTTP_WORKER* workers; /*NULL when maxParallelRequests is 1. workers[0] uses httpApiExHandle, the others own a connection each*/
+    bool wereOptionsPassedDown;
+    LOCK_HANDLE workersLock; /*created with the first workers, guards their hasJob and stopThread and busyWorkers*/
+    COND_HANDLE workersDone;
+    size_t busyWorkers;
+
     TRANSPORT_CALLBACKS_INFO transport_callbacks;
     void* transport_ctx;
 
@@ -82,6 +116,7 @@ typedef struct HTTPTRANSPORT_PERDEVICE_DATA_TAG
     HTTP_HEADERS_HANDLE messageHTTPrequestHeaders;
     STRING_HANDLE abandonHTTPrelativePathBegin;
     HTTPAPIEX_SAS_HANDLE sasObject;
+    HTTPAPIEX_HANDLE httpApiExHandle; /*connection of the worker that last served the device*/
     bool DoWork_PullMessage;
     time_t lastPollTime;
     bool isFirstPoll;
@@ -840,6 +875,7 @@ static IOTHUB_DEVICE_HANDLE IoTHubTransportHttp_Register(TRANSPORT_LL_HANDLE han
                 result->waitingToSend = waitingToSend;
                 DList_InitializeListHead(&(result->eventConfirmations));
                 result->transportHandle = (HTTPTRANSPORT_HANDLE_DATA *)handle;
+                result->httpApiExHandle = handleData->httpApiExHandle;
             }
             else
             {
@@ -1023,6 +1059,260 @@ static bool create_perDeviceList(HTTPTRANSPORT_HANDLE_DATA* handleData)
     return result;
 }
 
+static void DoWorkForWorkerDevices(HTTP_WORKER* worker);
+
+static bool create_workersLock(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    bool result;
+    if ((handleData->workersLock = Lock_Init()) == NULL)
+    {
+        LogError("unable to create the lock of the HTTP workers");
+        result = false;
+    }
+    else if ((handleData->workersDone = Condition_Init()) == NULL)
+    {
+        LogError("unable to create the condition of the HTTP workers");
+        Lock_Deinit(handleData->workersLock);
+        handleData->workersLock = NULL;
+        result = false;
+    }
+    else
+    {
+        result = true;
+    }
+    return result;
+}
+
+static void destroy_workersLock(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    if (handleData->workersLock != NULL)
+    {
+        Condition_Deinit(handleData->workersDone);
+        Lock_Deinit(handleData->workersLock);
+        handleData->workersLock = NULL;
+    }
+}
+
+/*the thread of a worker lives as long as the worker, it waits for DoWorkInParallel to hand it a job*/
+static int http_worker_thread(void* userContextCallback)
+{
+    HTTP_WORKER* worker = (HTTP_WORKER*)userContextCallback;
+    HTTPTRANSPORT_HANDLE_DATA* handleData = worker->transportData;
+
+    if (Lock(handleData->workersLock) != LOCK_OK)
+    {
+        LogError("failed to lock for http_worker_thread");
+    }
+    else
+    {
+        while (!worker->stopThread)
+        {
+            if (!worker->hasJob)
+            {
+                if (Condition_Wait(worker->jobAvailable, handleData->workersLock, 0) == COND_ERROR)
+                {
+                    LogError("failed waiting for an HTTP job");
+                }
+            }
+            else
+            {
+                (void)Unlock(handleData->workersLock);
+                DoWorkForWorkerDevices(worker);
+                while (Lock(handleData->workersLock) != LOCK_OK)
+                {
+                    /*the job must be marked done, or DoWorkInParallel would wait forever*/
+                    LogError("failed to relock for http_worker_thread");
+                    ThreadAPI_Sleep(1);
+                }
+                worker->hasJob = false;
+                handleData->busyWorkers--;
+                (void)Condition_Post(handleData->workersDone);
+            }
+        }
+        (void)Unlock(handleData->workersLock);
+    }
+    return 0;
+}
+
+static void start_worker_threads(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    HTTP_WORKER* workers = handleData->workers;
+    size_t i;
+    for (i = 1; i < handleData->maxParallelRequests; i++)
+    {
+        if ((workers[i].jobAvailable = Condition_Init()) == NULL)
+        {
+            LogError("unable to create the condition of HTTP worker %lu, its devices are served on the calling thread", (unsigned long)i);
+        }
+        else if (ThreadAPI_Create(&workers[i].threadHandle, http_worker_thread, &workers[i]) != THREADAPI_OK)
+        {
+            LogError("unable to create HTTP worker thread %lu, its devices are served on the calling thread", (unsigned long)i);
+            Condition_Deinit(workers[i].jobAvailable);
+            workers[i].jobAvailable = NULL;
+        }
+        else
+        {
+            workers[i].isThreadRunning = true;
+        }
+    }
+}
+
+static void stop_worker_threads(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    HTTP_WORKER* workers = handleData->workers;
+    bool isLocked = (Lock(handleData->workersLock) == LOCK_OK);
+    size_t i;
+
+    if (!isLocked)
+    {
+        LogError("Unable to lock - will still attempt to end the HTTP worker threads without thread safety");
+    }
+    for (i = 1; i < handleData->maxParallelRequests; i++)
+    {
+        if (workers[i].isThreadRunning)
+        {
+            workers[i].stopThread = 1;
+            (void)Condition_Post(workers[i].jobAvailable);
+        }
+    }
+    if (isLocked)
+    {
+        (void)Unlock(handleData->workersLock);
+    }
+
+    for (i = 1; i < handleData->maxParallelRequests; i++)
+    {
+        if (workers[i].isThreadRunning)
+        {
+            int threadResult;
+            if (ThreadAPI_Join(workers[i].threadHandle, &threadResult) != THREADAPI_OK)
+            {
+                LogError("unable to join HTTP worker thread %lu", (unsigned long)i);
+            }
+            Condition_Deinit(workers[i].jobAvailable);
+            workers[i].isThreadRunning = false;
+        }
+    }
+}
+
+static void destroy_workers(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    if (handleData->workers != NULL)
+    {
+        size_t i;
+        stop_worker_threads(handleData);
+        /*workers[0] borrows the connection of the transport*/
+        for (i = 1; i < handleData->maxParallelRequests; i++)
+        {
+            HTTPAPIEX_Destroy(handleData->workers[i].httpApiExHandle);
+        }
+        free(handleData->workers);
+        handleData->workers = NULL;
+    }
+}
+
+static void reset_device_connections(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    size_t deviceListSize = VECTOR_size(handleData->perDeviceList);
+    size_t i;
+    for (i = 0; i < deviceListSize; i++)
+    {
+        IOTHUB_DEVICE_HANDLE* listItem = (IOTHUB_DEVICE_HANDLE *)VECTOR_element(handleData->perDeviceList, i);
+        HTTPTRANSPORT_PERDEVICE_DATA* perDeviceItem = *(HTTPTRANSPORT_PERDEVICE_DATA**)(listItem);
+        perDeviceItem->httpApiExHandle = handleData->httpApiExHandle;
+    }
+}
+
+static IOTHUB_CLIENT_RESULT set_max_parallel_requests(HTTPTRANSPORT_HANDLE_DATA* handleData, size_t maxParallelRequests)
+{
+    IOTHUB_CLIENT_RESULT result;
+    if (maxParallelRequests == 0)
+    {
+        LogError("invalid value 0 for option %s", OPTION_HTTP_MAX_PARALLEL_REQUESTS);
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else if ((maxParallelRequests > handleData->maxParallelRequests) && handleData->wereOptionsPassedDown)
+    {
+        /*new connections would miss the options already passed down to HTTPAPIEX*/
+        LogError("option %s cannot be raised after options of the HTTP connection were set", OPTION_HTTP_MAX_PARALLEL_REQUESTS);
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else if (maxParallelRequests == 1)
+    {
+        destroy_workers(handleData);
+        handleData->maxParallelRequests = 1;
+        reset_device_connections(handleData);
+        result = IOTHUB_CLIENT_OK;
+    }
+    else if ((handleData->workersLock == NULL) && !create_workersLock(handleData))
+    {
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else
+    {
+        HTTP_WORKER* workers = (HTTP_WORKER*)malloc(maxParallelRequests * sizeof(HTTP_WORKER));
+        if (workers == NULL)
+        {
+            LogError("unable to malloc");
+            result = IOTHUB_CLIENT_ERROR;
+        }
+        else
+        {
+            size_t i;
+            memset(workers, 0, maxParallelRequests * sizeof(HTTP_WORKER));
+            workers[0].httpApiExHandle = handleData->httpApiExHandle;
+            for (i = 1; i < maxParallelRequests; i++)
+            {
+                if (i < handleData->maxParallelRequests)
+                {
+                    /*connections of the previous workers are kept open*/
+                    workers[i].httpApiExHandle = handleData->workers[i].httpApiExHandle;
+                }
+                else if ((workers[i].httpApiExHandle = HTTPAPIEX_Create(STRING_c_str(handleData->hostName))) == NULL)
+                {
+                    LogError("unable to create HTTP connection %lu", (unsigned long)i);
+                    break;
+                }
+            }
+
+            if (i < maxParallelRequests)
+            {
+                size_t j;
+                for (j = handleData->maxParallelRequests; j < i; j++)
+                {
+                    HTTPAPIEX_Destroy(workers[j].httpApiExHandle);
+                }
+                free(workers);
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                if (handleData->workers != NULL)
+                {
+                    /*the threads refer to the previous workers, they are started again on the new ones*/
+                    stop_worker_threads(handleData);
+                    for (i = maxParallelRequests; i < handleData->maxParallelRequests; i++)
+                    {
+                        HTTPAPIEX_Destroy(handleData->workers[i].httpApiExHandle);
+                    }
+                    free(handleData->workers);
+                }
+
+                for (i = 0; i < maxParallelRequests; i++)
+                {
+                    workers[i].transportData = handleData;
+                }
+                handleData->workers = workers;
+                handleData->maxParallelRequests = maxParallelRequests;
+                start_worker_threads(handleData);
+                reset_device_connections(handleData);
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+    }
+    return result;
+}
+
 static TRANSPORT_LL_HANDLE IoTHubTransportHttp_Create(const IOTHUBTRANSPORT_CONFIG* config, TRANSPORT_CALLBACKS_INFO* cb_info, void* ctx)
 {
     HTTPTRANSPORT_HANDLE_DATA* result;
@@ -1088,6 +1378,12 @@ static TRANSPORT_LL_HANDLE IoTHubTransportHttp_Create(const IOTHUBTRANSPORT_CONF
                 /*Codes_SRS_TRANSPORTMULTITHTTP_17_011: [ Otherwise, IoTHubTransportHttp_Create shall succeed and return a non-NULL value. ]*/
                 result->doBatchedTransfers = false;
                 result->getMinimumPollingTime = DEFAULT_GETMINIMUMPOLLINGTIME;
+                result->maxParallelRequests = DEFAULT_MAX_PARALLEL_REQUESTS;
+                result->workers = NULL;
+                result->wereOptionsPassedDown = false;
+                result->workersLock = NULL;
+                result->workersDone = NULL;
+                result->busyWorkers = 0;
 
                 result->transport_ctx = ctx;
                 memcpy(&result->transport_callbacks, cb_info, sizeof(TRANSPORT_CALLBACKS_INFO));
@@ -1125,6 +1421,8 @@ static void IoTHubTransportHttp_Destroy(TRANSPORT_LL_HANDLE handle)
             free(perDeviceItem);
         }
 
+        destroy_workers(handleData);
+        destroy_workersLock(handleData);
         destroy_hostName((HTTPTRANSPORT_HANDLE_DATA *)handle);
         destroy_httpApiExHandle((HTTPTRANSPORT_HANDLE_DATA *)handle);
         destroy_perDeviceList((HTTPTRANSPORT_HANDLE_DATA *)handle);
@@ -1244,365 +1542,151 @@ static int IoTHubTransportHttp_DeviceMethod_Response(IOTHUB_DEVICE_HANDLE handle
 
 /*produces a representation of the properties, if they exist*/
 /*if they do not exist, produces ""*/
-static int concat_Properties(STRING_HANDLE existing, MAP_HANDLE map, size_t* propertiesMessageSizeContribution)
-{
-    int result;
-    const char*const* keys;
-    const char*const* values;
-    size_t count;
-    if (Map_GetInternals(map, &keys, &values, &count) != MAP_OK)
-    {
-        result = MU_FAILURE;
-        LogError("error while Map_GetInternals");
-    }
-    else
-    {
+#define MAKE_PAYLOAD_RESULT_VALUES \
+    MAKE_PAYLOAD_OK, /*returned when there is a payload to be later send by HTTP*/ \
+    MAKE_PAYLOAD_NO_ITEMS, /*returned when there are no items to be send*/ \
+    MAKE_PAYLOAD_ERROR, /*returned when there were errors*/ \
+    MAKE_PAYLOAD_FIRST_ITEM_DOES_NOT_FIT /*returned when the first item doesn't fit*/
 
-        if (count == 0)
-        {
-            /*Codes_SRS_TRANSPORTMULTITHTTP_17_064: [If IoTHubMessage does not have properties, then "properties":{...} shall be missing from the payload*/
-            /*no properties - do nothing with existing*/
-            result = 0;
-            *propertiesMessageSizeContribution = 0;
-        }
-        else
-        {
-            /*Codes_SRS_TRANSPORTMULTITHTTP_17_058: [If IoTHubMessage has properties, then they shall be serialized at the same level as "body" using the following pattern: "properties":{"iothub-app-name1":"value1","iothub-app-name2":"value2*/
-            if (STRING_concat(existing, ",\"properties\":") != 0)
-            {
-                /*go ahead and return it*/
-                result = MU_FAILURE;
-                LogError("failed STRING_concat");
-            }
-            else if (appendMapToJSON(existing, keys, values, count) != 0)
-            {
-                result = MU_FAILURE;
-                LogError("unable to append the properties");
-            }
-            else
-            {
-                /*all is fine*/
-                size_t i;
-                *propertiesMessageSizeContribution = 0;
-                for (i = 0; i < count; i++)
-                {
-                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_063: [Every property name shall add to the message size the length of the property name + the length of the property value + 16 bytes.] */
-                    *propertiesMessageSizeContribution += (strlen(keys[i]) + strlen(values[i]) + MAXIMUM_PROPERTY_OVERHEAD);
-                }
-                result = 0;
-            }
-        }
-    }
-    return result;
+MU_DEFINE_ENUM(MAKE_PAYLOAD_RESULT, MAKE_PAYLOAD_RESULT_VALUES);
+
+static void reversePutListBackIn(PDLIST_ENTRY source, PDLIST_ENTRY destination)
+{
+    /*this function takes a list, and inserts it in another list. When done in the context of this file, it reverses the effects of a not-able-to-send situation*/
+    DList_AppendTailList(destination->Flink, source);
+    DList_RemoveEntryList(source);
+    DList_InitializeListHead(source);
 }
 
-/*produces a JSON representation of the map : {"a": "value_of_a","b":"value_of_b"}*/
-static int appendMapToJSON(STRING_HANDLE existing, const char* const* keys, const char* const* values, size_t count) /*under consideration: move to MAP module when it has more than 1 user*/
+/*reports the events of a request that reached the service, the whole body is accounted to the first of them since they all belong to the same device*/
+static void notifyEventsSent(HTTPTRANSPORT_HANDLE_DATA* handleData, PDLIST_ENTRY events, BUFFER_HANDLE body)
 {
-    int result;
-    if (STRING_concat(existing, "{") != 0)
-    {
-        /*go on and return it*/
-        LogError("STRING_construct failed");
-        result = MU_FAILURE;
-    }
-    else
+    if (handleData->transport_callbacks.event_sent_cb != NULL)
     {
-        size_t i;
-        for (i = 0; i < count; i++)
+        size_t bytes_sent = BUFFER_length(body);
+        PDLIST_ENTRY actual;
+        for (actual = events->Flink; actual != events; actual = actual->Flink)
         {
-            if (!(
-                (STRING_concat(existing, (i == 0) ? "\"" IOTHUB_APP_PREFIX : ",\"" IOTHUB_APP_PREFIX) == 0) &&
-                (STRING_concat(existing, keys[i]) == 0) &&
-                (STRING_concat(existing, "\":\"") == 0) &&
-                (STRING_concat(existing, values[i]) == 0) &&
-                (STRING_concat(existing, "\"") == 0)
-                ))
-            {
-                LogError("unable to STRING_concat");
-                break;
-            }
+            handleData->transport_callbacks.event_sent_cb(containingRecord(actual, IOTHUB_MESSAGE_LIST, entry), bytes_sent);
+            bytes_sent = 0;
         }
+    }
+}
 
-        if (i < count)
+/*this function assembles several {"body":"base64 encoding of the message content"," base64Encoded": true} into 1 payload*/
+/*Codes_SRS_TRANSPORTMULTITHTTP_17_056: [IoTHubTransportHttp_DoWork shall build the following string:[{"body":"base64 encoding of the message1 content"},{"body":"base64 encoding of the message2 content"}...]]*/
+/*the items that fit are measured first, so that the payload is allocated once and every item is encoded straight into it*/
+static MAKE_PAYLOAD_RESULT makePayload(HTTPTRANSPORT_PERDEVICE_DATA* deviceData, BUFFER_HANDLE* payload)
+{
+    MAKE_PAYLOAD_RESULT result;
+    size_t allMessagesSize = 0;
+    size_t payloadSize = 1; /*"[", the comma after the last item becomes "]"*/
+    size_t itemCount = 0;
+    bool isFirstItemTooBig = false;
+    PDLIST_ENTRY actual;
+
+    *payload = NULL;
+    for (actual = deviceData->waitingToSend->Flink; actual != deviceData->waitingToSend; actual = actual->Flink)
+    {
+        IOTHUB_MESSAGE_LIST* message = containingRecord(actual, IOTHUB_MESSAGE_LIST, entry);
+        size_t encodedSize;
+        size_t messageSize;
+        if (http_batch_encoder_measure(message->messageHandle, &encodedSize, &messageSize) != 0)
         {
-            result = MU_FAILURE;
-            /*error, let it go through*/
+            /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
+            LogError("unable to encode message %lu of the batch", (unsigned long)itemCount);
+            break;
         }
-        else if (STRING_concat(existing, "}") != 0)
+        /*Codes_SRS_TRANSPORTMULTITHTTP_17_061: [The message size shall be limited to 255KB - 1 byte.]*/
+        else if (allMessagesSize + messageSize > MAXIMUM_MESSAGE_SIZE)
         {
-            LogError("unable to STRING_concat");
-            result = MU_FAILURE;
+            isFirstItemTooBig = (itemCount == 0);
+            break;
         }
         else
         {
-            /*all is fine*/
-            result = 0;
+            allMessagesSize += messageSize;
+            payloadSize += encodedSize;
+            itemCount++;
         }
     }
-    return result;
-}
-
-/*makes the following string:{"body":"base64 encoding of the message content"[,"properties":{"a":"valueOfA"}]}*/
-/*return NULL if there was a failure, or a non-NULL STRING_HANDLE that contains the intended data*/
-static STRING_HANDLE make1EventJSONitem(PDLIST_ENTRY item, size_t *messageSizeContribution)
-{
-    STRING_HANDLE result; /*temp wants to contain :{"body":"base64 encoding of the message content"[,"properties":{"a":"valueOfA"}]}*/
-    IOTHUB_MESSAGE_LIST* message = containingRecord(item, IOTHUB_MESSAGE_LIST, entry);
-    IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(message->messageHandle);
 
-    switch (contentType)
+    if (isFirstItemTooBig)
     {
-    case IOTHUBMESSAGE_BYTEARRAY:
-    {
-        result = STRING_construct("{\"body\":\"");
-        if (result == NULL)
-        {
-            LogError("unable to STRING_construct");
-        }
-        else
-        {
-            const unsigned char* source;
-            size_t size;
-
-            if (IoTHubMessage_GetByteArray(message->messageHandle, &source, &size) != IOTHUB_MESSAGE_OK)
-            {
-                LogError("unable to get the data for the message.");
-                STRING_delete(result);
-                result = NULL;
-            }
-            else
-            {
-                STRING_HANDLE encoded = Azure_Base64_Encode_Bytes(source, size);
-                if (encoded == NULL)
-                {
-                    LogError("unable to Azure_Base64_Encode_Bytes.");
-                    STRING_delete(result);
-                    result = NULL;
-                }
-                else
-                {
-                    size_t propertiesSize = 0;
-                    if (!(
-                        (STRING_concat_with_STRING(result, encoded) == 0) &&
-                        (STRING_concat(result, "\"") == 0) && /*\" because closing value*/
-                        (concat_Properties(result, IoTHubMessage_Properties(message->messageHandle), &propertiesSize) == 0) &&
-                        (STRING_concat(result, "},") == 0) /*the last comma shall be replaced by a ']' by DaCr's suggestion (which is awesome enough to receive credits in the source code)*/
-                        ))
-                    {
-                        STRING_delete(result);
-                        result = NULL;
-                        LogError("unable to STRING_concat_with_STRING.");
-                    }
-                    else
-                    {
-                        /*all is fine... */
-                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_062: [The message size is computed from the length of the payload + 384.] */
-                        *messageSizeContribution = size + MAXIMUM_PAYLOAD_OVERHEAD + propertiesSize;
-                    }
-                    STRING_delete(encoded);
-                }
-            }
-        }
-        break;
+        /*Codes_SRS_TRANSPORTMULTITHTTP_17_065: [If the oldest message in waitingToSend causes the message size to exceed the message size limit then it shall be removed from waitingToSend, and IoTHubClientCore_LL_SendComplete shall be called. Parameter PDLIST_ENTRY completed shall point to a list containing only the oldest item, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_BATCHSTATE_FAILED.]*/
+        PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend);
+        DList_InsertTailList(&(deviceData->eventConfirmations), head);
+        result = MAKE_PAYLOAD_FIRST_ITEM_DOES_NOT_FIT;
     }
-    /*Codes_SRS_TRANSPORTMULTITHTTP_17_057: [If a messages to be send has type IOTHUBMESSAGE_STRING, then its serialization shall be {"body":"JSON encoding of the string", "base64Encoded":false}] */
-    case IOTHUBMESSAGE_STRING:
+    else if (itemCount == 0)
     {
-        result = STRING_construct("{\"body\":");
-        if (result == NULL)
-        {
-            LogError("unable to STRING_construct");
-        }
-        else
-        {
-            const char* source = IoTHubMessage_GetString(message->messageHandle);
-            if (source == NULL)
-            {
-                LogError("unable to IoTHubMessage_GetString");
-                STRING_delete(result);
-                result = NULL;
-            }
-            else
-            {
-                STRING_HANDLE asJson = STRING_new_JSON(source);
-                if (asJson == NULL)
-                {
-                    LogError("unable to STRING_new_JSON");
-                    STRING_delete(result);
-                    result = NULL;
-                }
-                else
-                {
-                    size_t propertiesSize = 0;
-                    if (!(
-                        (STRING_concat_with_STRING(result, asJson) == 0) &&
-                        (STRING_concat(result, ",\"base64Encoded\":false") == 0) &&
-                        (concat_Properties(result, IoTHubMessage_Properties(message->messageHandle), &propertiesSize) == 0) &&
-                        (STRING_concat(result, "},") == 0) /*the last comma shall be replaced by a ']' by DaCr's suggestion (which is awesome enough to receive credits in the source code)*/
-                        ))
-                    {
-                        LogError("unable to STRING_concat_with_STRING");
-                        STRING_delete(result);
-                        result = NULL;
-                    }
-                    else
-                    {
-                        /*result has the intended content*/
-                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_062: [The message size is computed from the length of the payload + 384.] */
-                        *messageSizeContribution = strlen(source) + MAXIMUM_PAYLOAD_OVERHEAD + propertiesSize;
-                    }
-                    STRING_delete(asJson);
-                }
-            }
-        }
-        break;
+        /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
+        result = (actual == deviceData->waitingToSend) ? MAKE_PAYLOAD_NO_ITEMS : MAKE_PAYLOAD_ERROR;
     }
-    default:
+    else if ((*payload = BUFFER_new()) == NULL)
     {
-        LogError("an unknown message type was encountered (%d)", contentType);
-        result = NULL; /*unknown message type*/
-        break;
-    }
+        LogError("unable to BUFFER_new");
+        result = MAKE_PAYLOAD_ERROR;
     }
-    return result;
-}
-
-#define MAKE_PAYLOAD_RESULT_VALUES \
-    MAKE_PAYLOAD_OK, /*returned when there is a payload to be later send by HTTP*/ \
-    MAKE_PAYLOAD_NO_ITEMS, /*returned when there are no items to be send*/ \
-    MAKE_PAYLOAD_ERROR, /*returned when there were errors*/ \
-    MAKE_PAYLOAD_FIRST_ITEM_DOES_NOT_FIT /*returned when the first item doesn't fit*/
-
-MU_DEFINE_ENUM(MAKE_PAYLOAD_RESULT, MAKE_PAYLOAD_RESULT_VALUES);
-
-/*this function assembles several {"body":"base64 encoding of the message content"," base64Encoded": true} into 1 payload*/
-/*Codes_SRS_TRANSPORTMULTITHTTP_17_056: [IoTHubTransportHttp_DoWork shall build the following string:[{"body":"base64 encoding of the message1 content"},{"body":"base64 encoding of the message2 content"}...]]*/
-static MAKE_PAYLOAD_RESULT makePayload(HTTPTRANSPORT_PERDEVICE_DATA* deviceData, STRING_HANDLE* payload)
-{
-    MAKE_PAYLOAD_RESULT result;
-    size_t allMessagesSize = 0;
-    *payload = STRING_construct("[");
-    if (*payload == NULL)
+    else if (BUFFER_pre_build(*payload, payloadSize) != 0)
     {
-        LogError("unable to STRING_construct");
+        LogError("unable to BUFFER_pre_build");
+        BUFFER_delete(*payload);
+        *payload = NULL;
         result = MAKE_PAYLOAD_ERROR;
     }
     else
     {
-        bool isFirst = true;
-        PDLIST_ENTRY actual;
-        bool keepGoing = true; /*keepGoing gets sometimes to false from within the loop*/
-                               /*either all the items enter the list or only some*/
-        result = MAKE_PAYLOAD_OK; /*optimistically initializing it*/
-        while (keepGoing && ((actual = deviceData->waitingToSend->Flink) != deviceData->waitingToSend))
-        {
-            size_t messageSize;
-            STRING_HANDLE temp = make1EventJSONitem(actual, &messageSize);
-            if (isFirst)
+        unsigned char* destination = BUFFER_u_char(*payload);
+        size_t remaining = payloadSize - 1;
+        size_t i;
+        *destination++ = '[';
+        for (i = 0; i < itemCount; i++)
+        {
+            IOTHUB_MESSAGE_LIST* message = containingRecord(deviceData->waitingToSend->Flink, IOTHUB_MESSAGE_LIST, entry);
+            size_t written = http_batch_encoder_write(message->messageHandle, destination, remaining);
+            if (written == 0)
             {
-                isFirst = false;
-                /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
-                if (temp == NULL) /*first item failed to create, nothing to send*/
-                {
-                    result = MAKE_PAYLOAD_ERROR;
-                    STRING_delete(*payload);
-                    *payload = NULL;
-                    keepGoing = false;
-                }
-                else
-                {
-                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_065: [If the oldest message in waitingToSend causes the message size to exceed the message size limit then it shall be removed from waitingToSend, and IoTHubClientCore_LL_SendComplete shall be called. Parameter PDLIST_ENTRY completed shall point to a list containing only the oldest item, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_BATCHSTATE_FAILED.]*/
-                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_061: [The message size shall be limited to 255KB - 1 byte.]*/
-                    if (messageSize > MAXIMUM_MESSAGE_SIZE)
-                    {
-                        PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
-                        DList_InsertTailList(&(deviceData->eventConfirmations), head);
-                        result = MAKE_PAYLOAD_FIRST_ITEM_DOES_NOT_FIT;
-                        STRING_delete(*payload);
-                        *payload = NULL;
-                        keepGoing = false;
-                    }
-                    else
-                    {
-                        if (STRING_concat_with_STRING(*payload, temp) != 0)
-                        {
-                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
-                            result = MAKE_PAYLOAD_ERROR;
-                            STRING_delete(*payload);
-                            *payload = NULL;
-                            keepGoing = false;
-                        }
-                        else
-                        {
-                            /*first item was put nicely in the payload*/
-                            PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
-                            DList_InsertTailList(&(deviceData->eventConfirmations), head);
-                            allMessagesSize += messageSize;
-                        }
-                    }
-                    STRING_delete(temp);
-                }
+                LogError("unable to write message %lu of the batch", (unsigned long)i);
+                break;
             }
             else
             {
-                /*there is at least 1 item already in the payload*/
-                if (temp == NULL)
-                {
-                    /*there are multiple payloads encoded, the last one had an internal error, just go with those - closing the payload happens "after the loop"*/
-                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
-                    result = MAKE_PAYLOAD_OK;
-                    keepGoing = false;
-                }
-                else
-                {
-                    if (allMessagesSize + messageSize > MAXIMUM_MESSAGE_SIZE)
-                    {
-                        /*this item doesn't make it to the payload, but the payload is valid so far*/
-                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
-                        result = MAKE_PAYLOAD_OK;
-                        keepGoing = false;
-                    }
-                    else if (STRING_concat_with_STRING(*payload, temp) != 0)
-                    {
-                        /*should still send what there is so far...*/
-                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
-                        result = MAKE_PAYLOAD_OK;
-                        keepGoing = false;
-                    }
-                    else
-                    {
-                        /*cool, the payload made it there, let's continue... */
-                        PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
-                        DList_InsertTailList(&(deviceData->eventConfirmations), head);
-                        allMessagesSize += messageSize;
-                    }
-                    STRING_delete(temp);
-                }
+                PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "message", but now it is removed*/
+                DList_InsertTailList(&(deviceData->eventConfirmations), head);
+                destination += written;
+                remaining -= written;
             }
         }
 
-        /*closing the payload*/
-        if (result == MAKE_PAYLOAD_OK)
+        if (i == 0)
         {
-            ((char*)STRING_c_str(*payload))[STRING_length(*payload) - 1] = ']'; /*TODO - do this in STRING_HANDLE*/
+            BUFFER_delete(*payload);
+            *payload = NULL;
+            result = MAKE_PAYLOAD_ERROR;
         }
         else
         {
-            /*no need to close anything*/
+            /*closing the payload: the comma after the last item becomes "]"*/
+            destination[-1] = ']';
+            /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
+            if ((remaining > 0) && (BUFFER_shrink(*payload, remaining, true) != 0))
+            {
+                LogError("unable to BUFFER_shrink");
+                reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
+                BUFFER_delete(*payload);
+                *payload = NULL;
+                result = MAKE_PAYLOAD_ERROR;
+            }
+            else
+            {
+                result = MAKE_PAYLOAD_OK;
+            }
         }
     }
     return result;
 }
 
-static void reversePutListBackIn(PDLIST_ENTRY source, PDLIST_ENTRY destination)
-{
-    /*this function takes a list, and inserts it in another list. When done in the context of this file, it reverses the effects of a not-able-to-send situation*/
-    DList_AppendTailList(destination->Flink, source);
-    DList_RemoveEntryList(source);
-    DList_InitializeListHead(source);
-}
-
 static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData)
 {
 
@@ -1624,67 +1708,47 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
             else
             {
                 /*Codes_SRS_TRANSPORTMULTITHTTP_17_059: [It shall inspect the "waitingToSend" DLIST passed in config structure.] */
-                STRING_HANDLE payload;
+                BUFFER_HANDLE payload;
                 switch (makePayload(deviceData, &payload))
                 {
                 case MAKE_PAYLOAD_OK:
                 {
                     /*Codes_SRS_TRANSPORTMULTITHTTP_17_068: [Once a final payload has been obtained, IoTHubTransportHttp_DoWork shall call HTTPAPIEX_SAS_ExecuteRequest passing the following parameters:] */
-                    BUFFER_HANDLE temp = BUFFER_new();
-                    if (temp == NULL)
+                    unsigned int statusCode;
+                    if (HTTPAPIEX_SAS_ExecuteRequest(
+                        deviceData->sasObject,
+                        deviceData->httpApiExHandle,
+                        HTTPAPI_REQUEST_POST,
+                        STRING_c_str(deviceData->eventHTTPrelativePath),
+                        deviceData->eventHTTPrequestHeaders,
+                        payload,
+                        &statusCode,
+                        NULL,
+                        NULL
+                    ) != HTTPAPIEX_OK)
                     {
-                        LogError("unable to BUFFER_new");
-                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
+                        LogError("unable to HTTPAPIEX_ExecuteRequest");
+                        //items go back to waitingToSend
+                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
                         reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
                     }
                     else
                     {
-                        if (BUFFER_build(temp, (const unsigned char*)STRING_c_str(payload), STRING_length(payload)) != 0)
+                        notifyEventsSent(handleData, &(deviceData->eventConfirmations), payload);
+                        if (statusCode < 300)
                         {
-                            LogError("unable to BUFFER_build");
-                            //items go back to waitingToSend
-                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
-                            reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
+                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_070: [If HTTPAPIEX_SAS_ExecuteRequest does not fail and http status code <300 then IoTHubTransportHttp_DoWork shall call IoTHubClientCore_LL_SendComplete. Parameter PDLIST_ENTRY completed shall point to a list containing all the items batched, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_OK. The batched items shall be removed from waitingToSend.] */
+                            handleData->transport_callbacks.send_complete_cb(&(deviceData->eventConfirmations), IOTHUB_CLIENT_CONFIRMATION_OK, deviceData->device_transport_ctx);
                         }
                         else
                         {
-                            unsigned int statusCode;
-                            if (HTTPAPIEX_SAS_ExecuteRequest(
-                                deviceData->sasObject,
-                                handleData->httpApiExHandle,
-                                HTTPAPI_REQUEST_POST,
-                                STRING_c_str(deviceData->eventHTTPrelativePath),
-                                deviceData->eventHTTPrequestHeaders,
-                                temp,
-                                &statusCode,
-                                NULL,
-                                NULL
-                            ) != HTTPAPIEX_OK)
-                            {
-                                LogError("unable to HTTPAPIEX_ExecuteRequest");
-                                //items go back to waitingToSend
-                                /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
-                                reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
-                            }
-                            else
-                            {
-                                if (statusCode < 300)
-                                {
-                                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_070: [If HTTPAPIEX_SAS_ExecuteRequest does not fail and http status code <300 then IoTHubTransportHttp_DoWork shall call IoTHubClientCore_LL_SendComplete. Parameter PDLIST_ENTRY completed shall point to a list containing all the items batched, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_OK. The batched items shall be removed from waitingToSend.] */
-                                    handleData->transport_callbacks.send_complete_cb(&(deviceData->eventConfirmations), IOTHUB_CLIENT_CONFIRMATION_OK, deviceData->device_transport_ctx);
-                                }
-                                else
-                                {
-                                    //items go back to waitingToSend
-                                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
-                                    LogError("unexpected HTTP status code (%u)", statusCode);
-                                    reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
-                                }
-                            }
+                            //items go back to waitingToSend
+                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
+                            LogError("unexpected HTTP status code (%u)", statusCode);
+                            reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
                         }
-                        BUFFER_delete(temp);
                     }
-                    STRING_delete(payload);
+                    BUFFER_delete(payload);
                     break;
                 }
                 case MAKE_PAYLOAD_FIRST_ITEM_DOES_NOT_FIT:
@@ -1801,7 +1865,7 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                                             }
                                             /*Codes_SRS_TRANSPORTMULTITHTTP_03_003: [If a deviceSasToken exists, IoTHubTransportHttp_DoWork shall call HTTPAPIEX_ExecuteRequest passing the following parameters] */
                                             else if ((r = HTTPAPIEX_ExecuteRequest(
-                                                handleData->httpApiExHandle, HTTPAPI_REQUEST_POST, STRING_c_str(deviceData->eventHTTPrelativePath),
+                                                deviceData->httpApiExHandle, HTTPAPI_REQUEST_POST, STRING_c_str(deviceData->eventHTTPrelativePath),
                                                 clonedEventHTTPrequestHeaders, toBeSend, &statusCode, NULL, NULL)) != HTTPAPIEX_OK)
                                             {
                                                 LogError("Unable to HTTPAPIEX_ExecuteRequest.");
@@ -1810,7 +1874,7 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                                         else
                                         {
                                             /*Codes_SRS_TRANSPORTMULTITHTTP_17_080: [If a deviceSasToken does not exist, IoTHubTransportHttp_DoWork shall call HTTPAPIEX_SAS_ExecuteRequest passing the following parameters] */
-                                            if ((r = HTTPAPIEX_SAS_ExecuteRequest(deviceData->sasObject, handleData->httpApiExHandle, HTTPAPI_REQUEST_POST, STRING_c_str(deviceData->eventHTTPrelativePath),
+                                            if ((r = HTTPAPIEX_SAS_ExecuteRequest(deviceData->sasObject, deviceData->httpApiExHandle, HTTPAPI_REQUEST_POST, STRING_c_str(deviceData->eventHTTPrelativePath),
                                                 clonedEventHTTPrequestHeaders, toBeSend, &statusCode, NULL, NULL )) != HTTPAPIEX_OK)
                                             {
                                                 LogError("unable to HTTPAPIEX_SAS_ExecuteRequest");
@@ -1818,6 +1882,11 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                                         }
                                         if (r == HTTPAPIEX_OK)
                                         {
+                                            if (handleData->transport_callbacks.event_sent_cb != NULL)
+                                            {
+                                                handleData->transport_callbacks.event_sent_cb(message, BUFFER_length(toBeSend));
+                                            }
+
                                             if (statusCode < 300)
                                             {
                                                 /*Codes_SRS_TRANSPORTMULTITHTTP_17_082: [If HTTPAPIEX_SAS_ExecuteRequest does not fail and http status code <300 then IoTHubTransportHttp_DoWork shall call IoTHubClientCore_LL_SendComplete. Parameter PDLIST_ENTRY completed shall point to a list the item send, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_OK. The item shall be removed from waitingToSend.] */
@@ -1956,7 +2025,7 @@ static bool abandonOrAcceptMessage(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTR
                                 LogError("Unable to replace the old SAS Token.");
                             }
                             else if ((r = HTTPAPIEX_ExecuteRequest(
-                                handleData->httpApiExHandle,
+                                deviceData->httpApiExHandle,
                                 (action == IOTHUBMESSAGE_ABANDONED) ? HTTPAPI_REQUEST_POST : HTTPAPI_REQUEST_DELETE,                               /*-requestType: POST                                                                                                       */
                                 STRING_c_str(fullAbandonRelativePath),              /*-relativePath: abandon relative path begin (as created by _Create) + value of ETag + "/abandon?api-version=2016-11-14"   */
                                 abandonRequestHttpHeaders,                          /*- requestHttpHeadersHandle: an HTTP headers instance containing the following                                            */
@@ -1974,7 +2043,7 @@ static bool abandonOrAcceptMessage(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTR
                         }
                         else if ((r = HTTPAPIEX_SAS_ExecuteRequest(
                             deviceData->sasObject,
-                            handleData->httpApiExHandle,
+                            deviceData->httpApiExHandle,
                             (action == IOTHUBMESSAGE_ABANDONED) ? HTTPAPI_REQUEST_POST : HTTPAPI_REQUEST_DELETE,                               /*-requestType: POST                                                                                                       */
                             STRING_c_str(fullAbandonRelativePath),              /*-relativePath: abandon relative path begin (as created by _Create) + value of ETag + "/abandon?api-version=2016-11-14"   */
                             abandonRequestHttpHeaders,                          /*- requestHttpHeadersHandle: an HTTP headers instance containing the following                                            */
@@ -2131,17 +2200,21 @@ static MESSAGE_CALLBACK_INFO* MESSAGE_CALLBACK_INFO_Create(IOTHUB_MESSAGE_HANDLE
     return result;
 }
 
+static bool is_polling_allowed(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData, time_t timeNow)
+{
+    return deviceData->isFirstPoll || (timeNow == (time_t)(-1)) || (get_difftime(timeNow, deviceData->lastPollTime) > handleData->getMinimumPollingTime);
+}
+
 static void DoMessages(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData)
 {
     /*Codes_SRS_TRANSPORTMULTITHTTP_17_083: [ If device is not subscribed then _DoWork shall advance to the next action. ] */
     if (deviceData->DoWork_PullMessage)
     {
+        time_t timeNow = get_time(NULL);
         /*Codes_SRS_TRANSPORTMULTITHTTP_17_123: [After client creation, the first GET shall be allowed no matter what the value of GetMinimumPollingTime.] */
         /*Codes_SRS_TRANSPORTMULTITHTTP_17_124: [If time is not available then all calls shall be treated as if they are the first one.] */
         /*Codes_SRS_TRANSPORTMULTITHTTP_17_122: [A GET request that happens earlier than GetMinimumPollingTime shall be ignored.] */
-        time_t timeNow = get_time(NULL);
-        bool isPollingAllowed = deviceData->isFirstPoll || (timeNow == (time_t)(-1)) || (get_difftime(timeNow, deviceData->lastPollTime) > handleData->getMinimumPollingTime);
-        if (isPollingAllowed)
+        if (is_polling_allowed(handleData, deviceData, timeNow))
         {
             HTTP_HEADERS_HANDLE responseHTTPHeaders = HTTPHeaders_Alloc();
             if (responseHTTPHeaders == NULL)
@@ -2171,7 +2244,7 @@ static void DoMessages(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERD
                             LogError("Unable to replace the old SAS Token.");
                         }
                         else if ((r = HTTPAPIEX_ExecuteRequest(
-                            handleData->httpApiExHandle,
+                            deviceData->httpApiExHandle,
                             HTTPAPI_REQUEST_GET,                                            /*requestType: GET*/
                             STRING_c_str(deviceData->messageHTTPrelativePath),         /*relativePath: the message HTTP relative path*/
                             deviceData->messageHTTPrequestHeaders,                     /*requestHttpHeadersHandle: message HTTP request headers created by _Create*/
@@ -2197,7 +2270,7 @@ static void DoMessages(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERD
                     */
                     else if ((r = HTTPAPIEX_SAS_ExecuteRequest(
                         deviceData->sasObject,
-                        handleData->httpApiExHandle,
+                        deviceData->httpApiExHandle,
                         HTTPAPI_REQUEST_GET,                                            /*requestType: GET*/
                         STRING_c_str(deviceData->messageHTTPrelativePath),         /*relativePath: the message HTTP relative path*/
                         deviceData->messageHTTPrequestHeaders,                     /*requestHttpHeadersHandle: message HTTP request headers created by _Create*/
@@ -2340,23 +2413,119 @@ static IOTHUB_PROCESS_ITEM_RESULT IoTHubTransportHttp_ProcessItem(TRANSPORT_LL_H
     return IOTHUB_PROCESS_ERROR;
 }
 
+static void DoWorkForWorkerDevices(HTTP_WORKER* worker)
+{
+    HTTPTRANSPORT_HANDLE_DATA* handleData = worker->transportData;
+    size_t i;
+    for (i = worker->firstDevice; i < worker->deviceCount; i += worker->deviceStride)
+    {
+        IOTHUB_DEVICE_HANDLE* listItem = (IOTHUB_DEVICE_HANDLE *)VECTOR_element(handleData->perDeviceList, i);
+        HTTPTRANSPORT_PERDEVICE_DATA* perDeviceItem = *(HTTPTRANSPORT_PERDEVICE_DATA**)(listItem);
+        perDeviceItem->httpApiExHandle = worker->httpApiExHandle;
+        DoEvent(handleData, perDeviceItem);
+        DoMessages(handleData, perDeviceItem);
+    }
+}
+
+/*returns true once MIN_PENDING_DEVICES_FOR_PARALLEL_REQUESTS devices have events waiting or a poll due, it stops looking there*/
+static bool has_enough_pending_devices_for_parallel_requests(HTTPTRANSPORT_HANDLE_DATA* handleData, size_t deviceListSize)
+{
+    size_t pendingDevices = 0;
+    size_t i;
+    for (i = 0; (i < deviceListSize) && (pendingDevices < MIN_PENDING_DEVICES_FOR_PARALLEL_REQUESTS); i++)
+    {
+        IOTHUB_DEVICE_HANDLE* listItem = (IOTHUB_DEVICE_HANDLE *)VECTOR_element(handleData->perDeviceList, i);
+        HTTPTRANSPORT_PERDEVICE_DATA* perDeviceItem = *(HTTPTRANSPORT_PERDEVICE_DATA**)(listItem);
+        if (!DList_IsListEmpty(perDeviceItem->waitingToSend) ||
+            (perDeviceItem->DoWork_PullMessage && is_polling_allowed(handleData, perDeviceItem, get_time(NULL))))
+        {
+            pendingDevices++;
+        }
+    }
+    return pendingDevices >= MIN_PENDING_DEVICES_FOR_PARALLEL_REQUESTS;
+}
+
+/*device i is served by worker i % workerCount on its own connection. workers[0] runs on the calling thread, the others on their
+threads, and the call returns once they are all done, so the device list and the transport are not touched concurrently with other API calls*/
+static void DoWorkInParallel(HTTPTRANSPORT_HANDLE_DATA* handleData, size_t deviceListSize, size_t workerCount)
+{
+    HTTP_WORKER* workers = handleData->workers;
+    bool isLocked = (Lock(handleData->workersLock) == LOCK_OK);
+    size_t i;
+
+    if (!isLocked)
+    {
+        LogError("failed to lock for DoWorkInParallel, the devices are served on the calling thread");
+    }
+    for (i = 0; i < workerCount; i++)
+    {
+        workers[i].firstDevice = i;
+        workers[i].deviceStride = workerCount;
+        workers[i].deviceCount = deviceListSize;
+        if (isLocked && workers[i].isThreadRunning)
+        {
+            workers[i].hasJob = true;
+            handleData->busyWorkers++;
+            (void)Condition_Post(workers[i].jobAvailable);
+        }
+    }
+    if (isLocked)
+    {
+        (void)Unlock(handleData->workersLock);
+    }
+
+    for (i = 0; i < workerCount; i++)
+    {
+        if (!isLocked || !workers[i].isThreadRunning)
+        {
+            DoWorkForWorkerDevices(&workers[i]);
+        }
+    }
+
+    if (isLocked)
+    {
+        while (Lock(handleData->workersLock) != LOCK_OK)
+        {
+            /*the workers are still serving devices, returning now would let other API calls run concurrently with them*/
+            LogError("failed to relock for DoWorkInParallel");
+            ThreadAPI_Sleep(1);
+        }
+        while (handleData->busyWorkers > 0)
+        {
+            if (Condition_Wait(handleData->workersDone, handleData->workersLock, 0) == COND_ERROR)
+            {
+                LogError("failed waiting for the HTTP workers");
+            }
+        }
+        (void)Unlock(handleData->workersLock);
+    }
+}
+
 static void IoTHubTransportHttp_DoWork(TRANSPORT_LL_HANDLE handle)
 {
     /*Codes_SRS_TRANSPORTMULTITHTTP_17_049: [ If handle is NULL, then IoTHubTransportHttp_DoWork shall do nothing. ]*/
     if (handle != NULL)
     {
         HTTPTRANSPORT_HANDLE_DATA* handleData = (HTTPTRANSPORT_HANDLE_DATA*)handle;
-        IOTHUB_DEVICE_HANDLE* listItem;
         size_t deviceListSize = VECTOR_size(handleData->perDeviceList);
-        /*Codes_SRS_TRANSPORTMULTITHTTP_17_052: [ IoTHubTransportHttp_DoWork shall perform a round-robin loop through every deviceHandle in the transport device list. ]*/
-        /*Codes_SRS_TRANSPORTMULTITHTTP_17_050: [ IoTHubTransportHttp_DoWork shall call loop through the device list. ] */
-        /*Codes_SRS_TRANSPORTMULTITHTTP_17_051: [ IF the list is empty, then IoTHubTransportHttp_DoWork shall do nothing. ]*/
-        for (size_t i = 0; i < deviceListSize; i++)
+        size_t workerCount = (deviceListSize < handleData->maxParallelRequests) ? deviceListSize : handleData->maxParallelRequests;
+        if ((workerCount > 1) && has_enough_pending_devices_for_parallel_requests(handleData, deviceListSize))
         {
-            listItem = (IOTHUB_DEVICE_HANDLE *)VECTOR_element(handleData->perDeviceList, i);
-            HTTPTRANSPORT_PERDEVICE_DATA* perDeviceItem = *(HTTPTRANSPORT_PERDEVICE_DATA**)(listItem);
-            DoEvent(handleData, perDeviceItem);
-            DoMessages(handleData, perDeviceItem);
+            DoWorkInParallel(handleData, deviceListSize, workerCount);
+        }
+        else
+        {
+            IOTHUB_DEVICE_HANDLE* listItem;
+            /*Codes_SRS_TRANSPORTMULTITHTTP_17_052: [ IoTHubTransportHttp_DoWork shall perform a round-robin loop through every deviceHandle in the transport device list. ]*/
+            /*Codes_SRS_TRANSPORTMULTITHTTP_17_050: [ IoTHubTransportHttp_DoWork shall call loop through the device list. ] */
+            /*Codes_SRS_TRANSPORTMULTITHTTP_17_051: [ IF the list is empty, then IoTHubTransportHttp_DoWork shall do nothing. ]*/
+            for (size_t i = 0; i < deviceListSize; i++)
+            {
+                listItem = (IOTHUB_DEVICE_HANDLE *)VECTOR_element(handleData->perDeviceList, i);
+                HTTPTRANSPORT_PERDEVICE_DATA* perDeviceItem = *(HTTPTRANSPORT_PERDEVICE_DATA**)(listItem);
+                DoEvent(handleData, perDeviceItem);
+                DoMessages(handleData, perDeviceItem);
+            }
         }
     }
     else
@@ -2441,16 +2610,27 @@ static IOTHUB_CLIENT_RESULT IoTHubTransportHttp_SetOption(TRANSPORT_LL_HANDLE ha
             handleData->getMinimumPollingTime = *(unsigned int*)value;
             result = IOTHUB_CLIENT_OK;
         }
+        else if (strcmp(OPTION_HTTP_MAX_PARALLEL_REQUESTS, option) == 0)
+        {
+            result = set_max_parallel_requests(handleData, *(size_t*)value);
+        }
         else
         {
             /*Codes_SRS_TRANSPORTMULTITHTTP_17_126: [ "TrustedCerts"] */
             /*Codes_SRS_TRANSPORTMULTITHTTP_17_127: [ NULL shall be allowed. ]*/
             /*Codes_SRS_TRANSPORTMULTITHTTP_17_129: [ This option shall passed down to the lower layer by calling HTTPAPIEX_SetOption. ]*/
             /*Codes_SRS_TRANSPORTMULTITHTTP_17_118: [Otherwise, IoTHubTransport_Http shall call HTTPAPIEX_SetOption with the same parameters and return the translated code.] */
+            size_t i;
             HTTPAPIEX_RESULT HTTPAPIEX_result = HTTPAPIEX_SetOption(handleData->httpApiExHandle, option, value);
+            /*the connections of parallel requests get the same options*/
+            for (i = 1; (HTTPAPIEX_result == HTTPAPIEX_OK) && (i < handleData->maxParallelRequests); i++)
+            {
+                HTTPAPIEX_result = HTTPAPIEX_SetOption(handleData->workers[i].httpApiExHandle, option, value);
+            }
             /*Codes_SRS_TRANSPORTMULTITHTTP_17_119: [The following table translates HTTPAPIEX return codes to IOTHUB_CLIENT_RESULT return codes:] */
             if (HTTPAPIEX_result == HTTPAPIEX_OK)
             {
+                handleData->wereOptionsPassedDown = true;
                 result = IOTHUB_CLIENT_OK;
             }
             else if (HTTPAPIEX_result == HTTPAPIEX_INVALID_ARG)
@@ -2570,7 +2750,8 @@ static TRANSPORT_PROVIDER thisTransportProvider =
     IotHubTransportHttp_Unsubscribe_InputQueue,     /*pfIoTHubTransport_Unsubscribe_InputQueue IoTHubTransport_Unsubscribe_InputQueue; */
     IoTHubTransportHttp_SetCallbackContext,         /*pfIoTHubTransport_SetTransportCallbacks IoTHubTransport_SetTransportCallbacks; */
     IoTHubTransportHttp_GetTwinAsync,               /*pfIoTHubTransport_GetTwinAsync IoTHubTransport_GetTwinAsync;*/
-    IoTHubTransportHttp_GetSupportedPlatformInfo      /*pfIoTHubTransport_GetSupportedPlatformInfo IoTHubTransport_GetSupportedPlatformInfo;*/
+    IoTHubTransportHttp_GetSupportedPlatformInfo,   /*pfIoTHubTransport_GetSupportedPlatformInfo IoTHubTransport_GetSupportedPlatformInfo;*/
+    NULL                                            /*pfIoTHubTransport_OnEventQueued IoTHubTransport_OnEventQueued;*/
 };
 
 const TRANSPORT_PROVIDER* HTTP_Protocol(void)
@@ -22,6 +22,8 @@ static const char* SAVED_OPTION_MAX_ENQUEUE_TIME_SECS = "SAVED_OPTION_MAX_ENQUEU
 static const char* SAVED_OPTION_MAX_PROCESSING_TIME_SECS = "SAVED_OPTION_MAX_PROCESSING_TIME_SECS";
 
 
+typedef struct MESSAGE_QUEUE_ITEM_TAG MESSAGE_QUEUE_ITEM;
+
 struct MESSAGE_QUEUE_TAG
 {
     size_t max_message_enqueued_time_secs;
@@ -33,9 +35,14 @@ struct MESSAGE_QUEUE_TAG
 
     SINGLYLINKEDLIST_HANDLE pending;
     SINGLYLINKEDLIST_HANDLE in_progress;
+
+    // All items, pending or in progress, ordered by enqueue_time. As max_message_enqueued_time_secs is the same
+    // for every item this is also the order of their enqueue deadlines, so expired items are always at the oldest end.
+    MESSAGE_QUEUE_ITEM* oldest;
+    MESSAGE_QUEUE_ITEM* newest;
 };
 
-typedef struct MESSAGE_QUEUE_ITEM_TAG
+struct MESSAGE_QUEUE_ITEM_TAG
 {
     MQ_MESSAGE_HANDLE message;
     MESSAGE_PROCESSING_COMPLETED_CALLBACK on_message_processing_completed_callback;
@@ -43,12 +50,97 @@ typedef struct MESSAGE_QUEUE_ITEM_TAG
     time_t enqueue_time;
     time_t processing_start_time;
     size_t number_of_attempts;
-} MESSAGE_QUEUE_ITEM;
+
+    // List (pending or in_progress) and node currently holding the item.
+    SINGLYLINKEDLIST_HANDLE list;
+    LIST_ITEM_HANDLE list_item;
+
+    MESSAGE_QUEUE_ITEM* older;
+    MESSAGE_QUEUE_ITEM* newer;
+};
 
 
 
 // ---------- Helper Functions ---------- //
 
+static void link_by_enqueue_time(MESSAGE_QUEUE_HANDLE message_queue, MESSAGE_QUEUE_ITEM* mq_item)
+{
+    MESSAGE_QUEUE_ITEM* older = message_queue->newest;
+
+    // Items are normally added in enqueue_time order; only walk back if the clock moved backwards.
+    while (older != NULL && older->enqueue_time > mq_item->enqueue_time)
+    {
+        older = older->older;
+    }
+
+    mq_item->older = older;
+    mq_item->newer = (older == NULL ? message_queue->oldest : older->newer);
+
+    if (older == NULL)
+    {
+        message_queue->oldest = mq_item;
+    }
+    else
+    {
+        older->newer = mq_item;
+    }
+
+    if (mq_item->newer == NULL)
+    {
+        message_queue->newest = mq_item;
+    }
+    else
+    {
+        mq_item->newer->older = mq_item;
+    }
+}
+
+// Does nothing for an item that is already unlinked, e.g. one left on pending after singlylinkedlist_remove failed.
+static void unlink_by_enqueue_time(MESSAGE_QUEUE_HANDLE message_queue, MESSAGE_QUEUE_ITEM* mq_item)
+{
+    if (message_queue->oldest == mq_item || mq_item->older != NULL || mq_item->newer != NULL)
+    {
+        if (mq_item->older == NULL)
+        {
+            message_queue->oldest = mq_item->newer;
+        }
+        else
+        {
+            mq_item->older->newer = mq_item->newer;
+        }
+
+        if (mq_item->newer == NULL)
+        {
+            message_queue->newest = mq_item->older;
+        }
+        else
+        {
+            mq_item->newer->older = mq_item->older;
+        }
+
+        mq_item->older = NULL;
+        mq_item->newer = NULL;
+    }
+}
+
+static int add_item_to_list(SINGLYLINKEDLIST_HANDLE list, MESSAGE_QUEUE_ITEM* mq_item)
+{
+    int result;
+
+    if ((mq_item->list_item = singlylinkedlist_add(list, (const void*)mq_item)) == NULL)
+    {
+        mq_item->list = NULL;
+        result = MU_FAILURE;
+    }
+    else
+    {
+        mq_item->list = list;
+        result = RESULT_OK;
+    }
+
+    return result;
+}
+
 static bool find_item_by_message_ptr(LIST_ITEM_HANDLE list_item, const void* match_context)
 {
     bool result;
@@ -101,7 +193,7 @@ static int retry_sending_message(MESSAGE_QUEUE_HANDLE message_queue, LIST_ITEM_H
         LogError("Failed removing message from in-progress list");
         result = MU_FAILURE;
     }
-    else if (singlylinkedlist_add(message_queue->pending, (const void*)mq_item) == NULL)
+    else if (add_item_to_list(message_queue->pending, mq_item) != RESULT_OK)
     {
         LogError("Failed moving message back to pending list");
         result = MU_FAILURE;
@@ -114,10 +206,12 @@ static int retry_sending_message(MESSAGE_QUEUE_HANDLE message_queue, LIST_ITEM_H
     return result;
 }
 
-static void dequeue_message_and_fire_callback(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE list_item, MESSAGE_QUEUE_RESULT result, void* reason)
+static void dequeue_message_and_fire_callback(MESSAGE_QUEUE_HANDLE message_queue, SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE list_item, MESSAGE_QUEUE_RESULT result, void* reason)
 {
     MESSAGE_QUEUE_ITEM* mq_item = (MESSAGE_QUEUE_ITEM*)singlylinkedlist_item_get_value(list_item);
 
+    unlink_by_enqueue_time(message_queue, mq_item);
+
     // Codes_SRS_MESSAGE_QUEUE_09_045: [If `message` is present in `message_queue->in_progress`, it shall be removed]
     if (singlylinkedlist_remove(list, list_item))
     {
@@ -155,7 +249,7 @@ static void on_process_message_completed_callback(MESSAGE_QUEUE_HANDLE message_q
             // Codes_SRS_MESSAGE_QUEUE_09_048: [If `result` is MESSAGE_QUEUE_RETRYABLE_ERROR and `mq_item->number_of_attempts` is greater than `message_queue->max_retry_count`, result shall be changed to MESSAGE_QUEUE_ERROR]
             if (!should_retry_sending(message_queue, mq_item, result) || retry_sending_message(message_queue, list_item) != RESULT_OK)
             {
-                dequeue_message_and_fire_callback(message_queue->in_progress, list_item, result, reason);
+                dequeue_message_and_fire_callback(message_queue, message_queue->in_progress, list_item, result, reason);
             }
         }
     }
@@ -174,49 +268,14 @@ static void process_timeouts(MESSAGE_QUEUE_HANDLE message_queue)
         // Codes_SRS_MESSAGE_QUEUE_09_035: [If `message_queue->max_message_enqueued_time_secs` is greater than zero, `message_queue->in_progress` and `message_queue->pending` items shall be checked for timeout]
         if (message_queue->max_message_enqueued_time_secs > 0)
         {
-            LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(message_queue->pending);
-
-            while (list_item != NULL)
-            {
-                LIST_ITEM_HANDLE current_list_item = list_item;
-                MESSAGE_QUEUE_ITEM* mq_item = (MESSAGE_QUEUE_ITEM*)singlylinkedlist_item_get_value(current_list_item);
-
-                list_item = singlylinkedlist_get_next_item(list_item);
-
-                if (mq_item == NULL)
-                {
-                    LogError("failed processing timeouts (unexpected NULL pointer to MESSAGE_QUEUE_ITEM)");
-                }
-                else if (get_difftime(current_time, mq_item->enqueue_time) >= message_queue->max_message_enqueued_time_secs)
-                {
-                    // Codes_SRS_MESSAGE_QUEUE_09_036: [If any items are in `message_queue` lists for `message_queue->max_message_enqueued_time_secs` or more, they shall be removed and `message_queue->on_message_processing_completed_callback` invoked with MESSAGE_QUEUE_TIMEOUT]
-                    dequeue_message_and_fire_callback(message_queue->pending, current_list_item, MESSAGE_QUEUE_TIMEOUT, NULL);
-                }
-                else
-                {
-                    // The pending list order is already based on enqueue time, so if one message is not expired, later ones won't be either.
-                    break;
-                }
-            }
+            MESSAGE_QUEUE_ITEM* mq_item;
 
-            list_item = singlylinkedlist_get_head_item(message_queue->in_progress);
-
-            while (list_item != NULL)
+            // Only expired items and the first one still within its deadline are looked at, whatever the queue depth.
+            while ((mq_item = message_queue->oldest) != NULL &&
+                get_difftime(current_time, mq_item->enqueue_time) >= message_queue->max_message_enqueued_time_secs)
             {
-                LIST_ITEM_HANDLE current_list_item = list_item;
-                MESSAGE_QUEUE_ITEM* mq_item = (MESSAGE_QUEUE_ITEM*)singlylinkedlist_item_get_value(current_list_item);
-
-                list_item = singlylinkedlist_get_next_item(list_item);
-
-                if (mq_item == NULL)
-                {
-                    LogError("failed processing timeouts (unexpected NULL pointer to MESSAGE_QUEUE_ITEM)");
-                }
-                else if (get_difftime(current_time, mq_item->enqueue_time) >= message_queue->max_message_enqueued_time_secs)
-                {
-                    // Codes_SRS_MESSAGE_QUEUE_09_038: [If any items are in `message_queue->in_progress` for `message_queue->max_message_processing_time_secs` or more, they shall be removed and `message_queue->on_message_processing_completed_callback` invoked with MESSAGE_QUEUE_TIMEOUT]
-                    dequeue_message_and_fire_callback(message_queue->in_progress, current_list_item, MESSAGE_QUEUE_TIMEOUT, NULL);
-                }
+                // Codes_SRS_MESSAGE_QUEUE_09_036: [If any items are in `message_queue` lists for `message_queue->max_message_enqueued_time_secs` or more, they shall be removed and `message_queue->on_message_processing_completed_callback` invoked with MESSAGE_QUEUE_TIMEOUT]
+                dequeue_message_and_fire_callback(message_queue, mq_item->list, mq_item->list_item, MESSAGE_QUEUE_TIMEOUT, NULL);
             }
         }
 
@@ -238,7 +297,7 @@ static void process_timeouts(MESSAGE_QUEUE_HANDLE message_queue)
                 }
                 else if (get_difftime(current_time, mq_item->processing_start_time) >= message_queue->max_message_processing_time_secs)
                 {
-                    dequeue_message_and_fire_callback(message_queue->in_progress, current_list_item, MESSAGE_QUEUE_TIMEOUT, NULL);
+                    dequeue_message_and_fire_callback(message_queue, message_queue->in_progress, current_list_item, MESSAGE_QUEUE_TIMEOUT, NULL);
                 }
                 else
                 {
@@ -274,6 +333,7 @@ static void process_pending_messages(MESSAGE_QUEUE_HANDLE message_queue)
             }
 
             // Not freeing since this would cause a memory A/V on the next call.
+            unlink_by_enqueue_time(message_queue, mq_item);
 
             break; // Trying to avoid an infinite loop
         }
@@ -289,10 +349,11 @@ static void process_pending_messages(MESSAGE_QUEUE_HANDLE message_queue)
                 mq_item->on_message_processing_completed_callback(mq_item->message, MESSAGE_QUEUE_ERROR, NULL, mq_item->user_context);
             }
 
+            unlink_by_enqueue_time(message_queue, mq_item);
             free(mq_item);
         }
         // Codes_SRS_MESSAGE_QUEUE_09_039: [Each `mq_item` in `message_queue->pending` shall be moved to `message_queue->in_progress`]
-        else if (singlylinkedlist_add(message_queue->in_progress, (const void*)mq_item) == NULL)
+        else if (add_item_to_list(message_queue->in_progress, mq_item) != RESULT_OK)
         {
             LogError("failed moving message to in-progress list (%p)", mq_item->message);
 
@@ -302,6 +363,7 @@ static void process_pending_messages(MESSAGE_QUEUE_HANDLE message_queue)
                 mq_item->on_message_processing_completed_callback(mq_item->message, MESSAGE_QUEUE_ERROR, NULL, mq_item->user_context);
             }
 
+            unlink_by_enqueue_time(message_queue, mq_item);
             free(mq_item);
         }
         else
@@ -379,19 +441,19 @@ void message_queue_remove_all(MESSAGE_QUEUE_HANDLE message_queue)
         {
             // Codes_SRS_MESSAGE_QUEUE_09_028: [`message_queue->on_message_processing_completed_callback` shall be invoked with MESSAGE_QUEUE_CANCELLED for each `mq_item` removed]
             // Codes_SRS_MESSAGE_QUEUE_09_029: [Each `mq_item` shall be freed]
-            dequeue_message_and_fire_callback(message_queue->in_progress, list_item, MESSAGE_QUEUE_CANCELLED, NULL);
+            dequeue_message_and_fire_callback(message_queue, message_queue->in_progress, list_item, MESSAGE_QUEUE_CANCELLED, NULL);
         }
 
         while ((list_item = singlylinkedlist_get_head_item(message_queue->pending)) != NULL)
         {
             // Codes_SRS_MESSAGE_QUEUE_09_028: [`message_queue->on_message_processing_completed_callback` shall be invoked with MESSAGE_QUEUE_CANCELLED for each `mq_item` removed]
             // Codes_SRS_MESSAGE_QUEUE_09_029: [Each `mq_item` shall be freed]
-            dequeue_message_and_fire_callback(message_queue->pending, list_item, MESSAGE_QUEUE_CANCELLED, NULL);
+            dequeue_message_and_fire_callback(message_queue, message_queue->pending, list_item, MESSAGE_QUEUE_CANCELLED, NULL);
         }
     }
 }
 
-static int move_messages_between_lists(SINGLYLINKEDLIST_HANDLE from_list, SINGLYLINKEDLIST_HANDLE to_list)
+static int move_messages_between_lists(MESSAGE_QUEUE_HANDLE message_queue, SINGLYLINKEDLIST_HANDLE from_list, SINGLYLINKEDLIST_HANDLE to_list)
 {
     int result;
     LIST_ITEM_HANDLE list_item;
@@ -414,10 +476,11 @@ static int move_messages_between_lists(SINGLYLINKEDLIST_HANDLE from_list, SINGLY
             result = MU_FAILURE;
             break;
         }
-        else if (singlylinkedlist_add(to_list, (const void*)mq_item) == NULL)
+        else if (add_item_to_list(to_list, mq_item) != RESULT_OK)
         {
             LogError("failed moving message to list");
             fire_message_callback(mq_item, MESSAGE_QUEUE_CANCELLED, NULL);
+            unlink_by_enqueue_time(message_queue, mq_item);
             free(mq_item);
             result = MU_FAILURE;
             break;
@@ -440,12 +503,12 @@ int message_queue_move_all_back_to_pending(MESSAGE_QUEUE_HANDLE message_queue)
     else
     {
         // Codes_SRS_MESSAGE_QUEUE_21_070: [The message_queue_move_all_back_to_pending shall add all in_progress message in front of the pending messages.]
-        if (move_messages_between_lists(message_queue->pending, message_queue->in_progress) != 0)
+        if (move_messages_between_lists(message_queue, message_queue->pending, message_queue->in_progress) != 0)
         {
             LogError("failed moving pending messages at the end of in-progress");
             result = MU_FAILURE;
         }
-        else if (move_messages_between_lists(message_queue->in_progress, message_queue->pending) != 0)
+        else if (move_messages_between_lists(message_queue, message_queue->in_progress, message_queue->pending) != 0)
         {
             LogError("failed moving all in-progress messages back to pending");
             result = MU_FAILURE;
@@ -584,7 +647,7 @@ int message_queue_add(MESSAGE_QUEUE_HANDLE message_queue, MQ_MESSAGE_HANDLE mess
                 result = MU_FAILURE;
             }
             // Codes_SRS_MESSAGE_QUEUE_09_021: [`mq_item` shall be added to `message_queue->pending` list]
-            else if (singlylinkedlist_add(message_queue->pending, (const void*)mq_item) == NULL)
+            else if (add_item_to_list(message_queue->pending, mq_item) != RESULT_OK)
             {
                 // Codes_SRS_MESSAGE_QUEUE_09_022: [`mq_item` fails to be added to `message_queue->pending`, message_queue_add shall fail and return non-zero]
                 LogError("failed enqueing message");
@@ -599,6 +662,7 @@ int message_queue_add(MESSAGE_QUEUE_HANDLE message_queue, MQ_MESSAGE_HANDLE mess
                 mq_item->on_message_processing_completed_callback = on_message_processing_completed_callback;
                 mq_item->user_context = user_context;
                 mq_item->processing_start_time = INDEFINITE_TIME;
+                link_by_enqueue_time(message_queue, mq_item);
                 // Codes_SRS_MESSAGE_QUEUE_09_025: [If no failures occur, message_queue_add shall return 0]
                 result = RESULT_OK;
             }
@@ -0,0 +1,1133 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#if defined(_WIN32)
+#include <io.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "azure_macro_utils/macro_utils.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/map.h"
+
+#include "iothub_message.h"
+#include "internal/persistent_queue.h"
+
+#define RECORD_FORMAT_VERSION 1
+#define RECORD_HEADER_SIZE 8 /*payload length and payload checksum*/
+#define RECORD_FLAG_STRING_CONTENT 0x01
+#define RECORD_FLAG_SECURITY_MESSAGE 0x02
+#define NULL_STRING_LENGTH UINT32_MAX
+#define CHECKPOINT_SIZE 20 /*segment, offset and checksum*/
+#define PENDING_ACKS_INITIAL_CAPACITY 16
+
+static const char* const CHECKPOINT_SUFFIX = ".checkpoint";
+static const char* const CHECKPOINT_TEMP_SUFFIX = ".checkpoint.tmp";
+static const char* const SEGMENT_SUFFIX = ".log";
+#define SEGMENT_NAME_EXTRA_LENGTH (1 + 16 + 4) /*".", 16 hexadecimal digits, ".log"*/
+
+typedef const char*(*MESSAGE_STRING_GETTER)(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle);
+typedef IOTHUB_MESSAGE_RESULT(*MESSAGE_STRING_SETTER)(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const char* value);
+
+typedef struct MESSAGE_STRING_PROPERTY_TAG
+{
+    MESSAGE_STRING_GETTER get;
+    MESSAGE_STRING_SETTER set;
+} MESSAGE_STRING_PROPERTY;
+
+/*system properties stored with each message, in record order. Appending to this table requires a new RECORD_FORMAT_VERSION*/
+static const MESSAGE_STRING_PROPERTY MESSAGE_STRING_PROPERTIES[] =
+{
+    { IoTHubMessage_GetMessageId, IoTHubMessage_SetMessageId },
+    { IoTHubMessage_GetCorrelationId, IoTHubMessage_SetCorrelationId },
+    { IoTHubMessage_GetContentTypeSystemProperty, IoTHubMessage_SetContentTypeSystemProperty },
+    { IoTHubMessage_GetContentEncodingSystemProperty, IoTHubMessage_SetContentEncodingSystemProperty },
+    { IoTHubMessage_GetOutputName, IoTHubMessage_SetOutputName },
+    { IoTHubMessage_GetMessageCreationTimeUtcSystemProperty, IoTHubMessage_SetMessageCreationTimeUtcSystemProperty },
+    { IoTHubMessage_GetMessageUserIdSystemProperty, IoTHubMessage_SetMessageUserIdSystemProperty }
+};
+#define MESSAGE_STRING_PROPERTY_COUNT (sizeof(MESSAGE_STRING_PROPERTIES) / sizeof(MESSAGE_STRING_PROPERTIES[0]))
+
+typedef struct PENDING_ACK_TAG
+{
+    uint64_t record_id;
+    uint64_t segment; /*start of the segment holding the record*/
+    uint64_t next_offset; /*position right after the record*/
+    bool acked;
+} PENDING_ACK;
+
+/*positions are offsets in the log as a whole; a segment is identified by the offset of its first byte*/
+typedef struct PERSISTENT_QUEUE_TAG
+{
+    char* segment_name; /*built by get_segment_name*/
+    size_t path_length;
+    char* checkpoint_name;
+    char* checkpoint_temp_name;
+    char* directory_name; /*directory holding the segments and the checkpoint*/
+    size_t segment_size;
+
+    uint64_t checkpoint_segment; /*first segment not deleted yet*/
+    uint64_t checkpoint_offset; /*last checkpoint written*/
+    uint64_t ack_segment; /*position of the oldest record not acknowledged yet*/
+    uint64_t ack_offset;
+
+    FILE* read_file;
+    uint64_t read_segment;
+    uint64_t read_offset;
+
+    FILE* write_file;
+    uint64_t write_segment;
+    uint64_t write_offset;
+    uint64_t flushed_offset; /*appends before this position have been handed to the file system*/
+    uint64_t synced_offset; /*appends before this position are on disk*/
+    bool directory_changed; /*a segment may have been created since the directory was last synced*/
+
+    PENDING_ACK* pending_acks; /*ring of the records read and not acknowledged yet, in read order*/
+    size_t pending_acks_capacity;
+    size_t pending_acks_head;
+    size_t pending_acks_count;
+} PERSISTENT_QUEUE;
+
+typedef struct RECORD_WRITER_TAG
+{
+    unsigned char* buffer; /*NULL when only measuring*/
+    size_t position;
+} RECORD_WRITER;
+
+typedef struct RECORD_READER_TAG
+{
+    const unsigned char* buffer;
+    size_t size;
+    size_t position;
+    bool failed;
+} RECORD_READER;
+
+typedef struct MESSAGE_FIELDS_TAG
+{
+    unsigned char flags;
+    const unsigned char* content;
+    size_t content_size;
+    const char* strings[MESSAGE_STRING_PROPERTY_COUNT];
+    const char*const* keys;
+    const char*const* values;
+    size_t property_count;
+} MESSAGE_FIELDS;
+
+static uint32_t compute_checksum(const unsigned char* data, size_t size)
+{
+    /*FNV-1a*/
+    uint32_t result = 2166136261u;
+    size_t i;
+    for (i = 0; i < size; i++)
+    {
+        result ^= data[i];
+        result *= 16777619u;
+    }
+    return result;
+}
+
+static void put_uint32(unsigned char* destination, uint32_t value)
+{
+    destination[0] = (unsigned char)(value & 0xFF);
+    destination[1] = (unsigned char)((value >> 8) & 0xFF);
+    destination[2] = (unsigned char)((value >> 16) & 0xFF);
+    destination[3] = (unsigned char)((value >> 24) & 0xFF);
+}
+
+static uint32_t get_uint32(const unsigned char* source)
+{
+    return (uint32_t)source[0] | ((uint32_t)source[1] << 8) | ((uint32_t)source[2] << 16) | ((uint32_t)source[3] << 24);
+}
+
+static void put_uint64(unsigned char* destination, uint64_t value)
+{
+    put_uint32(destination, (uint32_t)(value & 0xFFFFFFFF));
+    put_uint32(destination + 4, (uint32_t)(value >> 32));
+}
+
+static uint64_t get_uint64(const unsigned char* source)
+{
+    return (uint64_t)get_uint32(source) | ((uint64_t)get_uint32(source + 4) << 32);
+}
+
+static const char* get_segment_name(PERSISTENT_QUEUE* persistent_queue, uint64_t segment)
+{
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    char* digits = persistent_queue->segment_name + persistent_queue->path_length + 1;
+    int i;
+    for (i = 15; i >= 0; i--)
+    {
+        digits[i] = HEX_DIGITS[segment & 0xF];
+        segment >>= 4;
+    }
+    return persistent_queue->segment_name;
+}
+
+/*returns 0 and sets size if the segment file exists*/
+static int get_segment_file_size(PERSISTENT_QUEUE* persistent_queue, uint64_t segment, uint64_t* size)
+{
+    int result;
+    FILE* file = fopen(get_segment_name(persistent_queue, segment), "rb");
+    if (file == NULL)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        long end;
+        if ((fseek(file, 0, SEEK_END) != 0) || ((end = ftell(file)) < 0))
+        {
+            LogError("unable to get the size of %s", persistent_queue->segment_name);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            *size = (uint64_t)end;
+            result = 0;
+        }
+        (void)fclose(file);
+    }
+    return result;
+}
+
+static char* create_file_name(const char* path, const char* suffix)
+{
+    size_t path_length = strlen(path);
+    size_t suffix_length = strlen(suffix);
+    char* result = (char*)malloc(path_length + suffix_length + 1);
+    if (result == NULL)
+    {
+        LogError("unable to allocate a file name");
+    }
+    else
+    {
+        (void)memcpy(result, path, path_length);
+        (void)memcpy(result + path_length, suffix, suffix_length + 1);
+    }
+    return result;
+}
+
+static char* create_directory_name(const char* path)
+{
+    char* result;
+    const char* last_separator = strrchr(path, '/');
+#ifdef _WIN32
+    const char* last_backslash = strrchr(path, '\\');
+    if ((last_backslash != NULL) && ((last_separator == NULL) || (last_backslash > last_separator)))
+    {
+        last_separator = last_backslash;
+    }
+#endif
+    if (last_separator == NULL)
+    {
+        path = ".";
+        last_separator = path + 1;
+    }
+    else if (last_separator == path)
+    {
+        last_separator++; /*root directory*/
+    }
+
+    if ((result = (char*)malloc((size_t)(last_separator - path) + 1)) == NULL)
+    {
+        LogError("unable to allocate the directory name");
+    }
+    else
+    {
+        (void)memcpy(result, path, (size_t)(last_separator - path));
+        result[last_separator - path] = '\0';
+    }
+    return result;
+}
+
+/*fflush only hands data to the operating system, it survives a power failure once it has been synced to the disk. Platforms
+without _commit or fsync (mbed, TI-RTOS) only get the fflush that callers do before syncing*/
+static int sync_file(FILE* file)
+{
+    int result;
+#if defined(_WIN32)
+    if (_commit(_fileno(file)) != 0)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+#elif defined(__unix__) || defined(__APPLE__)
+    if (fsync(fileno(file)) != 0)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+#else
+    (void)file;
+    result = 0;
+#endif
+    return result;
+}
+
+/*makes the creation and renaming of files in the directory durable*/
+static int sync_directory(PERSISTENT_QUEUE* persistent_queue)
+{
+    int result;
+#if defined(__unix__) || defined(__APPLE__)
+    int directory = open(persistent_queue->directory_name, O_RDONLY);
+    if (directory < 0)
+    {
+        LogError("unable to open the directory %s", persistent_queue->directory_name);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        if (fsync(directory) != 0)
+        {
+            LogError("unable to sync the directory %s", persistent_queue->directory_name);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = 0;
+        }
+        (void)close(directory);
+    }
+#else
+    /*NTFS journals its metadata and a directory cannot be flushed through the CRT, other platforms have no way to do it*/
+    (void)persistent_queue;
+    result = 0;
+#endif
+    return result;
+}
+
+static int read_checkpoint_file(const char* name, uint64_t* segment, uint64_t* offset)
+{
+    int result;
+    FILE* file = fopen(name, "rb");
+    if (file == NULL)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        unsigned char checkpoint[CHECKPOINT_SIZE];
+        if ((fread(checkpoint, 1, CHECKPOINT_SIZE, file) != CHECKPOINT_SIZE) ||
+            (get_uint32(checkpoint + 16) != compute_checksum(checkpoint, 16)))
+        {
+            LogError("ignoring damaged checkpoint %s", name);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            *segment = get_uint64(checkpoint);
+            *offset = get_uint64(checkpoint + 8);
+            result = 0;
+        }
+        (void)fclose(file);
+    }
+    return result;
+}
+
+/*the checkpoint is written aside and then renamed over the previous one. If a crash happens in between, the temporary one is used*/
+static int write_checkpoint(PERSISTENT_QUEUE* persistent_queue, uint64_t segment, uint64_t offset)
+{
+    int result;
+    unsigned char checkpoint[CHECKPOINT_SIZE];
+    FILE* file;
+    put_uint64(checkpoint, segment);
+    put_uint64(checkpoint + 8, offset);
+    put_uint32(checkpoint + 16, compute_checksum(checkpoint, 16));
+
+    if ((file = fopen(persistent_queue->checkpoint_temp_name, "wb")) == NULL)
+    {
+        LogError("unable to create %s", persistent_queue->checkpoint_temp_name);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        bool written = (fwrite(checkpoint, 1, CHECKPOINT_SIZE, file) == CHECKPOINT_SIZE) && (fflush(file) == 0) && (sync_file(file) == 0);
+        if ((fclose(file) != 0) || !written)
+        {
+            LogError("unable to write %s", persistent_queue->checkpoint_temp_name);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            (void)remove(persistent_queue->checkpoint_name);
+            if (rename(persistent_queue->checkpoint_temp_name, persistent_queue->checkpoint_name) != 0)
+            {
+                LogError("unable to rename %s", persistent_queue->checkpoint_temp_name);
+                result = MU_FAILURE;
+            }
+            else if (sync_directory(persistent_queue) != 0)
+            {
+                result = MU_FAILURE;
+            }
+            else
+            {
+                persistent_queue->directory_changed = false;
+                result = 0;
+            }
+        }
+    }
+    return result;
+}
+
+static void write_uint32(RECORD_WRITER* writer, uint32_t value)
+{
+    if (writer->buffer != NULL)
+    {
+        put_uint32(writer->buffer + writer->position, value);
+    }
+    writer->position += 4;
+}
+
+static void write_bytes(RECORD_WRITER* writer, const unsigned char* data, size_t size)
+{
+    write_uint32(writer, (uint32_t)size);
+    if ((writer->buffer != NULL) && (size > 0))
+    {
+        (void)memcpy(writer->buffer + writer->position, data, size);
+    }
+    writer->position += size;
+}
+
+/*strings are stored with their terminating '\0', so that they can be handed to the message setters straight from the record*/
+static void write_string(RECORD_WRITER* writer, const char* value)
+{
+    if (value == NULL)
+    {
+        write_uint32(writer, NULL_STRING_LENGTH);
+    }
+    else
+    {
+        write_bytes(writer, (const unsigned char*)value, strlen(value) + 1);
+    }
+}
+
+static void write_message_fields(RECORD_WRITER* writer, const MESSAGE_FIELDS* fields)
+{
+    size_t i;
+    if (writer->buffer != NULL)
+    {
+        writer->buffer[writer->position] = RECORD_FORMAT_VERSION;
+        writer->buffer[writer->position + 1] = fields->flags;
+    }
+    writer->position += 2;
+    write_bytes(writer, fields->content, fields->content_size);
+    for (i = 0; i < MESSAGE_STRING_PROPERTY_COUNT; i++)
+    {
+        write_string(writer, fields->strings[i]);
+    }
+    write_uint32(writer, (uint32_t)fields->property_count);
+    for (i = 0; i < fields->property_count; i++)
+    {
+        write_string(writer, fields->keys[i]);
+        write_string(writer, fields->values[i]);
+    }
+}
+
+static int get_message_fields(IOTHUB_MESSAGE_HANDLE message, MESSAGE_FIELDS* fields)
+{
+    int result;
+    MAP_HANDLE properties;
+    IOTHUBMESSAGE_CONTENT_TYPE content_type = IoTHubMessage_GetContentType(message);
+    size_t i;
+
+    fields->flags = IoTHubMessage_IsSecurityMessage(message) ? RECORD_FLAG_SECURITY_MESSAGE : 0;
+    if (content_type == IOTHUBMESSAGE_STRING)
+    {
+        const char* content = IoTHubMessage_GetString(message);
+        fields->flags |= RECORD_FLAG_STRING_CONTENT;
+        fields->content = (const unsigned char*)content;
+        fields->content_size = (content == NULL) ? 0 : strlen(content) + 1;
+        result = (content == NULL) ? MU_FAILURE : 0;
+    }
+    else if ((content_type != IOTHUBMESSAGE_BYTEARRAY) ||
+        (IoTHubMessage_GetByteArray(message, &fields->content, &fields->content_size) != IOTHUB_MESSAGE_OK))
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result != 0)
+    {
+        LogError("unable to get the content of the message");
+    }
+    else if (fields->content_size >= NULL_STRING_LENGTH)
+    {
+        LogError("message content of %lu bytes is too large to be stored", (unsigned long)fields->content_size);
+        result = MU_FAILURE;
+    }
+    else if (((properties = IoTHubMessage_Properties(message)) == NULL) ||
+        (Map_GetInternals(properties, &fields->keys, &fields->values, &fields->property_count) != MAP_OK))
+    {
+        LogError("unable to get the properties of the message");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        for (i = 0; i < MESSAGE_STRING_PROPERTY_COUNT; i++)
+        {
+            fields->strings[i] = MESSAGE_STRING_PROPERTIES[i].get(message);
+        }
+    }
+    return result;
+}
+
+static uint32_t read_uint32(RECORD_READER* reader)
+{
+    uint32_t result;
+    if (reader->failed || (reader->size - reader->position < 4))
+    {
+        reader->failed = true;
+        result = 0;
+    }
+    else
+    {
+        result = get_uint32(reader->buffer + reader->position);
+        reader->position += 4;
+    }
+    return result;
+}
+
+static const unsigned char* read_bytes(RECORD_READER* reader, size_t* size)
+{
+    const unsigned char* result;
+    *size = read_uint32(reader);
+    if (reader->failed || (reader->size - reader->position < *size))
+    {
+        reader->failed = true;
+        result = NULL;
+    }
+    else
+    {
+        result = reader->buffer + reader->position;
+        reader->position += *size;
+    }
+    return result;
+}
+
+static const char* read_string(RECORD_READER* reader)
+{
+    const char* result;
+    size_t size;
+    if (!reader->failed && (reader->size - reader->position >= 4) && (get_uint32(reader->buffer + reader->position) == NULL_STRING_LENGTH))
+    {
+        reader->position += 4;
+        result = NULL;
+    }
+    else if (((result = (const char*)read_bytes(reader, &size)) != NULL) && ((size == 0) || (result[size - 1] != '\0')))
+    {
+        reader->failed = true;
+        result = NULL;
+    }
+    return result;
+}
+
+static IOTHUB_MESSAGE_HANDLE create_message_from_record(const unsigned char* payload, size_t payload_size)
+{
+    IOTHUB_MESSAGE_HANDLE result;
+    RECORD_READER reader;
+    unsigned char flags;
+    const unsigned char* content;
+    size_t content_size;
+
+    reader.buffer = payload;
+    reader.size = payload_size;
+    reader.position = 2;
+    reader.failed = (payload_size < 2) || (payload[0] != RECORD_FORMAT_VERSION);
+    flags = reader.failed ? 0 : payload[1];
+    content = read_bytes(&reader, &content_size);
+
+    if (reader.failed)
+    {
+        LogError("unsupported record");
+        result = NULL;
+    }
+    else if ((flags & RECORD_FLAG_STRING_CONTENT) != 0)
+    {
+        if ((content_size == 0) || (content[content_size - 1] != '\0'))
+        {
+            LogError("malformed string content");
+            result = NULL;
+        }
+        else
+        {
+            result = IoTHubMessage_CreateFromString((const char*)content);
+        }
+    }
+    else
+    {
+        result = IoTHubMessage_CreateFromByteArray(content, content_size);
+    }
+
+    if (result == NULL)
+    {
+        LogError("unable to create a message from a record");
+    }
+    else
+    {
+        size_t i;
+        uint32_t property_count;
+        bool failed = false;
+        for (i = 0; (i < MESSAGE_STRING_PROPERTY_COUNT) && !failed; i++)
+        {
+            const char* value = read_string(&reader);
+            failed = reader.failed || ((value != NULL) && (MESSAGE_STRING_PROPERTIES[i].set(result, value) != IOTHUB_MESSAGE_OK));
+        }
+
+        property_count = failed ? 0 : read_uint32(&reader);
+        for (i = 0; (i < property_count) && !failed; i++)
+        {
+            const char* key = read_string(&reader);
+            const char* value = read_string(&reader);
+            failed = reader.failed || (key == NULL) || (value == NULL) || (IoTHubMessage_SetProperty(result, key, value) != IOTHUB_MESSAGE_OK);
+        }
+
+        if (!failed && ((flags & RECORD_FLAG_SECURITY_MESSAGE) != 0))
+        {
+            failed = (IoTHubMessage_SetAsSecurityMessage(result) != IOTHUB_MESSAGE_OK);
+        }
+
+        if (failed || reader.failed)
+        {
+            LogError("unable to restore the properties of a message from a record");
+            IoTHubMessage_Destroy(result);
+            result = NULL;
+        }
+    }
+    return result;
+}
+
+static int flush_appends(PERSISTENT_QUEUE* persistent_queue)
+{
+    int result;
+    if ((persistent_queue->write_file != NULL) && (fflush(persistent_queue->write_file) != 0))
+    {
+        LogError("unable to flush %s", get_segment_name(persistent_queue, persistent_queue->write_segment));
+        result = MU_FAILURE;
+    }
+    else
+    {
+        persistent_queue->flushed_offset = persistent_queue->write_offset;
+        result = 0;
+    }
+    return result;
+}
+
+/*called at the sync cadence, so that appends cost a write to the file system cache only*/
+static int sync_appends(PERSISTENT_QUEUE* persistent_queue)
+{
+    int result;
+    if (flush_appends(persistent_queue) != 0)
+    {
+        result = MU_FAILURE;
+    }
+    else if ((persistent_queue->write_file != NULL) && (persistent_queue->synced_offset < persistent_queue->write_offset) &&
+        (sync_file(persistent_queue->write_file) != 0))
+    {
+        LogError("unable to sync %s", get_segment_name(persistent_queue, persistent_queue->write_segment));
+        result = MU_FAILURE;
+    }
+    else if (persistent_queue->directory_changed && (sync_directory(persistent_queue) != 0))
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        persistent_queue->synced_offset = persistent_queue->write_offset;
+        persistent_queue->directory_changed = false;
+        result = 0;
+    }
+    return result;
+}
+
+static void close_read_file(PERSISTENT_QUEUE* persistent_queue)
+{
+    if (persistent_queue->read_file != NULL)
+    {
+        (void)fclose(persistent_queue->read_file);
+        persistent_queue->read_file = NULL;
+    }
+}
+
+static int add_pending_ack(PERSISTENT_QUEUE* persistent_queue, uint64_t record_id, uint64_t next_offset)
+{
+    int result;
+    if (persistent_queue->pending_acks_count == persistent_queue->pending_acks_capacity)
+    {
+        size_t new_capacity = (persistent_queue->pending_acks_capacity == 0) ? PENDING_ACKS_INITIAL_CAPACITY : persistent_queue->pending_acks_capacity * 2;
+        PENDING_ACK* new_pending_acks;
+        if ((new_capacity > SIZE_MAX / sizeof(PENDING_ACK)) ||
+            ((new_pending_acks = (PENDING_ACK*)malloc(new_capacity * sizeof(PENDING_ACK))) == NULL))
+        {
+            LogError("unable to grow the list of records waiting for acknowledgement");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            size_t i;
+            for (i = 0; i < persistent_queue->pending_acks_count; i++)
+            {
+                new_pending_acks[i] = persistent_queue->pending_acks[(persistent_queue->pending_acks_head + i) % persistent_queue->pending_acks_capacity];
+            }
+            free(persistent_queue->pending_acks);
+            persistent_queue->pending_acks = new_pending_acks;
+            persistent_queue->pending_acks_capacity = new_capacity;
+            persistent_queue->pending_acks_head = 0;
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        PENDING_ACK* pending_ack = &persistent_queue->pending_acks[(persistent_queue->pending_acks_head + persistent_queue->pending_acks_count) % persistent_queue->pending_acks_capacity];
+        pending_ack->record_id = record_id;
+        pending_ack->segment = persistent_queue->read_segment;
+        pending_ack->next_offset = next_offset;
+        pending_ack->acked = false;
+        persistent_queue->pending_acks_count++;
+    }
+    return result;
+}
+
+/*moves reading to the segment following the current one, which ends size bytes after its start*/
+static void move_to_next_segment(PERSISTENT_QUEUE* persistent_queue, uint64_t size)
+{
+    close_read_file(persistent_queue);
+    persistent_queue->read_segment += size;
+    persistent_queue->read_offset = persistent_queue->read_segment;
+}
+
+/*reads the record at read_offset. Returns 0 and sets *payload to NULL when the current segment has no further record*/
+static int read_record(PERSISTENT_QUEUE* persistent_queue, unsigned char** payload, size_t* payload_size)
+{
+    int result;
+    unsigned char header[RECORD_HEADER_SIZE];
+    size_t header_read;
+    *payload = NULL;
+
+    if (fseek(persistent_queue->read_file, (long)(persistent_queue->read_offset - persistent_queue->read_segment), SEEK_SET) != 0)
+    {
+        LogError("unable to seek in %s", get_segment_name(persistent_queue, persistent_queue->read_segment));
+        result = MU_FAILURE;
+    }
+    else if ((header_read = fread(header, 1, RECORD_HEADER_SIZE, persistent_queue->read_file)) == 0)
+    {
+        /*end of the segment*/
+        move_to_next_segment(persistent_queue, persistent_queue->read_offset - persistent_queue->read_segment);
+        result = 0;
+    }
+    else
+    {
+        uint32_t size = get_uint32(header);
+        bool damaged;
+        if ((header_read != RECORD_HEADER_SIZE) || (size == 0) || (size > persistent_queue->write_offset - persistent_queue->read_offset))
+        {
+            damaged = true;
+        }
+        else if ((*payload = (unsigned char*)malloc(size)) == NULL)
+        {
+            LogError("unable to allocate %lu bytes for a record", (unsigned long)size);
+            damaged = false;
+        }
+        else if ((fread(*payload, 1, size, persistent_queue->read_file) != size) || (compute_checksum(*payload, size) != get_uint32(header + 4)))
+        {
+            free(*payload);
+            *payload = NULL;
+            damaged = true;
+        }
+        else
+        {
+            *payload_size = size;
+            damaged = false;
+        }
+
+        if (damaged)
+        {
+            uint64_t segment_size;
+            LogError("skipping the rest of %s after a damaged record", get_segment_name(persistent_queue, persistent_queue->read_segment));
+            if (get_segment_file_size(persistent_queue, persistent_queue->read_segment, &segment_size) != 0)
+            {
+                result = MU_FAILURE;
+            }
+            else
+            {
+                move_to_next_segment(persistent_queue, segment_size);
+                result = 0;
+            }
+        }
+        else
+        {
+            result = (*payload == NULL) ? MU_FAILURE : 0;
+        }
+    }
+    return result;
+}
+
+/*deletes the segments from first that end at or before offset and that reading has moved past. Returns the first segment kept*/
+static uint64_t delete_segments_before(PERSISTENT_QUEUE* persistent_queue, uint64_t first, uint64_t offset)
+{
+    uint64_t size;
+    while ((first < persistent_queue->read_segment) && (get_segment_file_size(persistent_queue, first, &size) == 0) && (size != 0) && (first + size <= offset))
+    {
+        if (remove(get_segment_name(persistent_queue, first)) != 0)
+        {
+            LogError("unable to delete %s", persistent_queue->segment_name);
+        }
+        first += size;
+    }
+    return first;
+}
+
+PERSISTENT_QUEUE_HANDLE persistent_queue_create(const char* path, size_t segment_size)
+{
+    PERSISTENT_QUEUE* result;
+    if ((path == NULL) || (segment_size == 0))
+    {
+        LogError("invalid argument (path=%p, segment_size=%lu)", path, (unsigned long)segment_size);
+        result = NULL;
+    }
+    else if ((result = (PERSISTENT_QUEUE*)malloc(sizeof(PERSISTENT_QUEUE))) == NULL)
+    {
+        LogError("unable to allocate PERSISTENT_QUEUE");
+    }
+    else
+    {
+        memset(result, 0, sizeof(PERSISTENT_QUEUE));
+        result->segment_size = segment_size;
+        result->path_length = strlen(path);
+
+        if (((result->segment_name = (char*)malloc(result->path_length + SEGMENT_NAME_EXTRA_LENGTH + 1)) == NULL) ||
+            ((result->checkpoint_name = create_file_name(path, CHECKPOINT_SUFFIX)) == NULL) ||
+            ((result->checkpoint_temp_name = create_file_name(path, CHECKPOINT_TEMP_SUFFIX)) == NULL) ||
+            ((result->directory_name = create_directory_name(path)) == NULL))
+        {
+            LogError("unable to allocate the file names");
+            free(result->segment_name);
+            free(result->checkpoint_name);
+            free(result->checkpoint_temp_name);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            uint64_t segment;
+            uint64_t size;
+
+            (void)memcpy(result->segment_name, path, result->path_length);
+            result->segment_name[result->path_length] = '.';
+            (void)memcpy(result->segment_name + result->path_length + 17, SEGMENT_SUFFIX, strlen(SEGMENT_SUFFIX) + 1);
+
+            if ((read_checkpoint_file(result->checkpoint_name, &result->checkpoint_segment, &result->checkpoint_offset) != 0) &&
+                (read_checkpoint_file(result->checkpoint_temp_name, &result->checkpoint_segment, &result->checkpoint_offset) != 0))
+            {
+                result->checkpoint_segment = 0;
+                result->checkpoint_offset = 0;
+            }
+            result->ack_segment = result->checkpoint_segment;
+            result->ack_offset = result->checkpoint_offset;
+            result->read_offset = result->checkpoint_offset;
+            result->read_segment = (get_segment_file_size(result, result->checkpoint_segment, &size) == 0) ? result->checkpoint_segment : result->checkpoint_offset;
+
+            /*appending always starts a new segment after the last one found, so it never follows a record torn by a crash*/
+            segment = result->read_segment;
+            while ((get_segment_file_size(result, segment, &size) == 0) && (size != 0))
+            {
+                segment += size;
+            }
+            result->write_segment = segment;
+            result->write_offset = segment;
+            result->flushed_offset = segment;
+            result->synced_offset = segment;
+        }
+    }
+    return result;
+}
+
+void persistent_queue_destroy(PERSISTENT_QUEUE_HANDLE persistent_queue)
+{
+    if (persistent_queue == NULL)
+    {
+        LogError("invalid argument (persistent_queue=NULL)");
+    }
+    else
+    {
+        close_read_file(persistent_queue);
+        if ((persistent_queue->write_file != NULL) && (fclose(persistent_queue->write_file) != 0))
+        {
+            LogError("unable to close %s", get_segment_name(persistent_queue, persistent_queue->write_segment));
+        }
+        free(persistent_queue->pending_acks);
+        free(persistent_queue->directory_name);
+        free(persistent_queue->checkpoint_temp_name);
+        free(persistent_queue->checkpoint_name);
+        free(persistent_queue->segment_name);
+        free(persistent_queue);
+    }
+}
+
+int persistent_queue_append(PERSISTENT_QUEUE_HANDLE persistent_queue, IOTHUB_MESSAGE_HANDLE message, uint64_t* record_id)
+{
+    int result;
+    MESSAGE_FIELDS fields;
+    if ((persistent_queue == NULL) || (message == NULL) || (record_id == NULL))
+    {
+        LogError("invalid argument (persistent_queue=%p, message=%p, record_id=%p)", persistent_queue, message, record_id);
+        result = MU_FAILURE;
+    }
+    else if (get_message_fields(message, &fields) != 0)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        RECORD_WRITER writer;
+        size_t payload_size;
+        writer.buffer = NULL;
+        writer.position = RECORD_HEADER_SIZE;
+        write_message_fields(&writer, &fields);
+        payload_size = writer.position - RECORD_HEADER_SIZE;
+
+        if (payload_size >= NULL_STRING_LENGTH)
+        {
+            LogError("message of %lu bytes is too large to be stored", (unsigned long)payload_size);
+            result = MU_FAILURE;
+        }
+        else if ((writer.buffer = (unsigned char*)malloc(writer.position)) == NULL)
+        {
+            LogError("unable to allocate %lu bytes for a record", (unsigned long)writer.position);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            size_t record_size = writer.position;
+            writer.position = RECORD_HEADER_SIZE;
+            write_message_fields(&writer, &fields);
+            put_uint32(writer.buffer, (uint32_t)payload_size);
+            put_uint32(writer.buffer + 4, compute_checksum(writer.buffer + RECORD_HEADER_SIZE, payload_size));
+
+            if ((persistent_queue->write_file != NULL) &&
+                (persistent_queue->write_offset > persistent_queue->write_segment) &&
+                (persistent_queue->write_offset - persistent_queue->write_segment + record_size > persistent_queue->segment_size))
+            {
+                /*start a new segment. The full one is synced now, since sync_appends only knows about the current one*/
+                if ((fflush(persistent_queue->write_file) != 0) || (sync_file(persistent_queue->write_file) != 0))
+                {
+                    LogError("unable to sync %s", get_segment_name(persistent_queue, persistent_queue->write_segment));
+                }
+                if (fclose(persistent_queue->write_file) != 0)
+                {
+                    LogError("unable to close %s", get_segment_name(persistent_queue, persistent_queue->write_segment));
+                }
+                persistent_queue->write_file = NULL;
+                persistent_queue->flushed_offset = persistent_queue->write_offset;
+                persistent_queue->synced_offset = persistent_queue->write_offset;
+                persistent_queue->write_segment = persistent_queue->write_offset;
+            }
+
+            if (persistent_queue->write_file == NULL)
+            {
+                /*opening may create the segment*/
+                persistent_queue->directory_changed = true;
+            }
+
+            if ((persistent_queue->write_file == NULL) &&
+                ((persistent_queue->write_file = fopen(get_segment_name(persistent_queue, persistent_queue->write_segment), "ab")) == NULL))
+            {
+                LogError("unable to open %s", persistent_queue->segment_name);
+                result = MU_FAILURE;
+            }
+            else if (fwrite(writer.buffer, 1, record_size, persistent_queue->write_file) != record_size)
+            {
+                /*the segment may now end with part of this record, which reading will skip, so nothing more is appended to it*/
+                LogError("unable to write to %s", get_segment_name(persistent_queue, persistent_queue->write_segment));
+                if ((fflush(persistent_queue->write_file) != 0) || (sync_file(persistent_queue->write_file) != 0))
+                {
+                    LogError("unable to sync %s", get_segment_name(persistent_queue, persistent_queue->write_segment));
+                }
+                (void)fclose(persistent_queue->write_file);
+                persistent_queue->write_file = NULL;
+                if (get_segment_file_size(persistent_queue, persistent_queue->write_segment, &persistent_queue->write_offset) == 0)
+                {
+                    persistent_queue->write_offset += persistent_queue->write_segment;
+                    persistent_queue->flushed_offset = persistent_queue->write_offset;
+                    persistent_queue->synced_offset = persistent_queue->write_offset;
+                    persistent_queue->write_segment = persistent_queue->write_offset;
+                }
+                result = MU_FAILURE;
+            }
+            else
+            {
+                *record_id = persistent_queue->write_offset;
+                persistent_queue->write_offset += record_size;
+                result = 0;
+            }
+            free(writer.buffer);
+        }
+    }
+    return result;
+}
+
+bool persistent_queue_has_unread(PERSISTENT_QUEUE_HANDLE persistent_queue)
+{
+    return (persistent_queue != NULL) && (persistent_queue->read_offset < persistent_queue->write_offset);
+}
+
+int persistent_queue_read(PERSISTENT_QUEUE_HANDLE persistent_queue, IOTHUB_MESSAGE_HANDLE* message, uint64_t* record_id)
+{
+    int result;
+    if ((persistent_queue == NULL) || (message == NULL) || (record_id == NULL))
+    {
+        LogError("invalid argument (persistent_queue=%p, message=%p, record_id=%p)", persistent_queue, message, record_id);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        *message = NULL;
+        result = 0;
+        while ((result == 0) && (*message == NULL) && (persistent_queue->read_offset < persistent_queue->write_offset))
+        {
+            unsigned char* payload;
+            size_t payload_size;
+            uint64_t read_offset = persistent_queue->read_offset;
+
+            if ((persistent_queue->read_offset >= persistent_queue->flushed_offset) && (flush_appends(persistent_queue) != 0))
+            {
+                result = MU_FAILURE;
+            }
+            else if ((persistent_queue->read_file == NULL) &&
+                ((persistent_queue->read_file = fopen(get_segment_name(persistent_queue, persistent_queue->read_segment), "rb")) == NULL))
+            {
+                LogError("unable to open %s", persistent_queue->segment_name);
+                result = MU_FAILURE;
+            }
+            else if (read_record(persistent_queue, &payload, &payload_size) != 0)
+            {
+                result = MU_FAILURE;
+            }
+            else if (payload != NULL)
+            {
+                uint64_t next_offset = read_offset + RECORD_HEADER_SIZE + payload_size;
+                if ((*message = create_message_from_record(payload, payload_size)) == NULL)
+                {
+                    /*a record that passed its checksum but cannot be turned back into a message is acknowledged right away*/
+                    LogError("dropping the record at %lu", (unsigned long)read_offset);
+                    persistent_queue->read_offset = next_offset;
+                    if (add_pending_ack(persistent_queue, read_offset, next_offset) != 0)
+                    {
+                        persistent_queue->read_offset = read_offset;
+                        result = MU_FAILURE;
+                    }
+                    else
+                    {
+                        (void)persistent_queue_ack(persistent_queue, read_offset);
+                    }
+                }
+                else if (add_pending_ack(persistent_queue, read_offset, next_offset) != 0)
+                {
+                    IoTHubMessage_Destroy(*message);
+                    *message = NULL;
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    persistent_queue->read_offset = next_offset;
+                    *record_id = read_offset;
+                }
+                free(payload);
+            }
+        }
+    }
+    return result;
+}
+
+int persistent_queue_ack(PERSISTENT_QUEUE_HANDLE persistent_queue, uint64_t record_id)
+{
+    int result;
+    if (persistent_queue == NULL)
+    {
+        LogError("invalid argument (persistent_queue=NULL)");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t i;
+        PENDING_ACK* pending_ack = NULL;
+        for (i = 0; i < persistent_queue->pending_acks_count; i++)
+        {
+            PENDING_ACK* candidate = &persistent_queue->pending_acks[(persistent_queue->pending_acks_head + i) % persistent_queue->pending_acks_capacity];
+            if (candidate->record_id == record_id)
+            {
+                pending_ack = candidate;
+                break;
+            }
+        }
+
+        if (pending_ack == NULL)
+        {
+            LogError("record %lu is not waiting for acknowledgement", (unsigned long)record_id);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            pending_ack->acked = true;
+            while ((persistent_queue->pending_acks_count > 0) && persistent_queue->pending_acks[persistent_queue->pending_acks_head].acked)
+            {
+                persistent_queue->ack_segment = persistent_queue->pending_acks[persistent_queue->pending_acks_head].segment;
+                persistent_queue->ack_offset = persistent_queue->pending_acks[persistent_queue->pending_acks_head].next_offset;
+                persistent_queue->pending_acks_head = (persistent_queue->pending_acks_head + 1) % persistent_queue->pending_acks_capacity;
+                persistent_queue->pending_acks_count--;
+            }
+            result = 0;
+        }
+    }
+    return result;
+}
+
+int persistent_queue_sync(PERSISTENT_QUEUE_HANDLE persistent_queue)
+{
+    int result;
+    if (persistent_queue == NULL)
+    {
+        LogError("invalid argument (persistent_queue=NULL)");
+        result = MU_FAILURE;
+    }
+    else if (sync_appends(persistent_queue) != 0)
+    {
+        result = MU_FAILURE;
+    }
+    else if (persistent_queue->ack_offset == persistent_queue->checkpoint_offset)
+    {
+        result = 0;
+    }
+    else if (write_checkpoint(persistent_queue, persistent_queue->ack_segment, persistent_queue->ack_offset) != 0)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        persistent_queue->checkpoint_segment = delete_segments_before(persistent_queue, persistent_queue->checkpoint_segment, persistent_queue->ack_offset);
+        persistent_queue->checkpoint_offset = persistent_queue->ack_offset;
+        result = 0;
+    }
+    return result;
+}
@@ -664,8 +664,36 @@ static int create_data_to_encode(IOTHUB_MESSAGE_HANDLE messageHandle, AMQP_VALUE
 }
 
 // Codes_SRS_UAMQP_MESSAGING_31_120: [Create a blob that contains AMQP encoding of IOTHUB_MESSAGE_HANDLE.]
+// Codes_SRS_UAMQP_MESSAGING_31_124: [The encoding buffer shall only be reallocated when it is smaller than the encoded message, and it shall never be shrunk.]
+static int reserve_encoding_buffer(UAMQP_ENCODING_BUFFER* encoding_buffer, size_t length)
+{
+    int result;
+
+    if (length <= encoding_buffer->size)
+    {
+        result = RESULT_OK;
+    }
+    else
+    {
+        unsigned char* bytes = (encoding_buffer->bytes == NULL) ? (unsigned char*)malloc(length) : (unsigned char*)realloc(encoding_buffer->bytes, length);
+        if (bytes == NULL)
+        {
+            LogError("allocating %lu bytes for the encoded message failed", (unsigned long)length);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            encoding_buffer->bytes = bytes;
+            encoding_buffer->size = length;
+            result = RESULT_OK;
+        }
+    }
+
+    return result;
+}
+
 // Codes_SRS_UAMQP_MESSAGING_31_121: [Any errors during `message_create_uamqp_encoding_from_iothub_message` stop processing on this message.]
-int message_create_uamqp_encoding_from_iothub_message(MESSAGE_HANDLE message_batch_container, IOTHUB_MESSAGE_HANDLE message_handle, BINARY_DATA* body_binary_data)
+static int create_uamqp_encoding(MESSAGE_HANDLE message_batch_container, IOTHUB_MESSAGE_HANDLE message_handle, UAMQP_ENCODING_BUFFER* encoding_buffer, BINARY_DATA* body_binary_data)
 {
     int result;
 
@@ -701,9 +729,15 @@ int message_create_uamqp_encoding_from_iothub_message(MESSAGE_HANDLE message_bat
         LogError("create_data_to_encode() failed");
         result = MU_FAILURE;
     }
-    else if ((body_binary_data->bytes = malloc(message_properties_length + application_properties_length + data_length + message_annotations_length)) == NULL)
+    else if (reserve_encoding_buffer(encoding_buffer, message_properties_length + application_properties_length + data_length + message_annotations_length) != RESULT_OK)
+    {
+        LogError("reserve_encoding_buffer() failed");
+        result = MU_FAILURE;
+    }
+    // encode_callback appends to body_binary_data, which starts at the beginning of the encoding buffer
+    else if ((body_binary_data->bytes = encoding_buffer->bytes) == NULL)
     {
-        LogError("malloc of %lu bytes failed", (unsigned long)(message_properties_length + application_properties_length + data_length + message_annotations_length));
+        LogError("the encoding buffer is empty");
         result = MU_FAILURE;
     }
     // Codes_SRS_UAMQP_MESSAGING_31_119: [Invoke underlying AMQP encode routines on data waiting to be encoded.]
@@ -756,6 +790,46 @@ int message_create_uamqp_encoding_from_iothub_message(MESSAGE_HANDLE message_bat
     return result;
 }
 
+int message_create_uamqp_encoding_from_iothub_message(MESSAGE_HANDLE message_batch_container, IOTHUB_MESSAGE_HANDLE message_handle, BINARY_DATA* body_binary_data)
+{
+    int result;
+
+    if (message_handle == NULL || body_binary_data == NULL)
+    {
+        LogError("Invalid argument (message_handle=%p, body_binary_data=%p)", message_handle, body_binary_data);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        UAMQP_ENCODING_BUFFER encoding_buffer = { NULL, 0 };
+        result = create_uamqp_encoding(message_batch_container, message_handle, &encoding_buffer, body_binary_data);
+
+        // The caller owns the encoded bytes, and frees them even if encoding failed after they were allocated.
+        body_binary_data->bytes = encoding_buffer.bytes;
+    }
+
+    return result;
+}
+
+int message_create_uamqp_encoding_in_buffer(MESSAGE_HANDLE message_batch_container, IOTHUB_MESSAGE_HANDLE message_handle, UAMQP_ENCODING_BUFFER* encoding_buffer, BINARY_DATA* body_binary_data)
+{
+    int result;
+
+    if (message_handle == NULL || encoding_buffer == NULL || body_binary_data == NULL)
+    {
+        LogError("Invalid argument (message_handle=%p, encoding_buffer=%p, body_binary_data=%p)", message_handle, encoding_buffer, body_binary_data);
+        result = MU_FAILURE;
+    }
+    else if ((result = create_uamqp_encoding(message_batch_container, message_handle, encoding_buffer, body_binary_data)) != RESULT_OK)
+    {
+        // Codes_SRS_UAMQP_MESSAGING_31_125: [On failure `body_binary_data` shall be left empty; the encoding buffer stays owned by the caller.]
+        body_binary_data->bytes = NULL;
+        body_binary_data->length = 0;
+    }
+
+    return result;
+}
+
 static int readMessageIdFromuAQMPMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, PROPERTIES_HANDLE uamqp_message_properties)
 {
     int result;
@@ -0,0 +1,496 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#endif
+
+static void* real_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void real_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umocktypes_charptr.h"
+#include "umock_c/umocktypes_bool.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#undef ENABLE_MOCKS
+
+#include "internal/blob_file_source.h"
+#include "internal/iothub_client_ll_uploadtoblob.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+// Data definitions
+
+static const char* TEST_FILE_PATH = "blob_file_source_ut_file";
+static const char* TEST_CHECKPOINT_PATH = "blob_file_source_ut_checkpoint";
+static const char* TEST_CHECKPOINT_TEMP_PATH = "blob_file_source_ut_checkpoint.tmp";
+static const char* TEST_DESTINATION = "logs/device.log";
+#define TEST_LAST_BLOCK_SIZE 3
+
+// Helpers
+
+/*byte i of the test file*/
+static unsigned char get_test_byte(size_t i)
+{
+    return (unsigned char)((i * 7) + (i / BLOCK_SIZE));
+}
+
+static void create_test_file(size_t size)
+{
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    size_t i;
+    ASSERT_IS_NOT_NULL(file);
+    for (i = 0; i < size; i++)
+    {
+        ASSERT_ARE_NOT_EQUAL(int, EOF, fputc(get_test_byte(i), file));
+    }
+    ASSERT_ARE_EQUAL(int, 0, fclose(file));
+}
+
+static bool file_exists(const char* name)
+{
+    FILE* file = fopen(name, "rb");
+    if (file != NULL)
+    {
+        (void)fclose(file);
+    }
+    return file != NULL;
+}
+
+static void delete_test_files(void)
+{
+    (void)remove(TEST_FILE_PATH);
+    (void)remove(TEST_CHECKPOINT_PATH);
+    (void)remove(TEST_CHECKPOINT_TEMP_PATH);
+}
+
+/*gets the next block and checks that it is block block_number of a file of file_size bytes*/
+static void assert_next_block(BLOB_FILE_SOURCE_HANDLE file_source, size_t block_number, size_t file_size)
+{
+    const unsigned char* data = NULL;
+    size_t size = 0;
+    size_t expected_size = (file_size - block_number * BLOCK_SIZE > BLOCK_SIZE) ? BLOCK_SIZE : file_size - block_number * BLOCK_SIZE;
+    size_t i;
+
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_OK, (int)blob_file_source_get_data(FILE_UPLOAD_OK, &data, &size, file_source));
+    ASSERT_IS_NOT_NULL(data);
+    ASSERT_ARE_EQUAL(size_t, expected_size, size);
+    for (i = 0; i < size; i += 4099) /*a sample of the bytes is enough*/
+    {
+        ASSERT_ARE_EQUAL(int, (int)get_test_byte(block_number * BLOCK_SIZE + i), (int)data[i]);
+    }
+    ASSERT_ARE_EQUAL(int, (int)get_test_byte(block_number * BLOCK_SIZE + size - 1), (int)data[size - 1]);
+}
+
+static void assert_no_more_blocks(BLOB_FILE_SOURCE_HANDLE file_source)
+{
+    const unsigned char* data = (const unsigned char*)0x1;
+    size_t size = 1;
+
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_OK, (int)blob_file_source_get_data(FILE_UPLOAD_OK, &data, &size, file_source));
+    ASSERT_IS_NULL(data);
+    ASSERT_ARE_EQUAL(size_t, 0, size);
+}
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return real_malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    real_free(ptr);
+}
+
+BEGIN_TEST_SUITE(blob_file_source_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    int result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    delete_test_files();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    delete_test_files();
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(blob_file_source_create_with_NULL_file_path_fails)
+{
+    // arrange
+
+    // act
+    BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(NULL, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+
+    // assert
+    ASSERT_IS_NULL(file_source);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(blob_file_source_create_with_NULL_destination_fails)
+{
+    // arrange
+    create_test_file(1);
+
+    // act
+    BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, NULL);
+
+    // assert
+    ASSERT_IS_NULL(file_source);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(blob_file_source_create_with_missing_file_fails)
+{
+    // arrange
+
+    // act
+    BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+
+    // assert
+    ASSERT_IS_NULL(file_source);
+}
+
+TEST_FUNCTION(blob_file_source_create_fails_when_malloc_fails)
+{
+    // arrange
+    create_test_file(1);
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(TEST_FILE_PATH, NULL, TEST_DESTINATION);
+
+    // assert
+    ASSERT_IS_NULL(file_source);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(blob_file_source_get_data_returns_the_file_block_by_block)
+{
+    // arrange
+    size_t file_size = BLOCK_SIZE + TEST_LAST_BLOCK_SIZE;
+    create_test_file(file_size);
+    BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(TEST_FILE_PATH, NULL, TEST_DESTINATION);
+    ASSERT_IS_NOT_NULL(file_source);
+
+    // act
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, (int)blob_file_source_get_uploaded_block_count(file_source));
+    assert_next_block(file_source, 0, file_size);
+    assert_next_block(file_source, 1, file_size);
+    assert_no_more_blocks(file_source);
+    ASSERT_IS_FALSE(blob_file_source_has_failed(file_source));
+    ASSERT_IS_FALSE(file_exists(TEST_CHECKPOINT_PATH));
+
+    // cleanup
+    blob_file_source_destroy(file_source);
+}
+
+TEST_FUNCTION(blob_file_source_get_data_of_empty_file_returns_no_block)
+{
+    // arrange
+    create_test_file(0);
+    BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+    ASSERT_IS_NOT_NULL(file_source);
+
+    // act
+    // assert
+    assert_no_more_blocks(file_source);
+    ASSERT_IS_FALSE(blob_file_source_has_failed(file_source));
+
+    // cleanup
+    blob_file_source_destroy(file_source);
+}
+
+TEST_FUNCTION(blob_file_source_get_data_after_failed_upload_returns_no_block)
+{
+    // arrange
+    const unsigned char* data = (const unsigned char*)0x1;
+    size_t size = 1;
+    create_test_file(TEST_LAST_BLOCK_SIZE);
+    BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+    ASSERT_IS_NOT_NULL(file_source);
+
+    // act
+    IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_RESULT result = blob_file_source_get_data(FILE_UPLOAD_ERROR, &data, &size, file_source);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_OK, (int)result);
+    ASSERT_IS_NULL(data);
+    ASSERT_ARE_EQUAL(size_t, 0, size);
+
+    // cleanup
+    blob_file_source_destroy(file_source);
+}
+
+TEST_FUNCTION(blob_file_source_get_data_checkpoints_each_uploaded_block)
+{
+    // arrange
+    size_t file_size = BLOCK_SIZE + TEST_LAST_BLOCK_SIZE;
+    create_test_file(file_size);
+    BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+    ASSERT_IS_NOT_NULL(file_source);
+    assert_next_block(file_source, 0, file_size);
+    ASSERT_IS_FALSE(file_exists(TEST_CHECKPOINT_PATH));
+
+    // act
+    assert_next_block(file_source, 1, file_size); /*asking for block 1 means block 0 is uploaded*/
+
+    // assert
+    ASSERT_IS_TRUE(file_exists(TEST_CHECKPOINT_PATH));
+    ASSERT_IS_FALSE(file_exists(TEST_CHECKPOINT_TEMP_PATH));
+    blob_file_source_destroy(file_source);
+
+    file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+    ASSERT_IS_NOT_NULL(file_source);
+    ASSERT_ARE_EQUAL(int, 1, (int)blob_file_source_get_uploaded_block_count(file_source));
+    assert_next_block(file_source, 1, file_size);
+    assert_no_more_blocks(file_source);
+
+    // cleanup
+    blob_file_source_destroy(file_source);
+}
+
+TEST_FUNCTION(blob_file_source_resumes_after_the_last_block)
+{
+    // arrange
+    size_t file_size = TEST_LAST_BLOCK_SIZE;
+    create_test_file(file_size);
+    BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+    ASSERT_IS_NOT_NULL(file_source);
+    assert_next_block(file_source, 0, file_size);
+    assert_no_more_blocks(file_source); /*the last block is uploaded, the block list is not*/
+    blob_file_source_destroy(file_source);
+
+    // act
+    file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+
+    // assert
+    ASSERT_IS_NOT_NULL(file_source);
+    ASSERT_ARE_EQUAL(int, 1, (int)blob_file_source_get_uploaded_block_count(file_source));
+    assert_no_more_blocks(file_source);
+
+    // cleanup
+    blob_file_source_destroy(file_source);
+}
+
+TEST_FUNCTION(blob_file_source_last_call_after_successful_upload_deletes_the_checkpoint)
+{
+    // arrange
+    size_t file_size = TEST_LAST_BLOCK_SIZE;
+    create_test_file(file_size);
+    BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+    ASSERT_IS_NOT_NULL(file_source);
+    assert_next_block(file_source, 0, file_size);
+    assert_no_more_blocks(file_source);
+    ASSERT_IS_TRUE(file_exists(TEST_CHECKPOINT_PATH));
+
+    // act
+    (void)blob_file_source_get_data(FILE_UPLOAD_OK, NULL, NULL, file_source);
+
+    // assert
+    ASSERT_IS_FALSE(file_exists(TEST_CHECKPOINT_PATH));
+    ASSERT_IS_TRUE(file_exists(TEST_FILE_PATH));
+
+    // cleanup
+    blob_file_source_destroy(file_source);
+}
+
+TEST_FUNCTION(blob_file_source_last_call_after_failed_upload_keeps_the_checkpoint)
+{
+    // arrange
+    size_t file_size = TEST_LAST_BLOCK_SIZE;
+    create_test_file(file_size);
+    BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+    ASSERT_IS_NOT_NULL(file_source);
+    assert_next_block(file_source, 0, file_size);
+    assert_no_more_blocks(file_source);
+
+    // act
+    (void)blob_file_source_get_data(FILE_UPLOAD_ERROR, NULL, NULL, file_source);
+
+    // assert
+    ASSERT_IS_TRUE(file_exists(TEST_CHECKPOINT_PATH));
+
+    // cleanup
+    blob_file_source_destroy(file_source);
+}
+
+TEST_FUNCTION(blob_file_source_ignores_checkpoint_of_another_destination)
+{
+    // arrange
+    size_t file_size = TEST_LAST_BLOCK_SIZE;
+    create_test_file(file_size);
+    BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+    ASSERT_IS_NOT_NULL(file_source);
+    assert_next_block(file_source, 0, file_size);
+    assert_no_more_blocks(file_source);
+    blob_file_source_destroy(file_source);
+
+    // act
+    file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, "logs/another.log");
+
+    // assert
+    ASSERT_IS_NOT_NULL(file_source);
+    ASSERT_ARE_EQUAL(int, 0, (int)blob_file_source_get_uploaded_block_count(file_source));
+    assert_next_block(file_source, 0, file_size);
+
+    // cleanup
+    blob_file_source_destroy(file_source);
+}
+
+TEST_FUNCTION(blob_file_source_ignores_checkpoint_of_a_file_of_another_size)
+{
+    // arrange
+    BLOB_FILE_SOURCE_HANDLE file_source;
+    create_test_file(TEST_LAST_BLOCK_SIZE);
+    file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+    ASSERT_IS_NOT_NULL(file_source);
+    assert_next_block(file_source, 0, TEST_LAST_BLOCK_SIZE);
+    assert_no_more_blocks(file_source);
+    blob_file_source_destroy(file_source);
+    create_test_file(TEST_LAST_BLOCK_SIZE + 1);
+
+    // act
+    file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+
+    // assert
+    ASSERT_IS_NOT_NULL(file_source);
+    ASSERT_ARE_EQUAL(int, 0, (int)blob_file_source_get_uploaded_block_count(file_source));
+    assert_next_block(file_source, 0, TEST_LAST_BLOCK_SIZE + 1);
+
+    // cleanup
+    blob_file_source_destroy(file_source);
+}
+
+TEST_FUNCTION(blob_file_source_ignores_checkpoint_of_another_file_of_the_same_size)
+{
+    // arrange
+    size_t file_size = BLOCK_SIZE + TEST_LAST_BLOCK_SIZE;
+    BLOB_FILE_SOURCE_HANDLE file_source;
+    FILE* file;
+    create_test_file(file_size);
+    file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+    ASSERT_IS_NOT_NULL(file_source);
+    assert_next_block(file_source, 0, file_size);
+    assert_next_block(file_source, 1, file_size);
+    blob_file_source_destroy(file_source);
+    file = fopen(TEST_FILE_PATH, "r+b"); /*same size, another first byte*/
+    ASSERT_IS_NOT_NULL(file);
+    ASSERT_ARE_NOT_EQUAL(int, EOF, fputc(get_test_byte(0) + 1, file));
+    ASSERT_ARE_EQUAL(int, 0, fclose(file));
+
+    // act
+    file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+
+    // assert
+    ASSERT_IS_NOT_NULL(file_source);
+    ASSERT_ARE_EQUAL(int, 0, (int)blob_file_source_get_uploaded_block_count(file_source));
+
+    // cleanup
+    blob_file_source_destroy(file_source);
+}
+
+TEST_FUNCTION(blob_file_source_ignores_damaged_checkpoint)
+{
+    // arrange
+    FILE* checkpoint = fopen(TEST_CHECKPOINT_PATH, "wb");
+    ASSERT_IS_NOT_NULL(checkpoint);
+    ASSERT_ARE_EQUAL(size_t, 20, fwrite("not a real checkpoint", 1, 20, checkpoint));
+    ASSERT_ARE_EQUAL(int, 0, fclose(checkpoint));
+    create_test_file(TEST_LAST_BLOCK_SIZE);
+
+    // act
+    BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+
+    // assert
+    ASSERT_IS_NOT_NULL(file_source);
+    ASSERT_ARE_EQUAL(int, 0, (int)blob_file_source_get_uploaded_block_count(file_source));
+
+    // cleanup
+    blob_file_source_destroy(file_source);
+}
+
+TEST_FUNCTION(blob_file_source_uses_temporary_checkpoint_when_the_checkpoint_is_missing)
+{
+    // arrange
+    size_t file_size = BLOCK_SIZE + TEST_LAST_BLOCK_SIZE;
+    create_test_file(file_size);
+    BLOB_FILE_SOURCE_HANDLE file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+    ASSERT_IS_NOT_NULL(file_source);
+    assert_next_block(file_source, 0, file_size);
+    assert_next_block(file_source, 1, file_size);
+    blob_file_source_destroy(file_source);
+    ASSERT_ARE_EQUAL(int, 0, rename(TEST_CHECKPOINT_PATH, TEST_CHECKPOINT_TEMP_PATH)); /*as if the rename had not happened*/
+
+    // act
+    file_source = blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION);
+
+    // assert
+    ASSERT_IS_NOT_NULL(file_source);
+    ASSERT_ARE_EQUAL(int, 1, (int)blob_file_source_get_uploaded_block_count(file_source));
+    assert_next_block(file_source, 1, file_size);
+
+    // cleanup
+    blob_file_source_destroy(file_source);
+}
+
+END_TEST_SUITE(blob_file_source_ut)
@@ -30,6 +30,8 @@ static void my_gballoc_free(void* s)
 #include "azure_c_shared_utility/httpheaders.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/lock.h"
 #undef ENABLE_MOCKS
 
 #include "internal/blob.h"
@@ -79,6 +81,22 @@ static void my_BUFFER_delete(BUFFER_HANDLE h)
     my_gballoc_free(h);
 }
 
+static BUFFER_HANDLE my_BUFFER_new(void)
+{
+    return (BUFFER_HANDLE)my_gballoc_malloc(1);
+}
+
+#define TEST_LOCK_HANDLE (LOCK_HANDLE)0x4242
+#define TEST_THREAD_HANDLE (THREAD_HANDLE)0x4243
+
+/*the thread runs to completion inside ThreadAPI_Create*/
+static THREADAPI_RESULT my_ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    *threadHandle = TEST_THREAD_HANDLE;
+    (void)func(arg);
+    return THREADAPI_OK;
+}
+
 static HTTP_HEADERS_HANDLE my_HTTPHeaders_Alloc(void)
 {
     return (HTTP_HEADERS_HANDLE)my_gballoc_malloc(1);
@@ -254,6 +272,16 @@ TEST_SUITE_INITIALIZE(TestSuiteInitialize)
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_create, my_BUFFER_create);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(BUFFER_create, NULL);
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_delete, my_BUFFER_delete);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_new, my_BUFFER_new);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(BUFFER_new, NULL);
+    REGISTER_GLOBAL_MOCK_RETURNS(BUFFER_build, 0, MU_FAILURE);
+
+    REGISTER_GLOBAL_MOCK_RETURNS(Lock_Init, TEST_LOCK_HANDLE, NULL);
+    REGISTER_GLOBAL_MOCK_RETURNS(Lock, LOCK_OK, LOCK_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURNS(Unlock, LOCK_OK, LOCK_ERROR);
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Create, my_ThreadAPI_Create);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(ThreadAPI_Create, THREADAPI_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(ThreadAPI_Join, THREADAPI_OK);
 
     REGISTER_GLOBAL_MOCK_HOOK(HTTPHeaders_Alloc, my_HTTPHeaders_Alloc);
     REGISTER_GLOBAL_MOCK_HOOK(HTTPHeaders_Free, my_HTTPHeaders_Free);
@@ -278,6 +306,11 @@ TEST_SUITE_INITIALIZE(TestSuiteInitialize)
 
     REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREADAPI_RESULT, int);
 
     REGISTER_TYPE(HTTPAPI_REQUEST_TYPE, HTTPAPI_REQUEST_TYPE);
     REGISTER_TYPE(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT);
@@ -311,6 +344,98 @@ static void set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup()
         .IgnoreArgument_ptr();
 }
 
+/*the array of workers, and the connection and buffers of every worker (workers[0] uses the connection of the caller)*/
+static void set_expected_calls_for_parallel_workers_create(size_t workerCount)
+{
+    size_t i;
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)); /*this is the array of workers*/
+    for (i = 0; i < workerCount; i++)
+    {
+        if (i > 0)
+        {
+            STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h")); /*this is the connection of the worker*/
+        }
+        STRICT_EXPECTED_CALL(BUFFER_new()); /*this is where the worker copies its blocks*/
+        STRICT_EXPECTED_CALL(BUFFER_new()); /*this is the HTTP response of the worker*/
+    }
+}
+
+static void set_expected_calls_for_parallel_workers_destroy(size_t workerCount)
+{
+    size_t i;
+    for (i = 0; i < workerCount; i++)
+    {
+        if (i > 0)
+        {
+            STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG));
+        }
+        STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+    }
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); /*this is the array of workers*/
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+}
+
+/*a worker takes the next block from the callback and encodes its ID*/
+static void set_expected_calls_for_parallel_take_block(void)
+{
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG)); /*this is copying the block*/
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Azure_Base64_Encode_Bytes(IGNORED_PTR_ARG, 6));
+}
+
+/*a worker finds that there are no more blocks*/
+static void set_expected_calls_for_parallel_no_more_blocks(void)
+{
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+}
+
+static void set_expected_calls_for_parallel_put_block_attempt(const unsigned int* responseCode, HTTPAPIEX_RESULT executeResult)
+{
+    STRICT_EXPECTED_CALL(STRING_construct("/something?a=b")); /*this is building the relativePath*/
+    STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "&comp=block&blockid="));
+    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PUT, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_statusCode(responseCode, sizeof(*responseCode))
+        .SetReturn(executeResult);
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*this is unbuilding the relativePath*/
+}
+
+/*the IDs of blocks firstBlockID to blockCount-1 are added to the XML in block order*/
+static void set_expected_calls_for_block_ids(size_t firstBlockID, size_t blockCount)
+{
+    size_t i;
+    for (i = firstBlockID; i < blockCount; i++)
+    {
+        char expectedBlockId[7];
+        (void)sprintf(expectedBlockId, "%6u", (unsigned int)i);
+        STRICT_EXPECTED_CALL(Azure_Base64_Encode_Bytes(IGNORED_PTR_ARG, 6))
+            .ValidateArgumentBuffer(1, expectedBlockId, 6);
+        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "<Latest>"));
+        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "</Latest>"));
+        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    }
+}
+
+static void set_expected_calls_for_put_block_list(void)
+{
+    STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "</BlockList>")); /*This is closing the XML*/
+    STRICT_EXPECTED_CALL(STRING_construct("/something?a=b")); /*this is building the relative path for the Put BLock list*/
+    STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "&comp=blocklist"));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)); /*this is getting the XML as const char* so it can be passed to _ExecuteRequest*/
+    STRICT_EXPECTED_CALL(BUFFER_create(IGNORED_PTR_ARG, IGNORED_NUM_ARG)); /*this is creating the XML body as BUFFER_HANDLE*/
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)); /*this is getting the relative path*/
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PUT, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG, &httpResponse, NULL, testValidBufferHandle))
+        .CopyOutArgumentBuffer_statusCode(&TwoHundred, sizeof(TwoHundred));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG)); /*This is the XML as BUFFER_HANDLE*/
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*this is destroying the relative path for Put Block List*/
+}
+
 TEST_FUNCTION_INITIALIZE(Setup)
 {
     umock_c_reset_all_calls();
@@ -328,7 +453,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_with_NULL_SasUri_fails)
     ///arrange
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(NULL, FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(NULL, FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
 
     ///assert
     ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
@@ -343,7 +468,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_with_NULL_getDataCallBack_and_
     ///arrange
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(TEST_VALID_SASURI_1, NULL, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(TEST_VALID_SASURI_1, NULL, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
 
     ///assert
     ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
@@ -415,7 +540,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_succeeds_when_HTTP_status_code
     set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(TEST_VALID_SASURI_1, FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(TEST_VALID_SASURI_1, FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
 
     ///assert
     ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
@@ -488,7 +613,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_fails_when_HTTPAPIEX_ExecuteRe
     set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(TEST_VALID_SASURI_1, FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(TEST_VALID_SASURI_1, FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
 
     ///assert
     ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_HTTP_ERROR, result);
@@ -521,7 +646,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_fails_when_BUFFER_create_fails
     }
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(TEST_VALID_SASURI_1, FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(TEST_VALID_SASURI_1, FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
 
     ///assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -549,7 +674,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_fails_when_HTTPAPIEX_Create_fa
     set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(TEST_VALID_SASURI_1, FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(TEST_VALID_SASURI_1, FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
 
     ///assert
     ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_ERROR, result);
@@ -574,7 +699,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_fails_when_malloc_fails)
     set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(TEST_VALID_SASURI_1, FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(TEST_VALID_SASURI_1, FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
 
     ///assert
     ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_ERROR, result);
@@ -595,7 +720,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_when_SasUri_is_wrong_fails_1)
     set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https:/h.h/doms", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL); /*wrong format for protocol, notice it is actually http:\h.h\doms (missing a \ from http)*/
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https:/h.h/doms", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0); /*wrong format for protocol, notice it is actually http:\h.h\doms (missing a \ from http)*/
 
     ///assert
     ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
@@ -616,7 +741,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_when_SasUri_is_wrong_fails_2)
     set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL); /*there's no relative path here*/
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0); /*there's no relative path here*/
 
     ///assert
     ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
@@ -758,7 +883,7 @@ static void Blob_UploadMultipleBlocksFromSasUri_various_sizes_happy_path_Impl(HT
         set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
 
         ///act
-        BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, proxyOptions, networkInterface);
+        BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, proxyOptions, networkInterface, 1, 0);
 
         ///assert
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -941,7 +1066,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_various_sizes_with_certificate
         set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
 
         ///act
-        BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, "a", NULL, NULL);
+        BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, "a", NULL, NULL, 1, 0);
 
         ///assert
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -1079,7 +1204,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_64MB_unhappy_paths)
 
             ///act
             context.toUpload = context.size; /* Reinit context */
-            BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+            BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
 
             ///assert
             ASSERT_ARE_NOT_EQUAL(BLOB_RESULT, BLOB_OK, result, temp_str);
@@ -1225,7 +1350,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_64MB_with_certificate_and_netw
 
             ///act
             context.toUpload = context.size; /* Reinit context */
-            BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, "a", NULL, interfaceName);
+            BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, "a", NULL, interfaceName, 1, 0);
 
             ///assert
             ASSERT_ARE_NOT_EQUAL(BLOB_RESULT, BLOB_OK, result, temp_str);
@@ -1312,7 +1437,7 @@ TEST_FUNCTION(Blob_UploadFromSasUri_when_http_code_is_404_it_immediately_succeed
     set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
 
     ///assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -1335,7 +1460,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_when_blockSize_too_big_fails)
     fakeContext.abortOnBlockNumber = -1;
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetFakeData_Callback, &fakeContext, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetFakeData_Callback, &fakeContext, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
 
     ///assert
     ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
@@ -1356,7 +1481,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_when_blockSize_is_4MB_succeeds
     fakeContext.abortOnBlockNumber = -1;
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetFakeData_Callback, &fakeContext, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetFakeData_Callback, &fakeContext, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
 
     ///assert
     ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
@@ -1377,7 +1502,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_when_blockCount_is_maximum_suc
     fakeContext.abortOnBlockNumber = -1;
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetFakeData_Callback, &fakeContext, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetFakeData_Callback, &fakeContext, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
 
     ///assert
     ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
@@ -1398,7 +1523,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_when_blockCount_is_one_over_ma
     fakeContext.abortOnBlockNumber = -1;
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetFakeData_Callback, &fakeContext, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetFakeData_Callback, &fakeContext, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
 
     ///assert
     ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
@@ -1419,7 +1544,7 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_returns_BLOB_ABORTED_when_call
     fakeContext.abortOnBlockNumber = 0;
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetFakeData_Callback, &fakeContext, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetFakeData_Callback, &fakeContext, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
 
     ///assert
     ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_ABORTED, result);
@@ -1440,7 +1565,243 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_returns_BLOB_ABORTED_when_call
     fakeContext.abortOnBlockNumber = 5;
 
     ///act
-    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetFakeData_Callback, &fakeContext, &httpResponse, testValidBufferHandle, NULL, NULL, NULL);
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetFakeData_Callback, &fakeContext, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_ABORTED, result);
+
+    ///cleanup
+    gballoc_free(fakeContext.fakeData);
+}
+
+/*Tests_SRS_BLOB_31_001: [ If `parallelBlocks` is greater than 1, `Blob_UploadMultipleBlocksFromSasUri` shall upload up to `parallelBlocks` blocks at the same time, each on its own connection. ]*/
+/*Tests_SRS_BLOB_31_002: [ Every worker other than the first shall open a connection of its own with HTTPAPIEX_Create, with the same options as the first connection. ]*/
+/*Tests_SRS_BLOB_31_003: [ Each worker shall copy the blocks it uploads into a BUFFER_HANDLE of its own that is reused from block to block. ]*/
+/*Tests_SRS_BLOB_31_004: [ The block IDs shall be added to the block list in the order of the blocks, whatever the order in which their uploads complete. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_parallel_succeeds)
+{
+    ///arrange
+    const unsigned int TwoHundredOne = 201;
+    size_t size = 4 * 1024 * 1024 + 1; /*2 blocks*/
+    unsigned char* content = (unsigned char*)gballoc_malloc(size);
+    ASSERT_IS_NOT_NULL(content);
+    context.size = size;
+    context.source = content;
+    context.toUpload = context.size;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)); /*this is creating a copy of the hostname */
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(STRING_construct("<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n<BlockList>"));
+    set_expected_calls_for_parallel_workers_create(2);
+
+    /*workers[1] uploads both blocks inside ThreadAPI_Create*/
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    set_expected_calls_for_parallel_take_block();
+    set_expected_calls_for_parallel_put_block_attempt(&TwoHundredOne, HTTPAPIEX_OK);
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*this is the blockID string*/
+    set_expected_calls_for_parallel_take_block();
+    set_expected_calls_for_parallel_put_block_attempt(&TwoHundredOne, HTTPAPIEX_OK);
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*this is the blockID string*/
+    set_expected_calls_for_parallel_no_more_blocks();
+
+    /*workers[0] finds nothing left*/
+    set_expected_calls_for_parallel_no_more_blocks();
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));
+
+    set_expected_calls_for_block_ids(0, 2);
+    set_expected_calls_for_parallel_workers_destroy(2);
+    set_expected_calls_for_put_block_list();
+    set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 2, 0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+    ASSERT_ARE_EQUAL(int, 200, httpResponse);
+
+    ///cleanup
+    gballoc_free(content);
+}
+
+/*Tests_SRS_BLOB_31_005: [ A Put Block that fails with BLOB_HTTP_ERROR or with HTTP status 408, 429 or 5xx shall be attempted again, up to 3 attempts in total. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_parallel_retries_block_after_transient_failure)
+{
+    ///arrange
+    const unsigned int FiveHundredThree = 503;
+    const unsigned int TwoHundredOne = 201;
+    unsigned char c = '3';
+    context.size = 1;
+    context.source = &c;
+    context.toUpload = context.size;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)); /*this is creating a copy of the hostname */
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(STRING_construct("<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n<BlockList>"));
+    set_expected_calls_for_parallel_workers_create(2);
+
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    set_expected_calls_for_parallel_take_block();
+    set_expected_calls_for_parallel_put_block_attempt(&FiveHundredThree, HTTPAPIEX_OK);
+    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(1000));
+    set_expected_calls_for_parallel_put_block_attempt(&TwoHundredOne, HTTPAPIEX_OK);
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*this is the blockID string*/
+    set_expected_calls_for_parallel_no_more_blocks();
+
+    set_expected_calls_for_parallel_no_more_blocks();
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));
+
+    set_expected_calls_for_block_ids(0, 1);
+    set_expected_calls_for_parallel_workers_destroy(2);
+    set_expected_calls_for_put_block_list();
+    set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 2, 0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+}
+
+/*Tests_SRS_BLOB_31_005: [ A Put Block that fails with BLOB_HTTP_ERROR or with HTTP status 408, 429 or 5xx shall be attempted again, up to 3 attempts in total. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_parallel_fails_after_3_failed_attempts)
+{
+    ///arrange
+    unsigned char c = '3';
+    context.size = 1;
+    context.source = &c;
+    context.toUpload = context.size;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)); /*this is creating a copy of the hostname */
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(STRING_construct("<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n<BlockList>"));
+    set_expected_calls_for_parallel_workers_create(2);
+
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    set_expected_calls_for_parallel_take_block();
+    set_expected_calls_for_parallel_put_block_attempt(&TwoHundred, HTTPAPIEX_ERROR);
+    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(1000));
+    set_expected_calls_for_parallel_put_block_attempt(&TwoHundred, HTTPAPIEX_ERROR);
+    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(2000));
+    set_expected_calls_for_parallel_put_block_attempt(&TwoHundred, HTTPAPIEX_ERROR);
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*this is the blockID string*/
+    set_expected_calls_for_parallel_no_more_blocks();
+
+    set_expected_calls_for_parallel_no_more_blocks();
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));
+
+    /*no Put Block List*/
+    set_expected_calls_for_parallel_workers_destroy(2);
+    set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 2, 0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_HTTP_ERROR, result);
+}
+
+/*Tests_SRS_BLOB_31_006: [ If a block fails, no more blocks shall be requested from `getDataCallbackEx` and `Blob_UploadMultipleBlocksFromSasUri` shall report the first failure the same way as when the blocks are uploaded one at a time. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_parallel_stops_at_first_HTTP_status_failure)
+{
+    ///arrange
+    size_t size = 4 * 1024 * 1024 + 1; /*2 blocks*/
+    unsigned char* content = (unsigned char*)gballoc_malloc(size);
+    ASSERT_IS_NOT_NULL(content);
+    context.size = size;
+    context.source = content;
+    context.toUpload = context.size;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)); /*this is creating a copy of the hostname */
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(STRING_construct("<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n<BlockList>"));
+    set_expected_calls_for_parallel_workers_create(2);
+
+    /*404 is not retried*/
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    set_expected_calls_for_parallel_take_block();
+    set_expected_calls_for_parallel_put_block_attempt(&FourHundredFour, HTTPAPIEX_OK);
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*this is the blockID string*/
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG)); /*this is copying the response of the failed block for the caller*/
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_build(testValidBufferHandle, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    set_expected_calls_for_parallel_no_more_blocks();
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));
+
+    /*no Put Block List*/
+    set_expected_calls_for_parallel_workers_destroy(2);
+    set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 2, 0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+    ASSERT_ARE_EQUAL(int, 404, httpResponse);
+    ASSERT_ARE_EQUAL(size_t, 1, context.toUpload, "the second block shall not have been requested");
+
+    ///cleanup
+    gballoc_free(content);
+}
+
+/*Tests_SRS_BLOB_31_001: [ If `parallelBlocks` is greater than 1, `Blob_UploadMultipleBlocksFromSasUri` shall upload up to `parallelBlocks` blocks at the same time, each on its own connection. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_parallel_uploads_on_calling_thread_when_ThreadAPI_Create_fails)
+{
+    ///arrange
+    const unsigned int TwoHundredOne = 201;
+    unsigned char c = '3';
+    context.size = 1;
+    context.source = &c;
+    context.toUpload = context.size;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)); /*this is creating a copy of the hostname */
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(STRING_construct("<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n<BlockList>"));
+    set_expected_calls_for_parallel_workers_create(2);
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(THREADAPI_ERROR);
+
+    /*workers[0] uploads the block*/
+    set_expected_calls_for_parallel_take_block();
+    set_expected_calls_for_parallel_put_block_attempt(&TwoHundredOne, HTTPAPIEX_OK);
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*this is the blockID string*/
+    set_expected_calls_for_parallel_no_more_blocks();
+
+    set_expected_calls_for_block_ids(0, 1);
+    set_expected_calls_for_parallel_workers_destroy(2);
+    set_expected_calls_for_put_block_list();
+    set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 2, 0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+}
+
+/*Tests_SRS_BLOB_99_004: [ If `getDataCallback` returns `IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_RESULT_ABORT`, then `Blob_UploadMultipleBlocksFromSasUri` shall exit the loop and return `BLOB_ABORTED`. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_parallel_returns_BLOB_ABORTED_when_callback_aborts_after_5_blocks)
+{
+    ///arrange
+    BLOB_UPLOAD_CONTEXT_FAKE fakeContext;
+    fakeContext.blockSent = 0;
+    fakeContext.blockSize = 1;
+    fakeContext.blocksCount = 10;
+    fakeContext.fakeData = NULL;
+    fakeContext.abortOnBlockNumber = 5;
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetFakeData_Callback, &fakeContext, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 4, 0);
 
     ///assert
     ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_ABORTED, result);
@@ -1449,4 +1810,147 @@ TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_returns_BLOB_ABORTED_when_call
     gballoc_free(fakeContext.fakeData);
 }
 
+/*Tests_SRS_BLOB_99_003: [ If `getDataCallback` returns more than 50000 blocks, then `Blob_UploadMultipleBlocksFromSasUri` shall fail and return `BLOB_INVALID_ARG`. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_parallel_when_blockCount_is_one_over_maximum_fails)
+{
+    ///arrange
+    BLOB_UPLOAD_CONTEXT_FAKE fakeContext;
+    fakeContext.blockSent = 0;
+    fakeContext.blockSize = 1;
+    fakeContext.blocksCount = MAX_BLOCK_COUNT + 1;
+    fakeContext.fakeData = NULL;
+    fakeContext.abortOnBlockNumber = -1;
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetFakeData_Callback, &fakeContext, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 4, 0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
+
+    ///cleanup
+    gballoc_free(fakeContext.fakeData);
+}
+
+/*Tests_SRS_BLOB_31_007: [ If `uploadedBlockCount` is bigger than 50000 then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_with_uploadedBlockCount_over_maximum_fails)
+{
+    ///arrange
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, MAX_BLOCK_COUNT + 1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
+}
+
+/*Tests_SRS_BLOB_31_008: [ The IDs of the first `uploadedBlockCount` blocks shall be added to the block list without uploading these blocks again, and the first block returned by `getDataCallbackEx` shall be block number `uploadedBlockCount`. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_resumes_after_uploaded_blocks)
+{
+    ///arrange
+    unsigned char c = '3';
+    context.size = 1;
+    context.source = &c;
+    context.toUpload = context.size;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)); /*this is creating a copy of the hostname */
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(STRING_construct("<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n<BlockList>"));
+    set_expected_calls_for_block_ids(0, 2); /*these blocks were uploaded before*/
+
+    /*the block returned by the callback is block 2*/
+    STRICT_EXPECTED_CALL(BUFFER_create(&c, 1));
+    STRICT_EXPECTED_CALL(Azure_Base64_Encode_Bytes(IGNORED_PTR_ARG, 6))
+        .ValidateArgumentBuffer(1, "     2", 6);
+    STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "<Latest>"));
+    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "</Latest>"));
+    STRICT_EXPECTED_CALL(STRING_construct("/something?a=b")); /*this is building the relativePath*/
+    STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "&comp=block&blockid="));
+    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PUT, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG, &httpResponse, NULL, testValidBufferHandle))
+        .CopyOutArgumentBuffer_statusCode(&TwoHundred, sizeof(TwoHundred));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*this is unbuilding the relativePath*/
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*this is the blockID string*/
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG)); /*this was the content to be uploaded*/
+
+    set_expected_calls_for_put_block_list();
+    set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 2);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+}
+
+/*Tests_SRS_BLOB_31_008: [ The IDs of the first `uploadedBlockCount` blocks shall be added to the block list without uploading these blocks again, and the first block returned by `getDataCallbackEx` shall be block number `uploadedBlockCount`. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_puts_block_list_when_all_blocks_were_uploaded)
+{
+    ///arrange
+    context.size = 0;
+    context.source = NULL;
+    context.toUpload = 0;
+    httpResponse = 404;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)); /*this is creating a copy of the hostname */
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(STRING_construct("<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n<BlockList>"));
+    set_expected_calls_for_block_ids(0, 3);
+    set_expected_calls_for_put_block_list();
+    set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 1, 3);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+    ASSERT_ARE_EQUAL(int, 200, httpResponse);
+}
+
+/*Tests_SRS_BLOB_31_008: [ The IDs of the first `uploadedBlockCount` blocks shall be added to the block list without uploading these blocks again, and the first block returned by `getDataCallbackEx` shall be block number `uploadedBlockCount`. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_parallel_resumes_after_uploaded_blocks)
+{
+    ///arrange
+    const unsigned int TwoHundredOne = 201;
+    unsigned char c = '3';
+    context.size = 1;
+    context.source = &c;
+    context.toUpload = context.size;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)); /*this is creating a copy of the hostname */
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(STRING_construct("<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n<BlockList>"));
+    set_expected_calls_for_block_ids(0, 1); /*this block was uploaded before*/
+    set_expected_calls_for_parallel_workers_create(2);
+
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_build(IGNORED_PTR_ARG, &c, 1));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Azure_Base64_Encode_Bytes(IGNORED_PTR_ARG, 6))
+        .ValidateArgumentBuffer(1, "     1", 6);
+    set_expected_calls_for_parallel_put_block_attempt(&TwoHundredOne, HTTPAPIEX_OK);
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*this is the blockID string*/
+    set_expected_calls_for_parallel_no_more_blocks();
+
+    set_expected_calls_for_parallel_no_more_blocks();
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));
+
+    set_expected_calls_for_block_ids(1, 2);
+    set_expected_calls_for_parallel_workers_destroy(2);
+    set_expected_calls_for_put_block_list();
+    set_expected_calls_for_Blob_UploadMultipleBlocksFromSasUri_cleanup();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", FileUpload_GetData_Callback, &context, &httpResponse, testValidBufferHandle, NULL, NULL, NULL, 2, 1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+}
+
 END_TEST_SUITE(blob_ut);
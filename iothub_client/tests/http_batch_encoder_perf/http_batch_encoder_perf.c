@@ -0,0 +1,278 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*compares the time it takes to encode a batch of messages, as the HTTP transport does when batching is on, with the encoder that
+concatenates one STRING per item (the one the transport used before http_batch_encoder) and with http_batch_encoder*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/azure_base64.h"
+#include "azure_c_shared_utility/map.h"
+#include "iothub_message.h"
+#include "internal/http_batch_encoder.h"
+
+#define MESSAGE_CONTENT_SIZE 256
+#define MESSAGE_PROPERTY_COUNT 3
+#define ENCODED_BYTES_PER_RUN (64 * 1024 * 1024)
+
+static const size_t BATCH_SIZES[] = { 1, 4, 16, 64, 256 };
+
+/*the concatenating encoder, kept here as the baseline*/
+static int legacy_concat_properties(STRING_HANDLE item, MAP_HANDLE map)
+{
+    int result;
+    const char* const* keys;
+    const char* const* values;
+    size_t count;
+    if (Map_GetInternals(map, &keys, &values, &count) != MAP_OK)
+    {
+        result = 1;
+    }
+    else if (count == 0)
+    {
+        result = 0;
+    }
+    else if (STRING_concat(item, ",\"properties\":") != 0)
+    {
+        result = 1;
+    }
+    else
+    {
+        size_t i;
+        result = 0;
+        for (i = 0; (result == 0) && (i < count); i++)
+        {
+            result = ((STRING_concat(item, (i == 0) ? "{\"iothub-app-" : ",\"iothub-app-") == 0) &&
+                (STRING_concat(item, keys[i]) == 0) &&
+                (STRING_concat(item, "\":\"") == 0) &&
+                (STRING_concat(item, values[i]) == 0) &&
+                (STRING_concat(item, "\"") == 0)) ? 0 : 1;
+        }
+        if (result == 0 && STRING_concat(item, "}") != 0)
+        {
+            result = 1;
+        }
+    }
+    return result;
+}
+
+static STRING_HANDLE legacy_make_item(IOTHUB_MESSAGE_HANDLE message)
+{
+    STRING_HANDLE result = STRING_construct("{\"body\":\"");
+    const unsigned char* source;
+    size_t size;
+    if (result != NULL)
+    {
+        STRING_HANDLE encoded;
+        if (IoTHubMessage_GetByteArray(message, &source, &size) != IOTHUB_MESSAGE_OK ||
+            (encoded = Azure_Base64_Encode_Bytes(source, size)) == NULL)
+        {
+            STRING_delete(result);
+            result = NULL;
+        }
+        else
+        {
+            if (!((STRING_concat_with_STRING(result, encoded) == 0) &&
+                (STRING_concat(result, "\"") == 0) &&
+                (legacy_concat_properties(result, IoTHubMessage_Properties(message)) == 0) &&
+                (STRING_concat(result, "},") == 0)))
+            {
+                STRING_delete(result);
+                result = NULL;
+            }
+            STRING_delete(encoded);
+        }
+    }
+    return result;
+}
+
+static BUFFER_HANDLE legacy_encode_batch(IOTHUB_MESSAGE_HANDLE* messages, size_t count)
+{
+    BUFFER_HANDLE result = NULL;
+    STRING_HANDLE payload = STRING_construct("[");
+    if (payload != NULL)
+    {
+        size_t i;
+        for (i = 0; i < count; i++)
+        {
+            STRING_HANDLE item = legacy_make_item(messages[i]);
+            if (item == NULL)
+            {
+                break;
+            }
+            (void)STRING_concat_with_STRING(payload, item);
+            STRING_delete(item);
+        }
+        if (i == count)
+        {
+            /*the transport then copies the payload into the BUFFER of the request*/
+            size_t length = STRING_length(payload);
+            if ((result = BUFFER_create((const unsigned char*)STRING_c_str(payload), length)) != NULL)
+            {
+                BUFFER_u_char(result)[length - 1] = ']';
+            }
+        }
+        STRING_delete(payload);
+    }
+    return result;
+}
+
+static BUFFER_HANDLE streaming_encode_batch(IOTHUB_MESSAGE_HANDLE* messages, size_t count)
+{
+    BUFFER_HANDLE result;
+    size_t payloadSize = 1;
+    size_t i;
+    for (i = 0; i < count; i++)
+    {
+        size_t encodedSize;
+        size_t messageSize;
+        if (http_batch_encoder_measure(messages[i], &encodedSize, &messageSize) != 0)
+        {
+            break;
+        }
+        payloadSize += encodedSize;
+    }
+
+    if (i < count || (result = BUFFER_new()) == NULL)
+    {
+        result = NULL;
+    }
+    else if (BUFFER_pre_build(result, payloadSize) != 0)
+    {
+        BUFFER_delete(result);
+        result = NULL;
+    }
+    else
+    {
+        unsigned char* destination = BUFFER_u_char(result);
+        size_t remaining = payloadSize - 1;
+        *destination++ = '[';
+        for (i = 0; i < count; i++)
+        {
+            size_t written = http_batch_encoder_write(messages[i], destination, remaining);
+            destination += written;
+            remaining -= written;
+        }
+        destination[-1] = ']';
+    }
+    return result;
+}
+
+typedef BUFFER_HANDLE(*ENCODE_BATCH)(IOTHUB_MESSAGE_HANDLE* messages, size_t count);
+
+/*returns the average time, in microseconds, it takes to encode a batch of count messages, or a negative value on failure*/
+static double time_encoder(ENCODE_BATCH encode, IOTHUB_MESSAGE_HANDLE* messages, size_t count, size_t* payloadLength)
+{
+    double result;
+    size_t runs = ENCODED_BYTES_PER_RUN / (count * MESSAGE_CONTENT_SIZE);
+    size_t i;
+    clock_t start = clock();
+    *payloadLength = 0;
+    for (i = 0; i < runs; i++)
+    {
+        BUFFER_HANDLE payload = encode(messages, count);
+        if (payload == NULL)
+        {
+            break;
+        }
+        *payloadLength = BUFFER_length(payload);
+        BUFFER_delete(payload);
+    }
+    result = (i < runs) ? -1.0 : (double)(clock() - start) * 1000000.0 / CLOCKS_PER_SEC / (double)runs;
+    return result;
+}
+
+int main(void)
+{
+    int result;
+    size_t maxBatchSize = BATCH_SIZES[sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]) - 1];
+    IOTHUB_MESSAGE_HANDLE* messages;
+
+    if (platform_init() != 0)
+    {
+        (void)printf("platform_init failed\r\n");
+        result = 1;
+    }
+    else
+    {
+        if ((messages = (IOTHUB_MESSAGE_HANDLE*)calloc(maxBatchSize, sizeof(IOTHUB_MESSAGE_HANDLE))) == NULL)
+        {
+            (void)printf("unable to allocate the messages\r\n");
+            result = 1;
+        }
+        else
+        {
+            unsigned char content[MESSAGE_CONTENT_SIZE];
+            size_t i;
+            size_t j;
+            result = 0;
+            for (i = 0; i < sizeof(content); i++)
+            {
+                content[i] = (unsigned char)(i * 31);
+            }
+
+            for (i = 0; (result == 0) && (i < maxBatchSize); i++)
+            {
+                if ((messages[i] = IoTHubMessage_CreateFromByteArray(content, sizeof(content))) == NULL)
+                {
+                    result = 1;
+                }
+                else
+                {
+                    for (j = 0; (result == 0) && (j < MESSAGE_PROPERTY_COUNT); j++)
+                    {
+                        char key[16];
+                        (void)sprintf(key, "property%lu", (unsigned long)j);
+                        if (Map_AddOrUpdate(IoTHubMessage_Properties(messages[i]), key, "a property value") != MAP_OK)
+                        {
+                            result = 1;
+                        }
+                    }
+                }
+            }
+
+            if (result != 0)
+            {
+                (void)printf("unable to create the messages\r\n");
+            }
+            else
+            {
+                (void)printf("%10s %14s %16s %16s %8s\r\n", "messages", "payload bytes", "concatenating us", "streaming us", "speedup");
+                for (i = 0; (result == 0) && (i < sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0])); i++)
+                {
+                    size_t legacyLength;
+                    size_t streamingLength;
+                    double legacy = time_encoder(legacy_encode_batch, messages, BATCH_SIZES[i], &legacyLength);
+                    double streaming = time_encoder(streaming_encode_batch, messages, BATCH_SIZES[i], &streamingLength);
+                    if (legacy < 0 || streaming < 0 || legacyLength != streamingLength)
+                    {
+                        (void)printf("encoding a batch of %lu messages failed\r\n", (unsigned long)BATCH_SIZES[i]);
+                        result = 1;
+                    }
+                    else
+                    {
+                        (void)printf("%10lu %14lu %16.2f %16.2f %7.2fx\r\n", (unsigned long)BATCH_SIZES[i], (unsigned long)streamingLength,
+                            legacy, streaming, (streaming > 0) ? legacy / streaming : 0.0);
+                    }
+                }
+            }
+
+            for (i = 0; i < maxBatchSize; i++)
+            {
+                if (messages[i] != NULL)
+                {
+                    IoTHubMessage_Destroy(messages[i]);
+                }
+            }
+            free(messages);
+        }
+        platform_deinit();
+    }
+    return result;
+}
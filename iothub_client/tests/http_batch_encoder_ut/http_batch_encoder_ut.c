@@ -0,0 +1,379 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#endif
+
+#include "testrunnerswitcher.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umocktypes_charptr.h"
+#include "umock_c/umocktypes_stdint.h"
+#include "umock_c/umocktypes_bool.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/map.h"
+#include "iothub_message.h"
+#undef ENABLE_MOCKS
+
+#include "internal/http_batch_encoder.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+// Data definitions
+
+#define TEST_MAP_HANDLE                     (MAP_HANDLE)0x4441
+
+static const char* const TEST_PROPERTY_KEYS[] = { "k1", "k2" };
+static const char* const TEST_PROPERTY_VALUES[] = { "v1", "value2" };
+
+/*stands in for a message, the IOTHUB_MESSAGE_HANDLEs given to the encoder point to one of these*/
+typedef struct TEST_MESSAGE_TAG
+{
+    IOTHUBMESSAGE_CONTENT_TYPE content_type;
+    const char* content;
+    size_t property_count;
+} TEST_MESSAGE;
+
+static TEST_MESSAGE* g_current_message;
+
+// Helpers
+
+static IOTHUB_MESSAGE_HANDLE set_test_message(TEST_MESSAGE* message, IOTHUBMESSAGE_CONTENT_TYPE content_type, const char* content, size_t property_count)
+{
+    message->content_type = content_type;
+    message->content = content;
+    message->property_count = property_count;
+    g_current_message = message;
+    return (IOTHUB_MESSAGE_HANDLE)message;
+}
+
+/*measures and writes message, checks the item is the expected one and the size is the one measured*/
+static void assert_encoded_item(IOTHUB_MESSAGE_HANDLE message, const char* expected_item)
+{
+    unsigned char destination[256];
+    size_t encoded_size;
+    size_t message_size;
+
+    ASSERT_ARE_EQUAL(int, 0, http_batch_encoder_measure(message, &encoded_size, &message_size));
+    ASSERT_ARE_EQUAL(size_t, strlen(expected_item), encoded_size);
+
+    size_t written = http_batch_encoder_write(message, destination, sizeof(destination));
+    ASSERT_ARE_EQUAL(size_t, encoded_size, written);
+    destination[written] = '\0';
+    ASSERT_ARE_EQUAL(char_ptr, expected_item, (const char*)destination);
+}
+
+static IOTHUBMESSAGE_CONTENT_TYPE my_IoTHubMessage_GetContentType(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return ((TEST_MESSAGE*)iotHubMessageHandle)->content_type;
+}
+
+static IOTHUB_MESSAGE_RESULT my_IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const unsigned char** buffer, size_t* size)
+{
+    *buffer = (const unsigned char*)((TEST_MESSAGE*)iotHubMessageHandle)->content;
+    *size = strlen(((TEST_MESSAGE*)iotHubMessageHandle)->content);
+    return IOTHUB_MESSAGE_OK;
+}
+
+static const char* my_IoTHubMessage_GetString(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return ((TEST_MESSAGE*)iotHubMessageHandle)->content;
+}
+
+static MAP_RESULT my_Map_GetInternals(MAP_HANDLE handle, const char*const** keys, const char*const** values, size_t* count)
+{
+    (void)handle;
+    *keys = TEST_PROPERTY_KEYS;
+    *values = TEST_PROPERTY_VALUES;
+    *count = g_current_message->property_count;
+    return MAP_OK;
+}
+
+BEGIN_TEST_SUITE(http_batch_encoder_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    int result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(MAP_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUBMESSAGE_CONTENT_TYPE, int);
+
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetContentType, my_IoTHubMessage_GetContentType);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetByteArray, my_IoTHubMessage_GetByteArray);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetString, my_IoTHubMessage_GetString);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_Properties, TEST_MAP_HANDLE);
+    REGISTER_GLOBAL_MOCK_HOOK(Map_GetInternals, my_Map_GetInternals);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    g_current_message = NULL;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(http_batch_encoder_measure_with_NULL_message_fails)
+{
+    // arrange
+    size_t encoded_size;
+    size_t message_size;
+
+    // act
+    int result = http_batch_encoder_measure(NULL, &encoded_size, &message_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(http_batch_encoder_measure_with_NULL_encoded_size_fails)
+{
+    // arrange
+    TEST_MESSAGE test_message;
+    IOTHUB_MESSAGE_HANDLE message = set_test_message(&test_message, IOTHUBMESSAGE_BYTEARRAY, "abc", 0);
+    size_t message_size;
+
+    // act
+    int result = http_batch_encoder_measure(message, NULL, &message_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(http_batch_encoder_measure_with_NULL_message_size_fails)
+{
+    // arrange
+    TEST_MESSAGE test_message;
+    IOTHUB_MESSAGE_HANDLE message = set_test_message(&test_message, IOTHUBMESSAGE_BYTEARRAY, "abc", 0);
+    size_t encoded_size;
+
+    // act
+    int result = http_batch_encoder_measure(message, &encoded_size, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(http_batch_encoder_measure_bytearray_message_succeeds)
+{
+    // arrange
+    TEST_MESSAGE test_message;
+    IOTHUB_MESSAGE_HANDLE message = set_test_message(&test_message, IOTHUBMESSAGE_BYTEARRAY, "abc", 0);
+    size_t encoded_size;
+    size_t message_size;
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(message));
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(message, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Properties(message));
+    STRICT_EXPECTED_CALL(Map_GetInternals(TEST_MAP_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    int result = http_batch_encoder_measure(message, &encoded_size, &message_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, strlen("{\"body\":\"YWJj\"},"), encoded_size);
+    ASSERT_ARE_EQUAL(size_t, 3 + MAXIMUM_PAYLOAD_OVERHEAD, message_size);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(http_batch_encoder_measure_counts_the_properties_towards_the_message_size)
+{
+    // arrange
+    TEST_MESSAGE test_message;
+    IOTHUB_MESSAGE_HANDLE message = set_test_message(&test_message, IOTHUBMESSAGE_BYTEARRAY, "abc", 2);
+    size_t encoded_size;
+    size_t message_size;
+
+    // act
+    int result = http_batch_encoder_measure(message, &encoded_size, &message_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 3 + MAXIMUM_PAYLOAD_OVERHEAD + (2 + 2 + MAXIMUM_PROPERTY_OVERHEAD) + (2 + 6 + MAXIMUM_PROPERTY_OVERHEAD), message_size);
+}
+
+TEST_FUNCTION(http_batch_encoder_measure_with_unknown_content_type_fails)
+{
+    // arrange
+    TEST_MESSAGE test_message;
+    IOTHUB_MESSAGE_HANDLE message = set_test_message(&test_message, IOTHUBMESSAGE_UNKNOWN, "abc", 0);
+    size_t encoded_size;
+    size_t message_size;
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(message));
+
+    // act
+    int result = http_batch_encoder_measure(message, &encoded_size, &message_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(http_batch_encoder_measure_fails_when_Map_GetInternals_fails)
+{
+    // arrange
+    TEST_MESSAGE test_message;
+    IOTHUB_MESSAGE_HANDLE message = set_test_message(&test_message, IOTHUBMESSAGE_BYTEARRAY, "abc", 0);
+    size_t encoded_size;
+    size_t message_size;
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(message));
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(message, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Properties(message));
+    STRICT_EXPECTED_CALL(Map_GetInternals(TEST_MAP_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(MAP_ERROR);
+
+    // act
+    int result = http_batch_encoder_measure(message, &encoded_size, &message_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(http_batch_encoder_measure_string_message_with_non_ASCII_characters_fails)
+{
+    // arrange
+    TEST_MESSAGE test_message;
+    IOTHUB_MESSAGE_HANDLE message = set_test_message(&test_message, IOTHUBMESSAGE_STRING, "caf\xC3\xA9", 0);
+    size_t encoded_size;
+    size_t message_size;
+
+    // act
+    int result = http_batch_encoder_measure(message, &encoded_size, &message_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(http_batch_encoder_write_with_NULL_message_fails)
+{
+    // arrange
+    unsigned char destination[64];
+
+    // act
+    size_t result = http_batch_encoder_write(NULL, destination, sizeof(destination));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(http_batch_encoder_write_with_NULL_destination_fails)
+{
+    // arrange
+    TEST_MESSAGE test_message;
+    IOTHUB_MESSAGE_HANDLE message = set_test_message(&test_message, IOTHUBMESSAGE_BYTEARRAY, "abc", 0);
+
+    // act
+    size_t result = http_batch_encoder_write(message, NULL, 64);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(http_batch_encoder_write_bytearray_message_is_base64_encoded)
+{
+    // arrange
+    TEST_MESSAGE test_message;
+
+    // act & assert
+    assert_encoded_item(set_test_message(&test_message, IOTHUBMESSAGE_BYTEARRAY, "abc", 0), "{\"body\":\"YWJj\"},");
+    assert_encoded_item(set_test_message(&test_message, IOTHUBMESSAGE_BYTEARRAY, "ab", 0), "{\"body\":\"YWI=\"},");
+    assert_encoded_item(set_test_message(&test_message, IOTHUBMESSAGE_BYTEARRAY, "a", 0), "{\"body\":\"YQ==\"},");
+    assert_encoded_item(set_test_message(&test_message, IOTHUBMESSAGE_BYTEARRAY, "", 0), "{\"body\":\"\"},");
+}
+
+TEST_FUNCTION(http_batch_encoder_write_string_message_is_JSON_encoded)
+{
+    // arrange
+    TEST_MESSAGE test_message;
+    IOTHUB_MESSAGE_HANDLE message = set_test_message(&test_message, IOTHUBMESSAGE_STRING, "a\"b\\c/d\n", 0);
+
+    // act & assert
+    assert_encoded_item(message, "{\"body\":\"a\\\"b\\\\c\\/d\\u000A\",\"base64Encoded\":false},");
+}
+
+TEST_FUNCTION(http_batch_encoder_write_message_with_properties_succeeds)
+{
+    // arrange
+    TEST_MESSAGE test_message;
+
+    // act & assert
+    assert_encoded_item(set_test_message(&test_message, IOTHUBMESSAGE_BYTEARRAY, "abc", 1),
+        "{\"body\":\"YWJj\",\"properties\":{\"iothub-app-k1\":\"v1\"}},");
+    assert_encoded_item(set_test_message(&test_message, IOTHUBMESSAGE_STRING, "abc", 2),
+        "{\"body\":\"abc\",\"base64Encoded\":false,\"properties\":{\"iothub-app-k1\":\"v1\",\"iothub-app-k2\":\"value2\"}},");
+}
+
+TEST_FUNCTION(http_batch_encoder_write_fails_when_the_item_does_not_fit)
+{
+    // arrange
+    TEST_MESSAGE test_message;
+    IOTHUB_MESSAGE_HANDLE message = set_test_message(&test_message, IOTHUBMESSAGE_BYTEARRAY, "abc", 1);
+    unsigned char destination[64];
+    size_t encoded_size;
+    size_t message_size;
+    ASSERT_ARE_EQUAL(int, 0, http_batch_encoder_measure(message, &encoded_size, &message_size));
+
+    // act
+    size_t result = http_batch_encoder_write(message, destination, encoded_size - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
+END_TEST_SUITE(http_batch_encoder_ut)
@@ -33,6 +33,7 @@ static void* my_gballoc_calloc(size_t nmemb, size_t size)
 #include "umock_c/umock_c_negative_tests.h"
 #include "umock_c/umocktypes.h"
 #include "umock_c/umocktypes_c.h"
+#include "umock_c/umocktypes_bool.h"
 
 #include "iothub_client_options.h"
 
@@ -47,6 +48,7 @@ static void* my_gballoc_calloc(size_t nmemb, size_t size)
 #include "azure_c_shared_utility/shared_util_options.h"
 
 #include "internal/blob.h"
+#include "internal/blob_file_source.h"
 #include "internal/iothub_client_authorization.h"
 
 #include "parson.h"
@@ -80,6 +82,9 @@ static const char* const TEST_CERT = "test_cert";
 static const unsigned char* TEST_SOURCE = (const unsigned char*)0x3;
 static const size_t TEST_SOURCE_LENGTH = 3;
 static const char* const TEST_DESTINATION_FILENAME = "text.txt";
+static const char* const TEST_FILE_PATH = "/var/log/text.txt";
+static const char* const TEST_CHECKPOINT_PATH = "/var/log/text.txt.upload";
+static BLOB_FILE_SOURCE_HANDLE TEST_FILE_SOURCE = (BLOB_FILE_SOURCE_HANDLE)0x4244;
 
 #ifdef __cplusplus
 extern "C"
@@ -316,6 +321,10 @@ typedef struct BLOB_UPLOAD_CONTEXT_TAG
 
 BLOB_UPLOAD_CONTEXT context;
 
+/*what Blob_UploadMultipleBlocksFromSasUri is expected to receive*/
+static size_t g_parallel_blocks;
+static unsigned int g_uploaded_block_count;
+
 static IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_RESULT FileUpload_GetData_Callback(IOTHUB_CLIENT_FILE_UPLOAD_RESULT result, unsigned char const ** data, size_t* size, void* _uploadContext)
 {
     BLOB_UPLOAD_CONTEXT* uploadContext = (BLOB_UPLOAD_CONTEXT*) _uploadContext;
@@ -480,6 +489,10 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_stdint_register_types");
 
     umocktypes_charptr_register_types();
+    result = umocktypes_c_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_c_register_types");
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_bool_register_types");
 
     REGISTER_TYPE(HTTPAPI_RESULT, HTTPAPI_RESULT);
     REGISTER_TYPE(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT);
@@ -498,6 +511,11 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_AUTHORIZATION_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(BLOB_FILE_SOURCE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_FILE_UPLOAD_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(unsigned char const **, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(size_t*, void*);
 
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
@@ -570,6 +588,11 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_RETURN(Blob_UploadMultipleBlocksFromSasUri, BLOB_OK);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(Blob_UploadMultipleBlocksFromSasUri, BLOB_ERROR);
 
+    REGISTER_GLOBAL_MOCK_RETURN(blob_file_source_create, TEST_FILE_SOURCE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(blob_file_source_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(blob_file_source_get_uploaded_block_count, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(blob_file_source_has_failed, false);
+
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(mallocAndStrcpy_s, MU_FAILURE);
     REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, my_mallocAndStrcpy_s);
 }
@@ -584,6 +607,8 @@ TEST_SUITE_CLEANUP(TestClassCleanup)
 static void reset_test_data()
 {
     memset(&context, 0, sizeof(context));
+    g_parallel_blocks = 1;
+    g_uploaded_block_count = 0;
 }
 
 TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
@@ -732,7 +757,7 @@ static void setup_Blob_UploadMultipleBlocksFromSasUri_mocks(IOTHUB_CREDENTIAL_TY
     if (BLOB_OK != blob_result)
     {
         status_code = 404;
-        STRICT_EXPECTED_CALL(Blob_UploadMultipleBlocksFromSasUri(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(Blob_UploadMultipleBlocksFromSasUri(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, g_parallel_blocks, g_uploaded_block_count))
             .CopyOutArgumentBuffer_httpStatus(&status_code, sizeof(status_code))
             .SetReturn(blob_result);
         STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
@@ -746,7 +771,7 @@ static void setup_Blob_UploadMultipleBlocksFromSasUri_mocks(IOTHUB_CREDENTIAL_TY
     else
     {
         status_code = 200;
-        STRICT_EXPECTED_CALL(Blob_UploadMultipleBlocksFromSasUri(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(Blob_UploadMultipleBlocksFromSasUri(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, g_parallel_blocks, g_uploaded_block_count))
             .CopyOutArgumentBuffer_httpStatus(&status_code, sizeof(status_code)).CallCannotFail();
 
         if (null_buffer)
@@ -1436,4 +1461,203 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SetOption_x509_timeout_succeeds)
     IoTHubClient_LL_UploadToBlob_Destroy(h);
 }
 
+/*Tests_SRS_IOTHUBCLIENT_LL_31_142: [ `blob_upload_parallel_blocks` - shall set the number of blocks uploaded at the same time; 0 shall be rejected with `IOTHUB_CLIENT_INVALID_ARG`. ]*/
+TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SetOption_parallel_blocks_succeeds)
+{
+    //arrange
+    size_t parallelBlocks = 4;
+
+    setup_uploadtoblob_create_mocks(IOTHUB_CREDENTIAL_TYPE_X509);
+    IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE h = IoTHubClient_LL_UploadToBlob_Create(&TEST_CONFIG_SAS, TEST_AUTH_HANDLE);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_UploadToBlob_SetOption(h, OPTION_BLOB_UPLOAD_PARALLEL_BLOCKS, &parallelBlocks);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_UploadToBlob_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_31_142: [ `blob_upload_parallel_blocks` - shall set the number of blocks uploaded at the same time; 0 shall be rejected with `IOTHUB_CLIENT_INVALID_ARG`. ]*/
+TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SetOption_parallel_blocks_zero_fails)
+{
+    //arrange
+    size_t parallelBlocks = 0;
+
+    setup_uploadtoblob_create_mocks(IOTHUB_CREDENTIAL_TYPE_X509);
+    IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE h = IoTHubClient_LL_UploadToBlob_Create(&TEST_CONFIG_SAS, TEST_AUTH_HANDLE);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_UploadToBlob_SetOption(h, OPTION_BLOB_UPLOAD_PARALLEL_BLOCKS, &parallelBlocks);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_UploadToBlob_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_31_150: [ `blob_upload_parallel_blocks` above 16 shall be rejected with `IOTHUB_CLIENT_INVALID_ARG`. ]*/
+TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_SetOption_parallel_blocks_above_maximum_fails)
+{
+    //arrange
+    size_t parallelBlocks = 17;
+
+    setup_uploadtoblob_create_mocks(IOTHUB_CREDENTIAL_TYPE_X509);
+    IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE h = IoTHubClient_LL_UploadToBlob_Create(&TEST_CONFIG_SAS, TEST_AUTH_HANDLE);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_UploadToBlob_SetOption(h, OPTION_BLOB_UPLOAD_PARALLEL_BLOCKS, &parallelBlocks);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_UploadToBlob_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_31_143: [ If handle, destinationFileName or filePath is NULL then IoTHubClient_LL_UploadFileToBlob shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_UploadFileToBlob_Impl_handle_NULL_fails)
+{
+    //arrange
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_UploadFileToBlob_Impl(NULL, TEST_DESTINATION_FILENAME, TEST_FILE_PATH, TEST_CHECKPOINT_PATH);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_31_143: [ If handle, destinationFileName or filePath is NULL then IoTHubClient_LL_UploadFileToBlob shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_UploadFileToBlob_Impl_filePath_NULL_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE h = IoTHubClient_LL_UploadToBlob_Create(&TEST_CONFIG_SAS, TEST_AUTH_HANDLE);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_UploadFileToBlob_Impl(h, TEST_DESTINATION_FILENAME, NULL, TEST_CHECKPOINT_PATH);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_UploadToBlob_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_31_145: [ If blob_file_source_create fails then IoTHubClient_LL_UploadFileToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_UploadFileToBlob_Impl_file_source_create_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE h = IoTHubClient_LL_UploadToBlob_Create(&TEST_CONFIG_SAS, TEST_AUTH_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION_FILENAME))
+        .SetReturn(NULL);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_UploadFileToBlob_Impl(h, TEST_DESTINATION_FILENAME, TEST_FILE_PATH, TEST_CHECKPOINT_PATH);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_UploadToBlob_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_31_144: [ IoTHubClient_LL_UploadFileToBlob shall open the file and its checkpoint by calling blob_file_source_create. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_31_146: [ IoTHubClient_LL_UploadFileToBlob shall upload the blocks that follow the ones reported by blob_file_source_get_uploaded_block_count, one at a time when checkpointPath is not NULL. ]*/
+TEST_FUNCTION(IoTHubClient_LL_UploadFileToBlob_Impl_resumes_one_block_at_a_time)
+{
+    //arrange
+    size_t parallelBlocks = 4;
+    IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE h = IoTHubClient_LL_UploadToBlob_Create(&TEST_CONFIG_SAS, TEST_AUTH_HANDLE);
+    (void)IoTHubClient_LL_UploadToBlob_SetOption(h, OPTION_BLOB_UPLOAD_PARALLEL_BLOCKS, &parallelBlocks);
+    umock_c_reset_all_calls();
+
+    g_uploaded_block_count = 2;
+    STRICT_EXPECTED_CALL(blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION_FILENAME));
+    STRICT_EXPECTED_CALL(blob_file_source_get_uploaded_block_count(TEST_FILE_SOURCE))
+        .SetReturn(g_uploaded_block_count);
+    setup_upload_blocks_mocks(IOTHUB_CREDENTIAL_TYPE_SAS_TOKEN, false, false, false, BLOB_OK, false);
+    STRICT_EXPECTED_CALL(blob_file_source_get_data(FILE_UPLOAD_OK, NULL, NULL, TEST_FILE_SOURCE));
+    STRICT_EXPECTED_CALL(blob_file_source_has_failed(TEST_FILE_SOURCE));
+    STRICT_EXPECTED_CALL(blob_file_source_destroy(TEST_FILE_SOURCE));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_UploadFileToBlob_Impl(h, TEST_DESTINATION_FILENAME, TEST_FILE_PATH, TEST_CHECKPOINT_PATH);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_UploadToBlob_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_31_146: [ IoTHubClient_LL_UploadFileToBlob shall upload the blocks that follow the ones reported by blob_file_source_get_uploaded_block_count, one at a time when checkpointPath is not NULL. ]*/
+TEST_FUNCTION(IoTHubClient_LL_UploadFileToBlob_Impl_without_checkpoint_uploads_blocks_in_parallel)
+{
+    //arrange
+    size_t parallelBlocks = 4;
+    IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE h = IoTHubClient_LL_UploadToBlob_Create(&TEST_CONFIG_SAS, TEST_AUTH_HANDLE);
+    (void)IoTHubClient_LL_UploadToBlob_SetOption(h, OPTION_BLOB_UPLOAD_PARALLEL_BLOCKS, &parallelBlocks);
+    umock_c_reset_all_calls();
+
+    g_parallel_blocks = parallelBlocks;
+    STRICT_EXPECTED_CALL(blob_file_source_create(TEST_FILE_PATH, NULL, TEST_DESTINATION_FILENAME));
+    STRICT_EXPECTED_CALL(blob_file_source_get_uploaded_block_count(TEST_FILE_SOURCE));
+    setup_upload_blocks_mocks(IOTHUB_CREDENTIAL_TYPE_SAS_TOKEN, false, false, false, BLOB_OK, false);
+    STRICT_EXPECTED_CALL(blob_file_source_get_data(FILE_UPLOAD_OK, NULL, NULL, TEST_FILE_SOURCE));
+    STRICT_EXPECTED_CALL(blob_file_source_has_failed(TEST_FILE_SOURCE));
+    STRICT_EXPECTED_CALL(blob_file_source_destroy(TEST_FILE_SOURCE));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_UploadFileToBlob_Impl(h, TEST_DESTINATION_FILENAME, TEST_FILE_PATH, NULL);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_UploadToBlob_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_31_147: [ If reading the file failed then IoTHubClient_LL_UploadFileToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_UploadFileToBlob_Impl_read_failure_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE h = IoTHubClient_LL_UploadToBlob_Create(&TEST_CONFIG_SAS, TEST_AUTH_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(blob_file_source_create(TEST_FILE_PATH, TEST_CHECKPOINT_PATH, TEST_DESTINATION_FILENAME));
+    STRICT_EXPECTED_CALL(blob_file_source_get_uploaded_block_count(TEST_FILE_SOURCE));
+    setup_upload_blocks_mocks(IOTHUB_CREDENTIAL_TYPE_SAS_TOKEN, false, false, false, BLOB_OK, false);
+    STRICT_EXPECTED_CALL(blob_file_source_get_data(FILE_UPLOAD_OK, NULL, NULL, TEST_FILE_SOURCE));
+    STRICT_EXPECTED_CALL(blob_file_source_has_failed(TEST_FILE_SOURCE))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(blob_file_source_destroy(TEST_FILE_SOURCE));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_UploadFileToBlob_Impl(h, TEST_DESTINATION_FILENAME, TEST_FILE_PATH, TEST_CHECKPOINT_PATH);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_UploadToBlob_Destroy(h);
+}
+
 END_TEST_SUITE(iothubclient_ll_uploadtoblob_ut)
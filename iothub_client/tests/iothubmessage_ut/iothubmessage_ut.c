@@ -38,6 +38,7 @@ static void my_gballoc_free(void* ptr)
 #undef ENABLE_MOCKS
 
 #include "iothub_message.h"
+#include "internal/iothub_message_pool.h"
 #include "real_strings.h"
 
 #ifdef __cplusplus
@@ -449,6 +450,130 @@ TEST_FUNCTION(IoTHubMessage_CreateFromByteArray_fails)
     umock_c_negative_tests_deinit();
 }
 
+static size_t g_payload_release_count;
+static void test_payload_release_callback(const unsigned char* byteArray, size_t size, void* context)
+{
+    (void)byteArray;
+    (void)size;
+    (void)context;
+    g_payload_release_count++;
+}
+
+TEST_FUNCTION(IoTHubMessage_CreateFromByteArrayNoCopy_happy_path)
+{
+    // arrange
+    const unsigned char* buffer;
+    size_t size;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG));
+
+    //act
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArrayNoCopy(c, 1, test_payload_release_callback, NULL);
+
+    //assert
+    ASSERT_IS_NOT_NULL(h);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_BYTEARRAY, IoTHubMessage_GetContentType(h));
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, IoTHubMessage_GetByteArray(h, &buffer, &size));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)c, (void*)buffer);
+    ASSERT_ARE_EQUAL(size_t, 1, size);
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_CreateFromByteArrayNoCopy_fails_when_size_non_zero_buffer_NULL)
+{
+    //arrange
+
+    //act
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArrayNoCopy(NULL, 1, test_payload_release_callback, NULL);
+
+    //assert
+    ASSERT_IS_NULL(h);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubMessage_CreateFromByteArrayNoCopy_fails)
+{
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    // arrange
+    g_payload_release_count = 0;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG));
+
+    umock_c_negative_tests_snapshot();
+
+    //act
+    size_t count = umock_c_negative_tests_call_count();
+    for (size_t index = 0; index < count; index++)
+    {
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(index);
+
+        char tmp_msg[64];
+        sprintf(tmp_msg, "IoTHubMessage_CreateFromByteArrayNoCopy failure in test %lu/%lu", (unsigned long)index, (unsigned long)count);
+        IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArrayNoCopy(c, 1, test_payload_release_callback, NULL);
+
+        //assert
+        ASSERT_IS_NULL(h, tmp_msg);
+    }
+
+    // a failed create leaves the buffer with the caller
+    ASSERT_ARE_EQUAL(size_t, 0, g_payload_release_count);
+
+    //cleanup
+    umock_c_negative_tests_deinit();
+}
+
+TEST_FUNCTION(IoTHubMessage_Clone_with_external_payload_shares_the_payload)
+{
+    //arrange
+    const unsigned char* buffer;
+    size_t size;
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArrayNoCopy(c, 1, test_payload_release_callback, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Map_Clone(IGNORED_PTR_ARG));
+
+    //act
+    IOTHUB_MESSAGE_HANDLE r = IoTHubMessage_Clone(h);
+
+    //assert
+    ASSERT_IS_NOT_NULL(r);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, IoTHubMessage_GetByteArray(r, &buffer, &size));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)c, (void*)buffer);
+    ASSERT_ARE_EQUAL(size_t, 1, size);
+
+    ///cleanup
+    IoTHubMessage_Destroy(r);
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_Destroy_with_external_payload_releases_it_with_the_last_message)
+{
+    //arrange
+    g_payload_release_count = 0;
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArrayNoCopy(c, 1, test_payload_release_callback, NULL);
+    IOTHUB_MESSAGE_HANDLE r = IoTHubMessage_Clone(h);
+    umock_c_reset_all_calls();
+
+    //act
+    IoTHubMessage_Destroy(h);
+    size_t release_count_after_first = g_payload_release_count;
+    IoTHubMessage_Destroy(r);
+
+    //assert
+    ASSERT_ARE_EQUAL(size_t, 0, release_count_after_first);
+    ASSERT_ARE_EQUAL(size_t, 1, g_payload_release_count);
+}
+
 /*Tests_SRS_IOTHUBMESSAGE_02_027: [IoTHubMessage_CreateFromString shall call STRING_construct passing source as parameter.] */
 /*Tests_SRS_IOTHUBMESSAGE_02_028: [IoTHubMessage_CreateFromString shall call Map_Create to create the message properties.] */
 /*Tests_SRS_IOTHUBMESSAGE_02_031: [Otherwise, IoTHubMessage_CreateFromString shall return a non-NULL handle.] */
@@ -872,6 +997,208 @@ TEST_FUNCTION(IoTHubMessage_Clone_with_STRING_fails)
     umock_c_negative_tests_deinit();
 }
 
+/*system property strings and diagnostic data freed by IoTHubMessage_Destroy, free(NULL) for the ones never set*/
+#define POOLED_MESSAGE_STRING_COUNT 11
+
+static void setup_free_of_unset_properties(size_t count)
+{
+    size_t index;
+    for (index = 0; index < count; index++)
+    {
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    }
+}
+
+TEST_FUNCTION(IoTHubMessage_CreatePool_with_0_messages_fails)
+{
+    //arrange
+
+    //act
+    IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(0);
+
+    //assert
+    ASSERT_IS_NULL(pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+}
+
+TEST_FUNCTION(IoTHubMessage_CreatePool_succeeds)
+{
+    //arrange
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    //act
+    IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(2);
+
+    //assert
+    ASSERT_IS_NOT_NULL(pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_DestroyPool(pool);
+}
+
+TEST_FUNCTION(IoTHubMessage_CreatePool_fails)
+{
+    //arrange
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    umock_c_negative_tests_snapshot();
+
+    //act
+    size_t count = umock_c_negative_tests_call_count();
+    for (size_t index = 0; index < count; index++)
+    {
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(index);
+
+        char tmp_msg[64];
+        sprintf(tmp_msg, "IoTHubMessage_CreatePool failure in test %lu/%lu", (unsigned long)index, (unsigned long)count);
+
+        IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(2);
+
+        //assert
+        ASSERT_IS_NULL(pool, tmp_msg);
+    }
+
+    //cleanup
+    umock_c_negative_tests_deinit();
+}
+
+TEST_FUNCTION(IoTHubMessage_CloneFromPool_with_NULL_pool_fails)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_MESSAGE_HANDLE r = IoTHubMessage_CloneFromPool(h, NULL);
+
+    //assert
+    ASSERT_IS_NULL(r);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_CloneFromPool_takes_the_header_and_strings_from_the_pool)
+{
+    //arrange
+    IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(1);
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetMessageId(h, TEST_MESSAGE_ID);
+    (void)IoTHubMessage_SetContentTypeSystemProperty(h, TEST_CONTENT_TYPE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(BUFFER_clone(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Map_Clone(IGNORED_PTR_ARG));
+
+    //act
+    IOTHUB_MESSAGE_HANDLE r = IoTHubMessage_CloneFromPool(h, pool);
+
+    //assert
+    ASSERT_IS_NOT_NULL(r);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, TEST_MESSAGE_ID, IoTHubMessage_GetMessageId(r));
+    ASSERT_ARE_EQUAL(char_ptr, TEST_CONTENT_TYPE, IoTHubMessage_GetContentTypeSystemProperty(r));
+
+    //cleanup
+    IoTHubMessage_Destroy(r);
+    IoTHubMessage_Destroy(h);
+    IoTHubMessage_DestroyPool(pool);
+}
+
+TEST_FUNCTION(IoTHubMessage_Destroy_gives_a_pooled_message_back_to_the_pool)
+{
+    //arrange
+    IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(1);
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetMessageId(h, TEST_MESSAGE_ID);
+    IOTHUB_MESSAGE_HANDLE r = IoTHubMessage_CloneFromPool(h, pool);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
+    setup_free_of_unset_properties(POOLED_MESSAGE_STRING_COUNT - 1);
+    STRICT_EXPECTED_CALL(BUFFER_clone(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Map_Clone(IGNORED_PTR_ARG));
+
+    //act
+    IoTHubMessage_Destroy(r);
+    r = IoTHubMessage_CloneFromPool(h, pool);
+
+    //assert
+    ASSERT_IS_NOT_NULL(r);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(r);
+    IoTHubMessage_Destroy(h);
+    IoTHubMessage_DestroyPool(pool);
+}
+
+TEST_FUNCTION(IoTHubMessage_CloneFromPool_exhausted_pool_falls_back_to_the_heap)
+{
+    //arrange
+    IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(1);
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    IOTHUB_MESSAGE_HANDLE r1 = IoTHubMessage_CloneFromPool(h, pool);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_clone(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Map_Clone(IGNORED_PTR_ARG));
+
+    //act
+    IOTHUB_MESSAGE_HANDLE r2 = IoTHubMessage_CloneFromPool(h, pool);
+
+    //assert
+    ASSERT_IS_NOT_NULL(r2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(r2);
+    IoTHubMessage_Destroy(r1);
+    IoTHubMessage_Destroy(h);
+    IoTHubMessage_DestroyPool(pool);
+}
+
+TEST_FUNCTION(IoTHubMessage_DestroyPool_with_pooled_messages_frees_it_with_the_last_message)
+{
+    //arrange
+    IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(1);
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    IOTHUB_MESSAGE_HANDLE r = IoTHubMessage_CloneFromPool(h, pool);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
+    setup_free_of_unset_properties(POOLED_MESSAGE_STRING_COUNT);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    //act
+    IoTHubMessage_DestroyPool(pool);
+    ASSERT_IS_NULL(IoTHubMessage_CloneFromPool(h, pool));
+    IoTHubMessage_Destroy(r);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
 /*Tests_SRS_IOTHUBMESSAGE_02_002: [Otherwise, for any non-NULL iotHubMessageHandle it shall return a non-NULL MAP_HANDLE.] */
 TEST_FUNCTION(IoTHubMessage_Properties_happy_path)
 {
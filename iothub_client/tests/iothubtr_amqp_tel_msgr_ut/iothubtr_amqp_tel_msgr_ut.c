@@ -188,6 +188,7 @@ typedef struct SEND_PENDING_EVENTS_TEST_CONFIG_TAG
     bool                        send_outside_working_loop;
     TEST_ON_SEND_COMPLETE_DATA* expected_on_send_complete_data;
     int                         number_expected_on_send_complete_data;
+    bool                        peer_max_message_size_cached;
 } SEND_PENDING_EVENTS_TEST_CONFIG;
 
 
@@ -460,10 +461,11 @@ static MESSENGER_DO_WORK_EXP_CALL_PROFILE* get_msgr_do_work_exp_call_profile(TEL
     return &g_do_work_profile;
 }
 
-static int TEST_message_create_uamqp_encoding_from_iothub_message(MESSAGE_HANDLE message_batch_container, IOTHUB_MESSAGE_HANDLE message_handle, BINARY_DATA* body_binary_data)
+static int TEST_message_create_uamqp_encoding_in_buffer(MESSAGE_HANDLE message_batch_container, IOTHUB_MESSAGE_HANDLE message_handle, UAMQP_ENCODING_BUFFER* encoding_buffer, BINARY_DATA* body_binary_data)
 {
     (void)message_batch_container;
     (void)message_handle;
+    (void)encoding_buffer;
     (void)body_binary_data;
     return 0;
 }
@@ -1373,18 +1375,21 @@ static void set_expected_calls_for_message_do_work_send_pending_events(SEND_PEND
 
         if (i == 0)
         {
-            // Product code factors in AMQP_BATCHING_RESERVE_SIZE bytes and won't go beneath this.
-            // Account for this in test here.
-            uint64_t peer_max_message_size = test_config->peer_max_message_size + AMQP_BATCHING_RESERVE_SIZE;
-            STRICT_EXPECTED_CALL(link_get_peer_max_message_size(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-                .CopyOutArgumentBuffer(2, &peer_max_message_size, sizeof(peer_max_message_size));
+            if (!test_config->peer_max_message_size_cached)
+            {
+                // Product code factors in AMQP_BATCHING_RESERVE_SIZE bytes and won't go beneath this.
+                // Account for this in test here.
+                uint64_t peer_max_message_size = test_config->peer_max_message_size + AMQP_BATCHING_RESERVE_SIZE;
+                STRICT_EXPECTED_CALL(link_get_peer_max_message_size(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+                    .CopyOutArgumentBuffer(2, &peer_max_message_size, sizeof(peer_max_message_size));
+            }
             set_expected_calls_for_create_send_pending_events_state();
         }
 
         TEST_amqp_data.length = test_config->test_events[i].number_bytes_encoded;
 
-        STRICT_EXPECTED_CALL(message_create_uamqp_encoding_from_iothub_message(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .CopyOutArgumentBuffer(3, &TEST_amqp_data, sizeof(TEST_amqp_data)).SetReturn(message_create_uamqp_encoding_from_iothub_message_return);
+        STRICT_EXPECTED_CALL(message_create_uamqp_encoding_in_buffer(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer(4, &TEST_amqp_data, sizeof(TEST_amqp_data)).SetReturn(message_create_uamqp_encoding_from_iothub_message_return);
 
         if ((SEND_PENDING_EXPECT_ERROR_TOO_LARGE == expected_action) || (SEND_PENDING_EXPECT_CREATE_MESSAGE_FAILURE == expected_action))
         {
@@ -1818,7 +1823,7 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_HOOK(messagesender_send_async, TEST_messagesender_send_async);
     REGISTER_GLOBAL_MOCK_HOOK(messagereceiver_create, TEST_messagereceiver_create);
     REGISTER_GLOBAL_MOCK_HOOK(messagereceiver_open, TEST_messagereceiver_open);
-    REGISTER_GLOBAL_MOCK_HOOK(message_create_uamqp_encoding_from_iothub_message, TEST_message_create_uamqp_encoding_from_iothub_message);
+    REGISTER_GLOBAL_MOCK_HOOK(message_create_uamqp_encoding_in_buffer, TEST_message_create_uamqp_encoding_in_buffer);
     REGISTER_GLOBAL_MOCK_HOOK(message_create_IoTHubMessage_from_uamqp_message, TEST_message_create_IoTHubMessage_from_uamqp_message);
     REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, TEST_singlylinkedlist_add);
     REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, TEST_singlylinkedlist_get_head_item);
@@ -2848,6 +2853,44 @@ TEST_FUNCTION(telemetry_messenger_do_work_on_multiple_callbacks_OK)
     test_send_events_for_callbacks(MESSAGE_SEND_OK, &test_send_just_under_rollover_config);
 }
 
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_31_202: [The maximum message size shall be read from the link once, and kept until the event sender is destroyed.]
+TEST_FUNCTION(telemetry_messenger_do_work_send_events_reads_the_peer_max_message_size_once)
+{
+    // arrange
+    SEND_PENDING_EVENTS_TEST_CONFIG cached_config = test_send_one_message_config;
+    TELEMETRY_MESSENGER_CONFIG* config = get_messenger_config();
+    TELEMETRY_MESSENGER_HANDLE handle = create_and_start_messenger2(config, false);
+    cached_config.peer_max_message_size_cached = true;
+
+    ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
+
+    time_t current_time = time(NULL);
+    MESSENGER_DO_WORK_EXP_CALL_PROFILE *do_work_profile = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTED, false, false, 1, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
+    do_work_profile->send_pending_events_test_config = &test_send_one_message_config;
+    crank_telemetry_messenger_do_work(handle, do_work_profile);
+
+    umock_c_reset_all_calls();
+    set_expected_calls_for_on_message_send_complete(1);
+    saved_messagesender_send_on_message_send_complete(saved_messagesender_send_callback_context, MESSAGE_SEND_OK, TEST_DISPOSITION_AMQP_VALUE);
+
+    ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
+
+    do_work_profile = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTED, false, false, 1, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
+    do_work_profile->send_pending_events_test_config = &cached_config;
+
+    umock_c_reset_all_calls();
+    set_expected_calls_for_telemetry_messenger_do_work(do_work_profile);
+
+    // act
+    telemetry_messenger_do_work(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    telemetry_messenger_destroy(handle);
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_31_190: [If a failure occured, `on_event_send_complete_callback` shall be invoked with result TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING for all callers associated with this task]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_128: [`task` shall be removed from `instance->in_progress_list`]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_130: [**`task` shall be destroyed()**]**
@@ -2857,7 +2900,7 @@ TEST_FUNCTION(telemetry_messenger_do_work_on_event_send_complete_ERROR)
     test_send_events_for_callbacks(MESSAGE_SEND_ERROR, &test_send_one_message_config);
 }
 
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_31_201: [If message_create_uamqp_encoding_from_iothub_message fails, invoke callback with TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_31_201: [If message_create_uamqp_encoding_in_buffer fails, invoke callback with TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_31_199: [Errors specific to a message (e.g. failure to encode) are NOT fatal but we'll keep processing.  More general errors (e.g. out of memory) will stop processing.]
 TEST_FUNCTION(telemetry_messenger_do_work_send_events_message_create_from_iothub_message_fails)
 {
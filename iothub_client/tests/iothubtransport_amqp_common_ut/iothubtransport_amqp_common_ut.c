@@ -90,7 +90,6 @@ extern "C"
 
 #define ENABLE_MOCKS
 #include "azure_c_shared_utility/gballoc.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/platform.h"
 #include "azure_c_shared_utility/strings.h"
@@ -112,6 +111,7 @@ extern "C"
 #include "internal/iothubtransportamqp_methods.h"
 #include "internal/iothubtransport_amqp_connection.h"
 #include "internal/iothubtransport_amqp_device.h"
+#include "internal/iothubtransport_amqp_device_index.h"
 
 #include "internal/iothub_transport_ll_private.h"
 
@@ -148,6 +148,7 @@ extern "C"
     extern void real_DList_InsertTailList(PDLIST_ENTRY ListHead, PDLIST_ENTRY Entry);
     extern int real_DList_IsListEmpty(const PDLIST_ENTRY ListHead);
     extern void real_DList_InitializeListHead(PDLIST_ENTRY ListHead);
+    extern PDLIST_ENTRY real_DList_RemoveHeadList(PDLIST_ENTRY ListHead);
 
     int my_DList_RemoveEntryList(PDLIST_ENTRY Entry)
     {
@@ -169,112 +170,50 @@ extern "C"
         real_DList_InitializeListHead(ListHead);
     }
 
-
-    // singlylinkedlist
-    static int saved_registered_devices_list_count;
-    static const void* saved_registered_devices_list[20];
-
-    static bool TEST_singlylinkedlist_add_fail_return = false;
-    static LIST_ITEM_HANDLE TEST_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item)
+    PDLIST_ENTRY my_DList_RemoveHeadList(PDLIST_ENTRY ListHead)
     {
-        (void)list;
-        saved_registered_devices_list[saved_registered_devices_list_count++] = item;
-
-        return TEST_singlylinkedlist_add_fail_return ? NULL : (LIST_ITEM_HANDLE)item;
+        return real_DList_RemoveHeadList(ListHead);
     }
 
-    static int TEST_singlylinkedlist_remove_return = 0;
-    static int TEST_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item)
-    {
-        (void)list;
-        const void** TEST_list = NULL;
-        int* TEST_list_count = NULL;
-
-        TEST_list = saved_registered_devices_list;
-        TEST_list_count = &saved_registered_devices_list_count;
 
-        int i;
-        int item_found = 0;
-        for (i = 0; i < *TEST_list_count; i++)
-        {
-            if (item_found)
-            {
-                TEST_list[i - 1] = TEST_list[i];
-            }
-            else if (TEST_list[i] == item)
-            {
-                item_found = 1;
-            }
-        }
+    // amqp_device_index
+    static int saved_registered_devices_count;
 
-        if (item_found)
-        {
-            (*TEST_list_count)--;
-        }
-
-        return item_found == 1 ? 0 : 1;
-    }
-
-    static LIST_ITEM_HANDLE TEST_singlylinkedlist_find(SINGLYLINKEDLIST_HANDLE list, LIST_MATCH_FUNCTION match_function, const void* match_context)
+    static int TEST_amqp_device_index_add(AMQP_DEVICE_INDEX_HANDLE index, const char* device_id, const char* module_id, void* device)
     {
-        (void)list;
-        (void)match_function;
-        return (LIST_ITEM_HANDLE)match_context;
+        (void)index;
+        (void)device_id;
+        (void)module_id;
+        (void)device;
+        saved_registered_devices_count++;
+        return 0;
     }
 
-    static SINGLYLINKEDLIST_HANDLE TEST_singlylinkedlist_foreach_list;
-    static LIST_ACTION_FUNCTION TEST_singlylinkedlist_foreach_action_function;
-    static const void* TEST_singlylinkedlist_foreach_context;
-    static int TEST_singlylinkedlist_foreach(SINGLYLINKEDLIST_HANDLE list, LIST_ACTION_FUNCTION action_function, const void* action_context)
+    static int TEST_amqp_device_index_remove(AMQP_DEVICE_INDEX_HANDLE index, const char* device_id, const char* module_id)
     {
-        TEST_singlylinkedlist_foreach_list = list;
-        TEST_singlylinkedlist_foreach_action_function = action_function;
-        TEST_singlylinkedlist_foreach_context = action_context;
+        (void)index;
+        (void)device_id;
+        (void)module_id;
+        saved_registered_devices_count--;
         return 0;
     }
 
-    static const void* TEST_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle)
+    static size_t TEST_amqp_device_index_get_count(AMQP_DEVICE_INDEX_HANDLE index)
     {
-        return (const void*)item_handle;
+        (void)index;
+        return (size_t)saved_registered_devices_count;
     }
 
-    static LIST_ITEM_HANDLE TEST_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list)
-    {
-        (void)list;
-        LIST_ITEM_HANDLE list_item;
+    static bool TEST_amqp_device_get_send_status_is_idle;
 
-        if (saved_registered_devices_list_count <= 0)
-        {
-            list_item = NULL;
-        }
-        else
-        {
-            list_item = (LIST_ITEM_HANDLE)saved_registered_devices_list[0];
-        }
-
-        return list_item;
-    }
-
-    static LIST_ITEM_HANDLE TEST_singlylinkedlist_get_next_item(LIST_ITEM_HANDLE item_handle)
+    static int TEST_amqp_device_get_send_status(AMQP_DEVICE_HANDLE handle, DEVICE_SEND_STATUS* send_status)
     {
-        LIST_ITEM_HANDLE next_item = NULL;
-
-        int i;
-        int item_found = 0;
-        for (i = 0; i < saved_registered_devices_list_count; i++)
+        (void)handle;
+        if (TEST_amqp_device_get_send_status_is_idle)
         {
-            if (item_found)
-            {
-                next_item = (LIST_ITEM_HANDLE)saved_registered_devices_list[i];
-                break;
-            }
-            else if (saved_registered_devices_list[i] == (void*)item_handle)
-            {
-                item_found = 1;
-            }
+            *send_status = DEVICE_SEND_STATUS_IDLE;
         }
-
-        return next_item;
+        return 0;
     }
 
 
@@ -409,10 +348,10 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 #define TEST_IOTHUB_HOST_FQDN_STRING_HANDLE        (STRING_HANDLE)0x4264
 #define TEST_IOTHUB_HOST_FQDN_CLONE_STRING_HANDLE  (STRING_HANDLE)0x4265
 #define TEST_PROTOCOL_PROVIDER                     (IOTHUB_CLIENT_TRANSPORT_PROVIDER)0x4266
-#define TEST_REGISTERED_DEVICES_LIST               (SINGLYLINKEDLIST_HANDLE)0x4267
+#define TEST_REGISTERED_DEVICES_INDEX              (AMQP_DEVICE_INDEX_HANDLE)0x4270
 #define TEST_DEVICE_ID_STRING_HANDLE               (STRING_HANDLE)0x4268
+#define TEST_MODULE_ID_STRING_HANDLE               (STRING_HANDLE)0x4277
 #define TEST_DEVICE_HANDLE                         (AMQP_DEVICE_HANDLE)0x4269
-#define TEST_LIST_ITEM_HANDLE                      (LIST_ITEM_HANDLE)0x4270
 #define TEST_AMQP_CONNECTION_HANDLE                (AMQP_CONNECTION_HANDLE)0x4271
 #define TEST_IOTHUB_MESSAGE_LIST_HANDLE            (IOTHUB_MESSAGE_LIST*)0x4272
 #define TEST_IOTHUB_DEVICE_HANDLE                  (IOTHUB_DEVICE_HANDLE)0x4273
@@ -445,6 +384,9 @@ static void set_expected_calls_for_Create(IOTHUBTRANSPORT_CONFIG* transport_conf
 {
     STRICT_EXPECTED_CALL(IoTHub_Transport_ValidateCallbacks(IGNORED_PTR_ARG) );
     EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(DList_InitializeListHead(IGNORED_PTR_ARG)).CallCannotFail();
+    EXPECTED_CALL(DList_InitializeListHead(IGNORED_PTR_ARG)).CallCannotFail();
+    EXPECTED_CALL(DList_InitializeListHead(IGNORED_PTR_ARG)).CallCannotFail();
 
     STRICT_EXPECTED_CALL(retry_control_create(DEFAULT_RETRY_POLICY, DEFAULT_MAX_RETRY_TIME_IN_SECS));
 
@@ -458,8 +400,7 @@ static void set_expected_calls_for_Create(IOTHUBTRANSPORT_CONFIG* transport_conf
         STRING_construct_sprintf_result = TEST_IOTHUB_HOST_FQDN_STRING_HANDLE;
     }
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_create())
-        .SetReturn(TEST_REGISTERED_DEVICES_LIST);
+    STRICT_EXPECTED_CALL(amqp_device_index_create());
 }
 
 static void set_expected_calls_for_GetSendStatus(bool is_waiting_to_send_list_empty, DEVICE_SEND_STATUS send_status)
@@ -487,12 +428,12 @@ static void set_expected_calls_for_GetHostname()
     STRICT_EXPECTED_CALL(STRING_clone(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE)).SetReturn(TEST_IOTHUB_HOST_FQDN_CLONE_STRING_HANDLE);
 }
 
-static void set_expected_calls_for_is_device_registered_ex(IOTHUB_DEVICE_CONFIG* device_config, IOTHUB_DEVICE_HANDLE registered_device)
+static void set_expected_calls_for_amqp_device_index_find(IOTHUB_DEVICE_CONFIG* device_config, IOTHUB_DEVICE_HANDLE registered_device)
 {
     (void)device_config;
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_REGISTERED_DEVICES_LIST, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .SetReturn((LIST_ITEM_HANDLE)registered_device).CallCannotFail();
+    STRICT_EXPECTED_CALL(amqp_device_index_find(TEST_REGISTERED_DEVICES_INDEX, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(registered_device).CallCannotFail();
 }
 
 static MESSAGE_DISPOSITION_CONTEXT* TRANSPORT_CONTEXT_DATA_create2(IOTHUB_DEVICE_HANDLE device_handle)
@@ -562,12 +503,12 @@ static void set_expected_calls_for_is_device_registered(IOTHUB_DEVICE_CONFIG* de
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_DEVICE_ID_STRING_HANDLE))
         .SetReturn(TEST_DEVICE_ID_CHAR_PTR);
 
-    set_expected_calls_for_is_device_registered_ex(device_config, registered_device);
+    set_expected_calls_for_amqp_device_index_find(device_config, registered_device);
 }
 
 static void set_expected_calls_for_Register(IOTHUB_DEVICE_CONFIG* device_config, bool is_using_cbs)
 {
-    set_expected_calls_for_is_device_registered_ex(device_config, NULL);
+    set_expected_calls_for_amqp_device_index_find(device_config, NULL);
 
     // is_device_credential_acceptable
     // Nothing to expect.
@@ -578,8 +519,7 @@ static void set_expected_calls_for_Register(IOTHUB_DEVICE_CONFIG* device_config,
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE))
         .SetReturn(TEST_IOTHUB_HOST_FQDN_CHAR_PTR).CallCannotFail();
     EXPECTED_CALL(amqp_device_create(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_REGISTERED_DEVICES_LIST))
-        .SetReturn(NULL).CallCannotFail();
+    EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG)).CallCannotFail();
 
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE)).SetReturn(TEST_IOTHUB_HOST_FQDN_CHAR_PTR).CallCannotFail();
     EXPECTED_CALL(iothubtransportamqp_methods_create(TEST_IOTHUB_HOST_FQDN_CHAR_PTR, device_config->deviceId, NULL));
@@ -592,7 +532,9 @@ static void set_expected_calls_for_Register(IOTHUB_DEVICE_CONFIG* device_config,
         STRICT_EXPECTED_CALL(amqp_device_set_option(TEST_DEVICE_HANDLE, DEVICE_OPTION_CBS_REQUEST_TIMEOUT_SECS, IGNORED_PTR_ARG));
     }
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_REGISTERED_DEVICES_LIST, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_device_index_add(TEST_REGISTERED_DEVICES_INDEX, device_config->deviceId, device_config->moduleId, IGNORED_PTR_ARG));
+    EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 }
 
 static void set_expected_calls_for_Unregister(IOTHUB_DEVICE_HANDLE iothub_device_handle)
@@ -600,13 +542,12 @@ static void set_expected_calls_for_Unregister(IOTHUB_DEVICE_HANDLE iothub_device
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_DEVICE_ID_STRING_HANDLE))
         .SetReturn(TEST_DEVICE_ID_CHAR_PTR);
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_REGISTERED_DEVICES_LIST, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2)
-        .IgnoreArgument(3)
-        .SetReturn((LIST_ITEM_HANDLE)iothub_device_handle);
+    STRICT_EXPECTED_CALL(amqp_device_index_find(TEST_REGISTERED_DEVICES_INDEX, TEST_DEVICE_ID_CHAR_PTR, IGNORED_PTR_ARG))
+        .SetReturn(iothub_device_handle);
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_REGISTERED_DEVICES_LIST, IGNORED_PTR_ARG))
-        .IgnoreArgument(2);
+    EXPECTED_CALL(DList_RemoveEntryList(IGNORED_PTR_ARG));
+    EXPECTED_CALL(DList_RemoveEntryList(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_device_index_remove(TEST_REGISTERED_DEVICES_INDEX, TEST_DEVICE_ID_CHAR_PTR, IGNORED_PTR_ARG));
 
     STRICT_EXPECTED_CALL(iothubtransportamqp_methods_destroy(TEST_IOTHUBTRANSPORTAMQP_METHODS));
 
@@ -719,7 +660,7 @@ static void set_expected_calls_for_get_new_underlying_io_transport(bool feed_opt
 
 static void set_expected_calls_for_DoWork2(PDLIST_ENTRY wts, int wts_length, DEVICE_STATE current_device_state, bool is_tls_io_acquired, bool feed_options, bool is_using_cbs, bool is_connection_created, bool is_connection_open, int number_of_registered_devices, time_t current_time, bool subscribe_for_methods)
 {
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_REGISTERED_DEVICES_LIST));
+    EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG));
 
     if (!is_tls_io_acquired)
     {
@@ -735,12 +676,22 @@ static void set_expected_calls_for_DoWork2(PDLIST_ENTRY wts, int wts_length, DEV
 
     if (is_connection_open)
     {
+        STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
+        // wake_idle_devices
+        EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG));
+
         int i;
         for (i = 0; i < number_of_registered_devices; i++)
         {
-            EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+            EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG));
+            EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
             set_expected_calls_for_Device_DoWork(wts, wts_length, current_device_state, is_using_cbs, current_time, subscribe_for_methods);
-            EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+
+            if (current_device_state == DEVICE_STATE_STARTED)
+            {
+                // is_device_idle; the mock leaves the status as busy, so the device stays ready.
+                STRICT_EXPECTED_CALL(amqp_device_get_send_status(TEST_DEVICE_HANDLE, IGNORED_PTR_ARG));
+            }
         }
     }
 
@@ -757,17 +708,13 @@ static void set_expected_calls_for_DoWork(PDLIST_ENTRY wts, int wts_length, DEVI
 
 static void set_expected_calls_for_Destroy(int number_of_registered_devices, IOTHUB_DEVICE_HANDLE* registered_devices)
 {
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_REGISTERED_DEVICES_LIST));
-
     int i;
     for (i = 0; i < number_of_registered_devices; i++)
     {
-        EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-        EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
         set_expected_calls_for_Unregister(registered_devices[i]);
     }
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_REGISTERED_DEVICES_LIST));
+    STRICT_EXPECTED_CALL(amqp_device_index_destroy(TEST_REGISTERED_DEVICES_INDEX));
     STRICT_EXPECTED_CALL(amqp_connection_destroy(TEST_AMQP_CONNECTION_HANDLE));
     STRICT_EXPECTED_CALL(xio_destroy(TEST_UNDERLYING_IO_TRANSPORT));
     STRICT_EXPECTED_CALL(retry_control_destroy(TEST_RETRY_CONTROL_HANDLE));
@@ -810,14 +757,10 @@ static void set_expected_calls_for_prepare_for_connection_retry(int number_of_re
     STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_UNDERLYING_IO_TRANSPORT))
         .SetReturn(TEST_OPTIONHANDLER_HANDLE);
 
-    EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
-
     int i;
     for (i = 0; i < number_of_registered_devices; i++)
     {
-        EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
         set_expected_calls_for_prepare_device_for_connection_retry(current_device_state);
-        EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
     }
 
     STRICT_EXPECTED_CALL(amqp_connection_destroy(TEST_AMQP_CONNECTION_HANDLE));
@@ -1051,6 +994,25 @@ static IOTHUB_DEVICE_HANDLE register_device(TRANSPORT_LL_HANDLE handle, IOTHUB_D
     return IoTHubTransport_AMQP_Common_Register(handle, device_config, wts);
 }
 
+static TRANSPORT_LL_HANDLE create_transport_with_idle_device(IOTHUB_DEVICE_HANDLE* device_handle)
+{
+    TRANSPORT_LL_HANDLE handle = create_transport();
+
+    IOTHUB_DEVICE_CONFIG* device_config = create_device_config(TEST_DEVICE_ID_CHAR_PTR, true);
+    *device_handle = register_device(handle, device_config, &TEST_waitingToSend, true);
+    ASSERT_IS_NOT_NULL(*device_handle);
+
+    crank_transport_ready_after_create(handle, &TEST_waitingToSend, 0, false, true, 1, TEST_current_time, false);
+
+    // The device has nothing left to send, so this DoWork parks it.
+    TEST_amqp_device_get_send_status_is_idle = true;
+    IoTHubTransport_AMQP_Common_DoWork(handle);
+
+    umock_c_reset_all_calls();
+
+    return handle;
+}
+
 static void destroy_transport(TRANSPORT_LL_HANDLE handle, IOTHUB_DEVICE_HANDLE registered_device0, IOTHUB_DEVICE_HANDLE registered_device1)
 {
     int number_of_registered_devices = (registered_device1 != NULL ? 2 : (registered_device0 != NULL ? 1 : 0));
@@ -1119,6 +1081,7 @@ static void register_umock_alias_types()
     REGISTER_UMOCK_ALIAS_TYPE(RETRY_CONTROL_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(SESSION_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(AMQP_DEVICE_INDEX_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(time_t, long long);
@@ -1140,18 +1103,16 @@ static void register_global_mock_hooks()
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
     REGISTER_GLOBAL_MOCK_HOOK(iothubtransportamqp_methods_subscribe, my_iothubtransportamqp_methods_subscribe);
 
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, TEST_singlylinkedlist_add);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, TEST_singlylinkedlist_remove);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, TEST_singlylinkedlist_get_head_item);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_next_item, TEST_singlylinkedlist_get_next_item);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_find, TEST_singlylinkedlist_find);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_foreach, TEST_singlylinkedlist_foreach);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, TEST_singlylinkedlist_item_get_value);
+    REGISTER_GLOBAL_MOCK_HOOK(amqp_device_index_add, TEST_amqp_device_index_add);
+    REGISTER_GLOBAL_MOCK_HOOK(amqp_device_index_remove, TEST_amqp_device_index_remove);
+    REGISTER_GLOBAL_MOCK_HOOK(amqp_device_index_get_count, TEST_amqp_device_index_get_count);
+    REGISTER_GLOBAL_MOCK_HOOK(amqp_device_get_send_status, TEST_amqp_device_get_send_status);
 
     REGISTER_GLOBAL_MOCK_HOOK(DList_RemoveEntryList, my_DList_RemoveEntryList);
     REGISTER_GLOBAL_MOCK_HOOK(DList_InsertTailList, my_DList_InsertTailList);
     REGISTER_GLOBAL_MOCK_HOOK(DList_IsListEmpty, my_DList_IsListEmpty);
     REGISTER_GLOBAL_MOCK_HOOK(DList_InitializeListHead, my_DList_InitializeListHead);
+    REGISTER_GLOBAL_MOCK_HOOK(DList_RemoveHeadList, my_DList_RemoveHeadList);
 
     REGISTER_GLOBAL_MOCK_HOOK(amqp_connection_create, TEST_amqp_connection_create);
     REGISTER_GLOBAL_MOCK_HOOK(amqp_connection_get_session_handle, TEST_amqp_connection_get_session_handle);
@@ -1182,7 +1143,12 @@ static void register_global_mock_returns()
     REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_create_symbol, TEST_AMQP_VALUE);
     REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_create_string, TEST_AMQP_VALUE);
 
-    REGISTER_GLOBAL_MOCK_FAIL_RETURN(singlylinkedlist_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(amqp_device_index_create, TEST_REGISTERED_DEVICES_INDEX);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqp_device_index_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(amqp_device_index_add, 0);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqp_device_index_add, 1);
+    REGISTER_GLOBAL_MOCK_RETURN(amqp_device_index_remove, 0);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqp_device_index_remove, 1);
 
     REGISTER_GLOBAL_MOCK_RETURN(amqp_device_start_async, 0);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqp_device_start_async, 1);
@@ -1223,6 +1189,7 @@ static void register_global_mock_returns()
 
 static void reset_test_data()
 {
+    TEST_amqp_device_get_send_status_is_idle = false;
     g_STRING_sprintf_call_count = 0;
     g_STRING_sprintf_fail_on_count = 0;
 
@@ -1245,7 +1212,7 @@ static void reset_test_data()
     TEST_device_create_saved_on_state_changed_context = NULL;
     TEST_device_create_return = TEST_DEVICE_HANDLE;
 
-    saved_registered_devices_list_count = 0;
+    saved_registered_devices_count = 0;
 
     TEST_device_subscribe_message_saved_callback = NULL;
     TEST_device_subscribe_message_saved_context = NULL;
@@ -1254,10 +1221,6 @@ static void reset_test_data()
     TEST_MESSAGE_ID = 1234;
     TEST_mallocAndStrcpy_s_return = 0;
 
-    TEST_singlylinkedlist_foreach_list = NULL;
-    TEST_singlylinkedlist_foreach_action_function = NULL;
-    TEST_singlylinkedlist_foreach_context = NULL;
-
     memset(&TEST_waitingToSend, 0, sizeof(TEST_waitingToSend));
 
     g_on_methods_error_context = NULL;
@@ -2012,7 +1975,8 @@ TEST_FUNCTION(GetHostName_success)
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_003: [Memory shall be allocated for the transport's internal state structure (`instance`)]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_005: [If `config->upperConfig->protocolGatewayHostName` is NULL, `instance->iothub_target_fqdn` shall be set as `config->upperConfig->iotHubName` + "." + `config->upperConfig->iotHubSuffix`]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_006: [If `config->upperConfig->protocolGatewayHostName` is not NULL, `instance->iothub_target_fqdn` shall be set with a copy of it]
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_008: [`instance->registered_devices` shall be set using singlylinkedlist_create()]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_008: [`instance->registered_devices` shall be initialized using DList_InitializeListHead(), as well as the lists of ready and idle devices]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_31_001: [`instance->registered_devices_index` shall be set using amqp_device_index_create()]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_010: [`get_io_transport` shall be saved on `instance->underlying_io_transport_provider`]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_012: [If IoTHubTransport_AMQP_Common_Create succeeds it shall return a pointer to `instance`.]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_124: [`instance->connection_retry_control` shall be set using retry_control_create(), passing defaults EXPONENTIAL_BACKOFF_WITH_JITTER and 0]
@@ -2059,7 +2023,7 @@ TEST_FUNCTION(IoTHubTransport_AMQP_Common_Create_callbacks_NULL_fail)
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_002: [IoTHubTransport_AMQP_Common_Create shall fail and return NULL if `config->upperConfig->protocol` is NULL]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_004: [If malloc() fails, IoTHubTransport_AMQP_Common_Create shall fail and return NULL]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_007: [If `instance->iothub_target_fqdn` fails to be set, IoTHubTransport_AMQP_Common_Create shall fail and return NULL]
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_009: [If singlylinkedlist_create() fails, IoTHubTransport_AMQP_Common_Create shall fail and return NULL]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_31_002: [If amqp_device_index_create() fails, IoTHubTransport_AMQP_Common_Create shall fail and return NULL]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_011: [If IoTHubTransport_AMQP_Common_Create fails it shall free any memory it allocated]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_125: [If retry_control_create() fails, IoTHubTransport_AMQP_Common_Create shall fail and return NULL]
 TEST_FUNCTION(Create_failure_checks)
@@ -2079,6 +2043,11 @@ TEST_FUNCTION(Create_failure_checks)
     size_t i;
     for (i = 0; i < umock_c_negative_tests_call_count(); i++)
     {
+        if (!umock_c_negative_tests_can_call_fail(i))
+        {
+            continue;
+        }
+
         // arrange
         char error_msg[64];
 
@@ -2210,6 +2179,7 @@ TEST_FUNCTION(Register_NULL_config_device_id)
 }
 
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_064: [If the device is already registered, IoTHubTransport_AMQP_Common_Register shall fail and return NULL.]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_31_003: [The device shall be looked up with amqp_device_index_find(), passing `device->deviceId` and `device->moduleId`]
 TEST_FUNCTION(Register_device_already_registered)
 {
     // arrange
@@ -2218,9 +2188,8 @@ TEST_FUNCTION(Register_device_already_registered)
 
     IOTHUB_DEVICE_CONFIG* device_config = create_device_config(TEST_DEVICE_ID_CHAR_PTR, true);
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_REGISTERED_DEVICES_LIST, IGNORED_PTR_ARG, device_config->deviceId))
-        .IgnoreArgument(2)
-        .SetReturn(TEST_LIST_ITEM_HANDLE);
+    STRICT_EXPECTED_CALL(amqp_device_index_find(TEST_REGISTERED_DEVICES_INDEX, device_config->deviceId, IGNORED_PTR_ARG))
+        .SetReturn(TEST_DEVICE_HANDLE);
 
     // act
     IOTHUB_DEVICE_HANDLE device_handle = IoTHubTransport_AMQP_Common_Register(handle, device_config, &TEST_waitingToSend);
@@ -2249,8 +2218,7 @@ TEST_FUNCTION(Register_CBS_transport_X509_credentials)
 
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_REGISTERED_DEVICES_LIST, IGNORED_PTR_ARG, device_config2->deviceId))
-        .IgnoreArgument(2)
+    STRICT_EXPECTED_CALL(amqp_device_index_find(TEST_REGISTERED_DEVICES_INDEX, device_config2->deviceId, IGNORED_PTR_ARG))
         .SetReturn(NULL);
 
     // act
@@ -2281,8 +2249,7 @@ TEST_FUNCTION(Register_X509_transport_CBS_credentials)
 
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_REGISTERED_DEVICES_LIST, IGNORED_PTR_ARG, device_config2->deviceId))
-        .IgnoreArgument(2)
+    STRICT_EXPECTED_CALL(amqp_device_index_find(TEST_REGISTERED_DEVICES_INDEX, device_config2->deviceId, IGNORED_PTR_ARG))
         .SetReturn(NULL);
 
     // act
@@ -2301,7 +2268,6 @@ TEST_FUNCTION(Register_X509_transport_CBS_credentials)
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_070: [If STRING_construct() fails, IoTHubTransport_AMQP_Common_Register shall fail and return NULL]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_073: [If amqp_device_create() fails, IoTHubTransport_AMQP_Common_Register shall fail and return NULL]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_01_011: [ If `iothubtransportamqp_methods_create` fails, `IoTHubTransport_AMQP_Common_Register` shall fail and return NULL]
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_075: [If it fails to add `amqp_device_instance`, IoTHubTransport_AMQP_Common_Register shall fail and return NULL]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_077: [If IoTHubTransport_AMQP_Common_Register fails, it shall free all memory it allocated]
 TEST_FUNCTION(Register_failure_checks)
 {
@@ -2352,7 +2318,8 @@ TEST_FUNCTION(Register_failure_checks)
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_071: [`amqp_device_instance->device_handle` shall be set using amqp_device_create()]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_072: [The configuration for amqp_device_create shall be set according to the authentication preferred by IOTHUB_DEVICE_CONFIG]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_01_010: [ `IoTHubTransport_AMQP_Common_Register` shall create a new iothubtransportamqp_methods instance by calling `iothubtransportamqp_methods_create` while passing to it the the fully qualified domain name, the device Id, and optional module Id.]
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_074: [IoTHubTransport_AMQP_Common_Register shall add the `amqp_device_instance` to `instance->registered_devices`]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_074: [IoTHubTransport_AMQP_Common_Register shall add the `amqp_device_instance` to `instance->registered_devices` and to the list of ready devices]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_31_005: [IoTHubTransport_AMQP_Common_Register shall add the `amqp_device_instance` to `instance->registered_devices_index` using amqp_device_index_add()]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_076: [If the device is the first being registered on the transport, IoTHubTransport_AMQP_Common_Register shall save its authentication mode as the transport preferred authentication mode]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_078: [IoTHubTransport_AMQP_Common_Register shall return a handle to `amqp_device_instance` as a IOTHUB_DEVICE_HANDLE]
 TEST_FUNCTION(Register_succeeds)
@@ -2377,6 +2344,77 @@ TEST_FUNCTION(Register_succeeds)
     destroy_transport(handle, device_handle, NULL);
 }
 
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_31_004: [If `config->moduleId` is not NULL, a copy of it shall be saved into `device_state->module_id`]
+TEST_FUNCTION(Register_module_succeeds)
+{
+    // arrange
+    initialize_test_variables();
+    TRANSPORT_LL_HANDLE handle = create_transport();
+
+    IOTHUB_DEVICE_CONFIG* device_config = create_device_config(TEST_DEVICE_ID_CHAR_PTR, true);
+    device_config->moduleId = "some-module";
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(amqp_device_index_find(TEST_REGISTERED_DEVICES_INDEX, device_config->deviceId, device_config->moduleId));
+    EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(STRING_construct(device_config->deviceId))
+        .SetReturn(TEST_DEVICE_ID_STRING_HANDLE);
+    STRICT_EXPECTED_CALL(STRING_construct(device_config->moduleId))
+        .SetReturn(TEST_MODULE_ID_STRING_HANDLE);
+    STRICT_EXPECTED_CALL(STRING_c_str(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE))
+        .SetReturn(TEST_IOTHUB_HOST_FQDN_CHAR_PTR);
+    EXPECTED_CALL(amqp_device_create(IGNORED_PTR_ARG));
+    EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_c_str(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE))
+        .SetReturn(TEST_IOTHUB_HOST_FQDN_CHAR_PTR);
+    STRICT_EXPECTED_CALL(iothubtransportamqp_methods_create(TEST_IOTHUB_HOST_FQDN_CHAR_PTR, device_config->deviceId, device_config->moduleId));
+    STRICT_EXPECTED_CALL(amqp_device_set_option(TEST_DEVICE_HANDLE, DEVICE_OPTION_EVENT_SEND_TIMEOUT_SECS, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_device_set_option(TEST_DEVICE_HANDLE, DEVICE_OPTION_CBS_REQUEST_TIMEOUT_SECS, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_device_index_add(TEST_REGISTERED_DEVICES_INDEX, device_config->deviceId, device_config->moduleId, IGNORED_PTR_ARG));
+    EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    IOTHUB_DEVICE_HANDLE device_handle = IoTHubTransport_AMQP_Common_Register(handle, device_config, &TEST_waitingToSend);
+
+    // assert
+    ASSERT_IS_NOT_NULL(device_handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_transport(handle, device_handle, NULL);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_31_006: [If amqp_device_index_add() fails, IoTHubTransport_AMQP_Common_Register shall fail and return NULL]
+TEST_FUNCTION(Register_index_add_fails)
+{
+    // arrange
+    initialize_test_variables();
+    ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+    TRANSPORT_LL_HANDLE handle = create_transport();
+
+    IOTHUB_DEVICE_CONFIG* device_config = create_device_config(TEST_DEVICE_ID_CHAR_PTR, true);
+
+    umock_c_reset_all_calls();
+    set_expected_calls_for_Register(device_config, true);
+    umock_c_negative_tests_snapshot();
+
+    // amqp_device_index_add() is followed by the two DList_InsertTailList() calls.
+    umock_c_negative_tests_reset();
+    umock_c_negative_tests_fail_call(umock_c_negative_tests_call_count() - 3);
+
+    // act
+    IOTHUB_DEVICE_HANDLE device_handle = IoTHubTransport_AMQP_Common_Register(handle, device_config, &TEST_waitingToSend);
+
+    // assert
+    ASSERT_IS_NULL(device_handle);
+    ASSERT_ARE_EQUAL(int, 0, saved_registered_devices_count);
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+    destroy_transport(handle, NULL, NULL);
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_084: [If `handle` is NULL, IoTHubTransport_AMQP_Common_Subscribe shall return a non-zero result]
 TEST_FUNCTION(Subscribe_NULL_handle)
 {
@@ -2816,8 +2854,6 @@ TEST_FUNCTION(SetOption_device_specific_failure_check)
     size_t value = 10;
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_REGISTERED_DEVICES_LIST));
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG)).SetReturn(device_handle);
     STRICT_EXPECTED_CALL(amqp_device_set_option(TEST_DEVICE_HANDLE, DEVICE_OPTION_EVENT_SEND_TIMEOUT_SECS, &value))
         .SetReturn(1);
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_DEVICE_ID_STRING_HANDLE))
@@ -3924,14 +3960,9 @@ TEST_FUNCTION(IoTHubTransport_AMQP_Common_Destroy_frees_proxy_options)
     (void)IoTHubTransport_AMQP_Common_SetOption(handle, "proxy_data", &http_proxy_options);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_REGISTERED_DEVICES_LIST));
-
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
-
     set_expected_calls_for_Unregister(device_handle);
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_REGISTERED_DEVICES_LIST));
+    STRICT_EXPECTED_CALL(amqp_device_index_destroy(TEST_REGISTERED_DEVICES_INDEX));
     STRICT_EXPECTED_CALL(retry_control_destroy(TEST_RETRY_CONTROL_HANDLE));
     STRICT_EXPECTED_CALL(STRING_delete(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE));
     STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
@@ -3975,7 +4006,7 @@ TEST_FUNCTION(Unregister_device_not_registered)
     umock_c_reset_all_calls();
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_DEVICE_ID_STRING_HANDLE))
         .SetReturn(TEST_DEVICE_ID_CHAR_PTR);
-    set_expected_calls_for_is_device_registered_ex(device_config, NULL);
+    set_expected_calls_for_amqp_device_index_find(device_config, NULL);
 
     // act
     IoTHubTransport_AMQP_Common_Unregister(device_handle);
@@ -3988,7 +4019,8 @@ TEST_FUNCTION(Unregister_device_not_registered)
 }
 
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_080: [if `deviceHandle` has a NULL reference to its transport instance, IoTHubTransport_AMQP_Common_Unregister shall return.] (NT)
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_082: [`device_instance` shall be removed from `instance->registered_devices`]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_082: [The device shall be removed from `instance->registered_devices` and from the list of ready or idle devices it is in]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_31_007: [The device shall be removed from `instance->registered_devices_index` using amqp_device_index_remove()]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_01_012: [IoTHubTransport_AMQP_Common_Unregister shall destroy the C2D methods handler by calling iothubtransportamqp_methods_destroy]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_083: [IoTHubTransport_AMQP_Common_Unregister shall free all the memory allocated for the `device_instance`]
 TEST_FUNCTION(Unregister_succeeds)
@@ -4207,6 +4239,88 @@ TEST_FUNCTION(on_amqp_connection_state_changed_CLOSED_unexpectedly)
     destroy_transport(handle, device_handle, NULL);
 }
 
+TEST_FUNCTION(DoWork_skips_idle_device)
+{
+    // arrange
+    initialize_test_variables();
+    IOTHUB_DEVICE_HANDLE device_handle;
+    TRANSPORT_LL_HANDLE handle = create_transport_with_idle_device(&device_handle);
+
+    EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(TEST_current_time);
+    EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(get_difftime(TEST_current_time, TEST_current_time));
+    STRICT_EXPECTED_CALL(amqp_connection_do_work(TEST_AMQP_CONNECTION_HANDLE));
+
+    // act
+    IoTHubTransport_AMQP_Common_DoWork(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_transport(handle, device_handle, NULL);
+}
+
+TEST_FUNCTION(DoWork_visits_idle_device_after_OnEventQueued)
+{
+    // arrange
+    initialize_test_variables();
+    IOTHUB_DEVICE_HANDLE device_handle;
+    TRANSPORT_LL_HANDLE handle = create_transport_with_idle_device(&device_handle);
+
+    TEST_amqp_device_get_send_status_is_idle = false;
+
+    EXPECTED_CALL(DList_RemoveEntryList(IGNORED_PTR_ARG));
+    EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    IoTHubTransport_AMQP_Common_OnEventQueued(device_handle);
+
+    set_expected_calls_for_DoWork(&TEST_waitingToSend, 0, DEVICE_STATE_STARTED, true, true, true, true, 1, TEST_current_time, false);
+
+    // act
+    IoTHubTransport_AMQP_Common_DoWork(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_transport(handle, device_handle, NULL);
+}
+
+TEST_FUNCTION(DoWork_visits_idle_device_after_idle_interval)
+{
+    // arrange
+    initialize_test_variables();
+    IOTHUB_DEVICE_HANDLE device_handle;
+    TRANSPORT_LL_HANDLE handle = create_transport_with_idle_device(&device_handle);
+    time_t next_time = TEST_current_time + 1;
+
+    TEST_amqp_device_get_send_status_is_idle = false;
+
+    EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(next_time);
+    EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(get_difftime(next_time, TEST_current_time));
+    EXPECTED_CALL(DList_RemoveEntryList(IGNORED_PTR_ARG));
+    EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG));
+    EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG));
+    EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    set_expected_calls_for_Device_DoWork(&TEST_waitingToSend, 0, DEVICE_STATE_STARTED, true, next_time, false);
+    STRICT_EXPECTED_CALL(amqp_device_get_send_status(TEST_DEVICE_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_connection_do_work(TEST_AMQP_CONNECTION_HANDLE));
+
+    // act
+    IoTHubTransport_AMQP_Common_DoWork(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_transport(handle, device_handle, NULL);
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_016: [If `handle` is NULL, IoTHubTransport_AMQP_Common_DoWork shall return without doing any work]
 TEST_FUNCTION(DoWork_NULL_handle)
 {
@@ -4235,7 +4349,7 @@ TEST_FUNCTION(DoWork_get_underlying_io_transport_provider_fails)
     ASSERT_IS_NOT_NULL(device_handle);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_REGISTERED_DEVICES_LIST));
+    EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE))
         .SetReturn(TEST_IOTHUB_HOST_FQDN_CHAR_PTR);
     TEST_amqp_get_io_transport_result = NULL;
@@ -4542,8 +4656,6 @@ TEST_FUNCTION(ConnectionStatusCallBack_UNAUTH_retry_expired)
     STRICT_EXPECTED_CALL(retry_control_should_retry(TEST_RETRY_CONTROL_HANDLE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer_retry_action(&retry_action, sizeof(RETRY_ACTION));
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_foreach(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-
     STRICT_EXPECTED_CALL(Transport_ConnectionStatusCallBack(IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED, IOTHUB_CLIENT_CONNECTION_RETRY_EXPIRED, IGNORED_PTR_ARG));
 
     // act
@@ -4553,12 +4665,6 @@ TEST_FUNCTION(ConnectionStatusCallBack_UNAUTH_retry_expired)
 
     (void)IoTHubTransport_AMQP_Common_DoWork(handle);
 
-    bool continue_processing;
-    TEST_singlylinkedlist_foreach_action_function(
-        saved_registered_devices_list[saved_registered_devices_list_count - 1],
-        TEST_singlylinkedlist_foreach_context,
-        &continue_processing);
-
     // assert
     ASSERT_ARE_EQUAL(int, 0, result_set_retry_policy);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -5011,8 +5117,7 @@ TEST_FUNCTION(IoTHubTransport_AMQP_Common_GetTwinAsync_success)
     crank_transport_ready_after_create(handle, &TEST_waitingToSend, 0, false, true, 1, TEST_current_time, false);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(amqp_device_index_get_count(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(amqp_device_get_twin_async(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
@@ -5084,9 +5189,7 @@ TEST_FUNCTION(IoTHubTransport_AMQP_Common_GetTwinAsync_failure_checks)
     crank_transport_ready_after_create(handle, &TEST_waitingToSend, 0, false, true, 1, TEST_current_time, false);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_NUM_ARG))
-        .CallCannotFail();
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_NUM_ARG))
+    STRICT_EXPECTED_CALL(amqp_device_index_get_count(IGNORED_PTR_ARG))
         .CallCannotFail();
     STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(amqp_device_get_twin_async(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
@@ -0,0 +1,438 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#endif
+
+void* real_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void real_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umock_c_negative_tests.h"
+#include "umock_c/umocktypes_charptr.h"
+#include "umock_c/umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#undef ENABLE_MOCKS
+
+#include "internal/iothubtransport_amqp_device_index.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+#define TEST_DEVICE_ID                      "some-device"
+#define TEST_MODULE_ID                      "some-module"
+#define TEST_DEVICE                         (void*)0x4401
+#define TEST_MODULE                         (void*)0x4402
+#define TEST_OTHER_DEVICE                   (void*)0x4403
+// More devices than the index starts with buckets for, so it has to grow.
+#define TEST_MANY_DEVICES_COUNT             100
+
+BEGIN_TEST_SUITE(iothubtransport_amqp_device_index_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    int result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+    REGISTER_GLOBAL_MOCK_HOOK(free, real_free);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(amqp_device_index_create_succeeds)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+
+    // act
+    AMQP_DEVICE_INDEX_HANDLE index = amqp_device_index_create();
+
+    // assert
+    ASSERT_IS_NOT_NULL(index);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, amqp_device_index_get_count(index));
+
+    // cleanup
+    amqp_device_index_destroy(index);
+}
+
+TEST_FUNCTION(amqp_device_index_create_failure_checks)
+{
+    // arrange
+    ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+    umock_c_negative_tests_snapshot();
+
+    size_t i;
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        // act
+        AMQP_DEVICE_INDEX_HANDLE index = amqp_device_index_create();
+
+        // assert
+        ASSERT_IS_NULL(index, "On failed call %lu", (unsigned long)i);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+}
+
+TEST_FUNCTION(amqp_device_index_destroy_NULL_index)
+{
+    // act
+    amqp_device_index_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(amqp_device_index_destroy_frees_the_entries)
+{
+    // arrange
+    AMQP_DEVICE_INDEX_HANDLE index = amqp_device_index_create();
+    ASSERT_ARE_EQUAL(int, 0, amqp_device_index_add(index, TEST_DEVICE_ID, NULL, TEST_DEVICE));
+    ASSERT_ARE_EQUAL(int, 0, amqp_device_index_add(index, TEST_DEVICE_ID, TEST_MODULE_ID, TEST_MODULE));
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+
+    // act
+    amqp_device_index_destroy(index);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(amqp_device_index_add_NULL_arguments)
+{
+    // arrange
+    AMQP_DEVICE_INDEX_HANDLE index = amqp_device_index_create();
+    umock_c_reset_all_calls();
+
+    // act
+    int result1 = amqp_device_index_add(NULL, TEST_DEVICE_ID, NULL, TEST_DEVICE);
+    int result2 = amqp_device_index_add(index, NULL, NULL, TEST_DEVICE);
+    int result3 = amqp_device_index_add(index, TEST_DEVICE_ID, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result3);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, amqp_device_index_get_count(index));
+
+    // cleanup
+    amqp_device_index_destroy(index);
+}
+
+TEST_FUNCTION(amqp_device_index_add_succeeds)
+{
+    // arrange
+    AMQP_DEVICE_INDEX_HANDLE index = amqp_device_index_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+
+    // act
+    int result = amqp_device_index_add(index, TEST_DEVICE_ID, NULL, TEST_DEVICE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, amqp_device_index_get_count(index));
+    ASSERT_ARE_EQUAL(void_ptr, TEST_DEVICE, amqp_device_index_find(index, TEST_DEVICE_ID, NULL));
+
+    // cleanup
+    amqp_device_index_destroy(index);
+}
+
+TEST_FUNCTION(amqp_device_index_add_malloc_fails)
+{
+    // arrange
+    AMQP_DEVICE_INDEX_HANDLE index = amqp_device_index_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    int result = amqp_device_index_add(index, TEST_DEVICE_ID, NULL, TEST_DEVICE);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, amqp_device_index_get_count(index));
+    ASSERT_IS_NULL(amqp_device_index_find(index, TEST_DEVICE_ID, NULL));
+
+    // cleanup
+    amqp_device_index_destroy(index);
+}
+
+TEST_FUNCTION(amqp_device_index_add_device_already_in_index_fails)
+{
+    // arrange
+    AMQP_DEVICE_INDEX_HANDLE index = amqp_device_index_create();
+    ASSERT_ARE_EQUAL(int, 0, amqp_device_index_add(index, TEST_DEVICE_ID, TEST_MODULE_ID, TEST_MODULE));
+    umock_c_reset_all_calls();
+
+    // act
+    int result = amqp_device_index_add(index, TEST_DEVICE_ID, TEST_MODULE_ID, TEST_OTHER_DEVICE);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, amqp_device_index_get_count(index));
+    ASSERT_ARE_EQUAL(void_ptr, TEST_MODULE, amqp_device_index_find(index, TEST_DEVICE_ID, TEST_MODULE_ID));
+
+    // cleanup
+    amqp_device_index_destroy(index);
+}
+
+TEST_FUNCTION(amqp_device_index_find_distinguishes_device_and_its_modules)
+{
+    // arrange
+    AMQP_DEVICE_INDEX_HANDLE index = amqp_device_index_create();
+    ASSERT_ARE_EQUAL(int, 0, amqp_device_index_add(index, TEST_DEVICE_ID, NULL, TEST_DEVICE));
+    ASSERT_ARE_EQUAL(int, 0, amqp_device_index_add(index, TEST_DEVICE_ID, TEST_MODULE_ID, TEST_MODULE));
+    umock_c_reset_all_calls();
+
+    // act
+    void* device = amqp_device_index_find(index, TEST_DEVICE_ID, NULL);
+    void* module = amqp_device_index_find(index, TEST_DEVICE_ID, TEST_MODULE_ID);
+    void* other_module = amqp_device_index_find(index, TEST_DEVICE_ID, "other-module");
+    void* other_device = amqp_device_index_find(index, "other-device", NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_DEVICE, device);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_MODULE, module);
+    ASSERT_IS_NULL(other_module);
+    ASSERT_IS_NULL(other_device);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_device_index_destroy(index);
+}
+
+TEST_FUNCTION(amqp_device_index_find_NULL_arguments)
+{
+    // arrange
+    AMQP_DEVICE_INDEX_HANDLE index = amqp_device_index_create();
+    ASSERT_ARE_EQUAL(int, 0, amqp_device_index_add(index, TEST_DEVICE_ID, NULL, TEST_DEVICE));
+    umock_c_reset_all_calls();
+
+    // act
+    void* result1 = amqp_device_index_find(NULL, TEST_DEVICE_ID, NULL);
+    void* result2 = amqp_device_index_find(index, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(result1);
+    ASSERT_IS_NULL(result2);
+
+    // cleanup
+    amqp_device_index_destroy(index);
+}
+
+TEST_FUNCTION(amqp_device_index_remove_succeeds)
+{
+    // arrange
+    AMQP_DEVICE_INDEX_HANDLE index = amqp_device_index_create();
+    ASSERT_ARE_EQUAL(int, 0, amqp_device_index_add(index, TEST_DEVICE_ID, NULL, TEST_DEVICE));
+    ASSERT_ARE_EQUAL(int, 0, amqp_device_index_add(index, TEST_DEVICE_ID, TEST_MODULE_ID, TEST_MODULE));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+
+    // act
+    int result = amqp_device_index_remove(index, TEST_DEVICE_ID, TEST_MODULE_ID);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, amqp_device_index_get_count(index));
+    ASSERT_IS_NULL(amqp_device_index_find(index, TEST_DEVICE_ID, TEST_MODULE_ID));
+    ASSERT_ARE_EQUAL(void_ptr, TEST_DEVICE, amqp_device_index_find(index, TEST_DEVICE_ID, NULL));
+
+    // cleanup
+    amqp_device_index_destroy(index);
+}
+
+TEST_FUNCTION(amqp_device_index_remove_device_not_in_index_fails)
+{
+    // arrange
+    AMQP_DEVICE_INDEX_HANDLE index = amqp_device_index_create();
+    ASSERT_ARE_EQUAL(int, 0, amqp_device_index_add(index, TEST_DEVICE_ID, NULL, TEST_DEVICE));
+    umock_c_reset_all_calls();
+
+    // act
+    int result1 = amqp_device_index_remove(index, TEST_DEVICE_ID, TEST_MODULE_ID);
+    int result2 = amqp_device_index_remove(NULL, TEST_DEVICE_ID, NULL);
+    int result3 = amqp_device_index_remove(index, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result3);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, amqp_device_index_get_count(index));
+
+    // cleanup
+    amqp_device_index_destroy(index);
+}
+
+TEST_FUNCTION(amqp_device_index_get_count_NULL_index)
+{
+    // act
+    size_t result = amqp_device_index_get_count(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
+TEST_FUNCTION(amqp_device_index_keeps_all_devices_when_it_grows)
+{
+    // arrange
+    AMQP_DEVICE_INDEX_HANDLE index = amqp_device_index_create();
+    char device_ids[TEST_MANY_DEVICES_COUNT][32];
+    size_t i;
+
+    for (i = 0; i < TEST_MANY_DEVICES_COUNT; i++)
+    {
+        (void)sprintf(device_ids[i], "device-%lu", (unsigned long)i);
+    }
+
+    // act
+    for (i = 0; i < TEST_MANY_DEVICES_COUNT; i++)
+    {
+        ASSERT_ARE_EQUAL(int, 0, amqp_device_index_add(index, device_ids[i], NULL, &device_ids[i]));
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, TEST_MANY_DEVICES_COUNT, amqp_device_index_get_count(index));
+
+    for (i = 0; i < TEST_MANY_DEVICES_COUNT; i++)
+    {
+        ASSERT_ARE_EQUAL(void_ptr, &device_ids[i], amqp_device_index_find(index, device_ids[i], NULL));
+    }
+
+    for (i = 0; i < TEST_MANY_DEVICES_COUNT; i += 2)
+    {
+        ASSERT_ARE_EQUAL(int, 0, amqp_device_index_remove(index, device_ids[i], NULL));
+    }
+
+    ASSERT_ARE_EQUAL(size_t, TEST_MANY_DEVICES_COUNT / 2, amqp_device_index_get_count(index));
+
+    for (i = 0; i < TEST_MANY_DEVICES_COUNT; i++)
+    {
+        void* expected = (i % 2 == 0) ? NULL : &device_ids[i];
+        ASSERT_ARE_EQUAL(void_ptr, expected, amqp_device_index_find(index, device_ids[i], NULL));
+    }
+
+    // cleanup
+    amqp_device_index_destroy(index);
+}
+
+TEST_FUNCTION(amqp_device_index_growth_failure_keeps_the_index_working)
+{
+    // arrange
+    AMQP_DEVICE_INDEX_HANDLE index = amqp_device_index_create();
+    char device_ids[17][32];
+    size_t i;
+
+    for (i = 0; i < 17; i++)
+    {
+        (void)sprintf(device_ids[i], "device-%lu", (unsigned long)i);
+    }
+
+    for (i = 0; i < 16; i++)
+    {
+        ASSERT_ARE_EQUAL(int, 0, amqp_device_index_add(index, device_ids[i], NULL, &device_ids[i]));
+    }
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    int result = amqp_device_index_add(index, device_ids[16], NULL, &device_ids[16]);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 17, amqp_device_index_get_count(index));
+
+    for (i = 0; i < 17; i++)
+    {
+        ASSERT_ARE_EQUAL(void_ptr, &device_ids[i], amqp_device_index_find(index, device_ids[i], NULL));
+    }
+
+    // cleanup
+    amqp_device_index_destroy(index);
+}
+
+END_TEST_SUITE(iothubtransport_amqp_device_index_ut)
@@ -1250,4 +1250,21 @@ TEST_FUNCTION(AMQP_GetSupportedPlatformInfo_NULL_info)
     // cleanup
 }
 
+TEST_FUNCTION(AMQP_OnEventQueued)
+{
+    // arrange
+    TRANSPORT_PROVIDER* provider = (TRANSPORT_PROVIDER*)AMQP_Protocol_over_WebSocketsTls();
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(IoTHubTransport_AMQP_Common_OnEventQueued(TEST_IOTHUB_DEVICE_HANDLE));
+
+    // act
+    provider->IoTHubTransport_OnEventQueued(TEST_IOTHUB_DEVICE_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+}
+
 END_TEST_SUITE(iothubtransportamqp_ws_ut)
@@ -12,6 +12,7 @@
 #endif
 
 #include <stdbool.h>
+#include <signal.h>
 
 #include "testrunnerswitcher.h"
 #include "umock_c/umock_c.h"
@@ -45,7 +46,9 @@ static void my_gballoc_free(void* ptr)
 #include "azure_c_shared_utility/vector.h"
 #include "azure_c_shared_utility/vector_types_internal.h"
 #include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
 #include "azure_c_shared_utility/agenttime.h"
+#include "azure_c_shared_utility/threadapi.h"
 
 #include "iothub_client_options.h"
 #include "iothub_client_version.h"
@@ -54,6 +57,7 @@ static void my_gballoc_free(void* ptr)
 #include "internal/iothubtransport.h"
 
 #include "internal/iothub_transport_ll_private.h"
+#include "internal/http_batch_encoder.h"
 
 MOCKABLE_FUNCTION(, bool, Transport_MessageCallbackFromInput, MESSAGE_CALLBACK_INFO*, messageData, void*, ctx);
 MOCKABLE_FUNCTION(, bool, Transport_MessageCallback, MESSAGE_CALLBACK_INFO*, messageData, void*, ctx);
@@ -82,6 +86,10 @@ extern "C" {
     extern int real_BUFFER_append_build(BUFFER_HANDLE handle, const unsigned char* source, size_t size);
     extern BUFFER_HANDLE real_BUFFER_clone(BUFFER_HANDLE handle);
     extern BUFFER_HANDLE real_BUFFER_create(const unsigned char* source, size_t size);
+    extern int real_BUFFER_pre_build(BUFFER_HANDLE handle, size_t size);
+    extern int real_BUFFER_shrink(BUFFER_HANDLE handle, size_t decreaseSize, bool fromEnd);
+
+    extern const size_t IoTHubTransportHttp_WorkerTerminationOffset;
 
     extern int real_mallocAndStrcpy_s(char** destination, const char* source);
     extern int real_size_tToString(char* destination, size_t destinationSize, size_t value);
@@ -157,6 +165,9 @@ IMPLEMENT_UMOCK_C_ENUM_TYPE(PLATFORM_INFO_OPTION, PLATFORM_INFO_OPTION_VALUES);
 #define TEST_PROPERTY_A_VALUE "value_of_a"
 
 #define TEST_HTTPAPIEX_HANDLE (HTTPAPIEX_HANDLE)0x343
+#define TEST_THREAD_HANDLE (THREAD_HANDLE)0x344
+#define TEST_LOCK_HANDLE (LOCK_HANDLE)0x345
+#define TEST_COND_HANDLE (COND_HANDLE)0x346
 
 //static const bool thisIsTrue = true;
 //static const bool thisIsFalse = false;
@@ -551,6 +562,38 @@ static void my_HTTPAPIEX_Destroy(HTTPAPIEX_HANDLE handle)
     my_gballoc_free(handle);
 }
 
+static THREAD_START_FUNC g_worker_thread_func;
+static void* g_worker_thread_arg;
+static bool g_in_worker_thread;
+
+static THREADAPI_RESULT my_ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    *threadHandle = TEST_THREAD_HANDLE;
+    g_worker_thread_func = func;
+    g_worker_thread_arg = arg;
+    return THREADAPI_OK;
+}
+
+/*waiting for the workers runs the last worker thread created, so that the calls it makes are in a known order. That thread
+waiting for its next job stops it*/
+static COND_RESULT my_Condition_Wait(COND_HANDLE handle, LOCK_HANDLE lock, int timeout_milliseconds)
+{
+    (void)handle;
+    (void)lock;
+    (void)timeout_milliseconds;
+    if (g_in_worker_thread)
+    {
+        *(sig_atomic_t*)(((char*)g_worker_thread_arg) + IoTHubTransportHttp_WorkerTerminationOffset) = 1; /*tell the thread to stop*/
+    }
+    else if (g_worker_thread_func != NULL)
+    {
+        g_in_worker_thread = true;
+        (void)g_worker_thread_func(g_worker_thread_arg);
+        g_in_worker_thread = false;
+    }
+    return COND_OK;
+}
+
 static IOTHUB_CLIENT_RESULT my_IoTHubClientCore_LL_GetOption(IOTHUB_CLIENT_CORE_LL_HANDLE handle, const char* option, void** value)
 {
     (void)handle;
@@ -1173,6 +1216,13 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(PDLIST_ENTRY, void*);
     REGISTER_UMOCK_ALIAS_TYPE(const PDLIST_ENTRY, void*);
     REGISTER_UMOCK_ALIAS_TYPE(HTTPAPIEX_SAS_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREADAPI_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_RESULT, int);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(HTTPAPI_REQUEST_TYPE, int);
 
@@ -1197,6 +1247,9 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_length, real_BUFFER_length);
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_clone, real_BUFFER_clone);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(BUFFER_clone, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_pre_build, real_BUFFER_pre_build);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(BUFFER_pre_build, __LINE__);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_shrink, real_BUFFER_shrink);
 
     REGISTER_STRING_GLOBAL_MOCK_HOOK;
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(STRING_new, NULL);
@@ -1218,6 +1271,18 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(HTTPAPIEX_Create, NULL);
     REGISTER_GLOBAL_MOCK_HOOK(HTTPAPIEX_Destroy, my_HTTPAPIEX_Destroy);
 
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Create, my_ThreadAPI_Create);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(ThreadAPI_Create, THREADAPI_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(ThreadAPI_Join, THREADAPI_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Init, TEST_COND_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Condition_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Post, COND_OK);
+    REGISTER_GLOBAL_MOCK_HOOK(Condition_Wait, my_Condition_Wait);
+
     REGISTER_GLOBAL_MOCK_HOOK(VECTOR_create, real_VECTOR_create);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(VECTOR_create, NULL);
     REGISTER_GLOBAL_MOCK_HOOK(VECTOR_destroy, real_VECTOR_destroy);
@@ -1352,6 +1417,9 @@ static void reset_test_data()
 {
     last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest = NULL;
     my_IoTHubClientCore_LL_MessageCallback_messageData = NULL;
+    g_worker_thread_func = NULL;
+    g_worker_thread_arg = NULL;
+    g_in_worker_thread = false;
 }
 
 typedef struct MESSAGE_DISPOSITION_CONTEXT_TAG
@@ -14326,6 +14394,530 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_GetContentEncoding_succeeds)
     IoTHubTransportHttp_Destroy(handle);
 }
 
+TEST_FUNCTION(IoTHubTransportHttp_SetOption_max_parallel_requests_creates_a_connection_and_a_thread_per_extra_request)
+{
+    //arrange
+    size_t maxParallelRequests = 3;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_MAX_PARALLEL_REQUESTS, &maxParallelRequests);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubTransportHttp_SetOption_max_parallel_requests_fails_when_a_connection_cannot_be_created)
+{
+    //arrange
+    size_t maxParallelRequests = 3;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create(IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_MAX_PARALLEL_REQUESTS, &maxParallelRequests);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubTransportHttp_SetOption_max_parallel_requests_fails_when_the_lock_cannot_be_created)
+{
+    //arrange
+    size_t maxParallelRequests = 2;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_MAX_PARALLEL_REQUESTS, &maxParallelRequests);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubTransportHttp_SetOption_max_parallel_requests_0_fails)
+{
+    //arrange
+    size_t maxParallelRequests = 0;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_MAX_PARALLEL_REQUESTS, &maxParallelRequests);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubTransportHttp_SetOption_max_parallel_requests_raised_after_a_connection_option_is_set_fails)
+{
+    //arrange
+    size_t maxParallelRequests = 2;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    (void)IoTHubTransportHttp_SetOption(handle, "someOption", (void*)42);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_MAX_PARALLEL_REQUESTS, &maxParallelRequests);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubTransportHttp_SetOption_max_parallel_requests_raised_after_a_failed_connection_option_succeeds)
+{
+    //arrange
+    size_t maxParallelRequests = 2;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    STRICT_EXPECTED_CALL(HTTPAPIEX_SetOption(IGNORED_PTR_ARG, "someOption", (void*)42))
+        .SetReturn(HTTPAPIEX_ERROR);
+    (void)IoTHubTransportHttp_SetOption(handle, "someOption", (void*)42);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_MAX_PARALLEL_REQUESTS, &maxParallelRequests);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubTransportHttp_SetOption_passes_the_option_to_every_connection)
+{
+    //arrange
+    size_t maxParallelRequests = 2;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_MAX_PARALLEL_REQUESTS, &maxParallelRequests);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(HTTPAPIEX_SetOption(IGNORED_PTR_ARG, "someOption", (void*)42));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_SetOption(IGNORED_PTR_ARG, "someOption", (void*)42));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransportHttp_SetOption(handle, "someOption", (void*)42);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubTransportHttp_Destroy_stops_the_threads_and_destroys_the_connections_of_parallel_requests)
+{
+    //arrange
+    size_t maxParallelRequests = 2;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_MAX_PARALLEL_REQUESTS, &maxParallelRequests);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Deinit());
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    //act
+    IoTHubTransportHttp_Destroy(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*both devices report events waiting, so DoWork spreads them over the workers*/
+static void setupPendingWorkForBothDevices(void)
+{
+    setupDoWorkLoopForNextDevice(0);
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend))
+        .SetReturn(0);
+    setupDoWorkLoopForNextDevice(1);
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend2))
+        .SetReturn(0);
+}
+
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_max_parallel_requests_and_no_pending_work_does_not_create_threads)
+{
+    //arrange
+    size_t maxParallelRequests = 2;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_MAX_PARALLEL_REQUESTS, &maxParallelRequests);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_2, TEST_CONFIG2.waitingToSend);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG));
+    setupDoWorkLoopForNextDevice(0);
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend));
+    setupDoWorkLoopForNextDevice(1);
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend2));
+    setupDoWorkLoopForNextDevice(0);
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend));
+    setupDoWorkLoopForNextDevice(1);
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend2));
+
+    //act
+    IoTHubTransportHttp_DoWork(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_max_parallel_requests_serves_each_device_on_a_worker_thread)
+{
+    //arrange
+    size_t maxParallelRequests = 2;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_MAX_PARALLEL_REQUESTS, &maxParallelRequests);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_2, TEST_CONFIG2.waitingToSend);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG));
+    setupPendingWorkForBothDevices();
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    setupDoWorkLoopForNextDevice(0);
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    /*the thread of the second worker, created by SetOption, runs while the calling thread waits*/
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, 0));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    setupDoWorkLoopForNextDevice(1);
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend2));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, 0));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    //act
+    IoTHubTransportHttp_DoWork(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_max_parallel_requests_serves_the_devices_inline_when_the_thread_fails)
+{
+    //arrange
+    size_t maxParallelRequests = 2;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(THREADAPI_ERROR);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_MAX_PARALLEL_REQUESTS, &maxParallelRequests);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_2, TEST_CONFIG2.waitingToSend);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG));
+    setupPendingWorkForBothDevices();
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    setupDoWorkLoopForNextDevice(0);
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend));
+    setupDoWorkLoopForNextDevice(1);
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend2));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    //act
+    IoTHubTransportHttp_DoWork(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+static const size_t TEST_ENCODED_SIZE_1 = 10;
+static const size_t TEST_ENCODED_SIZE_2 = 12;
+static const size_t TEST_BATCHED_MESSAGE_SIZE = 400;
+static const size_t TEST_OVERSIZED_MESSAGE_SIZE = 255 * 1024;
+
+static void setupBatchedDoEvent(void)
+{
+    setupDoWorkLoopOnceForOneDevice();
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend));
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"));
+}
+
+static void setupBatchedExecuteRequest(void)
+{
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(IGNORED_PTR_ARG, IGNORED_PTR_ARG, HTTPAPI_REQUEST_POST, "/devices/" TEST_DEVICE_ID EVENT_ENDPOINT API_VERSION, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL, NULL))
+        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200));
+    STRICT_EXPECTED_CALL(Transport_SendComplete_Callback(IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_17_056: [IoTHubTransportHttp_DoWork shall build the following string:[{"body":"base64 encoding of the message1 content"},{"body":"base64 encoding of the message2 content"}...]]
+//Tests_SRS_TRANSPORTMULTITHTTP_17_070: [If HTTPAPIEX_SAS_ExecuteRequest does not fail and http status code <300 then IoTHubTransportHttp_DoWork shall call IoTHubClientCore_LL_SendComplete. Parameter PDLIST_ENTRY completed shall point to a list containing all the items batched, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_OK. The batched items shall be removed from waitingToSend.]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_batched_writes_all_the_items_into_one_payload)
+{
+    //arrange
+    bool batching = true;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    DList_InsertTailList(&(waitingToSend), &(message2.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_BATCHING, &batching);
+    umock_c_reset_all_calls();
+
+    setupBatchedDoEvent();
+    /*the items are measured, then the payload is allocated once and the items are written into it*/
+    STRICT_EXPECTED_CALL(http_batch_encoder_measure(TEST_IOTHUB_MESSAGE_HANDLE_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_encoded_size(&TEST_ENCODED_SIZE_1, sizeof(TEST_ENCODED_SIZE_1))
+        .CopyOutArgumentBuffer_message_size(&TEST_BATCHED_MESSAGE_SIZE, sizeof(TEST_BATCHED_MESSAGE_SIZE));
+    STRICT_EXPECTED_CALL(http_batch_encoder_measure(TEST_IOTHUB_MESSAGE_HANDLE_2, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_encoded_size(&TEST_ENCODED_SIZE_2, sizeof(TEST_ENCODED_SIZE_2))
+        .CopyOutArgumentBuffer_message_size(&TEST_BATCHED_MESSAGE_SIZE, sizeof(TEST_BATCHED_MESSAGE_SIZE));
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    STRICT_EXPECTED_CALL(BUFFER_pre_build(IGNORED_PTR_ARG, 1 + TEST_ENCODED_SIZE_1 + TEST_ENCODED_SIZE_2));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(http_batch_encoder_write(TEST_IOTHUB_MESSAGE_HANDLE_1, IGNORED_PTR_ARG, TEST_ENCODED_SIZE_1 + TEST_ENCODED_SIZE_2))
+        .SetReturn(TEST_ENCODED_SIZE_1);
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(&waitingToSend));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)));
+    STRICT_EXPECTED_CALL(http_batch_encoder_write(TEST_IOTHUB_MESSAGE_HANDLE_2, IGNORED_PTR_ARG, TEST_ENCODED_SIZE_2))
+        .SetReturn(TEST_ENCODED_SIZE_2);
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(&waitingToSend));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, &(message2.entry)));
+    setupBatchedExecuteRequest();
+
+    //act
+    IoTHubTransportHttp_DoWork(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1 + TEST_ENCODED_SIZE_1 + TEST_ENCODED_SIZE_2, real_BUFFER_length(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest));
+    ASSERT_ARE_EQUAL(int, '[', real_BUFFER_u_char(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest)[0]);
+    ASSERT_ARE_EQUAL(int, ']', real_BUFFER_u_char(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest)[TEST_ENCODED_SIZE_1 + TEST_ENCODED_SIZE_2]);
+    ASSERT_IS_TRUE(DList_IsListEmpty(&waitingToSend));
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_17_061: [The message size shall be limited to 255KB - 1 byte.]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_batched_leaves_the_items_that_do_not_fit_in_waitingToSend)
+{
+    //arrange
+    bool batching = true;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    DList_InsertTailList(&(waitingToSend), &(message2.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_BATCHING, &batching);
+    umock_c_reset_all_calls();
+
+    setupBatchedDoEvent();
+    STRICT_EXPECTED_CALL(http_batch_encoder_measure(TEST_IOTHUB_MESSAGE_HANDLE_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_encoded_size(&TEST_ENCODED_SIZE_1, sizeof(TEST_ENCODED_SIZE_1))
+        .CopyOutArgumentBuffer_message_size(&TEST_BATCHED_MESSAGE_SIZE, sizeof(TEST_BATCHED_MESSAGE_SIZE));
+    STRICT_EXPECTED_CALL(http_batch_encoder_measure(TEST_IOTHUB_MESSAGE_HANDLE_2, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_encoded_size(&TEST_ENCODED_SIZE_2, sizeof(TEST_ENCODED_SIZE_2))
+        .CopyOutArgumentBuffer_message_size(&TEST_OVERSIZED_MESSAGE_SIZE, sizeof(TEST_OVERSIZED_MESSAGE_SIZE));
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    STRICT_EXPECTED_CALL(BUFFER_pre_build(IGNORED_PTR_ARG, 1 + TEST_ENCODED_SIZE_1));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(http_batch_encoder_write(TEST_IOTHUB_MESSAGE_HANDLE_1, IGNORED_PTR_ARG, TEST_ENCODED_SIZE_1))
+        .SetReturn(TEST_ENCODED_SIZE_1);
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(&waitingToSend));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)));
+    setupBatchedExecuteRequest();
+
+    //act
+    IoTHubTransportHttp_DoWork(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, &(message2.entry), waitingToSend.Flink);
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_batched_shrinks_the_payload_when_an_item_cannot_be_written)
+{
+    //arrange
+    bool batching = true;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    DList_InsertTailList(&(waitingToSend), &(message2.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_BATCHING, &batching);
+    umock_c_reset_all_calls();
+
+    setupBatchedDoEvent();
+    STRICT_EXPECTED_CALL(http_batch_encoder_measure(TEST_IOTHUB_MESSAGE_HANDLE_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_encoded_size(&TEST_ENCODED_SIZE_1, sizeof(TEST_ENCODED_SIZE_1))
+        .CopyOutArgumentBuffer_message_size(&TEST_BATCHED_MESSAGE_SIZE, sizeof(TEST_BATCHED_MESSAGE_SIZE));
+    STRICT_EXPECTED_CALL(http_batch_encoder_measure(TEST_IOTHUB_MESSAGE_HANDLE_2, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_encoded_size(&TEST_ENCODED_SIZE_2, sizeof(TEST_ENCODED_SIZE_2))
+        .CopyOutArgumentBuffer_message_size(&TEST_BATCHED_MESSAGE_SIZE, sizeof(TEST_BATCHED_MESSAGE_SIZE));
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    STRICT_EXPECTED_CALL(BUFFER_pre_build(IGNORED_PTR_ARG, 1 + TEST_ENCODED_SIZE_1 + TEST_ENCODED_SIZE_2));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(http_batch_encoder_write(TEST_IOTHUB_MESSAGE_HANDLE_1, IGNORED_PTR_ARG, TEST_ENCODED_SIZE_1 + TEST_ENCODED_SIZE_2))
+        .SetReturn(TEST_ENCODED_SIZE_1);
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(&waitingToSend));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)));
+    STRICT_EXPECTED_CALL(http_batch_encoder_write(TEST_IOTHUB_MESSAGE_HANDLE_2, IGNORED_PTR_ARG, TEST_ENCODED_SIZE_2))
+        .SetReturn(0);
+    STRICT_EXPECTED_CALL(BUFFER_shrink(IGNORED_PTR_ARG, TEST_ENCODED_SIZE_2, true));
+    setupBatchedExecuteRequest();
+
+    //act
+    IoTHubTransportHttp_DoWork(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1 + TEST_ENCODED_SIZE_1, real_BUFFER_length(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest));
+    ASSERT_ARE_EQUAL(int, ']', real_BUFFER_u_char(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest)[TEST_ENCODED_SIZE_1]);
+    ASSERT_ARE_EQUAL(void_ptr, &(message2.entry), waitingToSend.Flink);
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_17_065: [If the oldest message in waitingToSend causes the message size to exceed the message size limit then it shall be removed from waitingToSend, and IoTHubClientCore_LL_SendComplete shall be called. Parameter PDLIST_ENTRY completed shall point to a list containing only the oldest item, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_BATCHSTATE_FAILED.]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_batched_with_the_first_item_too_big_completes_it_with_error)
+{
+    //arrange
+    bool batching = true;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_BATCHING, &batching);
+    umock_c_reset_all_calls();
+
+    setupBatchedDoEvent();
+    STRICT_EXPECTED_CALL(http_batch_encoder_measure(TEST_IOTHUB_MESSAGE_HANDLE_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_encoded_size(&TEST_ENCODED_SIZE_1, sizeof(TEST_ENCODED_SIZE_1))
+        .CopyOutArgumentBuffer_message_size(&TEST_OVERSIZED_MESSAGE_SIZE, sizeof(TEST_OVERSIZED_MESSAGE_SIZE));
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(&waitingToSend));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)));
+    STRICT_EXPECTED_CALL(Transport_SendComplete_Callback(IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_ERROR, IGNORED_PTR_ARG));
+
+    //act
+    IoTHubTransportHttp_DoWork(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_batched_when_the_first_item_cannot_be_encoded_sends_nothing)
+{
+    //arrange
+    bool batching = true;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG, &transport_cb_info, transport_cb_ctx);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_BATCHING, &batching);
+    umock_c_reset_all_calls();
+
+    setupBatchedDoEvent();
+    STRICT_EXPECTED_CALL(http_batch_encoder_measure(TEST_IOTHUB_MESSAGE_HANDLE_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(MU_FAILURE);
+
+    //act
+    IoTHubTransportHttp_DoWork(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, &(message1.entry), waitingToSend.Flink);
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
 /*Tests_SRS_TRANSPORTMULTITHTTP_02_001: [ If handle is NULL then IoTHubTransportHttp_GetHostname shall fail and return NULL. ]*/
 TEST_FUNCTION(IoTHubTransportHttp_GetHostname_with_NULL_handle_fails)
 {
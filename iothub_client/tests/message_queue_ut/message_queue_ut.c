@@ -343,50 +343,22 @@ static void set_process_timeouts_expected_calls(MESSAGE_QUEUE_HANDLE mq, time_t
 
     if (expiration_profile->max_message_enqueued_time_secs > 0)
     {
-        size_t i, j;
-
-        // pending messages, max queued time
-        STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+        size_t i;
+        size_t number_of_expired_messages = expiration_profile->expired_pending_messages_size + expiration_profile->expired_enqueued_in_progress_messages_size;
 
-        for (i = 0, j = 0; i < number_of_messages_pending; i++)
+        // messages are checked oldest first, across both lists, until one has not expired.
+        for (i = 0; i < number_of_expired_messages; i++)
         {
-            STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-            STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
-
-            if (j < expiration_profile->expired_pending_messages_size && i == expiration_profile->expired_pending_messages[j])
-            {
-                STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).SetReturn(expiration_profile->max_message_enqueued_time_secs + 1);
-                set_dequeue_message_and_fire_callback_expected_calls();
-                number_of_messages_pending--;
-                j++;
-            }
-            else
-            {
-                STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).SetReturn(0);
-                break;
-            }
+            STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).SetReturn(expiration_profile->max_message_enqueued_time_secs + 1);
+            set_dequeue_message_and_fire_callback_expected_calls();
         }
 
-        // in progress messages, max queued time
-        STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+        number_of_messages_pending -= expiration_profile->expired_pending_messages_size;
+        number_of_messages_in_progress -= expiration_profile->expired_enqueued_in_progress_messages_size;
 
-        for (i = 0, j = 0; i < number_of_messages_in_progress; i++)
+        if (number_of_messages_pending + number_of_messages_in_progress > 0)
         {
-            STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-            STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
-
-            if (j < expiration_profile->expired_enqueued_in_progress_messages_size && i == expiration_profile->expired_enqueued_in_progress_messages[j])
-            {
-                STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).SetReturn(expiration_profile->max_message_enqueued_time_secs + 1);
-                set_dequeue_message_and_fire_callback_expected_calls();
-                //set_dequeue_message_and_fire_callback_expected_calls(number_of_messages_in_progress, expiration_profile->expired_enqueued_in_progress_messages[j] - i, false);
-                number_of_messages_in_progress--;
-                j++;
-            }
-            else
-            {
-                STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).SetReturn(0);
-            }
+            STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).SetReturn(0);
         }
     }
 
@@ -1603,6 +1575,103 @@ TEST_FUNCTION(do_work_in_progress_queue_timeout)
     message_queue_destroy(mq);
 }
 
+// Tests_SRS_MESSAGE_QUEUE_09_036: [If any items are in `message_queue` lists for `message_queue->max_message_enqueued_time_secs` or more, they shall be removed and `message_queue->on_message_processing_completed_callback` invoked with MESSAGE_QUEUE_TIMEOUT]
+TEST_FUNCTION(do_work_queue_timeout_stops_at_first_unexpired_message)
+{
+    // arrange
+    MESSAGE_QUEUE_HANDLE mq = create_message_queue(USE_DEFAULT_CONFIG);
+
+    add_messages(mq, 2, TEST_current_time);
+    crank_message_queue(mq, TEST_current_time, 2, 0, NULL);
+    add_messages(mq, 3, TEST_current_time);
+
+    (void)message_queue_set_max_message_enqueued_time_secs(mq, 10);
+
+    time_t t1 = add_seconds(TEST_current_time, 10);
+
+    TEST_MESSAGE_EXPIRATION_PROFILE exp_prof;
+    exp_prof.max_message_enqueued_time_secs = 10;
+    exp_prof.max_message_processing_time_secs = 0;
+    exp_prof.expired_pending_messages = NULL;
+    exp_prof.expired_pending_messages_size = 0;
+    exp_prof.expired_in_progress_messages = NULL;
+    exp_prof.expired_in_progress_messages_size = 0;
+    size_t expired_enqueued_in_progress_messages[] = { 0 };
+    exp_prof.expired_enqueued_in_progress_messages = expired_enqueued_in_progress_messages;
+    exp_prof.expired_enqueued_in_progress_messages_size = 1;
+
+    umock_c_reset_all_calls();
+    // the oldest in-progress message expires, the next one does not and none of the pending ones are looked at.
+    set_process_timeouts_expected_calls(mq, t1, 3, 2, &exp_prof);
+    set_process_pending_messages_calls(mq, t1, 3);
+
+    // act
+    message_queue_do_work(mq);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 1, (int)TEST_on_message_processing_completed_callback_TIMEOUT_result_count);
+
+    // cleanup
+    message_queue_destroy(mq);
+}
+
+TEST_FUNCTION(do_work_after_failing_to_move_a_message_out_of_pending_still_times_out_the_others)
+{
+    // arrange
+    MESSAGE_QUEUE_HANDLE mq = create_message_queue(USE_DEFAULT_CONFIG);
+    (void)message_queue_set_max_message_enqueued_time_secs(mq, 10);
+
+    add_messages(mq, 2, TEST_current_time);
+
+    time_t t1 = add_seconds(TEST_current_time, 10);
+
+    TEST_MESSAGE_EXPIRATION_PROFILE no_exp_prof;
+    no_exp_prof.max_message_enqueued_time_secs = 10;
+    no_exp_prof.max_message_processing_time_secs = 0;
+    no_exp_prof.expired_pending_messages = NULL;
+    no_exp_prof.expired_pending_messages_size = 0;
+    no_exp_prof.expired_in_progress_messages = NULL;
+    no_exp_prof.expired_in_progress_messages_size = 0;
+    no_exp_prof.expired_enqueued_in_progress_messages = NULL;
+    no_exp_prof.expired_enqueued_in_progress_messages_size = 0;
+
+    TEST_MESSAGE_EXPIRATION_PROFILE exp_prof = no_exp_prof;
+    size_t expired_enqueued_in_progress_messages[] = { 0 };
+    exp_prof.expired_enqueued_in_progress_messages = expired_enqueued_in_progress_messages;
+    exp_prof.expired_enqueued_in_progress_messages_size = 1;
+
+    // the first message fails to leave pending, which unlinks it from the enqueue order while it stays on the list.
+    umock_c_reset_all_calls();
+    set_process_timeouts_expected_calls(mq, TEST_current_time, 2, 0, &no_exp_prof);
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(1);
+    message_queue_do_work(mq);
+
+    // both messages then go in progress and the first one completes, which must leave the second one in the enqueue order.
+    crank_message_queue(mq, TEST_current_time, 2, 0, &no_exp_prof);
+    umock_c_reset_all_calls();
+    set_on_message_processing_completed_callback_expected_calls(2, 0, false);
+    TEST_on_process_message_callback_on_process_message_completed_callback(mq, TEST_BASE_MQ_MESSAGE_HANDLE[0], MESSAGE_QUEUE_SUCCESS, NULL);
+
+    umock_c_reset_all_calls();
+    set_process_timeouts_expected_calls(mq, t1, 0, 1, &exp_prof);
+    set_process_pending_messages_calls(mq, t1, 0);
+
+    // act
+    message_queue_do_work(mq);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 1, (int)TEST_on_message_processing_completed_callback_SUCCESS_result_count);
+    ASSERT_ARE_EQUAL(int, 1, (int)TEST_on_message_processing_completed_callback_ERROR_result_count);
+    ASSERT_ARE_EQUAL(int, 1, (int)TEST_on_message_processing_completed_callback_TIMEOUT_result_count);
+
+    // cleanup
+    message_queue_destroy(mq);
+}
+
 // Tests_SRS_MESSAGE_QUEUE_21_070: [The message_queue_move_all_back_to_pending shall add all in_progress message in front of the pending messages.]
 TEST_FUNCTION(message_queue_move_all_back_to_pending_with_in_progress_and_pending_succeed)
 {
@@ -0,0 +1,533 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+static void* real_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void real_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umocktypes_charptr.h"
+#include "umock_c/umocktypes_stdint.h"
+#include "umock_c/umocktypes_bool.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/map.h"
+#include "iothub_message.h"
+#undef ENABLE_MOCKS
+
+#include "internal/persistent_queue.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+// Data definitions
+
+#define TEST_MAP_HANDLE                     (MAP_HANDLE)0x4441
+#define TEST_SEGMENT_SIZE                   1048576
+#define TEST_SMALL_SEGMENT_SIZE             16 /*every record gets a segment of its own*/
+
+static const char* TEST_QUEUE_PATH = "persistent_queue_ut_queue";
+static const char* TEST_PROPERTY_KEY = "key";
+static const char* TEST_PROPERTY_VALUE = "value";
+static const char* const TEST_PROPERTY_KEYS[] = { "key" };
+static const char* const TEST_PROPERTY_VALUES[] = { "value" };
+
+/*stands in for a message, IOTHUB_MESSAGE_HANDLEs given to and returned by the queue point to one of these*/
+typedef struct TEST_MESSAGE_TAG
+{
+    unsigned char content[64];
+    size_t content_size;
+    bool is_string;
+    char message_id[64];
+    bool has_message_id;
+    size_t properties_set;
+} TEST_MESSAGE;
+
+// Helpers
+
+static IOTHUB_MESSAGE_HANDLE create_test_message(const char* content, const char* message_id)
+{
+    TEST_MESSAGE* message = (TEST_MESSAGE*)real_malloc(sizeof(TEST_MESSAGE));
+    ASSERT_IS_NOT_NULL(message);
+    memset(message, 0, sizeof(TEST_MESSAGE));
+    message->content_size = strlen(content);
+    (void)memcpy(message->content, content, message->content_size);
+    if (message_id != NULL)
+    {
+        (void)strcpy(message->message_id, message_id);
+        message->has_message_id = true;
+    }
+    return (IOTHUB_MESSAGE_HANDLE)message;
+}
+
+static void assert_test_message(IOTHUB_MESSAGE_HANDLE handle, const char* content, const char* message_id)
+{
+    TEST_MESSAGE* message = (TEST_MESSAGE*)handle;
+    ASSERT_IS_NOT_NULL(message);
+    ASSERT_ARE_EQUAL(size_t, strlen(content), message->content_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(content, message->content, message->content_size));
+    ASSERT_ARE_EQUAL(size_t, 1, message->properties_set);
+    if (message_id == NULL)
+    {
+        ASSERT_IS_FALSE(message->has_message_id);
+    }
+    else
+    {
+        ASSERT_IS_TRUE(message->has_message_id);
+        ASSERT_ARE_EQUAL(char_ptr, message_id, message->message_id);
+    }
+}
+
+static void append_test_message(PERSISTENT_QUEUE_HANDLE queue, const char* content, const char* message_id, uint64_t* record_id)
+{
+    IOTHUB_MESSAGE_HANDLE message = create_test_message(content, message_id);
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_append(queue, message, record_id));
+    real_free(message);
+}
+
+static void read_test_message(PERSISTENT_QUEUE_HANDLE queue, const char* content, const char* message_id, uint64_t* record_id)
+{
+    IOTHUB_MESSAGE_HANDLE message;
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_read(queue, &message, record_id));
+    assert_test_message(message, content, message_id);
+    real_free(message);
+}
+
+static const char* get_segment_file_name(uint64_t segment)
+{
+    static char name[256];
+    (void)snprintf(name, sizeof(name), "%s.%08lx%08lx.log", TEST_QUEUE_PATH, (unsigned long)(segment >> 32), (unsigned long)(segment & 0xFFFFFFFF));
+    return name;
+}
+
+static bool segment_file_exists(uint64_t segment)
+{
+    FILE* file = fopen(get_segment_file_name(segment), "rb");
+    if (file != NULL)
+    {
+        (void)fclose(file);
+    }
+    return file != NULL;
+}
+
+/*deletes the checkpoint and the segments of the log, which start at the segment of the checkpoint (or at its offset once that
+segment has been deleted) and follow each other*/
+static void delete_queue_files(void)
+{
+    char name[256];
+    uint64_t segment = 0;
+    FILE* file;
+
+    (void)snprintf(name, sizeof(name), "%s.checkpoint", TEST_QUEUE_PATH);
+    if ((file = fopen(name, "rb")) != NULL)
+    {
+        unsigned char checkpoint[16];
+        if (fread(checkpoint, 1, sizeof(checkpoint), file) == sizeof(checkpoint))
+        {
+            uint64_t offset = 0;
+            int i;
+            for (i = 7; i >= 0; i--)
+            {
+                segment = (segment << 8) | checkpoint[i];
+                offset = (offset << 8) | checkpoint[8 + i];
+            }
+            if (!segment_file_exists(segment))
+            {
+                segment = offset;
+            }
+        }
+        (void)fclose(file);
+    }
+    (void)remove(name);
+    (void)snprintf(name, sizeof(name), "%s.checkpoint.tmp", TEST_QUEUE_PATH);
+    (void)remove(name);
+
+    while ((file = fopen(get_segment_file_name(segment), "rb")) != NULL)
+    {
+        long size = ((fseek(file, 0, SEEK_END) == 0) ? ftell(file) : 0);
+        (void)fclose(file);
+        (void)remove(get_segment_file_name(segment));
+        if (size <= 0)
+        {
+            break;
+        }
+        segment += (uint64_t)size;
+    }
+}
+
+static IOTHUBMESSAGE_CONTENT_TYPE my_IoTHubMessage_GetContentType(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return ((TEST_MESSAGE*)iotHubMessageHandle)->is_string ? IOTHUBMESSAGE_STRING : IOTHUBMESSAGE_BYTEARRAY;
+}
+
+static IOTHUB_MESSAGE_RESULT my_IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const unsigned char** buffer, size_t* size)
+{
+    *buffer = ((TEST_MESSAGE*)iotHubMessageHandle)->content;
+    *size = ((TEST_MESSAGE*)iotHubMessageHandle)->content_size;
+    return IOTHUB_MESSAGE_OK;
+}
+
+static const char* my_IoTHubMessage_GetMessageId(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    TEST_MESSAGE* message = (TEST_MESSAGE*)iotHubMessageHandle;
+    return message->has_message_id ? message->message_id : NULL;
+}
+
+static MAP_RESULT my_Map_GetInternals(MAP_HANDLE handle, const char*const** keys, const char*const** values, size_t* count)
+{
+    (void)handle;
+    *keys = TEST_PROPERTY_KEYS;
+    *values = TEST_PROPERTY_VALUES;
+    *count = 1;
+    return MAP_OK;
+}
+
+static IOTHUB_MESSAGE_HANDLE my_IoTHubMessage_CreateFromByteArray(const unsigned char* byteArray, size_t size)
+{
+    TEST_MESSAGE* message = (TEST_MESSAGE*)real_malloc(sizeof(TEST_MESSAGE));
+    ASSERT_IS_NOT_NULL(message);
+    memset(message, 0, sizeof(TEST_MESSAGE));
+    ASSERT_IS_TRUE(size <= sizeof(message->content));
+    if (size > 0)
+    {
+        (void)memcpy(message->content, byteArray, size);
+    }
+    message->content_size = size;
+    return (IOTHUB_MESSAGE_HANDLE)message;
+}
+
+static IOTHUB_MESSAGE_RESULT my_IoTHubMessage_SetMessageId(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const char* messageId)
+{
+    TEST_MESSAGE* message = (TEST_MESSAGE*)iotHubMessageHandle;
+    (void)strcpy(message->message_id, messageId);
+    message->has_message_id = true;
+    return IOTHUB_MESSAGE_OK;
+}
+
+static IOTHUB_MESSAGE_RESULT my_IoTHubMessage_SetProperty(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const char* key, const char* value)
+{
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_KEY, key);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, value);
+    ((TEST_MESSAGE*)iotHubMessageHandle)->properties_set++;
+    return IOTHUB_MESSAGE_OK;
+}
+
+static void my_IoTHubMessage_Destroy(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    real_free(iotHubMessageHandle);
+}
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return real_malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    real_free(ptr);
+}
+
+BEGIN_TEST_SUITE(persistent_queue_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    int result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(MAP_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUBMESSAGE_CONTENT_TYPE, int);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetContentType, my_IoTHubMessage_GetContentType);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetByteArray, my_IoTHubMessage_GetByteArray);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetMessageId, my_IoTHubMessage_GetMessageId);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_IsSecurityMessage, false);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_Properties, TEST_MAP_HANDLE);
+    REGISTER_GLOBAL_MOCK_HOOK(Map_GetInternals, my_Map_GetInternals);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_CreateFromByteArray, my_IoTHubMessage_CreateFromByteArray);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_SetMessageId, my_IoTHubMessage_SetMessageId);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_SetProperty, my_IoTHubMessage_SetProperty);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_Destroy, my_IoTHubMessage_Destroy);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    delete_queue_files();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    delete_queue_files();
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(persistent_queue_create_with_NULL_path_fails)
+{
+    // arrange
+
+    // act
+    PERSISTENT_QUEUE_HANDLE queue = persistent_queue_create(NULL, TEST_SEGMENT_SIZE);
+
+    // assert
+    ASSERT_IS_NULL(queue);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(persistent_queue_create_with_0_segment_size_fails)
+{
+    // arrange
+
+    // act
+    PERSISTENT_QUEUE_HANDLE queue = persistent_queue_create(TEST_QUEUE_PATH, 0);
+
+    // assert
+    ASSERT_IS_NULL(queue);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(persistent_queue_read_of_empty_queue_returns_NULL_message)
+{
+    // arrange
+    IOTHUB_MESSAGE_HANDLE message = (IOTHUB_MESSAGE_HANDLE)0x1;
+    uint64_t record_id;
+    PERSISTENT_QUEUE_HANDLE queue = persistent_queue_create(TEST_QUEUE_PATH, TEST_SEGMENT_SIZE);
+
+    // act
+    int result = persistent_queue_read(queue, &message, &record_id);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(message);
+    ASSERT_IS_FALSE(persistent_queue_has_unread(queue));
+
+    // cleanup
+    persistent_queue_destroy(queue);
+}
+
+TEST_FUNCTION(persistent_queue_read_returns_appended_message)
+{
+    // arrange
+    uint64_t appended_id;
+    uint64_t read_id;
+    PERSISTENT_QUEUE_HANDLE queue = persistent_queue_create(TEST_QUEUE_PATH, TEST_SEGMENT_SIZE);
+    append_test_message(queue, "hello", "id1", &appended_id);
+
+    // act
+    ASSERT_IS_TRUE(persistent_queue_has_unread(queue));
+    read_test_message(queue, "hello", "id1", &read_id);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, appended_id, read_id);
+    ASSERT_IS_FALSE(persistent_queue_has_unread(queue));
+
+    // cleanup
+    persistent_queue_destroy(queue);
+}
+
+TEST_FUNCTION(persistent_queue_read_returns_messages_in_append_order_across_segments)
+{
+    // arrange
+    uint64_t ids[3];
+    uint64_t read_id;
+    PERSISTENT_QUEUE_HANDLE queue = persistent_queue_create(TEST_QUEUE_PATH, TEST_SMALL_SEGMENT_SIZE);
+    append_test_message(queue, "one", "id1", &ids[0]);
+    append_test_message(queue, "two", NULL, &ids[1]);
+    append_test_message(queue, "three", "id3", &ids[2]);
+
+    // act
+    // assert
+    ASSERT_IS_TRUE(segment_file_exists(ids[1]));
+    ASSERT_IS_TRUE(segment_file_exists(ids[2]));
+    read_test_message(queue, "one", "id1", &read_id);
+    ASSERT_ARE_EQUAL(uint64_t, ids[0], read_id);
+    read_test_message(queue, "two", NULL, &read_id);
+    ASSERT_ARE_EQUAL(uint64_t, ids[1], read_id);
+    read_test_message(queue, "three", "id3", &read_id);
+    ASSERT_ARE_EQUAL(uint64_t, ids[2], read_id);
+
+    // cleanup
+    persistent_queue_destroy(queue);
+}
+
+TEST_FUNCTION(persistent_queue_create_resumes_after_the_last_checkpoint)
+{
+    // arrange
+    uint64_t ids[3];
+    uint64_t read_id;
+    PERSISTENT_QUEUE_HANDLE queue = persistent_queue_create(TEST_QUEUE_PATH, TEST_SEGMENT_SIZE);
+    append_test_message(queue, "one", NULL, &ids[0]);
+    append_test_message(queue, "two", NULL, &ids[1]);
+    append_test_message(queue, "three", NULL, &ids[2]);
+    read_test_message(queue, "one", NULL, &read_id);
+    read_test_message(queue, "two", NULL, &read_id);
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, ids[0]));
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_sync(queue));
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, ids[1])); /*not synced, so read again*/
+    persistent_queue_destroy(queue);
+
+    // act
+    queue = persistent_queue_create(TEST_QUEUE_PATH, TEST_SEGMENT_SIZE);
+
+    // assert
+    ASSERT_IS_NOT_NULL(queue);
+    read_test_message(queue, "two", NULL, &read_id);
+    read_test_message(queue, "three", NULL, &read_id);
+    ASSERT_IS_FALSE(persistent_queue_has_unread(queue));
+
+    // cleanup
+    persistent_queue_destroy(queue);
+}
+
+TEST_FUNCTION(persistent_queue_sync_does_not_move_checkpoint_past_unacknowledged_record)
+{
+    // arrange
+    uint64_t ids[2];
+    uint64_t read_id;
+    PERSISTENT_QUEUE_HANDLE queue = persistent_queue_create(TEST_QUEUE_PATH, TEST_SEGMENT_SIZE);
+    append_test_message(queue, "one", NULL, &ids[0]);
+    append_test_message(queue, "two", NULL, &ids[1]);
+    read_test_message(queue, "one", NULL, &read_id);
+    read_test_message(queue, "two", NULL, &read_id);
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, ids[1]));
+
+    // act
+    int result = persistent_queue_sync(queue);
+    persistent_queue_destroy(queue);
+    queue = persistent_queue_create(TEST_QUEUE_PATH, TEST_SEGMENT_SIZE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    read_test_message(queue, "one", NULL, &read_id);
+    ASSERT_ARE_EQUAL(uint64_t, ids[0], read_id);
+
+    // cleanup
+    persistent_queue_destroy(queue);
+}
+
+TEST_FUNCTION(persistent_queue_sync_deletes_acknowledged_segments)
+{
+    // arrange
+    uint64_t ids[2];
+    uint64_t read_id;
+    PERSISTENT_QUEUE_HANDLE queue = persistent_queue_create(TEST_QUEUE_PATH, TEST_SMALL_SEGMENT_SIZE);
+    append_test_message(queue, "one", NULL, &ids[0]);
+    append_test_message(queue, "two", NULL, &ids[1]);
+    read_test_message(queue, "one", NULL, &read_id);
+    read_test_message(queue, "two", NULL, &read_id);
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_ack(queue, ids[0]));
+
+    // act
+    int result = persistent_queue_sync(queue);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(segment_file_exists(ids[0]));
+    ASSERT_IS_TRUE(segment_file_exists(ids[1]));
+
+    // cleanup
+    persistent_queue_destroy(queue);
+}
+
+TEST_FUNCTION(persistent_queue_read_skips_damaged_segment)
+{
+    // arrange
+    uint64_t ids[2];
+    uint64_t read_id;
+    FILE* file;
+    PERSISTENT_QUEUE_HANDLE queue = persistent_queue_create(TEST_QUEUE_PATH, TEST_SEGMENT_SIZE);
+    append_test_message(queue, "one", NULL, &ids[0]);
+    persistent_queue_destroy(queue);
+    file = fopen(get_segment_file_name(ids[0]), "r+b");
+    ASSERT_IS_NOT_NULL(file);
+    ASSERT_ARE_EQUAL(int, 0, fseek(file, 12, SEEK_SET)); /*inside the payload*/
+    ASSERT_ARE_EQUAL(int, 'X', fputc('X', file));
+    (void)fclose(file);
+    queue = persistent_queue_create(TEST_QUEUE_PATH, TEST_SEGMENT_SIZE);
+    append_test_message(queue, "two", NULL, &ids[1]);
+
+    // act
+    read_test_message(queue, "two", NULL, &read_id);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, ids[1], read_id);
+    ASSERT_IS_FALSE(persistent_queue_has_unread(queue));
+
+    // cleanup
+    persistent_queue_destroy(queue);
+}
+
+TEST_FUNCTION(persistent_queue_ack_of_unread_record_fails)
+{
+    // arrange
+    uint64_t record_id;
+    PERSISTENT_QUEUE_HANDLE queue = persistent_queue_create(TEST_QUEUE_PATH, TEST_SEGMENT_SIZE);
+    append_test_message(queue, "one", NULL, &record_id);
+
+    // act
+    int result = persistent_queue_ack(queue, record_id);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    persistent_queue_destroy(queue);
+}
+
+END_TEST_SUITE(persistent_queue_ut)
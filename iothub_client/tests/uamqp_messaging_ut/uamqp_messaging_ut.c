@@ -325,16 +325,17 @@ static void set_exp_calls_for_create_encoded_data(IOTHUBMESSAGE_CONTENT_TYPE msg
         .CopyOutArgumentBuffer(2, &encoding_size, sizeof(encoding_size));
 }
 
-static void set_exp_calls_for_message_create_uamqp_encoding_from_iothub_message(size_t number_of_app_properties, IOTHUBMESSAGE_CONTENT_TYPE msg_content_type, bool has_message_id, bool has_correlation_id, bool has_diag_properties, bool has_security_props, const char* content_type, const char* content_encoding)
+static void set_exp_calls_for_create_encoded_sections(size_t number_of_app_properties, IOTHUBMESSAGE_CONTENT_TYPE msg_content_type, bool has_message_id, bool has_correlation_id, bool has_diag_properties, bool has_security_props, const char* content_type, const char* content_encoding)
 {
     set_exp_calls_for_create_encoded_message_properties(has_message_id, has_correlation_id, content_type, content_encoding);
     set_exp_calls_for_create_encoded_application_properties(number_of_app_properties);
     set_exp_calls_for_create_encoded_annotations_properties(has_diag_properties, has_security_props);
 
     set_exp_calls_for_create_encoded_data(msg_content_type);
+}
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .SetReturn(g_encoding_buffer);
+static void set_exp_calls_for_encode_sections(size_t number_of_app_properties, bool has_diag_properties)
+{
     STRICT_EXPECTED_CALL(amqpvalue_encode(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     if (number_of_app_properties > 0)
@@ -361,6 +362,14 @@ static void set_exp_calls_for_message_create_uamqp_encoding_from_iothub_message(
     STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
 }
 
+static void set_exp_calls_for_message_create_uamqp_encoding_from_iothub_message(size_t number_of_app_properties, IOTHUBMESSAGE_CONTENT_TYPE msg_content_type, bool has_message_id, bool has_correlation_id, bool has_diag_properties, bool has_security_props, const char* content_type, const char* content_encoding)
+{
+    set_exp_calls_for_create_encoded_sections(number_of_app_properties, msg_content_type, has_message_id, has_correlation_id, has_diag_properties, has_security_props, content_type, content_encoding);
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(g_encoding_buffer);
+    set_exp_calls_for_encode_sections(number_of_app_properties, has_diag_properties);
+}
+
 static void set_exp_calls_for_message_create_IoTHubMessage_from_uamqp_message(
     size_t number_of_properties,
     bool has_message_id,
@@ -1282,5 +1291,159 @@ TEST_FUNCTION(message_create_IoTHubMessage_from_uamqp_message_no_user_id_success
     // cleanup
 }
 
+TEST_FUNCTION(message_create_uamqp_encoding_from_iothub_message_NULL_body_fails)
+{
+    // arrange
+    umock_c_reset_all_calls();
+
+    // act
+    int result = message_create_uamqp_encoding_from_iothub_message(NULL, TEST_IOTHUB_MESSAGE_HANDLE, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(message_create_uamqp_encoding_from_iothub_message_NULL_message_fails)
+{
+    // arrange
+    BINARY_DATA binary_data;
+    memset(&binary_data, 0, sizeof(binary_data));
+    umock_c_reset_all_calls();
+
+    // act
+    int result = message_create_uamqp_encoding_from_iothub_message(NULL, NULL, &binary_data);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(binary_data.bytes);
+}
+
+// Tests_SRS_UAMQP_MESSAGING_31_125: [On failure `body_binary_data` shall be left empty; the encoding buffer stays owned by the caller.]
+TEST_FUNCTION(message_create_uamqp_encoding_in_buffer_NULL_encoding_buffer_fails)
+{
+    // arrange
+    BINARY_DATA binary_data;
+    memset(&binary_data, 0, sizeof(binary_data));
+    umock_c_reset_all_calls();
+
+    // act
+    int result = message_create_uamqp_encoding_in_buffer(NULL, TEST_IOTHUB_MESSAGE_HANDLE, NULL, &binary_data);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(binary_data.bytes);
+}
+
+TEST_FUNCTION(message_create_uamqp_encoding_in_buffer_NULL_body_fails)
+{
+    // arrange
+    UAMQP_ENCODING_BUFFER encoding_buffer = { NULL, 0 };
+    umock_c_reset_all_calls();
+
+    // act
+    int result = message_create_uamqp_encoding_in_buffer(NULL, TEST_IOTHUB_MESSAGE_HANDLE, &encoding_buffer, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+// Tests_SRS_UAMQP_MESSAGING_31_124: [The encoding buffer shall only be reallocated when it is smaller than the encoded message, and it shall never be shrunk.]
+TEST_FUNCTION(message_create_uamqp_encoding_in_buffer_reuses_a_large_enough_buffer)
+{
+    // arrange
+    UAMQP_ENCODING_BUFFER encoding_buffer = { (unsigned char*)g_encoding_buffer, sizeof(g_encoding_buffer) };
+    BINARY_DATA binary_data;
+    memset(&binary_data, 0, sizeof(binary_data));
+    umock_c_reset_all_calls();
+    set_exp_calls_for_create_encoded_sections(0, IOTHUBMESSAGE_BYTEARRAY, true, true, false, false, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
+    set_exp_calls_for_encode_sections(0, false);
+
+    // act
+    int result = message_create_uamqp_encoding_in_buffer(NULL, TEST_IOTHUB_MESSAGE_HANDLE, &encoding_buffer, &binary_data);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)g_encoding_buffer, (void*)binary_data.bytes);
+    ASSERT_ARE_EQUAL(size_t, sizeof(g_encoding_buffer), encoding_buffer.size);
+}
+
+// Tests_SRS_UAMQP_MESSAGING_31_124: [The encoding buffer shall only be reallocated when it is smaller than the encoded message, and it shall never be shrunk.]
+TEST_FUNCTION(message_create_uamqp_encoding_in_buffer_allocates_an_empty_buffer)
+{
+    // arrange
+    UAMQP_ENCODING_BUFFER encoding_buffer = { NULL, 0 };
+    BINARY_DATA binary_data;
+    memset(&binary_data, 0, sizeof(binary_data));
+    umock_c_reset_all_calls();
+    set_exp_calls_for_create_encoded_sections(0, IOTHUBMESSAGE_BYTEARRAY, true, true, false, false, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(g_encoding_buffer);
+    set_exp_calls_for_encode_sections(0, false);
+
+    // act
+    int result = message_create_uamqp_encoding_in_buffer(NULL, TEST_IOTHUB_MESSAGE_HANDLE, &encoding_buffer, &binary_data);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)g_encoding_buffer, (void*)encoding_buffer.bytes);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)g_encoding_buffer, (void*)binary_data.bytes);
+    ASSERT_ARE_EQUAL(size_t, binary_data.length, encoding_buffer.size);
+}
+
+// Tests_SRS_UAMQP_MESSAGING_31_124: [The encoding buffer shall only be reallocated when it is smaller than the encoded message, and it shall never be shrunk.]
+TEST_FUNCTION(message_create_uamqp_encoding_in_buffer_grows_a_small_buffer)
+{
+    // arrange
+    UAMQP_ENCODING_BUFFER encoding_buffer = { (unsigned char*)g_encoding_buffer, 1 };
+    BINARY_DATA binary_data;
+    memset(&binary_data, 0, sizeof(binary_data));
+    umock_c_reset_all_calls();
+    set_exp_calls_for_create_encoded_sections(0, IOTHUBMESSAGE_BYTEARRAY, true, true, false, false, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
+    STRICT_EXPECTED_CALL(gballoc_realloc(g_encoding_buffer, IGNORED_NUM_ARG))
+        .SetReturn(g_encoding_buffer);
+    set_exp_calls_for_encode_sections(0, false);
+
+    // act
+    int result = message_create_uamqp_encoding_in_buffer(NULL, TEST_IOTHUB_MESSAGE_HANDLE, &encoding_buffer, &binary_data);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)g_encoding_buffer, (void*)binary_data.bytes);
+    ASSERT_ARE_EQUAL(size_t, binary_data.length, encoding_buffer.size);
+}
+
+// Tests_SRS_UAMQP_MESSAGING_31_125: [On failure `body_binary_data` shall be left empty; the encoding buffer stays owned by the caller.]
+TEST_FUNCTION(message_create_uamqp_encoding_in_buffer_realloc_fails_keeps_the_buffer)
+{
+    // arrange
+    UAMQP_ENCODING_BUFFER encoding_buffer = { (unsigned char*)g_encoding_buffer, 1 };
+    BINARY_DATA binary_data;
+    memset(&binary_data, 0, sizeof(binary_data));
+    umock_c_reset_all_calls();
+    set_exp_calls_for_create_encoded_sections(0, IOTHUBMESSAGE_BYTEARRAY, true, true, false, false, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
+    STRICT_EXPECTED_CALL(gballoc_realloc(g_encoding_buffer, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
+
+    // act
+    int result = message_create_uamqp_encoding_in_buffer(NULL, TEST_IOTHUB_MESSAGE_HANDLE, &encoding_buffer, &binary_data);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(binary_data.bytes);
+    ASSERT_ARE_EQUAL(size_t, 0, binary_data.length);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)g_encoding_buffer, (void*)encoding_buffer.bytes);
+    ASSERT_ARE_EQUAL(size_t, 1, encoding_buffer.size);
+}
+
 END_TEST_SUITE(uamqp_messaging_ut)
 
@@ -20,12 +20,50 @@ extern "C" {
     JSON_DECODER_INVALID_ARG,           \
     JSON_DECODER_PARSE_ERROR,           \
     JSON_DECODER_MULTITREE_FAILED,      \
-    JSON_DECODER_ERROR                  \
+    JSON_DECODER_ERROR,                 \
+    JSON_DECODER_MEMBER_NOT_FOUND       \
 
 MU_DEFINE_ENUM_WITHOUT_INVALID(JSON_DECODER_RESULT, JSON_DECODER_RESULT_VALUES);
 
+#define JSON_DECODER_TOKEN_TYPE_VALUES      \
+    JSON_DECODER_TOKEN_BEGIN_OBJECT,        \
+    JSON_DECODER_TOKEN_END_OBJECT,          \
+    JSON_DECODER_TOKEN_BEGIN_ARRAY,         \
+    JSON_DECODER_TOKEN_END_ARRAY,           \
+    JSON_DECODER_TOKEN_NAME,                \
+    JSON_DECODER_TOKEN_STRING,              \
+    JSON_DECODER_TOKEN_NUMBER,              \
+    JSON_DECODER_TOKEN_LITERAL,             \
+    JSON_DECODER_TOKEN_END_OF_DOCUMENT      \
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(JSON_DECODER_TOKEN_TYPE, JSON_DECODER_TOKEN_TYPE_VALUES);
+
+/*text points into the JSON given to JSONDecoder_Reader_Init and is not '\0' terminated. A name excludes its quotation marks, a string value includes them*/
+typedef struct JSON_DECODER_TOKEN_TAG
+{
+    JSON_DECODER_TOKEN_TYPE type;
+    const char* text;
+    size_t length;
+} JSON_DECODER_TOKEN;
+
+#define JSON_DECODER_READER_MAX_NESTING 64
+
+/*a pull parser over a JSON text. It does not allocate and it can be copied to remember a position in the text. The fields are private to jsondecoder.c*/
+typedef struct JSON_DECODER_READER_TAG
+{
+    const char* position;
+    int state;
+    size_t depth;
+    char containers[JSON_DECODER_READER_MAX_NESTING];
+} JSON_DECODER_READER;
+
 MOCKABLE_FUNCTION(, JSON_DECODER_RESULT, JSONDecoder_JSON_To_MultiTree, char*, json, MULTITREE_HANDLE*, multiTreeHandle);
 
+MOCKABLE_FUNCTION(, JSON_DECODER_RESULT, JSONDecoder_Reader_Init, JSON_DECODER_READER*, reader, const char*, json);
+MOCKABLE_FUNCTION(, JSON_DECODER_RESULT, JSONDecoder_Reader_Next, JSON_DECODER_READER*, reader, JSON_DECODER_TOKEN*, token);
+MOCKABLE_FUNCTION(, JSON_DECODER_RESULT, JSONDecoder_Reader_SkipValue, JSON_DECODER_READER*, reader);
+MOCKABLE_FUNCTION(, JSON_DECODER_RESULT, JSONDecoder_Reader_GetMember, const JSON_DECODER_READER*, objectReader, const char*, name, JSON_DECODER_READER*, memberReader);
+
 #ifdef __cplusplus
 }
 #endif
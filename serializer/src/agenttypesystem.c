@@ -12,6 +12,7 @@
 #endif
 
 #include <stddef.h>
+#include <string.h>
 
 #include <float.h>
 #include <math.h>
@@ -48,17 +49,6 @@
 
 #define GUID_STRING_LENGTH 38
 
-// This is an artificial upper limit on floating point string length
-// (e.g. the size of the string when printing %f). It is set to twice the
-// maximum decimal precision plus 2. 1 for the decimal point and 1 for a
-// sign (+/-)
-// Unfortunately it is quite possible to print a float larger than this.
-// An example of this would be printf("%.*f", MAX_FLOATING_POINT_STRING_LENGTH, 1.3);
-// But currently no explicit requests for this exist in the file nor are
-// any expected to reasonably occur when being used (numbers that hit
-// this limit would be experiencing significant precision loss in storage anyway.
-#define MAX_FLOATING_POINT_STRING_LENGTH (DECIMAL_DIG *2 + 2)
-
 // This maximum length is 11 for 32 bit integers (including the sign)
 // optionally increase to 21 if longs are 64 bit
 #define MAX_LONG_STRING_LENGTH ( 11 + (10 * (sizeof(long)/ 8)))
@@ -66,6 +56,10 @@
 // This is the maximum length for the largest 64 bit number (signed)
 #define MAX_ULONG_LONG_STRING_LENGTH 20
 
+// "year-month-dayThour:minute:second.fractionalSecond+timeZoneHour:timeZoneMinute" in quotes: 8 numbers, each
+// followed by at most one separator, the fractional second, the quotes and the terminating NULL
+#define DATE_TIME_OFFSET_STRING_LENGTH (1 + 8 * (MAX_LONG_STRING_LENGTH + 1) + MAX_ULONG_LONG_STRING_LENGTH + 1 + 1)
+
 MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_RESULT_VALUES);
 
 static int ValidateDate(int year, int month, int day);
@@ -1283,6 +1277,398 @@ static char hexDigitToChar(uint8_t hexDigit)
     else return ('A' - 10) + hexDigit;
 }
 
+/*writes value with at least minimumDigits digits, as printf's "%.*llu" would, and returns the number of characters written*/
+static size_t WriteUnsignedInteger(char* destination, uint64_t value, size_t minimumDigits)
+{
+    char digits[MAX_ULONG_LONG_STRING_LENGTH];
+    size_t length = 0;
+    size_t pos = 0;
+    do
+    {
+        digits[length++] = (char)('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+
+    for (; minimumDigits > length; minimumDigits--)
+    {
+        destination[pos++] = '0';
+    }
+    while (length > 0)
+    {
+        destination[pos++] = digits[--length];
+    }
+    return pos;
+}
+
+/*same as WriteUnsignedInteger, with a '-' for negative values and a '+' for the others when forceSign is true (printf's "%+")*/
+static size_t WriteInteger(char* destination, int64_t value, size_t minimumDigits, bool forceSign)
+{
+    size_t pos = 0;
+    uint64_t magnitude;
+    if (value < 0)
+    {
+        destination[pos++] = '-';
+        magnitude = 0 - (uint64_t)value; /*also right for INT64_MIN*/
+    }
+    else
+    {
+        if (forceSign)
+        {
+            destination[pos++] = '+';
+        }
+        magnitude = (uint64_t)value;
+    }
+    return pos + WriteUnsignedInteger(destination + pos, magnitude, minimumDigits);
+}
+
+#ifndef NO_FLOATS
+/*shortest round trip formatting of floating point values, after "Printing Floating-Point Numbers Quickly and Accurately with Integers" (Loitsch, Grisu2)*/
+typedef struct DIY_FP_TAG
+{
+    uint64_t f;
+    int e;
+} DIY_FP;
+
+typedef struct CACHED_POWER_TAG
+{
+    uint64_t f;
+    int e; /*binary exponent*/
+    int k; /*decimal exponent*/
+} CACHED_POWER;
+
+/*normalized 10^k for k = -348, -340, ..., 340*/
+static const CACHED_POWER cachedPowers[] =
+{
+    { 0xfa8fd5a0081c0288ULL, -1220, -348 }, { 0xbaaee17fa23ebf76ULL, -1193, -340 }, { 0x8b16fb203055ac76ULL, -1166, -332 },
+    { 0xcf42894a5dce35eaULL, -1140, -324 }, { 0x9a6bb0aa55653b2dULL, -1113, -316 }, { 0xe61acf033d1a45dfULL, -1087, -308 },
+    { 0xab70fe17c79ac6caULL, -1060, -300 }, { 0xff77b1fcbebcdc4fULL, -1034, -292 }, { 0xbe5691ef416bd60cULL, -1007, -284 },
+    { 0x8dd01fad907ffc3cULL, -980, -276 }, { 0xd3515c2831559a83ULL, -954, -268 }, { 0x9d71ac8fada6c9b5ULL, -927, -260 },
+    { 0xea9c227723ee8bcbULL, -901, -252 }, { 0xaecc49914078536dULL, -874, -244 }, { 0x823c12795db6ce57ULL, -847, -236 },
+    { 0xc21094364dfb5637ULL, -821, -228 }, { 0x9096ea6f3848984fULL, -794, -220 }, { 0xd77485cb25823ac7ULL, -768, -212 },
+    { 0xa086cfcd97bf97f4ULL, -741, -204 }, { 0xef340a98172aace5ULL, -715, -196 }, { 0xb23867fb2a35b28eULL, -688, -188 },
+    { 0x84c8d4dfd2c63f3bULL, -661, -180 }, { 0xc5dd44271ad3cdbaULL, -635, -172 }, { 0x936b9fcebb25c996ULL, -608, -164 },
+    { 0xdbac6c247d62a584ULL, -582, -156 }, { 0xa3ab66580d5fdaf6ULL, -555, -148 }, { 0xf3e2f893dec3f126ULL, -529, -140 },
+    { 0xb5b5ada8aaff80b8ULL, -502, -132 }, { 0x87625f056c7c4a8bULL, -475, -124 }, { 0xc9bcff6034c13053ULL, -449, -116 },
+    { 0x964e858c91ba2655ULL, -422, -108 }, { 0xdff9772470297ebdULL, -396, -100 }, { 0xa6dfbd9fb8e5b88fULL, -369, -92 },
+    { 0xf8a95fcf88747d94ULL, -343, -84 }, { 0xb94470938fa89bcfULL, -316, -76 }, { 0x8a08f0f8bf0f156bULL, -289, -68 },
+    { 0xcdb02555653131b6ULL, -263, -60 }, { 0x993fe2c6d07b7facULL, -236, -52 }, { 0xe45c10c42a2b3b06ULL, -210, -44 },
+    { 0xaa242499697392d3ULL, -183, -36 }, { 0xfd87b5f28300ca0eULL, -157, -28 }, { 0xbce5086492111aebULL, -130, -20 },
+    { 0x8cbccc096f5088ccULL, -103, -12 }, { 0xd1b71758e219652cULL, -77, -4 }, { 0x9c40000000000000ULL, -50, 4 },
+    { 0xe8d4a51000000000ULL, -24, 12 }, { 0xad78ebc5ac620000ULL, 3, 20 }, { 0x813f3978f8940984ULL, 30, 28 },
+    { 0xc097ce7bc90715b3ULL, 56, 36 }, { 0x8f7e32ce7bea5c70ULL, 83, 44 }, { 0xd5d238a4abe98068ULL, 109, 52 },
+    { 0x9f4f2726179a2245ULL, 136, 60 }, { 0xed63a231d4c4fb27ULL, 162, 68 }, { 0xb0de65388cc8ada8ULL, 189, 76 },
+    { 0x83c7088e1aab65dbULL, 216, 84 }, { 0xc45d1df942711d9aULL, 242, 92 }, { 0x924d692ca61be758ULL, 269, 100 },
+    { 0xda01ee641a708deaULL, 295, 108 }, { 0xa26da3999aef774aULL, 322, 116 }, { 0xf209787bb47d6b85ULL, 348, 124 },
+    { 0xb454e4a179dd1877ULL, 375, 132 }, { 0x865b86925b9bc5c2ULL, 402, 140 }, { 0xc83553c5c8965d3dULL, 428, 148 },
+    { 0x952ab45cfa97a0b3ULL, 455, 156 }, { 0xde469fbd99a05fe3ULL, 481, 164 }, { 0xa59bc234db398c25ULL, 508, 172 },
+    { 0xf6c69a72a3989f5cULL, 534, 180 }, { 0xb7dcbf5354e9beceULL, 561, 188 }, { 0x88fcf317f22241e2ULL, 588, 196 },
+    { 0xcc20ce9bd35c78a5ULL, 614, 204 }, { 0x98165af37b2153dfULL, 641, 212 }, { 0xe2a0b5dc971f303aULL, 667, 220 },
+    { 0xa8d9d1535ce3b396ULL, 694, 228 }, { 0xfb9b7cd9a4a7443cULL, 720, 236 }, { 0xbb764c4ca7a44410ULL, 747, 244 },
+    { 0x8bab8eefb6409c1aULL, 774, 252 }, { 0xd01fef10a657842cULL, 800, 260 }, { 0x9b10a4e5e9913129ULL, 827, 268 },
+    { 0xe7109bfba19c0c9dULL, 853, 276 }, { 0xac2820d9623bf429ULL, 880, 284 }, { 0x80444b5e7aa7cf85ULL, 907, 292 },
+    { 0xbf21e44003acdd2dULL, 933, 300 }, { 0x8e679c2f5e44ff8fULL, 960, 308 }, { 0xd433179d9c8cb841ULL, 986, 316 },
+    { 0x9e19db92b4e31ba9ULL, 1013, 324 }, { 0xeb96bf6ebadf77d9ULL, 1039, 332 }, { 0xaf87023b9bf0ee6bULL, 1066, 340 }
+};
+
+static const uint64_t powersOf10[] =
+{
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+    10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+    10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+/*the longest text of a floating point value, see WriteFloatingPoint*/
+#define SHORTEST_FLOATING_POINT_STRING_LENGTH 32
+
+static DIY_FP DiyFp_Multiply(DIY_FP x, DIY_FP y)
+{
+    DIY_FP result;
+    uint64_t a = x.f >> 32;
+    uint64_t b = x.f & 0xFFFFFFFF;
+    uint64_t c = y.f >> 32;
+    uint64_t d = y.f & 0xFFFFFFFF;
+    uint64_t ac = a * c;
+    uint64_t bc = b * c;
+    uint64_t ad = a * d;
+    uint64_t bd = b * d;
+    uint64_t middle = (bd >> 32) + (ad & 0xFFFFFFFF) + (bc & 0xFFFFFFFF) + (1ULL << 31); /*rounds the lower half*/
+    result.f = ac + (ad >> 32) + (bc >> 32) + (middle >> 32);
+    result.e = x.e + y.e + 64;
+    return result;
+}
+
+static DIY_FP DiyFp_Normalize(DIY_FP x)
+{
+    while ((x.f & 0x8000000000000000ULL) == 0)
+    {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+static void GrisuRound(char* digits, size_t length, uint64_t delta, uint64_t rest, uint64_t tenKappa, uint64_t distance)
+{
+    /*moves the last digit towards the exact value while the result stays in the rounding interval*/
+    while ((rest < distance) && (delta - rest >= tenKappa) &&
+        ((rest + tenKappa < distance) || (distance - rest > rest + tenKappa - distance)))
+    {
+        digits[length - 1]--;
+        rest += tenKappa;
+    }
+}
+
+/*value is f * 2^e where f has significandBits bits after the hidden bit. Writes the shortest digits that convert back to value and
+returns how many, *exponent10 receives the power of 10 of the last digit*/
+static size_t Grisu2(uint64_t f, int e, int significandBits, char* digits, int* exponent10)
+{
+    uint64_t hiddenBit = 1ULL << significandBits;
+    DIY_FP v;
+    DIY_FP plus;
+    DIY_FP minus;
+    DIY_FP one;
+    DIY_FP w;
+    DIY_FP wPlus;
+    DIY_FP wMinus;
+    const CACHED_POWER* cachedPower;
+    uint64_t delta;
+    uint64_t distance;
+    uint32_t p1;
+    uint64_t p2;
+    int kappa;
+    size_t length = 0;
+    double dk;
+    int k;
+
+    /*the boundaries of the rounding interval of value*/
+    v.f = f;
+    v.e = e;
+    plus.f = (f << 1) + 1;
+    plus.e = e - 1;
+    plus = DiyFp_Normalize(plus);
+    if (f == hiddenBit)
+    {
+        minus.f = (f << 2) - 1;
+        minus.e = e - 2;
+    }
+    else
+    {
+        minus.f = (f << 1) - 1;
+        minus.e = e - 1;
+    }
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    /*scales by a power of 10 that brings the binary exponent of the upper boundary in [-60, -32]*/
+    dk = (-61 - plus.e) * 0.30102999566398114 + 347;
+    k = (int)dk;
+    if (dk - k > 0.0)
+    {
+        k++;
+    }
+    cachedPower = &cachedPowers[(k >> 3) + 1];
+    *exponent10 = -cachedPower->k;
+    {
+        DIY_FP c;
+        c.f = cachedPower->f;
+        c.e = cachedPower->e;
+        w = DiyFp_Multiply(DiyFp_Normalize(v), c);
+        wPlus = DiyFp_Multiply(plus, c);
+        wMinus = DiyFp_Multiply(minus, c);
+    }
+    wMinus.f++;
+    wPlus.f--;
+
+    /*generates the digits of wPlus until they are inside the interval*/
+    delta = wPlus.f - wMinus.f;
+    distance = wPlus.f - w.f;
+    one.f = 1ULL << -wPlus.e;
+    one.e = wPlus.e;
+    p1 = (uint32_t)(wPlus.f >> -one.e);
+    p2 = wPlus.f & (one.f - 1);
+    kappa = 1;
+    while ((kappa < 10) && (p1 >= powersOf10[kappa]))
+    {
+        kappa++;
+    }
+
+    while (kappa > 0)
+    {
+        uint32_t d = (uint32_t)(p1 / powersOf10[kappa - 1]);
+        uint64_t rest;
+        p1 %= (uint32_t)powersOf10[kappa - 1];
+        if ((d != 0) || (length != 0))
+        {
+            digits[length++] = (char)('0' + d);
+        }
+        kappa--;
+        rest = ((uint64_t)p1 << -one.e) + p2;
+        if (rest <= delta)
+        {
+            *exponent10 += kappa;
+            GrisuRound(digits, length, delta, rest, powersOf10[kappa] << -one.e, distance);
+            return length;
+        }
+    }
+
+    for (;;)
+    {
+        char d;
+        p2 *= 10;
+        delta *= 10;
+        d = (char)(p2 >> -one.e);
+        if ((d != 0) || (length != 0))
+        {
+            digits[length++] = (char)('0' + d);
+        }
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta)
+        {
+            *exponent10 += kappa;
+            GrisuRound(digits, length, delta, p2, one.f, (-kappa < 20) ? distance * powersOf10[-kappa] : 0);
+            return length;
+        }
+    }
+}
+
+/*writes the digits like JavaScript does: in fixed notation for 1e-6 <= |value| < 1e21, with an exponent otherwise. Integral values keep a ".0"
+so that they still read as floating point numbers. Returns the number of characters written, at most SHORTEST_FLOATING_POINT_STRING_LENGTH - 1*/
+static size_t WriteFloatingPoint(char* destination, bool isNegative, const char* digits, size_t length, int exponent10)
+{
+    size_t pos = 0;
+    int pointPosition = (int)length + exponent10; /*digits before the decimal point*/
+
+    if (isNegative)
+    {
+        destination[pos++] = '-';
+    }
+
+    if ((exponent10 >= 0) && (pointPosition <= 21))
+    {
+        /*integral*/
+        (void)memcpy(destination + pos, digits, length);
+        pos += length;
+        (void)memset(destination + pos, '0', (size_t)exponent10);
+        pos += (size_t)exponent10;
+        destination[pos++] = '.';
+        destination[pos++] = '0';
+    }
+    else if ((pointPosition > 0) && (pointPosition <= 21))
+    {
+        (void)memcpy(destination + pos, digits, (size_t)pointPosition);
+        pos += (size_t)pointPosition;
+        destination[pos++] = '.';
+        (void)memcpy(destination + pos, digits + pointPosition, length - (size_t)pointPosition);
+        pos += length - (size_t)pointPosition;
+    }
+    else if ((pointPosition > -6) && (pointPosition <= 0))
+    {
+        destination[pos++] = '0';
+        destination[pos++] = '.';
+        (void)memset(destination + pos, '0', (size_t)-pointPosition);
+        pos += (size_t)-pointPosition;
+        (void)memcpy(destination + pos, digits, length);
+        pos += length;
+    }
+    else
+    {
+        int exponent = pointPosition - 1;
+        destination[pos++] = digits[0];
+        if (length > 1)
+        {
+            destination[pos++] = '.';
+            (void)memcpy(destination + pos, digits + 1, length - 1);
+            pos += length - 1;
+        }
+        destination[pos++] = 'e';
+        if (exponent < 0)
+        {
+            destination[pos++] = '-';
+            exponent = -exponent;
+        }
+        else
+        {
+            destination[pos++] = '+';
+        }
+        if (exponent >= 100)
+        {
+            destination[pos++] = (char)('0' + exponent / 100);
+        }
+        if (exponent >= 10)
+        {
+            destination[pos++] = (char)('0' + (exponent / 10) % 10);
+        }
+        destination[pos++] = (char)('0' + exponent % 10);
+    }
+    return pos;
+}
+
+/*value is finite*/
+static size_t DoubleToString(char* destination, double value)
+{
+    size_t result;
+    uint64_t bits;
+    (void)memcpy(&bits, &value, sizeof(bits));
+    if ((bits & 0x7FFFFFFFFFFFFFFFULL) == 0)
+    {
+        result = WriteFloatingPoint(destination, (bits >> 63) != 0, "0", 1, 0);
+    }
+    else
+    {
+        char digits[20];
+        int exponent10;
+        uint64_t f = bits & 0x000FFFFFFFFFFFFFULL;
+        int biasedExponent = (int)((bits >> 52) & 0x7FF);
+        size_t length;
+        if (biasedExponent == 0)
+        {
+            /*subnormal*/
+            length = Grisu2(f, -1074, 52, digits, &exponent10);
+        }
+        else
+        {
+            length = Grisu2(f | 0x0010000000000000ULL, biasedExponent - 1075, 52, digits, &exponent10);
+        }
+        result = WriteFloatingPoint(destination, (bits >> 63) != 0, digits, length, exponent10);
+    }
+    destination[result] = '\0';
+    return result;
+}
+
+/*value is finite*/
+static size_t FloatToString(char* destination, float value)
+{
+    size_t result;
+    uint32_t bits;
+    (void)memcpy(&bits, &value, sizeof(bits));
+    if ((bits & 0x7FFFFFFF) == 0)
+    {
+        result = WriteFloatingPoint(destination, (bits >> 31) != 0, "0", 1, 0);
+    }
+    else
+    {
+        char digits[20];
+        int exponent10;
+        uint64_t f = bits & 0x007FFFFF;
+        int biasedExponent = (int)((bits >> 23) & 0xFF);
+        size_t length;
+        if (biasedExponent == 0)
+        {
+            /*subnormal*/
+            length = Grisu2(f, -149, 23, digits, &exponent10);
+        }
+        else
+        {
+            length = Grisu2(f | 0x00800000, biasedExponent - 150, 23, digits, &exponent10);
+        }
+        result = WriteFloatingPoint(destination, (bits >> 31) != 0, digits, length, exponent10);
+    }
+    destination[result] = '\0';
+    return result;
+}
+#endif
+
 AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const AGENT_DATA_TYPE* value)
 {
     AGENT_DATA_TYPES_RESULT result;
@@ -1429,228 +1815,49 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
             {
                 /*Codes_SRS_AGENT_TYPE_SYSTEM_99_019:[ EDM_DATETIMEOFFSET: dateTimeOffsetValue = year "-" month "-" day "T" hour ":" minute [ ":" second [ "." fractionalSeconds ] ] ( "Z" / sign hour ":" minute )]*/
                 /*from ABNF seems like these numbers HAVE to be padded with zeroes*/
-                if (value->value.edmDateTimeOffset.hasTimeZone)
-                {
-                    if (value->value.edmDateTimeOffset.hasFractionalSecond)
-                    {
-                        size_t tempBufferSize = 1 + // \"
-                            MAX_LONG_STRING_LENGTH + // %.4d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // T
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // .
-                            MAX_ULONG_LONG_STRING_LENGTH + // %.12llu
-                            1 + MAX_LONG_STRING_LENGTH + // %+.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + //\"
-                            1;  // " (terminating NULL);
-
-                        char* tempBuffer = (char*)malloc(tempBufferSize);
-                        if (tempBuffer == NULL)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else
-                        {
-                            if (sprintf_s(tempBuffer, tempBufferSize, "\"%.4d-%.2d-%.2dT%.2d:%.2d:%.2d.%.12llu%+.2d:%.2d\"", /*+ in printf forces the sign to appear*/
-                                value->value.edmDateTimeOffset.dateTime.tm_year+1900,
-                                value->value.edmDateTimeOffset.dateTime.tm_mon+1,
-                                value->value.edmDateTimeOffset.dateTime.tm_mday,
-                                value->value.edmDateTimeOffset.dateTime.tm_hour,
-                                value->value.edmDateTimeOffset.dateTime.tm_min,
-                                value->value.edmDateTimeOffset.dateTime.tm_sec,
-                                value->value.edmDateTimeOffset.fractionalSecond,
-                                value->value.edmDateTimeOffset.timeZoneHour,
-                                value->value.edmDateTimeOffset.timeZoneMinute) < 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else if (STRING_concat(destination, tempBuffer) != 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else
-                            {
-                                result = AGENT_DATA_TYPES_OK;
-                            }
-
-                            // Clean up temp buffer if allocated
-                            free(tempBuffer);
-                        }
-                    }
-                    else
-                    {
-                        size_t tempBufferSize = 1 + // \"
-                            MAX_LONG_STRING_LENGTH + // %.4d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // T
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + MAX_LONG_STRING_LENGTH + // %+.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // \"
-                            1; // " terminating NULL
-                        char* tempBuffer = (char*)malloc(tempBufferSize);
-
-                        if (tempBuffer == NULL)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else
-                        {
-                            if (sprintf_s(tempBuffer, tempBufferSize, "\"%.4d-%.2d-%.2dT%.2d:%.2d:%.2d%+.2d:%.2d\"", /*+ in printf forces the sign to appear*/
-                                value->value.edmDateTimeOffset.dateTime.tm_year + 1900,
-                                value->value.edmDateTimeOffset.dateTime.tm_mon+1,
-                                value->value.edmDateTimeOffset.dateTime.tm_mday,
-                                value->value.edmDateTimeOffset.dateTime.tm_hour,
-                                value->value.edmDateTimeOffset.dateTime.tm_min,
-                                value->value.edmDateTimeOffset.dateTime.tm_sec,
-                                value->value.edmDateTimeOffset.timeZoneHour,
-                                value->value.edmDateTimeOffset.timeZoneMinute) < 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else if (STRING_concat(destination, tempBuffer) != 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else
-                            {
-                                result = AGENT_DATA_TYPES_OK;
-                            }
+                const EDM_DATE_TIME_OFFSET* dateTimeOffset = &value->value.edmDateTimeOffset;
+                char tempBuffer[DATE_TIME_OFFSET_STRING_LENGTH];
+                size_t pos = 0;
 
-                            // Clean up temp buffer if allocated
-                            free(tempBuffer);
-                        }
-                    }
+                tempBuffer[pos++] = '\"';
+                pos += WriteInteger(tempBuffer + pos, (int64_t)dateTimeOffset->dateTime.tm_year + 1900, 4, false);
+                tempBuffer[pos++] = '-';
+                pos += WriteInteger(tempBuffer + pos, (int64_t)dateTimeOffset->dateTime.tm_mon + 1, 2, false);
+                tempBuffer[pos++] = '-';
+                pos += WriteInteger(tempBuffer + pos, dateTimeOffset->dateTime.tm_mday, 2, false);
+                tempBuffer[pos++] = 'T';
+                pos += WriteInteger(tempBuffer + pos, dateTimeOffset->dateTime.tm_hour, 2, false);
+                tempBuffer[pos++] = ':';
+                pos += WriteInteger(tempBuffer + pos, dateTimeOffset->dateTime.tm_min, 2, false);
+                tempBuffer[pos++] = ':';
+                pos += WriteInteger(tempBuffer + pos, dateTimeOffset->dateTime.tm_sec, 2, false);
+                if (dateTimeOffset->hasFractionalSecond)
+                {
+                    tempBuffer[pos++] = '.';
+                    pos += WriteUnsignedInteger(tempBuffer + pos, dateTimeOffset->fractionalSecond, 12);
+                }
+                if (dateTimeOffset->hasTimeZone)
+                {
+                    /*the sign of the hour always appears*/
+                    pos += WriteInteger(tempBuffer + pos, dateTimeOffset->timeZoneHour, 2, true);
+                    tempBuffer[pos++] = ':';
+                    pos += WriteInteger(tempBuffer + pos, dateTimeOffset->timeZoneMinute, 2, false);
                 }
                 else
                 {
-                    if (value->value.edmDateTimeOffset.hasFractionalSecond)
-                    {
-                        size_t tempBufferSize = 1 + //\"
-                            MAX_LONG_STRING_LENGTH + // %.4d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // T
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // .
-                            MAX_ULONG_LONG_STRING_LENGTH + // %.12llu
-                            1 + // Z
-                            1 + // \"
-                            1; // " (terminating NULL)
-                        char* tempBuffer = (char*)malloc(tempBufferSize);
-
-                        if (tempBuffer == NULL)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else
-                        {
-                            if (sprintf_s(tempBuffer, tempBufferSize, "\"%.4d-%.2d-%.2dT%.2d:%.2d:%.2d.%.12lluZ\"", /*+ in printf forces the sign to appear*/
-                                value->value.edmDateTimeOffset.dateTime.tm_year + 1900,
-                                value->value.edmDateTimeOffset.dateTime.tm_mon+1,
-                                value->value.edmDateTimeOffset.dateTime.tm_mday,
-                                value->value.edmDateTimeOffset.dateTime.tm_hour,
-                                value->value.edmDateTimeOffset.dateTime.tm_min,
-                                value->value.edmDateTimeOffset.dateTime.tm_sec,
-                                value->value.edmDateTimeOffset.fractionalSecond) < 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else if (STRING_concat(destination, tempBuffer) != 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else
-                            {
-                                result = AGENT_DATA_TYPES_OK;
-                            }
-
-                            free(tempBuffer);
-                        }
-                    }
-                    else
-                    {
-                        size_t tempBufferSize = 1 + // \"
-                            MAX_LONG_STRING_LENGTH + // %.4d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // T
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // Z
-                            1 + // \"
-                            1; // " (terminating null);
-
-                        char* tempBuffer = (char*)malloc(tempBufferSize);
-
-                        if (tempBuffer == NULL)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else
-                        {
-                            if (sprintf_s(tempBuffer, tempBufferSize, "\"%.4d-%.2d-%.2dT%.2d:%.2d:%.2dZ\"",
-                                value->value.edmDateTimeOffset.dateTime.tm_year + 1900,
-                                value->value.edmDateTimeOffset.dateTime.tm_mon+1,
-                                value->value.edmDateTimeOffset.dateTime.tm_mday,
-                                value->value.edmDateTimeOffset.dateTime.tm_hour,
-                                value->value.edmDateTimeOffset.dateTime.tm_min,
-                                value->value.edmDateTimeOffset.dateTime.tm_sec) < 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else if (STRING_concat(destination, tempBuffer) != 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else
-                            {
-                                result = AGENT_DATA_TYPES_OK;
-                            }
+                    tempBuffer[pos++] = 'Z';
+                }
+                tempBuffer[pos++] = '\"';
+                tempBuffer[pos] = '\0';
 
-                            free(tempBuffer);
-                        }
-                    }
+                if (STRING_concat(destination, tempBuffer) != 0)
+                {
+                    result = AGENT_DATA_TYPES_ERROR;
+                    LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
+                }
+                else
+                {
+                    result = AGENT_DATA_TYPES_OK;
                 }
                 break;
             }
@@ -1671,33 +1878,7 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
             {
                 /*-32768 to +32767*/
                 char buffertemp2[7]; /*because 5 digits and sign and '\0'*/
-                uint16_t positiveValue;
-                size_t pos = 0;
-                uint16_t rank = (uint16_t)10000;
-                bool foundFirstDigit = false;
-
-                if (value->value.edmInt16.value < 0)
-                {
-                    buffertemp2[pos++] = '-';
-                    positiveValue = -value->value.edmInt16.value;
-                }
-                else
-                {
-                    positiveValue = value->value.edmInt16.value;
-                }
-
-                while (rank >= 10)
-                {
-                    if ((foundFirstDigit == true) || (positiveValue / rank) > 0)
-                    {
-                        buffertemp2[pos++] = '0' + (char)(positiveValue / rank);
-                        foundFirstDigit = true;
-                    }
-                    positiveValue %= rank;
-                    rank /= 10;
-                }
-                buffertemp2[pos++] = '0' + (char)(positiveValue);
-                buffertemp2[pos++] = '\0';
+                buffertemp2[WriteInteger(buffertemp2, value->value.edmInt16.value, 1, false)] = '\0';
 
                 if (STRING_concat(destination, buffertemp2) != 0)
                 {
@@ -1714,33 +1895,7 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
             {
                 /*-2147483648 to +2147483647*/
                 char buffertemp2[12]; /*because 10 digits and sign and '\0'*/
-                uint32_t positiveValue;
-                size_t pos = 0;
-                uint32_t rank = 1000000000UL;
-                bool foundFirstDigit = false;
-
-                if (value->value.edmInt32.value < 0)
-                {
-                    buffertemp2[pos++] = '-';
-                    positiveValue = - value->value.edmInt32.value;
-                }
-                else
-                {
-                    positiveValue = value->value.edmInt32.value;
-                }
-
-                while (rank >= 10)
-                {
-                    if ((foundFirstDigit == true) || (positiveValue / rank) > 0)
-                    {
-                        buffertemp2[pos++] = '0' + (char)(positiveValue / rank);
-                        foundFirstDigit = true;
-                    }
-                    positiveValue %= rank;
-                    rank /= 10;
-                }
-                buffertemp2[pos++] = '0' + (char)(positiveValue);
-                buffertemp2[pos++] = '\0';
+                buffertemp2[WriteInteger(buffertemp2, value->value.edmInt32.value, 1, false)] = '\0';
 
                 if (STRING_concat(destination, buffertemp2) != 0)
                 {
@@ -1756,33 +1911,7 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
             case (EDM_INT64_TYPE):
             {
                 char buffertemp2[21]; /*because 19 digits and sign and '\0'*/
-                uint64_t positiveValue;
-                size_t pos = 0;
-                uint64_t rank = 10000000000000000000ULL;
-                bool foundFirstDigit = false;
-
-                if (value->value.edmInt64.value < 0)
-                {
-                    buffertemp2[pos++] = '-';
-                    positiveValue = -value->value.edmInt64.value;
-                }
-                else
-                {
-                    positiveValue = value->value.edmInt64.value;
-                }
-
-                while (rank >= 10)
-                {
-                    if ((foundFirstDigit == true) || (positiveValue / rank) > 0)
-                    {
-                        buffertemp2[pos++] = '0' + (char)(positiveValue / rank);
-                        foundFirstDigit = true;
-                    }
-                    positiveValue %= rank;
-                    rank /= 10;
-                }
-                buffertemp2[pos++] = '0' + (char)(positiveValue);
-                buffertemp2[pos++] = '\0';
+                buffertemp2[WriteInteger(buffertemp2, value->value.edmInt64.value, 1, false)] = '\0';
 
                 if (STRING_concat(destination, buffertemp2) != 0)
                 {
@@ -1955,8 +2084,6 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                 /*C89 standard says: When a float is promoted to double or long double, or a double is promoted to long double, its value is unchanged*/
                 /*I read that as : when a float is NaN or Inf, it will stay NaN or INF in double representation*/
 
-                /*The sprintf function returns the number of characters written in the array, not counting the terminating null character.*/
-
                 if(ISNAN(value->value.edmSingle.value))
                 {
                     if (STRING_concat(destination, NaN_STRING) != 0)
@@ -1995,43 +2122,28 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                 }
                 else
                 {
-                    size_t tempBufferSize = MAX_FLOATING_POINT_STRING_LENGTH;
-                    char* tempBuffer = (char*)malloc(tempBufferSize);
-                    if (tempBuffer == NULL)
+                    /*Codes_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest that converts back to the same binary32 value.]*/
+                    char tempBuffer[SHORTEST_FLOATING_POINT_STRING_LENGTH];
+                    (void)FloatToString(tempBuffer, value->value.edmSingle.value);
+                    if (STRING_concat(destination, tempBuffer) != 0)
                     {
                         result = AGENT_DATA_TYPES_ERROR;
                         LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
                     }
                     else
                     {
-                        if (sprintf_s(tempBuffer, tempBufferSize, "%.*f", FLT_DIG, (double)(value->value.edmSingle.value)) < 0)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else if (STRING_concat(destination, tempBuffer) != 0)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else
-                        {
-                            result = AGENT_DATA_TYPES_OK;
-                        }
-
-                        free(tempBuffer);
+                        result = AGENT_DATA_TYPES_OK;
                     }
                 }
                 break;
             }
             case(EDM_DOUBLE_TYPE):
             {
-                /*The sprintf function returns the number of characters written in the array, not counting the terminating null character.*/
                 /*OData-ABNF says these can be used: nanInfinity = 'NaN' / '-INF' / 'INF'*/
                 /*C90 doesn't declare a NaN or Inf in the standard, however, values might be NaN or Inf...*/
                 /*C99 ... does*/
                 /*C11 is same as C99*/
-                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest that converts back to the same binary64 value.*/
                 if(ISNAN(value->value.edmDouble.value))
                 {
                     if (STRING_concat(destination, NaN_STRING) != 0)
@@ -2044,7 +2156,7 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                         result = AGENT_DATA_TYPES_OK;
                     }
                 }
-                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest that converts back to the same binary64 value.*/
                 else if (ISNEGATIVEINFINITY(value->value.edmDouble.value))
                 {
                     if (STRING_concat(destination, MINUSINF_STRING) != 0)
@@ -2057,7 +2169,7 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                         result = AGENT_DATA_TYPES_OK;
                     }
                 }
-                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest that converts back to the same binary64 value.*/
                 else if (ISPOSITIVEINFINITY(value->value.edmDouble.value))
                 {
                     if (STRING_concat(destination, PLUSINF_STRING) != 0)
@@ -2070,34 +2182,19 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                         result = AGENT_DATA_TYPES_OK;
                     }
                 }
-                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest that converts back to the same binary64 value.*/
                 else
                 {
-                    size_t tempBufferSize = DECIMAL_DIG * 2;
-                    char* tempBuffer = (char*)malloc(tempBufferSize);
-                    if (tempBuffer == NULL)
+                    char tempBuffer[SHORTEST_FLOATING_POINT_STRING_LENGTH];
+                    (void)DoubleToString(tempBuffer, value->value.edmDouble.value);
+                    if (STRING_concat(destination, tempBuffer) != 0)
                     {
                         result = AGENT_DATA_TYPES_ERROR;
                         LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
                     }
                     else
                     {
-                        if (sprintf_s(tempBuffer, tempBufferSize, "%.*f", DBL_DIG, value->value.edmDouble.value) < 0)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else if (STRING_concat(destination, tempBuffer) != 0)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", MU_ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else
-                        {
-                            result = AGENT_DATA_TYPES_OK;
-                        }
-
-                        free(tempBuffer);
+                        result = AGENT_DATA_TYPES_OK;
                     }
                 }
                 break;
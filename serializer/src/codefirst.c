@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 #include "azure_c_shared_utility/gballoc.h"
 
 #include "codefirst.h"
@@ -19,6 +20,21 @@ MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_R
 #define LOG_CODEFIRST_ERROR \
     LogError("(result = %s)", MU_ENUM_TO_STRING(CODEFIRST_RESULT, result))
 
+/*the full path of a property (for example "ChildModel/InnerProperty") and its offset in the device data*/
+typedef struct PROPERTY_PATH_TAG
+{
+    size_t offset;
+    const REFLECTED_SOMETHING* reflectedData;
+    char* path;
+} PROPERTY_PATH;
+
+/*the paths of all the properties of a device, sorted by offset*/
+typedef struct PROPERTY_PATH_TABLE_TAG
+{
+    PROPERTY_PATH* paths;
+    size_t count;
+} PROPERTY_PATH_TABLE;
+
 typedef struct DEVICE_HEADER_DATA_TAG
 {
     DEVICE_HANDLE DeviceHandle;
@@ -26,6 +42,8 @@ typedef struct DEVICE_HEADER_DATA_TAG
     SCHEMA_MODEL_TYPE_HANDLE ModelHandle;
     size_t DataSize;
     unsigned char* data;
+    PROPERTY_PATH_TABLE Properties;
+    PROPERTY_PATH_TABLE ReportedProperties;
 } DEVICE_HEADER_DATA;
 
 #define COUNT_OF(A) (sizeof(A) / sizeof((A)[0]))
@@ -80,7 +98,7 @@ MU_DEFINE_ENUM(CODEFIRST_STATE, CODEFIRST_STATE_VALUES)
 static CODEFIRST_STATE g_state = CODEFIRST_STATE_NOT_INIT;
 static const char* g_OverrideSchemaNamespace;
 static size_t g_DeviceCount = 0;
-static DEVICE_HEADER_DATA** g_Devices = NULL;
+static DEVICE_HEADER_DATA** g_Devices = NULL; /*sorted by the address of the device data*/
 
 static void deinitializeDesiredProperties(SCHEMA_MODEL_TYPE_HANDLE model, void* destination)
 {
@@ -153,16 +171,199 @@ static void deinitializeDesiredProperties(SCHEMA_MODEL_TYPE_HANDLE model, void*
     }
 }
 
+static void FreePropertyPathTable(PROPERTY_PATH_TABLE* table)
+{
+    size_t i;
+    for (i = 0; i < table->count; i++)
+    {
+        free(table->paths[i].path);
+    }
+    free(table->paths);
+    table->paths = NULL;
+    table->count = 0;
+}
+
+static char* BuildPropertyPath(const char* parentPath, const char* propertyName)
+{
+    size_t parentPathLength = (parentPath == NULL) ? 0 : strlen(parentPath) + 1; /*+1 for the '/'*/
+    size_t propertyNameLength = strlen(propertyName);
+    char* result = (char*)malloc(parentPathLength + propertyNameLength + 1);
+    if (result == NULL)
+    {
+        LogError("unable to allocate the path of property %s", propertyName);
+    }
+    else
+    {
+        if (parentPath != NULL)
+        {
+            (void)memcpy(result, parentPath, parentPathLength - 1);
+            result[parentPathLength - 1] = '/';
+        }
+        (void)memcpy(result + parentPathLength, propertyName, propertyNameLength + 1);
+    }
+    return result;
+}
+
+/*returns the position of the first path in the table that has an offset greater or equal to offset*/
+static size_t LowerBoundPropertyPath(const PROPERTY_PATH_TABLE* table, size_t offset)
+{
+    size_t low = 0;
+    size_t high = table->count;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (table->paths[middle].offset < offset)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static const PROPERTY_PATH* FindPropertyPath(const PROPERTY_PATH_TABLE* table, size_t offset)
+{
+    size_t position = LowerBoundPropertyPath(table, offset);
+    return ((position < table->count) && (table->paths[position].offset == offset)) ? &table->paths[position] : NULL;
+}
+
+/*adds to table the paths of all the properties (or reported properties) of modelName, and then recursively of its child models.
+The models are walked parent first, so when a child model starts at the same offset as its parent property, the parent property is the one kept for that offset*/
+static int AddPropertyPaths(PROPERTY_PATH_TABLE* table, const REFLECTED_SOMETHING* reflectedData, REFLECTION_TYPE propertyType, const char* modelName, size_t modelOffset, const char* modelPath)
+{
+    int result = 0;
+    const REFLECTED_SOMETHING* something;
+
+    for (something = reflectedData; something != NULL; something = something->next)
+    {
+        if (something->type == propertyType)
+        {
+            const REFLECTION_PROPERTY* property = &something->what.property;
+            const REFLECTION_REPORTED_PROPERTY* reportedProperty = &something->what.reportedProperty;
+            const char* propertyModelName = (propertyType == REFLECTION_PROPERTY_TYPE) ? property->modelName : reportedProperty->modelName;
+
+            if (strcmp(propertyModelName, modelName) == 0)
+            {
+                const char* propertyName = (propertyType == REFLECTION_PROPERTY_TYPE) ? property->name : reportedProperty->name;
+                const char* propertyTypeName = (propertyType == REFLECTION_PROPERTY_TYPE) ? property->type : reportedProperty->type;
+                size_t offset = modelOffset + ((propertyType == REFLECTION_PROPERTY_TYPE) ? property->offset : reportedProperty->offset);
+                size_t position = LowerBoundPropertyPath(table, offset);
+                char* path;
+
+                if ((path = BuildPropertyPath(modelPath, propertyName)) == NULL)
+                {
+                    result = MU_FAILURE;
+                    break;
+                }
+                else if ((position < table->count) && (table->paths[position].offset == offset))
+                {
+                    /*the offset already has a path of a parent property, this path is only needed for the child properties*/
+                    result = AddPropertyPaths(table, reflectedData, propertyType, propertyTypeName, offset, path);
+                    free(path);
+                    if (result != 0)
+                    {
+                        break;
+                    }
+                }
+                else
+                {
+                    PROPERTY_PATH* newPaths = (PROPERTY_PATH*)realloc(table->paths, sizeof(PROPERTY_PATH) * (table->count + 1));
+                    if (newPaths == NULL)
+                    {
+                        LogError("unable to grow the property path table");
+                        free(path);
+                        result = MU_FAILURE;
+                        break;
+                    }
+                    else
+                    {
+                        table->paths = newPaths;
+                        (void)memmove(&table->paths[position + 1], &table->paths[position], (table->count - position) * sizeof(PROPERTY_PATH));
+                        table->paths[position].offset = offset;
+                        table->paths[position].reflectedData = something;
+                        table->paths[position].path = path;
+                        table->count++;
+
+                        /*the table owns path from now on*/
+                        if (AddPropertyPaths(table, reflectedData, propertyType, propertyTypeName, offset, path) != 0)
+                        {
+                            result = MU_FAILURE;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*Codes_SRS_CODEFIRST_99_143: [ CodeFirst_CreateDevice shall build, for the properties and for the reported properties of the model and of its child models, a table of their full paths sorted by their offset in the device data. ]*/
+static int BuildPropertyPathTables(DEVICE_HEADER_DATA* deviceHeader, SCHEMA_MODEL_TYPE_HANDLE model, const REFLECTED_DATA_FROM_DATAPROVIDER* metadata)
+{
+    int result;
+    const char* modelName = Schema_GetModelName(model);
+    if (modelName == NULL)
+    {
+        LogError("unable to get the model name");
+        result = MU_FAILURE;
+    }
+    else if (AddPropertyPaths(&deviceHeader->Properties, metadata->reflectedData, REFLECTION_PROPERTY_TYPE, modelName, 0, NULL) != 0)
+    {
+        LogError("unable to build the property paths of model %s", modelName);
+        FreePropertyPathTable(&deviceHeader->Properties);
+        result = MU_FAILURE;
+    }
+    else if (AddPropertyPaths(&deviceHeader->ReportedProperties, metadata->reflectedData, REFLECTION_REPORTED_PROPERTY_TYPE, modelName, 0, NULL) != 0)
+    {
+        LogError("unable to build the reported property paths of model %s", modelName);
+        FreePropertyPathTable(&deviceHeader->ReportedProperties);
+        FreePropertyPathTable(&deviceHeader->Properties);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
 static void DestroyDevice(DEVICE_HEADER_DATA* deviceHeader)
 {
     /* Codes_SRS_CODEFIRST_99_085:[CodeFirst_DestroyDevice shall free all resources associated with a device.] */
     /* Codes_SRS_CODEFIRST_99_087:[In order to release the device handle, CodeFirst_DestroyDevice shall call Device_Destroy.] */
 
     Device_Destroy(deviceHeader->DeviceHandle);
+    FreePropertyPathTable(&deviceHeader->ReportedProperties);
+    FreePropertyPathTable(&deviceHeader->Properties);
     free(deviceHeader->data);
     free(deviceHeader);
 }
 
+/*returns the number of devices which data starts at or before value, that is the position where a device with data at value would be inserted*/
+static size_t UpperBoundDevice(const void* value)
+{
+    size_t low = 0;
+    size_t high = g_DeviceCount;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (g_Devices[middle]->data <= (const unsigned char*)value)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
 static CODEFIRST_RESULT buildStructTypes(SCHEMA_HANDLE schemaHandle, const REFLECTED_DATA_FROM_DATAPROVIDER* reflectedData)
 {
     CODEFIRST_RESULT result = CODEFIRST_OK;
@@ -738,7 +939,12 @@ SCHEMA_HANDLE CodeFirst_RegisterSchema(const char* schemaNamespace, const REFLEC
                 }
                 else
                 {
-                    /* do nothing, everything is OK */
+                    /*Codes_SRS_CODEFIRST_99_201: [ Once the schema is built, CodeFirst_RegisterSchema shall call Schema_BuildNameIndexes. If that fails, CodeFirst_RegisterSchema shall still succeed, the lookups by name falling back to linear searches. ]*/
+                    /*the indexes are built here, before any device uses the schema, because the lookups made later from several threads only read them*/
+                    if (Schema_BuildNameIndexes(result) != SCHEMA_OK)
+                    {
+                        LogError("unable to build the name indexes of schema %s, lookups by name will be linear", schemaNamespace);
+                    }
                 }
             }
         }
@@ -930,6 +1136,16 @@ void* CodeFirst_CreateDevice(SCHEMA_MODEL_TYPE_HANDLE model, const REFLECTED_DAT
                 result = NULL;
                 LogError(" %s ", MU_ENUM_TO_STRING(CODEFIRST_RESULT, CODEFIRST_ERROR));
             }
+            else if (BuildPropertyPathTables(deviceHeader, model, metadata) != 0)
+            {
+                free(deviceHeader->data);
+                free(deviceHeader);
+                deviceHeader = NULL;
+
+                /* Codes_SRS_CODEFIRST_99_102:[On any other errors, Device_Create shall return NULL.] */
+                result = NULL;
+                LogError(" %s ", MU_ENUM_TO_STRING(CODEFIRST_RESULT, CODEFIRST_ERROR));
+            }
             else
             {
                 DEVICE_HEADER_DATA** newDevices;
@@ -939,6 +1155,8 @@ void* CodeFirst_CreateDevice(SCHEMA_MODEL_TYPE_HANDLE model, const REFLECTED_DAT
                 if (Device_Create(model, CodeFirst_InvokeAction, deviceHeader, CodeFirst_InvokeMethod, deviceHeader,
                     includePropertyPath, &deviceHeader->DeviceHandle) != DEVICE_OK)
                 {
+                    FreePropertyPathTable(&deviceHeader->ReportedProperties);
+                    FreePropertyPathTable(&deviceHeader->Properties);
                     free(deviceHeader->data);
                     free(deviceHeader);
 
@@ -948,9 +1166,7 @@ void* CodeFirst_CreateDevice(SCHEMA_MODEL_TYPE_HANDLE model, const REFLECTED_DAT
                 }
                 else if ((newDevices = (DEVICE_HEADER_DATA**)realloc(g_Devices, sizeof(DEVICE_HEADER_DATA*) * (g_DeviceCount + 1))) == NULL)
                 {
-                    Device_Destroy(deviceHeader->DeviceHandle);
-                    free(deviceHeader->data);
-                    free(deviceHeader);
+                    DestroyDevice(deviceHeader);
 
                     /* Codes_SRS_CODEFIRST_99_102:[On any other errors, Device_Create shall return NULL.] */
                     result = NULL;
@@ -965,18 +1181,20 @@ void* CodeFirst_CreateDevice(SCHEMA_MODEL_TYPE_HANDLE model, const REFLECTED_DAT
                     schemaResult = Schema_AddDeviceRef(model);
                     if (schemaResult != SCHEMA_OK)
                     {
-                        Device_Destroy(deviceHeader->DeviceHandle);
-                        free(newDevices);
-                        free(deviceHeader->data);
-                        free(deviceHeader);
+                        g_Devices = newDevices; /*the block was reallocated, g_Devices still holds g_DeviceCount devices*/
+                        DestroyDevice(deviceHeader);
 
                         /* Codes_SRS_CODEFIRST_99_102:[On any other errors, Device_Create shall return NULL.] */
                         result = NULL;
                     }
                     else
                     {
+                        /*Codes_SRS_CODEFIRST_99_144: [ CodeFirst_CreateDevice shall keep the devices sorted by the address of their data. ]*/
+                        size_t position;
                         g_Devices = newDevices;
-                        g_Devices[g_DeviceCount] = deviceHeader;
+                        position = UpperBoundDevice(deviceHeader->data);
+                        (void)memmove(&g_Devices[position + 1], &g_Devices[position], (g_DeviceCount - position) * sizeof(DEVICE_HEADER_DATA*));
+                        g_Devices[position] = deviceHeader;
                         g_DeviceCount++;
 
                         /* Codes_SRS_CODEFIRST_99_101:[On success, CodeFirst_CreateDevice shall return a non NULL pointer to the device data.] */
@@ -996,23 +1214,21 @@ void CodeFirst_DestroyDevice(void* device)
     /* Codes_SRS_CODEFIRST_99_086:[If the argument is NULL, CodeFirst_DestroyDevice shall do nothing.] */
     if (device != NULL)
     {
-        size_t i;
+        size_t position = UpperBoundDevice(device);
 
-        for (i = 0; i < g_DeviceCount; i++)
+        if ((position > 0) && (g_Devices[position - 1]->data == device))
         {
-            if (g_Devices[i]->data == device)
-            {
-                deinitializeDesiredProperties(g_Devices[i]->ModelHandle, g_Devices[i]->data);
-                Schema_ReleaseDeviceRef(g_Devices[i]->ModelHandle);
+            size_t i = position - 1;
 
-                // Delete the Created Schema if all the devices are unassociated
-                Schema_DestroyIfUnused(g_Devices[i]->ModelHandle);
+            deinitializeDesiredProperties(g_Devices[i]->ModelHandle, g_Devices[i]->data);
+            Schema_ReleaseDeviceRef(g_Devices[i]->ModelHandle);
 
-                DestroyDevice(g_Devices[i]);
-                (void)memcpy(&g_Devices[i], &g_Devices[i + 1], (g_DeviceCount - i - 1) * sizeof(DEVICE_HEADER_DATA*));
-                g_DeviceCount--;
-                break;
-            }
+            // Delete the Created Schema if all the devices are unassociated
+            Schema_DestroyIfUnused(g_Devices[i]->ModelHandle);
+
+            DestroyDevice(g_Devices[i]);
+            (void)memmove(&g_Devices[i], &g_Devices[i + 1], (g_DeviceCount - i - 1) * sizeof(DEVICE_HEADER_DATA*));
+            g_DeviceCount--;
         }
 
         /*Codes_SRS_CODEFIRST_02_039: [ If the current device count is zero then CodeFirst_DestroyDevice shall deallocate all other used resources. ]*/
@@ -1027,97 +1243,14 @@ void CodeFirst_DestroyDevice(void* device)
 
 static DEVICE_HEADER_DATA* FindDevice(void* value)
 {
-    size_t i;
+    /*the device that holds value is the last one which data starts at or before value*/
+    size_t position = UpperBoundDevice(value);
     DEVICE_HEADER_DATA* result = NULL;
 
-    for (i = 0; i < g_DeviceCount; i++)
-    {
-        if ((g_Devices[i]->data <= (unsigned char*)value) &&
-            (g_Devices[i]->data + g_Devices[i]->DataSize > (unsigned char*)value))
-        {
-            result = g_Devices[i];
-            break;
-        }
-    }
-
-    return result;
-}
-
-static const REFLECTED_SOMETHING* FindValue(DEVICE_HEADER_DATA* deviceHeader, void* value, const char* modelName, size_t startOffset, STRING_HANDLE valuePath)
-{
-    const REFLECTED_SOMETHING* result;
-    size_t valueOffset = (size_t)((unsigned char*)value - (unsigned char*)deviceHeader->data) - startOffset;
-
-    for (result = deviceHeader->ReflectedData->reflectedData; result != NULL; result = result->next)
-    {
-        if (result->type == REFLECTION_PROPERTY_TYPE &&
-            (strcmp(result->what.property.modelName, modelName) == 0) &&
-            (result->what.property.offset <= valueOffset) &&
-            (result->what.property.offset + result->what.property.size > valueOffset))
-        {
-            if (startOffset != 0)
-            {
-                STRING_concat(valuePath, "/");
-            }
-
-            STRING_concat(valuePath, result->what.property.name);
-            break;
-        }
-    }
-
-    if (result != NULL)
-    {
-        /* Codes_SRS_CODEFIRST_99_133:[CodeFirst_SendAsync shall allow sending of properties that are part of a child model.] */
-        if (result->what.property.offset < valueOffset)
-        {
-            /* find recursively the property in the inner model, if there is one */
-            result = FindValue(deviceHeader, value, result->what.property.type, startOffset + result->what.property.offset, valuePath);
-        }
-    }
-
-    return result;
-}
-
-static const REFLECTED_SOMETHING* FindReportedProperty(DEVICE_HEADER_DATA* deviceHeader, void* value, const char* modelName, size_t startOffset, STRING_HANDLE valuePath)
-{
-    const REFLECTED_SOMETHING* result;
-    size_t valueOffset = (size_t)((unsigned char*)value - (unsigned char*)deviceHeader->data) - startOffset;
-
-    for (result = deviceHeader->ReflectedData->reflectedData; result != NULL; result = result->next)
-    {
-        if (result->type == REFLECTION_REPORTED_PROPERTY_TYPE &&
-            (strcmp(result->what.reportedProperty.modelName, modelName) == 0) &&
-            (result->what.reportedProperty.offset <= valueOffset) &&
-            (result->what.reportedProperty.offset + result->what.reportedProperty.size > valueOffset))
-        {
-            if (startOffset != 0)
-            {
-                if (STRING_concat(valuePath, "/") != 0)
-                {
-                    LogError("unable to STRING_concat");
-                    result = NULL;
-                    break;
-                }
-            }
-
-            if (STRING_concat(valuePath, result->what.reportedProperty.name) != 0)
-            {
-                LogError("unable to STRING_concat");
-                result = NULL;
-                break;
-            }
-            break;
-        }
-    }
-
-    if (result != NULL)
+    if ((position > 0) &&
+        (g_Devices[position - 1]->data + g_Devices[position - 1]->DataSize > (unsigned char*)value))
     {
-        /* Codes_SRS_CODEFIRST_99_133:[CodeFirst_SendAsync shall allow sending of properties that are part of a child model.] */
-        if (result->what.reportedProperty.offset < valueOffset)
-        {
-            /* find recursively the property in the inner model, if there is one */
-            result = FindReportedProperty(deviceHeader, value, result->what.reportedProperty.type, startOffset + result->what.reportedProperty.offset, valuePath);
-        }
+        result = g_Devices[position - 1];
     }
 
     return result;
@@ -1299,70 +1432,45 @@ CODEFIRST_RESULT CodeFirst_SendAsync(unsigned char** destination, size_t* destin
                 }
                 else
                 {
-                    const REFLECTED_SOMETHING* propertyReflectedData;
-                    const char* modelName;
-                    STRING_HANDLE valuePath;
+                    const PROPERTY_PATH* propertyPath;
 
-                    if ((valuePath = STRING_new()) == NULL)
+                    /* Codes_SRS_CODEFIRST_99_133:[CodeFirst_SendAsync shall allow sending of properties that are part of a child model.] */
+                    /* Codes_SRS_CODEFIRST_99_145: [ CodeFirst_SendAsync shall look up the property by a binary search of its offset in the table built by CodeFirst_CreateDevice. ]*/
+                    if ((propertyPath = FindPropertyPath(&deviceHeader->Properties, (size_t)((unsigned char*)value - deviceHeader->data))) == NULL)
                     {
-                        /* Codes_SRS_CODEFIRST_99_134:[If CodeFirst_Notify fails for any other reason it shall return CODEFIRST_ERROR.] */
-                        result = CODEFIRST_ERROR;
+                        /* Codes_SRS_CODEFIRST_99_104:[If a property cannot be associated with a device, CodeFirst_SendAsync shall return CODEFIRST_INVALID_ARG.] */
+                        result = CODEFIRST_INVALID_ARG;
                         LOG_CODEFIRST_ERROR;
                         break;
                     }
                     else
                     {
-                        if ((modelName = Schema_GetModelName(deviceHeader->ModelHandle)) == NULL)
-                        {
-                            /* Codes_SRS_CODEFIRST_99_134:[If CodeFirst_Notify fails for any other reason it shall return CODEFIRST_ERROR.] */
-                            result = CODEFIRST_ERROR;
-                            LOG_CODEFIRST_ERROR;
-                            STRING_delete(valuePath);
-                            break;
-                        }
-                        else if ((propertyReflectedData = FindValue(deviceHeader, value, modelName, 0, valuePath)) == NULL)
+                        AGENT_DATA_TYPE agentDataType;
+
+                        /* Codes_SRS_CODEFIRST_99_097:[For each value marshalling to AGENT_DATA_TYPE shall be performed.] */
+                        /* Codes_SRS_CODEFIRST_99_098:[The marshalling shall be done by calling the Create_AGENT_DATA_TYPE_from_Ptr function associated with the property.] */
+                        if (propertyPath->reflectedData->what.property.Create_AGENT_DATA_TYPE_from_Ptr(value, &agentDataType) != AGENT_DATA_TYPES_OK)
                         {
-                            /* Codes_SRS_CODEFIRST_99_104:[If a property cannot be associated with a device, CodeFirst_SendAsync shall return CODEFIRST_INVALID_ARG.] */
-                            result = CODEFIRST_INVALID_ARG;
+                            /* Codes_SRS_CODEFIRST_99_099:[If Create_AGENT_DATA_TYPE_from_Ptr fails, CodeFirst_SendAsync shall return CODEFIRST_AGENT_DATA_TYPE_ERROR.] */
+                            result = CODEFIRST_AGENT_DATA_TYPE_ERROR;
                             LOG_CODEFIRST_ERROR;
-                            STRING_delete(valuePath);
                             break;
                         }
                         else
                         {
-                            AGENT_DATA_TYPE agentDataType;
-
-                            /* Codes_SRS_CODEFIRST_99_097:[For each value marshalling to AGENT_DATA_TYPE shall be performed.] */
-                            /* Codes_SRS_CODEFIRST_99_098:[The marshalling shall be done by calling the Create_AGENT_DATA_TYPE_from_Ptr function associated with the property.] */
-                            if (propertyReflectedData->what.property.Create_AGENT_DATA_TYPE_from_Ptr(value, &agentDataType) != AGENT_DATA_TYPES_OK)
+                            /* Codes_SRS_CODEFIRST_99_092:[CodeFirst shall publish each value by using Device_PublishTransacted.] */
+                            /* Codes_SRS_CODEFIRST_99_136:[CodeFirst_SendAsync shall build the full path for each property and then pass it to Device_PublishTransacted.] */
+                            if (Device_PublishTransacted(transaction, propertyPath->path, &agentDataType) != DEVICE_OK)
                             {
-                                /* Codes_SRS_CODEFIRST_99_099:[If Create_AGENT_DATA_TYPE_from_Ptr fails, CodeFirst_SendAsync shall return CODEFIRST_AGENT_DATA_TYPE_ERROR.] */
-                                result = CODEFIRST_AGENT_DATA_TYPE_ERROR;
+                                Destroy_AGENT_DATA_TYPE(&agentDataType);
+
+                                /* Codes_SRS_CODEFIRST_99_094:[If any Device API fail, CodeFirst_SendAsync shall return CODEFIRST_DEVICE_PUBLISH_FAILED.] */
+                                result = CODEFIRST_DEVICE_PUBLISH_FAILED;
                                 LOG_CODEFIRST_ERROR;
-                                STRING_delete(valuePath);
                                 break;
                             }
-                            else
-                            {
-                                /* Codes_SRS_CODEFIRST_99_092:[CodeFirst shall publish each value by using Device_PublishTransacted.] */
-                                /* Codes_SRS_CODEFIRST_99_136:[CodeFirst_SendAsync shall build the full path for each property and then pass it to Device_PublishTransacted.] */
-                                if (Device_PublishTransacted(transaction, STRING_c_str(valuePath), &agentDataType) != DEVICE_OK)
-                                {
-                                    Destroy_AGENT_DATA_TYPE(&agentDataType);
-
-                                    /* Codes_SRS_CODEFIRST_99_094:[If any Device API fail, CodeFirst_SendAsync shall return CODEFIRST_DEVICE_PUBLISH_FAILED.] */
-                                    result = CODEFIRST_DEVICE_PUBLISH_FAILED;
-                                    LOG_CODEFIRST_ERROR;
-                                    STRING_delete(valuePath);
-                                    break;
-                                }
-                                else
-                                {
-                                    STRING_delete(valuePath); /*anyway*/
-                                }
 
-                                Destroy_AGENT_DATA_TYPE(&agentDataType);
-                            }
+                            Destroy_AGENT_DATA_TYPE(&agentDataType);
                         }
                     }
                 }
@@ -1469,56 +1577,36 @@ CODEFIRST_RESULT CodeFirst_SendAsyncReported(unsigned char** destination, size_t
                     else
                     {
                         /*Codes_SRS_CODEFIRST_02_020: [ If values passed through va_args are not all of type REFLECTED_REPORTED_PROPERTY then CodeFirst_SendAsyncReported shall fail and return CODEFIRST_INVALID_ARG. ]*/
-                        const REFLECTED_SOMETHING* propertyReflectedData;
-                        const char* modelName;
+                        const PROPERTY_PATH* propertyPath;
 
-                        STRING_HANDLE valuePath;
-                        if ((valuePath = STRING_new()) == NULL)
+                        /*Codes_SRS_CODEFIRST_02_025: [ CodeFirst_SendAsyncReported shall compute for every AGENT_DATA_TYPE the valuePath. ]*/
+                        if ((propertyPath = FindPropertyPath(&deviceHeader->ReportedProperties, (size_t)((unsigned char*)value - deviceHeader->data))) == NULL)
                         {
-                            result = CODEFIRST_ERROR;
+                            result = CODEFIRST_INVALID_ARG;
                             LOG_CODEFIRST_ERROR;
                             break;
                         }
                         else
                         {
-                            modelName = Schema_GetModelName(deviceHeader->ModelHandle);
-
-                            /*Codes_SRS_CODEFIRST_02_025: [ CodeFirst_SendAsyncReported shall compute for every AGENT_DATA_TYPE the valuePath. ]*/
-                            if ((propertyReflectedData = FindReportedProperty(deviceHeader, value, modelName, 0, valuePath)) == NULL)
+                            AGENT_DATA_TYPE agentDataType;
+                            /*Codes_SRS_CODEFIRST_02_023: [ CodeFirst_SendAsyncReported shall convert all REPORTED_PROPERTY model components to AGENT_DATA_TYPE. ]*/
+                            if (propertyPath->reflectedData->what.reportedProperty.Create_AGENT_DATA_TYPE_from_Ptr(value, &agentDataType) != AGENT_DATA_TYPES_OK)
                             {
-                                result = CODEFIRST_INVALID_ARG;
+                                result = CODEFIRST_AGENT_DATA_TYPE_ERROR;
                                 LOG_CODEFIRST_ERROR;
-                                STRING_delete(valuePath);
                                 break;
                             }
                             else
                             {
-                                AGENT_DATA_TYPE agentDataType;
-                                /*Codes_SRS_CODEFIRST_02_023: [ CodeFirst_SendAsyncReported shall convert all REPORTED_PROPERTY model components to AGENT_DATA_TYPE. ]*/
-                                if (propertyReflectedData->what.reportedProperty.Create_AGENT_DATA_TYPE_from_Ptr(value, &agentDataType) != AGENT_DATA_TYPES_OK)
+                                /*Codes_SRS_CODEFIRST_02_024: [ CodeFirst_SendAsyncReported shall call Device_PublishTransacted_ReportedProperty for every AGENT_DATA_TYPE converted from REPORTED_PROPERTY. ]*/
+                                if (Device_PublishTransacted_ReportedProperty(transaction, propertyPath->path, &agentDataType) != DEVICE_OK)
                                 {
-                                    result = CODEFIRST_AGENT_DATA_TYPE_ERROR;
+                                    Destroy_AGENT_DATA_TYPE(&agentDataType);
+                                    result = CODEFIRST_DEVICE_PUBLISH_FAILED;
                                     LOG_CODEFIRST_ERROR;
-                                    STRING_delete(valuePath);
                                     break;
                                 }
-                                else
-                                {
-                                    /*Codes_SRS_CODEFIRST_02_024: [ CodeFirst_SendAsyncReported shall call Device_PublishTransacted_ReportedProperty for every AGENT_DATA_TYPE converted from REPORTED_PROPERTY. ]*/
-                                    if (Device_PublishTransacted_ReportedProperty(transaction, STRING_c_str(valuePath), &agentDataType) != DEVICE_OK)
-                                    {
-                                        Destroy_AGENT_DATA_TYPE(&agentDataType);
-                                        result = CODEFIRST_DEVICE_PUBLISH_FAILED;
-                                        LOG_CODEFIRST_ERROR;
-                                        STRING_delete(valuePath);
-                                        break;
-                                    }
-                                    else
-                                    {
-                                        STRING_delete(valuePath);
-                                    }
-                                    Destroy_AGENT_DATA_TYPE(&agentDataType);
-                                }
+                                Destroy_AGENT_DATA_TYPE(&agentDataType);
                             }
                         }
                     }
@@ -26,128 +26,220 @@ typedef struct COMMAND_DECODER_HANDLE_DATA_TAG
     void* ActionCallbackContext;
 } COMMAND_DECODER_HANDLE_DATA;
 
-static int DecodeValueFromNode(SCHEMA_HANDLE schemaHandle, AGENT_DATA_TYPE* agentDataType, MULTITREE_HANDLE node, const char* edmTypeName)
+#define TOKEN_TEXT_BUFFER_SIZE 64
+
+/*the '\0' terminated text of a JSON token. Only the texts that do not fit in buffer are allocated*/
+typedef struct TOKEN_TEXT_TAG
 {
-    /* because "pottentially uninitialized variable on MS compiler" */
-    int result = 0;
-    const char* argStringValue;
-    AGENT_DATA_TYPE_TYPE primitiveType;
+    char buffer[TOKEN_TEXT_BUFFER_SIZE];
+    char* allocated;
+} TOKEN_TEXT;
 
-    /* Codes_SRS_COMMAND_DECODER_99_029:[ If the argument type is complex then a complex type value shall be built from the child nodes.] */
-    if ((primitiveType = CodeFirst_GetPrimitiveType(edmTypeName)) == EDM_NO_TYPE)
+static const char* TokenText_Create(TOKEN_TEXT* tokenText, const JSON_DECODER_TOKEN* token)
+{
+    char* result;
+
+    tokenText->allocated = NULL;
+    if (token->length < TOKEN_TEXT_BUFFER_SIZE)
+    {
+        result = tokenText->buffer;
+    }
+    else if ((tokenText->allocated = (char*)malloc(token->length + 1)) == NULL)
+    {
+        LogError("failure allocating %lu bytes for the text of a JSON token", (unsigned long)(token->length + 1));
+        result = NULL;
+    }
+    else
+    {
+        result = tokenText->allocated;
+    }
+
+    if (result != NULL)
+    {
+        (void)memcpy(result, token->text, token->length);
+        result[token->length] = '\0';
+    }
+
+    return result;
+}
+
+static void TokenText_Destroy(TOKEN_TEXT* tokenText)
+{
+    if (tokenText->allocated != NULL)
+    {
+        free(tokenText->allocated);
+    }
+}
+
+/*objectReader is a copy of reader positioned inside the JSON object at which reader is, ready for JSONDecoder_Reader_GetMember*/
+static int EnterObject(const JSON_DECODER_READER* reader, JSON_DECODER_READER* objectReader)
+{
+    int result;
+    JSON_DECODER_TOKEN token;
+
+    *objectReader = *reader;
+    if (JSONDecoder_Reader_Next(objectReader, &token) != JSON_DECODER_OK)
+    {
+        result = MU_FAILURE;
+        LogError("failure in JSONDecoder_Reader_Next");
+    }
+    else if (token.type != JSON_DECODER_TOKEN_BEGIN_OBJECT)
+    {
+        result = MU_FAILURE;
+        LogError("expected a JSON object, found a token of type %d", (int)token.type);
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int DecodeValueFromNode(SCHEMA_HANDLE schemaHandle, AGENT_DATA_TYPE* agentDataType, MULTITREE_HANDLE node, const char* edmTypeName);
+
+static int DecodeStructMemberFromNode(SCHEMA_HANDLE schemaHandle, AGENT_DATA_TYPE* memberValue, MULTITREE_HANDLE node, const char* memberName, const char* memberType)
+{
+    int result;
+    MULTITREE_HANDLE memberNode;
+
+    /* Codes_SRS_COMMAND_DECODER_01_014: [CommandDecoder shall use the MultiTree APIs to extract a specific element from the command JSON.] */
+    if (MultiTree_GetChildByName(node, memberName, &memberNode) != MULTITREE_OK)
+    {
+        /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+        result = MU_FAILURE;
+        LogError("Getting child %s failed", memberName);
+    }
+    else
     {
-        SCHEMA_STRUCT_TYPE_HANDLE structTypeHandle;
-        size_t propertyCount;
+        result = DecodeValueFromNode(schemaHandle, memberValue, memberNode, memberType);
+    }
+
+    return result;
+}
+
+static int DecodeStructValueFromNode(SCHEMA_HANDLE schemaHandle, AGENT_DATA_TYPE* agentDataType, MULTITREE_HANDLE node, const char* edmTypeName)
+{
+    int result;
+    SCHEMA_STRUCT_TYPE_HANDLE structTypeHandle;
+    size_t propertyCount;
 
-        /* Codes_SRS_COMMAND_DECODER_99_033:[ In order to determine which are the members of a complex types, Schema APIs for structure types shall be used.] */
-        if (((structTypeHandle = Schema_GetStructTypeByName(schemaHandle, edmTypeName)) == NULL) ||
-            (Schema_GetStructTypePropertyCount(structTypeHandle, &propertyCount) != SCHEMA_OK))
+    /* Codes_SRS_COMMAND_DECODER_99_033:[ In order to determine which are the members of a complex types, Schema APIs for structure types shall be used.] */
+    if (((structTypeHandle = Schema_GetStructTypeByName(schemaHandle, edmTypeName)) == NULL) ||
+        (Schema_GetStructTypePropertyCount(structTypeHandle, &propertyCount) != SCHEMA_OK))
+    {
+        /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
+        result = MU_FAILURE;
+        LogError("Getting Struct information failed.");
+    }
+    else
+    {
+        if (propertyCount == 0)
         {
-            /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
+            /* Codes_SRS_COMMAND_DECODER_99_034:[ If Schema APIs indicate that a complex type has 0 members then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
             result = MU_FAILURE;
-            LogError("Getting Struct information failed.");
+            LogError("Struct type with 0 members is not allowed");
         }
         else
         {
-            if (propertyCount == 0)
+            AGENT_DATA_TYPE* memberValues = (AGENT_DATA_TYPE*)calloc(1, (sizeof(AGENT_DATA_TYPE)* propertyCount));
+            if (memberValues == NULL)
             {
-                /* Codes_SRS_COMMAND_DECODER_99_034:[ If Schema APIs indicate that a complex type has 0 members then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+                /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
                 result = MU_FAILURE;
-                LogError("Struct type with 0 members is not allowed");
+                LogError("Failed allocating member values for command argument");
             }
             else
             {
-                AGENT_DATA_TYPE* memberValues = (AGENT_DATA_TYPE*)calloc(1, (sizeof(AGENT_DATA_TYPE)* propertyCount));
-                if (memberValues == NULL)
+                const char** memberNames = (const char**)malloc(sizeof(const char*)* propertyCount);
+                if (memberNames == NULL)
                 {
                     /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
                     result = MU_FAILURE;
-                    LogError("Failed allocating member values for command argument");
+                    LogError("Failed allocating member names for command argument.");
                 }
                 else
                 {
-                    const char** memberNames = (const char**)malloc(sizeof(const char*)* propertyCount);
-                    if (memberNames == NULL)
-                    {
-                        /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
-                        result = MU_FAILURE;
-                        LogError("Failed allocating member names for command argument.");
-                    }
-                    else
+                    size_t j;
+                    size_t k;
+
+                    result = 0;
+                    for (j = 0; j < propertyCount; j++)
                     {
-                        size_t j;
-                        size_t k;
+                        SCHEMA_PROPERTY_HANDLE propertyHandle;
+                        const char* propertyName;
+                        const char* propertyType;
 
-                        for (j = 0; j < propertyCount; j++)
+                        if ((propertyHandle = Schema_GetStructTypePropertyByIndex(structTypeHandle, j)) == NULL)
+                        {
+                            /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
+                            result = MU_FAILURE;
+                            LogError("Getting struct member failed.");
+                            break;
+                        }
+                        else if (((propertyName = Schema_GetPropertyName(propertyHandle)) == NULL) ||
+                                 ((propertyType = Schema_GetPropertyType(propertyHandle)) == NULL))
+                        {
+                            /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
+                            result = MU_FAILURE;
+                            LogError("Getting the struct member information failed.");
+                            break;
+                        }
+                        else
                         {
-                            SCHEMA_PROPERTY_HANDLE propertyHandle;
-                            MULTITREE_HANDLE memberNode;
-                            const char* propertyName;
-                            const char* propertyType;
+                            memberNames[j] = propertyName;
 
-                            if ((propertyHandle = Schema_GetStructTypePropertyByIndex(structTypeHandle, j)) == NULL)
-                            {
-                                /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-                                result = MU_FAILURE;
-                                LogError("Getting struct member failed.");
-                                break;
-                            }
-                            else if (((propertyName = Schema_GetPropertyName(propertyHandle)) == NULL) ||
-                                     ((propertyType = Schema_GetPropertyType(propertyHandle)) == NULL))
+                            /* Codes_SRS_COMMAND_DECODER_99_032:[ Nesting shall be supported for complex type.] */
+                            if ((result = DecodeStructMemberFromNode(schemaHandle, &memberValues[j], node, propertyName, propertyType)) != 0)
                             {
-                                /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
-                                result = MU_FAILURE;
-                                LogError("Getting the struct member information failed.");
                                 break;
                             }
-                            else
-                            {
-                                memberNames[j] = propertyName;
-
-                                /* Codes_SRS_COMMAND_DECODER_01_014: [CommandDecoder shall use the MultiTree APIs to extract a specific element from the command JSON.] */
-                                if (MultiTree_GetChildByName(node, memberNames[j], &memberNode) != MULTITREE_OK)
-                                {
-                                    /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-                                    result = MU_FAILURE;
-                                    LogError("Getting child %s failed", propertyName);
-                                    break;
-                                }
-                                /* Codes_SRS_COMMAND_DECODER_99_032:[ Nesting shall be supported for complex type.] */
-                                else if ((result = DecodeValueFromNode(schemaHandle, &memberValues[j], memberNode, propertyType)) != 0)
-                                {
-                                    break;
-                                }
-                            }
                         }
+                    }
 
-                        if (j == propertyCount)
+                    if (j == propertyCount)
+                    {
+                        /* Codes_SRS_COMMAND_DECODER_99_031:[ The complex type value that aggregates the children shall be built by using the Create_AGENT_DATA_TYPE_from_Members.] */
+                        if (Create_AGENT_DATA_TYPE_from_Members(agentDataType, edmTypeName, propertyCount, (const char* const*)memberNames, memberValues) != AGENT_DATA_TYPES_OK)
                         {
-                            /* Codes_SRS_COMMAND_DECODER_99_031:[ The complex type value that aggregates the children shall be built by using the Create_AGENT_DATA_TYPE_from_Members.] */
-                            if (Create_AGENT_DATA_TYPE_from_Members(agentDataType, edmTypeName, propertyCount, (const char* const*)memberNames, memberValues) != AGENT_DATA_TYPES_OK)
-                            {
-                                /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
-                                result = MU_FAILURE;
-                                LogError("Creating the agent data type from members failed.");
-                            }
-                            else
-                            {
-                                result = 0;
-                            }
+                            /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+                            result = MU_FAILURE;
+                            LogError("Creating the agent data type from members failed.");
                         }
-
-                        for (k = 0; k < j; k++)
+                        else
                         {
-                            Destroy_AGENT_DATA_TYPE(&memberValues[k]);
+                            result = 0;
                         }
+                    }
 
-                        free((void*)memberNames);
+                    for (k = 0; k < j; k++)
+                    {
+                        Destroy_AGENT_DATA_TYPE(&memberValues[k]);
                     }
 
-                    free(memberValues);
+                    free((void*)memberNames);
                 }
+
+                free(memberValues);
             }
         }
     }
+
+    return result;
+}
+
+static int DecodeValueFromNode(SCHEMA_HANDLE schemaHandle, AGENT_DATA_TYPE* agentDataType, MULTITREE_HANDLE node, const char* edmTypeName)
+{
+    /* because "pottentially uninitialized variable on MS compiler" */
+    int result = 0;
+    const char* argStringValue;
+    AGENT_DATA_TYPE_TYPE primitiveType;
+
+    /* Codes_SRS_COMMAND_DECODER_99_029:[ If the argument type is complex then a complex type value shall be built from the child nodes.] */
+    if ((primitiveType = CodeFirst_GetPrimitiveType(edmTypeName)) == EDM_NO_TYPE)
+    {
+        result = DecodeStructValueFromNode(schemaHandle, agentDataType, node, edmTypeName);
+    }
     else
     {
         /* Codes_SRS_COMMAND_DECODER_01_014: [CommandDecoder shall use the MultiTree APIs to extract a specific element from the command JSON.] */
@@ -169,6 +261,278 @@ static int DecodeValueFromNode(SCHEMA_HANDLE schemaHandle, AGENT_DATA_TYPE* agen
     return result;
 }
 
+static int DecodeValueFromReader(SCHEMA_HANDLE schemaHandle, AGENT_DATA_TYPE* agentDataType, JSON_DECODER_READER* reader, const char* edmTypeName);
+
+/*reads the JSON object at which reader is in a single pass. A member called memberNames[i] is decoded as a memberTypes[i] into memberValues[i] as soon as it is read,*/
+/*other members are skipped. When a member appears more than once only the first one is decoded. On failure no decoded value is left to destroy*/
+static int DecodeMembersFromReader(SCHEMA_HANDLE schemaHandle, JSON_DECODER_READER* reader, size_t memberCount, const char* const* memberNames, const char* const* memberTypes, AGENT_DATA_TYPE* memberValues)
+{
+    int result;
+    JSON_DECODER_TOKEN token;
+    bool* isDecoded;
+
+    if (JSONDecoder_Reader_Next(reader, &token) != JSON_DECODER_OK)
+    {
+        result = MU_FAILURE;
+        LogError("failure in JSONDecoder_Reader_Next");
+    }
+    else if (token.type != JSON_DECODER_TOKEN_BEGIN_OBJECT)
+    {
+        result = MU_FAILURE;
+        LogError("expected a JSON object, found a token of type %d", (int)token.type);
+    }
+    else if ((isDecoded = (bool*)calloc(memberCount, sizeof(bool))) == NULL)
+    {
+        result = MU_FAILURE;
+        LogError("failure allocating the decoded flags of %lu members", (unsigned long)memberCount);
+    }
+    else
+    {
+        size_t decodedCount = 0;
+        size_t i;
+        bool isDone = false;
+
+        result = 0;
+        while (!isDone)
+        {
+            if (JSONDecoder_Reader_Next(reader, &token) != JSON_DECODER_OK)
+            {
+                result = MU_FAILURE;
+                LogError("failure in JSONDecoder_Reader_Next");
+                isDone = true;
+            }
+            else if (token.type == JSON_DECODER_TOKEN_END_OBJECT)
+            {
+                isDone = true;
+            }
+            else
+            {
+                for (i = 0; i < memberCount; i++)
+                {
+                    if ((!isDecoded[i]) &&
+                        (strncmp(memberNames[i], token.text, token.length) == 0) &&
+                        (memberNames[i][token.length] == '\0'))
+                    {
+                        break;
+                    }
+                }
+
+                if (i == memberCount)
+                {
+                    if (JSONDecoder_Reader_SkipValue(reader) != JSON_DECODER_OK)
+                    {
+                        result = MU_FAILURE;
+                        LogError("failure in JSONDecoder_Reader_SkipValue");
+                        isDone = true;
+                    }
+                }
+                /* Codes_SRS_COMMAND_DECODER_99_032:[ Nesting shall be supported for complex type.] */
+                else if (DecodeValueFromReader(schemaHandle, &memberValues[i], reader, memberTypes[i]) != 0)
+                {
+                    /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+                    result = MU_FAILURE;
+                    LogError("failure decoding member %s", memberNames[i]);
+                    isDone = true;
+                }
+                else
+                {
+                    isDecoded[i] = true;
+                    decodedCount++;
+                }
+            }
+        }
+
+        if ((result == 0) &&
+            (decodedCount != memberCount))
+        {
+            for (i = 0; (i < memberCount) && isDecoded[i]; i++)
+            {
+                /*looking for the first member that is missing*/
+            }
+
+            /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+            result = MU_FAILURE;
+            LogError("Missing member %s", memberNames[i]);
+        }
+
+        if (result != 0)
+        {
+            for (i = 0; i < memberCount; i++)
+            {
+                if (isDecoded[i])
+                {
+                    Destroy_AGENT_DATA_TYPE(&memberValues[i]);
+                }
+            }
+        }
+
+        free(isDecoded);
+    }
+
+    return result;
+}
+
+static int DecodeStructValueFromReader(SCHEMA_HANDLE schemaHandle, AGENT_DATA_TYPE* agentDataType, JSON_DECODER_READER* reader, const char* edmTypeName)
+{
+    int result;
+    SCHEMA_STRUCT_TYPE_HANDLE structTypeHandle;
+    size_t propertyCount;
+
+    /* Codes_SRS_COMMAND_DECODER_99_033:[ In order to determine which are the members of a complex types, Schema APIs for structure types shall be used.] */
+    if (((structTypeHandle = Schema_GetStructTypeByName(schemaHandle, edmTypeName)) == NULL) ||
+        (Schema_GetStructTypePropertyCount(structTypeHandle, &propertyCount) != SCHEMA_OK))
+    {
+        /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
+        result = MU_FAILURE;
+        LogError("Getting Struct information failed.");
+    }
+    else
+    {
+        if (propertyCount == 0)
+        {
+            /* Codes_SRS_COMMAND_DECODER_99_034:[ If Schema APIs indicate that a complex type has 0 members then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+            result = MU_FAILURE;
+            LogError("Struct type with 0 members is not allowed");
+        }
+        else
+        {
+            AGENT_DATA_TYPE* memberValues = (AGENT_DATA_TYPE*)calloc(1, (sizeof(AGENT_DATA_TYPE)* propertyCount));
+            if (memberValues == NULL)
+            {
+                /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
+                result = MU_FAILURE;
+                LogError("Failed allocating member values for command argument");
+            }
+            else
+            {
+                /*the member names are followed by the member types*/
+                const char** memberNames = (const char**)malloc(2 * sizeof(const char*)* propertyCount);
+                if (memberNames == NULL)
+                {
+                    /* Codes_SRS_COMMAND_DECODER_99_021:[ If the parsing of the command fails for any other reason the command shall not be dispatched.] */
+                    result = MU_FAILURE;
+                    LogError("Failed allocating member names for command argument.");
+                }
+                else
+                {
+                    const char** memberTypes = memberNames + propertyCount;
+                    size_t j;
+                    size_t k;
+
+                    result = 0;
+                    for (j = 0; j < propertyCount; j++)
+                    {
+                        SCHEMA_PROPERTY_HANDLE propertyHandle;
+
+                        if ((propertyHandle = Schema_GetStructTypePropertyByIndex(structTypeHandle, j)) == NULL)
+                        {
+                            /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
+                            result = MU_FAILURE;
+                            LogError("Getting struct member failed.");
+                            break;
+                        }
+                        else if (((memberNames[j] = Schema_GetPropertyName(propertyHandle)) == NULL) ||
+                                 ((memberTypes[j] = Schema_GetPropertyType(propertyHandle)) == NULL))
+                        {
+                            /* Codes_SRS_COMMAND_DECODER_99_010:[ If any Schema API fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.]*/
+                            result = MU_FAILURE;
+                            LogError("Getting the struct member information failed.");
+                            break;
+                        }
+                    }
+
+                    if (j == propertyCount)
+                    {
+                        /* Codes_SRS_COMMAND_DECODER_02_026: [ The members of a complex type value read from JSON shall be decoded in a single pass over the JSON object, each member being matched by name as it is read. ]*/
+                        if (DecodeMembersFromReader(schemaHandle, reader, propertyCount, (const char* const*)memberNames, (const char* const*)memberTypes, memberValues) != 0)
+                        {
+                            /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+                            result = MU_FAILURE;
+                            LogError("failure decoding the members of a value of type %s", edmTypeName);
+                        }
+                        else
+                        {
+                            /* Codes_SRS_COMMAND_DECODER_99_031:[ The complex type value that aggregates the children shall be built by using the Create_AGENT_DATA_TYPE_from_Members.] */
+                            if (Create_AGENT_DATA_TYPE_from_Members(agentDataType, edmTypeName, propertyCount, (const char* const*)memberNames, memberValues) != AGENT_DATA_TYPES_OK)
+                            {
+                                /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+                                result = MU_FAILURE;
+                                LogError("Creating the agent data type from members failed.");
+                            }
+
+                            for (k = 0; k < propertyCount; k++)
+                            {
+                                Destroy_AGENT_DATA_TYPE(&memberValues[k]);
+                            }
+                        }
+                    }
+
+                    free((void*)memberNames);
+                }
+
+                free(memberValues);
+            }
+        }
+    }
+
+    return result;
+}
+
+/*decodes the JSON value at the position of reader and advances reader past it*/
+static int DecodeValueFromReader(SCHEMA_HANDLE schemaHandle, AGENT_DATA_TYPE* agentDataType, JSON_DECODER_READER* reader, const char* edmTypeName)
+{
+    int result;
+    JSON_DECODER_TOKEN token;
+    AGENT_DATA_TYPE_TYPE primitiveType;
+
+    if ((primitiveType = CodeFirst_GetPrimitiveType(edmTypeName)) == EDM_NO_TYPE)
+    {
+        /* Codes_SRS_COMMAND_DECODER_99_029:[ If the argument type is complex then a complex type value shall be built from the child nodes.] */
+        result = DecodeStructValueFromReader(schemaHandle, agentDataType, reader, edmTypeName);
+    }
+    else if (JSONDecoder_Reader_Next(reader, &token) != JSON_DECODER_OK)
+    {
+        result = MU_FAILURE;
+        LogError("failure in JSONDecoder_Reader_Next");
+    }
+    else if ((token.type != JSON_DECODER_TOKEN_STRING) &&
+        (token.type != JSON_DECODER_TOKEN_NUMBER) &&
+        (token.type != JSON_DECODER_TOKEN_LITERAL))
+    {
+        /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+        result = MU_FAILURE;
+        LogError("the value of type %s is not a JSON string, number or literal", edmTypeName);
+    }
+    else
+    {
+        TOKEN_TEXT tokenText;
+        const char* argStringValue;
+
+        if ((argStringValue = TokenText_Create(&tokenText, &token)) == NULL)
+        {
+            result = MU_FAILURE;
+            LogError("failure in TokenText_Create");
+        }
+        else
+        {
+            /* Codes_SRS_COMMAND_DECODER_99_027:[ The value for an argument of primitive type shall be decoded by using the CreateAgentDataType_From_String API.] */
+            if (CreateAgentDataType_From_String(argStringValue, primitiveType, agentDataType) != AGENT_DATA_TYPES_OK)
+            {
+                /* Codes_SRS_COMMAND_DECODER_99_028:[ If decoding the argument fails then the command shall not be dispatched and it shall return EXECUTE_COMMAND_ERROR.] */
+                result = MU_FAILURE;
+                LogError("Failed parsing value %s.", argStringValue);
+            }
+            else
+            {
+                result = 0;
+            }
+            TokenText_Destroy(&tokenText);
+        }
+    }
+
+    return result;
+}
+
 static EXECUTE_COMMAND_RESULT DecodeAndExecuteModelAction(COMMAND_DECODER_HANDLE_DATA* commandDecoderInstance, SCHEMA_HANDLE schemaHandle, SCHEMA_MODEL_TYPE_HANDLE modelHandle, const char* relativeActionPath, const char* actionName, MULTITREE_HANDLE commandNode)
 {
     EXECUTE_COMMAND_RESULT result;
@@ -294,7 +658,7 @@ static EXECUTE_COMMAND_RESULT DecodeAndExecuteModelAction(COMMAND_DECODER_HANDLE
     return result;
 }
 
-static METHODRETURN_HANDLE DecodeAndExecuteModelMethod(COMMAND_DECODER_HANDLE_DATA* commandDecoderInstance, SCHEMA_HANDLE schemaHandle, SCHEMA_MODEL_TYPE_HANDLE modelHandle, const char* relativeMethodPath, const char* methodName, MULTITREE_HANDLE methodTree)
+static METHODRETURN_HANDLE DecodeAndExecuteModelMethod(COMMAND_DECODER_HANDLE_DATA* commandDecoderInstance, SCHEMA_HANDLE schemaHandle, SCHEMA_MODEL_TYPE_HANDLE modelHandle, const char* relativeMethodPath, const char* methodName, const JSON_DECODER_READER* methodReader)
 {
     METHODRETURN_HANDLE result;
     size_t strLength = strlen(methodName);
@@ -324,13 +688,18 @@ static METHODRETURN_HANDLE DecodeAndExecuteModelMethod(COMMAND_DECODER_HANDLE_DA
         }
         else
         {
-            /*Codes_SRS_COMMAND_DECODER_02_021: [ For every argument of methodName, CommandDecoder_ExecuteMethod shall build an AGENT_DATA_TYPE from the node with the same name from the MULTITREE_HANDLE. ]*/
-
+            /*Codes_SRS_COMMAND_DECODER_02_021: [ For every argument of methodName, CommandDecoder_ExecuteMethod shall build an AGENT_DATA_TYPE from the member with the same name of the JSON object in methodPayload. ]*/
             if (argCount == 0)
             {
                 /*no need for any parameters*/
                 result = commandDecoderInstance->methodCallback(commandDecoderInstance->methodCallbackContext, relativeMethodPath, methodName, 0, NULL);
             }
+            else if (methodReader == NULL)
+            {
+                /*Codes_SRS_COMMAND_DECODER_02_023: [ If any of the previous operations fail, then CommandDecoder_ExecuteMethod shall return NULL. ]*/
+                LogError("method %s has arguments but methodPayload is NULL", methodName);
+                result = NULL;
+            }
             else
             {
                 AGENT_DATA_TYPE* arguments;
@@ -342,57 +711,66 @@ static METHODRETURN_HANDLE DecodeAndExecuteModelMethod(COMMAND_DECODER_HANDLE_DA
                 }
                 else
                 {
-                    size_t i;
-                    size_t j;
-                    result = NULL;
-
-                    for (i = 0; i < argCount; i++)
+                    /*the argument names are followed by the argument types*/
+                    const char** argNames = (const char**)malloc(2 * sizeof(const char*)* argCount);
+                    if (argNames == NULL)
                     {
-                        SCHEMA_METHOD_ARGUMENT_HANDLE methodArgumentHandle;
-                        MULTITREE_HANDLE argumentNode;
-                        const char* argName;
-                        const char* argType;
+                        /*Codes_SRS_COMMAND_DECODER_02_023: [ If any of the previous operations fail, then CommandDecoder_ExecuteMethod shall return NULL. ]*/
+                        LogError("Failed allocating argument names array");
+                        result = NULL;
+                    }
+                    else
+                    {
+                        const char** argTypes = argNames + argCount;
+                        size_t i;
+                        size_t j;
+                        result = NULL;
 
-                        if (((methodArgumentHandle = Schema_GetModelMethodArgumentByIndex(modelMethodHandle, i)) == NULL) ||
-                            ((argName = Schema_GetMethodArgumentName(methodArgumentHandle)) == NULL) ||
-                            ((argType = Schema_GetMethodArgumentType(methodArgumentHandle)) == NULL))
+                        for (i = 0; i < argCount; i++)
                         {
-                            /*Codes_SRS_COMMAND_DECODER_02_023: [ If any of the previous operations fail, then CommandDecoder_ExecuteMethod shall return NULL. ]*/
-                            LogError("Failed getting the argument information from the schema");
-                            result = NULL;
-                            break;
-                        }
-                        else if (MultiTree_GetChildByName(methodTree, argName, &argumentNode) != MULTITREE_OK)
-                        {
-                            /*Codes_SRS_COMMAND_DECODER_02_023: [ If any of the previous operations fail, then CommandDecoder_ExecuteMethod shall return NULL. ]*/
-                            LogError("Missing argument %s", argName);
-                            result = NULL;
-                            break;
+                            SCHEMA_METHOD_ARGUMENT_HANDLE methodArgumentHandle;
+
+                            if (((methodArgumentHandle = Schema_GetModelMethodArgumentByIndex(modelMethodHandle, i)) == NULL) ||
+                                ((argNames[i] = Schema_GetMethodArgumentName(methodArgumentHandle)) == NULL) ||
+                                ((argTypes[i] = Schema_GetMethodArgumentType(methodArgumentHandle)) == NULL))
+                            {
+                                /*Codes_SRS_COMMAND_DECODER_02_023: [ If any of the previous operations fail, then CommandDecoder_ExecuteMethod shall return NULL. ]*/
+                                LogError("Failed getting the argument information from the schema");
+                                result = NULL;
+                                break;
+                            }
                         }
-                        else if (DecodeValueFromNode(schemaHandle, &arguments[i], argumentNode, argType) != 0)
+
+                        if (i == argCount)
                         {
-                            /*Codes_SRS_COMMAND_DECODER_02_023: [ If any of the previous operations fail, then CommandDecoder_ExecuteMethod shall return NULL. ]*/
-                            LogError("failure in DecodeValueFromNode");
-                            result = NULL;
-                            break;
-                        }
-                    }
+                            /*the arguments are read from a copy, methodReader is left where it is*/
+                            JSON_DECODER_READER argumentsReader = *methodReader;
 
-                    if (i == argCount)
-                    {
-                        /*Codes_SRS_COMMAND_DECODER_02_022: [ CommandDecoder_ExecuteMethod shall call methodCallback passing the context, the methodName, number of arguments and the AGENT_DATA_TYPE. ]*/
-                        /*Codes_SRS_COMMAND_DECODER_02_024: [ Otherwise, CommandDecoder_ExecuteMethod shall return what methodCallback returns. ]*/
-                        result = commandDecoderInstance->methodCallback(commandDecoderInstance->methodCallbackContext, relativeMethodPath, methodName, argCount, arguments);
-                    }
+                            /*Codes_SRS_COMMAND_DECODER_02_027: [ The arguments shall be decoded in a single pass over the JSON object in methodPayload, each member being matched to an argument by name as it is read. ]*/
+                            if (DecodeMembersFromReader(schemaHandle, &argumentsReader, argCount, (const char* const*)argNames, (const char* const*)argTypes, arguments) != 0)
+                            {
+                                /*Codes_SRS_COMMAND_DECODER_02_023: [ If any of the previous operations fail, then CommandDecoder_ExecuteMethod shall return NULL. ]*/
+                                LogError("failure decoding the arguments of method %s", methodName);
+                                result = NULL;
+                            }
+                            else
+                            {
+                                /*Codes_SRS_COMMAND_DECODER_02_022: [ CommandDecoder_ExecuteMethod shall call methodCallback passing the context, the methodName, number of arguments and the AGENT_DATA_TYPE. ]*/
+                                /*Codes_SRS_COMMAND_DECODER_02_024: [ Otherwise, CommandDecoder_ExecuteMethod shall return what methodCallback returns. ]*/
+                                result = commandDecoderInstance->methodCallback(commandDecoderInstance->methodCallbackContext, relativeMethodPath, methodName, argCount, arguments);
 
-                    for (j = 0; j < i; j++)
-                    {
-                        Destroy_AGENT_DATA_TYPE(&arguments[j]);
+                                for (j = 0; j < argCount; j++)
+                                {
+                                    Destroy_AGENT_DATA_TYPE(&arguments[j]);
+                                }
+                            }
+                        }
+
+                        free((void*)argNames);
                     }
 
                     free(arguments);
                 }
-
             }
         }
 
@@ -486,7 +864,7 @@ static EXECUTE_COMMAND_RESULT ScanActionPathAndExecuteAction(COMMAND_DECODER_HAN
     return result;
 }
 
-static METHODRETURN_HANDLE ScanMethodPathAndExecuteMethod(COMMAND_DECODER_HANDLE_DATA* commandDecoderInstance, SCHEMA_HANDLE schemaHandle, const char* fullMethodName, MULTITREE_HANDLE methodTree)
+static METHODRETURN_HANDLE ScanMethodPathAndExecuteMethod(COMMAND_DECODER_HANDLE_DATA* commandDecoderInstance, SCHEMA_HANDLE schemaHandle, const char* fullMethodName, const JSON_DECODER_READER* methodReader)
 {
     METHODRETURN_HANDLE result;
     char* relativeMethodPath;
@@ -525,7 +903,7 @@ static METHODRETURN_HANDLE ScanMethodPathAndExecuteMethod(COMMAND_DECODER_HANDLE
                 relativeMethodPath[relativeMethodPathLength] = 0;
 
                 /* no slash found, this must be an method */
-                result = DecodeAndExecuteModelMethod(commandDecoderInstance, schemaHandle, modelHandle, relativeMethodPath, methodName, methodTree);
+                result = DecodeAndExecuteModelMethod(commandDecoderInstance, schemaHandle, modelHandle, relativeMethodPath, methodName, methodReader);
 
                 free(relativeMethodPath);
                 methodName = NULL;
@@ -612,7 +990,7 @@ static EXECUTE_COMMAND_RESULT DecodeCommand(COMMAND_DECODER_HANDLE_DATA* command
     return result;
 }
 
-static METHODRETURN_HANDLE DecodeMethod(COMMAND_DECODER_HANDLE_DATA* commandDecoderInstance, const char* fullMethodName, MULTITREE_HANDLE methodTree)
+static METHODRETURN_HANDLE DecodeMethod(COMMAND_DECODER_HANDLE_DATA* commandDecoderInstance, const char* fullMethodName, const JSON_DECODER_READER* methodReader)
 {
     METHODRETURN_HANDLE result;
     SCHEMA_HANDLE schemaHandle;
@@ -625,7 +1003,7 @@ static METHODRETURN_HANDLE DecodeMethod(COMMAND_DECODER_HANDLE_DATA* commandDeco
     }
     else
     {
-        result = ScanMethodPathAndExecuteMethod(commandDecoderInstance, schemaHandle, fullMethodName, methodTree);
+        result = ScanMethodPathAndExecuteMethod(commandDecoderInstance, schemaHandle, fullMethodName, methodReader);
 
     }
     return result;
@@ -714,34 +1092,23 @@ METHODRETURN_HANDLE CommandDecoder_ExecuteMethod(COMMAND_DECODER_HANDLE handle,
         }
         else
         {
-            /*Codes_SRS_COMMAND_DECODER_02_016: [ If methodPayload is not NULL then CommandDecoder_ExecuteMethod shall build a MULTITREE_HANDLE out of methodPayload. ]*/
+            /*Codes_SRS_COMMAND_DECODER_02_016: [ If methodPayload is not NULL then CommandDecoder_ExecuteMethod shall read methodPayload in place with a JSON_DECODER_READER initialized by JSONDecoder_Reader_Init. ]*/
             if (methodPayload == NULL)
             {
                 result = DecodeMethod(commandDecoderInstance, fullMethodName, NULL);
             }
             else
             {
-                char* methodJSON;
+                JSON_DECODER_READER methodReader;
 
-                if (mallocAndStrcpy_s(&methodJSON, methodPayload) != 0)
+                if (JSONDecoder_Reader_Init(&methodReader, methodPayload) != JSON_DECODER_OK)
                 {
-                    LogError("Failed to allocate temporary storage for the method JSON");
+                    LogError("failure in JSONDecoder_Reader_Init");
                     result = NULL;
                 }
                 else
                 {
-                    MULTITREE_HANDLE methodTree;
-                    if (JSONDecoder_JSON_To_MultiTree(methodJSON, &methodTree) != JSON_DECODER_OK)
-                    {
-                        LogError("Decoding JSON to a multi tree failed");
-                        result = NULL;
-                    }
-                    else
-                    {
-                        result = DecodeMethod(commandDecoderInstance, fullMethodName, methodTree);
-                        MultiTree_Destroy(methodTree);
-                    }
-                    free(methodJSON);
+                    result = DecodeMethod(commandDecoderInstance, fullMethodName, &methodReader);
                 }
             }
         }
@@ -797,74 +1164,101 @@ void CommandDecoder_Destroy(COMMAND_DECODER_HANDLE commandDecoderHandle)
 
 MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(AGENT_DATA_TYPE_TYPE, AGENT_DATA_TYPE_TYPE_VALUES);
 
-/*validates that the multitree (coming from a JSON) is actually a serialization of the model (complete or incomplete)*/
+/*validates that the JSON object at which reader is, is actually a serialization of the model (complete or incomplete)*/
 /*if the serialization contains more than the model, then it fails.*/
 /*if the serialization does not contain mandatory items from the model, it fails*/
-static bool validateModel_vs_Multitree(void* startAddress, SCHEMA_MODEL_TYPE_HANDLE modelHandle, MULTITREE_HANDLE desiredPropertiesTree, size_t offset)
+static bool validateModel_vs_JSON(void* startAddress, SCHEMA_MODEL_TYPE_HANDLE modelHandle, JSON_DECODER_READER* reader, size_t offset, bool skipVersion)
 {
-
     bool result;
-    size_t nChildren;
-    size_t nProcessedChildren = 0;
-    (void)MultiTree_GetChildCount(desiredPropertiesTree, &nChildren);
-    for (size_t i = 0;i < nChildren;i++)
+    JSON_DECODER_TOKEN token;
+
+    if ((JSONDecoder_Reader_Next(reader, &token) != JSON_DECODER_OK) ||
+        (token.type != JSON_DECODER_TOKEN_BEGIN_OBJECT))
     {
-        MULTITREE_HANDLE child;
-        if (MultiTree_GetChild(desiredPropertiesTree, i, &child) != MULTITREE_OK)
-        {
-            LogError("failure in MultiTree_GetChild");
-            i = nChildren;
-        }
-        else
+        LogError("the desired properties are not a JSON object");
+        result = false;
+    }
+    else
+    {
+        bool isDone = false;
+
+        result = true;
+        while (!isDone)
         {
-            STRING_HANDLE childName = STRING_new();
-            if (childName == NULL)
+            if (JSONDecoder_Reader_Next(reader, &token) != JSON_DECODER_OK)
             {
-                LogError("failure to STRING_new");
-                i = nChildren;
+                LogError("failure in JSONDecoder_Reader_Next");
+                result = false;
+                isDone = true;
+            }
+            else if (token.type == JSON_DECODER_TOKEN_END_OBJECT)
+            {
+                /*Codes_SRS_COMMAND_DECODER_02_010: [ If the complete JSON object has been read then CommandDecoder_IngestDesiredProperties shall succeed and return EXECUTE_COMMAND_SUCCESS. ]*/
+                isDone = true;
+            }
+            /*Codes_COMMAND_DECODER_02_015: [ A '$version' member of the desired properties shall be skipped with JSONDecoder_Reader_SkipValue. It not being present is not an error ]*/
+            else if (
+                skipVersion &&
+                (token.length == sizeof("$version") - 1) &&
+                (memcmp(token.text, "$version", sizeof("$version") - 1) == 0)
+                )
+            {
+                if (JSONDecoder_Reader_SkipValue(reader) != JSON_DECODER_OK)
+                {
+                    LogError("failure in JSONDecoder_Reader_SkipValue");
+                    result = false;
+                    isDone = true;
+                }
             }
             else
             {
-                if (MultiTree_GetName(child, childName) != MULTITREE_OK)
+                TOKEN_TEXT tokenText;
+                const char* childName_str;
+
+                if ((childName_str = TokenText_Create(&tokenText, &token)) == NULL)
                 {
-                    LogError("failure to MultiTree_GetName");
-                    i = nChildren;
+                    LogError("failure in TokenText_Create");
+                    result = false;
+                    isDone = true;
                 }
                 else
                 {
-                    const char *childName_str = STRING_c_str(childName);
                     SCHEMA_MODEL_ELEMENT elementType = Schema_GetModelElementByName(modelHandle, childName_str);
                     switch (elementType.elementType)
                     {
                         default:
                         {
                             LogError("INTERNAL ERROR: unexpected function return");
-                            i = nChildren;
+                            result = false;
+                            isDone = true;
                             break;
                         }
                         case (SCHEMA_PROPERTY):
                         {
                             LogError("cannot ingest name (WITH_DATA instead of WITH_DESIRED_PROPERTY): %s", childName_str);
-                            i = nChildren;
+                            result = false;
+                            isDone = true;
                             break;
                         }
                         case (SCHEMA_REPORTED_PROPERTY):
                         {
                             LogError("cannot ingest name (WITH_REPORTED_PROPERTY instead of WITH_DESIRED_PROPERTY): %s", childName_str);
-                            i = nChildren;
+                            result = false;
+                            isDone = true;
                             break;
                         }
                         case (SCHEMA_DESIRED_PROPERTY):
                         {
-                            /*Codes_SRS_COMMAND_DECODER_02_007: [ If the child name corresponds to a desired property then an AGENT_DATA_TYPE shall be constructed from the MULTITREE node. ]*/
+                            /*Codes_SRS_COMMAND_DECODER_02_007: [ If the member name corresponds to a desired property then an AGENT_DATA_TYPE shall be constructed from the member value. ]*/
                             SCHEMA_DESIRED_PROPERTY_HANDLE desiredPropertyHandle = elementType.elementHandle.desiredPropertyHandle;
 
                             const char* desiredPropertyType = Schema_GetModelDesiredPropertyType(desiredPropertyHandle);
                             AGENT_DATA_TYPE output;
-                            if (DecodeValueFromNode(Schema_GetSchemaForModelType(modelHandle), &output, child, desiredPropertyType) != 0)
+                            if (DecodeValueFromReader(Schema_GetSchemaForModelType(modelHandle), &output, reader, desiredPropertyType) != 0)
                             {
-                                LogError("failure in DecodeValueFromNode");
-                                i = nChildren;
+                                LogError("failure in DecodeValueFromReader");
+                                result = false;
+                                isDone = true;
                             }
                             else
                             {
@@ -873,6 +1267,7 @@ static bool validateModel_vs_Multitree(void* startAddress, SCHEMA_MODEL_TYPE_HAN
                                 if (leFunction(&output, (char*)startAddress + offset + Schema_GetModelDesiredProperty_offset(desiredPropertyHandle)) != 0)
                                 {
                                     LogError("failure in a function that converts from AGENT_DATA_TYPE to C data");
+                                    result = false;
                                 }
                                 else
                                 {
@@ -882,7 +1277,6 @@ static bool validateModel_vs_Multitree(void* startAddress, SCHEMA_MODEL_TYPE_HAN
                                     {
                                         onDesiredProperty((char*)startAddress + offset);
                                     }
-                                    nProcessedChildren++;
                                 }
                                 Destroy_AGENT_DATA_TYPE(&output);
                             }
@@ -893,11 +1287,12 @@ static bool validateModel_vs_Multitree(void* startAddress, SCHEMA_MODEL_TYPE_HAN
                         {
                             SCHEMA_MODEL_TYPE_HANDLE modelModel = elementType.elementHandle.modelHandle;
 
-                            /*Codes_SRS_COMMAND_DECODER_02_009: [ If the child name corresponds to a model in model then the function shall call itself recursively. ]*/
-                            if (!validateModel_vs_Multitree(startAddress, modelModel, child, offset + Schema_GetModelModelByName_Offset(modelHandle, childName_str)))
+                            /*Codes_SRS_COMMAND_DECODER_02_009: [ If the member name corresponds to a model in model then the function shall call itself recursively. ]*/
+                            if (!validateModel_vs_JSON(startAddress, modelModel, reader, offset + Schema_GetModelModelByName_Offset(modelHandle, childName_str), false))
                             {
-                                LogError("failure in validateModel_vs_Multitree");
-                                i = nChildren;
+                                LogError("failure in validateModel_vs_JSON");
+                                result = false;
+                                isDone = true;
                             }
                             else
                             {
@@ -908,73 +1303,59 @@ static bool validateModel_vs_Multitree(void* startAddress, SCHEMA_MODEL_TYPE_HAN
                                 {
                                     onDesiredProperty((char*)startAddress + offset);
                                 }
-
-                                nProcessedChildren++;
                             }
 
                             break;
                         }
 
                     } /*switch*/
+                    TokenText_Destroy(&tokenText);
                 }
-                STRING_delete(childName);
             }
         }
-    }
 
-    if(nProcessedChildren == nChildren)
-    {
-        /*Codes_SRS_COMMAND_DECODER_02_010: [ If the complete MULTITREE has been parsed then CommandDecoder_IngestDesiredProperties shall succeed and return EXECUTE_COMMAND_SUCCESS. ]*/
-        result = true;
-    }
-    else
-    {
-        /*Codes_SRS_COMMAND_DECODER_02_011: [ Otherwise CommandDecoder_IngestDesiredProperties shall fail and return EXECUTE_COMMAND_FAILED. ]*/
-        LogError("not all constituents of the JSON have been ingested");
-        result = false;
+        if (!result)
+        {
+            /*Codes_SRS_COMMAND_DECODER_02_011: [ Otherwise CommandDecoder_IngestDesiredProperties shall fail and return EXECUTE_COMMAND_FAILED. ]*/
+            LogError("not all constituents of the JSON have been ingested");
+        }
     }
     return result;
 }
 
-static EXECUTE_COMMAND_RESULT DecodeDesiredProperties(void* startAddress, COMMAND_DECODER_HANDLE_DATA* handle, MULTITREE_HANDLE desiredPropertiesTree)
+static EXECUTE_COMMAND_RESULT DecodeDesiredProperties(void* startAddress, COMMAND_DECODER_HANDLE_DATA* handle, JSON_DECODER_READER* desiredPropertiesReader)
 {
-    /*Codes_SRS_COMMAND_DECODER_02_006: [ CommandDecoder_IngestDesiredProperties shall parse the MULTITREEE recursively. ]*/
-    return validateModel_vs_Multitree(startAddress, handle->ModelHandle, desiredPropertiesTree, 0 )?EXECUTE_COMMAND_SUCCESS:EXECUTE_COMMAND_FAILED;
+    /*Codes_SRS_COMMAND_DECODER_02_006: [ CommandDecoder_IngestDesiredProperties shall read the desired properties recursively, in a single pass. ]*/
+    return validateModel_vs_JSON(startAddress, handle->ModelHandle, desiredPropertiesReader, 0, true)?EXECUTE_COMMAND_SUCCESS:EXECUTE_COMMAND_FAILED;
 }
 
-/* Raw JSON has properties we don't need; potentially nodes other than "desired" for full TWIN as well as a $version we don't pass to callees */
-static bool RemoveUnneededTwinProperties(MULTITREE_HANDLE initialParsedTree, bool parseDesiredNode, MULTITREE_HANDLE *desiredPropertiesTree)
+/* Raw JSON potentially has nodes other than "desired" for full TWIN; those are skipped by positioning the reader at the "desired" value */
+static bool SkipUnneededTwinProperties(JSON_DECODER_READER* twinReader, bool parseDesiredNode, JSON_DECODER_READER* desiredPropertiesReader)
 {
-    MULTITREE_HANDLE updateTree;
     bool result;
 
     if (parseDesiredNode)
     {
-        /*Codes_SRS_COMMAND_DECODER_02_014: [ If parseDesiredNode is TRUE, parse only the `desired` part of JSON tree ]*/
-        if (MultiTree_GetChildByName(initialParsedTree, "desired", &updateTree) != MULTITREE_OK)
+        JSON_DECODER_READER objectReader;
+
+        /*Codes_SRS_COMMAND_DECODER_02_014: [ If parseDesiredNode is TRUE, read only the value of the `desired` member of the JSON, located with JSONDecoder_Reader_GetMember ]*/
+        if ((EnterObject(twinReader, &objectReader) != 0) ||
+            (JSONDecoder_Reader_GetMember(&objectReader, "desired", desiredPropertiesReader) != JSON_DECODER_OK))
         {
-            LogError("Unable to find 'desired' in tree");
-            return false;
+            LogError("Unable to find 'desired' in JSON");
+            result = false;
+        }
+        else
+        {
+            result = true;
         }
     }
     else
     {
-        // Tree already starts on node we want so just use it.
-        updateTree = initialParsedTree;
-    }
-
-    /*Codes_COMMAND_DECODER_02_015: [ Remove '$version' string from node, if it is present.  It not being present is not an error ]*/
-    MULTITREE_RESULT deleteChildResult = MultiTree_DeleteChild(updateTree, "$version");
-    if ((deleteChildResult == MULTITREE_OK) || (deleteChildResult == MULTITREE_CHILD_NOT_FOUND))
-    {
-        *desiredPropertiesTree = updateTree;
+        // Reader already starts on the object we want so just use it.
+        *desiredPropertiesReader = *twinReader;
         result = true;
     }
-    else
-    {
-        *desiredPropertiesTree = NULL;
-        result = false;
-    }
 
     return result;
 }
@@ -997,43 +1378,27 @@ EXECUTE_COMMAND_RESULT CommandDecoder_IngestDesiredProperties(void* startAddress
     }
     else
     {
-        /*Codes_SRS_COMMAND_DECODER_02_004: [ CommandDecoder_IngestDesiredProperties shall clone desiredProperties. ]*/
-        char* copy;
-        if (mallocAndStrcpy_s(&copy, jsonPayload) != 0)
+        /*Codes_SRS_COMMAND_DECODER_02_004: [ CommandDecoder_IngestDesiredProperties shall read jsonPayload in place, without cloning it. ]*/
+        /*Codes_SRS_COMMAND_DECODER_02_005: [ CommandDecoder_IngestDesiredProperties shall initialize a JSON_DECODER_READER over jsonPayload by calling JSONDecoder_Reader_Init. ]*/
+        JSON_DECODER_READER twinReader;
+        JSON_DECODER_READER desiredPropertiesReader;
+
+        if (JSONDecoder_Reader_Init(&twinReader, jsonPayload) != JSON_DECODER_OK)
+        {
+            LogError("Decoding JSON failed");
+            result = EXECUTE_COMMAND_ERROR;
+        }
+        else if (SkipUnneededTwinProperties(&twinReader, parseDesiredNode, &desiredPropertiesReader) == false)
         {
-            LogError("failure in mallocAndStrcpy_s");
-            result = EXECUTE_COMMAND_FAILED;
+            LogError("Skipping unneeded twin properties failed");
+            result = EXECUTE_COMMAND_ERROR;
         }
         else
         {
-            /*Codes_SRS_COMMAND_DECODER_02_005: [ CommandDecoder_IngestDesiredProperties shall create a MULTITREE_HANDLE ouf of the clone of desiredProperties. ]*/
-            MULTITREE_HANDLE initialParsedTree;
-            MULTITREE_HANDLE desiredPropertiesTree;
-
-            if (JSONDecoder_JSON_To_MultiTree(copy, &initialParsedTree) != JSON_DECODER_OK)
-            {
-                LogError("Decoding JSON to a multi tree failed");
-                result = EXECUTE_COMMAND_ERROR;
-            }
-            else
-            {
-                if (RemoveUnneededTwinProperties(initialParsedTree, parseDesiredNode, &desiredPropertiesTree) == false)
-                {
-                    LogError("Removing unneeded twin properties failed");
-                    result = EXECUTE_COMMAND_ERROR;
-                }
-                else
-                {
-                    COMMAND_DECODER_HANDLE_DATA* commandDecoderInstance = (COMMAND_DECODER_HANDLE_DATA*)handle;
+            COMMAND_DECODER_HANDLE_DATA* commandDecoderInstance = (COMMAND_DECODER_HANDLE_DATA*)handle;
 
-                    /*Codes_SRS_COMMAND_DECODER_02_006: [ CommandDecoder_IngestDesiredProperties shall parse the MULTITREEE recursively. ]*/
-                    result = DecodeDesiredProperties(startAddress, commandDecoderInstance, desiredPropertiesTree);
-
-                    // Do NOT free desiredPropertiesTree.  It is only a pointer into initialParsedTree.
-                    MultiTree_Destroy(initialParsedTree);
-                }
-            }
-            free(copy);
+            /*Codes_SRS_COMMAND_DECODER_02_006: [ CommandDecoder_IngestDesiredProperties shall read the desired properties recursively, in a single pass. ]*/
+            result = DecodeDesiredProperties(startAddress, commandDecoderInstance, &desiredPropertiesReader);
         }
     }
     return result;
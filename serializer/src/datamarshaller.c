@@ -5,6 +5,7 @@
 #include "azure_c_shared_utility/gballoc.h"
 
 #include <stdbool.h>
+#include <string.h>
 #include "datamarshaller.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "schema.h"
@@ -73,11 +74,251 @@ void DataMarshaller_Destroy(DATA_MARSHALLER_HANDLE dataMarshallerHandle)
     }
 }
 
+/*the members of the JSON object are the struct members when a single struct is sent without its property path, otherwise they are the values*/
+static bool MembersAreStructFields(bool includePropertyPath, size_t valueCount, const DATA_MARSHALLER_VALUE* values)
+{
+    return (includePropertyPath == false) && (valueCount == 1) && (values[0].Value->type == EDM_COMPLEX_TYPE_TYPE);
+}
+
+static void GetMember(bool membersAreStructFields, const DATA_MARSHALLER_VALUE* values, size_t index, const char** name, const AGENT_DATA_TYPE** value)
+{
+    if (membersAreStructFields)
+    {
+        *name = values[0].Value->value.edmComplexType.fields[index].fieldName;
+        *value = values[0].Value->value.edmComplexType.fields[index].value;
+    }
+    else
+    {
+        /*same as MultiTree_AddLeaf, a leading / is not part of the name*/
+        *name = (values[index].PropertyPath[0] == '/') ? values[index].PropertyPath + 1 : values[index].PropertyPath;
+        *value = values[index].Value;
+    }
+}
+
+/*returns true when every member goes at the root of the JSON object under a distinct name, that is when the MultiTree would have a single level.
+The names are not compared with each other, that would be quadratic in the number of members on every send: struct field names are unique
+per struct type (Schema_AddStructTypeProperty) and DataPublisher keeps one value per property path. Only "x" and "/x" name the same member
+with distinct paths, so property paths are flat when all or none of them have the leading slash*/
+static bool MembersAreFlat(bool membersAreStructFields, const DATA_MARSHALLER_VALUE* values, size_t memberCount)
+{
+    size_t i;
+    size_t leadingSlashCount = 0;
+    for (i = 0; i < memberCount; i++)
+    {
+        const char* name;
+        const AGENT_DATA_TYPE* value;
+        GetMember(membersAreStructFields, values, i, &name, &value);
+        if ((name[0] == '\0') || (strchr(name, '/') != NULL))
+        {
+            break;
+        }
+        if (!membersAreStructFields && (values[i].PropertyPath[0] == '/'))
+        {
+            leadingSlashCount++;
+        }
+    }
+    return (i == memberCount) && ((leadingSlashCount == 0) || (leadingSlashCount == memberCount));
+}
+
+/*writes {"name1":value1, "name2":value2} - the same text JSONEncoder_EncodeTree produces for a single level tree - straight into the destination buffer.
+All the values are first converted into one STRING, then the output is allocated once at its final size*/
+static DATA_MARSHALLER_RESULT EncodeFlatMembers(bool membersAreStructFields, const DATA_MARSHALLER_VALUE* values, size_t memberCount, unsigned char** destination, size_t* destinationSize)
+{
+    DATA_MARSHALLER_RESULT result;
+    size_t* valueEnds = (memberCount > 0) ? (size_t*)malloc(memberCount * sizeof(size_t)) : NULL; /*where each value ends in valuesText*/
+    STRING_HANDLE valuesText;
+
+    if ((memberCount > 0) && (valueEnds == NULL))
+    {
+        result = DATA_MARSHALLER_ERROR;
+        LOG_DATA_MARSHALLER_ERROR
+    }
+    else
+    {
+        if ((valuesText = STRING_new()) == NULL)
+        {
+            result = DATA_MARSHALLER_ERROR;
+            LOG_DATA_MARSHALLER_ERROR
+        }
+        else
+        {
+            size_t i;
+            size_t resultSize = 2; /*{}*/
+            for (i = 0; i < memberCount; i++)
+            {
+                const char* name;
+                const AGENT_DATA_TYPE* value;
+                GetMember(membersAreStructFields, values, i, &name, &value);
+                if (AgentDataTypes_ToString(valuesText, value) != AGENT_DATA_TYPES_OK)
+                {
+                    break;
+                }
+                valueEnds[i] = STRING_length(valuesText);
+                resultSize += strlen(name) + ((i > 0) ? 5 : 3); /*, "name":*/
+            }
+
+            if (i < memberCount)
+            {
+                /*Codes_SRS_DATA_MARSHALLER_99_036:[ DATA_MARSHALLER_AGENT_DATA_TYPES_ERROR shall be returned in case any AgentTypeSystem APIs fails.]*/
+                result = DATA_MARSHALLER_AGENT_DATA_TYPES_ERROR;
+                LOG_DATA_MARSHALLER_ERROR
+            }
+            else
+            {
+                unsigned char* temp;
+                resultSize += (memberCount > 0) ? valueEnds[memberCount - 1] : 0;
+                if ((temp = (unsigned char*)malloc(resultSize)) == NULL)
+                {
+                    /*Codes_SRS_DATA_MARSHALLER_99_015:[ DATA_MARSHALLER_ERROR shall be returned in all the other error cases not explicitly defined here.]*/
+                    result = DATA_MARSHALLER_ERROR;
+                    LOG_DATA_MARSHALLER_ERROR
+                }
+                else
+                {
+                    const char* text = STRING_c_str(valuesText);
+                    size_t valueStart = 0;
+                    size_t position = 0;
+                    temp[position++] = '{';
+                    for (i = 0; i < memberCount; i++)
+                    {
+                        const char* name;
+                        const AGENT_DATA_TYPE* value;
+                        size_t nameLength;
+                        GetMember(membersAreStructFields, values, i, &name, &value);
+                        nameLength = strlen(name);
+
+                        if (i > 0)
+                        {
+                            temp[position++] = ',';
+                            temp[position++] = ' ';
+                        }
+                        temp[position++] = '"';
+                        (void)memcpy(temp + position, name, nameLength);
+                        position += nameLength;
+                        temp[position++] = '"';
+                        temp[position++] = ':';
+                        (void)memcpy(temp + position, text + valueStart, valueEnds[i] - valueStart);
+                        position += valueEnds[i] - valueStart;
+                        valueStart = valueEnds[i];
+                    }
+                    temp[position] = '}';
+
+                    /*Codes_SRS_DATAMARSHALLER_02_007: [DataMarshaller_SendData shall copy in the output parameters *destination, *destinationSize the content and the content length of the encoded JSON tree.] */
+                    *destination = temp;
+                    *destinationSize = resultSize;
+                    result = DATA_MARSHALLER_OK;
+                }
+            }
+            STRING_delete(valuesText);
+        }
+        free(valueEnds);
+    }
+    return result;
+}
+
+static DATA_MARSHALLER_RESULT EncodeTree(bool includePropertyPath, size_t valueCount, const DATA_MARSHALLER_VALUE* values, unsigned char** destination, size_t* destinationSize)
+{
+    DATA_MARSHALLER_RESULT result;
+    MULTITREE_HANDLE treeHandle;
+
+    /* Codes_SRS_DATA_MARSHALLER_99_037:[DataMarshaller shall store as MultiTree the data to be encoded by the JSONEncoder module.] */
+    if ((treeHandle = MultiTree_Create(NoCloneFunction, NoFreeFunction)) == NULL)
+    {
+        /* Codes_SRS_DATA_MARSHALLER_99_035:[DATA_MARSHALLER_MULTITREE_ERROR shall be returned in case any MultiTree API call fails.] */
+        result = DATA_MARSHALLER_MULTITREE_ERROR;
+        LOG_DATA_MARSHALLER_ERROR
+    }
+    else
+    {
+        size_t j;
+        result = DATA_MARSHALLER_OK; /* addressing warning in VS compiler */
+        /* Codes_SRS_DATA_MARSHALLER_99_038:[For each pair in the values argument, a string : value pair shall exist in the JSON object in the form of propertyName : value.] */
+        for (j = 0; j < valueCount; j++)
+        {
+            if ((includePropertyPath == false) && (values[j].Value->type == EDM_COMPLEX_TYPE_TYPE))
+            {
+                size_t k;
+
+                /* Codes_SRS_DATAMARSHALLER_01_001: [If the includePropertyPath argument passed to DataMarshaller_Create was false and only one struct is being sent, the relative path of the value passed to DataMarshaller_SendData - including property name - shall be ignored and the value shall be placed at JSON root.] */
+                for (k = 0; k < values[j].Value->value.edmComplexType.nMembers; k++)
+                {
+                    /* Codes_SRS_DATAMARSHALLER_01_004: [In this case the members of the struct shall be added as leafs into the MultiTree, each leaf having the name of the struct member.] */
+                    if (MultiTree_AddLeaf(treeHandle, values[j].Value->value.edmComplexType.fields[k].fieldName, (void*)values[j].Value->value.edmComplexType.fields[k].value) != MULTITREE_OK)
+                    {
+                        break;
+                    }
+                }
+
+                if (k < values[j].Value->value.edmComplexType.nMembers)
+                {
+                    /* Codes_SRS_DATA_MARSHALLER_99_035:[DATA_MARSHALLER_MULTITREE_ERROR shall be returned in case any MultiTree API call fails.] */
+                    result = DATA_MARSHALLER_MULTITREE_ERROR;
+                    LOG_DATA_MARSHALLER_ERROR
+                    break;
+                }
+            }
+            else
+            {
+                /* Codes_SRS_DATA_MARSHALLER_99_039:[ If the includePropertyPath argument passed to DataMarshaller_Create was true each property shall be placed in the appropriate position in the JSON according to its path in the model.] */
+                if (MultiTree_AddLeaf(treeHandle, values[j].PropertyPath, (void*)values[j].Value) != MULTITREE_OK)
+                {
+                    /* Codes_SRS_DATA_MARSHALLER_99_035:[DATA_MARSHALLER_MULTITREE_ERROR shall be returned in case any MultiTree API call fails.] */
+                    result = DATA_MARSHALLER_MULTITREE_ERROR;
+                    LOG_DATA_MARSHALLER_ERROR
+                    break;
+                }
+            }
+
+        }
+
+        if (j == valueCount)
+        {
+            STRING_HANDLE payload = STRING_new();
+            if (payload == NULL)
+            {
+                result = DATA_MARSHALLER_ERROR;
+                LOG_DATA_MARSHALLER_ERROR
+            }
+            else
+            {
+                if (JSONEncoder_EncodeTree(treeHandle, payload, (JSON_ENCODER_TOSTRING_FUNC)AgentDataTypes_ToString) != JSON_ENCODER_OK)
+                {
+                    /* Codes_SRS_DATA_MARSHALLER_99_027:[ DATA_MARSHALLER_JSON_ENCODER_ERROR shall be returned when JSONEncoder returns an error code.] */
+                    result = DATA_MARSHALLER_JSON_ENCODER_ERROR;
+                    LOG_DATA_MARSHALLER_ERROR
+                }
+                else
+                {
+                    /*Codes_SRS_DATAMARSHALLER_02_007: [DataMarshaller_SendData shall copy in the output parameters *destination, *destinationSize the content and the content length of the encoded JSON tree.] */
+                    size_t resultSize = STRING_length(payload);
+                    unsigned char* temp = malloc(resultSize);
+                    if (temp == NULL)
+                    {
+                        /*Codes_SRS_DATA_MARSHALLER_99_015:[ DATA_MARSHALLER_ERROR shall be returned in all the other error cases not explicitly defined here.]*/
+                        result = DATA_MARSHALLER_ERROR;
+                        LOG_DATA_MARSHALLER_ERROR;
+                    }
+                    else
+                    {
+                        (void)memcpy(temp, STRING_c_str(payload), resultSize);
+                        *destination = temp;
+                        *destinationSize = resultSize;
+                        result = DATA_MARSHALLER_OK;
+                    }
+                }
+                STRING_delete(payload);
+            }
+        } /* if (j==valueCount)*/
+        MultiTree_Destroy(treeHandle);
+    } /* MultiTree_Create */
+
+    return result;
+}
+
 DATA_MARSHALLER_RESULT DataMarshaller_SendData(DATA_MARSHALLER_HANDLE dataMarshallerHandle, size_t valueCount, const DATA_MARSHALLER_VALUE* values, unsigned char** destination, size_t* destinationSize)
 {
     DATA_MARSHALLER_HANDLE_DATA* dataMarshallerInstance = (DATA_MARSHALLER_HANDLE_DATA*)dataMarshallerHandle;
     DATA_MARSHALLER_RESULT result;
-    MULTITREE_HANDLE treeHandle;
 
     /* Codes_SRS_DATA_MARSHALLER_99_034:[All argument checks shall be performed before calling any other modules.] */
     /* Codes_SRS_DATA_MARSHALLER_99_004:[ DATA_MARSHALLER_INVALID_ARG shall be returned when the function has detected an invalid parameter (NULL) being passed to the function.] */
@@ -120,96 +361,18 @@ DATA_MARSHALLER_RESULT DataMarshaller_SendData(DATA_MARSHALLER_HANDLE dataMarsha
 
         if (i == valueCount)
         {
-            /* Codes_SRS_DATA_MARSHALLER_99_037:[DataMarshaller shall store as MultiTree the data to be encoded by the JSONEncoder module.] */
-            if ((treeHandle = MultiTree_Create(NoCloneFunction, NoFreeFunction)) == NULL)
+            bool membersAreStructFields = MembersAreStructFields(includePropertyPath, valueCount, values);
+            size_t memberCount = membersAreStructFields ? values[0].Value->value.edmComplexType.nMembers : valueCount;
+
+            if (MembersAreFlat(membersAreStructFields, values, memberCount))
             {
-                /* Codes_SRS_DATA_MARSHALLER_99_035:[DATA_MARSHALLER_MULTITREE_ERROR shall be returned in case any MultiTree API call fails.] */
-                result = DATA_MARSHALLER_MULTITREE_ERROR;
-                LOG_DATA_MARSHALLER_ERROR
+                /*Codes_SRS_DATA_MARSHALLER_99_050: [ When all the members of the JSON object have names that are not paths, and either all or none of the property paths start with '/', DataMarshaller_SendData shall write the JSON object directly in the destination buffer, without a MultiTree. ]*/
+                result = EncodeFlatMembers(membersAreStructFields, values, memberCount, destination, destinationSize);
             }
             else
             {
-                size_t j;
-                result = DATA_MARSHALLER_OK; /* addressing warning in VS compiler */
-                /* Codes_SRS_DATA_MARSHALLER_99_038:[For each pair in the values argument, a string : value pair shall exist in the JSON object in the form of propertyName : value.] */
-                for (j = 0; j < valueCount; j++)
-                {
-                    if ((includePropertyPath == false) && (values[j].Value->type == EDM_COMPLEX_TYPE_TYPE))
-                    {
-                        size_t k;
-
-                        /* Codes_SRS_DATAMARSHALLER_01_001: [If the includePropertyPath argument passed to DataMarshaller_Create was false and only one struct is being sent, the relative path of the value passed to DataMarshaller_SendData - including property name - shall be ignored and the value shall be placed at JSON root.] */
-                        for (k = 0; k < values[j].Value->value.edmComplexType.nMembers; k++)
-                        {
-                            /* Codes_SRS_DATAMARSHALLER_01_004: [In this case the members of the struct shall be added as leafs into the MultiTree, each leaf having the name of the struct member.] */
-                            if (MultiTree_AddLeaf(treeHandle, values[j].Value->value.edmComplexType.fields[k].fieldName, (void*)values[j].Value->value.edmComplexType.fields[k].value) != MULTITREE_OK)
-                            {
-                                break;
-                            }
-                        }
-
-                        if (k < values[j].Value->value.edmComplexType.nMembers)
-                        {
-                            /* Codes_SRS_DATA_MARSHALLER_99_035:[DATA_MARSHALLER_MULTITREE_ERROR shall be returned in case any MultiTree API call fails.] */
-                            result = DATA_MARSHALLER_MULTITREE_ERROR;
-                            LOG_DATA_MARSHALLER_ERROR
-                            break;
-                        }
-                    }
-                    else
-                    {
-                        /* Codes_SRS_DATA_MARSHALLER_99_039:[ If the includePropertyPath argument passed to DataMarshaller_Create was true each property shall be placed in the appropriate position in the JSON according to its path in the model.] */
-                        if (MultiTree_AddLeaf(treeHandle, values[j].PropertyPath, (void*)values[j].Value) != MULTITREE_OK)
-                        {
-                            /* Codes_SRS_DATA_MARSHALLER_99_035:[DATA_MARSHALLER_MULTITREE_ERROR shall be returned in case any MultiTree API call fails.] */
-                            result = DATA_MARSHALLER_MULTITREE_ERROR;
-                            LOG_DATA_MARSHALLER_ERROR
-                            break;
-                        }
-                    }
-
-                }
-
-                if (j == valueCount)
-                {
-                    STRING_HANDLE payload = STRING_new();
-                    if (payload == NULL)
-                    {
-                        result = DATA_MARSHALLER_ERROR;
-                        LOG_DATA_MARSHALLER_ERROR
-                    }
-                    else
-                    {
-                        if (JSONEncoder_EncodeTree(treeHandle, payload, (JSON_ENCODER_TOSTRING_FUNC)AgentDataTypes_ToString) != JSON_ENCODER_OK)
-                        {
-                            /* Codes_SRS_DATA_MARSHALLER_99_027:[ DATA_MARSHALLER_JSON_ENCODER_ERROR shall be returned when JSONEncoder returns an error code.] */
-                            result = DATA_MARSHALLER_JSON_ENCODER_ERROR;
-                            LOG_DATA_MARSHALLER_ERROR
-                        }
-                        else
-                        {
-                            /*Codes_SRS_DATAMARSHALLER_02_007: [DataMarshaller_SendData shall copy in the output parameters *destination, *destinationSize the content and the content length of the encoded JSON tree.] */
-                            size_t resultSize = STRING_length(payload);
-                            unsigned char* temp = malloc(resultSize);
-                            if (temp == NULL)
-                            {
-                                /*Codes_SRS_DATA_MARSHALLER_99_015:[ DATA_MARSHALLER_ERROR shall be returned in all the other error cases not explicitly defined here.]*/
-                                result = DATA_MARSHALLER_ERROR;
-                                LOG_DATA_MARSHALLER_ERROR;
-                            }
-                            else
-                            {
-                                (void)memcpy(temp, STRING_c_str(payload), resultSize);
-                                *destination = temp;
-                                *destinationSize = resultSize;
-                                result = DATA_MARSHALLER_OK;
-                            }
-                        }
-                        STRING_delete(payload);
-                    }
-                } /* if (j==valueCount)*/
-                MultiTree_Destroy(treeHandle);
-            } /* MultiTree_Create */
+                result = EncodeTree(includePropertyPath, valueCount, values, destination, destinationSize);
+            }
         }
     }
 
@@ -3,6 +3,7 @@
 
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/xlogging.h"
 
 #include "jsondecoder.h"
 #include <stdio.h>
@@ -40,46 +41,54 @@ void SkipWhiteSpaces(PARSER_STATE* parserState)
     }
 }
 
-static JSON_DECODER_RESULT ParseString(PARSER_STATE* parserState, char** stringBegin)
+static const char* SkipWhiteSpacesFrom(const char* json)
+{
+    while ((*json != '\0') && IsWhiteSpace(*json))
+    {
+        json++;
+    }
+    return json;
+}
+
+static JSON_DECODER_RESULT ScanString(const char** json)
 {
     JSON_DECODER_RESULT result = JSON_DECODER_OK;
-    *stringBegin = parserState->json;
 
     /* Codes_SRS_JSON_DECODER_99_028:[ A string begins and ends with quotation marks.] */
-    if (*(parserState->json) != '"')
+    if (**json != '"')
     {
         /* Codes_SRS_JSON_DECODER_99_007:[ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_MultiTree shall return JSON_DECODER_PARSE_ERROR.] */
         result = JSON_DECODER_PARSE_ERROR;
     }
     else
     {
-        parserState->json++;
-        while ((*(parserState->json) != '"') && (*(parserState->json) != '\0'))
+        (*json)++;
+        while ((**json != '"') && (**json != '\0'))
         {
             /* Codes_SRS_JSON_DECODER_99_030:[ Any character may be escaped.]  */
             /* Codes_SRS_JSON_DECODER_99_033:[ Alternatively, there are two-character sequence escape  representations of some popular characters.  So, for example, a string containing only a single reverse solidus character may be represented more compactly as "\\".] */
-            if (*(parserState->json) == '\\')
+            if (**json == '\\')
             {
-                parserState->json++;
+                (*json)++;
                 if (
                     /* Codes_SRS_JSON_DECODER_99_051:[ %x5C /          ; \    reverse solidus U+005C] */
-                    (*parserState->json == '\\') ||
+                    (**json == '\\') ||
                     /* Codes_SRS_JSON_DECODER_99_050:[ %x22 /          ; "    quotation mark  U+0022] */
-                    (*parserState->json == '"') ||
+                    (**json == '"') ||
                     /* Codes_SRS_JSON_DECODER_99_052:[ %x2F /          ; /    solidus         U+002F] */
-                    (*parserState->json == '/') ||
+                    (**json == '/') ||
                     /* Codes_SRS_JSON_DECODER_99_053:[ %x62 /          ; b    backspace       U+0008] */
-                    (*parserState->json == 'b') ||
+                    (**json == 'b') ||
                     /* Codes_SRS_JSON_DECODER_99_054:[ %x66 /          ; f    form feed       U+000C] */
-                    (*parserState->json == 'f') ||
+                    (**json == 'f') ||
                     /* Codes_SRS_JSON_DECODER_99_055:[ %x6E /          ; n    line feed       U+000A] */
-                    (*parserState->json == 'n') ||
+                    (**json == 'n') ||
                     /* Codes_SRS_JSON_DECODER_99_056:[ %x72 /          ; r    carriage return U+000D] */
-                    (*parserState->json == 'r') ||
+                    (**json == 'r') ||
                     /* Codes_SRS_JSON_DECODER_99_057:[ %x74 /          ; t    tab             U+0009] */
-                    (*parserState->json == 't'))
+                    (**json == 't'))
                 {
-                    parserState->json++;
+                    (*json)++;
                 }
                 else
                 {
@@ -90,20 +99,20 @@ static JSON_DECODER_RESULT ParseString(PARSER_STATE* parserState, char** stringB
             }
             else
             {
-                parserState->json++;
+                (*json)++;
             }
         }
 
         if (result == JSON_DECODER_OK)
         {
-            if (*(parserState->json) != '"')
+            if (**json != '"')
             {
                 /* Codes_SRS_JSON_DECODER_99_007:[ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_MultiTree shall return JSON_DECODER_PARSE_ERROR.] */
                 result = JSON_DECODER_PARSE_ERROR;
             }
             else
             {
-                parserState->json++;
+                (*json)++;
                 result = JSON_DECODER_OK;
             }
         }
@@ -112,21 +121,32 @@ static JSON_DECODER_RESULT ParseString(PARSER_STATE* parserState, char** stringB
     return result;
 }
 
-static JSON_DECODER_RESULT ParseNumber(PARSER_STATE* parserState)
+static JSON_DECODER_RESULT ParseString(PARSER_STATE* parserState, char** stringBegin)
+{
+    const char* stringEnd = parserState->json;
+    JSON_DECODER_RESULT result = ScanString(&stringEnd);
+
+    *stringBegin = parserState->json;
+    parserState->json += stringEnd - parserState->json;
+
+    return result;
+}
+
+static JSON_DECODER_RESULT ScanNumber(const char** json)
 {
     JSON_DECODER_RESULT result = JSON_DECODER_OK;
     size_t digitCount = 0;
 
-    if (*(parserState->json) == '-')
+    if (**json == '-')
     {
-        parserState->json++;
+        (*json)++;
     }
 
     /* Codes_SRS_JSON_DECODER_99_043:[ A number contains an integer component that may be prefixed with an optional minus sign, which may be followed by a fraction part and/or an exponent part.] */
-    while (*(parserState->json) != '\0')
+    while (**json != '\0')
     {
         /* Codes_SRS_JSON_DECODER_99_044:[ Octal and hex forms are not allowed.] */
-        if (ISDIGIT(*(parserState->json)))
+        if (ISDIGIT(**json))
         {
             digitCount++;
             /* simply continue */
@@ -136,12 +156,12 @@ static JSON_DECODER_RESULT ParseNumber(PARSER_STATE* parserState)
             break;
         }
 
-        parserState->json++;
+        (*json)++;
     }
 
     if ((digitCount == 0) ||
         /* Codes_SRS_JSON_DECODER_99_045:[ Leading zeros are not allowed.] */
-        ((digitCount > 1) && *(parserState->json - digitCount) == '0'))
+        ((digitCount > 1) && *(*json - digitCount) == '0'))
     {
         /* Codes_SRS_JSON_DECODER_99_007:[ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_MultiTree shall return JSON_DECODER_PARSE_ERROR.] */
         result = JSON_DECODER_PARSE_ERROR;
@@ -149,16 +169,16 @@ static JSON_DECODER_RESULT ParseNumber(PARSER_STATE* parserState)
     else
     {
         /* Codes_SRS_JSON_DECODER_99_046:[ A fraction part is a decimal point followed by one or more digits.] */
-        if (*(parserState->json) == '.')
+        if (**json == '.')
         {
             /* optional fractional part */
-            parserState->json++;
+            (*json)++;
             digitCount = 0;
 
-            while (*(parserState->json) != '\0')
+            while (**json != '\0')
             {
                 /* Codes_SRS_JSON_DECODER_99_044:[ Octal and hex forms are not allowed.] */
-                if (ISDIGIT(*(parserState->json)))
+                if (ISDIGIT(**json))
                 {
                     digitCount++;
                     /* simply continue */
@@ -168,7 +188,7 @@ static JSON_DECODER_RESULT ParseNumber(PARSER_STATE* parserState)
                     break;
                 }
 
-                parserState->json++;
+                (*json)++;
             }
 
             if (digitCount == 0)
@@ -179,23 +199,23 @@ static JSON_DECODER_RESULT ParseNumber(PARSER_STATE* parserState)
         }
 
         /* Codes_SRS_JSON_DECODER_99_047:[ An exponent part begins with the letter E in upper or lowercase, which may be followed by a plus or minus sign.] */
-        if ((*(parserState->json) == 'e') || (*(parserState->json) == 'E'))
+        if ((**json == 'e') || (**json == 'E'))
         {
-            parserState->json++;
+            (*json)++;
 
             /* optional sign */
-            if ((*(parserState->json) == '-') || (*(parserState->json) == '+'))
+            if ((**json == '-') || (**json == '+'))
             {
-                parserState->json++;
+                (*json)++;
             }
 
             digitCount = 0;
 
             /* Codes_SRS_JSON_DECODER_99_048:[ The E and optional sign are followed by one or more digits.] */
-            while (*(parserState->json) != '\0')
+            while (**json != '\0')
             {
                 /* Codes_SRS_JSON_DECODER_99_044:[ Octal and hex forms are not allowed.] */
-                if (ISDIGIT(*(parserState->json)))
+                if (ISDIGIT(**json))
                 {
                     digitCount++;
                     /* simply continue */
@@ -205,7 +225,7 @@ static JSON_DECODER_RESULT ParseNumber(PARSER_STATE* parserState)
                     break;
                 }
 
-                parserState->json++;
+                (*json)++;
             }
 
             if (digitCount == 0)
@@ -219,6 +239,16 @@ static JSON_DECODER_RESULT ParseNumber(PARSER_STATE* parserState)
     return result;
 }
 
+static JSON_DECODER_RESULT ParseNumber(PARSER_STATE* parserState)
+{
+    const char* numberEnd = parserState->json;
+    JSON_DECODER_RESULT result = ScanNumber(&numberEnd);
+
+    parserState->json += numberEnd - parserState->json;
+
+    return result;
+}
+
 static JSON_DECODER_RESULT ParseValue(PARSER_STATE* parserState, MULTITREE_HANDLE currentNode, char** stringBegin)
 {
     JSON_DECODER_RESULT result;
@@ -612,3 +642,407 @@ JSON_DECODER_RESULT JSONDecoder_JSON_To_MultiTree(char* json, MULTITREE_HANDLE*
 
     return result;
 }
+
+typedef enum READER_STATE_TAG
+{
+    READER_EXPECT_ROOT,
+    READER_EXPECT_VALUE,
+    READER_EXPECT_VALUE_OR_END_ARRAY,
+    READER_EXPECT_NAME,
+    READER_EXPECT_NAME_OR_END_OBJECT,
+    READER_EXPECT_SEPARATOR_OR_END,
+    READER_EXPECT_END_OF_DOCUMENT,
+    READER_FAILED
+} READER_STATE;
+
+static void ReaderEndValue(JSON_DECODER_READER* reader)
+{
+    reader->state = (reader->depth == 0) ? READER_EXPECT_END_OF_DOCUMENT : READER_EXPECT_SEPARATOR_OR_END;
+}
+
+static void ReaderSetToken(JSON_DECODER_READER* reader, JSON_DECODER_TOKEN* token, JSON_DECODER_TOKEN_TYPE type, const char* end)
+{
+    token->type = type;
+    token->text = reader->position;
+    token->length = end - reader->position;
+    reader->position = end;
+}
+
+static JSON_DECODER_RESULT ReaderBeginContainer(JSON_DECODER_READER* reader, JSON_DECODER_TOKEN* token)
+{
+    JSON_DECODER_RESULT result;
+
+    if (reader->depth == JSON_DECODER_READER_MAX_NESTING)
+    {
+        /* Codes_SRS_JSON_DECODER_99_068: [ If the JSON nests objects and arrays deeper than JSON_DECODER_READER_MAX_NESTING levels then JSONDecoder_Reader_Next shall fail and return JSON_DECODER_ERROR. ]*/
+        LogError("JSON nests more than %d objects and arrays", JSON_DECODER_READER_MAX_NESTING);
+        result = JSON_DECODER_ERROR;
+    }
+    else
+    {
+        char container = *(reader->position);
+        reader->containers[reader->depth++] = container;
+        reader->state = (container == '{') ? READER_EXPECT_NAME_OR_END_OBJECT : READER_EXPECT_VALUE_OR_END_ARRAY;
+        ReaderSetToken(reader, token, (container == '{') ? JSON_DECODER_TOKEN_BEGIN_OBJECT : JSON_DECODER_TOKEN_BEGIN_ARRAY, reader->position + 1);
+        result = JSON_DECODER_OK;
+    }
+
+    return result;
+}
+
+static void ReaderEndContainer(JSON_DECODER_READER* reader, JSON_DECODER_TOKEN* token)
+{
+    reader->depth--;
+    ReaderSetToken(reader, token, (reader->containers[reader->depth] == '{') ? JSON_DECODER_TOKEN_END_OBJECT : JSON_DECODER_TOKEN_END_ARRAY, reader->position + 1);
+    ReaderEndValue(reader);
+}
+
+static JSON_DECODER_RESULT ReaderReadName(JSON_DECODER_READER* reader, JSON_DECODER_TOKEN* token)
+{
+    JSON_DECODER_RESULT result;
+    const char* nameEnd = reader->position;
+
+    /* Codes_SRS_JSON_DECODER_99_022:[ A name is a string.] */
+    if ((result = ScanString(&nameEnd)) == JSON_DECODER_OK)
+    {
+        const char* colon = SkipWhiteSpacesFrom(nameEnd);
+
+        /* Codes_SRS_JSON_DECODER_99_023:[  A single colon comes after each name, separating the name from the value.] */
+        if (*colon != ':')
+        {
+            result = JSON_DECODER_PARSE_ERROR;
+        }
+        else
+        {
+            /* Codes_SRS_JSON_DECODER_99_061: [ For a JSON_DECODER_TOKEN_NAME token the text shall not include the quotation marks. ]*/
+            token->type = JSON_DECODER_TOKEN_NAME;
+            token->text = reader->position + 1;
+            token->length = nameEnd - reader->position - 2;
+            reader->position = colon + 1;
+            reader->state = READER_EXPECT_VALUE;
+        }
+    }
+
+    return result;
+}
+
+static JSON_DECODER_RESULT ReaderReadScalar(JSON_DECODER_READER* reader, JSON_DECODER_TOKEN* token)
+{
+    JSON_DECODER_RESULT result;
+    const char* valueEnd = reader->position;
+    JSON_DECODER_TOKEN_TYPE type;
+
+    if (*valueEnd == '"')
+    {
+        type = JSON_DECODER_TOKEN_STRING;
+        result = ScanString(&valueEnd);
+    }
+    /* Codes_SRS_JSON_DECODER_99_019:[ The literal names MUST be lowercase.] */
+    /* Codes_SRS_JSON_DECODER_99_020:[ No other literal names are allowed.] */
+    else if (strncmp(valueEnd, "false", 5) == 0)
+    {
+        type = JSON_DECODER_TOKEN_LITERAL;
+        valueEnd += 5;
+        result = JSON_DECODER_OK;
+    }
+    else if ((strncmp(valueEnd, "true", 4) == 0) || (strncmp(valueEnd, "null", 4) == 0))
+    {
+        type = JSON_DECODER_TOKEN_LITERAL;
+        valueEnd += 4;
+        result = JSON_DECODER_OK;
+    }
+    else if (ISDIGIT(*valueEnd) || (*valueEnd == '-'))
+    {
+        type = JSON_DECODER_TOKEN_NUMBER;
+        result = ScanNumber(&valueEnd);
+    }
+    else
+    {
+        type = JSON_DECODER_TOKEN_END_OF_DOCUMENT;
+        result = JSON_DECODER_PARSE_ERROR;
+    }
+
+    if (result == JSON_DECODER_OK)
+    {
+        /* Codes_SRS_JSON_DECODER_99_062: [ For a JSON_DECODER_TOKEN_STRING token the text shall include the quotation marks and the escape sequences as they appear in the JSON. ]*/
+        ReaderSetToken(reader, token, type, valueEnd);
+        ReaderEndValue(reader);
+    }
+
+    return result;
+}
+
+static JSON_DECODER_RESULT ReaderReadValue(JSON_DECODER_READER* reader, JSON_DECODER_TOKEN* token)
+{
+    JSON_DECODER_RESULT result;
+
+    /* Codes_SRS_JSON_DECODER_99_018:[ A JSON value MUST be an object, array, number, or string, or one of the following three literal names: false null true] */
+    if ((*(reader->position) == '{') || (*(reader->position) == '['))
+    {
+        result = ReaderBeginContainer(reader, token);
+    }
+    else
+    {
+        result = ReaderReadScalar(reader, token);
+    }
+
+    return result;
+}
+
+static JSON_DECODER_RESULT ReaderReadToken(JSON_DECODER_READER* reader, JSON_DECODER_TOKEN* token)
+{
+    JSON_DECODER_RESULT result;
+
+    /* Codes_SRS_JSON_DECODER_99_016:[ Insignificant whitespace is allowed before or after any of the six structural characters.] */
+    reader->position = SkipWhiteSpacesFrom(reader->position);
+
+    switch (reader->state)
+    {
+        case READER_EXPECT_ROOT:
+        {
+            /* Codes_SRS_JSON_DECODER_99_012:[ A JSON text is a serialized object or array.] */
+            if ((*(reader->position) == '{') || (*(reader->position) == '['))
+            {
+                result = ReaderBeginContainer(reader, token);
+            }
+            else
+            {
+                result = JSON_DECODER_PARSE_ERROR;
+            }
+            break;
+        }
+        case READER_EXPECT_VALUE:
+        {
+            result = ReaderReadValue(reader, token);
+            break;
+        }
+        case READER_EXPECT_VALUE_OR_END_ARRAY:
+        {
+            /* Codes_SRS_JSON_DECODER_99_026:[ An array structure is represented as square brackets surrounding zero or more values (or elements).] */
+            if (*(reader->position) == ']')
+            {
+                ReaderEndContainer(reader, token);
+                result = JSON_DECODER_OK;
+            }
+            else
+            {
+                result = ReaderReadValue(reader, token);
+            }
+            break;
+        }
+        case READER_EXPECT_NAME:
+        {
+            result = ReaderReadName(reader, token);
+            break;
+        }
+        case READER_EXPECT_NAME_OR_END_OBJECT:
+        {
+            /* Codes_SRS_JSON_DECODER_99_021:[    An object structure is represented as a pair of curly brackets surrounding zero or more name/value pairs (or members).] */
+            if (*(reader->position) == '}')
+            {
+                ReaderEndContainer(reader, token);
+                result = JSON_DECODER_OK;
+            }
+            else
+            {
+                result = ReaderReadName(reader, token);
+            }
+            break;
+        }
+        case READER_EXPECT_SEPARATOR_OR_END:
+        {
+            char container = reader->containers[reader->depth - 1];
+
+            /* Codes_SRS_JSON_DECODER_99_024:[ A single comma separates a value from a following name.] */
+            /* Codes_SRS_JSON_DECODER_99_027:[ Elements are separated by commas.] */
+            if (*(reader->position) == ',')
+            {
+                reader->position = SkipWhiteSpacesFrom(reader->position + 1);
+                result = (container == '{') ? ReaderReadName(reader, token) : ReaderReadValue(reader, token);
+            }
+            else if (*(reader->position) == ((container == '{') ? '}' : ']'))
+            {
+                ReaderEndContainer(reader, token);
+                result = JSON_DECODER_OK;
+            }
+            else
+            {
+                result = JSON_DECODER_PARSE_ERROR;
+            }
+            break;
+        }
+        case READER_EXPECT_END_OF_DOCUMENT:
+        {
+            if (*(reader->position) == '\0')
+            {
+                /* Codes_SRS_JSON_DECODER_99_063: [ After the root object or array has ended JSONDecoder_Reader_Next shall produce JSON_DECODER_TOKEN_END_OF_DOCUMENT. ]*/
+                ReaderSetToken(reader, token, JSON_DECODER_TOKEN_END_OF_DOCUMENT, reader->position);
+                result = JSON_DECODER_OK;
+            }
+            else
+            {
+                result = JSON_DECODER_PARSE_ERROR;
+            }
+            break;
+        }
+        default:
+        {
+            result = JSON_DECODER_PARSE_ERROR;
+            break;
+        }
+    }
+
+    if (result != JSON_DECODER_OK)
+    {
+        /* Codes_SRS_JSON_DECODER_99_064: [ If the JSON is malformed then JSONDecoder_Reader_Next shall fail and return JSON_DECODER_PARSE_ERROR, and so shall every following call. ]*/
+        reader->state = READER_FAILED;
+    }
+
+    return result;
+}
+
+JSON_DECODER_RESULT JSONDecoder_Reader_Init(JSON_DECODER_READER* reader, const char* json)
+{
+    JSON_DECODER_RESULT result;
+
+    if ((reader == NULL) ||
+        (json == NULL))
+    {
+        /* Codes_SRS_JSON_DECODER_99_059: [ If reader or json is NULL then JSONDecoder_Reader_Init shall fail and return JSON_DECODER_INVALID_ARG. ]*/
+        LogError("invalid argument JSON_DECODER_READER* reader=%p, const char* json=%p", reader, json);
+        result = JSON_DECODER_INVALID_ARG;
+    }
+    else
+    {
+        JSON_DECODER_READER scanner;
+        JSON_DECODER_TOKEN token;
+
+        reader->position = json;
+        reader->state = READER_EXPECT_ROOT;
+        reader->depth = 0;
+
+        /* Codes_SRS_JSON_DECODER_99_060: [ JSONDecoder_Reader_Init shall read the complete json, without allocating, and fail with the error JSONDecoder_Reader_Next would return if json is malformed, so that no caller acts on a document that turns out to be malformed. ]*/
+        scanner = *reader;
+        do
+        {
+            result = ReaderReadToken(&scanner, &token);
+        } while ((result == JSON_DECODER_OK) && (token.type != JSON_DECODER_TOKEN_END_OF_DOCUMENT));
+
+        if (result != JSON_DECODER_OK)
+        {
+            LogError("malformed JSON");
+            reader->state = READER_FAILED;
+        }
+    }
+
+    return result;
+}
+
+JSON_DECODER_RESULT JSONDecoder_Reader_Next(JSON_DECODER_READER* reader, JSON_DECODER_TOKEN* token)
+{
+    JSON_DECODER_RESULT result;
+
+    if ((reader == NULL) ||
+        (token == NULL))
+    {
+        /* Codes_SRS_JSON_DECODER_99_065: [ If reader or token is NULL then JSONDecoder_Reader_Next shall fail and return JSON_DECODER_INVALID_ARG. ]*/
+        LogError("invalid argument JSON_DECODER_READER* reader=%p, JSON_DECODER_TOKEN* token=%p", reader, token);
+        result = JSON_DECODER_INVALID_ARG;
+    }
+    else
+    {
+        /* Codes_SRS_JSON_DECODER_99_066: [ JSONDecoder_Reader_Next shall produce the next token of the JSON in token and advance the reader past it. ]*/
+        /* Codes_SRS_JSON_DECODER_99_067: [ Curly brackets and square brackets shall produce the BEGIN_ and END_ OBJECT and ARRAY tokens, member names JSON_DECODER_TOKEN_NAME, strings JSON_DECODER_TOKEN_STRING, numbers JSON_DECODER_TOKEN_NUMBER and true, false and null JSON_DECODER_TOKEN_LITERAL. ]*/
+        result = ReaderReadToken(reader, token);
+    }
+
+    return result;
+}
+
+JSON_DECODER_RESULT JSONDecoder_Reader_SkipValue(JSON_DECODER_READER* reader)
+{
+    JSON_DECODER_RESULT result;
+
+    if (reader == NULL)
+    {
+        /* Codes_SRS_JSON_DECODER_99_069: [ If reader is NULL then JSONDecoder_Reader_SkipValue shall fail and return JSON_DECODER_INVALID_ARG. ]*/
+        LogError("invalid argument JSON_DECODER_READER* reader=%p", reader);
+        result = JSON_DECODER_INVALID_ARG;
+    }
+    else if (
+        ((reader->state != READER_EXPECT_VALUE) && (reader->state != READER_EXPECT_VALUE_OR_END_ARRAY)) ||
+        (*SkipWhiteSpacesFrom(reader->position) == ']')
+        )
+    {
+        /* Codes_SRS_JSON_DECODER_99_070: [ If the next token is not the start of a value then JSONDecoder_Reader_SkipValue shall fail and return JSON_DECODER_ERROR without advancing the reader. ]*/
+        LogError("there is no value to skip at the position of the reader");
+        result = JSON_DECODER_ERROR;
+    }
+    else
+    {
+        /* Codes_SRS_JSON_DECODER_99_071: [ JSONDecoder_Reader_SkipValue shall advance the reader past the next value, including all the members or elements of an object or array. ]*/
+        size_t depth = reader->depth;
+        JSON_DECODER_TOKEN token;
+        do
+        {
+            result = ReaderReadToken(reader, &token);
+        } while ((result == JSON_DECODER_OK) && (reader->depth > depth));
+    }
+
+    return result;
+}
+
+JSON_DECODER_RESULT JSONDecoder_Reader_GetMember(const JSON_DECODER_READER* objectReader, const char* name, JSON_DECODER_READER* memberReader)
+{
+    JSON_DECODER_RESULT result;
+
+    if ((objectReader == NULL) ||
+        (name == NULL) ||
+        (memberReader == NULL))
+    {
+        /* Codes_SRS_JSON_DECODER_99_072: [ If objectReader, name or memberReader is NULL then JSONDecoder_Reader_GetMember shall fail and return JSON_DECODER_INVALID_ARG. ]*/
+        LogError("invalid argument const JSON_DECODER_READER* objectReader=%p, const char* name=%p, JSON_DECODER_READER* memberReader=%p", objectReader, name, memberReader);
+        result = JSON_DECODER_INVALID_ARG;
+    }
+    else
+    {
+        /* Codes_SRS_JSON_DECODER_99_073: [ JSONDecoder_Reader_GetMember shall scan the remaining members of the object objectReader is in, skipping their values, without advancing objectReader. ]*/
+        JSON_DECODER_READER scanner = *objectReader;
+        JSON_DECODER_TOKEN token;
+        size_t nameLength = strlen(name);
+
+        result = JSON_DECODER_MEMBER_NOT_FOUND;
+        while (ReaderReadToken(&scanner, &token) == JSON_DECODER_OK)
+        {
+            if (token.type != JSON_DECODER_TOKEN_NAME)
+            {
+                /* Codes_SRS_JSON_DECODER_99_075: [ If the member is not found before the end of the object then JSONDecoder_Reader_GetMember shall return JSON_DECODER_MEMBER_NOT_FOUND. ]*/
+                if (token.type != JSON_DECODER_TOKEN_END_OBJECT)
+                {
+                    /* Codes_SRS_JSON_DECODER_99_076: [ If objectReader is not positioned before a member or the end of an object then JSONDecoder_Reader_GetMember shall fail and return JSON_DECODER_ERROR. ]*/
+                    LogError("the reader is not positioned inside an object");
+                    result = JSON_DECODER_ERROR;
+                }
+                break;
+            }
+            else if ((token.length == nameLength) && (memcmp(token.text, name, nameLength) == 0))
+            {
+                /* Codes_SRS_JSON_DECODER_99_074: [ When a member called name is found then JSONDecoder_Reader_GetMember shall position memberReader before its value and return JSON_DECODER_OK. ]*/
+                *memberReader = scanner;
+                result = JSON_DECODER_OK;
+                break;
+            }
+            else if (JSONDecoder_Reader_SkipValue(&scanner) != JSON_DECODER_OK)
+            {
+                break;
+            }
+        }
+
+        if (scanner.state == READER_FAILED)
+        {
+            result = JSON_DECODER_PARSE_ERROR;
+        }
+    }
+
+    return result;
+}
@@ -12,6 +12,34 @@
 
 MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(SCHEMA_RESULT, SCHEMA_RESULT_VALUES);
 
+/*the kinds of names held by a NAME_INDEX. A schema indexes its models and struct types, a model indexes its own elements*/
+typedef enum NAME_INDEX_KIND_TAG
+{
+    NAME_INDEX_MODEL,
+    NAME_INDEX_STRUCT_TYPE,
+    NAME_INDEX_PROPERTY,
+    NAME_INDEX_REPORTED_PROPERTY,
+    NAME_INDEX_DESIRED_PROPERTY,
+    NAME_INDEX_ACTION,
+    NAME_INDEX_METHOD,
+    NAME_INDEX_MODEL_IN_MODEL
+} NAME_INDEX_KIND;
+
+typedef struct NAME_INDEX_ENTRY_TAG
+{
+    const char* name; /*not owned, this is the name stored in the element. NULL marks an empty slot*/
+    size_t hash;
+    NAME_INDEX_KIND kind;
+    void* element;
+} NAME_INDEX_ENTRY;
+
+/*open addressing hash table of names. It is built by Schema_BuildNameIndexes once the schema is complete and dropped when a name is added*/
+typedef struct NAME_INDEX_TAG
+{
+    NAME_INDEX_ENTRY* entries; /*NULL when the index is not built*/
+    size_t mask; /*the number of entries is a power of 2, mask is that number - 1*/
+} NAME_INDEX;
+
 typedef struct SCHEMA_PROPERTY_HANDLE_DATA_TAG
 {
     const char* PropertyName;
@@ -81,6 +109,7 @@ typedef struct SCHEMA_MODEL_TYPE_HANDLE_DATA_TAG
     size_t ActionCount;
     VECTOR_HANDLE models;
     size_t DeviceCount;
+    NAME_INDEX NameIndex; /*properties, reported properties, desired properties, actions, methods and models in model*/
 } SCHEMA_MODEL_TYPE_HANDLE_DATA;
 
 typedef struct SCHEMA_STRUCT_TYPE_HANDLE_DATA_TAG
@@ -98,10 +127,350 @@ typedef struct SCHEMA_HANDLE_DATA_TAG
     size_t ModelTypeCount;
     SCHEMA_STRUCT_TYPE_HANDLE* StructTypes;
     size_t StructTypeCount;
+    NAME_INDEX NameIndex; /*models and struct types*/
 } SCHEMA_HANDLE_DATA;
 
 static VECTOR_HANDLE g_schemas = NULL;
 
+/*hashes the first length characters of name, so that a segment of a path can be looked up without copying it*/
+static size_t HashName(const char* name, size_t length)
+{
+    /*FNV-1a*/
+    size_t result = 2166136261u;
+    size_t i;
+    for (i = 0; i < length; i++)
+    {
+        result = (result ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return result;
+}
+
+static void ClearNameIndex(NAME_INDEX* nameIndex)
+{
+    if (nameIndex->entries != NULL)
+    {
+        free(nameIndex->entries);
+        nameIndex->entries = NULL;
+        nameIndex->mask = 0;
+    }
+}
+
+/*allocates an index that stays at most half full when holding nameCount names, so probing always ends on an empty slot*/
+static int CreateNameIndex(NAME_INDEX* nameIndex, size_t nameCount)
+{
+    int result;
+    size_t entryCount = 8;
+
+    while (entryCount < nameCount * 2)
+    {
+        entryCount *= 2;
+    }
+
+    if ((nameIndex->entries = (NAME_INDEX_ENTRY*)calloc(entryCount, sizeof(NAME_INDEX_ENTRY))) == NULL)
+    {
+        LogError("failure in calloc");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        nameIndex->mask = entryCount - 1;
+        result = 0;
+    }
+
+    return result;
+}
+
+static void AddToNameIndex(NAME_INDEX* nameIndex, NAME_INDEX_KIND kind, const char* name, void* element)
+{
+    size_t hash = HashName(name, strlen(name));
+    size_t i = hash & nameIndex->mask;
+
+    /*names added earlier come first in the probe sequence, so a lookup finds the first element added with a name, as the linear searches do*/
+    while (nameIndex->entries[i].name != NULL)
+    {
+        i = (i + 1) & nameIndex->mask;
+    }
+
+    nameIndex->entries[i].name = name;
+    nameIndex->entries[i].hash = hash;
+    nameIndex->entries[i].kind = kind;
+    nameIndex->entries[i].element = element;
+}
+
+/*name does not need to be '\0' terminated, only its first length characters are compared*/
+static void* FindInNameIndex(const NAME_INDEX* nameIndex, NAME_INDEX_KIND kind, const char* name, size_t length, size_t hash)
+{
+    void* result = NULL;
+    size_t i = hash & nameIndex->mask;
+
+    while (nameIndex->entries[i].name != NULL)
+    {
+        const NAME_INDEX_ENTRY* entry = &nameIndex->entries[i];
+        if ((entry->hash == hash) &&
+            (entry->kind == kind) &&
+            (strncmp(entry->name, name, length) == 0) &&
+            (entry->name[length] == '\0'))
+        {
+            result = entry->element;
+            break;
+        }
+        i = (i + 1) & nameIndex->mask;
+    }
+
+    return result;
+}
+
+static bool NameMatches(const char* elementName, const char* name, size_t length)
+{
+    return (strncmp(elementName, name, length) == 0) && (elementName[length] == '\0');
+}
+
+/*the index is filled before it is stored in the schema, so a lookup never sees a partially filled index*/
+static int BuildSchemaNameIndex(SCHEMA_HANDLE_DATA* schema)
+{
+    int result;
+    NAME_INDEX nameIndex;
+
+    if (schema->NameIndex.entries != NULL)
+    {
+        result = 0;
+    }
+    else if (CreateNameIndex(&nameIndex, schema->ModelTypeCount + schema->StructTypeCount) != 0)
+    {
+        LogError("unable to build the name index of schema %s", schema->Namespace);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t i;
+
+        for (i = 0; i < schema->ModelTypeCount; i++)
+        {
+            AddToNameIndex(&nameIndex, NAME_INDEX_MODEL, schema->ModelTypes[i]->Name, schema->ModelTypes[i]);
+        }
+
+        for (i = 0; i < schema->StructTypeCount; i++)
+        {
+            AddToNameIndex(&nameIndex, NAME_INDEX_STRUCT_TYPE, schema->StructTypes[i]->Name, schema->StructTypes[i]);
+        }
+
+        schema->NameIndex = nameIndex;
+        result = 0;
+    }
+
+    return result;
+}
+
+/*the index is filled before it is stored in the model, so a lookup never sees a partially filled index*/
+static int BuildModelNameIndex(SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType)
+{
+    int result;
+
+    if (modelType->NameIndex.entries != NULL)
+    {
+        result = 0;
+    }
+    else
+    {
+        NAME_INDEX nameIndex;
+        size_t methodCount = VECTOR_size(modelType->methods);
+        size_t desiredPropertyCount = VECTOR_size(modelType->desiredProperties);
+        size_t reportedPropertyCount = VECTOR_size(modelType->reportedProperties);
+        size_t modelCount = VECTOR_size(modelType->models);
+
+        if (CreateNameIndex(&nameIndex, modelType->PropertyCount + modelType->ActionCount + methodCount + desiredPropertyCount + reportedPropertyCount + modelCount) != 0)
+        {
+            LogError("unable to build the name index of model %s", modelType->Name);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            size_t i;
+
+            for (i = 0; i < modelType->PropertyCount; i++)
+            {
+                AddToNameIndex(&nameIndex, NAME_INDEX_PROPERTY, modelType->Properties[i]->PropertyName, modelType->Properties[i]);
+            }
+
+            for (i = 0; i < modelType->ActionCount; i++)
+            {
+                AddToNameIndex(&nameIndex, NAME_INDEX_ACTION, modelType->Actions[i]->ActionName, modelType->Actions[i]);
+            }
+
+            for (i = 0; i < methodCount; i++)
+            {
+                SCHEMA_METHOD_HANDLE method = *(SCHEMA_METHOD_HANDLE*)VECTOR_element(modelType->methods, i);
+                AddToNameIndex(&nameIndex, NAME_INDEX_METHOD, method->methodName, method);
+            }
+
+            for (i = 0; i < desiredPropertyCount; i++)
+            {
+                SCHEMA_DESIRED_PROPERTY_HANDLE desiredProperty = *(SCHEMA_DESIRED_PROPERTY_HANDLE*)VECTOR_element(modelType->desiredProperties, i);
+                AddToNameIndex(&nameIndex, NAME_INDEX_DESIRED_PROPERTY, desiredProperty->desiredPropertyName, desiredProperty);
+            }
+
+            for (i = 0; i < reportedPropertyCount; i++)
+            {
+                SCHEMA_REPORTED_PROPERTY_HANDLE reportedProperty = *(SCHEMA_REPORTED_PROPERTY_HANDLE*)VECTOR_element(modelType->reportedProperties, i);
+                AddToNameIndex(&nameIndex, NAME_INDEX_REPORTED_PROPERTY, reportedProperty->reportedPropertyName, reportedProperty);
+            }
+
+            /*the MODEL_IN_MODEL are stored in the vector itself, adding a model in model drops the index before they can move*/
+            for (i = 0; i < modelCount; i++)
+            {
+                MODEL_IN_MODEL* modelInModel = (MODEL_IN_MODEL*)VECTOR_element(modelType->models, i);
+                AddToNameIndex(&nameIndex, NAME_INDEX_MODEL_IN_MODEL, modelInModel->propertyName, modelInModel);
+            }
+
+            modelType->NameIndex = nameIndex;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+/*looks up a model or a struct type of the schema, in the name index of the schema when it is built, linearly otherwise*/
+static void* FindSchemaElement(SCHEMA_HANDLE_DATA* schema, NAME_INDEX_KIND kind, const char* name)
+{
+    void* result = NULL;
+    size_t length = strlen(name);
+
+    if (schema->NameIndex.entries != NULL)
+    {
+        result = FindInNameIndex(&schema->NameIndex, kind, name, length, HashName(name, length));
+    }
+    else
+    {
+        /*Codes_SRS_SCHEMA_99_186: [ If the hash index is not built then the lookup shall search the elements linearly. ]*/
+        size_t i;
+
+        if (kind == NAME_INDEX_MODEL)
+        {
+            for (i = 0; i < schema->ModelTypeCount; i++)
+            {
+                if (NameMatches(schema->ModelTypes[i]->Name, name, length))
+                {
+                    result = schema->ModelTypes[i];
+                    break;
+                }
+            }
+        }
+        else
+        {
+            for (i = 0; i < schema->StructTypeCount; i++)
+            {
+                if (NameMatches(schema->StructTypes[i]->Name, name, length))
+                {
+                    result = schema->StructTypes[i];
+                    break;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*looks up the element of the model named by the first length characters of name, in the name index of the model when it is built, linearly otherwise*/
+static void* FindModelElementByLength(SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType, NAME_INDEX_KIND kind, const char* name, size_t length)
+{
+    void* result = NULL;
+
+    if (modelType->NameIndex.entries != NULL)
+    {
+        result = FindInNameIndex(&modelType->NameIndex, kind, name, length, HashName(name, length));
+    }
+    else
+    {
+        /*Codes_SRS_SCHEMA_99_186: [ If the hash index is not built then the lookup shall search the elements linearly. ]*/
+        size_t i;
+        size_t count;
+
+        switch (kind)
+        {
+            case NAME_INDEX_PROPERTY:
+                for (i = 0; i < modelType->PropertyCount; i++)
+                {
+                    if (NameMatches(modelType->Properties[i]->PropertyName, name, length))
+                    {
+                        result = modelType->Properties[i];
+                        break;
+                    }
+                }
+                break;
+            case NAME_INDEX_ACTION:
+                for (i = 0; i < modelType->ActionCount; i++)
+                {
+                    if (NameMatches(modelType->Actions[i]->ActionName, name, length))
+                    {
+                        result = modelType->Actions[i];
+                        break;
+                    }
+                }
+                break;
+            case NAME_INDEX_METHOD:
+                count = VECTOR_size(modelType->methods);
+                for (i = 0; i < count; i++)
+                {
+                    SCHEMA_METHOD_HANDLE method = *(SCHEMA_METHOD_HANDLE*)VECTOR_element(modelType->methods, i);
+                    if (NameMatches(method->methodName, name, length))
+                    {
+                        result = method;
+                        break;
+                    }
+                }
+                break;
+            case NAME_INDEX_DESIRED_PROPERTY:
+                count = VECTOR_size(modelType->desiredProperties);
+                for (i = 0; i < count; i++)
+                {
+                    SCHEMA_DESIRED_PROPERTY_HANDLE desiredProperty = *(SCHEMA_DESIRED_PROPERTY_HANDLE*)VECTOR_element(modelType->desiredProperties, i);
+                    if (NameMatches(desiredProperty->desiredPropertyName, name, length))
+                    {
+                        result = desiredProperty;
+                        break;
+                    }
+                }
+                break;
+            case NAME_INDEX_REPORTED_PROPERTY:
+                count = VECTOR_size(modelType->reportedProperties);
+                for (i = 0; i < count; i++)
+                {
+                    SCHEMA_REPORTED_PROPERTY_HANDLE reportedProperty = *(SCHEMA_REPORTED_PROPERTY_HANDLE*)VECTOR_element(modelType->reportedProperties, i);
+                    if (NameMatches(reportedProperty->reportedPropertyName, name, length))
+                    {
+                        result = reportedProperty;
+                        break;
+                    }
+                }
+                break;
+            case NAME_INDEX_MODEL_IN_MODEL:
+                count = VECTOR_size(modelType->models);
+                for (i = 0; i < count; i++)
+                {
+                    MODEL_IN_MODEL* modelInModel = (MODEL_IN_MODEL*)VECTOR_element(modelType->models, i);
+                    if (NameMatches(modelInModel->propertyName, name, length))
+                    {
+                        result = modelInModel;
+                        break;
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    return result;
+}
+
+/*looks up an element of the model, in the name index of the model when it is built, linearly otherwise*/
+static void* FindModelElement(SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType, NAME_INDEX_KIND kind, const char* name)
+{
+    return FindModelElementByLength(modelType, kind, name, strlen(name));
+}
+
 static void DestroyProperty(SCHEMA_PROPERTY_HANDLE propertyHandle)
 {
     SCHEMA_PROPERTY_HANDLE_DATA* propertyType = (SCHEMA_PROPERTY_HANDLE_DATA*)propertyHandle;
@@ -252,6 +621,8 @@ static void DestroyModel(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle)
     VECTOR_clear(modelType->models);
     VECTOR_destroy(modelType->models);
 
+    ClearNameIndex(&modelType->NameIndex);
+
     free(modelType->Actions);
     free(modelType);
 }
@@ -328,6 +699,7 @@ static SCHEMA_RESULT AddModelProperty(SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType,
                     {
                         modelType->Properties[modelType->PropertyCount] = (SCHEMA_PROPERTY_HANDLE)newProperty;
                         modelType->PropertyCount++;
+                        ClearNameIndex(&modelType->NameIndex);
 
                         /* Codes_SRS_SCHEMA_99_012:[On success, Schema_AddModelProperty shall return SCHEMA_OK.] */
                         result = SCHEMA_OK;
@@ -474,6 +846,43 @@ const char* Schema_GetSchemaNamespace(SCHEMA_HANDLE schemaHandle)
     return result;
 }
 
+SCHEMA_RESULT Schema_BuildNameIndexes(SCHEMA_HANDLE schemaHandle)
+{
+    SCHEMA_RESULT result;
+
+    /*Codes_SRS_SCHEMA_99_187: [ If schemaHandle is NULL, Schema_BuildNameIndexes shall fail and return SCHEMA_INVALID_ARG. ]*/
+    if (schemaHandle == NULL)
+    {
+        LogError("invalid arg SCHEMA_HANDLE schemaHandle=%p", schemaHandle);
+        result = SCHEMA_INVALID_ARG;
+    }
+    else
+    {
+        SCHEMA_HANDLE_DATA* schema = (SCHEMA_HANDLE_DATA*)schemaHandle;
+        size_t i;
+
+        /*Codes_SRS_SCHEMA_99_188: [ Schema_BuildNameIndexes shall build the hash index of the names of the schema and the hash index of the names of each of its models, keeping the indexes that are already built. ]*/
+        /*Codes_SRS_SCHEMA_99_190: [ On success, Schema_BuildNameIndexes shall return SCHEMA_OK. ]*/
+        result = SCHEMA_OK;
+
+        /*Codes_SRS_SCHEMA_99_189: [ If any index cannot be built, Schema_BuildNameIndexes shall still build the other indexes and return SCHEMA_ERROR. ]*/
+        if (BuildSchemaNameIndex(schema) != 0)
+        {
+            result = SCHEMA_ERROR;
+        }
+
+        for (i = 0; i < schema->ModelTypeCount; i++)
+        {
+            if (BuildModelNameIndex(schema->ModelTypes[i]) != 0)
+            {
+                result = SCHEMA_ERROR;
+            }
+        }
+    }
+
+    return result;
+}
+
 void Schema_Destroy(SCHEMA_HANDLE schemaHandle)
 {
     /* Codes_SRS_SCHEMA_99_006:[If the schemaHandle is NULL, Schema_Destroy shall do nothing.] */
@@ -497,6 +906,7 @@ void Schema_Destroy(SCHEMA_HANDLE schemaHandle)
         }
 
         free(schema->StructTypes);
+        ClearNameIndex(&schema->NameIndex);
         free((void*)schema->Namespace);
         free(schema);
 
@@ -724,6 +1134,7 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_CreateModelType(SCHEMA_HANDLE schemaHandle, cons
 
                                     schema->ModelTypes[schema->ModelTypeCount] = modelType;
                                     schema->ModelTypeCount++;
+                                    ClearNameIndex(&schema->NameIndex);
                                     /* Codes_SRS_SCHEMA_99_008:[On success, a non-NULL handle shall be returned.] */
                                     result = (SCHEMA_MODEL_TYPE_HANDLE)modelType;
                                 }
@@ -848,6 +1259,7 @@ SCHEMA_RESULT Schema_AddModelReportedProperty(SCHEMA_MODEL_TYPE_HANDLE modelType
                         }
                         else
                         {
+                            ClearNameIndex(&modelType->NameIndex);
                             /*Codes_SRS_SCHEMA_02_007: [ Otherwise Schema_AddModelReportedProperty shall succeed and return SCHEMA_OK. ]*/
                             result = SCHEMA_OK;
                         }
@@ -928,6 +1340,7 @@ SCHEMA_ACTION_HANDLE Schema_CreateModelAction(SCHEMA_MODEL_TYPE_HANDLE modelType
 
                         modelType->Actions[modelType->ActionCount] = newAction;
                         modelType->ActionCount++;
+                        ClearNameIndex(&modelType->NameIndex);
                         result = (SCHEMA_ACTION_HANDLE)(newAction);
                     }
 
@@ -1032,6 +1445,7 @@ SCHEMA_METHOD_HANDLE Schema_CreateModelMethod(SCHEMA_MODEL_TYPE_HANDLE modelType
                         }
                         else
                         {
+                            ClearNameIndex(&modelTypeHandle->NameIndex);
                             /*Codes_SRS_SCHEMA_02_104: [ Otherwise, Schema_CreateModelMethod shall succeed and return a non-NULL SCHEMA_METHOD_HANDLE. ]*/
                             /*return as is*/
                         }
@@ -1252,29 +1666,15 @@ SCHEMA_PROPERTY_HANDLE Schema_GetModelPropertyByName(SCHEMA_MODEL_TYPE_HANDLE mo
     }
     else
     {
-        size_t i;
         SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
         /* Codes_SRS_SCHEMA_99_036:[Schema_GetModelPropertyByName shall return a non-NULL SCHEMA_PROPERTY_HANDLE corresponding to the model type identified by modelTypeHandle and matching the propertyName argument value.] */
-        for (i = 0; i < modelType->PropertyCount; i++)
-        {
-            SCHEMA_PROPERTY_HANDLE_DATA* modelProperty = (SCHEMA_PROPERTY_HANDLE_DATA*)modelType->Properties[i];
-            if (strcmp(modelProperty->PropertyName, propertyName) == 0)
-            {
-                break;
-            }
-        }
-
-        if (i == modelType->PropertyCount)
+        /* Codes_SRS_SCHEMA_99_184: [ Looking up an element of a model by name shall use the hash index of the names of the model built by Schema_BuildNameIndexes. The index is dropped whenever an element is added to the model. ]*/
+        if ((result = (SCHEMA_PROPERTY_HANDLE)FindModelElement(modelType, NAME_INDEX_PROPERTY, propertyName)) == NULL)
         {
             /* Codes_SRS_SCHEMA_99_038:[Schema_GetModelPropertyByName shall return NULL if unable to find a matching property or if any of the arguments are NULL.] */
-            result = NULL;
             LogError("(Error code:%s)", MU_ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_ELEMENT_NOT_FOUND));
         }
-        else
-        {
-            result = (SCHEMA_PROPERTY_HANDLE)(modelType->Properties[i]);
-        }
     }
 
     return result;
@@ -1346,7 +1746,7 @@ SCHEMA_REPORTED_PROPERTY_HANDLE Schema_GetModelReportedPropertyByName(SCHEMA_MOD
         SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
         /*Codes_SRS_SCHEMA_02_013: [ If reported property by the name reportedPropertyName exists then Schema_GetModelReportedPropertyByName shall succeed and return a non-NULL value. ]*/
         /*Codes_SRS_SCHEMA_02_014: [ Otherwise Schema_GetModelReportedPropertyByName shall fail and return NULL. ]*/
-        if((result = VECTOR_find_if(modelType->reportedProperties, reportedPropertyExists, reportedPropertyName))==NULL)
+        if ((result = (SCHEMA_REPORTED_PROPERTY_HANDLE)FindModelElement(modelType, NAME_INDEX_REPORTED_PROPERTY, reportedPropertyName)) == NULL)
         {
             LogError("a reported property with name \"%s\" does not exist", reportedPropertyName);
         }
@@ -1420,42 +1820,19 @@ SCHEMA_ACTION_HANDLE Schema_GetModelActionByName(SCHEMA_MODEL_TYPE_HANDLE modelT
     }
     else
     {
-        size_t i;
         SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
         /* Codes_SRS_SCHEMA_99_040:[Schema_GetModelActionByName shall return a non-NULL SCHEMA_ACTION_HANDLE corresponding to the model type identified by modelTypeHandle and matching the actionName argument value.] */
-        for (i = 0; i < modelType->ActionCount; i++)
-        {
-            SCHEMA_ACTION_HANDLE_DATA* modelAction = (SCHEMA_ACTION_HANDLE_DATA*)modelType->Actions[i];
-            if (strcmp(modelAction->ActionName, actionName) == 0)
-            {
-                break;
-            }
-        }
-
-        if (i == modelType->ActionCount)
+        if ((result = (SCHEMA_ACTION_HANDLE)FindModelElement(modelType, NAME_INDEX_ACTION, actionName)) == NULL)
         {
             /* Codes_SRS_SCHEMA_99_041:[Schema_GetModelActionByName shall return NULL if unable to find a matching action, if any of the arguments are NULL.] */
-            result = NULL;
             LogError("(Error code:%s)", MU_ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_ELEMENT_NOT_FOUND));
         }
-        else
-        {
-            result = modelType->Actions[i];
-        }
     }
 
     return result;
 }
 
-static bool matchModelMethod(const void* element, const void* value)
-{
-    /*element is a pointer to SCHEMA_METHOD_HANDLE_DATA*/
-    const SCHEMA_METHOD_HANDLE* decodedElement = (const SCHEMA_METHOD_HANDLE* )element;
-    const char* name = (const char*)value;
-    return (strcmp((*decodedElement)->methodName, name) == 0);
-}
-
 SCHEMA_METHOD_HANDLE Schema_GetModelMethodByName(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, const char* methodName)
 {
     SCHEMA_METHOD_HANDLE result;
@@ -1471,16 +1848,10 @@ SCHEMA_METHOD_HANDLE Schema_GetModelMethodByName(SCHEMA_MODEL_TYPE_HANDLE modelT
     else
     {
         /*Codes_SRS_SCHEMA_02_117: [ If a method with the name methodName exists then Schema_GetModelMethodByName shall succeed and returns its handle. ]*/
-        SCHEMA_METHOD_HANDLE* found = VECTOR_find_if(modelTypeHandle->methods, matchModelMethod, methodName);
-        if (found == NULL)
+        if ((result = (SCHEMA_METHOD_HANDLE)FindModelElement(modelTypeHandle, NAME_INDEX_METHOD, methodName)) == NULL)
         {
             /*Codes_SRS_SCHEMA_02_118: [ Otherwise, Schema_GetModelMethodByName shall fail and return NULL. ]*/
             LogError("no such method by name = %s", methodName);
-            result = NULL;
-        }
-        else
-        {
-            result = *found;
         }
     }
 
@@ -1830,6 +2201,7 @@ SCHEMA_STRUCT_TYPE_HANDLE Schema_CreateStructType(SCHEMA_HANDLE schemaHandle, co
                     /* Codes_SRS_SCHEMA_99_057:[Schema_CreateStructType shall create a new struct type and return a handle to it.] */
                     schema->StructTypes[schema->StructTypeCount] = structType;
                     schema->StructTypeCount++;
+                    ClearNameIndex(&schema->NameIndex);
                     structType->PropertyCount = 0;
                     structType->Properties = NULL;
 
@@ -1922,28 +2294,13 @@ SCHEMA_STRUCT_TYPE_HANDLE Schema_GetStructTypeByName(SCHEMA_HANDLE schemaHandle,
     }
     else
     {
-        size_t i;
-
         /* Codes_SRS_SCHEMA_99_068:[Schema_GetStructTypeByName shall return a non-NULL handle corresponding to the struct type identified by the structTypeName in the schemaHandle schema.] */
-        for (i = 0; i < schema->StructTypeCount; i++)
-        {
-            SCHEMA_STRUCT_TYPE_HANDLE_DATA* structType = (SCHEMA_STRUCT_TYPE_HANDLE_DATA*)schema->StructTypes[i];
-            if (strcmp(structType->Name, name) == 0)
-            {
-                break;
-            }
-        }
-
-        if (i == schema->StructTypeCount)
+        /* Codes_SRS_SCHEMA_99_185: [ Looking up a model or a struct type of a schema by name shall use the hash index of the names of the schema built by Schema_BuildNameIndexes. The index is dropped whenever a model or a struct type is added to the schema. ]*/
+        if ((result = (SCHEMA_STRUCT_TYPE_HANDLE)FindSchemaElement(schema, NAME_INDEX_STRUCT_TYPE, name)) == NULL)
         {
             /* Codes_SRS_SCHEMA_99_069:[Schema_GetStructTypeByName shall return NULL if unable to find a matching struct or if any of the arguments are NULL.] */
-            result = NULL;
             LogError("(Error code:%s)", MU_ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_ELEMENT_NOT_FOUND));
         }
-        else
-        {
-            result = schema->StructTypes[i];
-        }
     }
 
     return result;
@@ -2243,25 +2600,9 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_GetModelByName(SCHEMA_HANDLE schemaHandle, const
     else
     {
         /* Codes_SRS_SCHEMA_99_124: [Schema_GetModelByName shall return a non-NULL SCHEMA_MODEL_TYPE_HANDLE corresponding to the model identified by schemaHandle and matching the modelName argument value.] */
-        SCHEMA_HANDLE_DATA* schema = (SCHEMA_HANDLE_DATA*)schemaHandle;
-        size_t i;
-        for (i = 0; i < schema->ModelTypeCount; i++)
-        {
-            SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)schema->ModelTypes[i];
-            if (strcmp(modelName, modelType->Name)==0)
-            {
-                break;
-            }
-        }
-        if (i == schema->ModelTypeCount)
-        {
-            /* Codes_SRS_SCHEMA_99_125: [Schema_GetModelByName shall return NULL if unable to find a matching model, or if any of the arguments are NULL.] */
-            result = NULL;
-        }
-        else
-        {
-            result = schema->ModelTypes[i];
-        }
+        /* Codes_SRS_SCHEMA_99_185: [ Looking up a model or a struct type of a schema by name shall use the hash index of the names of the schema built by Schema_BuildNameIndexes. The index is dropped whenever a model or a struct type is added to the schema. ]*/
+        /* Codes_SRS_SCHEMA_99_125: [Schema_GetModelByName shall return NULL if unable to find a matching model, or if any of the arguments are NULL.] */
+        result = (SCHEMA_MODEL_TYPE_HANDLE)FindSchemaElement((SCHEMA_HANDLE_DATA*)schemaHandle, NAME_INDEX_MODEL, modelName);
     }
     return result;
 }
@@ -2340,8 +2681,8 @@ SCHEMA_RESULT Schema_AddModelModel(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, con
         }
         else
         {
+            ClearNameIndex(&parentModel->NameIndex);
             /*Codes_SRS_SCHEMA_99_164: [If the function succeeds, then the return value shall be SCHEMA_OK.]*/
-
             result = SCHEMA_OK;
         }
     }
@@ -2372,13 +2713,6 @@ SCHEMA_RESULT Schema_GetModelModelCount(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle
     return result;
 }
 
-static bool matchModelName(const void* element, const void* value)
-{
-    MODEL_IN_MODEL* decodedElement = (MODEL_IN_MODEL*)element;
-    const char* name = (const char*)value;
-    return (strcmp(decodedElement->propertyName, name) == 0);
-}
-
 SCHEMA_MODEL_TYPE_HANDLE Schema_GetModelModelByName(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, const char* propertyName)
 {
     SCHEMA_MODEL_TYPE_HANDLE result;
@@ -2396,7 +2730,7 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_GetModelModelByName(SCHEMA_MODEL_TYPE_HANDLE mod
         SCHEMA_MODEL_TYPE_HANDLE_DATA* model = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
         /*Codes_SRS_SCHEMA_99_170: [Schema_GetModelModelByName shall return a handle to the model identified by the property with the name propertyName in the model identified by the handle modelTypeHandle.]*/
         /*Codes_SRS_SCHEMA_99_171: [If Schema_GetModelModelByName is unable to provide the handle it shall return NULL.]*/
-        void* temp = VECTOR_find_if(model->models, matchModelName, propertyName);
+        MODEL_IN_MODEL* temp = (MODEL_IN_MODEL*)FindModelElement(model, NAME_INDEX_MODEL_IN_MODEL, propertyName);
         if (temp == NULL)
         {
             LogError("specified propertyName not found (%s)", propertyName);
@@ -2404,7 +2738,7 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_GetModelModelByName(SCHEMA_MODEL_TYPE_HANDLE mod
         }
         else
         {
-            result = ((MODEL_IN_MODEL*)temp)->modelHandle;
+            result = temp->modelHandle;
         }
     }
     return result;
@@ -2428,7 +2762,7 @@ size_t Schema_GetModelModelByName_Offset(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandl
     {
         SCHEMA_MODEL_TYPE_HANDLE_DATA* model = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
         /*Codes_SRS_SCHEMA_02_056: [ If propertyName is not a model then Schema_GetModelModelByName_Offset shall fail and return 0. ]*/
-        void* temp = VECTOR_find_if(model->models, matchModelName, propertyName);
+        MODEL_IN_MODEL* temp = (MODEL_IN_MODEL*)FindModelElement(model, NAME_INDEX_MODEL_IN_MODEL, propertyName);
         if (temp == NULL)
         {
             LogError("specified propertyName not found (%s)", propertyName);
@@ -2437,7 +2771,7 @@ size_t Schema_GetModelModelByName_Offset(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandl
         else
         {
             /*Codes_SRS_SCHEMA_02_055: [ Otherwise Schema_GetModelModelByName_Offset shall succeed and return the offset. ]*/
-            result = ((MODEL_IN_MODEL*)temp)->offset;
+            result = temp->offset;
         }
     }
     return result;
@@ -2459,7 +2793,7 @@ pfOnDesiredProperty Schema_GetModelModelByName_OnDesiredProperty(SCHEMA_MODEL_TY
     else
     {
         SCHEMA_MODEL_TYPE_HANDLE_DATA* model = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
-        void* temp = VECTOR_find_if(model->models, matchModelName, propertyName);
+        MODEL_IN_MODEL* temp = (MODEL_IN_MODEL*)FindModelElement(model, NAME_INDEX_MODEL_IN_MODEL, propertyName);
         if (temp == NULL)
         {
             LogError("specified propertyName not found (%s)", propertyName);
@@ -2468,7 +2802,7 @@ pfOnDesiredProperty Schema_GetModelModelByName_OnDesiredProperty(SCHEMA_MODEL_TY
         else
         {
             /*Codes_SRS_SCHEMA_02_089: [ Otherwise Schema_GetModelModelByName_OnDesiredProperty shall return the desired property callback. ]*/
-            result = ((MODEL_IN_MODEL*)temp)->onDesiredProperty;
+            result = temp->onDesiredProperty;
         }
     }
     return result;
@@ -2585,8 +2919,7 @@ bool Schema_ModelPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle,
         do
         {
             const char* endPos;
-            size_t i;
-            size_t modelCount;
+            MODEL_IN_MODEL* childModel;
             SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
             /* Codes_SRS_SCHEMA_99_179: [The propertyPath shall be assumed to be in the format model1/model2/.../propertyName.] */
@@ -2598,22 +2931,13 @@ bool Schema_ModelPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle,
             }
 
             /* get the child-model */
-            modelCount = VECTOR_size(modelType->models);
-            for (i = 0; i < modelCount; i++)
+            /* the segment is not '\0' terminated, it is looked up by its length */
+            childModel = (MODEL_IN_MODEL*)FindModelElementByLength(modelType, NAME_INDEX_MODEL_IN_MODEL, propertyPath, endPos - propertyPath);
+            if (childModel != NULL)
             {
-                MODEL_IN_MODEL* childModel = (MODEL_IN_MODEL*)VECTOR_element(modelType->models, i);
-                if (childModel != NULL &&
-                    (strncmp(childModel->propertyName, propertyPath, endPos - propertyPath) == 0) &&
-                    (strlen(childModel->propertyName) == (size_t)(endPos - propertyPath)))
-                {
-                    /* found */
-                    modelTypeHandle = childModel->modelHandle;
-                    break;
-                }
-            }
+                /* found */
+                modelTypeHandle = childModel->modelHandle;
 
-            if (i < modelCount)
-            {
                 /* model found, check if there is more in the path */
                 if (slashPos == NULL)
                 {
@@ -2631,17 +2955,11 @@ bool Schema_ModelPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle,
             {
                 /* no model found, let's see if this is a property */
                 /* Codes_SRS_SCHEMA_99_178: [The argument propertyPath shall be used to find the leaf property.] */
-                for (i = 0; i < modelType->PropertyCount; i++)
+                if (FindModelElementByLength(modelType, NAME_INDEX_PROPERTY, propertyPath, endPos - propertyPath) != NULL)
                 {
-                    SCHEMA_PROPERTY_HANDLE_DATA* property = (SCHEMA_PROPERTY_HANDLE_DATA*)modelType->Properties[i];
-                    if ((strncmp(property->PropertyName, propertyPath, endPos - propertyPath) == 0) &&
-                        (strlen(property->PropertyName) == (size_t)(endPos - propertyPath)))
-                    {
-                        /* found property */
-                        /* Codes_SRS_SCHEMA_99_177: [Schema_ModelPropertyByPathExists shall return true if a leaf property exists in the model modelTypeHandle.] */
-                        result = true;
-                        break;
-                    }
+                    /* found property */
+                    /* Codes_SRS_SCHEMA_99_177: [Schema_ModelPropertyByPathExists shall return true if a leaf property exists in the model modelTypeHandle.] */
+                    result = true;
                 }
 
                 break;
@@ -2680,8 +2998,7 @@ bool Schema_ModelReportedPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelType
         do
         {
             const char* endPos;
-            size_t i;
-            size_t modelCount;
+            MODEL_IN_MODEL* childModel;
             SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
             slashPos = strchr(reportedPropertyPath, '/');
@@ -2691,22 +3008,13 @@ bool Schema_ModelReportedPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelType
                 endPos = &reportedPropertyPath[strlen(reportedPropertyPath)];
             }
 
-            modelCount = VECTOR_size(modelType->models);
-            for (i = 0; i < modelCount; i++)
+            /* the segment is not '\0' terminated, it is looked up by its length */
+            childModel = (MODEL_IN_MODEL*)FindModelElementByLength(modelType, NAME_INDEX_MODEL_IN_MODEL, reportedPropertyPath, endPos - reportedPropertyPath);
+            if (childModel != NULL)
             {
-                MODEL_IN_MODEL* childModel = (MODEL_IN_MODEL*)VECTOR_element(modelType->models, i);
-                if (childModel != NULL &&
-                    (strncmp(childModel->propertyName, reportedPropertyPath, endPos - reportedPropertyPath) == 0) &&
-                    (strlen(childModel->propertyName) == (size_t)(endPos - reportedPropertyPath)))
-                {
-                    /* found */
-                    modelTypeHandle = childModel->modelHandle;
-                    break;
-                }
-            }
+                /* found */
+                modelTypeHandle = childModel->modelHandle;
 
-            if (i < modelCount)
-            {
                 /* model found, check if there is more in the path */
                 if (slashPos == NULL)
                 {
@@ -2724,7 +3032,7 @@ bool Schema_ModelReportedPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelType
             else
             {
                 /* no model found, let's see if this is a property */
-                result = (VECTOR_find_if(modelType->reportedProperties, reportedPropertyExists, reportedPropertyPath) != NULL);
+                result = (FindModelElement(modelType, NAME_INDEX_REPORTED_PROPERTY, reportedPropertyPath) != NULL);
                 if (!result)
                 {
                     LogError("no such reported property \"%s\"", reportedPropertyPath);
@@ -2822,6 +3130,7 @@ SCHEMA_RESULT Schema_AddModelDesiredProperty(SCHEMA_MODEL_TYPE_HANDLE modelTypeH
                             desiredProperty->desiredPropertDeinitialize = desiredPropertyDeinitialize;
                             desiredProperty->onDesiredProperty = onDesiredProperty; /*NULL is a perfectly fine value*/
                             desiredProperty->offset = offset;
+                            ClearNameIndex(&handleData->NameIndex);
                             result = SCHEMA_OK;
                         }
                     }
@@ -2874,15 +3183,9 @@ SCHEMA_DESIRED_PROPERTY_HANDLE Schema_GetModelDesiredPropertyByName(SCHEMA_MODEL
         /*Codes_SRS_SCHEMA_02_036: [ If a desired property having the name desiredPropertyName exists then Schema_GetModelDesiredPropertyByName shall succeed and return a non-NULL value. ]*/
         /*Codes_SRS_SCHEMA_02_037: [ Otherwise, Schema_GetModelDesiredPropertyByName shall fail and return NULL. ]*/
         SCHEMA_MODEL_TYPE_HANDLE_DATA* handleData = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
-        SCHEMA_DESIRED_PROPERTY_HANDLE* temp = VECTOR_find_if(handleData->desiredProperties, desiredPropertyExists, desiredPropertyName);
-        if (temp == NULL)
+        if ((result = (SCHEMA_DESIRED_PROPERTY_HANDLE)FindModelElement(handleData, NAME_INDEX_DESIRED_PROPERTY, desiredPropertyName)) == NULL)
         {
             LogError("no such desired property by name %s", desiredPropertyName);
-            result = NULL;
-        }
-        else
-        {
-            result = *temp;
         }
     }
     return result;
@@ -2945,8 +3248,7 @@ bool Schema_ModelDesiredPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeH
         do
         {
             const char* endPos;
-            size_t i;
-            size_t modelCount;
+            MODEL_IN_MODEL* childModel;
             SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
             slashPos = strchr(desiredPropertyPath, '/');
@@ -2956,22 +3258,13 @@ bool Schema_ModelDesiredPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeH
                 endPos = &desiredPropertyPath[strlen(desiredPropertyPath)];
             }
 
-            modelCount = VECTOR_size(modelType->models);
-            for (i = 0; i < modelCount; i++)
+            /* the segment is not '\0' terminated, it is looked up by its length */
+            childModel = (MODEL_IN_MODEL*)FindModelElementByLength(modelType, NAME_INDEX_MODEL_IN_MODEL, desiredPropertyPath, endPos - desiredPropertyPath);
+            if (childModel != NULL)
             {
-                MODEL_IN_MODEL* childModel = (MODEL_IN_MODEL*)VECTOR_element(modelType->models, i);
-                if (childModel != NULL &&
-                    (strncmp(childModel->propertyName, desiredPropertyPath, endPos - desiredPropertyPath) == 0) &&
-                    (strlen(childModel->propertyName) == (size_t)(endPos - desiredPropertyPath)))
-                {
-                    /* found */
-                    modelTypeHandle = childModel->modelHandle;
-                    break;
-                }
-            }
+                /* found */
+                modelTypeHandle = childModel->modelHandle;
 
-            if (i < modelCount)
-            {
                 /* model found, check if there is more in the path */
                 if (slashPos == NULL)
                 {
@@ -2989,7 +3282,7 @@ bool Schema_ModelDesiredPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeH
             else
             {
                 /* no model found, let's see if this is a property */
-                result = (VECTOR_find_if(modelType->desiredProperties, desiredPropertyExists, desiredPropertyPath) != NULL);
+                result = (FindModelElement(modelType, NAME_INDEX_DESIRED_PROPERTY, desiredPropertyPath) != NULL);
                 if (!result)
                 {
                     LogError("no such desired property \"%s\"", desiredPropertyPath);
@@ -3071,12 +3364,6 @@ size_t Schema_GetModelDesiredProperty_offset(SCHEMA_DESIRED_PROPERTY_HANDLE desi
     return result;
 }
 
-static bool modelInModelExists(const void* element, const void* value)
-{
-    MODEL_IN_MODEL* modelInModel = (MODEL_IN_MODEL*)element;
-    return (strcmp(modelInModel->propertyName, value) == 0);
-}
-
 SCHEMA_MODEL_ELEMENT Schema_GetModelElementByName(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, const char* elementName)
 {
     SCHEMA_MODEL_ELEMENT result;
@@ -3094,87 +3381,40 @@ SCHEMA_MODEL_ELEMENT Schema_GetModelElementByName(SCHEMA_MODEL_TYPE_HANDLE model
     {
         SCHEMA_MODEL_TYPE_HANDLE_DATA* handleData = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
-        SCHEMA_DESIRED_PROPERTY_HANDLE* desiredPropertyHandle = VECTOR_find_if(handleData->desiredProperties, desiredPropertyExists, elementName);
-        if (desiredPropertyHandle != NULL)
+        /*Codes_SRS_SCHEMA_99_184: [ Looking up an element of a model by name shall use the hash index of the names of the model built by Schema_BuildNameIndexes. The index is dropped whenever an element is added to the model. ]*/
+        size_t elementNameLength = strlen(elementName);
+        MODEL_IN_MODEL* modelInModel;
+
+        /*Codes_SRS_SCHEMA_02_080: [ If elementName is a desired property then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_DESIRED_PROPERTY and SCHEMA_MODEL_ELEMENT.elementHandle.desiredPropertyHandle to the handle of the desired property. ]*/
+        if ((result.elementHandle.desiredPropertyHandle = (SCHEMA_DESIRED_PROPERTY_HANDLE)FindModelElementByLength(handleData, NAME_INDEX_DESIRED_PROPERTY, elementName, elementNameLength)) != NULL)
         {
-            /*Codes_SRS_SCHEMA_02_080: [ If elementName is a desired property then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_DESIRED_PROPERTY and SCHEMA_MODEL_ELEMENT.elementHandle.desiredPropertyHandle to the handle of the desired property. ]*/
             result.elementType = SCHEMA_DESIRED_PROPERTY;
-            result.elementHandle.desiredPropertyHandle = *desiredPropertyHandle;
+        }
+        /*Codes_SRS_SCHEMA_02_078: [ If elementName is a property then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_PROPERTY and SCHEMA_MODEL_ELEMENT.elementHandle.propertyHandle to the handle of the property. ]*/
+        else if ((result.elementHandle.propertyHandle = (SCHEMA_PROPERTY_HANDLE)FindModelElementByLength(handleData, NAME_INDEX_PROPERTY, elementName, elementNameLength)) != NULL)
+        {
+            result.elementType = SCHEMA_PROPERTY;
+        }
+        /*Codes_SRS_SCHEMA_02_079: [ If elementName is a reported property then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_REPORTED_PROPERTY and SCHEMA_MODEL_ELEMENT.elementHandle.reportedPropertyHandle to the handle of the reported property. ]*/
+        else if ((result.elementHandle.reportedPropertyHandle = (SCHEMA_REPORTED_PROPERTY_HANDLE)FindModelElementByLength(handleData, NAME_INDEX_REPORTED_PROPERTY, elementName, elementNameLength)) != NULL)
+        {
+            result.elementType = SCHEMA_REPORTED_PROPERTY;
+        }
+        /*Codes_SRS_SCHEMA_02_081: [ If elementName is a model action then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_MODEL_ACTION and SCHEMA_MODEL_ELEMENT.elementHandle.actionHandle to the handle of the action. ]*/
+        else if ((result.elementHandle.actionHandle = (SCHEMA_ACTION_HANDLE)FindModelElementByLength(handleData, NAME_INDEX_ACTION, elementName, elementNameLength)) != NULL)
+        {
+            result.elementType = SCHEMA_MODEL_ACTION;
+        }
+        /*Codes_SRS_SCHEMA_02_082: [ If elementName is a model in model then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_MODEL_IN_MODEL and SCHEMA_MODEL_ELEMENT.elementHandle.modelHandle to the handle of the model. ]*/
+        else if ((modelInModel = (MODEL_IN_MODEL*)FindModelElementByLength(handleData, NAME_INDEX_MODEL_IN_MODEL, elementName, elementNameLength)) != NULL)
+        {
+            result.elementType = SCHEMA_MODEL_IN_MODEL;
+            result.elementHandle.modelHandle = modelInModel->modelHandle;
         }
         else
         {
-            size_t nProcessedProperties = 0;
-            SCHEMA_PROPERTY_HANDLE_DATA* property = NULL;
-            for (size_t i = 0; i < handleData->PropertyCount;i++)
-            {
-                property = (SCHEMA_PROPERTY_HANDLE_DATA*)(handleData->Properties[i]);
-                if (strcmp(property->PropertyName, elementName) == 0)
-                {
-                    i = handleData->PropertyCount; /*found it*/
-                }
-                else
-                {
-                    nProcessedProperties++;
-                }
-            }
-
-            if (nProcessedProperties < handleData->PropertyCount)
-            {
-                /*Codes_SRS_SCHEMA_02_078: [ If elementName is a property then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_PROPERTY and SCHEMA_MODEL_ELEMENT.elementHandle.propertyHandle to the handle of the property. ]*/
-                result.elementType = SCHEMA_PROPERTY;
-                result.elementHandle.propertyHandle = property;
-            }
-            else
-            {
-
-                SCHEMA_REPORTED_PROPERTY_HANDLE* reportedPropertyHandle = VECTOR_find_if(handleData->reportedProperties, reportedPropertyExists, elementName);
-                if (reportedPropertyHandle != NULL)
-                {
-                    /*Codes_SRS_SCHEMA_02_079: [ If elementName is a reported property then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_REPORTED_PROPERTY and SCHEMA_MODEL_ELEMENT.elementHandle.reportedPropertyHandle to the handle of the reported property. ]*/
-                    result.elementType = SCHEMA_REPORTED_PROPERTY;
-                    result.elementHandle.reportedPropertyHandle = *reportedPropertyHandle;
-                }
-                else
-                {
-
-                    size_t nProcessedActions = 0;
-                    SCHEMA_ACTION_HANDLE_DATA* actionHandleData = NULL;
-                    for (size_t i = 0;i < handleData->ActionCount; i++)
-                    {
-                        actionHandleData = (SCHEMA_ACTION_HANDLE_DATA*)(handleData->Actions[i]);
-                        if (strcmp(actionHandleData->ActionName, elementName) == 0)
-                        {
-                            i = handleData->ActionCount; /*get out quickly*/
-                        }
-                        else
-                        {
-                            nProcessedActions++;
-                        }
-                    }
-
-                    if (nProcessedActions < handleData->ActionCount)
-                    {
-                        /*Codes_SRS_SCHEMA_02_081: [ If elementName is a model action then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_MODEL_ACTION and SCHEMA_MODEL_ELEMENT.elementHandle.actionHandle to the handle of the action. ]*/
-                        result.elementType = SCHEMA_MODEL_ACTION;
-                        result.elementHandle.actionHandle = actionHandleData;
-                    }
-                    else
-                    {
-                        MODEL_IN_MODEL* modelInModel = VECTOR_find_if(handleData->models, modelInModelExists, elementName);
-                        if (modelInModel != NULL)
-                        {
-                            /*Codes_SRS_SCHEMA_02_082: [ If elementName is a model in model then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_MODEL_IN_MODEL and SCHEMA_MODEL_ELEMENT.elementHandle.modelHandle to the handle of the model. ]*/
-                            result.elementType = SCHEMA_MODEL_IN_MODEL;
-                            result.elementHandle.modelHandle = modelInModel->modelHandle;
-                        }
-                        else
-                        {
-                            /*Codes_SRS_SCHEMA_02_083: [ Otherwise Schema_GetModelElementByName shall fail and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_NOT_FOUND. ]*/
-                            result.elementType = SCHEMA_NOT_FOUND;
-                        }
-                    }
-                }
-            }
+            /*Codes_SRS_SCHEMA_02_083: [ Otherwise Schema_GetModelElementByName shall fail and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_NOT_FOUND. ]*/
+            result.elementType = SCHEMA_NOT_FOUND;
         }
     }
     return result;
@@ -0,0 +1,161 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*compares the text AgentDataTypes_ToString produces for floating point values, in bytes and in time per value, with the "%.*f" formatting
+it used before (DBL_DIG, respectively FLT_DIG, digits after the decimal point, printed in a temporary buffer then concatenated)*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include <time.h>
+
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "agenttypesystem.h"
+
+#define VALUE_COUNT 1024
+#define FORMATTED_VALUES_PER_RUN (1024 * 1024)
+#define LEGACY_BUFFER_SIZE (DECIMAL_DIG * 2)
+
+typedef int(*TO_STRING)(STRING_HANDLE destination, const AGENT_DATA_TYPE* value);
+
+/*the formatting AgentDataTypes_ToString used before, kept here as the baseline*/
+static int legacy_to_string(STRING_HANDLE destination, const AGENT_DATA_TYPE* value)
+{
+    int result;
+    char* tempBuffer = (char*)malloc(LEGACY_BUFFER_SIZE);
+    if (tempBuffer == NULL)
+    {
+        result = 1;
+    }
+    else
+    {
+        int written = (value->type == EDM_DOUBLE_TYPE) ?
+            sprintf_s(tempBuffer, LEGACY_BUFFER_SIZE, "%.*f", DBL_DIG, value->value.edmDouble.value) :
+            sprintf_s(tempBuffer, LEGACY_BUFFER_SIZE, "%.*f", FLT_DIG, (double)value->value.edmSingle.value);
+        result = ((written < 0) || (STRING_concat(destination, tempBuffer) != 0)) ? 1 : 0;
+        free(tempBuffer);
+    }
+    return result;
+}
+
+static int shortest_to_string(STRING_HANDLE destination, const AGENT_DATA_TYPE* value)
+{
+    return (AgentDataTypes_ToString(destination, value) == AGENT_DATA_TYPES_OK) ? 0 : 1;
+}
+
+/*returns the average time, in nanoseconds, it takes to format one of the values, or a negative value on failure. *bytesPerValue receives
+the average length of the text*/
+static double time_to_string(TO_STRING toString, const AGENT_DATA_TYPE* values, double* bytesPerValue)
+{
+    double result;
+    size_t runs = FORMATTED_VALUES_PER_RUN / VALUE_COUNT;
+    size_t totalLength = 0;
+    size_t i;
+    STRING_HANDLE text = STRING_new();
+    if (text == NULL)
+    {
+        result = -1.0;
+    }
+    else
+    {
+        clock_t start = clock();
+        for (i = 0; i < runs; i++)
+        {
+            size_t j;
+            for (j = 0; j < VALUE_COUNT; j++)
+            {
+                /*as DataMarshaller does, one STRING receives every value of the message*/
+                if (toString(text, &values[j]) != 0)
+                {
+                    break;
+                }
+            }
+            if (j < VALUE_COUNT)
+            {
+                break;
+            }
+            totalLength += STRING_length(text);
+            (void)STRING_empty(text);
+        }
+        result = (i < runs) ? -1.0 : (double)(clock() - start) * 1000000000.0 / CLOCKS_PER_SEC / (double)(runs * VALUE_COUNT);
+        *bytesPerValue = (double)totalLength / (double)(runs * VALUE_COUNT);
+        STRING_delete(text);
+    }
+    return result;
+}
+
+/*values as sensors report them: a few significant digits, around a typical reading*/
+static void create_values(AGENT_DATA_TYPE* values, EDM_TYPE type)
+{
+    size_t i;
+    srand(42);
+    for (i = 0; i < VALUE_COUNT; i++)
+    {
+        double reading = (double)(rand() % 100000) / 100.0 - 200.0;
+        if (type == EDM_DOUBLE_TYPE)
+        {
+            (void)Create_AGENT_DATA_TYPE_from_DOUBLE(&values[i], reading);
+        }
+        else
+        {
+            (void)Create_AGENT_DATA_TYPE_from_FLOAT(&values[i], (float)reading);
+        }
+    }
+}
+
+static int compare(const char* name, EDM_TYPE type, AGENT_DATA_TYPE* values)
+{
+    int result;
+    double legacyBytes;
+    double shortestBytes;
+    double legacy;
+    double shortest;
+    create_values(values, type);
+    legacy = time_to_string(legacy_to_string, values, &legacyBytes);
+    shortest = time_to_string(shortest_to_string, values, &shortestBytes);
+    if (legacy < 0 || shortest < 0)
+    {
+        (void)printf("formatting %s values failed\r\n", name);
+        result = 1;
+    }
+    else
+    {
+        (void)printf("%8s %14.2f %14.2f %12.2f %12.2f %7.2fx\r\n", name, legacyBytes, shortestBytes, legacy, shortest, (shortest > 0) ? legacy / shortest : 0.0);
+        result = 0;
+    }
+    return result;
+}
+
+int main(void)
+{
+    int result;
+    AGENT_DATA_TYPE* values;
+
+    if (platform_init() != 0)
+    {
+        (void)printf("platform_init failed\r\n");
+        result = 1;
+    }
+    else
+    {
+        if ((values = (AGENT_DATA_TYPE*)calloc(VALUE_COUNT, sizeof(AGENT_DATA_TYPE))) == NULL)
+        {
+            (void)printf("unable to allocate the values\r\n");
+            result = 1;
+        }
+        else
+        {
+            (void)printf("%8s %14s %14s %12s %12s %8s\r\n", "type", "%.*f bytes", "shortest bytes", "%.*f ns", "shortest ns", "speedup");
+            result = compare("double", EDM_DOUBLE_TYPE, values);
+            if (result == 0)
+            {
+                result = compare("float", EDM_SINGLE_TYPE, values);
+            }
+            free(values);
+        }
+        platform_deinit();
+    }
+    return result;
+}
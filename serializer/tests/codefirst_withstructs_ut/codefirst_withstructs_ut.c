@@ -239,6 +239,7 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_HOOK(Schema_GetModelModelCount, my_Schema_GetModelModelCount);
 
     REGISTER_GLOBAL_MOCK_RETURN(Schema_AddDeviceRef, SCHEMA_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Schema_GetModelName, "TruckType");
 
 }
 
@@ -145,6 +145,17 @@ static SCHEMA_METHOD_HANDLE TEST_MODEL_METHOD_HANDLE = (SCHEMA_METHOD_HANDLE)0x5
 static SCHEMA_METHOD_ARGUMENT_HANDLE TEST_METHOD_ARGUMENT_HANDLE_0 = (SCHEMA_METHOD_ARGUMENT_HANDLE)0x57;
 static SCHEMA_METHOD_ARGUMENT_HANDLE TEST_METHOD_ARGUMENT_HANDLE_1 = (SCHEMA_METHOD_ARGUMENT_HANDLE)0x58;
 
+static const JSON_DECODER_TOKEN TEST_TOKEN_BEGIN_OBJECT = { JSON_DECODER_TOKEN_BEGIN_OBJECT, "{", 1 };
+static const JSON_DECODER_TOKEN TEST_TOKEN_END_OBJECT = { JSON_DECODER_TOKEN_END_OBJECT, "}", 1 };
+static const JSON_DECODER_TOKEN TEST_TOKEN_NAME_INT_FIELD = { JSON_DECODER_TOKEN_NAME, "int_field", sizeof("int_field") - 1 };
+static const JSON_DECODER_TOKEN TEST_TOKEN_NAME_MODEL_IN_MODEL = { JSON_DECODER_TOKEN_NAME, "modelInModel", sizeof("modelInModel") - 1 };
+static const JSON_DECODER_TOKEN TEST_TOKEN_NAME_VERSION = { JSON_DECODER_TOKEN_NAME, "$version", sizeof("$version") - 1 };
+static const JSON_DECODER_TOKEN TEST_TOKEN_NAME_A = { JSON_DECODER_TOKEN_NAME, "a\":2}", 1 };
+static const JSON_DECODER_TOKEN TEST_TOKEN_NAME_B = { JSON_DECODER_TOKEN_NAME, "b\":3}", 1 };
+static const JSON_DECODER_TOKEN TEST_TOKEN_NAME_ABC = { JSON_DECODER_TOKEN_NAME, "abc\":[1]}", 3 };
+static const JSON_DECODER_TOKEN TEST_TOKEN_NUMBER_2 = { JSON_DECODER_TOKEN_NUMBER, "2}", 1 };
+static const JSON_DECODER_TOKEN TEST_TOKEN_NUMBER_3 = { JSON_DECODER_TOKEN_NUMBER, "3}", 1 };
+
 MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES);
 
 static void SetupCommand(const char* quotedActionName, const char* actionName)
@@ -174,6 +185,13 @@ void SetupArgumentCalls(SCHEMA_ACTION_HANDLE actionHandle, size_t index, SCHEMA_
         .SetReturn(argType);
 }
 
+/*the token is copied out of the mock, its text points into a JSON that is not '\0' terminated after the token*/
+static void setup_JSONDecoder_Reader_Next(const JSON_DECODER_TOKEN* token)
+{
+    STRICT_EXPECTED_CALL(JSONDecoder_Reader_Next(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_token(token, sizeof(*token));
+}
+
 static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 {
     char temp_str[256];
@@ -316,6 +334,9 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         REGISTER_UMOCK_ALIAS_TYPE(pfOnDesiredProperty, void*);
         REGISTER_UMOCK_ALIAS_TYPE(SCHEMA_METHOD_HANDLE, void*);
         REGISTER_UMOCK_ALIAS_TYPE(SCHEMA_METHOD_ARGUMENT_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(JSON_DECODER_READER*, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(const JSON_DECODER_READER*, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(JSON_DECODER_TOKEN*, void*);
 
 
         REGISTER_UMOCK_ALIAS_TYPE(JSON_DECODER_RESULT, int);
@@ -335,6 +356,14 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
 
         REGISTER_GLOBAL_MOCK_HOOK(JSONDecoder_JSON_To_MultiTree, my_JSONDecoder_JSON_To_MultiTree);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(JSONDecoder_JSON_To_MultiTree, JSON_DECODER_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURN(JSONDecoder_Reader_Init, JSON_DECODER_OK);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(JSONDecoder_Reader_Init, JSON_DECODER_PARSE_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURN(JSONDecoder_Reader_Next, JSON_DECODER_OK);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(JSONDecoder_Reader_Next, JSON_DECODER_PARSE_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURN(JSONDecoder_Reader_SkipValue, JSON_DECODER_OK);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(JSONDecoder_Reader_SkipValue, JSON_DECODER_PARSE_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURN(JSONDecoder_Reader_GetMember, JSON_DECODER_OK);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(JSONDecoder_Reader_GetMember, JSON_DECODER_MEMBER_NOT_FOUND);
         REGISTER_GLOBAL_MOCK_HOOK(MultiTree_Destroy, my_MultiTree_Destroy);
 
         REGISTER_GLOBAL_MOCK_HOOK(Create_AGENT_DATA_TYPE_from_Members, my_Create_AGENT_DATA_TYPE_from_Members);
@@ -2995,32 +3024,13 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    void CommandDecoder_IngestDesiredProperties_with_1_simple_desired_property_succeeds_inert_path(unsigned char* deviceMemoryArea, const char* desiredPropertiesJSON, const char* three, size_t one, MULTITREE_HANDLE childHandle, bool desiredPropertyHasCallback)
+    void CommandDecoder_IngestDesiredProperties_with_1_simple_desired_property_succeeds_inert_path(unsigned char* deviceMemoryArea, const char* desiredPropertiesJSON, bool desiredPropertyHasCallback)
     {
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, desiredPropertiesJSON))
-            .IgnoreArgument_destination();
-
-        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_MultiTree(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_json()
-            .IgnoreArgument_multiTreeHandle();
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_Init(IGNORED_PTR_ARG, desiredPropertiesJSON));
 
-        STRICT_EXPECTED_CALL(MultiTree_DeleteChild(IGNORED_PTR_ARG, IGNORED_PTR_ARG)).CallCannotFail();
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_BEGIN_OBJECT);
 
-        STRICT_EXPECTED_CALL(MultiTree_GetChildCount(IGNORED_PTR_ARG, IGNORED_PTR_ARG)).CallCannotFail()
-            .CopyOutArgumentBuffer_count(&one, sizeof(one));
-
-        STRICT_EXPECTED_CALL(MultiTree_GetChild(IGNORED_PTR_ARG, 0, IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle()
-            .CopyOutArgumentBuffer_childHandle(&childHandle, sizeof(childHandle));
-
-        STRICT_EXPECTED_CALL(STRING_new())
-            .SetReturn(TEST_STRING_HANDLE_CHILD_NAME);
-
-        STRICT_EXPECTED_CALL(MultiTree_GetName(childHandle, TEST_STRING_HANDLE_CHILD_NAME)); /*this fills in TEST_STRING_HANDLE_CHILD_NAME with "int_field"*/
-
-        STRICT_EXPECTED_CALL(STRING_c_str(TEST_STRING_HANDLE_CHILD_NAME)) /*6*/
-            .SetReturn("int_field")
-            .CallCannotFail();
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NAME_INT_FIELD);
 
         STRICT_EXPECTED_CALL(Schema_GetModelElementByName(TEST_MODEL_HANDLE, "int_field"))
             .SetReturn(Schema_GetModelElementByName_desiredProperty_int_field);
@@ -3033,18 +3043,15 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
             .CallCannotFail()
             .SetReturn(TEST_SCHEMA);
 
-        /*this is DecodeValueFromNode expected calls*/
+        /*this is DecodeValueFromReader expected calls*/
 
         STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
             .CallCannotFail()
             .SetReturn(EDM_INT32_TYPE);
 
-        STRICT_EXPECTED_CALL(MultiTree_GetValue(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle()
-            .CopyOutArgumentBuffer_destination(&three, sizeof(three));
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NUMBER_3);
 
-        STRICT_EXPECTED_CALL(CreateAgentDataType_From_String(IGNORED_PTR_ARG, EDM_INT32_TYPE, IGNORED_PTR_ARG))
-            .IgnoreArgument_source()
+        STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("3", EDM_INT32_TYPE, IGNORED_PTR_ARG))
             .IgnoreArgument_agentData()
             .SetReturn(AGENT_DATA_TYPES_OK);
 
@@ -3068,21 +3075,19 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
             STRICT_EXPECTED_CALL(onDesiredPropertySimpleProperty(IGNORED_PTR_ARG));
         }
 
-        STRICT_EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
-
-        STRICT_EXPECTED_CALL(STRING_delete(TEST_STRING_HANDLE_CHILD_NAME));
-
-        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG))
+            .CallCannotFail();
 
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_END_OBJECT);
     }
 
     /*case1: a simple property (non-recursive) is ingested*/
     /*the property is called "int_field" and shall have the value 3*/
-    /*Tests_SRS_COMMAND_DECODER_02_005: [ CommandDecoder_IngestDesiredProperties shall create a MULTITREE_HANDLE ouf of the clone of desiredProperties. ]*/
-    /*Tests_SRS_COMMAND_DECODER_02_007: [ If the child name corresponds to a desired property then an AGENT_DATA_TYPE shall be constructed from the MULTITREE node. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_004: [ CommandDecoder_IngestDesiredProperties shall read jsonPayload in place, without cloning it. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_005: [ CommandDecoder_IngestDesiredProperties shall initialize a JSON_DECODER_READER over jsonPayload by calling JSONDecoder_Reader_Init. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_007: [ If the member name corresponds to a desired property then an AGENT_DATA_TYPE shall be constructed from the member value. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_008: [ The desired property shall be constructed in memory by calling pfDesiredPropertyFromAGENT_DATA_TYPE. ]*/
-    /*Tests_SRS_COMMAND_DECODER_02_010: [ If the complete MULTITREE has been parsed then CommandDecoder_IngestDesiredProperties shall succeed and return EXECUTE_COMMAND_SUCCESS. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_010: [ If the complete JSON object has been read then CommandDecoder_IngestDesiredProperties shall succeed and return EXECUTE_COMMAND_SUCCESS. ]*/
     TEST_FUNCTION(CommandDecoder_IngestDesiredProperties_with_1_simple_desired_property_happy_path)
     {
         ///arrange
@@ -3090,11 +3095,8 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         umock_c_reset_all_calls();
         unsigned char deviceMemoryArea[100];
         const char* desiredPropertiesJSON = "{\"int_field\":3}";
-        const char* three = "3";
-        size_t one = 1;
-        MULTITREE_HANDLE childHandle = (MULTITREE_HANDLE)0x11;
 
-        CommandDecoder_IngestDesiredProperties_with_1_simple_desired_property_succeeds_inert_path(deviceMemoryArea, desiredPropertiesJSON, three, one, childHandle, false);
+        CommandDecoder_IngestDesiredProperties_with_1_simple_desired_property_succeeds_inert_path(deviceMemoryArea, desiredPropertiesJSON, false);
 
         ///act
         EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, false);
@@ -3115,36 +3117,13 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         unsigned char deviceMemoryArea[100];
         const char* desiredPropertiesJSON = "{\"int_field\":3}";
-        const char* three = "3";
-        size_t one = 1;
-        MULTITREE_HANDLE childHandle = (MULTITREE_HANDLE)0x11;
         (void)umock_c_negative_tests_init();
         umock_c_reset_all_calls();
 
-        CommandDecoder_IngestDesiredProperties_with_1_simple_desired_property_succeeds_inert_path(deviceMemoryArea, desiredPropertiesJSON, three, one, childHandle, false);
+        CommandDecoder_IngestDesiredProperties_with_1_simple_desired_property_succeeds_inert_path(deviceMemoryArea, desiredPropertiesJSON, false);
 
         umock_c_negative_tests_snapshot();
 
-#if 0
-        size_t calls_that_cannot_fail[] =
-        {
-            2, /*MultiTree_DeleteChild*/
-
-            3,/*MultiTree_GetChildCount*/
-            7, /*STRING_c_str*/
-
-            9, /*Schema_GetModelDesiredPropertyType*/
-            10, /*Schema_GetSchemaForModelType*/
-            11, /*CodeFirst_GetPrimitiveType*/
-            14, /*Schema_GetModelDesiredProperty_pfDesiredPropertyFromAGENT_DATA_TYPE*/
-            15, /*Schema_GetModelDesiredProperty_offset*/
-            17, /*Schema_GetModelDesiredProperty_pfOnDesiredProperty*/
-            18, /*Destroy_AGENT_DATA_TYPE*/
-            19, /*STRING_delete*/
-            20, /*MultiTree_Destroy*/
-            21 /*gballoc_free*/
-        };
-#endif
         size_t count = umock_c_negative_tests_call_count();
         for (size_t i = 0; i < count; i++)
         {
@@ -3168,94 +3147,186 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    void CommandDecoder_IngestDesiredProperties_with_1_simple_model_in_model_desired_property_inert_path(unsigned char* deviceMemoryArea, const char* desiredPropertiesJSON, const char* three, size_t one, MULTITREE_HANDLE childHandle, bool desiredPropertiesHaveCallbacks)
+    /*Tests_SRS_COMMAND_DECODER_02_005: [ CommandDecoder_IngestDesiredProperties shall initialize a JSON_DECODER_READER over jsonPayload by calling JSONDecoder_Reader_Init. ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredProperties_when_JSONDecoder_Reader_Init_fails_it_fails)
     {
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, desiredPropertiesJSON))
-            .IgnoreArgument_destination();
+        ///arrange
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+        unsigned char deviceMemoryArea[100];
+        const char* desiredPropertiesJSON = "{\"int_field\":3";
 
-        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_MultiTree(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_json()
-            .IgnoreArgument_multiTreeHandle();
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_Init(IGNORED_PTR_ARG, desiredPropertiesJSON))
+            .SetReturn(JSON_DECODER_PARSE_ERROR);
 
-        STRICT_EXPECTED_CALL(MultiTree_DeleteChild(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle()
-            .IgnoreArgument_childName();
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, false);
 
-        STRICT_EXPECTED_CALL(MultiTree_GetChildCount(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*2*/
-            .IgnoreArgument_treeHandle()
-            .CopyOutArgumentBuffer_count(&one, sizeof(one));
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
 
-        STRICT_EXPECTED_CALL(MultiTree_GetChild(IGNORED_PTR_ARG, 0, IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle()
-            .CopyOutArgumentBuffer_childHandle(&childHandle, sizeof(childHandle));
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
 
-        STRICT_EXPECTED_CALL(STRING_new())
-            .SetReturn(TEST_STRING_HANDLE_CHILD_NAME);
+    /*Tests_SRS_COMMAND_DECODER_02_014: [ If parseDesiredNode is TRUE, read only the value of the `desired` member of the JSON, located with JSONDecoder_Reader_GetMember ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredProperties_with_parseDesiredNode_reads_only_desired_happy_path)
+    {
+        ///arrange
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+        unsigned char deviceMemoryArea[100];
+        const char* twinJSON = "{\"reported\":{\"int_field\":4},\"desired\":{\"int_field\":3}}";
 
-        STRICT_EXPECTED_CALL(MultiTree_GetName(childHandle, TEST_STRING_HANDLE_CHILD_NAME)); /*this fills in TEST_STRING_HANDLE_CHILD_NAME with "modelInModel"*/
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_Init(IGNORED_PTR_ARG, twinJSON));
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_BEGIN_OBJECT);
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_GetMember(IGNORED_PTR_ARG, "desired", IGNORED_PTR_ARG));
 
-        STRICT_EXPECTED_CALL(STRING_c_str(TEST_STRING_HANDLE_CHILD_NAME)) /*6*/
-            .SetReturn("modelInModel");
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_BEGIN_OBJECT);
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NAME_INT_FIELD);
+        STRICT_EXPECTED_CALL(Schema_GetModelElementByName(TEST_MODEL_HANDLE, "int_field"))
+            .SetReturn(Schema_GetModelElementByName_desiredProperty_int_field);
+        STRICT_EXPECTED_CALL(Schema_GetModelDesiredPropertyType(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+            .SetReturn("int");
+        STRICT_EXPECTED_CALL(Schema_GetSchemaForModelType(TEST_MODEL_HANDLE))
+            .SetReturn(TEST_SCHEMA);
+        STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
+            .SetReturn(EDM_INT32_TYPE);
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NUMBER_3);
+        STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("3", EDM_INT32_TYPE, IGNORED_PTR_ARG))
+            .IgnoreArgument_agentData();
+        STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_pfDesiredPropertyFromAGENT_DATA_TYPE(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+            .SetReturn(int_pfDesiredPropertyFromAGENT_DATA_TYPE);
+        STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_offset(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+            .SetReturn(2);
+        STRICT_EXPECTED_CALL(int_pfDesiredPropertyFromAGENT_DATA_TYPE(IGNORED_PTR_ARG, (unsigned char*)deviceMemoryArea + 2))
+            .IgnoreArgument_source();
+        STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_pfOnDesiredProperty(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_END_OBJECT);
+
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, twinJSON, true);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
+
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_02_014: [ If parseDesiredNode is TRUE, read only the value of the `desired` member of the JSON, located with JSONDecoder_Reader_GetMember ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredProperties_with_parseDesiredNode_and_no_desired_fails)
+    {
+        ///arrange
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+        unsigned char deviceMemoryArea[100];
+        const char* twinJSON = "{\"reported\":{\"int_field\":4}}";
+
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_Init(IGNORED_PTR_ARG, twinJSON));
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_BEGIN_OBJECT);
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_GetMember(IGNORED_PTR_ARG, "desired", IGNORED_PTR_ARG))
+            .SetReturn(JSON_DECODER_MEMBER_NOT_FOUND);
+
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, twinJSON, true);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
+
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_02_015: [ A '$version' member of the desired properties shall be skipped with JSONDecoder_Reader_SkipValue. It not being present is not an error ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredProperties_skips_version_happy_path)
+    {
+        ///arrange
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+        unsigned char deviceMemoryArea[100];
+        const char* desiredPropertiesJSON = "{\"$version\":7}";
+
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_Init(IGNORED_PTR_ARG, desiredPropertiesJSON));
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_BEGIN_OBJECT);
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NAME_VERSION);
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_SkipValue(IGNORED_PTR_ARG));
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_END_OBJECT);
+
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, false);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
+
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    void CommandDecoder_IngestDesiredProperties_with_1_simple_model_in_model_desired_property_inert_path(unsigned char* deviceMemoryArea, const char* desiredPropertiesJSON, bool desiredPropertiesHaveCallbacks)
+    {
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_Init(IGNORED_PTR_ARG, desiredPropertiesJSON));
+
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_BEGIN_OBJECT);
+
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NAME_MODEL_IN_MODEL);
 
         STRICT_EXPECTED_CALL(Schema_GetModelElementByName(TEST_MODEL_HANDLE, "modelInModel"))
             .SetReturn(Schema_GetModelElementByName_modelInModel);
 
-        STRICT_EXPECTED_CALL(Schema_GetModelModelByName_Offset(TEST_MODEL_HANDLE, "modelInModel")) /*9*/
+        STRICT_EXPECTED_CALL(Schema_GetModelModelByName_Offset(TEST_MODEL_HANDLE, "modelInModel"))
+            .CallCannotFail()
             .SetReturn(10);
 
         /*here recursion happens*/
 
         {
-            STRICT_EXPECTED_CALL(MultiTree_GetChildCount(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*10*/
-                .IgnoreArgument_treeHandle()
-                .CopyOutArgumentBuffer_count(&one, sizeof(one));
-
-            STRICT_EXPECTED_CALL(MultiTree_GetChild(IGNORED_PTR_ARG, 0, IGNORED_PTR_ARG))
-                .IgnoreArgument_treeHandle()
-                .CopyOutArgumentBuffer_childHandle(&childHandle, sizeof(childHandle));
-
-            STRICT_EXPECTED_CALL(STRING_new())
-                .SetReturn(TEST_STRING_HANDLE_CHILD_NAME);
-
-            STRICT_EXPECTED_CALL(MultiTree_GetName(childHandle, TEST_STRING_HANDLE_CHILD_NAME)); /*13*/ /*this fills in TEST_STRING_HANDLE_CHILD_NAME with "int_field"*/
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_BEGIN_OBJECT);
 
-            STRICT_EXPECTED_CALL(STRING_c_str(TEST_STRING_HANDLE_CHILD_NAME)) /*14*/
-                .SetReturn("int_field");
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NAME_INT_FIELD);
 
             STRICT_EXPECTED_CALL(Schema_GetModelElementByName(SCHEMA_MODEL_TYPE_HANDLE_MODEL_IN_MODEL, "int_field"))
                 .SetReturn(Schema_GetModelElementByName_desiredProperty_int_field);
 
-            STRICT_EXPECTED_CALL(Schema_GetModelDesiredPropertyType(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD)) /*17*/
+            STRICT_EXPECTED_CALL(Schema_GetModelDesiredPropertyType(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+                .CallCannotFail()
                 .SetReturn("int");
 
-            STRICT_EXPECTED_CALL(Schema_GetSchemaForModelType(SCHEMA_MODEL_TYPE_HANDLE_MODEL_IN_MODEL)) /*18*/
+            STRICT_EXPECTED_CALL(Schema_GetSchemaForModelType(SCHEMA_MODEL_TYPE_HANDLE_MODEL_IN_MODEL))
+                .CallCannotFail()
                 .SetReturn(TEST_SCHEMA);
 
-            /*this is DecodeValueFromNodea expected calls*/
+            /*this is DecodeValueFromReader expected calls*/
 
-            STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int")) /*19*/
+            STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
+                .CallCannotFail()
                 .SetReturn(EDM_INT32_TYPE);
 
-            STRICT_EXPECTED_CALL(MultiTree_GetValue(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-                .IgnoreArgument_treeHandle()
-                .CopyOutArgumentBuffer_destination(&three, sizeof(three));
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NUMBER_3);
 
-            STRICT_EXPECTED_CALL(CreateAgentDataType_From_String(IGNORED_PTR_ARG, EDM_INT32_TYPE, IGNORED_PTR_ARG))
-                .IgnoreArgument_source()
+            STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("3", EDM_INT32_TYPE, IGNORED_PTR_ARG))
                 .IgnoreArgument_agentData()
                 .SetReturn(AGENT_DATA_TYPES_OK);
 
-            STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_pfDesiredPropertyFromAGENT_DATA_TYPE(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD)) /*22*/
+            STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_pfDesiredPropertyFromAGENT_DATA_TYPE(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+                .CallCannotFail()
                 .SetReturn(int_pfDesiredPropertyFromAGENT_DATA_TYPE);
 
-            STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_offset(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD)) /*23*/
+            STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_offset(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+                .CallCannotFail()
                 .SetReturn(2);
 
             STRICT_EXPECTED_CALL(int_pfDesiredPropertyFromAGENT_DATA_TYPE(IGNORED_PTR_ARG, (unsigned char*)deviceMemoryArea + 12))  /*notice here the new offset (2+10)*/
                 .IgnoreArgument_source();
 
-            STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_pfOnDesiredProperty(IGNORED_PTR_ARG)) /*24*/
+            STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_pfOnDesiredProperty(IGNORED_PTR_ARG))
                 .IgnoreArgument_desiredPropertyHandle()
+                .CallCannotFail()
                 .SetReturn(desiredPropertiesHaveCallbacks ? onDesiredPropertySimpleProperty : NULL);
 
             if (desiredPropertiesHaveCallbacks)
@@ -3264,15 +3335,16 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
                     .IgnoreArgument_v();
             }
 
-
             STRICT_EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG))
-                .IgnoreArgument_agentData();
+                .IgnoreArgument_agentData()
+                .CallCannotFail();
 
-            STRICT_EXPECTED_CALL(STRING_delete(TEST_STRING_HANDLE_CHILD_NAME));
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_END_OBJECT);
         }
 
-        STRICT_EXPECTED_CALL(Schema_GetModelModelByName_OnDesiredProperty(IGNORED_PTR_ARG, "modelInModel")) /*27*/
+        STRICT_EXPECTED_CALL(Schema_GetModelModelByName_OnDesiredProperty(IGNORED_PTR_ARG, "modelInModel"))
             .IgnoreArgument_modelTypeHandle()
+            .CallCannotFail()
             .SetReturn(desiredPropertiesHaveCallbacks ? onDesiredPropertyModelInModel : NULL);
 
         if (desiredPropertiesHaveCallbacks)
@@ -3281,16 +3353,10 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
                 .IgnoreArgument_v();
         }
 
-        STRICT_EXPECTED_CALL(STRING_delete(TEST_STRING_HANDLE_CHILD_NAME));
-
-        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle();
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument_ptr();
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_END_OBJECT);
     }
 
-    /*Tests_SRS_COMMAND_DECODER_02_009: [ If the child name corresponds to a model in model then the function shall call itself recursively. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_009: [ If the member name corresponds to a model in model then the function shall call itself recursively. ]*/
     TEST_FUNCTION(CommandDecoder_IngestDesiredProperties_with_1_simple_model_in_model_desired_property_happy_path)
     {
         ///arrange
@@ -3298,11 +3364,8 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         umock_c_reset_all_calls();
         unsigned char deviceMemoryArea[100];
         const char* desiredPropertiesJSON = "{\"modelInModel\":{\"int_field\":3}}";
-        const char* three = "3";
-        size_t one = 1;
-        MULTITREE_HANDLE childHandle = (MULTITREE_HANDLE)0x11;
 
-        CommandDecoder_IngestDesiredProperties_with_1_simple_model_in_model_desired_property_inert_path(deviceMemoryArea, desiredPropertiesJSON, three, one, childHandle, false);
+        CommandDecoder_IngestDesiredProperties_with_1_simple_model_in_model_desired_property_inert_path(deviceMemoryArea, desiredPropertiesJSON, false);
 
         ///act
         EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, false);
@@ -3323,57 +3386,21 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         unsigned char deviceMemoryArea[100];
         const char* desiredPropertiesJSON = "{\"modelInModel\":{\"int_field\":3}}";
-        const char* three = "3";
-        size_t one = 1;
-        MULTITREE_HANDLE childHandle = (MULTITREE_HANDLE)0x11;
         (void)umock_c_negative_tests_init();
         umock_c_reset_all_calls();
 
-        CommandDecoder_IngestDesiredProperties_with_1_simple_model_in_model_desired_property_inert_path(deviceMemoryArea, desiredPropertiesJSON, three, one, childHandle, false);
+        CommandDecoder_IngestDesiredProperties_with_1_simple_model_in_model_desired_property_inert_path(deviceMemoryArea, desiredPropertiesJSON, false);
 
         umock_c_negative_tests_snapshot();
 
-        size_t calls_that_cannot_fail[] =
-        {
-            2, /*MultiTree_DeleteChild*/
-            3, /*MultiTree_GetChildCount*/
-            7, /*STRING_c_str*/
-            9, /*Schema_GetModelModelByName_Offset*/
-            10, /*MultiTree_GetChildCount*/
-            13, /*MultiTree_GetName*/
-            14, /*STRING_c_str*/
-            16, /*Schema_GetModelDesiredPropertyType*/
-            17, /*Schema_GetSchemaForModelType*/
-            18, /*CodeFirst_GetPrimitiveType*/
-            21, /*Schema_GetModelDesiredProperty_pfDesiredPropertyFromAGENT_DATA_TYPE*/
-            22, /*Schema_GetModelDesiredProperty_offset*/
-            24, /*Destroy_AGENT_DATA_TYPE*/
-            25, /*Schema_GetModelDesiredProperty_pfOnDesiredProperty*/
-            26, /*STRING_delete*/
-            27, /*STRING_delete*/
-            28, /*Schema_GetModelModelByName_OnDesiredProperty*/
-            29, /*MultiTree_Destroy*/
-            30, /*gballoc_free*/
-        };
-
         size_t count = umock_c_negative_tests_call_count();
         for (size_t i = 0; i < count; i++)
         {
-            size_t j;
             umock_c_negative_tests_reset();
 
-            for (j = 0;j<sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]);j++) /*not running the tests that cannot fail*/
-            {
-                if (calls_that_cannot_fail[j] == i)
-                    break;
-            }
-
-            if (j == sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]))
+            if (umock_c_negative_tests_can_call_fail(i))
             {
-
                 umock_c_negative_tests_fail_call(i);
-                char temp_str[128];
-                sprintf(temp_str, "On failed call %lu", (unsigned long)i);
 
                 ///act
                 EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, false);
@@ -3398,11 +3425,8 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         umock_c_reset_all_calls();
         unsigned char deviceMemoryArea[100];
         const char* desiredPropertiesJSON = "{\"int_field\":3}";
-        const char* three = "3";
-        size_t one = 1;
-        MULTITREE_HANDLE childHandle = (MULTITREE_HANDLE)0x11;
 
-        CommandDecoder_IngestDesiredProperties_with_1_simple_desired_property_succeeds_inert_path(deviceMemoryArea, desiredPropertiesJSON, three, one, childHandle, true);
+        CommandDecoder_IngestDesiredProperties_with_1_simple_desired_property_succeeds_inert_path(deviceMemoryArea, desiredPropertiesJSON, true);
 
         ///act
         EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, false);
@@ -3425,11 +3449,8 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         umock_c_reset_all_calls();
         unsigned char deviceMemoryArea[100];
         const char* desiredPropertiesJSON = "{\"modelInModel\":{\"int_field\":3}}";
-        const char* three = "3";
-        size_t one = 1;
-        MULTITREE_HANDLE childHandle = (MULTITREE_HANDLE)0x11;
 
-        CommandDecoder_IngestDesiredProperties_with_1_simple_model_in_model_desired_property_inert_path(deviceMemoryArea, desiredPropertiesJSON, three, one, childHandle, true);
+        CommandDecoder_IngestDesiredProperties_with_1_simple_model_in_model_desired_property_inert_path(deviceMemoryArea, desiredPropertiesJSON, true);
 
         ///act
         EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, false);
@@ -3520,12 +3541,12 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
             .IgnoreArgument_ptr();
     }
 
-    /*Tests_SRS_COMMAND_DECODER_02_016: [ If methodPayload is not NULL then CommandDecoder_ExecuteMethod shall build a MULTITREE_HANDLE out of methodPayload. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_016: [ If methodPayload is not NULL then CommandDecoder_ExecuteMethod shall read methodPayload in place with a JSON_DECODER_READER initialized by JSONDecoder_Reader_Init. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_017: [ CommandDecoder_ExecuteMethod shall get the SCHEMA_HANDLE associated with the modelHandle passed at CommandDecoder_Create. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_018: [ CommandDecoder_ExecuteMethod shall validate that consecutive segments of the fullMethodName exist in the model. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_019: [ CommandDecoder_ExecuteMethod shall locate the final model to which the methodName applies. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_020: [ CommandDecoder_ExecuteMethod shall verify that the model has a method called methodName. ]*/
-    /*Tests_SRS_COMMAND_DECODER_02_021: [ For every argument of methodName, CommandDecoder_ExecuteMethod shall build an AGENT_DATA_TYPE from the node with the same name from the MULTITREE_HANDLE. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_021: [ For every argument of methodName, CommandDecoder_ExecuteMethod shall build an AGENT_DATA_TYPE from the member with the same name of the JSON object in methodPayload. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_022: [ CommandDecoder_ExecuteMethod shall call methodCallback passing the context, the methodName, number of arguments and the AGENT_DATA_TYPE. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_024: [ Otherwise, CommandDecoder_ExecuteMethod shall return what methodCallback returns. ]*/
     TEST_FUNCTION(CommandDecoder_ExecuteMethod_with_NULL_payload_hapy_path)
@@ -3585,13 +3606,9 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         umock_c_negative_tests_deinit();
     }
 
-    static void CommandDecoder_ExecuteMethod_with_1_arg_payload_inert_path(size_t* one, const char* methodPayload, const char** aValue)
+    static void CommandDecoder_ExecuteMethod_with_1_arg_payload_inert_path(size_t* one, const char* methodPayload)
     {
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, methodPayload))
-            .IgnoreArgument_destination();
-        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_MultiTree(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_json()
-            .IgnoreArgument_multiTreeHandle();
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_Init(IGNORED_PTR_ARG, methodPayload));
         STRICT_EXPECTED_CALL(Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         STRICT_EXPECTED_CALL(gballoc_malloc(1)); /*this is the string "" for relative relativeMethodPath*/
         STRICT_EXPECTED_CALL(Schema_GetModelMethodByName(TEST_MODEL_HANDLE, "methodA"));
@@ -3602,6 +3619,7 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
 
         STRICT_EXPECTED_CALL(gballoc_calloc(IGNORED_NUM_ARG, IGNORED_NUM_ARG)) /*this is the array holding 1 x AGENT_DATA_TYPE */
             .IgnoreAllArguments().IgnoreArgument_size();
+        STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(const char*))); /*this is the array holding the argument names and types*/
 
         STRICT_EXPECTED_CALL(Schema_GetModelMethodArgumentByIndex(TEST_MODEL_METHOD_HANDLE, 0))
             .SetReturn(TEST_METHOD_ARGUMENT_HANDLE_0);
@@ -3610,19 +3628,21 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         STRICT_EXPECTED_CALL(Schema_GetMethodArgumentType(TEST_METHOD_ARGUMENT_HANDLE_0))
             .SetReturn("int");
 
-        STRICT_EXPECTED_CALL(MultiTree_GetChildByName(IGNORED_PTR_ARG, "a", IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle()
-            .IgnoreArgument_childHandle();
+        { /*scope for DecodeMembersFromReader*/
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_BEGIN_OBJECT);
+            STRICT_EXPECTED_CALL(gballoc_calloc(1, sizeof(bool))); /*this is the array of decoded flags*/
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NAME_A);
 
-        { /*scope for DecodeValueFromNode*/
-            STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
-                .SetReturn(EDM_INT32_TYPE);
-            STRICT_EXPECTED_CALL(MultiTree_GetValue(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-                .IgnoreArgument_treeHandle()
-                .IgnoreArgument_destination()
-                .CopyOutArgumentBuffer_destination(aValue, sizeof(aValue));
-            STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("2", EDM_INT32_TYPE, IGNORED_PTR_ARG))
-                .IgnoreArgument_agentData();
+            { /*scope for DecodeValueFromReader*/
+                STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
+                    .SetReturn(EDM_INT32_TYPE);
+                setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NUMBER_2);
+                STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("2", EDM_INT32_TYPE, IGNORED_PTR_ARG))
+                    .IgnoreArgument_agentData();
+            }
+
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_END_OBJECT);
+            STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); /*this is freeing the decoded flags*/
         }
 
         STRICT_EXPECTED_CALL(methodCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "", "methodA", 1, IGNORED_PTR_ARG))
@@ -3630,39 +3650,35 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
 
         STRICT_EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG))
             .IgnoreArgument_agentData();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*this is freeing the argument names and types*/
+            .IgnoreArgument_ptr();
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument_ptr();
 
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*this is freeing the relativeMethodPath*/
             .IgnoreArgument_ptr();
-
-        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle();
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument_ptr();
-
     }
 
-    /*Tests_SRS_COMMAND_DECODER_02_016: [ If methodPayload is not NULL then CommandDecoder_ExecuteMethod shall build a MULTITREE_HANDLE out of methodPayload. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_016: [ If methodPayload is not NULL then CommandDecoder_ExecuteMethod shall read methodPayload in place with a JSON_DECODER_READER initialized by JSONDecoder_Reader_Init. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_017: [ CommandDecoder_ExecuteMethod shall get the SCHEMA_HANDLE associated with the modelHandle passed at CommandDecoder_Create. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_018: [ CommandDecoder_ExecuteMethod shall validate that consecutive segments of the fullMethodName exist in the model. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_019: [ CommandDecoder_ExecuteMethod shall locate the final model to which the methodName applies. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_020: [ CommandDecoder_ExecuteMethod shall verify that the model has a method called methodName. ]*/
-    /*Tests_SRS_COMMAND_DECODER_02_021: [ For every argument of methodName, CommandDecoder_ExecuteMethod shall build an AGENT_DATA_TYPE from the node with the same name from the MULTITREE_HANDLE. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_021: [ For every argument of methodName, CommandDecoder_ExecuteMethod shall build an AGENT_DATA_TYPE from the member with the same name of the JSON object in methodPayload. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_022: [ CommandDecoder_ExecuteMethod shall call methodCallback passing the context, the methodName, number of arguments and the AGENT_DATA_TYPE. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_024: [ Otherwise, CommandDecoder_ExecuteMethod shall return what methodCallback returns. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_027: [ The arguments shall be decoded in a single pass over the JSON object in methodPayload, each member being matched to an argument by name as it is read. ]*/
     TEST_FUNCTION(CommandDecoder_ExecuteMethod_with_1_arg_payload_hapy_path)
     {
         /*this TEST_FUNCTION assumes that there is a method in the root model called "methodA" that takes 1x arguments*/
 
         ///arrange
         size_t one = 1;
-        const char* aValue = "2";
         const char* methodPayload = "{\"a\":2}";
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         umock_c_reset_all_calls();
 
-        CommandDecoder_ExecuteMethod_with_1_arg_payload_inert_path(&one, methodPayload, &aValue);
+        CommandDecoder_ExecuteMethod_with_1_arg_payload_inert_path(&one, methodPayload);
 
         ///act
         METHODRETURN_HANDLE methodReturn = CommandDecoder_ExecuteMethod(commandDecoderHandle, "methodA", methodPayload);
@@ -3683,24 +3699,23 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
 
         ///arrange
         size_t one = 1;
-        const char* aValue = "2";
         const char* methodPayload = "{\"a\":2}";
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         umock_c_reset_all_calls();
 
         umock_c_negative_tests_init();
-        CommandDecoder_ExecuteMethod_with_1_arg_payload_inert_path(&one, methodPayload, &aValue);
+        CommandDecoder_ExecuteMethod_with_1_arg_payload_inert_path(&one, methodPayload);
         umock_c_negative_tests_snapshot();
 
         for (size_t i = 0; i < umock_c_negative_tests_call_count(); i++)
         {
             if (
-                (i != 11)&& /*gballoc_free*/
-                (i != 15) && /*Destroy_AGENT_DATA_TYPE*/
-                (i != 16) && /*gballoc_free*/
+                (i != 13) && /*CodeFirst_GetPrimitiveType*/
                 (i != 17) && /*gballoc_free*/
-                (i != 18) && /*MultiTree_Destroy*/
-                (i != 19)  /*gballoc_free*/
+                (i != 19) && /*Destroy_AGENT_DATA_TYPE*/
+                (i != 20) && /*gballoc_free*/
+                (i != 21) && /*gballoc_free*/
+                (i != 22)  /*gballoc_free*/
                 )
             {
                 umock_c_negative_tests_reset();
@@ -3719,14 +3734,152 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         umock_c_negative_tests_deinit();
     }
 
+    /*Tests_SRS_COMMAND_DECODER_02_023: [ If any of the previous operations fail, then CommandDecoder_ExecuteMethod shall return NULL. ]*/
+    TEST_FUNCTION(CommandDecoder_ExecuteMethod_with_1_arg_and_NULL_payload_fails)
+    {
+        ///arrange
+        size_t one = 1;
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_malloc(1)); /*this is the string "" for relative relativeMethodPath*/
+        STRICT_EXPECTED_CALL(Schema_GetModelMethodByName(TEST_MODEL_HANDLE, "methodA"));
+        STRICT_EXPECTED_CALL(Schema_GetModelMethodArgumentCount(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_argumentCount(&one, sizeof(one));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); /*this is freeing the relativeMethodPath*/
+
+        ///act
+        METHODRETURN_HANDLE methodReturn = CommandDecoder_ExecuteMethod(commandDecoderHandle, "methodA", NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_IS_NULL(methodReturn);
+
+        ///cleanup
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_02_016: [ If methodPayload is not NULL then CommandDecoder_ExecuteMethod shall read methodPayload in place with a JSON_DECODER_READER initialized by JSONDecoder_Reader_Init. ]*/
+    TEST_FUNCTION(CommandDecoder_ExecuteMethod_when_JSONDecoder_Reader_Init_fails_it_fails)
+    {
+        ///arrange
+        const char* methodPayload = "{\"a\":";
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_Init(IGNORED_PTR_ARG, methodPayload))
+            .SetReturn(JSON_DECODER_PARSE_ERROR);
+
+        ///act
+        METHODRETURN_HANDLE methodReturn = CommandDecoder_ExecuteMethod(commandDecoderHandle, "methodA", methodPayload);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_IS_NULL(methodReturn);
+
+        ///cleanup
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_02_027: [ The arguments shall be decoded in a single pass over the JSON object in methodPayload, each member being matched to an argument by name as it is read. ]*/
+    TEST_FUNCTION(CommandDecoder_ExecuteMethod_skips_the_members_that_are_not_arguments)
+    {
+        ///arrange
+        size_t one = 1;
+        const char* methodPayload = "{\"abc\":[1], \"a\":2}";
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_Init(IGNORED_PTR_ARG, methodPayload));
+        STRICT_EXPECTED_CALL(Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_malloc(1)); /*this is the string "" for relative relativeMethodPath*/
+        STRICT_EXPECTED_CALL(Schema_GetModelMethodByName(TEST_MODEL_HANDLE, "methodA"));
+        STRICT_EXPECTED_CALL(Schema_GetModelMethodArgumentCount(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_argumentCount(&one, sizeof(one));
+        STRICT_EXPECTED_CALL(gballoc_calloc(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(const char*)));
+        STRICT_EXPECTED_CALL(Schema_GetModelMethodArgumentByIndex(TEST_MODEL_METHOD_HANDLE, 0))
+            .SetReturn(TEST_METHOD_ARGUMENT_HANDLE_0);
+        STRICT_EXPECTED_CALL(Schema_GetMethodArgumentName(TEST_METHOD_ARGUMENT_HANDLE_0))
+            .SetReturn("a");
+        STRICT_EXPECTED_CALL(Schema_GetMethodArgumentType(TEST_METHOD_ARGUMENT_HANDLE_0))
+            .SetReturn("int");
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_BEGIN_OBJECT);
+        STRICT_EXPECTED_CALL(gballoc_calloc(1, sizeof(bool)));
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NAME_ABC);
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_SkipValue(IGNORED_PTR_ARG));
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NAME_A);
+        STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
+            .SetReturn(EDM_INT32_TYPE);
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NUMBER_2);
+        STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("2", EDM_INT32_TYPE, IGNORED_PTR_ARG));
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_END_OBJECT);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(methodCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "", "methodA", 1, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); /*this is freeing the relativeMethodPath*/
+
+        ///act
+        METHODRETURN_HANDLE methodReturn = CommandDecoder_ExecuteMethod(commandDecoderHandle, "methodA", methodPayload);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(void_ptr, g_methodReturnValue, methodReturn);
+
+        ///cleanup
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_02_023: [ If any of the previous operations fail, then CommandDecoder_ExecuteMethod shall return NULL. ]*/
+    TEST_FUNCTION(CommandDecoder_ExecuteMethod_with_a_missing_argument_fails)
+    {
+        ///arrange
+        size_t one = 1;
+        const char* methodPayload = "{\"abc\":[1]}";
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
 
-    static void CommandDecoder_ExecuteMethod_with_2_arg_payload_inert_path(size_t* two, const char* methodPayload, const char** aValue, const char** bValue)
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_Init(IGNORED_PTR_ARG, methodPayload));
+        STRICT_EXPECTED_CALL(Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_malloc(1)); /*this is the string "" for relative relativeMethodPath*/
+        STRICT_EXPECTED_CALL(Schema_GetModelMethodByName(TEST_MODEL_HANDLE, "methodA"));
+        STRICT_EXPECTED_CALL(Schema_GetModelMethodArgumentCount(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_argumentCount(&one, sizeof(one));
+        STRICT_EXPECTED_CALL(gballoc_calloc(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(const char*)));
+        STRICT_EXPECTED_CALL(Schema_GetModelMethodArgumentByIndex(TEST_MODEL_METHOD_HANDLE, 0))
+            .SetReturn(TEST_METHOD_ARGUMENT_HANDLE_0);
+        STRICT_EXPECTED_CALL(Schema_GetMethodArgumentName(TEST_METHOD_ARGUMENT_HANDLE_0))
+            .SetReturn("a");
+        STRICT_EXPECTED_CALL(Schema_GetMethodArgumentType(TEST_METHOD_ARGUMENT_HANDLE_0))
+            .SetReturn("int");
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_BEGIN_OBJECT);
+        STRICT_EXPECTED_CALL(gballoc_calloc(1, sizeof(bool)));
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NAME_ABC);
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_SkipValue(IGNORED_PTR_ARG));
+        setup_JSONDecoder_Reader_Next(&TEST_TOKEN_END_OBJECT);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); /*this is freeing the relativeMethodPath*/
+
+        ///act
+        METHODRETURN_HANDLE methodReturn = CommandDecoder_ExecuteMethod(commandDecoderHandle, "methodA", methodPayload);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_IS_NULL(methodReturn);
+
+        ///cleanup
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    static void CommandDecoder_ExecuteMethod_with_2_arg_payload_inert_path(size_t* two, const char* methodPayload)
     {
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, methodPayload))
-            .IgnoreArgument_destination();
-        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_MultiTree(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_json()
-            .IgnoreArgument_multiTreeHandle();
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_Init(IGNORED_PTR_ARG, methodPayload));
         STRICT_EXPECTED_CALL(Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         STRICT_EXPECTED_CALL(gballoc_malloc(1)); /*this is the string "" for relative relativeMethodPath*/
         STRICT_EXPECTED_CALL(Schema_GetModelMethodByName(TEST_MODEL_HANDLE, "methodA"));
@@ -3734,8 +3887,9 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
             .CopyOutArgumentBuffer_argumentCount(two, sizeof(*two));
 
         STRICT_EXPECTED_CALL(gballoc_calloc(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(gballoc_malloc(2 * 2 * sizeof(const char*))); /*this is the array holding the argument names and types*/
 
-        { /*scope for processing every individual argument*/
+        { /*scope for getting every individual argument from the schema*/
             STRICT_EXPECTED_CALL(Schema_GetModelMethodArgumentByIndex(TEST_MODEL_METHOD_HANDLE, 0))
                 .SetReturn(TEST_METHOD_ARGUMENT_HANDLE_0);
             STRICT_EXPECTED_CALL(Schema_GetMethodArgumentName(TEST_METHOD_ARGUMENT_HANDLE_0))
@@ -3743,40 +3897,40 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
             STRICT_EXPECTED_CALL(Schema_GetMethodArgumentType(TEST_METHOD_ARGUMENT_HANDLE_0))
                 .SetReturn("int");
 
-            STRICT_EXPECTED_CALL(MultiTree_GetChildByName(IGNORED_PTR_ARG, "a", IGNORED_PTR_ARG))
-                .IgnoreArgument_treeHandle()
-                .IgnoreArgument_childHandle();
-
-            { /*scope for DecodeValueFromNode*/
-                STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
-                    .CallCannotFail()
-                    .SetReturn(EDM_INT32_TYPE);
-                STRICT_EXPECTED_CALL(MultiTree_GetValue(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-                    .CopyOutArgumentBuffer_destination(aValue, sizeof(aValue));
-                STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("2", EDM_INT32_TYPE, IGNORED_PTR_ARG))
-                    .IgnoreArgument_agentData();
-            }
-
             STRICT_EXPECTED_CALL(Schema_GetModelMethodArgumentByIndex(TEST_MODEL_METHOD_HANDLE, 1))
                 .SetReturn(TEST_METHOD_ARGUMENT_HANDLE_1);
             STRICT_EXPECTED_CALL(Schema_GetMethodArgumentName(TEST_METHOD_ARGUMENT_HANDLE_1))
                 .SetReturn("b");
             STRICT_EXPECTED_CALL(Schema_GetMethodArgumentType(TEST_METHOD_ARGUMENT_HANDLE_1))
                 .SetReturn("int");
+        }
 
-            STRICT_EXPECTED_CALL(MultiTree_GetChildByName(IGNORED_PTR_ARG, "b", IGNORED_PTR_ARG))
-                .IgnoreArgument_treeHandle()
-                .IgnoreArgument_childHandle();
+        { /*scope for DecodeMembersFromReader*/
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_BEGIN_OBJECT);
+            STRICT_EXPECTED_CALL(gballoc_calloc(2, sizeof(bool))); /*this is the array of decoded flags*/
+
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NAME_A);
+            { /*scope for DecodeValueFromReader*/
+                STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
+                    .CallCannotFail()
+                    .SetReturn(EDM_INT32_TYPE);
+                setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NUMBER_2);
+                STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("2", EDM_INT32_TYPE, IGNORED_PTR_ARG))
+                    .IgnoreArgument_agentData();
+            }
 
-            { /*scope for DecodeValueFromNode*/
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NAME_B);
+            { /*scope for DecodeValueFromReader*/
                 STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
                     .CallCannotFail()
                     .SetReturn(EDM_INT32_TYPE);
-                STRICT_EXPECTED_CALL(MultiTree_GetValue(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-                    .CopyOutArgumentBuffer_destination(bValue, sizeof(bValue));
-                STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("3", EDM_INT32_TYPE, IGNORED_PTR_ARG)) /*20*/
+                setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NUMBER_3);
+                STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("3", EDM_INT32_TYPE, IGNORED_PTR_ARG))
                     .IgnoreArgument_agentData();
             }
+
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_END_OBJECT);
+            STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); /*this is freeing the decoded flags*/
         }
 
         STRICT_EXPECTED_CALL(methodCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "", "methodA", 2, IGNORED_PTR_ARG))
@@ -3784,21 +3938,18 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
 
         STRICT_EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
         STRICT_EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); /*this is freeing the argument names and types*/
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-
-        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-
     }
 
-    /*Tests_SRS_COMMAND_DECODER_02_016: [ If methodPayload is not NULL then CommandDecoder_ExecuteMethod shall build a MULTITREE_HANDLE out of methodPayload. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_016: [ If methodPayload is not NULL then CommandDecoder_ExecuteMethod shall read methodPayload in place with a JSON_DECODER_READER initialized by JSONDecoder_Reader_Init. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_017: [ CommandDecoder_ExecuteMethod shall get the SCHEMA_HANDLE associated with the modelHandle passed at CommandDecoder_Create. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_018: [ CommandDecoder_ExecuteMethod shall validate that consecutive segments of the fullMethodName exist in the model. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_019: [ CommandDecoder_ExecuteMethod shall locate the final model to which the methodName applies. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_020: [ CommandDecoder_ExecuteMethod shall verify that the model has a method called methodName. ]*/
-    /*Tests_SRS_COMMAND_DECODER_02_021: [ For every argument of methodName, CommandDecoder_ExecuteMethod shall build an AGENT_DATA_TYPE from the node with the same name from the MULTITREE_HANDLE. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_021: [ For every argument of methodName, CommandDecoder_ExecuteMethod shall build an AGENT_DATA_TYPE from the member with the same name of the JSON object in methodPayload. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_022: [ CommandDecoder_ExecuteMethod shall call methodCallback passing the context, the methodName, number of arguments and the AGENT_DATA_TYPE. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_024: [ Otherwise, CommandDecoder_ExecuteMethod shall return what methodCallback returns. ]*/
     TEST_FUNCTION(CommandDecoder_ExecuteMethod_with_2_arg_payload_hapy_path)
@@ -3807,13 +3958,11 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
 
         ///arrange
         size_t two = 2;
-        const char* aValue = "2";
-        const char* bValue = "3";
         const char* methodPayload = "{\"a\":2, \"b\":3}";
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         umock_c_reset_all_calls();
 
-        CommandDecoder_ExecuteMethod_with_2_arg_payload_inert_path(&two, methodPayload, &aValue, &bValue);
+        CommandDecoder_ExecuteMethod_with_2_arg_payload_inert_path(&two, methodPayload);
 
         ///act
         METHODRETURN_HANDLE methodReturn = CommandDecoder_ExecuteMethod(commandDecoderHandle, "methodA", methodPayload);
@@ -3834,14 +3983,12 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
 
         ///arrange
         size_t two = 2;
-        const char* aValue = "2";
-        const char* bValue = "3";
         const char* methodPayload = "{\"a\":2, \"b\":3}";
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         umock_c_reset_all_calls();
 
         umock_c_negative_tests_init();
-        CommandDecoder_ExecuteMethod_with_2_arg_payload_inert_path(&two, methodPayload, &aValue, &bValue);
+        CommandDecoder_ExecuteMethod_with_2_arg_payload_inert_path(&two, methodPayload);
         umock_c_negative_tests_snapshot();
 
         size_t count = umock_c_negative_tests_call_count();
@@ -3865,11 +4012,9 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         umock_c_negative_tests_deinit();
     }
 
-    static void CommandDecoder_ExecuteMethod_model_in_model_with_2_arg_payload_inert_path(size_t* two, const char* methodPayload, const char** aValue, const char** bValue)
+    static void CommandDecoder_ExecuteMethod_model_in_model_with_2_arg_payload_inert_path(size_t* two, const char* methodPayload)
     {
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, methodPayload))
-            .IgnoreArgument_destination();
-        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_MultiTree(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(JSONDecoder_Reader_Init(IGNORED_PTR_ARG, methodPayload));
         STRICT_EXPECTED_CALL(Schema_GetSchemaForModelType(TEST_MODEL_HANDLE));
         STRICT_EXPECTED_CALL(gballoc_malloc(11)); /*this is the string "innermodel" for relative relativeMethodPath*/
         STRICT_EXPECTED_CALL(Schema_GetModelModelByName(TEST_MODEL_HANDLE, "innermodel"));
@@ -3882,8 +4027,9 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
             .CopyOutArgumentBuffer_argumentCount(two, sizeof(*two));
 
         STRICT_EXPECTED_CALL(gballoc_calloc(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(gballoc_malloc(2 * 2 * sizeof(const char*))); /*this is the array holding the argument names and types*/
 
-        { /*scope for processing every individual argument*/
+        { /*scope for getting every individual argument from the schema*/
             STRICT_EXPECTED_CALL(Schema_GetModelMethodArgumentByIndex(TEST_MODEL_METHOD_HANDLE, 0))
                 .SetReturn(TEST_METHOD_ARGUMENT_HANDLE_0);
             STRICT_EXPECTED_CALL(Schema_GetMethodArgumentName(TEST_METHOD_ARGUMENT_HANDLE_0))
@@ -3891,40 +4037,38 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
             STRICT_EXPECTED_CALL(Schema_GetMethodArgumentType(TEST_METHOD_ARGUMENT_HANDLE_0))
                 .SetReturn("int");
 
-            STRICT_EXPECTED_CALL(MultiTree_GetChildByName(IGNORED_PTR_ARG, "a", IGNORED_PTR_ARG))
-                .IgnoreArgument_treeHandle()
-                .IgnoreArgument_childHandle();
-
-            { /*scope for DecodeValueFromNode*/
-                STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
-                    .SetReturn(EDM_INT32_TYPE);
-                STRICT_EXPECTED_CALL(MultiTree_GetValue(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-                    .CopyOutArgumentBuffer_destination(aValue, sizeof(aValue));
-                STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("2", EDM_INT32_TYPE, IGNORED_PTR_ARG))
-                    .IgnoreArgument_agentData();
-            }
-
             STRICT_EXPECTED_CALL(Schema_GetModelMethodArgumentByIndex(TEST_MODEL_METHOD_HANDLE, 1))
                 .SetReturn(TEST_METHOD_ARGUMENT_HANDLE_1);
             STRICT_EXPECTED_CALL(Schema_GetMethodArgumentName(TEST_METHOD_ARGUMENT_HANDLE_1))
                 .SetReturn("b");
             STRICT_EXPECTED_CALL(Schema_GetMethodArgumentType(TEST_METHOD_ARGUMENT_HANDLE_1))
                 .SetReturn("int");
+        }
+
+        { /*scope for DecodeMembersFromReader*/
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_BEGIN_OBJECT);
+            STRICT_EXPECTED_CALL(gballoc_calloc(2, sizeof(bool))); /*this is the array of decoded flags*/
 
-            STRICT_EXPECTED_CALL(MultiTree_GetChildByName(IGNORED_PTR_ARG, "b", IGNORED_PTR_ARG))
-                .IgnoreArgument_treeHandle()
-                .IgnoreArgument_childHandle();
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NAME_A);
+            { /*scope for DecodeValueFromReader*/
+                STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
+                    .SetReturn(EDM_INT32_TYPE).CallCannotFail();
+                setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NUMBER_2);
+                STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("2", EDM_INT32_TYPE, IGNORED_PTR_ARG))
+                    .IgnoreArgument_agentData();
+            }
 
-            { /*scope for DecodeValueFromNode*/
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NAME_B);
+            { /*scope for DecodeValueFromReader*/
                 STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
                     .SetReturn(EDM_INT32_TYPE).CallCannotFail();
-                STRICT_EXPECTED_CALL(MultiTree_GetValue(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-                    .IgnoreArgument_treeHandle()
-                    .IgnoreArgument_destination()
-                    .CopyOutArgumentBuffer_destination(bValue, sizeof(bValue));
-                STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("3", EDM_INT32_TYPE, IGNORED_PTR_ARG)) /*23*/
+                setup_JSONDecoder_Reader_Next(&TEST_TOKEN_NUMBER_3);
+                STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("3", EDM_INT32_TYPE, IGNORED_PTR_ARG))
                     .IgnoreArgument_agentData();
             }
+
+            setup_JSONDecoder_Reader_Next(&TEST_TOKEN_END_OBJECT);
+            STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); /*this is freeing the decoded flags*/
         }
 
         STRICT_EXPECTED_CALL(methodCallbackMock(TEST_CALLBACK_CONTEXT_VALUE, "innermodel", "methodA", 2, IGNORED_PTR_ARG))
@@ -3932,21 +4076,18 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
 
         STRICT_EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
         STRICT_EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); /*this is freeing the argument names and types*/
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-
-        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-
     }
 
-    /*Tests_SRS_COMMAND_DECODER_02_016: [ If methodPayload is not NULL then CommandDecoder_ExecuteMethod shall build a MULTITREE_HANDLE out of methodPayload. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_016: [ If methodPayload is not NULL then CommandDecoder_ExecuteMethod shall read methodPayload in place with a JSON_DECODER_READER initialized by JSONDecoder_Reader_Init. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_017: [ CommandDecoder_ExecuteMethod shall get the SCHEMA_HANDLE associated with the modelHandle passed at CommandDecoder_Create. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_018: [ CommandDecoder_ExecuteMethod shall validate that consecutive segments of the fullMethodName exist in the model. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_019: [ CommandDecoder_ExecuteMethod shall locate the final model to which the methodName applies. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_020: [ CommandDecoder_ExecuteMethod shall verify that the model has a method called methodName. ]*/
-    /*Tests_SRS_COMMAND_DECODER_02_021: [ For every argument of methodName, CommandDecoder_ExecuteMethod shall build an AGENT_DATA_TYPE from the node with the same name from the MULTITREE_HANDLE. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_021: [ For every argument of methodName, CommandDecoder_ExecuteMethod shall build an AGENT_DATA_TYPE from the member with the same name of the JSON object in methodPayload. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_022: [ CommandDecoder_ExecuteMethod shall call methodCallback passing the context, the methodName, number of arguments and the AGENT_DATA_TYPE. ]*/
     /*Tests_SRS_COMMAND_DECODER_02_024: [ Otherwise, CommandDecoder_ExecuteMethod shall return what methodCallback returns. ]*/
     TEST_FUNCTION(CommandDecoder_ExecuteMethod_model_in_model_with_2_arg_payload_hapy_path)
@@ -3955,13 +4096,11 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
 
         ///arrange
         size_t two = 2;
-        const char* aValue = "2";
-        const char* bValue = "3";
         const char* methodPayload = "{\"a\":2, \"b\":3}";
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         umock_c_reset_all_calls();
 
-        CommandDecoder_ExecuteMethod_model_in_model_with_2_arg_payload_inert_path(&two, methodPayload, &aValue, &bValue);
+        CommandDecoder_ExecuteMethod_model_in_model_with_2_arg_payload_inert_path(&two, methodPayload);
 
         ///act
         METHODRETURN_HANDLE methodReturn = CommandDecoder_ExecuteMethod(commandDecoderHandle, "innermodel/methodA", methodPayload);
@@ -3982,14 +4121,12 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
 
         ///arrange
         size_t two = 2;
-        const char* aValue = "2";
-        const char* bValue = "3";
         const char* methodPayload = "{\"a\":2, \"b\":3}";
         COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
         umock_c_reset_all_calls();
 
         umock_c_negative_tests_init();
-        CommandDecoder_ExecuteMethod_model_in_model_with_2_arg_payload_inert_path(&two, methodPayload, &aValue, &bValue);
+        CommandDecoder_ExecuteMethod_model_in_model_with_2_arg_payload_inert_path(&two, methodPayload);
         umock_c_negative_tests_snapshot();
 
         size_t count = umock_c_negative_tests_call_count();
@@ -117,6 +117,8 @@ static AGENT_DATA_TYPE structTypeValue2Members;
 
 static COMPLEX_TYPE_FIELD_TYPE members = { "x", &floatValid };
 static COMPLEX_TYPE_FIELD_TYPE two_members[] = { { "x", &floatValid },{ "y", &intValid } };
+static AGENT_DATA_TYPE structTypeValuePathNames;
+static COMPLEX_TYPE_FIELD_TYPE path_name_members[] = { { "x/a", &floatValid },{ "x/b", &intValid } };
 
 static const SCHEMA_MODEL_TYPE_HANDLE TEST_MODEL_HANDLE = (SCHEMA_MODEL_TYPE_HANDLE)0x4242;
 #define DEFAULT_PROPERTY_NAME "defaultPropertyName"
@@ -167,6 +169,25 @@ static AGENT_DATA_TYPES_RESULT my_AgentDataTypes_ToString(STRING_HANDLE destinat
     return AGENT_DATA_TYPES_OK;
 }
 
+/*the calls made when the JSON object is written without a MultiTree*/
+static void setup_flat_encoding_mocks(const AGENT_DATA_TYPE** values, size_t valueCount)
+{
+    size_t i;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(STRING_new());
+    for (i = 0; i < valueCount; i++)
+    {
+        STRICT_EXPECTED_CALL(AgentDataTypes_ToString(IGNORED_PTR_ARG, values[i]));
+        STRICT_EXPECTED_CALL(STRING_length(IGNORED_PTR_ARG))
+            .CallCannotFail();
+    }
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .CallCannotFail();
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+}
+
 static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 {
     char temp_str[256];
@@ -197,6 +218,9 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         structTypeValue2Members.type = EDM_COMPLEX_TYPE_TYPE;
         structTypeValue2Members.value.edmComplexType.nMembers = COUNT_OF(two_members);
         structTypeValue2Members.value.edmComplexType.fields = two_members;
+        structTypeValuePathNames.type = EDM_COMPLEX_TYPE_TYPE;
+        structTypeValuePathNames.value.edmComplexType.nMembers = COUNT_OF(path_name_members);
+        structTypeValuePathNames.value.edmComplexType.fields = path_name_members;
 
         REGISTER_UMOCK_ALIAS_TYPE(MULTITREE_CLONE_FUNCTION, void*);
         REGISTER_UMOCK_ALIAS_TYPE(MULTITREE_FREE_FUNCTION, void*);
@@ -563,7 +587,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         size_t destinationSize;
         umock_c_reset_all_calls();
 
-        DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &floatValid };
+        DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME_LEVEL2, &floatValid };
 
         EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .SetReturn((MULTITREE_HANDLE)NULL);
@@ -588,13 +612,13 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         size_t destinationSize;
         umock_c_reset_all_calls();
 
-        DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &floatValid };
+        DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME_LEVEL2, &floatValid };
 
         STRICT_EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreArgument_cloneFunction()
             .IgnoreArgument_freeFunction();
 
-        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
+        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME_LEVEL2, &floatValid))
             .IgnoreArgument_treeHandle()
             .SetReturn(MULTITREE_ERROR);
 
@@ -623,7 +647,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         AGENT_DATA_TYPE floatValid2;
 
         DATA_MARSHALLER_VALUE values[2];
-        values[0].PropertyPath = DEFAULT_PROPERTY_NAME;
+        values[0].PropertyPath = DEFAULT_PROPERTY_NAME_LEVEL2;
         values[0].Value = &floatValid;
 
         values[1].PropertyPath = DEFAULT_PROPERTY_NAME_2;
@@ -631,7 +655,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
 
         EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
-        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
+        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME_LEVEL2, &floatValid))
             .IgnoreArgument_treeHandle();
         STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME_2, &floatValid2))
             .IgnoreArgument_treeHandle()
@@ -659,11 +683,11 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         umock_c_reset_all_calls();
         unsigned char* destination;
         size_t destinationSize;
-        DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &floatValid };
+        DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME_LEVEL2, &floatValid };
 
         EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
-        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
+        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME_LEVEL2, &floatValid))
             .IgnoreArgument_treeHandle();
         STRICT_EXPECTED_CALL(STRING_new());
         EXPECTED_CALL(JSONEncoder_EncodeTree(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -690,23 +714,23 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         DataMarshaller_Destroy(handle);
     }
 
-    /* Tests_SRS_DATAMARSHALLER_01_002: [If the includePropertyPath argument passed to DataMarshaller_Create was false and the number of values passed to SendData is greater than 1 and at least one of them is a struct, DataMarshaller_SendData shall fallback to  including the complete property path in the output JSON.] */
+    /* Tests_SRS_DATA_MARSHALLER_99_037:[ Otherwise DataMarshaller shall store as MultiTree the data to be encoded by the JSONEncoder module.] */
     /*Tests_SRS_DATAMARSHALLER_02_007: [DataMarshaller_SendData shall copy in the output parameters *destination, *destinationSize the content and the content length of the encoded JSON tree.] */
-    TEST_FUNCTION(when_includepropertypath_is_false_and_value_count_is_greater_than_1_and_one_of_them_is_a_struct_the_property_path_is_included)
+    TEST_FUNCTION(when_a_property_path_has_several_levels_SendData_encodes_a_MultiTree)
     {
         ///arrange
-        DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, false);
+        DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, true);
         unsigned char* destination;
         size_t destinationSize;
         umock_c_reset_all_calls();
-        DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid }, { DEFAULT_PROPERTY_NAME_2, &structTypeValue } };
+        DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid }, { DEFAULT_PROPERTY_NAME_LEVEL2, &floatValid } };
         char json_payload[] = "Test";
 
         EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
         STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
             .IgnoreArgument_treeHandle();
-        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME_2, &structTypeValue))
+        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME_LEVEL2, &floatValid))
             .IgnoreArgument_treeHandle();
         EXPECTED_CALL(STRING_new());
         EXPECTED_CALL(JSONEncoder_EncodeTree(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -736,95 +760,111 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         ASSERT_ARE_EQUAL(size_t, strlen(json_payload), destinationSize);
         ASSERT_ARE_EQUAL(int, 0, memcmp(destination, json_payload, destinationSize));
 
-
         ///cleanup
         free(destination);
         DataMarshaller_Destroy(handle);
     }
 
-    /*Tests_SRS_DATAMARSHALLER_02_006: [The complete JSON object shall be handed over to IoTHubClient by a call to IoTHubClient_LL_SendEventAsync if parameter transportType of _Create was TRANSPORT_LL.] */
-    TEST_FUNCTION(DataMarshaller_SendData_sends_to_LL_layer_succeeds)
+    /* Tests_SRS_DATA_MARSHALLER_99_037:[ Otherwise DataMarshaller shall store as MultiTree the data to be encoded by the JSONEncoder module.] */
+    TEST_FUNCTION(when_two_properties_have_the_same_name_SendData_encodes_a_MultiTree)
     {
         ///arrange
-        DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, false);
+        DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, true);
         unsigned char* destination;
         size_t destinationSize;
         umock_c_reset_all_calls();
-        DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid }, { DEFAULT_PROPERTY_NAME_2, &structTypeValue } };
-        char json_payload[] = "Test";
+        DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid }, { "/" DEFAULT_PROPERTY_NAME, &intValid } };
 
         EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
         STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
             .IgnoreArgument_treeHandle();
-        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME_2, &structTypeValue))
-            .IgnoreArgument_treeHandle();
-        EXPECTED_CALL(STRING_new());
-        EXPECTED_CALL(JSONEncoder_EncodeTree(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, "/" DEFAULT_PROPERTY_NAME, &intValid))
             .IgnoreArgument_treeHandle()
-            .IgnoreArgument_destination()
-            .IgnoreArgument_toStringFunc();
+            .SetReturn(MULTITREE_ALREADY_HAS_A_VALUE);
+        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG))
+            .IgnoreArgument_treeHandle();
 
-        EXPECTED_CALL(STRING_length(IGNORED_PTR_ARG))
-            .SetReturn(strlen(json_payload));
+        ///act
+        DATA_MARSHALLER_RESULT result = DataMarshaller_SendData(handle, 2, value, &destination, &destinationSize);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument_size();
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_MULTITREE_ERROR, result);
 
-        EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
-            .SetReturn(json_payload);
+        ///cleanup
+        DataMarshaller_Destroy(handle);
+    }
 
-        EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle();
+    /* Tests_SRS_DATAMARSHALLER_01_002: [If the includePropertyPath argument passed to DataMarshaller_Create was false and the number of values passed to SendData is greater than 1 and at least one of them is a struct, DataMarshaller_SendData shall fallback to  including the complete property path in the output JSON.] */
+    /* Tests_SRS_DATA_MARSHALLER_99_050: [ When all the members of the JSON object have names that are not paths, and either all or none of the property paths start with '/', DataMarshaller_SendData shall write the JSON object directly in the destination buffer, without a MultiTree. ]*/
+    /*Tests_SRS_DATAMARSHALLER_02_007: [DataMarshaller_SendData shall copy in the output parameters *destination, *destinationSize the content and the content length of the encoded JSON tree.] */
+    TEST_FUNCTION(when_includepropertypath_is_false_and_value_count_is_greater_than_1_and_one_of_them_is_a_struct_the_property_path_is_included)
+    {
+        ///arrange
+        DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, false);
+        unsigned char* destination;
+        size_t destinationSize;
+        umock_c_reset_all_calls();
+        DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid }, { DEFAULT_PROPERTY_NAME_2, &structTypeValue } };
+        const AGENT_DATA_TYPE* encodedValues[] = { &floatValid, &structTypeValue };
+        const char* json_payload = "{\"" DEFAULT_PROPERTY_NAME "\":2.4, \"" DEFAULT_PROPERTY_NAME_2 "\":2.4}";
+
+        setup_flat_encoding_mocks(encodedValues, 2);
 
         ///act
         DATA_MARSHALLER_RESULT result = DataMarshaller_SendData(handle, 2, value, &destination, &destinationSize);
 
         ///assert
-        ASSERT_ARE_EQUAL(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_OK, result);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_OK, result);
+        ASSERT_ARE_EQUAL(size_t, strlen(json_payload), destinationSize);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(destination, json_payload, destinationSize));
+
 
         ///cleanup
         free(destination);
         DataMarshaller_Destroy(handle);
     }
 
-    /* Tests_SRS_DATAMARSHALLER_01_002: [If the includePropertyPath argument passed to DataMarshaller_Create was false and the number of values passed to SendData is greater than 1 and at least one of them is a struct, DataMarshaller_SendData shall fallback to  including the complete property path in the output JSON.] */
-    TEST_FUNCTION(when_includepropertypath_is_false_and_value_count_is_greater_than_1_and_one_but_no_structs_SendData_succeeds)
+    /*Tests_SRS_DATAMARSHALLER_02_006: [The complete JSON object shall be handed over to IoTHubClient by a call to IoTHubClient_LL_SendEventAsync if parameter transportType of _Create was TRANSPORT_LL.] */
+    TEST_FUNCTION(DataMarshaller_SendData_sends_to_LL_layer_succeeds)
     {
         ///arrange
         DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, false);
         unsigned char* destination;
         size_t destinationSize;
         umock_c_reset_all_calls();
-        DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid }, { DEFAULT_PROPERTY_NAME_2, &floatValid } };
-        char json_payload[] = "Test";
+        DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid }, { DEFAULT_PROPERTY_NAME_2, &structTypeValue } };
+        const AGENT_DATA_TYPE* encodedValues[] = { &floatValid, &structTypeValue };
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        setup_flat_encoding_mocks(encodedValues, 2);
 
-        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
-            .IgnoreArgument_treeHandle();
-        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME_2, &floatValid))
-            .IgnoreArgument_treeHandle();
-        EXPECTED_CALL(STRING_new());
-        EXPECTED_CALL(JSONEncoder_EncodeTree(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle()
-            .IgnoreArgument_destination()
-            .IgnoreArgument_toStringFunc();
+        ///act
+        DATA_MARSHALLER_RESULT result = DataMarshaller_SendData(handle, 2, value, &destination, &destinationSize);
 
-        EXPECTED_CALL(STRING_length(IGNORED_PTR_ARG))
-            .SetReturn(strlen(json_payload));
+        ///assert
+        ASSERT_ARE_EQUAL(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument_size();
+        ///cleanup
+        free(destination);
+        DataMarshaller_Destroy(handle);
+    }
 
-        EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
-            .SetReturn(json_payload);
+    /* Tests_SRS_DATAMARSHALLER_01_002: [If the includePropertyPath argument passed to DataMarshaller_Create was false and the number of values passed to SendData is greater than 1 and at least one of them is a struct, DataMarshaller_SendData shall fallback to  including the complete property path in the output JSON.] */
+    TEST_FUNCTION(when_includepropertypath_is_false_and_value_count_is_greater_than_1_and_one_but_no_structs_SendData_succeeds)
+    {
+        ///arrange
+        DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, false);
+        unsigned char* destination;
+        size_t destinationSize;
+        umock_c_reset_all_calls();
+        DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid }, { DEFAULT_PROPERTY_NAME_2, &floatValid } };
+        const AGENT_DATA_TYPE* encodedValues[] = { &floatValid, &floatValid };
+        const char* json_payload = "{\"" DEFAULT_PROPERTY_NAME "\":2.4, \"" DEFAULT_PROPERTY_NAME_2 "\":2.4}";
 
-        EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle();
+        setup_flat_encoding_mocks(encodedValues, 2);
 
         ///act
         DATA_MARSHALLER_RESULT result = DataMarshaller_SendData(handle, 2, value, &destination, &destinationSize);
@@ -832,6 +872,8 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         ///assert
         ASSERT_ARE_EQUAL(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_OK, result);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, strlen(json_payload), destinationSize);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(destination, json_payload, destinationSize));
 
         ///cleanup
         free(destination);
@@ -847,30 +889,38 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         size_t destinationSize;
         umock_c_reset_all_calls();
         DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &floatValid };
-        char json_payload[] = "Test";
+        const AGENT_DATA_TYPE* encodedValues[] = { &floatValid };
+        const char* json_payload = "{\"" DEFAULT_PROPERTY_NAME "\":2.4}";
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        setup_flat_encoding_mocks(encodedValues, 1);
 
-        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
-            .IgnoreArgument_treeHandle();
-        EXPECTED_CALL(STRING_new());
-        EXPECTED_CALL(JSONEncoder_EncodeTree(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle()
-            .IgnoreArgument_destination()
-            .IgnoreArgument_toStringFunc();
+        ///act
+        DATA_MARSHALLER_RESULT result = DataMarshaller_SendData(handle, 1, &value, &destination, &destinationSize);
 
-        EXPECTED_CALL(STRING_length(IGNORED_PTR_ARG))
-            .SetReturn(strlen(json_payload));
+        ///assert
+        ASSERT_ARE_EQUAL(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, strlen(json_payload), destinationSize);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(destination, json_payload, destinationSize));
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument_size();
+        ///cleanup
+        free(destination);
+        DataMarshaller_Destroy(handle);
+    }
 
-        EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
-            .SetReturn(json_payload);
+    /* Tests_SRS_DATA_MARSHALLER_99_039:[ If the includePropertyPath argument passed to DataMarshaller_Create was true each property shall be placed in the appropriate position in the JSON according to its path in the model.] */
+    TEST_FUNCTION(a_leading_slash_is_not_part_of_the_property_name)
+    {
+        ///arrange
+        DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, true);
+        unsigned char* destination;
+        size_t destinationSize;
+        umock_c_reset_all_calls();
+        DATA_MARSHALLER_VALUE value = { "/" DEFAULT_PROPERTY_NAME, &floatValid };
+        const AGENT_DATA_TYPE* encodedValues[] = { &floatValid };
+        const char* json_payload = "{\"" DEFAULT_PROPERTY_NAME "\":2.4}";
 
-        EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle();
+        setup_flat_encoding_mocks(encodedValues, 1);
 
         ///act
         DATA_MARSHALLER_RESULT result = DataMarshaller_SendData(handle, 1, &value, &destination, &destinationSize);
@@ -878,6 +928,36 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         ///assert
         ASSERT_ARE_EQUAL(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_OK, result);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, strlen(json_payload), destinationSize);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(destination, json_payload, destinationSize));
+
+        ///cleanup
+        free(destination);
+        DataMarshaller_Destroy(handle);
+    }
+
+    /* Tests_SRS_DATA_MARSHALLER_99_050: [ When all the members of the JSON object have names that are not paths, and either all or none of the property paths start with '/', DataMarshaller_SendData shall write the JSON object directly in the destination buffer, without a MultiTree. ]*/
+    TEST_FUNCTION(when_every_property_path_has_a_leading_slash_SendData_writes_the_JSON_object_directly)
+    {
+        ///arrange
+        DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, true);
+        unsigned char* destination;
+        size_t destinationSize;
+        umock_c_reset_all_calls();
+        DATA_MARSHALLER_VALUE value[] = { { "/" DEFAULT_PROPERTY_NAME, &floatValid }, { "/" DEFAULT_PROPERTY_NAME_2, &intValid } };
+        const AGENT_DATA_TYPE* encodedValues[] = { &floatValid, &intValid };
+        const char* json_payload = "{\"" DEFAULT_PROPERTY_NAME "\":2.4, \"" DEFAULT_PROPERTY_NAME_2 "\":2.4}";
+
+        setup_flat_encoding_mocks(encodedValues, 2);
+
+        ///act
+        DATA_MARSHALLER_RESULT result = DataMarshaller_SendData(handle, 2, value, &destination, &destinationSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, strlen(json_payload), destinationSize);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(destination, json_payload, destinationSize));
 
         ///cleanup
         free(destination);
@@ -894,31 +974,10 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         size_t destinationSize;
         umock_c_reset_all_calls();
         DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &structTypeValue2Members };
-        char json_payload[] = "Test";
+        const AGENT_DATA_TYPE* encodedValues[] = { structTypeValue2Members.value.edmComplexType.fields[0].value, structTypeValue2Members.value.edmComplexType.fields[1].value };
+        const char* json_payload = "{\"x\":2.4, \"y\":2.4}";
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-
-        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, "x", structTypeValue2Members.value.edmComplexType.fields[0].value))
-            .IgnoreArgument_treeHandle();
-        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, "y", structTypeValue2Members.value.edmComplexType.fields[1].value))
-            .IgnoreArgument_treeHandle();
-        EXPECTED_CALL(STRING_new());
-        EXPECTED_CALL(JSONEncoder_EncodeTree(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle()
-            .IgnoreArgument_destination()
-            .IgnoreArgument_toStringFunc();
-
-        EXPECTED_CALL(STRING_length(IGNORED_PTR_ARG))
-            .SetReturn(strlen(json_payload));
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument_size();
-
-        EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
-            .SetReturn(json_payload);
-        EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle();
+        setup_flat_encoding_mocks(encodedValues, 2);
 
         ///act
         DATA_MARSHALLER_RESULT result = DataMarshaller_SendData(handle, 1, &value, &destination, &destinationSize);
@@ -926,6 +985,8 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         ///assert
         ASSERT_ARE_EQUAL(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_OK, result);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, strlen(json_payload), destinationSize);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(destination, json_payload, destinationSize));
 
         ///cleanup
         free(destination);
@@ -940,11 +1001,11 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         unsigned char* destination;
         size_t destinationSize;
         umock_c_reset_all_calls();
-        DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &structTypeValue2Members };
+        DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &structTypeValuePathNames };
 
         EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
-        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, "x", structTypeValue2Members.value.edmComplexType.fields[0].value))
+        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, "x/a", structTypeValuePathNames.value.edmComplexType.fields[0].value))
             .IgnoreArgument_treeHandle()
             .SetReturn(MULTITREE_ERROR);
 
@@ -970,13 +1031,13 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         unsigned char* destination;
         size_t destinationSize;
         umock_c_reset_all_calls();
-        DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &structTypeValue2Members };
+        DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &structTypeValuePathNames };
 
         EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
-        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, "x", structTypeValue2Members.value.edmComplexType.fields[0].value))
+        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, "x/a", structTypeValuePathNames.value.edmComplexType.fields[0].value))
             .IgnoreArgument_treeHandle();
-        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, "y", structTypeValue2Members.value.edmComplexType.fields[1].value))
+        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, "x/b", structTypeValuePathNames.value.edmComplexType.fields[1].value))
             .IgnoreArgument_treeHandle()
             .SetReturn(MULTITREE_ERROR);
 
@@ -1004,14 +1065,10 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         umock_c_reset_all_calls();
         DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &floatValid };
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-
-        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
-            .IgnoreArgument_treeHandle();
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
         EXPECTED_CALL(STRING_new())
             .SetReturn(NULL);
-        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_treeHandle();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
         ///act
         DATA_MARSHALLER_RESULT result = DataMarshaller_SendData(handle, 1, &value, &destination, &destinationSize);
@@ -1024,6 +1081,48 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         DataMarshaller_Destroy(handle);
     }
 
+    /* Tests_SRS_DATA_MARSHALLER_99_036:[ DATA_MARSHALLER_AGENT_DATA_TYPES_ERROR shall be returned in case any AgentTypeSystem APIs fails.]*/
+    /* Tests_SRS_DATA_MARSHALLER_99_015:[ DATA_MARSHALLER_ERROR shall be returned in all the other error cases not explicitly defined here.]*/
+    TEST_FUNCTION(when_a_call_in_the_direct_encoding_fails_SendData_fails)
+    {
+        ///arrange
+        DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, true);
+        DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid }, { DEFAULT_PROPERTY_NAME_2, &intValid } };
+        const AGENT_DATA_TYPE* encodedValues[] = { &floatValid, &intValid };
+        size_t i;
+        umock_c_reset_all_calls();
+
+        ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+
+        setup_flat_encoding_mocks(encodedValues, 2);
+
+        umock_c_negative_tests_snapshot();
+
+        for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+        {
+            if (umock_c_negative_tests_can_call_fail(i))
+            {
+                unsigned char* destination;
+                size_t destinationSize;
+                char temp_str[128];
+
+                umock_c_negative_tests_reset();
+                umock_c_negative_tests_fail_call(i);
+
+                ///act
+                DATA_MARSHALLER_RESULT result = DataMarshaller_SendData(handle, 2, value, &destination, &destinationSize);
+
+                ///assert
+                (void)sprintf(temp_str, "On failed call %lu", (unsigned long)i);
+                ASSERT_ARE_NOT_EQUAL(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_OK, result, temp_str);
+            }
+        }
+
+        ///cleanup
+        umock_c_negative_tests_deinit();
+        DataMarshaller_Destroy(handle);
+    }
+
     /*Tests_SRS_DATA_MARSHALLER_02_021: [ If argument dataMarshallerHandle is NULL then DataMarshaller_SendData_ReportedProperties shall fail and return DATA_MARSHALLER_INVALID_ARG. ]*/
     TEST_FUNCTION(DataMarshaller_SendData_ReportedProperties_with_NULL_dataMarshallerHandle_fails)
     {
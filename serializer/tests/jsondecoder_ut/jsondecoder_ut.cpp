@@ -2,6 +2,7 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <cstdlib>
+#include <cstring>
 #include "testrunnerswitcher.h"
 #include "micromock.h"
 #include "micromockcharstararenullterminatedstrings.h"
@@ -42,7 +43,8 @@ MICROMOCK_ENUM_TO_STRING(JSON_DECODER_RESULT_TAG,
     L"JSON_DECODER_INVALID_ARG",
     L"JSON_DECODER_PARSE_ERROR",
     L"JSON_DECODER_MULTITREE_FAILED",
-    L"JSON_DECODER_ERROR");
+    L"JSON_DECODER_ERROR",
+    L"JSON_DECODER_MEMBER_NOT_FOUND");
 
 static MICROMOCK_MUTEX_HANDLE g_testByTest;
 
@@ -2583,4 +2585,280 @@ TEST_FUNCTION(JSONDecoder_When_String_Has_Several_Escaped_Chars_Decoding_Succeed
     TestSpecialCharacter_Success(json);
 }
 
+static void AssertToken(const JSON_DECODER_TOKEN* token, JSON_DECODER_TOKEN_TYPE expectedType, const char* expectedText)
+{
+    ASSERT_ARE_EQUAL(int, (int)expectedType, (int)token->type);
+    ASSERT_ARE_EQUAL(size_t, strlen(expectedText), token->length);
+    ASSERT_ARE_EQUAL(int, 0, strncmp(expectedText, token->text, token->length));
+}
+
+static void AssertNextToken(JSON_DECODER_READER* reader, JSON_DECODER_TOKEN_TYPE expectedType, const char* expectedText)
+{
+    JSON_DECODER_TOKEN token;
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, JSONDecoder_Reader_Next(reader, &token));
+    AssertToken(&token, expectedType, expectedText);
+}
+
+/* Tests_SRS_JSON_DECODER_99_059: [ If reader or json is NULL then JSONDecoder_Reader_Init shall fail and return JSON_DECODER_INVALID_ARG. ]*/
+TEST_FUNCTION(JSONDecoder_Reader_Init_with_NULL_reader_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_Reader_Init(NULL, emptyJSONobject);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_INVALID_ARG, result);
+}
+
+/* Tests_SRS_JSON_DECODER_99_059: [ If reader or json is NULL then JSONDecoder_Reader_Init shall fail and return JSON_DECODER_INVALID_ARG. ]*/
+TEST_FUNCTION(JSONDecoder_Reader_Init_with_NULL_json_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    JSON_DECODER_READER reader;
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_Reader_Init(&reader, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_INVALID_ARG, result);
+}
+
+/* Tests_SRS_JSON_DECODER_99_060: [ JSONDecoder_Reader_Init shall read the complete json, without allocating, and fail with the error JSONDecoder_Reader_Next would return if json is malformed, so that no caller acts on a document that turns out to be malformed. ]*/
+TEST_FUNCTION(JSONDecoder_Reader_Init_with_malformed_json_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    JSON_DECODER_READER reader;
+    const char* malformedJSONs[] = { "", " ", "a", "{", "{\"a\"}", "{\"a\":1,}", "{\"a\":1 \"b\":2}", "[1,2", "[1]]", "{\"a\":tru}", "{\"a\":\"b}" };
+
+    for (size_t i = 0; i < sizeof(malformedJSONs) / sizeof(malformedJSONs[0]); i++)
+    {
+        ///act
+        JSON_DECODER_RESULT result = JSONDecoder_Reader_Init(&reader, malformedJSONs[i]);
+
+        ///assert
+        ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_PARSE_ERROR, result);
+    }
+}
+
+/* Tests_SRS_JSON_DECODER_99_063: [ After the root object or array has ended JSONDecoder_Reader_Next shall produce JSON_DECODER_TOKEN_END_OF_DOCUMENT. ]*/
+/* Tests_SRS_JSON_DECODER_99_066: [ JSONDecoder_Reader_Next shall produce the next token of the JSON in token and advance the reader past it. ]*/
+/* Tests_SRS_JSON_DECODER_99_067: [ Curly brackets and square brackets shall produce the BEGIN_ and END_ OBJECT and ARRAY tokens, member names JSON_DECODER_TOKEN_NAME, strings JSON_DECODER_TOKEN_STRING, numbers JSON_DECODER_TOKEN_NUMBER and true, false and null JSON_DECODER_TOKEN_LITERAL. ]*/
+TEST_FUNCTION(JSONDecoder_Reader_Next_produces_all_the_tokens)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    JSON_DECODER_READER reader;
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, JSONDecoder_Reader_Init(&reader, " { \"a\" : [ 1, -2.5e3, true, false, null ], \"b\" : { } } "));
+
+    ///act + assert
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_BEGIN_OBJECT, "{");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_NAME, "a");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_BEGIN_ARRAY, "[");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_NUMBER, "1");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_NUMBER, "-2.5e3");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_LITERAL, "true");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_LITERAL, "false");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_LITERAL, "null");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_END_ARRAY, "]");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_NAME, "b");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_BEGIN_OBJECT, "{");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_END_OBJECT, "}");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_END_OBJECT, "}");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_END_OF_DOCUMENT, "");
+}
+
+/* Tests_SRS_JSON_DECODER_99_061: [ For a JSON_DECODER_TOKEN_NAME token the text shall not include the quotation marks. ]*/
+/* Tests_SRS_JSON_DECODER_99_062: [ For a JSON_DECODER_TOKEN_STRING token the text shall include the quotation marks and the escape sequences as they appear in the JSON. ]*/
+TEST_FUNCTION(JSONDecoder_Reader_Next_produces_the_text_of_names_and_strings)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    JSON_DECODER_READER reader;
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, JSONDecoder_Reader_Init(&reader, "{\"$version\":\"a\\\"b\\t\"}"));
+
+    ///act + assert
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_BEGIN_OBJECT, "{");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_NAME, "$version");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_STRING, "\"a\\\"b\\t\"");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_END_OBJECT, "}");
+}
+
+/* Tests_SRS_JSON_DECODER_99_065: [ If reader or token is NULL then JSONDecoder_Reader_Next shall fail and return JSON_DECODER_INVALID_ARG. ]*/
+TEST_FUNCTION(JSONDecoder_Reader_Next_with_NULL_arguments_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    JSON_DECODER_READER reader;
+    JSON_DECODER_TOKEN token;
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, JSONDecoder_Reader_Init(&reader, emptyJSONobject));
+
+    ///act
+    JSON_DECODER_RESULT result1 = JSONDecoder_Reader_Next(NULL, &token);
+    JSON_DECODER_RESULT result2 = JSONDecoder_Reader_Next(&reader, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_INVALID_ARG, result1);
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_INVALID_ARG, result2);
+}
+
+static void BuildNestedArrays(char* json, size_t depth)
+{
+    for (size_t i = 0; i < depth; i++)
+    {
+        json[i] = '[';
+        json[depth + i] = ']';
+    }
+    json[2 * depth] = '\0';
+}
+
+/* Tests_SRS_JSON_DECODER_99_068: [ If the JSON nests objects and arrays deeper than JSON_DECODER_READER_MAX_NESTING levels then JSONDecoder_Reader_Next shall fail and return JSON_DECODER_ERROR. ]*/
+TEST_FUNCTION(JSONDecoder_Reader_Init_with_json_nested_too_deep_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    JSON_DECODER_READER reader;
+    char deepest[2 * JSON_DECODER_READER_MAX_NESTING + 1];
+    char tooDeep[2 * (JSON_DECODER_READER_MAX_NESTING + 1) + 1];
+    BuildNestedArrays(deepest, JSON_DECODER_READER_MAX_NESTING);
+    BuildNestedArrays(tooDeep, JSON_DECODER_READER_MAX_NESTING + 1);
+
+    ///act
+    JSON_DECODER_RESULT result1 = JSONDecoder_Reader_Init(&reader, deepest);
+    JSON_DECODER_RESULT result2 = JSONDecoder_Reader_Init(&reader, tooDeep);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, result1);
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_ERROR, result2);
+}
+
+/* Tests_SRS_JSON_DECODER_99_069: [ If reader is NULL then JSONDecoder_Reader_SkipValue shall fail and return JSON_DECODER_INVALID_ARG. ]*/
+TEST_FUNCTION(JSONDecoder_Reader_SkipValue_with_NULL_reader_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_Reader_SkipValue(NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_INVALID_ARG, result);
+}
+
+/* Tests_SRS_JSON_DECODER_99_071: [ JSONDecoder_Reader_SkipValue shall advance the reader past the next value, including all the members or elements of an object or array. ]*/
+TEST_FUNCTION(JSONDecoder_Reader_SkipValue_skips_nested_values)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    JSON_DECODER_READER reader;
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, JSONDecoder_Reader_Init(&reader, "{\"a\":{\"b\":[1,{\"c\":\"}\"}],\"d\":2},\"e\":3,\"f\":4}"));
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_BEGIN_OBJECT, "{");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_NAME, "a");
+
+    ///act
+    JSON_DECODER_RESULT result1 = JSONDecoder_Reader_SkipValue(&reader);
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_NAME, "e");
+    JSON_DECODER_RESULT result2 = JSONDecoder_Reader_SkipValue(&reader);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, result1);
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, result2);
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_NAME, "f");
+}
+
+/* Tests_SRS_JSON_DECODER_99_070: [ If the next token is not the start of a value then JSONDecoder_Reader_SkipValue shall fail and return JSON_DECODER_ERROR without advancing the reader. ]*/
+TEST_FUNCTION(JSONDecoder_Reader_SkipValue_before_a_name_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    JSON_DECODER_READER reader;
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, JSONDecoder_Reader_Init(&reader, "{\"a\":1}"));
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_BEGIN_OBJECT, "{");
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_Reader_SkipValue(&reader);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_ERROR, result);
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_NAME, "a");
+}
+
+/* Tests_SRS_JSON_DECODER_99_072: [ If objectReader, name or memberReader is NULL then JSONDecoder_Reader_GetMember shall fail and return JSON_DECODER_INVALID_ARG. ]*/
+TEST_FUNCTION(JSONDecoder_Reader_GetMember_with_NULL_arguments_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    JSON_DECODER_READER reader;
+    JSON_DECODER_READER memberReader;
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, JSONDecoder_Reader_Init(&reader, "{\"a\":1}"));
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_BEGIN_OBJECT, "{");
+
+    ///act
+    JSON_DECODER_RESULT result1 = JSONDecoder_Reader_GetMember(NULL, "a", &memberReader);
+    JSON_DECODER_RESULT result2 = JSONDecoder_Reader_GetMember(&reader, NULL, &memberReader);
+    JSON_DECODER_RESULT result3 = JSONDecoder_Reader_GetMember(&reader, "a", NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_INVALID_ARG, result1);
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_INVALID_ARG, result2);
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_INVALID_ARG, result3);
+}
+
+/* Tests_SRS_JSON_DECODER_99_073: [ JSONDecoder_Reader_GetMember shall scan the remaining members of the object objectReader is in, skipping their values, without advancing objectReader. ]*/
+/* Tests_SRS_JSON_DECODER_99_074: [ When a member called name is found then JSONDecoder_Reader_GetMember shall position memberReader before its value and return JSON_DECODER_OK. ]*/
+TEST_FUNCTION(JSONDecoder_Reader_GetMember_finds_a_member_after_nested_values)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    JSON_DECODER_READER reader;
+    JSON_DECODER_READER memberReader;
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, JSONDecoder_Reader_Init(&reader, "{\"reported\":{\"b\":[{\"b\":1}]},\"b\":\"x\"}"));
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_BEGIN_OBJECT, "{");
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_Reader_GetMember(&reader, "b", &memberReader);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, result);
+    AssertNextToken(&memberReader, JSON_DECODER_TOKEN_STRING, "\"x\"");
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_NAME, "reported");
+}
+
+/* Tests_SRS_JSON_DECODER_99_075: [ If the member is not found before the end of the object then JSONDecoder_Reader_GetMember shall return JSON_DECODER_MEMBER_NOT_FOUND. ]*/
+TEST_FUNCTION(JSONDecoder_Reader_GetMember_with_no_such_member_returns_MEMBER_NOT_FOUND)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    JSON_DECODER_READER reader;
+    JSON_DECODER_READER memberReader;
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, JSONDecoder_Reader_Init(&reader, "{\"a\":{\"desired\":1}}"));
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_BEGIN_OBJECT, "{");
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_Reader_GetMember(&reader, "desired", &memberReader);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_MEMBER_NOT_FOUND, result);
+}
+
+/* Tests_SRS_JSON_DECODER_99_076: [ If objectReader is not positioned before a member or the end of an object then JSONDecoder_Reader_GetMember shall fail and return JSON_DECODER_ERROR. ]*/
+TEST_FUNCTION(JSONDecoder_Reader_GetMember_in_an_array_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    JSON_DECODER_READER reader;
+    JSON_DECODER_READER memberReader;
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, JSONDecoder_Reader_Init(&reader, "[{\"a\":1}]"));
+    AssertNextToken(&reader, JSON_DECODER_TOKEN_BEGIN_ARRAY, "[");
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_Reader_GetMember(&reader, "a", &memberReader);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_ERROR, result);
+}
+
 END_TEST_SUITE(JSONDecoder_ut)
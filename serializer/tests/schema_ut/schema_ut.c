@@ -1089,6 +1089,45 @@ BEGIN_TEST_SUITE(Schema_ut)
         Schema_Destroy(schemaHandle);
     }
 
+    /* the calls made by Schema_BuildNameIndexes to build the name index of a model */
+    static void Schema_BuildModelNameIndex_inert_path(size_t methodCount, size_t desiredPropertyCount, size_t reportedPropertyCount, size_t modelCount)
+    {
+        size_t i;
+
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG)) /*methods*/
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG)) /*desired properties*/
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG)) /*reported properties*/
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG)) /*models in model*/
+            .IgnoreArgument_handle();
+
+        STRICT_EXPECTED_CALL(gballoc_calloc(IGNORED_NUM_ARG, IGNORED_NUM_ARG))
+            .IgnoreAllArguments();
+
+        for (i = 0; i < methodCount; i++)
+        {
+            STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, i))
+                .IgnoreArgument_handle();
+        }
+        for (i = 0; i < desiredPropertyCount; i++)
+        {
+            STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, i))
+                .IgnoreArgument_handle();
+        }
+        for (i = 0; i < reportedPropertyCount; i++)
+        {
+            STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, i))
+                .IgnoreArgument_handle();
+        }
+        for (i = 0; i < modelCount; i++)
+        {
+            STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, i))
+                .IgnoreArgument_handle();
+        }
+    }
+
     /* Schema_GetModelByName */
 
     /* Tests_SRS_SCHEMA_99_125: [Schema_GetModelByName shall return NULL if unable to find a matching model, or if any of the arguments are NULL.] */
@@ -1179,6 +1218,182 @@ BEGIN_TEST_SUITE(Schema_ut)
         Schema_Destroy(schemaHandle);
     }
 
+    /* Tests_SRS_SCHEMA_99_185: [ Looking up a model or a struct type of a schema by name shall use the hash index of the names of the schema built by Schema_BuildNameIndexes. The index is dropped whenever a model or a struct type is added to the schema. ]*/
+    TEST_FUNCTION(Schema_GetModelByName_uses_the_name_index_of_the_schema)
+    {
+        // arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        SCHEMA_MODEL_TYPE_HANDLE model1 = Schema_CreateModelType(schemaHandle, "ModelName1");
+        SCHEMA_MODEL_TYPE_HANDLE model2 = Schema_CreateModelType(schemaHandle, "ModelName2");
+        (void)Schema_BuildNameIndexes(schemaHandle);
+        umock_c_reset_all_calls();
+
+        // act
+        SCHEMA_MODEL_TYPE_HANDLE result1 = Schema_GetModelByName(schemaHandle, "ModelName1");
+        SCHEMA_MODEL_TYPE_HANDLE result2 = Schema_GetModelByName(schemaHandle, "ModelName2");
+        SCHEMA_MODEL_TYPE_HANDLE result3 = Schema_GetModelByName(schemaHandle, "ModelName3");
+
+        // assert
+        ASSERT_ARE_EQUAL(void_ptr, (void*)model1, (void*)result1);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)model2, (void*)result2);
+        ASSERT_IS_NULL(result3);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_99_185: [ Looking up a model or a struct type of a schema by name shall use the hash index of the names of the schema built by Schema_BuildNameIndexes. The index is dropped whenever a model or a struct type is added to the schema. ]*/
+    /* Tests_SRS_SCHEMA_99_186: [ If the hash index is not built then the lookup shall search the elements linearly. ]*/
+    TEST_FUNCTION(Schema_GetModelByName_finds_a_model_created_after_the_name_index_is_built)
+    {
+        // arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        (void)Schema_CreateModelType(schemaHandle, "ModelName1");
+        (void)Schema_BuildNameIndexes(schemaHandle);
+        SCHEMA_MODEL_TYPE_HANDLE model2 = Schema_CreateModelType(schemaHandle, "ModelName2");
+        SCHEMA_STRUCT_TYPE_HANDLE structType = Schema_CreateStructType(schemaHandle, "ModelName2");
+
+        // act
+        SCHEMA_MODEL_TYPE_HANDLE result = Schema_GetModelByName(schemaHandle, "ModelName2");
+        SCHEMA_STRUCT_TYPE_HANDLE structResult = Schema_GetStructTypeByName(schemaHandle, "ModelName2");
+
+        // assert
+        ASSERT_ARE_EQUAL(void_ptr, (void*)model2, (void*)result);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)structType, (void*)structResult);
+
+        // cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Schema_BuildNameIndexes */
+
+    /* Tests_SRS_SCHEMA_99_187: [ If schemaHandle is NULL, Schema_BuildNameIndexes shall fail and return SCHEMA_INVALID_ARG. ]*/
+    TEST_FUNCTION(Schema_BuildNameIndexes_with_NULL_schemaHandle_fails)
+    {
+        // arrange
+
+        // act
+        SCHEMA_RESULT result = Schema_BuildNameIndexes(NULL);
+
+        // assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_SCHEMA_99_188: [ Schema_BuildNameIndexes shall build the hash index of the names of the schema and the hash index of the names of each of its models, keeping the indexes that are already built. ]*/
+    /* Tests_SRS_SCHEMA_99_190: [ On success, Schema_BuildNameIndexes shall return SCHEMA_OK. ]*/
+    TEST_FUNCTION(Schema_BuildNameIndexes_builds_the_name_indexes_of_the_schema_and_of_its_models)
+    {
+        // arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        SCHEMA_MODEL_TYPE_HANDLE model1 = Schema_CreateModelType(schemaHandle, "ModelName1");
+        SCHEMA_MODEL_TYPE_HANDLE model2 = Schema_CreateModelType(schemaHandle, "ModelName2");
+        (void)Schema_CreateModelMethod(model1, "method");
+        (void)Schema_AddModelModel(model1, "inner", model2, 0, NULL);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_calloc(IGNORED_NUM_ARG, IGNORED_NUM_ARG)) /*name index of the schema*/
+            .IgnoreAllArguments();
+        Schema_BuildModelNameIndex_inert_path(1, 0, 0, 1);
+        Schema_BuildModelNameIndex_inert_path(0, 0, 0, 0);
+
+        // act
+        SCHEMA_RESULT result = Schema_BuildNameIndexes(schemaHandle);
+
+        // assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(void_ptr, (void*)model2, (void*)Schema_GetModelByName(schemaHandle, "ModelName2"));
+        ASSERT_IS_NOT_NULL(Schema_GetModelMethodByName(model1, "method"));
+        ASSERT_ARE_EQUAL(void_ptr, (void*)model2, (void*)Schema_GetModelModelByName(model1, "inner"));
+
+        // cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_99_188: [ Schema_BuildNameIndexes shall build the hash index of the names of the schema and the hash index of the names of each of its models, keeping the indexes that are already built. ]*/
+    TEST_FUNCTION(Schema_BuildNameIndexes_keeps_the_name_indexes_already_built)
+    {
+        // arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        (void)Schema_CreateModelType(schemaHandle, "ModelName1");
+        (void)Schema_BuildNameIndexes(schemaHandle);
+        umock_c_reset_all_calls();
+
+        // act
+        SCHEMA_RESULT result = Schema_BuildNameIndexes(schemaHandle);
+
+        // assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_99_189: [ If any index cannot be built, Schema_BuildNameIndexes shall still build the other indexes and return SCHEMA_ERROR. ]*/
+    /* Tests_SRS_SCHEMA_99_186: [ If the hash index is not built then the lookup shall search the elements linearly. ]*/
+    TEST_FUNCTION(Schema_BuildNameIndexes_fails_when_building_the_name_index_of_the_schema_fails)
+    {
+        // arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        SCHEMA_MODEL_TYPE_HANDLE model = Schema_CreateModelType(schemaHandle, "ModelName1");
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_calloc(IGNORED_NUM_ARG, IGNORED_NUM_ARG))
+            .IgnoreAllArguments()
+            .SetReturn(NULL);
+        Schema_BuildModelNameIndex_inert_path(0, 0, 0, 0);
+
+        // act
+        SCHEMA_RESULT result = Schema_BuildNameIndexes(schemaHandle);
+
+        // assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(void_ptr, (void*)model, (void*)Schema_GetModelByName(schemaHandle, "ModelName1"));
+
+        // cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_99_189: [ If any index cannot be built, Schema_BuildNameIndexes shall still build the other indexes and return SCHEMA_ERROR. ]*/
+    /* Tests_SRS_SCHEMA_99_186: [ If the hash index is not built then the lookup shall search the elements linearly. ]*/
+    TEST_FUNCTION(Schema_BuildNameIndexes_fails_when_building_the_name_index_of_a_model_fails)
+    {
+        // arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        SCHEMA_MODEL_TYPE_HANDLE model = Schema_CreateModelType(schemaHandle, "ModelName1");
+        (void)Schema_CreateModelMethod(model, "method");
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_calloc(IGNORED_NUM_ARG, IGNORED_NUM_ARG)) /*name index of the schema*/
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(gballoc_calloc(IGNORED_NUM_ARG, IGNORED_NUM_ARG)) /*name index of the model*/
+            .IgnoreAllArguments()
+            .SetReturn(NULL);
+
+        // act
+        SCHEMA_RESULT result = Schema_BuildNameIndexes(schemaHandle);
+
+        // assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_IS_NOT_NULL(Schema_GetModelMethodByName(model, "method"));
+
+        // cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
     /* Schema_GetModelByIndex */
 
     /* Tests_SRS_SCHEMA_99_128: [Schema_GetModelByIndex shall return NULL if the index specified is outside the valid range or if schemaHandle argument is NULL.] */
@@ -4288,17 +4503,15 @@ BEGIN_TEST_SUITE(Schema_ut)
         SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
         SCHEMA_MODEL_TYPE_HANDLE modelType = Schema_CreateModelType(schemaHandle, "Model");
         (void)Schema_AddModelReportedProperty(modelType, "a", "b");
+        (void)Schema_BuildNameIndexes(schemaHandle);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, "a"))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred();
-
         ///act
         SCHEMA_REPORTED_PROPERTY_HANDLE result = Schema_GetModelReportedPropertyByName(modelType, "a");
 
         ///assert
         ASSERT_IS_NOT_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///clean
         Schema_Destroy(schemaHandle);
@@ -4311,17 +4524,15 @@ BEGIN_TEST_SUITE(Schema_ut)
         SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
         SCHEMA_MODEL_TYPE_HANDLE modelType = Schema_CreateModelType(schemaHandle, "Model");
         (void)Schema_AddModelReportedProperty(modelType, "a", "b");
+        (void)Schema_BuildNameIndexes(schemaHandle);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, "a"))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred();
-
         ///act
         SCHEMA_REPORTED_PROPERTY_HANDLE result = Schema_GetModelReportedPropertyByName(modelType, "it_wasn_t_me");
 
         ///assert
         ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///clean
         Schema_Destroy(schemaHandle);
@@ -4931,13 +5142,10 @@ BEGIN_TEST_SUITE(Schema_ut)
         ///arrange
         SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
         SCHEMA_MODEL_TYPE_HANDLE modelType = Schema_CreateModelType(schemaHandle, "Model");
+        (void)Schema_BuildNameIndexes(schemaHandle);
         umock_c_reset_all_calls();
         const char* desiredPropertyName = "a";
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, desiredPropertyName))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred();
-
         ///act
         SCHEMA_DESIRED_PROPERTY_HANDLE result = Schema_GetModelDesiredPropertyByName(modelType, desiredPropertyName); /*doesn't exist because no desired properties*/
 
@@ -4956,13 +5164,10 @@ BEGIN_TEST_SUITE(Schema_ut)
         SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
         SCHEMA_MODEL_TYPE_HANDLE modelType = Schema_CreateModelType(schemaHandle, "Model");
         (void)Schema_AddModelDesiredProperty(modelType, "a", "b", g_pfDesiredPropertyFromAGENT_DATA_TYPE, g_pfDesiredPropertyInitialize, g_pfDesiredPropertyDeinitialize, 0, NULL);
+        (void)Schema_BuildNameIndexes(schemaHandle);
         umock_c_reset_all_calls();
         const char* desiredPropertyName = "c"; /*only "a" exists*/
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, desiredPropertyName))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred();
-
         ///act
         SCHEMA_DESIRED_PROPERTY_HANDLE result = Schema_GetModelDesiredPropertyByName(modelType, desiredPropertyName);
 
@@ -4981,13 +5186,10 @@ BEGIN_TEST_SUITE(Schema_ut)
         SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
         SCHEMA_MODEL_TYPE_HANDLE modelType = Schema_CreateModelType(schemaHandle, "Model");
         (void)Schema_AddModelDesiredProperty(modelType, "a", "b", g_pfDesiredPropertyFromAGENT_DATA_TYPE, g_pfDesiredPropertyInitialize, g_pfDesiredPropertyDeinitialize, 0, NULL);
+        (void)Schema_BuildNameIndexes(schemaHandle);
         umock_c_reset_all_calls();
         const char* desiredPropertyName = "a"; /*only "a" exists*/
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, desiredPropertyName))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred();
-
         ///act
         SCHEMA_DESIRED_PROPERTY_HANDLE result = Schema_GetModelDesiredPropertyByName(modelType, desiredPropertyName);
 
@@ -4999,6 +5201,129 @@ BEGIN_TEST_SUITE(Schema_ut)
         Schema_Destroy(schemaHandle);
     }
 
+    /*Tests_SRS_SCHEMA_99_184: [ Looking up an element of a model by name shall use the hash index of the names of the model built by Schema_BuildNameIndexes. The index is dropped whenever an element is added to the model. ]*/
+    TEST_FUNCTION(Schema_GetModelDesiredPropertyByName_uses_the_name_index_of_the_model)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        SCHEMA_MODEL_TYPE_HANDLE modelType = Schema_CreateModelType(schemaHandle, "Model");
+        (void)Schema_AddModelDesiredProperty(modelType, "a", "b", g_pfDesiredPropertyFromAGENT_DATA_TYPE, g_pfDesiredPropertyInitialize, g_pfDesiredPropertyDeinitialize, 0, NULL);
+        (void)Schema_AddModelDesiredProperty(modelType, "c", "d", g_pfDesiredPropertyFromAGENT_DATA_TYPE, g_pfDesiredPropertyInitialize, g_pfDesiredPropertyDeinitialize, 0, NULL);
+        (void)Schema_BuildNameIndexes(schemaHandle);
+        umock_c_reset_all_calls();
+
+        ///act
+        SCHEMA_DESIRED_PROPERTY_HANDLE result1 = Schema_GetModelDesiredPropertyByName(modelType, "a");
+        SCHEMA_DESIRED_PROPERTY_HANDLE result2 = Schema_GetModelDesiredPropertyByName(modelType, "c");
+        SCHEMA_DESIRED_PROPERTY_HANDLE result3 = Schema_GetModelDesiredPropertyByName(modelType, "e");
+
+        ///assert
+        ASSERT_IS_NOT_NULL(result1);
+        ASSERT_IS_NOT_NULL(result2);
+        ASSERT_ARE_NOT_EQUAL(void_ptr, (void*)result1, (void*)result2);
+        ASSERT_IS_NULL(result3);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        Schema_Destroy(schemaHandle);
+    }
+
+    /*Tests_SRS_SCHEMA_99_184: [ Looking up an element of a model by name shall use the hash index of the names of the model built by Schema_BuildNameIndexes. The index is dropped whenever an element is added to the model. ]*/
+    /*Tests_SRS_SCHEMA_99_186: [ If the hash index is not built then the lookup shall search the elements linearly. ]*/
+    TEST_FUNCTION(Schema_GetModelDesiredPropertyByName_finds_a_desired_property_added_after_the_name_index_is_built)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        SCHEMA_MODEL_TYPE_HANDLE modelType = Schema_CreateModelType(schemaHandle, "Model");
+        (void)Schema_AddModelDesiredProperty(modelType, "a", "b", g_pfDesiredPropertyFromAGENT_DATA_TYPE, g_pfDesiredPropertyInitialize, g_pfDesiredPropertyDeinitialize, 0, NULL);
+        (void)Schema_BuildNameIndexes(schemaHandle);
+        (void)Schema_AddModelDesiredProperty(modelType, "c", "d", g_pfDesiredPropertyFromAGENT_DATA_TYPE, g_pfDesiredPropertyInitialize, g_pfDesiredPropertyDeinitialize, 4, NULL);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 1))
+            .IgnoreArgument_handle();
+
+        ///act
+        SCHEMA_DESIRED_PROPERTY_HANDLE result = Schema_GetModelDesiredPropertyByName(modelType, "c");
+
+        ///assert
+        ASSERT_IS_NOT_NULL(result);
+        ASSERT_ARE_EQUAL(size_t, 4, Schema_GetModelDesiredProperty_offset(result));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        Schema_Destroy(schemaHandle);
+    }
+
+    /*Tests_SRS_SCHEMA_99_186: [ If the hash index is not built then the lookup shall search the elements linearly. ]*/
+    TEST_FUNCTION(Schema_GetModelDesiredPropertyByName_without_a_name_index_searches_linearly)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        SCHEMA_MODEL_TYPE_HANDLE modelType = Schema_CreateModelType(schemaHandle, "Model");
+        (void)Schema_AddModelDesiredProperty(modelType, "a", "b", g_pfDesiredPropertyFromAGENT_DATA_TYPE, g_pfDesiredPropertyInitialize, g_pfDesiredPropertyDeinitialize, 0, NULL);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
+            .IgnoreArgument_handle();
+
+        ///act
+        SCHEMA_DESIRED_PROPERTY_HANDLE result = Schema_GetModelDesiredPropertyByName(modelType, "a");
+
+        ///assert
+        ASSERT_IS_NOT_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        Schema_Destroy(schemaHandle);
+    }
+
+    /*Tests_SRS_SCHEMA_99_184: [ Looking up an element of a model by name shall use the hash index of the names of the model built by Schema_BuildNameIndexes. The index is dropped whenever an element is added to the model. ]*/
+    TEST_FUNCTION(Schema_GetModelElementByName_finds_every_element_of_a_large_model)
+    {
+        ///arrange
+        char name[32];
+        size_t i;
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        SCHEMA_MODEL_TYPE_HANDLE modelType = Schema_CreateModelType(schemaHandle, "Model");
+        for (i = 0; i < 300; i++)
+        {
+            (void)sprintf(name, "property%lu", (unsigned long)i);
+            ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, Schema_AddModelProperty(modelType, name, "int"));
+            (void)sprintf(name, "desired%lu", (unsigned long)i);
+            ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, Schema_AddModelDesiredProperty(modelType, name, "int", g_pfDesiredPropertyFromAGENT_DATA_TYPE, g_pfDesiredPropertyInitialize, g_pfDesiredPropertyDeinitialize, i, NULL));
+        }
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, Schema_BuildNameIndexes(schemaHandle));
+
+        ///act
+        for (i = 0; i < 300; i++)
+        {
+            SCHEMA_MODEL_ELEMENT property;
+            SCHEMA_MODEL_ELEMENT desiredProperty;
+
+            (void)sprintf(name, "property%lu", (unsigned long)i);
+            property = Schema_GetModelElementByName(modelType, name);
+            (void)sprintf(name, "desired%lu", (unsigned long)i);
+            desiredProperty = Schema_GetModelElementByName(modelType, name);
+
+            ///assert
+            ASSERT_ARE_EQUAL(SCHEMA_ELEMENT_TYPE, SCHEMA_PROPERTY, property.elementType);
+            ASSERT_ARE_EQUAL(void_ptr, (void*)Schema_GetModelPropertyByIndex(modelType, i), (void*)property.elementHandle.propertyHandle);
+            ASSERT_ARE_EQUAL(SCHEMA_ELEMENT_TYPE, SCHEMA_DESIRED_PROPERTY, desiredProperty.elementType);
+            ASSERT_ARE_EQUAL(size_t, i, Schema_GetModelDesiredProperty_offset(desiredProperty.elementHandle.desiredPropertyHandle));
+        }
+        ASSERT_ARE_EQUAL(SCHEMA_ELEMENT_TYPE, SCHEMA_NOT_FOUND, Schema_GetModelElementByName(modelType, "property300").elementType);
+
+        ///clean
+        Schema_Destroy(schemaHandle);
+    }
+
     /*Tests_SRS_SCHEMA_02_038: [ If modelTypeHandle is NULL then Schema_GetModelDesiredPropertyByIndex shall fail and return NULL. ]*/
     TEST_FUNCTION(Schema_GetModelDesiredPropertyByIndex_with_NULL_modelTypeHandle_fails)
     {
@@ -6211,13 +6536,9 @@ BEGIN_TEST_SUITE(Schema_ut)
         SCHEMA_MODEL_TYPE_HANDLE model = Schema_CreateModelType(schemaHandle, "model");
         (void)Schema_CreateModelMethod(model, "method");
 
+        (void)Schema_BuildNameIndexes(schemaHandle);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred()
-            .IgnoreArgument_value();
-
         ///act
         SCHEMA_METHOD_HANDLE methodHandle = Schema_GetModelMethodByName(model, "method");
 
@@ -6237,13 +6558,9 @@ BEGIN_TEST_SUITE(Schema_ut)
         SCHEMA_MODEL_TYPE_HANDLE model = Schema_CreateModelType(schemaHandle, "model");
         (void)Schema_CreateModelMethod(model, "method");
 
+        (void)Schema_BuildNameIndexes(schemaHandle);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred()
-            .IgnoreArgument_value();
-
         ///act
         SCHEMA_METHOD_HANDLE methodHandle = Schema_GetModelMethodByName(model, "NO WAY THIS EXISTS!");
 